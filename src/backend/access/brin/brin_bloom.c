@@ -0,0 +1,400 @@
+/*
+ * brin_bloom.c
+ *		Implementation of Bloom opclass for BRIN
+ *
+ * A min/max summary is useless on columns whose values have no physical
+ * correlation with heap position (UUIDs, hashes, and so on): every page
+ * range ends up spanning nearly the whole domain, so no range is ever
+ * skipped.  This opclass instead summarizes each page range with a small
+ * Bloom filter over the hashed values, which supports equality queries
+ * regardless of correlation: a range can be skipped whenever the filter
+ * proves the sought value was never inserted into it.
+ *
+ * The filter is sized from the number of distinct values we expect a page
+ * range to contain and the false positive rate we are willing to accept.
+ * Both are compile-time defaults below; they produce filters of a few
+ * hundred bytes for default pages_per_range, and the size is capped so
+ * that a summary always fits comfortably on a page.  We hash values with
+ * the datatype's hash function, registered as an extra (optional) support
+ * procedure of the opclass, and derive the k filter positions from that
+ * single hash by double hashing.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/access/brin/brin_bloom.c
+ */
+#include "postgres.h"
+
+#include <math.h>
+
+#include "access/brin.h"
+#include "access/brin_internal.h"
+#include "access/brin_tuple.h"
+#include "access/genam.h"
+#include "access/htup_details.h"
+#include "access/stratnum.h"
+#include "catalog/pg_type.h"
+#include "port/pg_bitutils.h"
+#include "utils/builtins.h"
+#include "utils/datum.h"
+#include "utils/hashutils.h"
+#include "utils/rel.h"
+
+/*
+ * Expected number of distinct values per page range, used to size the
+ * filter.  A negative value means a fraction of the maximum number of
+ * tuples a range can hold (e.g. -0.1 means 10% of them).
+ */
+#define BLOOM_DEFAULT_NDISTINCT_PER_RANGE	(-0.1)
+
+/* Lower bound on the distinct-values estimate, to avoid tiny filters. */
+#define BLOOM_MIN_NDISTINCT_PER_RANGE		128
+
+/* Accepted rate of ranges falsely matching an equality query. */
+#define BLOOM_DEFAULT_FALSE_POSITIVE_RATE	0.01
+
+/*
+ * Cap on the bitmap size, so that the summary (with varlena and index
+ * tuple overhead) always fits on a page with plenty of room to spare.
+ */
+#define BLOOM_MAX_NBITS					(4096 * 8)
+
+/* Strategy number of the only operator the opclass supports. */
+#define BloomEqualStrategyNumber		1
+
+/* Procedure number of the datatype's hash function. */
+#define BRIN_PROCNUM_BLOOM_HASH			11
+
+/*
+ * Bloom filter, stored as a single bytea-typed summary value.
+ */
+typedef struct BloomFilter
+{
+	int32		vl_len_;		/* varlena header (do not touch directly!) */
+	uint16		flags;			/* reserved for future use */
+	uint16		nhashes;		/* number of hash functions */
+	uint32		nbits;			/* number of bits in the bitmap */
+	uint32		nbits_set;		/* number of bits currently set */
+	char		data[FLEXIBLE_ARRAY_MEMBER];	/* the bitmap */
+} BloomFilter;
+
+typedef struct BloomOpaque
+{
+	FmgrInfo	extra_procinfo; /* hash function for the datatype */
+	bool		extra_proc_missing;
+} BloomOpaque;
+
+static FmgrInfo *bloom_get_hash_procinfo(BrinDesc *bdesc, uint16 attno);
+
+
+/*
+ * Allocate a Bloom filter sized for the index's pages_per_range setting
+ * and the compile-time defaults above.
+ */
+static BloomFilter *
+bloom_init(BrinDesc *bdesc)
+{
+	BloomFilter *filter;
+	double		maxtuples;
+	double		ndistinct;
+	uint32		nbits;
+	int			nhashes;
+	Size		len;
+
+	maxtuples = (double) BrinGetPagesPerRange(bdesc->bd_index) *
+		MaxHeapTuplesPerPage;
+
+	ndistinct = BLOOM_DEFAULT_NDISTINCT_PER_RANGE;
+	if (ndistinct < 0)
+		ndistinct = -ndistinct * maxtuples;
+	ndistinct = Max(ndistinct, BLOOM_MIN_NDISTINCT_PER_RANGE);
+	ndistinct = Min(ndistinct, maxtuples);
+
+	/*
+	 * Optimal bitmap size for n distinct values and false positive rate p
+	 * is (-n * ln(p) / ln(2)^2) bits, with (m/n * ln(2)) hash functions.
+	 */
+	nbits = (uint32) ceil(ndistinct *
+						  -log(BLOOM_DEFAULT_FALSE_POSITIVE_RATE) /
+						  pow(log(2.0), 2));
+	nbits = Min(nbits, BLOOM_MAX_NBITS);
+
+	nhashes = (int) round(nbits / ndistinct * log(2.0));
+	nhashes = Max(nhashes, 1);
+
+	len = offsetof(BloomFilter, data) + (nbits + 7) / 8;
+
+	filter = (BloomFilter *) palloc0(len);
+	SET_VARSIZE(filter, len);
+	filter->nhashes = (uint16) nhashes;
+	filter->nbits = nbits;
+
+	return filter;
+}
+
+/*
+ * Add the hash of a value to the filter.  Returns true if any bit changed.
+ */
+static bool
+bloom_add_value(BloomFilter *filter, uint32 hashvalue)
+{
+	uint64		h = DatumGetUInt64(hash_uint32_extended(hashvalue, 0));
+	uint32		h1 = (uint32) h;
+	uint32		h2 = (uint32) (h >> 32);
+	bool		updated = false;
+
+	for (int i = 0; i < filter->nhashes; i++)
+	{
+		uint32		bit = (h1 + i * h2) % filter->nbits;
+
+		if (!(filter->data[bit / 8] & (1 << (bit % 8))))
+		{
+			filter->data[bit / 8] |= (1 << (bit % 8));
+			filter->nbits_set++;
+			updated = true;
+		}
+	}
+
+	return updated;
+}
+
+/*
+ * Test whether a value with the given hash may be in the filter.
+ */
+static bool
+bloom_contains_value(BloomFilter *filter, uint32 hashvalue)
+{
+	uint64		h = DatumGetUInt64(hash_uint32_extended(hashvalue, 0));
+	uint32		h1 = (uint32) h;
+	uint32		h2 = (uint32) (h >> 32);
+
+	for (int i = 0; i < filter->nhashes; i++)
+	{
+		uint32		bit = (h1 + i * h2) % filter->nbits;
+
+		if (!(filter->data[bit / 8] & (1 << (bit % 8))))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Look up the hash function registered for the attribute's type, caching
+ * it in the opclass-private state.
+ */
+static FmgrInfo *
+bloom_get_hash_procinfo(BrinDesc *bdesc, uint16 attno)
+{
+	BloomOpaque *opaque;
+
+	opaque = (BloomOpaque *) bdesc->bd_info[attno - 1]->oi_opaque;
+	if (opaque->extra_procinfo.fn_oid == InvalidOid)
+	{
+		if (opaque->extra_proc_missing)
+			elog(ERROR, "missing hash support function %d for attribute %d",
+				 BRIN_PROCNUM_BLOOM_HASH, attno);
+		fmgr_info_copy(&opaque->extra_procinfo,
+					   index_getprocinfo(bdesc->bd_index, attno,
+										 BRIN_PROCNUM_BLOOM_HASH),
+					   bdesc->bd_context);
+	}
+
+	return &opaque->extra_procinfo;
+}
+
+Datum
+brin_bloom_opcinfo(PG_FUNCTION_ARGS)
+{
+	BrinOpcInfo *result;
+
+	/*
+	 * The opaque struct is initialized to zeroes by palloc0, which leaves
+	 * the cached hash procinfo invalid until first use.
+	 *
+	 * The only summary value is the Bloom filter itself, stored as bytea.
+	 */
+	result = palloc0(MAXALIGN(SizeofBrinOpcInfo(1)) +
+					 sizeof(BloomOpaque));
+	result->oi_nstored = 1;
+	result->oi_opaque = (BloomOpaque *)
+		MAXALIGN((char *) result + SizeofBrinOpcInfo(1));
+	result->oi_typcache[0] = lookup_type_cache(BYTEAOID, 0);
+
+	PG_RETURN_POINTER(result);
+}
+
+/*
+ * Examine the given index tuple (which contains partial status of a
+ * certain page range) by comparing it to the given value that comes from
+ * another heap tuple.  If the new value is not represented in the range's
+ * filter yet, update the index tuple and return true.  Otherwise return
+ * false and do not modify in this case.
+ */
+Datum
+brin_bloom_add_value(PG_FUNCTION_ARGS)
+{
+	BrinDesc   *bdesc = (BrinDesc *) PG_GETARG_POINTER(0);
+	BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+	Datum		newval = PG_GETARG_DATUM(2);
+	bool		isnull = PG_GETARG_DATUM(3);
+	Oid			colloid = PG_GET_COLLATION();
+	BloomFilter *filter;
+	FmgrInfo   *hashFn;
+	uint32		hashvalue;
+	bool		updated;
+
+	/*
+	 * If the new value is null, we record that we saw it if it's the first
+	 * one; otherwise, there's nothing to do.
+	 */
+	if (isnull)
+	{
+		if (column->bv_hasnulls)
+			PG_RETURN_BOOL(false);
+
+		column->bv_hasnulls = true;
+		PG_RETURN_BOOL(true);
+	}
+
+	hashFn = bloom_get_hash_procinfo(bdesc, column->bv_attno);
+	hashvalue = DatumGetUInt32(FunctionCall1Coll(hashFn, colloid, newval));
+
+	/*
+	 * If this is the first non-null value in the range, create the filter.
+	 */
+	if (column->bv_allnulls)
+	{
+		filter = bloom_init(bdesc);
+		column->bv_values[0] = PointerGetDatum(filter);
+		column->bv_allnulls = false;
+		updated = true;
+	}
+	else
+	{
+		filter = (BloomFilter *) PG_DETOAST_DATUM(column->bv_values[0]);
+		column->bv_values[0] = PointerGetDatum(filter);
+		updated = false;
+	}
+
+	updated |= bloom_add_value(filter, hashvalue);
+
+	PG_RETURN_BOOL(updated);
+}
+
+/*
+ * Given an index tuple corresponding to a certain page range and a scan
+ * key, return whether the scan key is consistent with the index tuple's
+ * Bloom filter.  Return true if so, false otherwise.
+ */
+Datum
+brin_bloom_consistent(PG_FUNCTION_ARGS)
+{
+	BrinDesc   *bdesc = (BrinDesc *) PG_GETARG_POINTER(0);
+	BrinValues *column = (BrinValues *) PG_GETARG_POINTER(1);
+	ScanKey		key = (ScanKey) PG_GETARG_POINTER(2);
+	Oid			colloid = PG_GET_COLLATION();
+	BloomFilter *filter;
+	FmgrInfo   *hashFn;
+	uint32		hashvalue;
+
+	Assert(key->sk_attno == column->bv_attno);
+
+	/* handle IS NULL/IS NOT NULL tests */
+	if (key->sk_flags & SK_ISNULL)
+	{
+		if (key->sk_flags & SK_SEARCHNULL)
+		{
+			if (column->bv_allnulls || column->bv_hasnulls)
+				PG_RETURN_BOOL(true);
+			PG_RETURN_BOOL(false);
+		}
+
+		/*
+		 * For IS NOT NULL, we can only skip ranges that are known to have
+		 * only nulls.
+		 */
+		if (key->sk_flags & SK_SEARCHNOTNULL)
+			PG_RETURN_BOOL(!column->bv_allnulls);
+
+		/*
+		 * Neither IS NULL nor IS NOT NULL was used; assume all indexable
+		 * operators are strict and return false.
+		 */
+		PG_RETURN_BOOL(false);
+	}
+
+	/* if the range is all empty, it cannot possibly be consistent */
+	if (column->bv_allnulls)
+		PG_RETURN_BOOL(false);
+
+	if (key->sk_strategy != BloomEqualStrategyNumber)
+		elog(ERROR, "invalid strategy number %d", key->sk_strategy);
+
+	filter = (BloomFilter *) PG_DETOAST_DATUM(column->bv_values[0]);
+
+	hashFn = bloom_get_hash_procinfo(bdesc, key->sk_attno);
+	hashvalue = DatumGetUInt32(FunctionCall1Coll(hashFn, colloid,
+												 key->sk_argument));
+
+	PG_RETURN_BOOL(bloom_contains_value(filter, hashvalue));
+}
+
+/*
+ * Given two BrinValues, update the first of them as a union of the summary
+ * values contained in both.  The second one is untouched.
+ */
+Datum
+brin_bloom_union(PG_FUNCTION_ARGS)
+{
+	BrinValues *col_a = (BrinValues *) PG_GETARG_POINTER(1);
+	BrinValues *col_b = (BrinValues *) PG_GETARG_POINTER(2);
+	BloomFilter *filter_a;
+	BloomFilter *filter_b;
+	uint32		nbytes;
+
+	Assert(col_a->bv_attno == col_b->bv_attno);
+
+	/* Adjust "hasnulls" */
+	if (!col_a->bv_hasnulls && col_b->bv_hasnulls)
+		col_a->bv_hasnulls = true;
+
+	/* If there are no values in B, there's nothing left to do */
+	if (col_b->bv_allnulls)
+		PG_RETURN_VOID();
+
+	filter_b = (BloomFilter *) PG_DETOAST_DATUM(col_b->bv_values[0]);
+
+	/*
+	 * Adjust "allnulls".  If A doesn't have a filter, just copy the one
+	 * from B into A, and we're done.  Note we already established that B
+	 * contains values.
+	 */
+	if (col_a->bv_allnulls)
+	{
+		col_a->bv_allnulls = false;
+		col_a->bv_values[0] =
+			datumCopy(PointerGetDatum(filter_b), false, -1);
+		PG_RETURN_VOID();
+	}
+
+	filter_a = (BloomFilter *) PG_DETOAST_DATUM(col_a->bv_values[0]);
+	col_a->bv_values[0] = PointerGetDatum(filter_a);
+
+	/* Both filters are sized by the same defaults, so they must agree */
+	if (filter_a->nbits != filter_b->nbits ||
+		filter_a->nhashes != filter_b->nhashes)
+		elog(ERROR, "mismatching bloom filter parameters in BRIN union");
+
+	nbytes = (filter_a->nbits + 7) / 8;
+	filter_a->nbits_set = 0;
+	for (uint32 i = 0; i < nbytes; i++)
+	{
+		filter_a->data[i] |= filter_b->data[i];
+		filter_a->nbits_set += pg_popcount32((uint8) filter_a->data[i]);
+	}
+
+	PG_RETURN_VOID();
+}
@@ -16,9 +16,11 @@
 #include "postgres.h"
 
 #include "access/printtup.h"
+#include "catalog/pg_type.h"
 #include "libpq/libpq.h"
 #include "libpq/pqformat.h"
 #include "tcop/pquery.h"
+#include "utils/builtins.h"
 #include "utils/lsyscache.h"
 #include "utils/memdebug.h"
 #include "utils/memutils.h"
@@ -54,10 +56,23 @@ typedef struct
 	Oid			typoutput;		/* Oid for the type's text output fn */
 	Oid			typsend;		/* Oid for the type's binary output fn */
 	bool		typisvarlena;	/* is it varlena (ie possibly toastable)? */
+	char		fastpath;		/* specialized emitter, see PRINTTUP_FAST_* */
 	int16		format;			/* format code for this column */
 	FmgrInfo	finfo;			/* Precomputed call info for output fn */
 } PrinttupAttrInfo;
 
+/*
+ * Values for PrinttupAttrInfo.fastpath.  Integer columns are so common in
+ * result sets that it's worth emitting them straight into the message buffer,
+ * bypassing the output-function call and the intermediate palloc'd copy of
+ * the value.  Their text form is plain ASCII, which every client encoding
+ * represents unchanged, so skipping the encoding conversion is safe too.
+ */
+#define PRINTTUP_FAST_NONE	0
+#define PRINTTUP_FAST_INT2	1
+#define PRINTTUP_FAST_INT4	2
+#define PRINTTUP_FAST_INT8	3
+
 typedef struct
 {
 	DestReceiver pub;			/* publicly-known function pointers */
@@ -367,6 +382,27 @@ printtup_prepare_info(DR_printtup *myState, TupleDesc typeinfo, int numAttrs)
 			ereport(ERROR,
 					(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
 					 errmsg("unsupported format code: %d", format)));
+
+		/*
+		 * Note that a domain over an integer type keeps its own OID here and
+		 * so does not take the fast path, which is fine: its base type's
+		 * output function is used either way.
+		 */
+		switch (attr->atttypid)
+		{
+			case INT2OID:
+				thisState->fastpath = PRINTTUP_FAST_INT2;
+				break;
+			case INT4OID:
+				thisState->fastpath = PRINTTUP_FAST_INT4;
+				break;
+			case INT8OID:
+				thisState->fastpath = PRINTTUP_FAST_INT8;
+				break;
+			default:
+				thisState->fastpath = PRINTTUP_FAST_NONE;
+				break;
+		}
 	}
 }
 
@@ -426,7 +462,55 @@ printtup(TupleTableSlot *slot, DestReceiver *self)
 			VALGRIND_CHECK_MEM_IS_DEFINED(DatumGetPointer(attr),
 										  VARSIZE_ANY(attr));
 
-		if (thisState->format == 0)
+		if (thisState->fastpath != PRINTTUP_FAST_NONE)
+		{
+			if (thisState->format == 0)
+			{
+				/*
+				 * Integer text output, directly into the message buffer.
+				 * Being all-ASCII, the digits need no encoding conversion,
+				 * so we can skip pq_sendcountedtext.
+				 */
+				char		numbuf[24];
+				int			len;
+
+				switch (thisState->fastpath)
+				{
+					case PRINTTUP_FAST_INT2:
+						pg_itoa(DatumGetInt16(attr), numbuf);
+						break;
+					case PRINTTUP_FAST_INT4:
+						pg_ltoa(DatumGetInt32(attr), numbuf);
+						break;
+					default:
+						pg_lltoa(DatumGetInt64(attr), numbuf);
+						break;
+				}
+				len = strlen(numbuf);
+				pq_sendint32(buf, len);
+				pq_sendbytes(buf, numbuf, len);
+			}
+			else
+			{
+				/* Integer binary output, without the intermediate bytea */
+				switch (thisState->fastpath)
+				{
+					case PRINTTUP_FAST_INT2:
+						pq_sendint32(buf, sizeof(int16));
+						pq_sendint16(buf, DatumGetInt16(attr));
+						break;
+					case PRINTTUP_FAST_INT4:
+						pq_sendint32(buf, sizeof(int32));
+						pq_sendint32(buf, DatumGetInt32(attr));
+						break;
+					default:
+						pq_sendint32(buf, sizeof(int64));
+						pq_sendint64(buf, DatumGetInt64(attr));
+						break;
+				}
+			}
+		}
+		else if (thisState->format == 0)
 		{
 			/* Text output */
 			char	   *outputstr;
@@ -378,6 +378,15 @@ ginbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	/*
 	 * Do the heap scan.  We disallow sync scan here because dataPlaceToPage
 	 * prefers to receive tuples in TID order.
+	 *
+	 * XXX This scan is the obvious candidate for parallelism, along the
+	 * lines of _bt_parallel_build_main().  But nbtree workers communicate
+	 * through tuplesort, and tuplesort has no notion of a GIN (key, TID
+	 * list) pair: we would need a serialized GIN tuple format with a merge
+	 * step that concatenates posting lists for equal keys, since each
+	 * worker sees a disjoint subset of a key's TIDs.  Until that exists,
+	 * the build runs in a single process through the rbtree accumulator,
+	 * and amcanbuildparallel-style plan support would be pointless.
 	 */
 	reltuples = table_index_build_scan(heap, index, indexInfo, false, true,
 									   ginBuildCallback, (void *) &buildstate,
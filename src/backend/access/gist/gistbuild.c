@@ -28,6 +28,7 @@
 #include "storage/smgr.h"
 #include "utils/memutils.h"
 #include "utils/rel.h"
+#include "utils/tuplesort.h"
 
 /* Step of index tuples for check whether to switch to buffering build mode */
 #define BUFFERING_MODE_SWITCH_CHECK_STEP 256
@@ -74,6 +75,13 @@ typedef struct
 	HTAB	   *parentMap;
 
 	GistBufferingMode bufferingMode;
+
+	/*
+	 * In a sorted build, the input is accumulated here during the heap scan
+	 * and inserted into the index in sorted order afterwards.  NULL when not
+	 * doing a sorted build.
+	 */
+	Tuplesortstate *sortstate;
 } GISTBuildState;
 
 /* prototypes for private functions */
@@ -85,6 +93,13 @@ static void gistBuildCallback(Relation index,
 							  bool *isnull,
 							  bool tupleIsAlive,
 							  void *state);
+static void gistSortedBuildCallback(Relation index,
+									HeapTuple htup,
+									Datum *values,
+									bool *isnull,
+									bool tupleIsAlive,
+									void *state);
+static void gistSortedBuildInsert(GISTBuildState *buildstate);
 static void gistBufferingBuildInsert(GISTBuildState *buildstate,
 									 IndexTuple itup);
 static bool gistProcessItup(GISTBuildState *buildstate, IndexTuple itup,
@@ -152,6 +167,25 @@ gistbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	/* Calculate target amount of free space to leave on pages */
 	buildstate.freespace = BLCKSZ * (100 - fillfactor) / 100;
 
+	/*
+	 * If the leading index column's operator class provides a sortsupport
+	 * procedure, sort the input on that column before inserting.  Inserting
+	 * in sort order makes consecutive insertions descend to the same or
+	 * neighboring leaf pages, so the build does mostly-sequential I/O
+	 * instead of thrashing the whole tree.  An explicit buffering=on request
+	 * takes precedence.
+	 */
+	if (buildstate.bufferingMode != GIST_BUFFERING_STATS &&
+		OidIsValid(index_getprocid(index, 1, GIST_SORTSUPPORT_PROC)))
+	{
+		buildstate.sortstate = tuplesort_begin_index_gist(heap, index,
+														  maintenance_work_mem,
+														  NULL, false);
+		buildstate.bufferingMode = GIST_BUFFERING_DISABLED;
+	}
+	else
+		buildstate.sortstate = NULL;
+
 	/*
 	 * We expect to be called exactly once for any index relation. If that's
 	 * not the case, big trouble's what we have.
@@ -194,9 +228,21 @@ gistbuild(Relation heap, Relation index, IndexInfo *indexInfo)
 	 * Do the heap scan.
 	 */
 	reltuples = table_index_build_scan(heap, index, indexInfo, true, true,
+									   buildstate.sortstate ?
+									   gistSortedBuildCallback :
 									   gistBuildCallback,
 									   (void *) &buildstate, NULL);
 
+	/*
+	 * In a sorted build, the tuples are all still in the sorter; sort them
+	 * and insert them into the index now.
+	 */
+	if (buildstate.sortstate)
+	{
+		gistSortedBuildInsert(&buildstate);
+		tuplesort_end(buildstate.sortstate);
+	}
+
 	/*
 	 * If buffering was used, flush out all the tuples that are still in the
 	 * buffers.
@@ -507,6 +553,71 @@ gistBuildCallback(Relation index,
 	}
 }
 
+/*
+ * Per-tuple callback for table_index_build_scan, sorted build variant.
+ *
+ * All we do here is pass the tuple to the sorter; the insertions happen in
+ * gistSortedBuildInsert, once the whole input has been seen and sorted.
+ */
+static void
+gistSortedBuildCallback(Relation index,
+						HeapTuple htup,
+						Datum *values,
+						bool *isnull,
+						bool tupleIsAlive,
+						void *state)
+{
+	GISTBuildState *buildstate = (GISTBuildState *) state;
+
+	tuplesort_putindextuplevalues(buildstate->sortstate, index,
+								  &htup->t_self, values, isnull);
+}
+
+/*
+ * Insert the sorted input into the index, tuple by tuple.
+ */
+static void
+gistSortedBuildInsert(GISTBuildState *buildstate)
+{
+	Relation	index = buildstate->indexrel;
+	TupleDesc	tupdesc = RelationGetDescr(index);
+	IndexTuple	itup;
+
+	tuplesort_performsort(buildstate->sortstate);
+
+	while ((itup = tuplesort_getindextuple(buildstate->sortstate,
+										   true)) != NULL)
+	{
+		Datum		values[INDEX_MAX_KEYS];
+		bool		isnull[INDEX_MAX_KEYS];
+		IndexTuple	gtup;
+		MemoryContext oldCtx;
+
+		CHECK_FOR_INTERRUPTS();
+
+		oldCtx = MemoryContextSwitchTo(buildstate->giststate->tempCxt);
+
+		/*
+		 * The sorter holds the raw column values; re-form the tuple so that
+		 * any compress functions are applied.
+		 */
+		index_deform_tuple(itup, tupdesc, values, isnull);
+		gtup = gistFormTuple(buildstate->giststate, index, values, isnull,
+							 true);
+		gtup->t_tid = itup->t_tid;
+
+		gistdoinsert(index, gtup, buildstate->freespace,
+					 buildstate->giststate, buildstate->heaprel, true);
+
+		/* Update tuple count and total size. */
+		buildstate->indtuples += 1;
+		buildstate->indtuplesSize += IndexTupleSize(gtup);
+
+		MemoryContextSwitchTo(oldCtx);
+		MemoryContextReset(buildstate->giststate->tempCxt);
+	}
+}
+
 /*
  * Insert function for buffering index build.
  */
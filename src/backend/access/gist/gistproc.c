@@ -24,6 +24,7 @@
 #include "utils/builtins.h"
 #include "utils/float.h"
 #include "utils/geo_decls.h"
+#include "utils/sortsupport.h"
 
 
 static bool gist_box_leaf_consistent(BOX *key, BOX *query,
@@ -1544,3 +1545,101 @@ gist_poly_distance(PG_FUNCTION_ARGS)
 
 	PG_RETURN_FLOAT8(distance);
 }
+
+/*
+ * Map a floating-point value to an unsigned integer with the same sort
+ * order, for use in Z-order calculations.
+ *
+ * This relies on the IEEE 754 layout: for positive floats, the bit pattern
+ * already sorts correctly as an unsigned integer once the sign bit is set;
+ * for negative floats, inverting all the bits reverses their (descending)
+ * bit-pattern order into the right ascending order.  NaNs end up among the
+ * largest values, which is harmless here.
+ */
+static uint32
+ieee_float32_to_uint32(float f)
+{
+	union
+	{
+		float		f;
+		uint32		i;
+	}			u;
+
+	u.f = f;
+
+	if (u.i & 0x80000000)
+		return ~u.i;
+	else
+		return u.i | 0x80000000;
+}
+
+/*
+ * Interleave zero bits between the bits of x, so that its bits occupy the
+ * even-numbered positions of the result.
+ */
+static uint64
+part_bits32_by2(uint32 x)
+{
+	uint64		n = x;
+
+	n = (n | (n << 16)) & UINT64CONST(0x0000FFFF0000FFFF);
+	n = (n | (n << 8)) & UINT64CONST(0x00FF00FF00FF00FF);
+	n = (n | (n << 4)) & UINT64CONST(0x0F0F0F0F0F0F0F0F);
+	n = (n | (n << 2)) & UINT64CONST(0x3333333333333333);
+	n = (n | (n << 1)) & UINT64CONST(0x5555555555555555);
+
+	return n;
+}
+
+/*
+ * Compute the Z-order (Morton code) of a point.
+ *
+ * The coordinates are first reduced to float4, losing some precision.
+ * That's OK: the Z-order is used only to order the input of an index build,
+ * so an occasional misplaced point costs a little locality, not correctness.
+ */
+static uint64
+point_zorder_internal(float8 x, float8 y)
+{
+	uint32		ix = ieee_float32_to_uint32((float) x);
+	uint32		iy = ieee_float32_to_uint32((float) y);
+
+	return part_bits32_by2(ix) | (part_bits32_by2(iy) << 1);
+}
+
+/*
+ * Z-order comparator for points
+ */
+static int
+gist_point_zorder_cmp(Datum a, Datum b, SortSupport ssup)
+{
+	Point	   *p1 = DatumGetPointP(a);
+	Point	   *p2 = DatumGetPointP(b);
+	uint64		z1;
+	uint64		z2;
+
+	if (p1->x == p2->x && p1->y == p2->y)
+		return 0;
+
+	z1 = point_zorder_internal(p1->x, p1->y);
+	z2 = point_zorder_internal(p2->x, p2->y);
+
+	if (z1 > z2)
+		return 1;
+	else if (z1 < z2)
+		return -1;
+	else
+		return 0;
+}
+
+/*
+ * Sort support routine for fast GiST index build by sorting.
+ */
+Datum
+gist_point_sortsupport(PG_FUNCTION_ARGS)
+{
+	SortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
+
+	ssup->comparator = gist_point_zorder_cmp;
+	PG_RETURN_VOID();
+}
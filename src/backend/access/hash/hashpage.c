@@ -633,8 +633,6 @@ _hash_expandtable(Relation rel, Buffer metabuf)
 	bool		metap_update_masks = false;
 	bool		metap_update_splitpoint = false;
 
-restart_expand:
-
 	/*
 	 * Write-lock the meta page.  It used to be necessary to acquire a
 	 * heavyweight lock to begin a split, but that is no longer required.
@@ -726,10 +724,16 @@ restart_expand:
 		_hash_finish_split(rel, metabuf, buf_oblkno, old_bucket, maxbucket,
 						   highmask, lowmask);
 
-		/* release the pin on old buffer and retry for expand. */
+		/*
+		 * Release the pin on the old buffer, and stop here rather than
+		 * retrying the expansion.  Finishing the interrupted split was this
+		 * backend's quantum of split work; since the fill factor is still
+		 * exceeded, the next inserter to come through will attempt the
+		 * expansion, which bounds the split effort any one insert absorbs.
+		 */
 		_hash_dropbuf(rel, buf_oblkno);
 
-		goto restart_expand;
+		return;
 	}
 
 	/*
@@ -765,7 +769,12 @@ restart_expand:
 
 		_hash_dropbuf(rel, buf_oblkno);
 
-		goto restart_expand;
+		/*
+		 * As above, the cleanup pass was enough split work for one insert;
+		 * leave the split itself to the next backend that trips the fill
+		 * factor check.
+		 */
+		return;
 	}
 
 	/*
@@ -301,6 +301,7 @@ initscan(HeapScanDesc scan, ScanKey key, bool keep_startblock)
 	ItemPointerSetInvalid(&scan->rs_ctup.t_self);
 	scan->rs_cbuf = InvalidBuffer;
 	scan->rs_cblock = InvalidBlockNumber;
+	scan->rs_extent_until = InvalidBlockNumber;
 
 	/* page-at-a-time fields are always invalid when not rs_inited */
 
@@ -377,6 +378,33 @@ heapgetpage(TableScanDesc sscan, BlockNumber page)
 	 */
 	CHECK_FOR_INTERRUPTS();
 
+	/*
+	 * When a bulk-read strategy is in use, batch the physical reads: each
+	 * time a forward step of the scan moves past the last extent we
+	 * requested, pull the next READ_EXTENT_SIZE blocks into shared buffers
+	 * with as few kernel calls as possible, so that the per-page read below
+	 * finds the page already resident.  A forward step is one from the
+	 * immediately preceding block, or the first page of the scan; backward
+	 * scans and parallel workers being handed scattered pages get plain
+	 * per-page reads.  A synchronized-scan wraparound jumps far below the
+	 * old high-water mark, which the last test treats as a fresh start.
+	 */
+	if (scan->rs_strategy != NULL &&
+		(scan->rs_cblock == InvalidBlockNumber ||
+		 page == scan->rs_cblock + 1) &&
+		(scan->rs_extent_until == InvalidBlockNumber ||
+		 page >= scan->rs_extent_until ||
+		 scan->rs_extent_until - page > READ_EXTENT_SIZE))
+	{
+		BlockNumber extblocks = scan->rs_nblocks - page;
+
+		if (extblocks > READ_EXTENT_SIZE)
+			extblocks = READ_EXTENT_SIZE;
+		ReadBufferExtent(scan->rs_base.rs_rd, MAIN_FORKNUM, page,
+						 (int) extblocks, scan->rs_strategy);
+		scan->rs_extent_until = page + extblocks;
+	}
+
 	/* read page using selected strategy */
 	scan->rs_cbuf = ReadBufferExtended(scan->rs_base.rs_rd, MAIN_FORKNUM, page,
 									   RBM_NORMAL, scan->rs_strategy);
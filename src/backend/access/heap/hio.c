@@ -185,10 +185,11 @@ GetVisibilityMapPins(Relation relation, Buffer buffer1, Buffer buffer2,
 static void
 RelationAddExtraBlocks(Relation relation, BulkInsertState bistate)
 {
-	BlockNumber blockNum,
-				firstBlock = InvalidBlockNumber;
+	BlockNumber firstBlock,
+				blockNum;
 	int			extraBlocks;
 	int			lockWaiters;
+	Size		freespace;
 
 	/* Use the length of the lock wait queue to judge how much to extend. */
 	lockWaiters = RelationExtensionLockWaiterCount(relation);
@@ -203,53 +204,40 @@ RelationAddExtraBlocks(Relation relation, BulkInsertState bistate)
 	 */
 	extraBlocks = Min(512, lockWaiters * 20);
 
-	do
-	{
-		Buffer		buffer;
-		Page		page;
-		Size		freespace;
-
-		/*
-		 * Extend by one page.  This should generally match the main-line
-		 * extension code in RelationGetBufferForTuple, except that we hold
-		 * the relation extension lock throughout, and we don't immediately
-		 * initialize the page (see below).
-		 */
-		buffer = ReadBufferBI(relation, P_NEW, RBM_ZERO_AND_LOCK, bistate);
-		page = BufferGetPage(buffer);
-
-		if (!PageIsNew(page))
-			elog(ERROR, "page %u of relation \"%s\" should be empty but is not",
-				 BufferGetBlockNumber(buffer),
-				 RelationGetRelationName(relation));
-
-		/*
-		 * Add the page to the FSM without initializing. If we were to
-		 * initialize here, the page would potentially get flushed out to disk
-		 * before we add any useful content. There's no guarantee that that'd
-		 * happen before a potential crash, so we need to deal with
-		 * uninitialized pages anyway, thus avoid the potential for
-		 * unnecessary writes.
-		 */
-
-		/* we'll need this info below */
-		blockNum = BufferGetBlockNumber(buffer);
-		freespace = BufferGetPageSize(buffer) - SizeOfPageHeaderData;
+	RelationOpenSmgr(relation);
+	firstBlock = smgrnblocks(relation->rd_smgr, MAIN_FORKNUM);
 
-		UnlockReleaseBuffer(buffer);
+	/*
+	 * Stay away from the 2^32-1 wraparound limit; if there's no room left,
+	 * let the main-line single-block extension code produce the usual error.
+	 */
+	if (firstBlock > MaxBlockNumber - extraBlocks)
+		extraBlocks = MaxBlockNumber - firstBlock;
+	if (extraBlocks <= 0)
+		return;
 
-		/* Remember first block number thus added. */
-		if (firstBlock == InvalidBlockNumber)
-			firstBlock = blockNum;
+	/*
+	 * Extend the relation by all the blocks in a single smgrzeroextend()
+	 * call, rather than going through the buffer manager one page at a time.
+	 * This keeps the time we hold the extension lock down to (usually) one
+	 * fallocate call, and avoids pushing extraBlocks' worth of pages that
+	 * contain no data yet through shared buffers.  The new pages are left
+	 * uninitialized on disk, just as the page-at-a-time code left them
+	 * uninitialized in shared buffers: whoever gets one of them from the FSM
+	 * initializes it on first use, and we must cope with uninitialized pages
+	 * after a crash anyway.
+	 */
+	smgrzeroextend(relation->rd_smgr, MAIN_FORKNUM, firstBlock, extraBlocks,
+				   false);
 
-		/*
-		 * Immediately update the bottom level of the FSM.  This has a good
-		 * chance of making this page visible to other concurrently inserting
-		 * backends, and we want that to happen without delay.
-		 */
+	/*
+	 * Immediately update the bottom level of the FSM.  This has a good
+	 * chance of making these pages visible to other concurrently inserting
+	 * backends, and we want that to happen without delay.
+	 */
+	freespace = BLCKSZ - SizeOfPageHeaderData;
+	for (blockNum = firstBlock; blockNum < firstBlock + extraBlocks; blockNum++)
 		RecordPageWithFreeSpace(relation, blockNum, freespace);
-	}
-	while (--extraBlocks > 0);
 
 	/*
 	 * Updating the upper levels of the free space map is too expensive to do
@@ -257,7 +245,7 @@ RelationAddExtraBlocks(Relation relation, BulkInsertState bistate)
 	 * subsequent insertion activity sees all of those nifty free pages we
 	 * just inserted.
 	 */
-	FreeSpaceMapVacuumRange(relation, firstBlock, blockNum + 1);
+	FreeSpaceMapVacuumRange(relation, firstBlock, firstBlock + extraBlocks);
 }
 
 /*
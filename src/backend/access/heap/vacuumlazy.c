@@ -4,23 +4,28 @@
  *	  Concurrent ("lazy") vacuuming.
  *
  *
- * The major space usage for LAZY VACUUM is storage for the array of dead tuple
+ * The major space usage for LAZY VACUUM is storage for the set of dead tuple
  * TIDs.  We want to ensure we can vacuum even the very largest relations with
  * finite memory space usage.  To do that, we set upper bounds on the number of
- * tuples we will keep track of at once.
+ * pages we will keep track of at once.
  *
  * We are willing to use at most maintenance_work_mem (or perhaps
- * autovacuum_work_mem) memory space to keep track of dead tuples.  We
- * initially allocate an array of TIDs of that size, with an upper limit that
+ * autovacuum_work_mem) memory space to keep track of dead tuples.  Dead TIDs
+ * are stored as one entry per heap page, holding the block number and a
+ * bitmap of dead offsets on that page.  That is far denser than a flat TID
+ * array when pages contain several dead tuples, and it lets index vacuuming
+ * test membership with a binary search over page entries plus a bit test
+ * instead of a binary search over every TID.  We initially allocate an array
+ * of page entries sized from the memory budget, with an upper limit that
  * depends on table size (this limit ensures we don't allocate a huge area
  * uselessly for vacuuming small tables).  If the array threatens to overflow,
  * we suspend the heap scan phase and perform a pass of index cleanup and page
- * compaction, then resume the heap scan with an empty TID array.
+ * compaction, then resume the heap scan with an empty dead-TID store.
  *
  * If we're processing a table with no indexes, we can just vacuum each page
  * as we go; there's no need to save up multiple tuples to minimize the number
  * of index scans performed.  So we don't use maintenance_work_mem memory for
- * the TID array, just enough to hold as many heap tuples as fit on one page.
+ * the dead-TID store, just a single page entry.
  *
  *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
@@ -92,11 +97,20 @@
 	((BlockNumber) (((uint64) 8 * 1024 * 1024 * 1024) / BLCKSZ))
 
 /*
- * Guesstimation of number of dead tuples per page.  This is used to
- * provide an upper limit to memory allocated when vacuuming small
- * tables.
+ * Dead TIDs are accumulated as one entry per heap page, holding a bitmap of
+ * the dead offsets on that page.  Heap pages never use line pointers beyond
+ * MaxHeapTuplesPerPage, so a fixed-size bitmap suffices.  Bit (offset - 1)
+ * of the bitmap is set when that offset is dead.
  */
-#define LAZY_ALLOC_TUPLES		MaxHeapTuplesPerPage
+#define LV_BITMAP_BYTES			((MaxHeapTuplesPerPage + 7) / 8)
+#define LV_BITMAP_BYTE(off)		(((off) - 1) / 8)
+#define LV_BITMAP_BIT(off)		((uint8) (1 << (((off) - 1) % 8)))
+
+typedef struct LVDeadPage
+{
+	BlockNumber blkno;			/* heap page containing dead tuples */
+	uint8		bitmap[LV_BITMAP_BYTES];	/* which offsets are dead */
+} LVDeadPage;
 
 /*
  * Before we consider skipping a page that's marked as clean in
@@ -128,11 +142,12 @@ typedef struct LVRelStats
 	BlockNumber pages_removed;
 	double		tuples_deleted;
 	BlockNumber nonempty_pages; /* actually, last nonempty page + 1 */
-	/* List of TIDs of tuples we intend to delete */
-	/* NB: this list is ordered by TID address */
-	int			num_dead_tuples;	/* current # of entries */
-	int			max_dead_tuples;	/* # slots allocated in array */
-	ItemPointer dead_tuples;	/* array of ItemPointerData */
+	/* Store of TIDs of tuples we intend to delete */
+	/* NB: page entries are ordered by block number */
+	int			num_dead_pages; /* current # of page entries */
+	int			max_dead_pages; /* # page entries allocated */
+	int			num_dead_tuples;	/* total # of TIDs recorded */
+	LVDeadPage *dead_pages;		/* array of per-page offset bitmaps */
 	int			num_index_scans;
 	TransactionId latestRemovedXid;
 	bool		lock_waiter_detected;
@@ -162,7 +177,8 @@ static void lazy_cleanup_index(Relation indrel,
 							   IndexBulkDeleteResult *stats,
 							   LVRelStats *vacrelstats);
 static int	lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
-							 int tupindex, LVRelStats *vacrelstats, Buffer *vmbuffer);
+							 LVDeadPage *deadpage, LVRelStats *vacrelstats,
+							 Buffer *vmbuffer);
 static bool should_attempt_truncation(VacuumParams *params,
 									  LVRelStats *vacrelstats);
 static void lazy_truncate_heap(Relation onerel, LVRelStats *vacrelstats);
@@ -172,7 +188,7 @@ static void lazy_space_alloc(LVRelStats *vacrelstats, BlockNumber relblocks);
 static void lazy_record_dead_tuple(LVRelStats *vacrelstats,
 								   ItemPointer itemptr);
 static bool lazy_tid_reaped(ItemPointer itemptr, void *state);
-static int	vac_cmp_itemptr(const void *left, const void *right);
+static int	vac_cmp_dead_page(const void *key, const void *entry);
 static bool heap_page_is_all_visible(Relation rel, Buffer buf,
 									 TransactionId *visibility_cutoff_xid, bool *all_frozen);
 
@@ -516,6 +532,10 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 	Buffer		vmbuffer = InvalidBuffer;
 	BlockNumber next_unskippable_block;
 	bool		skipping_blocks;
+	BlockNumber eager_pages_left;
+#ifdef USE_PREFETCH
+	BlockNumber prefetch_blkno = 0;
+#endif
 	xl_heap_freeze_tuple *frozen;
 	StringInfoData buf;
 	const int	initprog_index[] = {
@@ -559,7 +579,7 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 	/* Report that we're scanning the heap, advertising total # of blocks */
 	initprog_val[0] = PROGRESS_VACUUM_PHASE_SCAN_HEAP;
 	initprog_val[1] = nblocks;
-	initprog_val[2] = vacrelstats->max_dead_tuples;
+	initprog_val[2] = (int64) vacrelstats->max_dead_pages * MaxHeapTuplesPerPage;
 	pgstat_progress_update_multi_param(3, initprog_index, initprog_val);
 
 	/*
@@ -605,7 +625,15 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 	 * a truncation that just fails immediately because there are tuples in
 	 * the last page.  This is worth avoiding mainly because such a lock must
 	 * be replayed on any hot standby, where it can be disruptive.
+	 *
+	 * When vacuum_freeze_eager_pages is set and this isn't an aggressive
+	 * vacuum, we additionally visit up to that many pages that are
+	 * all-visible but not yet all-frozen, so that they can be frozen and
+	 * marked all-frozen now rather than waiting for an anti-wraparound
+	 * vacuum to rescan them all at once.  (Aggressive vacuums visit such
+	 * pages anyway.)
 	 */
+	eager_pages_left = aggressive ? 0 : vacuum_freeze_eager_pages;
 	next_unskippable_block = 0;
 	if ((params->options & VACOPT_DISABLE_PAGE_SKIPPING) == 0)
 	{
@@ -624,6 +652,12 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 			{
 				if ((vmstatus & VISIBILITYMAP_ALL_VISIBLE) == 0)
 					break;
+				if (eager_pages_left > 0 &&
+					(vmstatus & VISIBILITYMAP_ALL_FROZEN) == 0)
+				{
+					eager_pages_left--;
+					break;
+				}
 			}
 			vacuum_delay_point();
 			next_unskippable_block++;
@@ -650,6 +684,7 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 		bool		all_visible;
 		bool		all_frozen = true;	/* provided all_visible is also true */
 		bool		has_dead_tuples;
+		TransactionId freeze_cutoff;
 		TransactionId visibility_cutoff_xid = InvalidTransactionId;
 
 		/* see note above about forcing scanning of last page */
@@ -680,6 +715,12 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 					{
 						if ((vmskipflags & VISIBILITYMAP_ALL_VISIBLE) == 0)
 							break;
+						if (eager_pages_left > 0 &&
+							(vmskipflags & VISIBILITYMAP_ALL_FROZEN) == 0)
+						{
+							eager_pages_left--;
+							break;
+						}
 					}
 					vacuum_delay_point();
 					next_unskippable_block++;
@@ -731,13 +772,51 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 			all_visible_according_to_vm = true;
 		}
 
+#ifdef USE_PREFETCH
+
+		/*
+		 * At this point we are committed to reading this block.  Issue
+		 * prefetch requests for the upcoming blocks that the skipping logic
+		 * will also read, so that vacuuming mostly-cold heap pages isn't
+		 * bound by the latency of one synchronous read per page.  When we're
+		 * skipping a long all-visible run, the next block to be read is
+		 * next_unskippable_block; otherwise every block up to and including
+		 * it will be read.
+		 */
+		if (target_prefetch_pages > 0)
+		{
+			BlockNumber prefetch_stop;
+
+			if (skipping_blocks)
+			{
+				prefetch_stop = next_unskippable_block;
+				if (prefetch_blkno < next_unskippable_block)
+					prefetch_blkno = next_unskippable_block;
+			}
+			else
+			{
+				prefetch_stop = Min(next_unskippable_block,
+									(BlockNumber) (blkno + target_prefetch_pages));
+				if (prefetch_blkno <= blkno)
+					prefetch_blkno = blkno + 1;
+			}
+
+			while (prefetch_blkno <= prefetch_stop && prefetch_blkno < nblocks)
+			{
+				PrefetchBuffer(onerel, MAIN_FORKNUM, prefetch_blkno);
+				prefetch_blkno++;
+			}
+		}
+#endif							/* USE_PREFETCH */
+
 		vacuum_delay_point();
 
 		/*
-		 * If we are close to overrunning the available space for dead-tuple
-		 * TIDs, pause and do a cycle of vacuuming before we tackle this page.
+		 * If there is no room left for another page entry in the dead-TID
+		 * store, pause and do a cycle of vacuuming before we tackle this
+		 * page.
 		 */
-		if ((vacrelstats->max_dead_tuples - vacrelstats->num_dead_tuples) < MaxHeapTuplesPerPage &&
+		if (vacrelstats->num_dead_pages >= vacrelstats->max_dead_pages &&
 			vacrelstats->num_dead_tuples > 0)
 		{
 			const int	hvp_index[] = {
@@ -789,6 +868,7 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 			 * not to reset latestRemovedXid since we want that value to be
 			 * valid.
 			 */
+			vacrelstats->num_dead_pages = 0;
 			vacrelstats->num_dead_tuples = 0;
 			vacrelstats->num_index_scans++;
 
@@ -988,6 +1068,18 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 		prev_dead_count = vacrelstats->num_dead_tuples;
 		maxoff = PageGetMaxOffsetNumber(page);
 
+		/*
+		 * When eager freezing is enabled and the visibility map claims this
+		 * page is all-visible, freeze with OldestXmin rather than
+		 * FreezeLimit as the cutoff.  OldestXmin is the most aggressive
+		 * cutoff heap_prepare_freeze_tuple() permits, and using it is what
+		 * lets the page come out all-frozen instead of merely all-visible.
+		 */
+		if (vacuum_freeze_eager_pages > 0 && all_visible_according_to_vm)
+			freeze_cutoff = OldestXmin;
+		else
+			freeze_cutoff = FreezeLimit;
+
 		/*
 		 * Note: If you change anything in the loop below, also look at
 		 * heap_page_is_all_visible to see if that needs to be changed.
@@ -1189,7 +1281,7 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 				 */
 				if (heap_prepare_freeze_tuple(tuple.t_data,
 											  relfrozenxid, relminmxid,
-											  FreezeLimit, MultiXactCutoff,
+											  freeze_cutoff, MultiXactCutoff,
 											  &frozen[nfrozen],
 											  &tuple_totally_frozen))
 					frozen[nfrozen++].offset = offnum;
@@ -1227,7 +1319,7 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 			{
 				XLogRecPtr	recptr;
 
-				recptr = log_heap_freeze(onerel, buf, FreezeLimit,
+				recptr = log_heap_freeze(onerel, buf, freeze_cutoff,
 										 frozen, nfrozen);
 				PageSetLSN(page, recptr);
 			}
@@ -1245,7 +1337,10 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 			if (nindexes == 0)
 			{
 				/* Remove tuples from heap if the table has no index */
-				lazy_vacuum_page(onerel, blkno, buf, 0, vacrelstats, &vmbuffer);
+				Assert(vacrelstats->num_dead_pages == 1 &&
+					   vacrelstats->dead_pages[0].blkno == blkno);
+				lazy_vacuum_page(onerel, blkno, buf, &vacrelstats->dead_pages[0],
+								 vacrelstats, &vmbuffer);
 				vacuumed_pages++;
 				has_dead_tuples = false;
 			}
@@ -1256,7 +1351,7 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 				 * Instead of vacuuming the dead tuples on the heap, we just
 				 * forget them.
 				 *
-				 * Note that vacrelstats->dead_tuples could have tuples which
+				 * Note that vacrelstats->dead_pages could have tuples which
 				 * became dead after HOT-pruning but are not marked dead yet.
 				 * We do not process them because it's a very rare condition,
 				 * and the next vacuum will process them anyway.
@@ -1269,6 +1364,7 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 			 * not to reset latestRemovedXid since we want that value to be
 			 * valid.
 			 */
+			vacrelstats->num_dead_pages = 0;
 			vacrelstats->num_dead_tuples = 0;
 
 			/*
@@ -1525,34 +1621,56 @@ lazy_scan_heap(Relation onerel, VacuumParams *params, LVRelStats *vacrelstats,
 static void
 lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
 {
-	int			tupindex;
+	int			pageidx;
 	int			npages;
+	int			ntuples;
+#ifdef USE_PREFETCH
+	int			prefetch_idx = 0;
+#endif
 	PGRUsage	ru0;
 	Buffer		vmbuffer = InvalidBuffer;
 
 	pg_rusage_init(&ru0);
 	npages = 0;
+	ntuples = 0;
 
-	tupindex = 0;
-	while (tupindex < vacrelstats->num_dead_tuples)
+	for (pageidx = 0; pageidx < vacrelstats->num_dead_pages; pageidx++)
 	{
-		BlockNumber tblk;
+		LVDeadPage *deadpage = &vacrelstats->dead_pages[pageidx];
+		BlockNumber tblk = deadpage->blkno;
 		Buffer		buf;
 		Page		page;
 		Size		freespace;
 
 		vacuum_delay_point();
 
-		tblk = ItemPointerGetBlockNumber(&vacrelstats->dead_tuples[tupindex]);
+#ifdef USE_PREFETCH
+
+		/*
+		 * The blocks we will visit are all known in advance, so keep up to
+		 * target_prefetch_pages of them in flight ahead of the current read.
+		 */
+		if (target_prefetch_pages > 0)
+		{
+			while (prefetch_idx < vacrelstats->num_dead_pages &&
+				   prefetch_idx <= pageidx + target_prefetch_pages)
+			{
+				PrefetchBuffer(onerel, MAIN_FORKNUM,
+							   vacrelstats->dead_pages[prefetch_idx].blkno);
+				prefetch_idx++;
+			}
+		}
+#endif							/* USE_PREFETCH */
+
 		buf = ReadBufferExtended(onerel, MAIN_FORKNUM, tblk, RBM_NORMAL,
 								 vac_strategy);
 		if (!ConditionalLockBufferForCleanup(buf))
 		{
+			/* Leave this page for the next vacuum to deal with */
 			ReleaseBuffer(buf);
-			++tupindex;
 			continue;
 		}
-		tupindex = lazy_vacuum_page(onerel, tblk, buf, tupindex, vacrelstats,
+		ntuples += lazy_vacuum_page(onerel, tblk, buf, deadpage, vacrelstats,
 									&vmbuffer);
 
 		/* Now that we've compacted the page, record its available space */
@@ -1573,7 +1691,7 @@ lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
 	ereport(elevel,
 			(errmsg("\"%s\": removed %d row versions in %d pages",
 					RelationGetRelationName(onerel),
-					tupindex, npages),
+					ntuples, npages),
 			 errdetail_internal("%s", pg_rusage_show(&ru0))));
 }
 
@@ -1583,34 +1701,35 @@ lazy_vacuum_heap(Relation onerel, LVRelStats *vacrelstats)
  *
  * Caller must hold pin and buffer cleanup lock on the buffer.
  *
- * tupindex is the index in vacrelstats->dead_tuples of the first dead
- * tuple for this page.  We assume the rest follow sequentially.
- * The return value is the first tupindex after the tuples of this page.
+ * deadpage is the dead-TID store entry for this page; every offset set in
+ * its bitmap is marked unused.  The return value is the number of items so
+ * marked.
  */
 static int
 lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
-				 int tupindex, LVRelStats *vacrelstats, Buffer *vmbuffer)
+				 LVDeadPage *deadpage, LVRelStats *vacrelstats,
+				 Buffer *vmbuffer)
 {
 	Page		page = BufferGetPage(buffer);
 	OffsetNumber unused[MaxOffsetNumber];
+	OffsetNumber toff;
 	int			uncnt = 0;
 	TransactionId visibility_cutoff_xid;
 	bool		all_frozen;
 
+	Assert(deadpage->blkno == blkno);
+
 	pgstat_progress_update_param(PROGRESS_VACUUM_HEAP_BLKS_VACUUMED, blkno);
 
 	START_CRIT_SECTION();
 
-	for (; tupindex < vacrelstats->num_dead_tuples; tupindex++)
+	for (toff = FirstOffsetNumber; toff <= MaxHeapTuplesPerPage; toff++)
 	{
-		BlockNumber tblk;
-		OffsetNumber toff;
 		ItemId		itemid;
 
-		tblk = ItemPointerGetBlockNumber(&vacrelstats->dead_tuples[tupindex]);
-		if (tblk != blkno)
-			break;				/* past end of tuples for this block */
-		toff = ItemPointerGetOffsetNumber(&vacrelstats->dead_tuples[tupindex]);
+		if ((deadpage->bitmap[LV_BITMAP_BYTE(toff)] & LV_BITMAP_BIT(toff)) == 0)
+			continue;
+
 		itemid = PageGetItemId(page, toff);
 		ItemIdSetUnused(itemid);
 		unused[uncnt++] = toff;
@@ -1675,7 +1794,7 @@ lazy_vacuum_page(Relation onerel, BlockNumber blkno, Buffer buffer,
 							  *vmbuffer, visibility_cutoff_xid, flags);
 	}
 
-	return tupindex;
+	return uncnt;
 }
 
 /*
@@ -1735,8 +1854,8 @@ lazy_check_needs_freeze(Buffer buf, bool *hastup)
 /*
  *	lazy_vacuum_index() -- vacuum one index relation.
  *
- *		Delete all the index entries pointing to tuples listed in
- *		vacrelstats->dead_tuples, and update running statistics.
+ *		Delete all the index entries pointing to tuples recorded in
+ *		vacrelstats->dead_pages, and update running statistics.
  */
 static void
 lazy_vacuum_index(Relation indrel,
@@ -2141,54 +2260,80 @@ count_nondeletable_pages(Relation onerel, LVRelStats *vacrelstats)
 static void
 lazy_space_alloc(LVRelStats *vacrelstats, BlockNumber relblocks)
 {
-	long		maxtuples;
+	long		maxpages;
 	int			vac_work_mem = IsAutoVacuumWorkerProcess() &&
 	autovacuum_work_mem != -1 ?
 	autovacuum_work_mem : maintenance_work_mem;
 
 	if (vacrelstats->useindex)
 	{
-		maxtuples = (vac_work_mem * 1024L) / sizeof(ItemPointerData);
-		maxtuples = Min(maxtuples, INT_MAX);
-		maxtuples = Min(maxtuples, MaxAllocSize / sizeof(ItemPointerData));
+		maxpages = (vac_work_mem * 1024L) / sizeof(LVDeadPage);
+		maxpages = Min(maxpages, INT_MAX);
+		maxpages = Min(maxpages, MaxAllocSize / sizeof(LVDeadPage));
 
-		/* curious coding here to ensure the multiplication can't overflow */
-		if ((BlockNumber) (maxtuples / LAZY_ALLOC_TUPLES) > relblocks)
-			maxtuples = relblocks * LAZY_ALLOC_TUPLES;
+		/*
+		 * A page entry covers every dead tuple on its page, so there is no
+		 * point in allocating more entries than the table has pages.
+		 */
+		if ((BlockNumber) maxpages > relblocks)
+			maxpages = relblocks;
 
 		/* stay sane if small maintenance_work_mem */
-		maxtuples = Max(maxtuples, MaxHeapTuplesPerPage);
+		maxpages = Max(maxpages, 1);
 	}
 	else
 	{
-		maxtuples = MaxHeapTuplesPerPage;
+		maxpages = 1;
 	}
 
+	vacrelstats->num_dead_pages = 0;
+	vacrelstats->max_dead_pages = (int) maxpages;
 	vacrelstats->num_dead_tuples = 0;
-	vacrelstats->max_dead_tuples = (int) maxtuples;
-	vacrelstats->dead_tuples = (ItemPointer)
-		palloc(maxtuples * sizeof(ItemPointerData));
+	vacrelstats->dead_pages = (LVDeadPage *)
+		palloc(maxpages * sizeof(LVDeadPage));
 }
 
 /*
  * lazy_record_dead_tuple - remember one deletable tuple
+ *
+ * TIDs are recorded in block order, so either the tuple belongs to the
+ * page entry most recently started, or it starts a new one.
  */
 static void
 lazy_record_dead_tuple(LVRelStats *vacrelstats,
 					   ItemPointer itemptr)
 {
-	/*
-	 * The array shouldn't overflow under normal behavior, but perhaps it
-	 * could if we are given a really small maintenance_work_mem. In that
-	 * case, just forget the last few tuples (we'll get 'em next time).
-	 */
-	if (vacrelstats->num_dead_tuples < vacrelstats->max_dead_tuples)
+	BlockNumber blkno = ItemPointerGetBlockNumber(itemptr);
+	OffsetNumber offnum = ItemPointerGetOffsetNumber(itemptr);
+	LVDeadPage *deadpage;
+
+	Assert(offnum >= FirstOffsetNumber && offnum <= MaxHeapTuplesPerPage);
+
+	if (vacrelstats->num_dead_pages > 0 &&
+		vacrelstats->dead_pages[vacrelstats->num_dead_pages - 1].blkno == blkno)
+		deadpage = &vacrelstats->dead_pages[vacrelstats->num_dead_pages - 1];
+	else
 	{
-		vacrelstats->dead_tuples[vacrelstats->num_dead_tuples] = *itemptr;
-		vacrelstats->num_dead_tuples++;
-		pgstat_progress_update_param(PROGRESS_VACUUM_NUM_DEAD_TUPLES,
-									 vacrelstats->num_dead_tuples);
+		/*
+		 * The array shouldn't overflow under normal behavior, but perhaps it
+		 * could if we are given a really small maintenance_work_mem. In that
+		 * case, just forget the last few tuples (we'll get 'em next time).
+		 */
+		if (vacrelstats->num_dead_pages >= vacrelstats->max_dead_pages)
+			return;
+
+		Assert(vacrelstats->num_dead_pages == 0 ||
+			   blkno > vacrelstats->dead_pages[vacrelstats->num_dead_pages - 1].blkno);
+
+		deadpage = &vacrelstats->dead_pages[vacrelstats->num_dead_pages++];
+		deadpage->blkno = blkno;
+		MemSet(deadpage->bitmap, 0, sizeof(deadpage->bitmap));
 	}
+
+	deadpage->bitmap[LV_BITMAP_BYTE(offnum)] |= LV_BITMAP_BIT(offnum);
+	vacrelstats->num_dead_tuples++;
+	pgstat_progress_update_param(PROGRESS_VACUUM_NUM_DEAD_TUPLES,
+								 vacrelstats->num_dead_tuples);
 }
 
 /*
@@ -2196,50 +2341,47 @@ lazy_record_dead_tuple(LVRelStats *vacrelstats,
  *
  *		This has the right signature to be an IndexBulkDeleteCallback.
  *
- *		Assumes dead_tuples array is in sorted order.
+ *		Binary-searches the page entries (which are in block-number order)
+ *		and then tests the offset bitmap, so the per-TID cost depends only
+ *		on the number of pages with dead tuples, not the number of TIDs.
  */
 static bool
 lazy_tid_reaped(ItemPointer itemptr, void *state)
 {
 	LVRelStats *vacrelstats = (LVRelStats *) state;
-	ItemPointer res;
+	BlockNumber blkno = ItemPointerGetBlockNumber(itemptr);
+	OffsetNumber offnum = ItemPointerGetOffsetNumber(itemptr);
+	LVDeadPage *deadpage;
+
+	deadpage = (LVDeadPage *) bsearch((void *) &blkno,
+									  (void *) vacrelstats->dead_pages,
+									  vacrelstats->num_dead_pages,
+									  sizeof(LVDeadPage),
+									  vac_cmp_dead_page);
+	if (deadpage == NULL)
+		return false;
 
-	res = (ItemPointer) bsearch((void *) itemptr,
-								(void *) vacrelstats->dead_tuples,
-								vacrelstats->num_dead_tuples,
-								sizeof(ItemPointerData),
-								vac_cmp_itemptr);
+	/* paranoia: an index should never point past MaxHeapTuplesPerPage */
+	if (offnum < FirstOffsetNumber || offnum > MaxHeapTuplesPerPage)
+		return false;
 
-	return (res != NULL);
+	return (deadpage->bitmap[LV_BITMAP_BYTE(offnum)] & LV_BITMAP_BIT(offnum)) != 0;
 }
 
 /*
- * Comparator routines for use with qsort() and bsearch().
+ * Comparator for use with bsearch(); key is a BlockNumber, entries are
+ * LVDeadPage.
  */
 static int
-vac_cmp_itemptr(const void *left, const void *right)
+vac_cmp_dead_page(const void *key, const void *entry)
 {
-	BlockNumber lblk,
-				rblk;
-	OffsetNumber loff,
-				roff;
-
-	lblk = ItemPointerGetBlockNumber((ItemPointer) left);
-	rblk = ItemPointerGetBlockNumber((ItemPointer) right);
+	BlockNumber blkno = *((const BlockNumber *) key);
+	const LVDeadPage *deadpage = (const LVDeadPage *) entry;
 
-	if (lblk < rblk)
+	if (blkno < deadpage->blkno)
 		return -1;
-	if (lblk > rblk)
+	if (blkno > deadpage->blkno)
 		return 1;
-
-	loff = ItemPointerGetOffsetNumber((ItemPointer) left);
-	roff = ItemPointerGetOffsetNumber((ItemPointer) right);
-
-	if (loff < roff)
-		return -1;
-	if (loff > roff)
-		return 1;
-
 	return 0;
 }
 
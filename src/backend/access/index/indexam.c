@@ -188,6 +188,47 @@ index_insert(Relation indexRelation,
 											 checkUnique, indexInfo);
 }
 
+/* ----------------
+ *		index_insert_batch - insert a batch of index tuples into a relation
+ *
+ * No uniqueness checking is done; callers that need it must use
+ * index_insert().  If the access method has no batch support, we simply
+ * insert the entries one by one.
+ * ----------------
+ */
+void
+index_insert_batch(Relation indexRelation,
+				   Datum **values,
+				   bool **isnull,
+				   ItemPointer *heap_tids,
+				   int ntuples,
+				   Relation heapRelation,
+				   IndexInfo *indexInfo)
+{
+	RELATION_CHECKS;
+	CHECK_REL_PROCEDURE(aminsert);
+
+	if (!(indexRelation->rd_indam->ampredlocks))
+		CheckForSerializableConflictIn(indexRelation,
+									   (HeapTuple) NULL,
+									   InvalidBuffer);
+
+	if (indexRelation->rd_indam->aminsertbatch != NULL)
+		indexRelation->rd_indam->aminsertbatch(indexRelation, values, isnull,
+											   heap_tids, ntuples,
+											   heapRelation, indexInfo);
+	else
+	{
+		int			i;
+
+		for (i = 0; i < ntuples; i++)
+			indexRelation->rd_indam->aminsert(indexRelation, values[i],
+											  isnull[i], heap_tids[i],
+											  heapRelation, UNIQUE_CHECK_NO,
+											  indexInfo);
+	}
+}
+
 /*
  * index_beginscan - start a scan of an index with amgettuple
  *
@@ -19,15 +19,20 @@
 #include "access/relscan.h"
 #include "miscadmin.h"
 #include "pgstat.h"
+#include "storage/bufmgr.h"
 #include "storage/predicate.h"
 #include "utils/lsyscache.h"
 #include "utils/rel.h"
+#include "utils/spccache.h"
 
 
 static void _bt_drop_lock_and_maybe_pin(IndexScanDesc scan, BTScanPos sp);
 static OffsetNumber _bt_binsrch(Relation rel, BTScanInsert key, Buffer buf);
+static int32 _bt_compare_skipattrs(Relation rel, BTScanInsert key, Page page,
+								   OffsetNumber offnum, int *comparecol);
 static bool _bt_readpage(IndexScanDesc scan, ScanDirection dir,
 						 OffsetNumber offnum);
+static void _bt_prefetchheap(IndexScanDesc scan, ScanDirection dir);
 static void _bt_saveitem(BTScanOpaque so, int itemIndex,
 						 OffsetNumber offnum, IndexTuple itup);
 static bool _bt_steppage(IndexScanDesc scan, ScanDirection dir);
@@ -346,6 +351,8 @@ _bt_binsrch(Relation rel,
 				high;
 	int32		result,
 				cmpval;
+	int			lowcmpcol = 1,
+				highcmpcol = 1;
 
 	page = BufferGetPage(buf);
 	opaque = (BTPageOpaque) PageGetSpecialPointer(page);
@@ -378,6 +385,14 @@ _bt_binsrch(Relation rel,
 	 * For nextkey=true (cmpval=0), the loop invariant is: all slots before
 	 * 'low' are <= scan key, all slots at or after 'high' are > scan key.
 	 *
+	 * As the bounds tighten we also track the first attribute at which the
+	 * scan key was found to differ from the current low and high bound
+	 * tuples.  Since the page is sorted, every tuple between the bounds must
+	 * agree with the scan key on all earlier attributes, so the comparisons
+	 * can skip them.  This saves a lot of cycles on keys with long shared
+	 * prefixes (e.g. URLs), but is only valid while both bounds refer to
+	 * tuples on this same, locked page.
+	 *
 	 * We can fall out when high == low.
 	 */
 	high++;						/* establish the loop invariant for high */
@@ -387,15 +402,22 @@ _bt_binsrch(Relation rel,
 	while (high > low)
 	{
 		OffsetNumber mid = low + ((high - low) / 2);
+		int			cmpcol = Min(lowcmpcol, highcmpcol);
 
 		/* We have low <= mid < high, so mid points at a real slot */
 
-		result = _bt_compare(rel, key, page, mid);
+		result = _bt_compare_skipattrs(rel, key, page, mid, &cmpcol);
 
 		if (result >= cmpval)
+		{
 			low = mid + 1;
+			lowcmpcol = cmpcol;
+		}
 		else
+		{
 			high = mid;
+			highcmpcol = cmpcol;
+		}
 	}
 
 	/*
@@ -447,6 +469,8 @@ _bt_binsrch_insert(Relation rel, BTInsertState insertstate)
 				stricthigh;
 	int32		result,
 				cmpval;
+	int			lowcmpcol = 1,
+				highcmpcol = 1;
 
 	page = BufferGetPage(insertstate->buf);
 	opaque = (BTPageOpaque) PageGetSpecialPointer(page);
@@ -485,6 +509,11 @@ _bt_binsrch_insert(Relation rel, BTInsertState insertstate)
 	 * at or after 'high' are >= scan key.  'stricthigh' is > scan key, and is
 	 * maintained to save additional search effort for caller.
 	 *
+	 * Attributes known equal to both bound tuples are skipped during the
+	 * comparisons, as in _bt_binsrch.  (When restarting from cached bounds we
+	 * conservatively start with no known-equal prefix, since the columns the
+	 * previous search established aren't remembered.)
+	 *
 	 * We can fall out when high == low.
 	 */
 	if (!insertstate->bounds_valid)
@@ -496,16 +525,21 @@ _bt_binsrch_insert(Relation rel, BTInsertState insertstate)
 	while (high > low)
 	{
 		OffsetNumber mid = low + ((high - low) / 2);
+		int			cmpcol = Min(lowcmpcol, highcmpcol);
 
 		/* We have low <= mid < high, so mid points at a real slot */
 
-		result = _bt_compare(rel, key, page, mid);
+		result = _bt_compare_skipattrs(rel, key, page, mid, &cmpcol);
 
 		if (result >= cmpval)
+		{
 			low = mid + 1;
+			lowcmpcol = cmpcol;
+		}
 		else
 		{
 			high = mid;
+			highcmpcol = cmpcol;
 			if (result != 0)
 				stricthigh = high;
 		}
@@ -555,6 +589,34 @@ _bt_compare(Relation rel,
 			BTScanInsert key,
 			Page page,
 			OffsetNumber offnum)
+{
+	int			comparecol = 1;
+
+	return _bt_compare_skipattrs(rel, key, page, offnum, &comparecol);
+}
+
+/*
+ *	_bt_compare_skipattrs() -- _bt_compare(), minus a known-equal prefix.
+ *
+ * On entry, *comparecol gives the 1-based attribute number to start
+ * comparing at; the caller guarantees that all earlier attributes of the
+ * tuple at offnum are equal to the corresponding scankey attributes.  On
+ * return, *comparecol is set to the attribute number at which the result
+ * was decided, or to key->keysz + 1 when every provided attribute compared
+ * equal (including when the result came from the heap TID tiebreaker or
+ * from truncated-attribute handling).
+ *
+ * Only callers that have established the known-equal prefix against other
+ * tuples on the same, locked page may pass *comparecol > 1; see the binary
+ * searches above.  A prefix carried across pages would be unsafe, since
+ * the tuples it was derived from may have moved.
+ */
+static int32
+_bt_compare_skipattrs(Relation rel,
+					  BTScanInsert key,
+					  Page page,
+					  OffsetNumber offnum,
+					  int *comparecol)
 {
 	TupleDesc	itupdesc = RelationGetDescr(rel);
 	BTPageOpaque opaque = (BTPageOpaque) PageGetSpecialPointer(page);
@@ -567,13 +629,17 @@ _bt_compare(Relation rel,
 	Assert(_bt_check_natts(rel, key->heapkeyspace, page, offnum));
 	Assert(key->keysz <= IndexRelationGetNumberOfKeyAttributes(rel));
 	Assert(key->heapkeyspace || key->scantid == NULL);
+	Assert(*comparecol >= 1 && *comparecol <= key->keysz + 1);
 
 	/*
 	 * Force result ">" if target item is first data item on an internal page
 	 * --- see NOTE above.
 	 */
 	if (!P_ISLEAF(opaque) && offnum == P_FIRSTDATAKEY(opaque))
+	{
+		*comparecol = 1;
 		return 1;
+	}
 
 	itup = (IndexTuple) PageGetItem(page, PageGetItemId(page, offnum));
 	ntupatts = BTreeTupleGetNAtts(itup, rel);
@@ -592,8 +658,8 @@ _bt_compare(Relation rel,
 
 	ncmpkey = Min(ntupatts, key->keysz);
 	Assert(key->heapkeyspace || ncmpkey == key->keysz);
-	scankey = key->scankeys;
-	for (int i = 1; i <= ncmpkey; i++)
+	scankey = key->scankeys + (*comparecol - 1);
+	for (int i = *comparecol; i <= ncmpkey; i++)
 	{
 		Datum		datum;
 		bool		isNull;
@@ -639,7 +705,10 @@ _bt_compare(Relation rel,
 
 		/* if the keys are unequal, return the difference */
 		if (result != 0)
+		{
+			*comparecol = i;
 			return result;
+		}
 
 		scankey++;
 	}
@@ -654,7 +723,13 @@ _bt_compare(Relation rel,
 	 * necessary.
 	 */
 	if (key->keysz > ntupatts)
+	{
+		*comparecol = ntupatts + 1;
 		return 1;
+	}
+
+	/* every provided attribute compared equal */
+	*comparecol = key->keysz + 1;
 
 	/*
 	 * Use the heap TID attribute and scantid to try to break the tie.  The
@@ -1316,6 +1391,9 @@ _bt_first(IndexScanDesc scan, ScanDirection dir)
 	}
 
 readcomplete:
+	/* Prefetch the heap blocks of upcoming items */
+	_bt_prefetchheap(scan, dir);
+
 	/* OK, itemIndex says what to return */
 	currItem = &so->currPos.items[so->currPos.itemIndex];
 	scan->xs_heaptid = currItem->heapTid;
@@ -1366,6 +1444,9 @@ _bt_next(IndexScanDesc scan, ScanDirection dir)
 		}
 	}
 
+	/* Prefetch the heap blocks of upcoming items */
+	_bt_prefetchheap(scan, dir);
+
 	/* OK, itemIndex says what to return */
 	currItem = &so->currPos.items[so->currPos.itemIndex];
 	scan->xs_heaptid = currItem->heapTid;
@@ -1375,6 +1456,83 @@ _bt_next(IndexScanDesc scan, ScanDirection dir)
 	return true;
 }
 
+/*
+ *	_bt_prefetchheap() -- Issue prefetches for upcoming heap blocks.
+ *
+ * Once a leaf page has been loaded into so->currPos we already know the
+ * heap TIDs of every matching tuple on it, so we can hint the kernel about
+ * the heap blocks the scan is about to fetch, overlapping their I/O with
+ * the current fetch.  This turns poorly-correlated range scans from
+ * synchronous random reads into pipelined ones.  We keep the prefetch
+ * window at most prefetchMaximum items ahead of the scan cursor, per the
+ * heap tablespace's effective_io_concurrency, as bitmap heap scans do.
+ *
+ * Called whenever itemIndex has settled on the next item to return.
+ */
+static void
+_bt_prefetchheap(IndexScanDesc scan, ScanDirection dir)
+{
+#ifdef USE_PREFETCH
+	BTScanOpaque so = (BTScanOpaque) scan->opaque;
+	BTScanPos	pos = &so->currPos;
+	BlockNumber lastblkno;
+
+	/*
+	 * Index-only scans visit the heap rarely enough that prefetching every
+	 * TID's block would do more harm than good; plain TID fetches (no heap
+	 * relation here) don't know the heap either.
+	 */
+	if (scan->xs_want_itup || scan->heapRelation == NULL)
+		return;
+
+	/* Look up the prefetch distance on first use */
+	if (so->prefetchMaximum < 0)
+		so->prefetchMaximum =
+			get_tablespace_io_concurrency(scan->heapRelation->rd_rel->reltablespace);
+
+	if (so->prefetchMaximum == 0)
+		return;					/* prefetching disabled */
+
+	if (ScanDirectionIsForward(dir))
+	{
+		int			limit = Min(pos->itemIndex + so->prefetchMaximum,
+								pos->lastItem);
+
+		lastblkno = pos->prefetchIndex > pos->firstItem ?
+			ItemPointerGetBlockNumber(&pos->items[pos->prefetchIndex - 1].heapTid) :
+			InvalidBlockNumber;
+		for (; pos->prefetchIndex <= limit; pos->prefetchIndex++)
+		{
+			BlockNumber blkno;
+
+			blkno = ItemPointerGetBlockNumber(&pos->items[pos->prefetchIndex].heapTid);
+			/* don't re-issue for runs of TIDs on the same heap block */
+			if (blkno != lastblkno)
+				PrefetchBuffer(scan->heapRelation, MAIN_FORKNUM, blkno);
+			lastblkno = blkno;
+		}
+	}
+	else
+	{
+		int			limit = Max(pos->itemIndex - so->prefetchMaximum,
+								pos->firstItem);
+
+		lastblkno = pos->prefetchIndex < pos->lastItem ?
+			ItemPointerGetBlockNumber(&pos->items[pos->prefetchIndex + 1].heapTid) :
+			InvalidBlockNumber;
+		for (; pos->prefetchIndex >= limit; pos->prefetchIndex--)
+		{
+			BlockNumber blkno;
+
+			blkno = ItemPointerGetBlockNumber(&pos->items[pos->prefetchIndex].heapTid);
+			if (blkno != lastblkno)
+				PrefetchBuffer(scan->heapRelation, MAIN_FORKNUM, blkno);
+			lastblkno = blkno;
+		}
+	}
+#endif							/* USE_PREFETCH */
+}
+
 /*
  *	_bt_readpage() -- Load data from current index page into so->currPos
  *
@@ -1523,6 +1681,7 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 		so->currPos.firstItem = 0;
 		so->currPos.lastItem = itemIndex - 1;
 		so->currPos.itemIndex = 0;
+		so->currPos.prefetchIndex = 0;
 	}
 	else
 	{
@@ -1586,6 +1745,7 @@ _bt_readpage(IndexScanDesc scan, ScanDirection dir, OffsetNumber offnum)
 		so->currPos.firstItem = itemIndex;
 		so->currPos.lastItem = MaxIndexTuplesPerPage - 1;
 		so->currPos.itemIndex = MaxIndexTuplesPerPage - 1;
+		so->currPos.prefetchIndex = MaxIndexTuplesPerPage - 1;
 	}
 
 	return (so->currPos.firstItem <= so->currPos.lastItem);
@@ -2216,6 +2376,9 @@ _bt_endpoint(IndexScanDesc scan, ScanDirection dir)
 		_bt_drop_lock_and_maybe_pin(scan, &so->currPos);
 	}
 
+	/* Prefetch the heap blocks of upcoming items */
+	_bt_prefetchheap(scan, dir);
+
 	/* OK, itemIndex says what to return */
 	currItem = &so->currPos.items[so->currPos.itemIndex];
 	scan->xs_heaptid = currItem->heapTid;
@@ -19,6 +19,15 @@ undoxacttest_desc(StringInfo buf, XLogReaderState *record)
 								 xlrec->newval, xlrec->debug_mod, xlrec->debug_oldval);
 			}
 			break;
+		case XLOG_UNDOXACTTEST_MOD_MULTI:
+			{
+				xl_undoxacttest_mod_multi *xlrec = (xl_undoxacttest_mod_multi *) rec;
+
+				appendStringInfo(buf, "newval: "INT64_FORMAT" debug_mod: "INT64_FORMAT" debug_oldval: "INT64_FORMAT" nmods: %d",
+								 xlrec->newval, xlrec->debug_mod, xlrec->debug_oldval,
+								 xlrec->nmods);
+			}
+			break;
 		default:
 			appendStringInfo(buf, "unknown action");
 	}
@@ -31,6 +40,8 @@ undoxacttest_identify(uint8 info)
 	{
 		case XLOG_UNDOXACTTEST_MOD:
 			return "mod";
+		case XLOG_UNDOXACTTEST_MOD_MULTI:
+			return "mod_multi";
 		default:
 			return NULL;
 	}
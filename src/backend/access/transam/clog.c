@@ -663,14 +663,21 @@ TransactionIdGetStatus(TransactionId xid, XLogRecPtr *lsn)
 	return status;
 }
 
+/* GUC variable */
+int			clog_buffers = 0;
+
 /*
  * Number of shared CLOG buffers.
  *
- * On larger multi-processor systems, it is possible to have many CLOG page
- * requests in flight at one time which could lead to disk access for CLOG
- * page if the required page is not found in memory.  Testing revealed that we
- * can get the best performance by having 128 CLOG buffers, more than that it
- * doesn't improve performance.
+ * If the clog_buffers GUC is set, use that, though never fewer buffers than
+ * the SLRU machinery is comfortable with.  Workloads that churn through XIDs
+ * faster than the default cache can hold them benefit from raising it.
+ *
+ * Otherwise auto-tune: on larger multi-processor systems, it is possible to
+ * have many CLOG page requests in flight at one time which could lead to
+ * disk access for CLOG page if the required page is not found in memory.
+ * Testing revealed that we can get the best performance by having 128 CLOG
+ * buffers, more than that it doesn't improve performance.
  *
  * Unconditionally keeping the number of CLOG buffers to 128 did not seem like
  * a good idea, because it would increase the minimum amount of shared memory
@@ -682,6 +689,8 @@ TransactionIdGetStatus(TransactionId xid, XLogRecPtr *lsn)
 Size
 CLOGShmemBuffers(void)
 {
+	if (clog_buffers > 0)
+		return Max(4, clog_buffers);
 	return Min(128, Max(4, NBuffers / 512));
 }
 
@@ -87,6 +87,7 @@
 #include "storage/pmsignal.h"
 #include "storage/proc.h"
 #include "storage/procarray.h"
+#include "storage/spin.h"
 #include "utils/builtins.h"
 #include "utils/memutils.h"
 #include "utils/snapmgr.h"
@@ -323,6 +324,42 @@ static dlist_head MXactCache = DLIST_STATIC_INIT(MXactCache);
 static int	MXactCacheMembers = 0;
 static MemoryContext MXactContext = NULL;
 
+/*
+ * A second-level cache of member sets lives in shared memory, so that
+ * repeated lookups of the same MultiXactId by different backends -- as
+ * happens with foreign-key row locks on hot rows -- need not contend for the
+ * SLRU control locks.  The cache is a simple direct-mapped table: each multi
+ * maps to exactly one slot, and a new entry just overwrites whatever its
+ * slot held before.  Each slot has its own spinlock; the protected
+ * operations are short, bounded memcpy()s, as spinlock rules require.
+ *
+ * A member set is immutable once created, so a cached entry can only become
+ * wrong through multixact wraparound reusing the same numeric ID.  To close
+ * that window, truncation drops the entries for the multis it removes (an ID
+ * must be truncated away before it can be reused), and readers consult the
+ * cache only after GetMultiXactIdMembers has range-checked the ID against
+ * the oldest valid multi.
+ *
+ * Sets with more than MXACT_SHARED_CACHE_MAX_MEMBERS members are not cached;
+ * they are rare, and bounding the member array keeps the slots small enough
+ * to afford a useful number of them.
+ */
+#define NUM_SHARED_MXACT_CACHE_SLOTS	16384
+#define MXACT_SHARED_CACHE_MAX_MEMBERS	16
+
+typedef struct mXactSharedCacheEnt
+{
+	slock_t		lock;
+	MultiXactId multi;			/* InvalidMultiXactId if slot unused */
+	int			nmembers;
+	MultiXactMember members[MXACT_SHARED_CACHE_MAX_MEMBERS];
+} mXactSharedCacheEnt;
+
+static mXactSharedCacheEnt *MXactSharedCache = NULL;
+
+#define MXactSharedCacheSlot(multi) \
+	(&MXactSharedCache[(multi) % NUM_SHARED_MXACT_CACHE_SLOTS])
+
 #ifdef MULTIXACT_DEBUG
 #define debug_elog2(a,b) elog(a,b)
 #define debug_elog3(a,b,c) elog(a,b,c)
@@ -349,6 +386,11 @@ static MultiXactId mXactCacheGetBySet(int nmembers, MultiXactMember *members);
 static int	mXactCacheGetById(MultiXactId multi, MultiXactMember **members);
 static void mXactCachePut(MultiXactId multi, int nmembers,
 						  MultiXactMember *members);
+static int	mXactSharedCacheGetById(MultiXactId multi,
+									MultiXactMember **members);
+static void mXactSharedCachePut(MultiXactId multi, int nmembers,
+								MultiXactMember *members);
+static void mXactSharedCacheTruncate(MultiXactId newOldestMulti);
 
 static char *mxstatus_to_string(MultiXactStatus status);
 
@@ -824,8 +866,9 @@ MultiXactIdCreateFromMembers(int nmembers, MultiXactMember *members)
 	/* Done with critical section */
 	END_CRIT_SECTION();
 
-	/* Store the new MultiXactId in the local cache, too */
+	/* Store the new MultiXactId in the local and shared caches, too */
 	mXactCachePut(multi, nmembers, members);
+	mXactSharedCachePut(multi, nmembers, members);
 
 	debug_elog2(DEBUG2, "Create: all done");
 
@@ -1287,6 +1330,21 @@ GetMultiXactIdMembers(MultiXactId multi, MultiXactMember **members,
 				 errmsg("MultiXactId %u has not been created yet -- apparent wraparound",
 						multi)));
 
+	/*
+	 * Try the shared cache next; now that the multi is known to be within
+	 * the valid range, a hit there cannot be a leftover from a wrapped-
+	 * around ID.  On a hit, prime the local cache too, so that further
+	 * lookups of the same multi avoid even the spinlock.
+	 */
+	length = mXactSharedCacheGetById(multi, members);
+	if (length >= 0)
+	{
+		debug_elog3(DEBUG2, "GetMembers: found %s in the shared cache",
+					mxid_to_string(multi, length, *members));
+		mXactCachePut(multi, length, *members);
+		return length;
+	}
+
 	/*
 	 * Find out the offset at which we need to start reading MultiXactMembers
 	 * and the number of members in the multixact.  We determine the latter as
@@ -1425,9 +1483,10 @@ retry:
 	LWLockRelease(MultiXactMemberControlLock);
 
 	/*
-	 * Copy the result into the local cache.
+	 * Copy the result into the local and shared caches.
 	 */
 	mXactCachePut(multi, truelength, ptr);
+	mXactSharedCachePut(multi, truelength, ptr);
 
 	debug_elog3(DEBUG2, "GetMembers: no cache for %s",
 				mxid_to_string(multi, truelength, ptr));
@@ -1606,6 +1665,93 @@ mXactCachePut(MultiXactId multi, int nmembers, MultiXactMember *members)
 	}
 }
 
+/*
+ * mXactSharedCacheGetById
+ *		returns the composing MultiXactMember set from the shared cache for
+ *		a given MultiXactId, if present.
+ *
+ * If successful, *members is set to the address of a palloc'd copy of the
+ * MultiXactMember set.  Return value is number of members, or -1 on failure.
+ *
+ * The caller must already have verified that multi is within the valid
+ * range; see the comments at MXactSharedCache.
+ */
+static int
+mXactSharedCacheGetById(MultiXactId multi, MultiXactMember **members)
+{
+	mXactSharedCacheEnt *ent = MXactSharedCacheSlot(multi);
+	MultiXactMember buf[MXACT_SHARED_CACHE_MAX_MEMBERS];
+	int			nmembers;
+
+	/* Copy out to a stack buffer; no palloc while holding a spinlock */
+	SpinLockAcquire(&ent->lock);
+	if (ent->multi != multi)
+	{
+		SpinLockRelease(&ent->lock);
+		debug_elog2(DEBUG2, "SharedCacheGet: not found");
+		return -1;
+	}
+	nmembers = ent->nmembers;
+	memcpy(buf, ent->members, nmembers * sizeof(MultiXactMember));
+	SpinLockRelease(&ent->lock);
+
+	*members = (MultiXactMember *) palloc(nmembers * sizeof(MultiXactMember));
+	memcpy(*members, buf, nmembers * sizeof(MultiXactMember));
+
+	debug_elog3(DEBUG2, "SharedCacheGet: found %s",
+				mxid_to_string(multi, nmembers, *members));
+	return nmembers;
+}
+
+/*
+ * mXactSharedCachePut
+ *		Add a MultiXactId and its composing set into the shared cache,
+ *		evicting whatever previously occupied its slot.
+ */
+static void
+mXactSharedCachePut(MultiXactId multi, int nmembers, MultiXactMember *members)
+{
+	mXactSharedCacheEnt *ent;
+
+	if (nmembers < 1 || nmembers > MXACT_SHARED_CACHE_MAX_MEMBERS)
+		return;
+
+	debug_elog3(DEBUG2, "SharedCachePut: storing %s",
+				mxid_to_string(multi, nmembers, members));
+
+	ent = MXactSharedCacheSlot(multi);
+	SpinLockAcquire(&ent->lock);
+	ent->multi = multi;
+	ent->nmembers = nmembers;
+	memcpy(ent->members, members, nmembers * sizeof(MultiXactMember));
+	SpinLockRelease(&ent->lock);
+}
+
+/*
+ * mXactSharedCacheTruncate
+ *		Drop shared cache entries for multis older than newOldestMulti.
+ *
+ * This must run before truncated-away IDs can be reused after wraparound;
+ * both TruncateMultiXact and its replay call here while holding
+ * MultiXactTruncationLock, which suffices.
+ */
+static void
+mXactSharedCacheTruncate(MultiXactId newOldestMulti)
+{
+	int			i;
+
+	for (i = 0; i < NUM_SHARED_MXACT_CACHE_SLOTS; i++)
+	{
+		mXactSharedCacheEnt *ent = &MXactSharedCache[i];
+
+		SpinLockAcquire(&ent->lock);
+		if (MultiXactIdIsValid(ent->multi) &&
+			MultiXactIdPrecedes(ent->multi, newOldestMulti))
+			ent->multi = InvalidMultiXactId;
+		SpinLockRelease(&ent->lock);
+	}
+}
+
 static char *
 mxstatus_to_string(MultiXactStatus status)
 {
@@ -1799,7 +1945,8 @@ multixact_twophase_postabort(TransactionId xid, uint16 info,
 /*
  * Initialization of shared memory for MultiXact.  We use two SLRU areas,
  * thus double memory.  Also, reserve space for the shared MultiXactState
- * struct and the per-backend MultiXactId arrays (two of those, too).
+ * struct, the per-backend MultiXactId arrays (two of those, too), and the
+ * shared member-set cache.
  */
 Size
 MultiXactShmemSize(void)
@@ -1814,6 +1961,8 @@ MultiXactShmemSize(void)
 	size = SHARED_MULTIXACT_STATE_SIZE;
 	size = add_size(size, SimpleLruShmemSize(NUM_MXACTOFFSET_BUFFERS, 0));
 	size = add_size(size, SimpleLruShmemSize(NUM_MXACTMEMBER_BUFFERS, 0));
+	size = add_size(size, mul_size(NUM_SHARED_MXACT_CACHE_SLOTS,
+								   sizeof(mXactSharedCacheEnt)));
 
 	return size;
 }
@@ -1857,6 +2006,26 @@ MultiXactShmemInit(void)
 	 */
 	OldestMemberMXactId = MultiXactState->perBackendXactIds;
 	OldestVisibleMXactId = OldestMemberMXactId + MaxOldestSlot;
+
+	/* Initialize the shared member-set cache */
+	MXactSharedCache = (mXactSharedCacheEnt *)
+		ShmemInitStruct("Shared MultiXact Member Cache",
+						mul_size(NUM_SHARED_MXACT_CACHE_SLOTS,
+								 sizeof(mXactSharedCacheEnt)),
+						&found);
+	if (!IsUnderPostmaster)
+	{
+		int			i;
+
+		Assert(!found);
+
+		MemSet(MXactSharedCache, 0,
+			   NUM_SHARED_MXACT_CACHE_SLOTS * sizeof(mXactSharedCacheEnt));
+		for (i = 0; i < NUM_SHARED_MXACT_CACHE_SLOTS; i++)
+			SpinLockInit(&MXactSharedCache[i].lock);
+	}
+	else
+		Assert(found);
 }
 
 /*
@@ -3044,6 +3213,9 @@ TruncateMultiXact(MultiXactId newOldestMulti, Oid newOldestMultiDB)
 		 MXOffsetToMemberSegment(oldestOffset),
 		 MXOffsetToMemberSegment(newOldestOffset));
 
+	/* Drop shared cache entries for the multis we're about to remove */
+	mXactSharedCacheTruncate(newOldestMulti);
+
 	/*
 	 * Do truncation, and the WAL logging of the truncation, in a critical
 	 * section. That way offsets/members cannot get out of sync anymore, i.e.
@@ -3309,6 +3481,9 @@ multixact_redo(XLogReaderState *record)
 		 */
 		SetMultiXactIdLimit(xlrec.endTruncOff, xlrec.oldestMultiDB, false);
 
+		/* Drop shared cache entries for the multis we're about to remove */
+		mXactSharedCacheTruncate(xlrec.endTruncOff);
+
 		PerformMembersTruncation(xlrec.startTruncMemb, xlrec.endTruncMemb);
 
 		/*
@@ -248,6 +248,7 @@ SimpleLruInit(SlruCtl ctl, const char *name, int nslots, int nlsns,
 	 */
 	ctl->shared = shared;
 	ctl->do_fsync = true;		/* default behavior */
+	ctl->last_read_slot = 0;
 	StrNCpy(ctl->Dir, subdir, sizeof(ctl->Dir));
 }
 
@@ -472,6 +473,21 @@ SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
 	/* Try to find the page while holding only shared lock */
 	LWLockAcquire(shared->ControlLock, LW_SHARED);
 
+	/*
+	 * First probe the slot where this backend last found a page; repeated
+	 * lookups tend to hit the same few hot pages, and this skips the scan
+	 * over all the buffers in that case.
+	 */
+	slotno = ctl->last_read_slot;
+	if (shared->page_number[slotno] == pageno &&
+		shared->page_status[slotno] != SLRU_PAGE_EMPTY &&
+		shared->page_status[slotno] != SLRU_PAGE_READ_IN_PROGRESS)
+	{
+		/* See comments for SlruRecentlyUsed macro */
+		SlruRecentlyUsed(shared, slotno);
+		return slotno;
+	}
+
 	/* See if page is already in a buffer */
 	for (slotno = 0; slotno < shared->num_slots; slotno++)
 	{
@@ -481,6 +497,7 @@ SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
 		{
 			/* See comments for SlruRecentlyUsed macro */
 			SlruRecentlyUsed(shared, slotno);
+			ctl->last_read_slot = slotno;
 			return slotno;
 		}
 	}
@@ -489,7 +506,9 @@ SimpleLruReadPage_ReadOnly(SlruCtl ctl, int pageno, TransactionId xid)
 	LWLockRelease(shared->ControlLock);
 	LWLockAcquire(shared->ControlLock, LW_EXCLUSIVE);
 
-	return SimpleLruReadPage(ctl, pageno, true, xid);
+	slotno = SimpleLruReadPage(ctl, pageno, true, xid);
+	ctl->last_read_slot = slotno;
+	return slotno;
 }
 
 /*
@@ -63,6 +63,33 @@ static SlruCtlData SubTransCtlData;
 #define SubTransCtl  (&SubTransCtlData)
 
 
+/*
+ * Per-backend cache of recent SubTransGetTopmostTransaction() results.
+ *
+ * Workloads that overflow the snapshot subxid cache look up the same
+ * subtransaction XIDs over and over while scanning a relation, and every
+ * lookup walks one SLRU page per nesting level under SubtransControlLock.
+ * Remembering recent results lets the common case skip the SLRU entirely.
+ *
+ * A cached result remains valid as long as TransactionXmin does not move:
+ * parent links are immutable and are recorded before the child XID can
+ * appear in any tuple, and pg_subtrans is never truncated past the oldest
+ * xmin.  The result does depend on TransactionXmin, though, since the walk
+ * stops there, so we discard the cache whenever TransactionXmin changes.
+ */
+#define NUM_SUBTRANS_CACHE_ENTRIES	16
+
+typedef struct SubTransCacheEntry
+{
+	TransactionId xid;			/* the XID that was looked up */
+	TransactionId topmost;		/* its topmost known ancestor */
+} SubTransCacheEntry;
+
+static SubTransCacheEntry SubTransCache[NUM_SUBTRANS_CACHE_ENTRIES];
+static int	SubTransCacheUsed = 0;	/* number of valid entries */
+static int	SubTransCacheNext = 0;	/* next victim for replacement */
+static TransactionId SubTransCacheXmin = InvalidTransactionId;
+
 static int	ZeroSUBTRANSPage(int pageno);
 static bool SubTransPagePrecedes(int page1, int page2);
 
@@ -151,10 +178,30 @@ SubTransGetTopmostTransaction(TransactionId xid)
 {
 	TransactionId parentXid = xid,
 				previousXid = xid;
+	int			i;
 
 	/* Can't ask about stuff that might not be around anymore */
 	Assert(TransactionIdFollowsOrEquals(xid, TransactionXmin));
 
+	/*
+	 * If the snapshot horizon has moved since the cache was filled, the
+	 * cached walks may have stopped at the wrong place; start over.
+	 */
+	if (!TransactionIdEquals(SubTransCacheXmin, TransactionXmin))
+	{
+		SubTransCacheUsed = 0;
+		SubTransCacheNext = 0;
+		SubTransCacheXmin = TransactionXmin;
+	}
+	else
+	{
+		for (i = 0; i < SubTransCacheUsed; i++)
+		{
+			if (TransactionIdEquals(SubTransCache[i].xid, xid))
+				return SubTransCache[i].topmost;
+		}
+	}
+
 	while (TransactionIdIsValid(parentXid))
 	{
 		previousXid = parentXid;
@@ -174,6 +221,13 @@ SubTransGetTopmostTransaction(TransactionId xid)
 
 	Assert(TransactionIdIsValid(previousXid));
 
+	/* Remember the result, replacing entries in insertion order */
+	SubTransCache[SubTransCacheNext].xid = xid;
+	SubTransCache[SubTransCacheNext].topmost = previousXid;
+	SubTransCacheNext = (SubTransCacheNext + 1) % NUM_SUBTRANS_CACHE_ENTRIES;
+	if (SubTransCacheUsed < NUM_SUBTRANS_CACHE_ENTRIES)
+		SubTransCacheUsed++;
+
 	return previousXid;
 }
 
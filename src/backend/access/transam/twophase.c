@@ -232,7 +232,8 @@ static void MarkAsPreparingGuts(GlobalTransaction gxact, TransactionId xid,
 								const char *gid, TimestampTz prepared_at, Oid owner,
 								Oid databaseid);
 static void RemoveTwoPhaseFile(TransactionId xid, bool giveWarning);
-static void RecreateTwoPhaseFile(TransactionId xid, void *content, int len);
+static void RecreateTwoPhaseFile(TransactionId xid, void *content, int len,
+								 bool do_sync);
 
 /*
  * Initialization of shared memory
@@ -1701,10 +1702,13 @@ RemoveTwoPhaseFile(TransactionId xid, bool giveWarning)
  * Recreates a state file. This is used in WAL replay and during
  * checkpoint creation.
  *
+ * Unless do_sync is set, the file is not fsync'd here; the caller is then
+ * responsible for making it durable before the checkpoint completes.
+ *
  * Note: content and len don't include CRC.
  */
 static void
-RecreateTwoPhaseFile(TransactionId xid, void *content, int len)
+RecreateTwoPhaseFile(TransactionId xid, void *content, int len, bool do_sync)
 {
 	char		path[MAXPGPATH];
 	pg_crc32c	statefile_crc;
@@ -1751,12 +1755,15 @@ RecreateTwoPhaseFile(TransactionId xid, void *content, int len)
 	 * We must fsync the file because the end-of-replay checkpoint will not do
 	 * so, there being no GXACT in shared memory yet to tell it to.
 	 */
-	pgstat_report_wait_start(WAIT_EVENT_TWOPHASE_FILE_SYNC);
-	if (pg_fsync(fd) != 0)
-		ereport(ERROR,
-				(errcode_for_file_access(),
-				 errmsg("could not fsync file \"%s\": %m", path)));
-	pgstat_report_wait_end();
+	if (do_sync)
+	{
+		pgstat_report_wait_start(WAIT_EVENT_TWOPHASE_FILE_SYNC);
+		if (pg_fsync(fd) != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not fsync file \"%s\": %m", path)));
+		pgstat_report_wait_end();
+	}
 
 	if (CloseTransientFile(fd) != 0)
 		ereport(ERROR,
@@ -1788,6 +1795,7 @@ CheckPointTwoPhase(XLogRecPtr redo_horizon)
 {
 	int			i;
 	int			serialized_xacts = 0;
+	TransactionId *serialized_xids = NULL;
 
 	if (max_prepared_xacts <= 0)
 		return;					/* nothing to do */
@@ -1827,16 +1835,65 @@ CheckPointTwoPhase(XLogRecPtr redo_horizon)
 			int			len;
 
 			XlogReadTwoPhaseData(gxact->prepare_start_lsn, &buf, &len);
-			RecreateTwoPhaseFile(gxact->xid, buf, len);
+			RecreateTwoPhaseFile(gxact->xid, buf, len, false);
 			gxact->ondisk = true;
 			gxact->prepare_start_lsn = InvalidXLogRecPtr;
 			gxact->prepare_end_lsn = InvalidXLogRecPtr;
 			pfree(buf);
-			serialized_xacts++;
+			if (serialized_xids == NULL)
+				serialized_xids = (TransactionId *)
+					palloc(TwoPhaseState->numPrepXacts * sizeof(TransactionId));
+			serialized_xids[serialized_xacts++] = gxact->xid;
 		}
 	}
 	LWLockRelease(TwoPhaseStateLock);
 
+	/*
+	 * The files written above were deliberately not fsync'd one by one.  Now
+	 * that all the writes have been issued, sync them in a single batch, so
+	 * that the kernel can overlap the flushes and we don't hold
+	 * TwoPhaseStateLock across any fsync.  The checkpoint is not complete
+	 * until this is done, so durability is preserved.
+	 *
+	 * Since the lock is no longer held, a concurrent COMMIT/ROLLBACK PREPARED
+	 * may unlink a file before we get to it.  That is fine: the removal
+	 * record was flushed to WAL before the unlink, so the file's contents are
+	 * no longer needed for durability.  Hence we open the files ourselves and
+	 * silently skip any that have disappeared, rather than using
+	 * fsync_fname() which would raise ERROR on ENOENT.
+	 */
+	for (i = 0; i < serialized_xacts; i++)
+	{
+		char		path[MAXPGPATH];
+		int			fd;
+
+		TwoPhaseFilePath(path, serialized_xids[i]);
+
+		fd = OpenTransientFile(path, O_RDWR | PG_BINARY);
+		if (fd < 0)
+		{
+			if (errno == ENOENT)
+				continue;
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not open file \"%s\": %m", path)));
+		}
+
+		pgstat_report_wait_start(WAIT_EVENT_TWOPHASE_FILE_SYNC);
+		if (pg_fsync(fd) != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not fsync file \"%s\": %m", path)));
+		pgstat_report_wait_end();
+
+		if (CloseTransientFile(fd) != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not close file \"%s\": %m", path)));
+	}
+	if (serialized_xids)
+		pfree(serialized_xids);
+
 	/*
 	 * Flush unconditionally the parent directory to make any information
 	 * durable on disk.  Two-phase files could have been removed and those
@@ -66,6 +66,7 @@ GetNewTransactionId(bool isSubXact)
 	{
 		Assert(!isSubXact);
 		MyPgXact->xid = BootstrapTransactionId;
+		ProcGlobal->xids[MyProc->pgxactoff] = BootstrapTransactionId;
 		return FullTransactionIdFromEpochAndXid(0, BootstrapTransactionId);
 	}
 
@@ -193,7 +194,10 @@ GetNewTransactionId(bool isSubXact)
 	 * Note that readers of PGXACT xid fields should be careful to fetch the
 	 * value only once, rather than assume they can read a value multiple
 	 * times and get the same answer each time.  Note we are assuming that
-	 * TransactionId and int fetch/store are atomic.
+	 * TransactionId and int fetch/store are atomic.  The dense mirror
+	 * entries in ProcGlobal must be updated together with the PGXACT
+	 * fields; holding XidGenLock is what entitles us to write our own
+	 * mirror entries here (see PROC_HDR).
 	 *
 	 * The same comments apply to the subxact xid count and overflow fields.
 	 *
@@ -219,7 +223,13 @@ GetNewTransactionId(bool isSubXact)
 	 * answer later on when someone does have a reason to inquire.)
 	 */
 	if (!isSubXact)
-		MyPgXact->xid = xid;	/* LWLockRelease acts as barrier */
+	{
+		Assert(!TransactionIdIsValid(ProcGlobal->xids[MyProc->pgxactoff]));
+
+		/* LWLockRelease acts as barrier */
+		MyPgXact->xid = xid;
+		ProcGlobal->xids[MyProc->pgxactoff] = xid;
+	}
 	else
 	{
 		int			nxids = MyPgXact->nxids;
@@ -229,9 +239,13 @@ GetNewTransactionId(bool isSubXact)
 			MyProc->subxids.xids[nxids] = xid;
 			pg_write_barrier();
 			MyPgXact->nxids = nxids + 1;
+			ProcGlobal->subxidStates[MyProc->pgxactoff].count = nxids + 1;
 		}
 		else
+		{
 			MyPgXact->overflowed = true;
+			ProcGlobal->subxidStates[MyProc->pgxactoff].overflowed = true;
+		}
 	}
 
 	LWLockRelease(XidGenLock);
@@ -61,6 +61,7 @@
 #include "storage/ipc.h"
 #include "storage/large_object.h"
 #include "storage/latch.h"
+#include "storage/md.h"
 #include "storage/pmsignal.h"
 #include "storage/predicate.h"
 #include "storage/proc.h"
@@ -95,16 +96,19 @@ char	   *XLogArchiveCommand = NULL;
 bool		EnableHotStandby = false;
 bool		fullPageWrites = true;
 bool		wal_log_hints = false;
-bool		wal_compression = false;
+int			wal_compression = WAL_COMPRESSION_NONE;
 char	   *wal_consistency_checking_string = NULL;
 bool	   *wal_consistency_checking = NULL;
 bool		wal_init_zero = true;
 bool		wal_recycle = true;
+int			wal_prealloc_segments = 1;
 bool		log_checkpoints = false;
 int			sync_method = DEFAULT_SYNC_METHOD;
 int			wal_level = WAL_LEVEL_MINIMAL;
 int			CommitDelay = 0;	/* precommit delay in microseconds */
 int			CommitSiblings = 5; /* # concurrent xacts needed to sleep */
+int			WalGroupCommitWindow = 0;	/* flush batching window in
+										 * microseconds */
 int			wal_retrieve_retry_interval = 5000;
 
 #ifdef WAL_DEBUG
@@ -116,9 +120,10 @@ int			wal_segment_size = DEFAULT_XLOG_SEG_SIZE;
 /*
  * Number of WAL insertion locks to use. A higher value allows more insertions
  * to happen concurrently, but adds some CPU overhead to flushing the WAL,
- * which needs to iterate all the locks.
+ * which needs to iterate all the locks.  Settable at server start so that
+ * machines with many cores can use more locks.
  */
-#define NUM_XLOGINSERT_LOCKS  8
+int			num_xloginsert_locks = 8;
 
 /*
  * Max distance from last checkpoint, before triggering a new xlog-based
@@ -543,6 +548,13 @@ typedef struct XLogCtlInsert
 	uint64		CurrBytePos;
 	uint64		PrevBytePos;
 
+	/*
+	 * Head of the list of processes waiting for a group WAL space
+	 * reservation (pgprocno of the latest joiner, or INVALID_PGPROCNO).
+	 * See ReserveXLogInsertLocation().
+	 */
+	pg_atomic_uint32 walReserveFirst;
+
 	/*
 	 * Make sure the above heavily-contended spinlock and byte positions are
 	 * on their own cache line. In particular, the RedoRecPtr and full page
@@ -608,6 +620,12 @@ typedef struct XLogCtlData
 	pg_time_t	lastSegSwitchTime;
 	XLogRecPtr	lastSegSwitchLSN;
 
+	/*
+	 * Time the last WAL flush completed.  Used to implement
+	 * wal_group_commit_window.  Protected by WALWriteLock.
+	 */
+	TimestampTz lastFlushTime;
+
 	/*
 	 * Protected by info_lck and WALWriteLock (you must hold either lock to
 	 * read it, but both to update)
@@ -922,6 +940,7 @@ static bool read_backup_label(XLogRecPtr *checkPointLoc,
 static bool read_tablespace_map(List **tablespaces);
 
 static void rm_redo_error_callback(void *arg);
+static void rm_redo_prefetch_blocks(XLogReaderState *record);
 static int	get_sync_bit(int method);
 
 static void CopyXLogRecordToWAL(int write_len, bool isLogSwitch,
@@ -1010,7 +1029,7 @@ XLogInsertRecord(XLogRecData *rdata,
 	 * inserter acquires an insertion lock. In addition to just indicating that
 	 * an insertion is in progress, the lock tells others how far the inserter
 	 * has progressed. There is a small fixed number of insertion locks,
-	 * determined by NUM_XLOGINSERT_LOCKS. When an inserter crosses a page
+	 * determined by num_xloginsert_locks. When an inserter crosses a page
 	 * boundary, it updates the value stored in the lock to the how far it has
 	 * inserted, to allow the previous buffer to be flushed.
 	 *
@@ -1242,6 +1261,14 @@ XLogInsertRecord(XLogRecData *rdata,
  * section as short as possible, insertpos_lck can be heavily contended on a
  * busy system.
  *
+ * To keep the serialized section from becoming a handoff between many
+ * processes, reservations are made in groups, in the style of
+ * TransactionGroupUpdateXidStatus(): each process publishes the size it
+ * needs in its PGPROC and adds itself to a list, and the first process to
+ * join claims one contiguous range for the whole group under a single
+ * spinlock acquisition, then hands each member its start and prev
+ * positions.
+ *
  * NB: The space calculation here must match the code in CopyXLogRecordToWAL,
  * where we actually copy the record to the reserved space.
  */
@@ -1250,9 +1277,11 @@ ReserveXLogInsertLocation(int size, XLogRecPtr *StartPos, XLogRecPtr *EndPos,
 						  XLogRecPtr *PrevPtr)
 {
 	XLogCtlInsert *Insert = &XLogCtl->Insert;
+	PGPROC	   *proc = MyProc;
 	uint64		startbytepos;
 	uint64		endbytepos;
 	uint64		prevbytepos;
+	uint32		nextidx;
 
 	size = MAXALIGN(size);
 
@@ -1269,15 +1298,160 @@ ReserveXLogInsertLocation(int size, XLogRecPtr *StartPos, XLogRecPtr *EndPos,
 	 * because the usable byte position doesn't include any headers, reserving
 	 * X bytes from WAL is almost as simple as "CurrBytePos += X".
 	 */
-	SpinLockAcquire(&Insert->insertpos_lck);
+	if (proc == NULL)
+	{
+		/* Standalone initialization: no group machinery available. */
+		SpinLockAcquire(&Insert->insertpos_lck);
 
-	startbytepos = Insert->CurrBytePos;
-	endbytepos = startbytepos + size;
-	prevbytepos = Insert->PrevBytePos;
-	Insert->CurrBytePos = endbytepos;
-	Insert->PrevBytePos = startbytepos;
+		startbytepos = Insert->CurrBytePos;
+		endbytepos = startbytepos + size;
+		prevbytepos = Insert->PrevBytePos;
+		Insert->CurrBytePos = endbytepos;
+		Insert->PrevBytePos = startbytepos;
 
-	SpinLockRelease(&Insert->insertpos_lck);
+		SpinLockRelease(&Insert->insertpos_lck);
+
+		*StartPos = XLogBytePosToRecPtr(startbytepos);
+		*EndPos = XLogBytePosToEndRecPtr(endbytepos);
+		*PrevPtr = XLogBytePosToRecPtr(prevbytepos);
+
+		Assert(XLogRecPtrToBytePos(*StartPos) == startbytepos);
+		Assert(XLogRecPtrToBytePos(*EndPos) == endbytepos);
+		Assert(XLogRecPtrToBytePos(*PrevPtr) == prevbytepos);
+		return;
+	}
+
+	/* Add ourselves to the list of processes waiting to reserve WAL. */
+	proc->walReserveMember = true;
+	proc->walReserveSize = size;
+
+	nextidx = pg_atomic_read_u32(&Insert->walReserveFirst);
+	while (true)
+	{
+		pg_atomic_write_u32(&proc->walReserveNext, nextidx);
+
+		if (pg_atomic_compare_exchange_u32(&Insert->walReserveFirst,
+										   &nextidx,
+										   (uint32) proc->pgprocno))
+			break;
+	}
+
+	/*
+	 * If the list was not empty, the leader will assign our position.  It is
+	 * impossible to have followers without a leader because the first
+	 * process that has added itself to the list will always have nextidx as
+	 * INVALID_PGPROCNO.
+	 */
+	if (nextidx != INVALID_PGPROCNO)
+	{
+		int			extraWaits = 0;
+
+		/* Sleep until the leader assigns our WAL position. */
+		pgstat_report_wait_start(WAIT_EVENT_WAL_RESERVE_GROUP_UPDATE);
+		for (;;)
+		{
+			/* acts as a read barrier */
+			PGSemaphoreLock(proc->sem);
+			if (!proc->walReserveMember)
+				break;
+			extraWaits++;
+		}
+		pgstat_report_wait_end();
+
+		Assert(pg_atomic_read_u32(&proc->walReserveNext) == INVALID_PGPROCNO);
+
+		/* Fix semaphore count for any absorbed wakeups */
+		while (extraWaits-- > 0)
+			PGSemaphoreUnlock(proc->sem);
+
+		startbytepos = proc->walReserveStartBytePos;
+		prevbytepos = proc->walReservePrevBytePos;
+		endbytepos = startbytepos + size;
+	}
+	else
+	{
+		uint64		groupsize = 0;
+		uint64		lastsize = 0;
+		uint64		pos;
+		uint64		prev;
+		uint32		wakeidx;
+
+		/*
+		 * We are the leader.  Detach the whole list; anyone who joins after
+		 * this will form a new group with a new leader.
+		 */
+		nextidx = pg_atomic_exchange_u32(&Insert->walReserveFirst,
+										 INVALID_PGPROCNO);
+		wakeidx = nextidx;
+
+		/*
+		 * Add up the space the whole group needs.  The list is newest-first,
+		 * so the last process visited is the one whose record will end up
+		 * last in the claimed range; remember its size so that PrevBytePos
+		 * can be computed without walking the list under the spinlock.
+		 */
+		while (nextidx != INVALID_PGPROCNO)
+		{
+			PGPROC	   *member = &ProcGlobal->allProcs[nextidx];
+
+			lastsize = member->walReserveSize;
+			groupsize += lastsize;
+			nextidx = pg_atomic_read_u32(&member->walReserveNext);
+		}
+
+		/* Claim one contiguous range for the whole group. */
+		SpinLockAcquire(&Insert->insertpos_lck);
+
+		pos = Insert->CurrBytePos;
+		prev = Insert->PrevBytePos;
+		Insert->CurrBytePos = pos + groupsize;
+		Insert->PrevBytePos = pos + groupsize - lastsize;
+
+		SpinLockRelease(&Insert->insertpos_lck);
+
+		/*
+		 * Hand out positions in list order.  Each member's record directly
+		 * follows the previous member's, so the prev-link of each record
+		 * points at its predecessor within the group, and the first member's
+		 * at the record reserved before the group.
+		 */
+		nextidx = wakeidx;
+		while (nextidx != INVALID_PGPROCNO)
+		{
+			PGPROC	   *member = &ProcGlobal->allProcs[nextidx];
+
+			member->walReserveStartBytePos = pos;
+			member->walReservePrevBytePos = prev;
+			prev = pos;
+			pos += member->walReserveSize;
+
+			nextidx = pg_atomic_read_u32(&member->walReserveNext);
+		}
+
+		startbytepos = proc->walReserveStartBytePos;
+		prevbytepos = proc->walReservePrevBytePos;
+		endbytepos = startbytepos + size;
+
+		/*
+		 * Wake everybody up.  As in TransactionGroupUpdateXidStatus(), clear
+		 * the next-links first so that members see a fully reset state.
+		 */
+		while (wakeidx != INVALID_PGPROCNO)
+		{
+			PGPROC	   *member = &ProcGlobal->allProcs[wakeidx];
+
+			wakeidx = pg_atomic_read_u32(&member->walReserveNext);
+			pg_atomic_write_u32(&member->walReserveNext, INVALID_PGPROCNO);
+
+			/* ensure all previous writes are visible before follower continues */
+			pg_write_barrier();
+
+			member->walReserveMember = false;
+
+			if (member != proc)
+				PGSemaphoreUnlock(member->sem);
+		}
+	}
 
 	*StartPos = XLogBytePosToRecPtr(startbytepos);
 	*EndPos = XLogBytePosToEndRecPtr(endbytepos);
@@ -1633,7 +1807,7 @@ WALInsertLockAcquire(void)
 	static int	lockToTry = -1;
 
 	if (lockToTry == -1)
-		lockToTry = MyProc->pgprocno % NUM_XLOGINSERT_LOCKS;
+		lockToTry = MyProc->pgprocno % num_xloginsert_locks;
 	MyLockNo = lockToTry;
 
 	/*
@@ -1651,7 +1825,7 @@ WALInsertLockAcquire(void)
 		 * than locks, it still helps to distribute the inserters evenly
 		 * across the locks.
 		 */
-		lockToTry = (lockToTry + 1) % NUM_XLOGINSERT_LOCKS;
+		lockToTry = (lockToTry + 1) % num_xloginsert_locks;
 	}
 }
 
@@ -1669,7 +1843,7 @@ WALInsertLockAcquireExclusive(void)
 	 * indicator is set to 0xFFFFFFFFFFFFFFFF, which is higher than any real
 	 * XLogRecPtr value, to make sure that no-one blocks waiting on those.
 	 */
-	for (i = 0; i < NUM_XLOGINSERT_LOCKS - 1; i++)
+	for (i = 0; i < num_xloginsert_locks - 1; i++)
 	{
 		LWLockAcquire(&WALInsertLocks[i].l.lock, LW_EXCLUSIVE);
 		LWLockUpdateVar(&WALInsertLocks[i].l.lock,
@@ -1695,7 +1869,7 @@ WALInsertLockRelease(void)
 	{
 		int			i;
 
-		for (i = 0; i < NUM_XLOGINSERT_LOCKS; i++)
+		for (i = 0; i < num_xloginsert_locks; i++)
 			LWLockReleaseClearVar(&WALInsertLocks[i].l.lock,
 								  &WALInsertLocks[i].l.insertingAt,
 								  0);
@@ -1723,8 +1897,8 @@ WALInsertLockUpdateInsertingAt(XLogRecPtr insertingAt)
 		 * We use the last lock to mark our actual position, see comments in
 		 * WALInsertLockAcquireExclusive.
 		 */
-		LWLockUpdateVar(&WALInsertLocks[NUM_XLOGINSERT_LOCKS - 1].l.lock,
-						&WALInsertLocks[NUM_XLOGINSERT_LOCKS - 1].l.insertingAt,
+		LWLockUpdateVar(&WALInsertLocks[num_xloginsert_locks - 1].l.lock,
+						&WALInsertLocks[num_xloginsert_locks - 1].l.insertingAt,
 						insertingAt);
 	}
 	else
@@ -1791,7 +1965,7 @@ WaitXLogInsertionsToFinish(XLogRecPtr upto)
 	 * out for any insertion that's still in progress.
 	 */
 	finishedUpto = reservedUpto;
-	for (i = 0; i < NUM_XLOGINSERT_LOCKS; i++)
+	for (i = 0; i < num_xloginsert_locks; i++)
 	{
 		XLogRecPtr	insertingat = InvalidXLogRecPtr;
 
@@ -1952,6 +2126,75 @@ GetXLogBuffer(XLogRecPtr ptr)
 	return cachedPos + ptr % XLOG_BLCKSZ;
 }
 
+/*
+ * Try to read WAL data directly from the WAL buffers, avoiding the round
+ * trip through the kernel's page cache.
+ *
+ * Reads 'count' bytes starting at 'startptr' into 'dstbuf' and returns the
+ * number of bytes actually copied, which can be less than 'count' (zero if
+ * the requested range has already been evicted from the buffers).  The
+ * caller must only ask for WAL on the current insert timeline that it knows
+ * to have been written out already; typically that means WAL up to the
+ * flushed position as obtained from GetFlushRecPtr().
+ *
+ * We read the buffers without taking any locks, in the same way that
+ * GetXLogBuffer() reads xlblocks: check which page a buffer holds before and
+ * after copying it, and discard the copy if the buffer was recycled
+ * underneath us.  The xlblocks value for a given buffer only ever increases,
+ * so there is no ABA hazard, and a torn read merely causes a false mismatch.
+ */
+Size
+XLogReadFromBuffers(char *dstbuf, XLogRecPtr startptr, Size count)
+{
+	char	   *pdst = dstbuf;
+	XLogRecPtr	recptr = startptr;
+	Size		nbytes = count;
+
+	if (RecoveryInProgress())
+		return 0;
+
+	Assert(!XLogRecPtrIsInvalid(startptr));
+
+	while (nbytes > 0)
+	{
+		uint32		offset = recptr % XLOG_BLCKSZ;
+		int			idx = XLogRecPtrToBufIdx(recptr);
+		XLogRecPtr	expectedEndPtr;
+		XLogRecPtr	endptr;
+		const char *page;
+		Size		ncopy;
+
+		expectedEndPtr = recptr + (XLOG_BLCKSZ - offset);
+
+		endptr = XLogCtl->xlblocks[idx];
+		if (endptr != expectedEndPtr)
+			break;
+
+		/* don't let the copy be reordered before the check above */
+		pg_read_barrier();
+
+		ncopy = Min(nbytes, XLOG_BLCKSZ - offset);
+		page = XLogCtl->pages + idx * (Size) XLOG_BLCKSZ;
+		memcpy(pdst, page + offset, ncopy);
+
+		/* ... nor after the re-check below */
+		pg_read_barrier();
+
+		/* was the buffer recycled while we were copying from it? */
+		endptr = XLogCtl->xlblocks[idx];
+		if (endptr != expectedEndPtr)
+			break;
+
+		pdst += ncopy;
+		recptr += ncopy;
+		nbytes -= ncopy;
+	}
+
+	Assert((Size) (pdst - dstbuf) <= count);
+
+	return pdst - dstbuf;
+}
+
 /*
  * Converts a "usable byte position" to XLogRecPtr. A usable byte position
  * is the position starting from the beginning of WAL, excluding all WAL
@@ -2605,6 +2848,10 @@ XLogWrite(XLogwrtRqst WriteRqst, bool flexible)
 			issue_xlog_fsync(openLogFile, openLogSegNo);
 		}
 
+		/* remember when this flush finished, for wal_group_commit_window */
+		if (WalGroupCommitWindow > 0)
+			XLogCtl->lastFlushTime = GetCurrentTimestamp();
+
 		/* signal that we need to wakeup walsenders later */
 		WalSndWakeupRequest();
 
@@ -2896,11 +3143,33 @@ XLogFlush(XLogRecPtr record)
 		 * followers; this can significantly improve transaction throughput,
 		 * at the risk of increasing transaction latency.
 		 *
-		 * We do not sleep if enableFsync is not turned on, nor if there are
-		 * fewer than CommitSiblings other backends with active transactions.
+		 * With wal_group_commit_window, the delay is a latency target rather
+		 * than a fixed sleep: we only wait out the remainder of the window
+		 * since the previous flush completed, so that at most one fsync is
+		 * issued per window.  On a device that is already saturated the
+		 * window has usually passed by the time we get here and no extra
+		 * latency is added, which makes it safer than commit_delay on fast
+		 * storage.
+		 *
+		 * We do not sleep if enableFsync is not turned on, nor (for
+		 * commit_delay) if there are fewer than CommitSiblings other
+		 * backends with active transactions.
 		 */
-		if (CommitDelay > 0 && enableFsync &&
-			MinimumActiveBackends(CommitSiblings))
+		if (WalGroupCommitWindow > 0 && enableFsync)
+		{
+			long		elapsed;
+
+			elapsed = (long) (GetCurrentTimestamp() - XLogCtl->lastFlushTime);
+			if (elapsed >= 0 && elapsed < WalGroupCommitWindow)
+			{
+				pg_usleep(WalGroupCommitWindow - elapsed);
+
+				/* see the note below about re-checking insertpos */
+				insertpos = WaitXLogInsertionsToFinish(insertpos);
+			}
+		}
+		else if (CommitDelay > 0 && enableFsync &&
+				 MinimumActiveBackends(CommitSiblings))
 		{
 			pg_usleep(CommitDelay);
 
@@ -3103,6 +3372,15 @@ XLogBackgroundFlush(void)
 	 */
 	AdvanceXLInsertBuffer(InvalidXLogRecPtr, true);
 
+	/*
+	 * Likewise, keep the pool of preallocated WAL segments topped up from
+	 * here rather than leaving segment creation to some backend's commit
+	 * path.  With the default setting this is a no-op most of the time;
+	 * checkpoints take care of it as before.
+	 */
+	if (wal_prealloc_segments > 1)
+		PreallocXlogFiles(LogwrtResult.Write);
+
 	/*
 	 * If we determined that we need to write data, but somebody else
 	 * wrote/flushed already, it should be considered as being active, to
@@ -3804,12 +4082,16 @@ XLogFileClose(void)
 /*
  * Preallocate log files beyond the specified log endpoint.
  *
- * XXX this is currently extremely conservative, since it forces only one
- * future log segment to exist, and even that only if we are 75% done with
- * the current one.  This is only appropriate for very low-WAL-volume systems.
- * High-volume systems will be OK once they've built up a sufficient set of
- * recycled log segments, but the startup transient is likely to include
- * a lot of segment creations by foreground processes, which is not so good.
+ * With the default setting of one segment we keep the historical
+ * conservative behavior: force only one future log segment to exist, and
+ * even that only if we are 75% done with the current one.  That is only
+ * appropriate for very low-WAL-volume systems; high-volume systems are OK
+ * once they've built up a sufficient set of recycled log segments, but the
+ * startup transient is likely to include a lot of segment creations by
+ * foreground processes, which is not so good.  Raising
+ * wal_prealloc_segments instead maintains a pool of that many ready
+ * segments ahead of the insert position, so that foreground processes
+ * never have to zero-fill a new segment during a write burst.
  */
 static void
 PreallocXlogFiles(XLogRecPtr endptr)
@@ -3818,10 +4100,14 @@ PreallocXlogFiles(XLogRecPtr endptr)
 	int			lf;
 	bool		use_existent;
 	uint64		offset;
+	int			nsegs = wal_prealloc_segments;
 
 	XLByteToPrevSeg(endptr, _logSegNo, wal_segment_size);
 	offset = XLogSegmentOffset(endptr - 1, wal_segment_size);
-	if (offset >= (uint32) (0.75 * wal_segment_size))
+	if (nsegs <= 1 && offset < (uint32) (0.75 * wal_segment_size))
+		return;
+
+	while (nsegs-- > 0)
 	{
 		_logSegNo++;
 		use_existent = true;
@@ -4508,7 +4794,7 @@ WriteControlFile(void)
 	ControlFile->floatFormat = FLOATFORMAT_VALUE;
 
 	ControlFile->blcksz = BLCKSZ;
-	ControlFile->relseg_size = RELSEG_SIZE;
+	ControlFile->relseg_size = rel_segment_size;
 	ControlFile->xlog_blcksz = XLOG_BLCKSZ;
 	ControlFile->xlog_seg_size = wal_segment_size;
 
@@ -4581,6 +4867,7 @@ ReadControlFile(void)
 	pg_crc32c	crc;
 	int			fd;
 	static char wal_segsz_str[20];
+	static char rel_segsz_str[20];
 	int			r;
 
 	/*
@@ -4679,13 +4966,13 @@ ReadControlFile(void)
 						   " but the server was compiled with BLCKSZ %d.",
 						   ControlFile->blcksz, BLCKSZ),
 				 errhint("It looks like you need to recompile or initdb.")));
-	if (ControlFile->relseg_size != RELSEG_SIZE)
+	if (ControlFile->relseg_size <= 0)
 		ereport(FATAL,
 				(errmsg("database files are incompatible with server"),
-				 errdetail("The database cluster was initialized with RELSEG_SIZE %d,"
-						   " but the server was compiled with RELSEG_SIZE %d.",
-						   ControlFile->relseg_size, RELSEG_SIZE),
-				 errhint("It looks like you need to recompile or initdb.")));
+				 errdetail("The database cluster was initialized with an invalid"
+						   " relation segment size %d.",
+						   ControlFile->relseg_size),
+				 errhint("It looks like you need to initdb.")));
 	if (ControlFile->xlog_blcksz != XLOG_BLCKSZ)
 		ereport(FATAL,
 				(errmsg("database files are incompatible with server"),
@@ -4767,6 +5054,13 @@ ReadControlFile(void)
 	SetConfigOption("wal_segment_size", wal_segsz_str, PGC_INTERNAL,
 					PGC_S_OVERRIDE);
 
+	/* likewise adopt the cluster's relation segment size */
+	rel_segment_size = ControlFile->relseg_size;
+
+	snprintf(rel_segsz_str, sizeof(rel_segsz_str), "%d", rel_segment_size);
+	SetConfigOption("segment_size", rel_segsz_str, PGC_INTERNAL,
+					PGC_S_OVERRIDE);
+
 	/* check and update variables dependent on wal_segment_size */
 	if (ConvertToXSegs(min_wal_size_mb, wal_segment_size) < 2)
 		ereport(ERROR, (errcode(ERRCODE_INVALID_PARAMETER_VALUE),
@@ -4955,7 +5249,7 @@ XLOGShmemSize(void)
 	size = sizeof(XLogCtlData);
 
 	/* WAL insertion locks, plus alignment */
-	size = add_size(size, mul_size(sizeof(WALInsertLockPadded), NUM_XLOGINSERT_LOCKS + 1));
+	size = add_size(size, mul_size(sizeof(WALInsertLockPadded), num_xloginsert_locks + 1));
 	/* xlblocks array */
 	size = add_size(size, mul_size(sizeof(XLogRecPtr), XLOGbuffers));
 	/* extra alignment padding for XLOG I/O buffers */
@@ -5047,10 +5341,10 @@ XLOGShmemInit(void)
 		((uintptr_t) allocptr) % sizeof(WALInsertLockPadded);
 	WALInsertLocks = XLogCtl->Insert.WALInsertLocks =
 		(WALInsertLockPadded *) allocptr;
-	allocptr += sizeof(WALInsertLockPadded) * NUM_XLOGINSERT_LOCKS;
+	allocptr += sizeof(WALInsertLockPadded) * num_xloginsert_locks;
 
 	LWLockRegisterTranche(LWTRANCHE_WAL_INSERT, "wal_insert");
-	for (i = 0; i < NUM_XLOGINSERT_LOCKS; i++)
+	for (i = 0; i < num_xloginsert_locks; i++)
 	{
 		LWLockInitialize(&WALInsertLocks[i].l.lock, LWTRANCHE_WAL_INSERT);
 		WALInsertLocks[i].l.insertingAt = InvalidXLogRecPtr;
@@ -5076,6 +5370,7 @@ XLOGShmemInit(void)
 	XLogCtl->WalWriterSleeping = false;
 
 	SpinLockInit(&XLogCtl->Insert.insertpos_lck);
+	pg_atomic_init_u32(&XLogCtl->Insert.walReserveFirst, INVALID_PGPROCNO);
 	SpinLockInit(&XLogCtl->info_lck);
 	SpinLockInit(&XLogCtl->ulsn_lck);
 	InitSharedLatch(&XLogCtl->recoveryWakeupLatch);
@@ -7187,6 +7482,12 @@ StartupXLOG(void)
 					TransactionIdIsValid(record->xl_xid))
 					RecordKnownAssignedTransactionIds(record->xl_xid);
 
+				/*
+				 * Get reads for any further blocks this record touches going
+				 * before we start replaying it.
+				 */
+				rm_redo_prefetch_blocks(xlogreader);
+
 				/* Now apply the WAL record itself */
 				RmgrTable[record->xl_rmid].rm_redo(xlogreader);
 
@@ -8280,7 +8581,7 @@ GetLastImportantRecPtr(void)
 	XLogRecPtr	res = InvalidXLogRecPtr;
 	int			i;
 
-	for (i = 0; i < NUM_XLOGINSERT_LOCKS; i++)
+	for (i = 0; i < num_xloginsert_locks; i++)
 	{
 		XLogRecPtr	last_important;
 
@@ -11445,6 +11746,45 @@ rm_redo_error_callback(void *arg)
 	pfree(buf.data);
 }
 
+/*
+ * Issue prefetch requests for the blocks a record references before it is
+ * replayed, so that a record touching several blocks that are not yet in
+ * shared buffers has their reads in flight concurrently instead of faulting
+ * them in one at a time inside rm_redo.
+ *
+ * Blocks whose full-page image will be applied are skipped; those are
+ * (re)initialized from the WAL record without reading the old contents.
+ * The first block that would need a read is also skipped, because rm_redo
+ * will typically read it immediately anyway and the posix_fadvise would buy
+ * nothing.
+ */
+static void
+rm_redo_prefetch_blocks(XLogReaderState *record)
+{
+#ifdef USE_PREFETCH
+	int			block_id;
+	bool		skipped_first = false;
+
+	for (block_id = 0; block_id <= record->max_block_id; block_id++)
+	{
+		DecodedBkpBlock *blk = &record->blocks[block_id];
+
+		if (!blk->in_use)
+			continue;
+		if (blk->apply_image)
+			continue;
+
+		if (!skipped_first)
+		{
+			skipped_first = true;
+			continue;
+		}
+
+		PrefetchBufferWithoutRelcache(blk->rnode, blk->forknum, blk->blkno);
+	}
+#endif							/* USE_PREFETCH */
+}
+
 /*
  * BackupInProgress: check if online backup mode is active
  *
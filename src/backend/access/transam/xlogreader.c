@@ -17,6 +17,14 @@
  */
 #include "postgres.h"
 
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
 #include "access/transam.h"
 #include "access/xlogrecord.h"
 #include "access/xlog_internal.h"
@@ -1030,12 +1038,14 @@ ResetDecoder(XLogReaderState *state)
 	state->decoded_record = NULL;
 
 	state->main_data_len = 0;
+	state->main_data_src = NULL;
 
 	for (block_id = 0; block_id <= state->max_block_id; block_id++)
 	{
 		state->blocks[block_id].in_use = false;
 		state->blocks[block_id].has_image = false;
 		state->blocks[block_id].has_data = false;
+		state->blocks[block_id].data_src = NULL;
 		state->blocks[block_id].apply_image = false;
 	}
 	state->max_block_id = -1;
@@ -1164,7 +1174,7 @@ DecodeXLogRecord(XLogReaderState *state, XLogRecord *record, char **errormsg)
 
 				blk->apply_image = ((blk->bimg_info & BKPIMAGE_APPLY) != 0);
 
-				if (blk->bimg_info & BKPIMAGE_IS_COMPRESSED)
+				if (BKPIMAGE_COMPRESSED(blk->bimg_info))
 				{
 					if (blk->bimg_info & BKPIMAGE_HAS_HOLE)
 						COPY_HEADER_FIELD(&blk->hole_length, sizeof(uint16));
@@ -1209,29 +1219,28 @@ DecodeXLogRecord(XLogReaderState *state, XLogRecord *record, char **errormsg)
 				}
 
 				/*
-				 * cross-check that bimg_len < BLCKSZ if the IS_COMPRESSED
-				 * flag is set.
+				 * cross-check that bimg_len < BLCKSZ if it is compressed.
 				 */
-				if ((blk->bimg_info & BKPIMAGE_IS_COMPRESSED) &&
+				if (BKPIMAGE_COMPRESSED(blk->bimg_info) &&
 					blk->bimg_len == BLCKSZ)
 				{
 					report_invalid_record(state,
-										  "BKPIMAGE_IS_COMPRESSED set, but block image length %u at %X/%X",
+										  "BKPIMAGE_COMPRESSED set, but block image length %u at %X/%X",
 										  (unsigned int) blk->bimg_len,
 										  (uint32) (state->ReadRecPtr >> 32), (uint32) state->ReadRecPtr);
 					goto err;
 				}
 
 				/*
-				 * cross-check that bimg_len = BLCKSZ if neither HAS_HOLE nor
-				 * IS_COMPRESSED flag is set.
+				 * cross-check that bimg_len = BLCKSZ if neither HAS_HOLE is
+				 * set nor the image is compressed.
 				 */
 				if (!(blk->bimg_info & BKPIMAGE_HAS_HOLE) &&
-					!(blk->bimg_info & BKPIMAGE_IS_COMPRESSED) &&
+					!BKPIMAGE_COMPRESSED(blk->bimg_info) &&
 					blk->bimg_len != BLCKSZ)
 				{
 					report_invalid_record(state,
-										  "neither BKPIMAGE_HAS_HOLE nor BKPIMAGE_IS_COMPRESSED set, but block image length is %u at %X/%X",
+										  "neither BKPIMAGE_HAS_HOLE nor BKPIMAGE_COMPRESSED set, but block image length is %u at %X/%X",
 										  (unsigned int) blk->data_len,
 										  (uint32) (state->ReadRecPtr >> 32), (uint32) state->ReadRecPtr);
 					goto err;
@@ -1273,11 +1282,13 @@ DecodeXLogRecord(XLogReaderState *state, XLogRecord *record, char **errormsg)
 	/*
 	 * Ok, we've parsed the fragment headers, and verified that the total
 	 * length of the payload in the fragments is equal to the amount of data
-	 * left. Copy the data of each fragment to a separate buffer.
+	 * left.  Set up pointers into the record for the data of each fragment.
 	 *
-	 * We could just set up pointers into readRecordBuf, but we want to align
-	 * the data for the convenience of the callers. Backup images are not
-	 * copied, however; they don't need alignment.
+	 * The data is not copied out of the record here; XLogRecGetBlockData and
+	 * XLogRecGetMainData copy it into an aligned buffer on first access, so
+	 * callers that never look at a fragment (e.g. logical decoding skipping
+	 * over an uninteresting record) don't pay for the copy at all.  Backup
+	 * images are never copied; they don't need alignment.
 	 */
 
 	/* block data first */
@@ -1297,20 +1308,7 @@ DecodeXLogRecord(XLogReaderState *state, XLogRecord *record, char **errormsg)
 		}
 		if (blk->has_data)
 		{
-			if (!blk->data || blk->data_len > blk->data_bufsz)
-			{
-				if (blk->data)
-					pfree(blk->data);
-
-				/*
-				 * Force the initial request to be BLCKSZ so that we don't
-				 * waste time with lots of trips through this stanza as a
-				 * result of WAL compression.
-				 */
-				blk->data_bufsz = MAXALIGN(Max(blk->data_len, BLCKSZ));
-				blk->data = palloc(blk->data_bufsz);
-			}
-			memcpy(blk->data, ptr, blk->data_len);
+			blk->data_src = ptr;
 			ptr += blk->data_len;
 		}
 	}
@@ -1318,29 +1316,7 @@ DecodeXLogRecord(XLogReaderState *state, XLogRecord *record, char **errormsg)
 	/* and finally, the main data */
 	if (state->main_data_len > 0)
 	{
-		if (!state->main_data || state->main_data_len > state->main_data_bufsz)
-		{
-			if (state->main_data)
-				pfree(state->main_data);
-
-			/*
-			 * main_data_bufsz must be MAXALIGN'ed.  In many xlog record
-			 * types, we omit trailing struct padding on-disk to save a few
-			 * bytes; but compilers may generate accesses to the xlog struct
-			 * that assume that padding bytes are present.  If the palloc
-			 * request is not large enough to include such padding bytes then
-			 * we'll get valgrind complaints due to otherwise-harmless fetches
-			 * of the padding bytes.
-			 *
-			 * In addition, force the initial request to be reasonably large
-			 * so that we don't waste time with lots of trips through this
-			 * stanza.  BLCKSZ / 2 seems like a good compromise choice.
-			 */
-			state->main_data_bufsz = MAXALIGN(Max(state->main_data_len,
-												  BLCKSZ / 2));
-			state->main_data = palloc(state->main_data_bufsz);
-		}
-		memcpy(state->main_data, ptr, state->main_data_len);
+		state->main_data_src = ptr;
 		ptr += state->main_data_len;
 	}
 
@@ -1382,10 +1358,57 @@ XLogRecGetBlockTag(XLogReaderState *record, uint8 block_id,
 	return true;
 }
 
+/*
+ * Returns the main data portion of the currently decoded record.  The
+ * returned pointer points to a MAXALIGNed buffer.
+ *
+ * The copy out of the record is performed here, on first access, rather
+ * than in DecodeXLogRecord, so that records whose main data is never
+ * examined are not copied at all.
+ */
+char *
+XLogRecGetMainData(XLogReaderState *record)
+{
+	if (record->main_data_src != NULL)
+	{
+		if (!record->main_data ||
+			record->main_data_len > record->main_data_bufsz)
+		{
+			if (record->main_data)
+				pfree(record->main_data);
+
+			/*
+			 * main_data_bufsz must be MAXALIGN'ed.  In many xlog record
+			 * types, we omit trailing struct padding on-disk to save a few
+			 * bytes; but compilers may generate accesses to the xlog struct
+			 * that assume that padding bytes are present.  If the palloc
+			 * request is not large enough to include such padding bytes then
+			 * we'll get valgrind complaints due to otherwise-harmless fetches
+			 * of the padding bytes.
+			 *
+			 * In addition, force the initial request to be reasonably large
+			 * so that we don't waste time with lots of trips through this
+			 * stanza.  BLCKSZ / 2 seems like a good compromise choice.
+			 */
+			record->main_data_bufsz = MAXALIGN(Max(record->main_data_len,
+												   BLCKSZ / 2));
+			record->main_data = palloc(record->main_data_bufsz);
+		}
+		memcpy(record->main_data, record->main_data_src,
+			   record->main_data_len);
+		record->main_data_src = NULL;
+	}
+
+	return record->main_data;
+}
+
 /*
  * Returns the data associated with a block reference, or NULL if there is
  * no data (e.g. because a full-page image was taken instead). The returned
  * pointer points to a MAXALIGNed buffer.
+ *
+ * As with XLogRecGetMainData, the data is copied out of the record into an
+ * aligned buffer on first access only.
  */
 char *
 XLogRecGetBlockData(XLogReaderState *record, uint8 block_id, Size *len)
@@ -1405,6 +1428,25 @@ XLogRecGetBlockData(XLogReaderState *record, uint8 block_id, Size *len)
 	}
 	else
 	{
+		if (bkpb->data_src != NULL)
+		{
+			if (!bkpb->data || bkpb->data_len > bkpb->data_bufsz)
+			{
+				if (bkpb->data)
+					pfree(bkpb->data);
+
+				/*
+				 * Force the initial request to be BLCKSZ so that we don't
+				 * waste time with lots of trips through this stanza as a
+				 * result of WAL compression.
+				 */
+				bkpb->data_bufsz = MAXALIGN(Max(bkpb->data_len, BLCKSZ));
+				bkpb->data = palloc(bkpb->data_bufsz);
+			}
+			memcpy(bkpb->data, bkpb->data_src, bkpb->data_len);
+			bkpb->data_src = NULL;
+		}
+
 		if (len)
 			*len = bkpb->data_len;
 		return bkpb->data;
@@ -1431,11 +1473,49 @@ RestoreBlockImage(XLogReaderState *record, uint8 block_id, char *page)
 	bkpb = &record->blocks[block_id];
 	ptr = bkpb->bkp_image;
 
-	if (bkpb->bimg_info & BKPIMAGE_IS_COMPRESSED)
+	if (BKPIMAGE_COMPRESSED(bkpb->bimg_info))
 	{
 		/* If a backup block image is compressed, decompress it */
-		if (pglz_decompress(ptr, bkpb->bimg_len, tmp.data,
-							BLCKSZ - bkpb->hole_length, true) < 0)
+		bool		decomp_success = true;
+
+		if (bkpb->bimg_info & BKPIMAGE_COMPRESS_PGLZ)
+		{
+			if (pglz_decompress(ptr, bkpb->bimg_len, tmp.data,
+								BLCKSZ - bkpb->hole_length, true) < 0)
+				decomp_success = false;
+		}
+		else if (bkpb->bimg_info & BKPIMAGE_COMPRESS_LZ4)
+		{
+#ifdef USE_LZ4
+			if (LZ4_decompress_safe(ptr, tmp.data,
+									bkpb->bimg_len, BLCKSZ) <= 0)
+				decomp_success = false;
+#else
+			report_invalid_record(record, "image at %X/%X compressed with LZ4 not supported by build, block %d",
+								  (uint32) (record->ReadRecPtr >> 32),
+								  (uint32) record->ReadRecPtr,
+								  block_id);
+			return false;
+#endif
+		}
+		else if (bkpb->bimg_info & BKPIMAGE_COMPRESS_ZSTD)
+		{
+#ifdef USE_ZSTD
+			size_t		decomp_result = ZSTD_decompress(tmp.data, BLCKSZ, ptr,
+														bkpb->bimg_len);
+
+			if (ZSTD_isError(decomp_result))
+				decomp_success = false;
+#else
+			report_invalid_record(record, "image at %X/%X compressed with zstd not supported by build, block %d",
+								  (uint32) (record->ReadRecPtr >> 32),
+								  (uint32) record->ReadRecPtr,
+								  block_id);
+			return false;
+#endif
+		}
+
+		if (!decomp_success)
 		{
 			report_invalid_record(record, "invalid compressed image at %X/%X, block %d",
 								  (uint32) (record->ReadRecPtr >> 32),
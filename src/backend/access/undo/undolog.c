@@ -34,23 +34,61 @@
 #include "catalog/pg_class.h"
 #include "catalog/pg_tablespace_d.h"
 #include "commands/tablespace.h"
+#include "common/pg_lzcompress.h"
 #include "funcapi.h"
 #include "lib/qunique.h"
 #include "miscadmin.h"
+#include "pgstat.h"
+#include "port/atomics.h"
+#include "storage/proc.h"
 #include "storage/procarray.h"
 #include "storage/undofile.h"
 #include "utils/builtins.h"
 #include "utils/guc.h"
 #include "utils/varlena.h"
 
+/*
+ * Upper limit on the number of free-list stripes per persistence level.  The
+ * actual number scales with max_connections, unless overridden with the
+ * undo_freelist_stripes GUC; see choose_freelist_stripes().
+ */
+#define UndoLogMaxFreeListStripes 32
+
+/*
+ * Activity counters for the undo subsystem, one per member of
+ * UndoLogStatsData.  They are bumped with atomic adds rather than under any
+ * of the undo locks, because several of the interesting events happen on the
+ * insertion fast path.
+ */
+typedef struct UndoLogSharedStats
+{
+	pg_atomic_uint64 records_inserted;
+	pg_atomic_uint64 bytes_inserted;
+	pg_atomic_uint64 bytes_discarded;
+	pg_atomic_uint64 segments_created;
+	pg_atomic_uint64 spare_segments_claimed;
+	pg_atomic_uint64 segments_recycled;
+	pg_atomic_uint64 buffers_reclaimed;
+	pg_atomic_uint64 reclaim_passes;
+} UndoLogSharedStats;
+
 /*
  * Main control structure for undo log management in shared memory.
  * UndoLogSlot objects are arranged in a fixed-size array, with no particular
  * ordering.
+ *
+ * The shared free lists are striped, with each backend hashing onto a home
+ * stripe, so that concurrent writers tend to attach to disjoint undo logs
+ * without fighting over a single lock or appending to each other's logs.
+ * Each stripe has its own lock; UndoLogLock continues to protect slot
+ * allocation and freeing, low_logno and next_logno.
  */
 typedef struct UndoLogSharedData
 {
-	slist_head		free_lists[3];	/* one per persistence level */
+	UndoLogSharedStats stats;
+	int				nfreelist_stripes;
+	LWLock			free_list_locks[UndoLogMaxFreeListStripes];
+	slist_head		free_lists[3][UndoLogMaxFreeListStripes];
 	UndoLogNumber	low_logno;
 	UndoLogNumber	next_logno;
 	UndoLogNumber	nslots;
@@ -68,6 +106,9 @@ UndoLogNumber undologtable_low_logno;
 
 /* GUC variables */
 char	   *undo_tablespaces = NULL;
+int			undo_prealloc_segments = 2;
+int			undo_freelist_stripes = 0;
+bool		undo_compress_segments = false;
 
 static UndoLogSlot *allocate_undo_log_slot(void);
 static void free_undo_log_slot(UndoLogSlot *log);
@@ -75,6 +116,17 @@ static void discard_undo_buffers(int logno, UndoLogOffset old_discard,
 								 UndoLogOffset new_discard,
 								 bool drop_tail);
 static void scan_physical_range(void);
+static void spare_undo_segment_path(Oid tablespace, int n, char *path);
+static bool claim_spare_undo_segment(Oid tablespace, const char *path);
+static void compress_undo_segment(UndoLogSlot *slot, UndoLogNumber logno,
+								  Oid tablespace, int segno);
+
+/*
+ * Name of pre-zeroed spare segment files maintained by the undo launcher.
+ * The prefix must not be parseable as a segment file name, so that
+ * scan_physical_range() and friends can tell the two kinds of file apart.
+ */
+#define UndoLogSparePrefix		"spare."
 
 /*
  * How many undo logs can be active at a time?  This creates a theoretical
@@ -89,6 +141,29 @@ UndoLogNumSlots(void)
 	return MaxBackends * 4;
 }
 
+/*
+ * How many free-list stripes to use per persistence level.  One stripe per
+ * 16 backends keeps the lists short without wasting undo logs on small
+ * systems; undo_freelist_stripes overrides the automatic choice.
+ */
+static int
+choose_freelist_stripes(void)
+{
+	if (undo_freelist_stripes > 0)
+		return Min(undo_freelist_stripes, UndoLogMaxFreeListStripes);
+
+	return Max(1, Min(MaxBackends / 16, UndoLogMaxFreeListStripes));
+}
+
+/*
+ * The stripe that this backend's undo logs call home.
+ */
+static inline int
+UndoLogMyFreeListStripe(void)
+{
+	return MyProc->pgprocno % UndoLogShared->nfreelist_stripes;
+}
+
 /*
  * Return the amount of traditional shmem required for undo log management.
  */
@@ -120,9 +195,22 @@ UndoLogShmemInit(void)
 		 * the undo logs that were known at the last checkpoint.
 		 */
 		memset(UndoLogShared, 0, sizeof(*UndoLogShared));
+		pg_atomic_init_u64(&UndoLogShared->stats.records_inserted, 0);
+		pg_atomic_init_u64(&UndoLogShared->stats.bytes_inserted, 0);
+		pg_atomic_init_u64(&UndoLogShared->stats.bytes_discarded, 0);
+		pg_atomic_init_u64(&UndoLogShared->stats.segments_created, 0);
+		pg_atomic_init_u64(&UndoLogShared->stats.spare_segments_claimed, 0);
+		pg_atomic_init_u64(&UndoLogShared->stats.segments_recycled, 0);
+		pg_atomic_init_u64(&UndoLogShared->stats.buffers_reclaimed, 0);
+		pg_atomic_init_u64(&UndoLogShared->stats.reclaim_passes, 0);
 		UndoLogShared->nslots = UndoLogNumSlots();
+		UndoLogShared->nfreelist_stripes = choose_freelist_stripes();
+		for (int i = 0; i < UndoLogShared->nfreelist_stripes; ++i)
+			LWLockInitialize(&UndoLogShared->free_list_locks[i],
+							 LWTRANCHE_UNDO_FREELIST);
 		for (int i = 0; i < NUndoPersistenceLevels; ++i)
-			slist_init(&UndoLogShared->free_lists[i]);
+			for (int j = 0; j < UndoLogShared->nfreelist_stripes; ++j)
+				slist_init(&UndoLogShared->free_lists[i][j]);
 		for (int i = 0; i < UndoLogShared->nslots; ++i)
 		{
 			memset(&UndoLogShared->slots[i], 0, sizeof(UndoLogShared->slots[i]));
@@ -156,6 +244,43 @@ UndoLogShmemInit(void)
 	LWLockRelease(UndoLogLock);
 }
 
+/*
+ * Count undo records written into shared buffers.  Called by the undo record
+ * set code once per insertion, which may cover multiple records.
+ */
+void
+UndoLogCountInsertion(size_t bytes, int nrecords)
+{
+	pg_atomic_fetch_add_u64(&UndoLogShared->stats.records_inserted, nrecords);
+	pg_atomic_fetch_add_u64(&UndoLogShared->stats.bytes_inserted, bytes);
+}
+
+/*
+ * Copy the current values of the undo activity counters into *stats.  The
+ * counters are read individually, so the result is not an atomic snapshot,
+ * which is fine for monitoring purposes.
+ */
+void
+UndoLogGetStats(UndoLogStatsData *stats)
+{
+	stats->records_inserted =
+		pg_atomic_read_u64(&UndoLogShared->stats.records_inserted);
+	stats->bytes_inserted =
+		pg_atomic_read_u64(&UndoLogShared->stats.bytes_inserted);
+	stats->bytes_discarded =
+		pg_atomic_read_u64(&UndoLogShared->stats.bytes_discarded);
+	stats->segments_created =
+		pg_atomic_read_u64(&UndoLogShared->stats.segments_created);
+	stats->spare_segments_claimed =
+		pg_atomic_read_u64(&UndoLogShared->stats.spare_segments_claimed);
+	stats->segments_recycled =
+		pg_atomic_read_u64(&UndoLogShared->stats.segments_recycled);
+	stats->buffers_reclaimed =
+		pg_atomic_read_u64(&UndoLogShared->stats.buffers_reclaimed);
+	stats->reclaim_passes =
+		pg_atomic_read_u64(&UndoLogShared->stats.reclaim_passes);
+}
+
 /*
  * Figure out which directory holds an undo log based on tablespace.
  */
@@ -263,6 +388,7 @@ void
 AtProcExit_UndoLog(void)
 {
 	int		i;
+	int		stripe;
 
 	if (!CurrentSession)
 		return;
@@ -281,10 +407,12 @@ AtProcExit_UndoLog(void)
 			slot->xid = InvalidTransactionId;
 			LWLockRelease(&slot->meta_lock);
 
-			LWLockAcquire(UndoLogLock, LW_EXCLUSIVE);
-			slist_push_head(&UndoLogShared->free_lists[GetUndoPersistenceLevel(slot->meta.persistence)],
+			stripe = UndoLogMyFreeListStripe();
+			LWLockAcquire(&UndoLogShared->free_list_locks[stripe],
+						  LW_EXCLUSIVE);
+			slist_push_head(&UndoLogShared->free_lists[GetUndoPersistenceLevel(slot->meta.persistence)][stripe],
 							&slot->next);
-			LWLockRelease(UndoLogLock);
+			LWLockRelease(&UndoLogShared->free_list_locks[stripe]);
 		}
 	}
 }
@@ -301,10 +429,26 @@ allocate_empty_undo_segment(UndoLogNumber logno, Oid tablespace,
 	char	path[MAXPGPATH];
 	void   *zeroes;
 	size_t	nzeroes = 8192;
+	bool	is_temp;
 	int		fd;
 
+	is_temp = UndoLogNumberGetPersistence(logno) == RELPERSISTENCE_TEMP;
+
 	UndoLogSegmentPath(logno, end / UndoLogSegmentSize, tablespace, path);
 
+	/*
+	 * First preference: grab a pre-zeroed, pre-fsynced segment from the spare
+	 * pool maintained by the undo launcher, turning a 1MB write+fsync on the
+	 * insertion path into a rename.  Temporary undo logs don't bother: they
+	 * don't need the durability the spares were prepared for, and shouldn't
+	 * deplete the pool that permanent logs rely on.
+	 */
+	if (!is_temp && claim_spare_undo_segment(tablespace, path))
+	{
+		pg_atomic_fetch_add_u64(&UndoLogShared->stats.spare_segments_claimed, 1);
+		return;
+	}
+
 	/*
 	 * Create and fully allocate a new file.  If we crashed and recovered
 	 * then the file might already exist, so use flags that tolerate that.
@@ -382,9 +526,32 @@ allocate_empty_undo_segment(UndoLogNumber logno, Oid tablespace,
 				 errmsg("could not fstat \"%s\": %m", path)));
 	size = stat_buffer.st_size;
 
+	/*
+	 * Temporary undo logs need none of the work below.  Their contents never
+	 * survive a crash or a clean shutdown, only the owning backend can read
+	 * them, and in the common case the data lives and dies in backend-local
+	 * buffers without ever being written out.  Just make a sparse file of
+	 * the right logical size, so that local buffer eviction has somewhere to
+	 * spill pages if the undo data outgrows temp_buffers; unwritten ranges
+	 * read back as zeroes, the same as an explicitly zero-filled file.
+	 */
+	if (is_temp)
+	{
+		if (size < UndoLogSegmentSize &&
+			ftruncate(fd, UndoLogSegmentSize) < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not initialize file \"%s\": %m", path)));
+		CloseTransientFile(fd);
+		pg_atomic_fetch_add_u64(&UndoLogShared->stats.segments_created, 1);
+		elog(DEBUG1, "created sparse temporary undo segment \"%s\"", path);
+		return;
+	}
+
 	/* A buffer full of zeroes we'll use to fill up new segment files. */
 	zeroes = palloc0(nzeroes);
 
+	pgstat_report_wait_start(WAIT_EVENT_UNDO_SEGMENT_INIT);
 	while (size < UndoLogSegmentSize)
 	{
 		ssize_t written;
@@ -396,6 +563,7 @@ allocate_empty_undo_segment(UndoLogNumber logno, Oid tablespace,
 					 errmsg("could not initialize file \"%s\": %m", path)));
 		size += written;
 	}
+	pgstat_report_wait_end();
 
 	/*
 	 * Ask the checkpointer to flush the contents of the file to disk before
@@ -407,9 +575,155 @@ allocate_empty_undo_segment(UndoLogNumber logno, Oid tablespace,
 
 	pfree(zeroes);
 
+	pg_atomic_fetch_add_u64(&UndoLogShared->stats.segments_created, 1);
+
 	elog(DEBUG1, "created undo segment \"%s\"", path);
 }
 
+/*
+ * Compute the path of a spare segment file in a tablespace's undo directory.
+ */
+static void
+spare_undo_segment_path(Oid tablespace, int n, char *path)
+{
+	char		dir[MAXPGPATH];
+
+	UndoLogDirectory(tablespace, dir);
+	snprintf(path, MAXPGPATH, "%s/%s%02d", dir, UndoLogSparePrefix, n);
+}
+
+/*
+ * Try to claim a spare segment by renaming it into place as 'path'.
+ * Returns true on success.
+ *
+ * Any backend may try to claim any spare, so we just probe each candidate
+ * name; rename() is atomic, so if several backends go for the same spare,
+ * exactly one wins and the others see ENOENT and move on.  The spare's
+ * contents were fsynced when it was created, and durable_rename() takes
+ * care of making the rename itself survive a crash, so unlike the
+ * create-from-scratch path we don't need to ask the checkpointer to sync
+ * anything.
+ */
+static bool
+claim_spare_undo_segment(Oid tablespace, const char *path)
+{
+	int			n;
+
+	for (n = 0; n < undo_prealloc_segments; ++n)
+	{
+		char		spare_path[MAXPGPATH];
+
+		spare_undo_segment_path(tablespace, n, spare_path);
+		if (durable_rename(spare_path, path, DEBUG1) == 0)
+		{
+			elog(DEBUG1, "claimed spare undo segment \"%s\" -> \"%s\"",
+				 spare_path, path);
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Top up the pool of spare segments in every tablespace that holds an active
+ * undo log.  This is called periodically by the undo launcher, so that
+ * foreground transactions extending an undo log can usually claim a
+ * ready-made segment instead of zero-filling and fsyncing one themselves.
+ */
+void
+UndoLogMaintainSpareSegments(void)
+{
+	Oid		   *tablespaces;
+	int			ntablespaces = 0;
+	UndoLogSlot *slot = NULL;
+
+	if (undo_prealloc_segments <= 0)
+		return;
+
+	/* Compute the unique set of tablespaces containing active undo logs. */
+	tablespaces = palloc0((UndoLogNumSlots() + 1) * sizeof(Oid));
+	tablespaces[ntablespaces++] = DEFAULTTABLESPACE_OID;
+	while ((slot = UndoLogGetNextSlot(slot)))
+		tablespaces[ntablespaces++] = slot->meta.tablespace;
+	qsort(tablespaces, ntablespaces, sizeof(Oid), oid_cmp);
+	ntablespaces = qunique(tablespaces, ntablespaces, sizeof(Oid), oid_cmp);
+
+	for (int i = 0; i < ntablespaces; ++i)
+	{
+		for (int n = 0; n < undo_prealloc_segments; ++n)
+		{
+			char		path[MAXPGPATH];
+			char		tmp_path[MAXPGPATH];
+			struct stat	stat_buffer;
+			off_t		size = 0;
+			void	   *zeroes;
+			size_t		nzeroes = 8192;
+			int			fd;
+
+			CHECK_FOR_INTERRUPTS();
+
+			/* Is this spare already present? */
+			spare_undo_segment_path(tablespaces[i], n, path);
+			if (stat(path, &stat_buffer) == 0)
+				continue;
+
+			/*
+			 * Build the new spare under a temporary name, and move it into
+			 * place only once its contents are durable, so that claimants
+			 * never have to fsync the data.  Only the launcher creates
+			 * spares, so we don't have to worry about colliding with another
+			 * creator of the temporary file.
+			 */
+			snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+			fd = OpenTransientFile(tmp_path,
+								   O_RDWR | O_CREAT | O_TRUNC | PG_BINARY);
+			if (fd < 0)
+			{
+				/*
+				 * The undo directory for the tablespace may simply not exist
+				 * yet; it's not this function's job to create it.  Just skip.
+				 */
+				elog(DEBUG1, "could not create spare undo segment \"%s\": %m",
+					 tmp_path);
+				continue;
+			}
+
+			zeroes = palloc0(nzeroes);
+			pgstat_report_wait_start(WAIT_EVENT_UNDO_SEGMENT_INIT);
+			while (size < UndoLogSegmentSize)
+			{
+				ssize_t		written;
+
+				written = write(fd, zeroes,
+								Min(nzeroes, UndoLogSegmentSize - size));
+				if (written < 0)
+					ereport(ERROR,
+							(errcode_for_file_access(),
+							 errmsg("could not initialize file \"%s\": %m",
+									tmp_path)));
+				size += written;
+			}
+			pgstat_report_wait_end();
+			pfree(zeroes);
+
+			pgstat_report_wait_start(WAIT_EVENT_UNDO_FILE_SYNC);
+			if (pg_fsync(fd) != 0)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not fsync file \"%s\": %m", tmp_path)));
+			pgstat_report_wait_end();
+			CloseTransientFile(fd);
+
+			durable_rename(tmp_path, path, ERROR);
+			pg_atomic_fetch_add_u64(&UndoLogShared->stats.segments_created, 1);
+			elog(DEBUG1, "created spare undo segment \"%s\"", path);
+		}
+	}
+
+	pfree(tablespaces);
+}
+
 /*
  * Create a new undo segment, when it is unexpectedly not present.
  */
@@ -484,13 +798,34 @@ scan_physical_range(void)
 			int offset_high;
 			int offset_low;
 			UndoLogSlot *slot;
+			char name[MAXPGPATH];
+			size_t len;
 
 			if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
 				continue;
 
+			/* Spare segments maintained by the undo launcher aren't ours. */
+			if (strncmp(de->d_name, UndoLogSparePrefix,
+						strlen(UndoLogSparePrefix)) == 0)
+				continue;
+
+			/*
+			 * A compressed segment covers the same range of the address
+			 * space as the segment itself; strip the suffix and treat it
+			 * like one, so that we don't zero-fill over it later.
+			 */
+			strlcpy(name, de->d_name, sizeof(name));
+			len = strlen(name);
+			if (len == 17 + strlen(UndoLogSegmentCompressSuffix) &&
+				strcmp(name + 17, UndoLogSegmentCompressSuffix) == 0)
+			{
+				name[17] = '\0';
+				len = 17;
+			}
+
 			/* Can we parse the name as a segment file name? */
-			if (strlen(de->d_name) != 17 ||
-				sscanf(de->d_name, "%06X.%02X%08X", &logno, &offset_high, &offset_low) != 3)
+			if (len != 17 ||
+				sscanf(name, "%06X.%02X%08X", &logno, &offset_high, &offset_low) != 3)
 			{
 				elog(LOG, "unexpected file \"%s\" in \"%s\"", de->d_name, tablespace_path);
 				continue;
@@ -598,6 +933,7 @@ UndoLogAdjustPhysicalRange(UndoLogNumber logno,
 			 begin += UndoLogSegmentSize)
 		{
 			char old_path[MAXPGPATH];
+			char compressed_path[MAXPGPATH];
 
 			/* Tell the checkpointer that the file is going away. */
 			undofile_forget_sync(logno, begin / UndoLogSegmentSize,
@@ -606,6 +942,22 @@ UndoLogAdjustPhysicalRange(UndoLogNumber logno,
 			UndoLogSegmentPath(logno, begin / UndoLogSegmentSize,
 							   slot->meta.tablespace, old_path);
 
+			/*
+			 * If a compressed copy of this segment exists, it is behind the
+			 * discard horizon too.  Tolerate ENOENT: most segments were
+			 * never compressed.
+			 */
+			snprintf(compressed_path, sizeof(compressed_path), "%s%s",
+					 old_path, UndoLogSegmentCompressSuffix);
+			if (unlink(compressed_path) == 0)
+				elog(DEBUG1, "unlinked compressed undo segment \"%s\"",
+					 compressed_path);
+			else if (errno != ENOENT)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not unlink \"%s\": %m",
+								compressed_path)));
+
 			/*
 			 * Rename or unlink as required.  Tolerate ENOENT, because some
 			 * crash scenarios could leave holes in the sequence of segment
@@ -620,6 +972,7 @@ UndoLogAdjustPhysicalRange(UndoLogNumber logno,
 
 				if (rename(old_path, new_path) == 0)
 				{
+					pg_atomic_fetch_add_u64(&UndoLogShared->stats.segments_recycled, 1);
 					elog(DEBUG1, "recycled undo segment \"%s\" -> \"%s\"",
 						 old_path, new_path);
 					--recycle;
@@ -680,6 +1033,7 @@ UndoLogGetForPersistence(char persistence)
 	xl_undolog_create xlrec;
 	UndoPersistenceLevel plevel = GetUndoPersistenceLevel(persistence);
 	Oid			tablespace = DEFAULTTABLESPACE_OID;
+	int			stripe;
 
 	/* Is there one on our private free list of attached undo logs? */
 	slist = &CurrentSession->sticky_undo_log_slots[plevel];
@@ -697,27 +1051,41 @@ UndoLogGetForPersistence(char persistence)
 	 */
 	tablespace = DEFAULTTABLESPACE_OID;
 
-	/* Is there one on the shared freelist? */
-	LWLockAcquire(UndoLogLock, LW_EXCLUSIVE);
-	slist_foreach_modify(iter, &UndoLogShared->free_lists[plevel])
+	/*
+	 * Is there one on the shared freelist?  Start with our own stripe, so
+	 * that concurrent backends tend to grab disjoint undo logs without lock
+	 * contention, falling back to stealing from other stripes only when
+	 * ours is empty.
+	 */
+	stripe = UndoLogMyFreeListStripe();
+	for (int n = 0; n < UndoLogShared->nfreelist_stripes; ++n)
 	{
-		slot = slist_container(UndoLogSlot, next, iter.cur);
-		if (slot->meta.persistence == persistence &&
-			slot->meta.tablespace == tablespace)
+		LWLock	   *lock = &UndoLogShared->free_list_locks[stripe];
+
+		LWLockAcquire(lock, LW_EXCLUSIVE);
+		slist_foreach_modify(iter, &UndoLogShared->free_lists[plevel][stripe])
 		{
-			slist_delete_current(&iter);
-			LWLockRelease(UndoLogLock);
+			slot = slist_container(UndoLogSlot, next, iter.cur);
+			if (slot->meta.persistence == persistence &&
+				slot->meta.tablespace == tablespace)
+			{
+				slist_delete_current(&iter);
+				LWLockRelease(lock);
 
-			LWLockAcquire(&slot->meta_lock, LW_EXCLUSIVE);
-			slot->pid = MyProcPid;
-			slot->xid = GetTopTransactionIdIfAny();
-			LWLockRelease(&slot->meta_lock);
+				LWLockAcquire(&slot->meta_lock, LW_EXCLUSIVE);
+				slot->pid = MyProcPid;
+				slot->xid = GetTopTransactionIdIfAny();
+				LWLockRelease(&slot->meta_lock);
 
-			return slot;
+				return slot;
+			}
 		}
+		LWLockRelease(lock);
+		stripe = (stripe + 1) % UndoLogShared->nfreelist_stripes;
 	}
 
 	/* We'll have to make a new one. */
+	LWLockAcquire(UndoLogLock, LW_EXCLUSIVE);
 	if (unlikely(UndoLogShared->next_logno > MaxUndoLogNumber))
 	{
 		/*
@@ -739,6 +1107,8 @@ UndoLogGetForPersistence(char persistence)
 	slot->logno = UndoLogShared->next_logno;
 	slot->meta.insert = SizeOfUndoPageHeaderData;
 	slot->meta.discard = SizeOfUndoPageHeaderData;
+	slot->reclaim = SizeOfUndoPageHeaderData;
+	slot->discard_lsn = InvalidXLogRecPtr;
 	slot->meta.logno = UndoLogShared->next_logno;
 	slot->meta.tablespace = tablespace;
 	slot->meta.persistence = persistence;
@@ -784,14 +1154,17 @@ UndoLogPut(UndoLogSlot *slot)
 						&slot->next);
 	else
 	{
+		int		stripe = UndoLogMyFreeListStripe();
+
 		LWLockAcquire(&slot->meta_lock, LW_EXCLUSIVE);
 		slot->pid = InvalidPid;
 		slot->xid = InvalidTransactionId;
 		LWLockRelease(&slot->meta_lock);
 
-		LWLockAcquire(UndoLogLock, LW_EXCLUSIVE);
-		slist_push_head(&UndoLogShared->free_lists[plevel], &slot->next);
-		LWLockRelease(UndoLogLock);
+		LWLockAcquire(&UndoLogShared->free_list_locks[stripe], LW_EXCLUSIVE);
+		slist_push_head(&UndoLogShared->free_lists[plevel][stripe],
+						&slot->next);
+		LWLockRelease(&UndoLogShared->free_list_locks[stripe]);
 	}
 }
 
@@ -834,6 +1207,7 @@ UndoDiscard(UndoRecPtr discard_point)
 	UndoLogOffset begin;
 	UndoLogOffset insert;
 	UndoLogOffset old_discard;
+	UndoLogOffset reclaim;
 	UndoLogSlot *slot;
 	bool		entirely_discarded;
 	XLogRecPtr	recptr = InvalidXLogRecPtr;
@@ -858,6 +1232,7 @@ UndoDiscard(UndoRecPtr discard_point)
 	old_discard = slot->meta.discard;
 	insert = slot->meta.insert;
 	begin = slot->begin;
+	reclaim = slot->reclaim;
 	entirely_discarded = insert == slot->meta.size;
 	LWLockRelease(&slot->meta_lock);
 
@@ -906,9 +1281,32 @@ UndoDiscard(UndoRecPtr discard_point)
 	 */
 	LWLockAcquire(&slot->meta_lock, LW_EXCLUSIVE);
 	if (likely(slot->logno == logno))
+	{
 		slot->meta.discard = new_discard;
+		if (!XLogRecPtrIsInvalid(recptr))
+			slot->discard_lsn = recptr;
+	}
 	LWLockRelease(&slot->meta_lock);
 
+	if (new_discard > old_discard)
+		pg_atomic_fetch_add_u64(&UndoLogShared->stats.bytes_discarded,
+								new_discard - old_discard);
+
+	/*
+	 * In normal running, that's all: invalidating buffers and unlinking
+	 * segment files can be a lot of work, so it is left to the undo
+	 * launcher, which periodically reclaims everything between 'reclaim' and
+	 * 'discard' in batches; see UndoLogBackgroundReclaim().  Stale buffers
+	 * left behind in the meantime are harmless, because undofile_read()
+	 * already refuses to read the discarded range, and the files they'd be
+	 * written back to can't be unlinked before the buffers are gone.
+	 *
+	 * In recovery and single-user mode there is no launcher, so do the work
+	 * synchronously as part of this call.
+	 */
+	if (!InRecovery && IsUnderPostmaster)
+		return;
+
 	/*
 	 * Try to invalidate all existing buffers in the discarded range.  Any
 	 * that can't be invalidated because they are currently pinned will remain
@@ -916,7 +1314,22 @@ UndoDiscard(UndoRecPtr discard_point)
 	 * written back again after this point, so it's safe to unlink the
 	 * underlying files after this point.
 	 */
-	discard_undo_buffers(logno, old_discard, new_discard, entirely_discarded);
+	discard_undo_buffers(logno, Min(reclaim, old_discard), new_discard,
+						 entirely_discarded);
+
+	LWLockAcquire(&slot->meta_lock, LW_EXCLUSIVE);
+	if (likely(slot->logno == logno))
+	{
+		/*
+		 * If we dropped the buffer holding new_discard too, remember that by
+		 * advancing 'reclaim' to the end of that block.
+		 */
+		if (entirely_discarded)
+			slot->reclaim = (new_discard / BLCKSZ + 1) * BLCKSZ;
+		else
+			slot->reclaim = new_discard;
+	}
+	LWLockRelease(&slot->meta_lock);
 
 	/*
 	 * Have we crossed a segment file boundary?  If so, we'll need to do some
@@ -940,6 +1353,465 @@ UndoDiscard(UndoRecPtr discard_point)
 	}
 }
 
+/*
+ * Background stage of undo log discarding, run in the undo launcher.
+ *
+ * UndoDiscard() only advances the discard pointer, which is enough to make
+ * the discarded range unreachable.  Here we catch up with the expensive part
+ * for all undo logs in one pass: invalidate any buffers that still hold
+ * discarded data, and then unlink or recycle whole segment files that have
+ * fallen behind the discard horizon.
+ */
+void
+UndoLogBackgroundReclaim(void)
+{
+	UndoLogSlot *slot = NULL;
+
+	pg_atomic_fetch_add_u64(&UndoLogShared->stats.reclaim_passes, 1);
+
+	while ((slot = UndoLogGetNextSlot(slot)))
+	{
+		UndoLogNumber logno;
+		UndoLogOffset begin;
+		UndoLogOffset discard;
+		UndoLogOffset reclaim;
+		UndoLogOffset target;
+		XLogRecPtr	discard_lsn;
+		bool		entirely_discarded;
+
+		LWLockAcquire(&slot->meta_lock, LW_SHARED);
+		logno = slot->logno;
+		begin = slot->begin;
+		discard = slot->meta.discard;
+		reclaim = slot->reclaim;
+		discard_lsn = slot->discard_lsn;
+		entirely_discarded = slot->meta.insert == slot->meta.size &&
+			slot->meta.discard == slot->meta.size;
+		LWLockRelease(&slot->meta_lock);
+
+		/*
+		 * Invalidate buffers the fast discard stage left behind.  Once a
+		 * log is entirely discarded we also drop the buffer holding the
+		 * discard pointer itself, which is otherwise kept because it may
+		 * contain live data; 'reclaim' then points past it, so that the
+		 * slot can be freed at the next checkpoint.
+		 */
+		if (entirely_discarded)
+			target = (discard / BLCKSZ + 1) * BLCKSZ;
+		else
+			target = discard;
+		if (reclaim < target)
+		{
+			discard_undo_buffers(logno, reclaim, discard, entirely_discarded);
+			pg_atomic_fetch_add_u64(&UndoLogShared->stats.buffers_reclaimed,
+									target / BLCKSZ - reclaim / BLCKSZ);
+
+			LWLockAcquire(&slot->meta_lock, LW_EXCLUSIVE);
+			if (likely(slot->logno == logno))
+				slot->reclaim = target;
+			LWLockRelease(&slot->meta_lock);
+		}
+
+		/*
+		 * Unlink or recycle segment files that lie entirely behind the
+		 * discard pointer.  The WAL record covering the discard must reach
+		 * disk first, so that the discard pointer can't point into a
+		 * missing file after crash recovery.
+		 */
+		if (discard / UndoLogSegmentSize > begin / UndoLogSegmentSize)
+		{
+			if (!XLogRecPtrIsInvalid(discard_lsn))
+				XLogFlush(discard_lsn);
+			UndoLogAdjustPhysicalRange(logno, discard, 0);
+		}
+	}
+}
+
+/*
+ * Compress one closed undo segment file, replacing "<segment>" with
+ * "<segment>" UndoLogSegmentCompressSuffix.  Called only from
+ * UndoLogCompressSegments(), which has established that the segment's
+ * contents can no longer change.
+ */
+static void
+compress_undo_segment(UndoLogSlot *slot, UndoLogNumber logno, Oid tablespace,
+					  int segno)
+{
+	UndoLogCompressedSegmentHeader header;
+	char		path[MAXPGPATH];
+	char		compressed_path[MAXPGPATH];
+	char		tmp_path[MAXPGPATH];
+	RelFileNode rnode;
+	char	   *raw;
+	char	   *compressed;
+	int32		compressed_size;
+	off_t		done;
+	int			fd;
+
+	UndoLogSegmentPath(logno, segno, tablespace, path);
+	snprintf(compressed_path, sizeof(compressed_path), "%s%s",
+			 path, UndoLogSegmentCompressSuffix);
+
+	/*
+	 * Hold the file lock so that the segment file can't be renamed, unlinked
+	 * or uncompressed underneath us; see UndoLogAdjustPhysicalRange().
+	 */
+	LWLockAcquire(&slot->file_lock, LW_EXCLUSIVE);
+	if (slot->logno != logno)
+	{
+		/* The undo log was entirely discarded and the slot recycled. */
+		LWLockRelease(&slot->file_lock);
+		return;
+	}
+
+	fd = OpenTransientFile(path, O_RDONLY | PG_BINARY);
+	if (fd < 0)
+	{
+		/* Already compressed, or a hole left behind by a crash. */
+		LWLockRelease(&slot->file_lock);
+		return;
+	}
+
+	/*
+	 * Write back any dirty buffers for this segment, so that the file
+	 * contents we are about to read are current.  No new modifications can
+	 * arrive while we hold the file lock, because the caller established
+	 * that every chunk covering this segment has been closed.
+	 */
+	UndoRecPtrAssignRelFileNode(rnode, MakeUndoRecPtr(logno, 0));
+	for (int block = segno * UNDOSEG_SIZE;
+		 block < (segno + 1) * UNDOSEG_SIZE;
+		 ++block)
+		FlushBufferIfPresent(rnode, UndoLogForkNum, block);
+
+	raw = palloc(UndoLogSegmentSize);
+	done = 0;
+	pgstat_report_wait_start(WAIT_EVENT_UNDO_FILE_READ);
+	while (done < UndoLogSegmentSize)
+	{
+		ssize_t		nread;
+
+		nread = read(fd, raw + done, UndoLogSegmentSize - done);
+		if (nread < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read file \"%s\": %m", path)));
+		if (nread == 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("unexpected EOF in file \"%s\"", path)));
+		done += nread;
+	}
+	pgstat_report_wait_end();
+	CloseTransientFile(fd);
+
+	compressed = palloc(PGLZ_MAX_OUTPUT(UndoLogSegmentSize));
+	compressed_size = pglz_compress(raw, UndoLogSegmentSize, compressed,
+									PGLZ_strategy_always);
+	pfree(raw);
+	if (compressed_size < 0)
+	{
+		/* Incompressible; leave the segment alone. */
+		pfree(compressed);
+		LWLockRelease(&slot->file_lock);
+		return;
+	}
+
+	/*
+	 * Write the compressed copy under a temporary name, and move it into
+	 * place only once its contents are durable.  If we crash before
+	 * unlinking the original, both files exist with identical contents and
+	 * the original wins; the stale compressed copy is removed when the
+	 * segment is eventually discarded or uncompressed.
+	 */
+	snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", compressed_path);
+	fd = OpenTransientFile(tmp_path, O_RDWR | O_CREAT | O_TRUNC | PG_BINARY);
+	if (fd < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not create file \"%s\": %m", tmp_path)));
+	header.magic = UNDO_COMPRESSED_SEGMENT_MAGIC;
+	header.rawsize = UndoLogSegmentSize;
+	pgstat_report_wait_start(WAIT_EVENT_UNDO_FILE_WRITE);
+	errno = 0;
+	if (write(fd, &header, sizeof(header)) != sizeof(header) ||
+		write(fd, compressed, compressed_size) != compressed_size)
+	{
+		/* if write didn't set errno, assume problem is no disk space */
+		if (errno == 0)
+			errno = ENOSPC;
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to file \"%s\": %m", tmp_path)));
+	}
+	pgstat_report_wait_end();
+	pfree(compressed);
+
+	pgstat_report_wait_start(WAIT_EVENT_UNDO_FILE_SYNC);
+	if (pg_fsync(fd) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not fsync file \"%s\": %m", tmp_path)));
+	pgstat_report_wait_end();
+	CloseTransientFile(fd);
+
+	durable_rename(tmp_path, compressed_path, ERROR);
+
+	/*
+	 * The checkpointer has nothing left to do for this file: the compressed
+	 * copy is already durable, and the original is about to go away.
+	 */
+	undofile_forget_sync(logno, segno, tablespace);
+
+	if (unlink(path) < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not unlink \"%s\": %m", path)));
+
+	elog(DEBUG1, "compressed undo segment \"%s\" (%d of %zu bytes)",
+		 path, compressed_size, UndoLogSegmentSize);
+
+	LWLockRelease(&slot->file_lock);
+}
+
+/*
+ * Compress closed undo segments to reclaim disk space.
+ *
+ * This is called periodically by the undo launcher.  We only touch segments
+ * whose contents can no longer change: the undo log must be permanent (the
+ * other persistence levels don't survive a shutdown anyway), it must not be
+ * attached to any backend, and its most recent transaction must be over, so
+ * that every chunk covering the candidate segments has been closed.  Such
+ * segments can still sit on disk for a long time under long-lived undo
+ * retention, so replacing them with a compressed copy saves most of their
+ * disk and page-cache footprint.  They are brought back transparently if
+ * anyone needs them; see UndoLogUncompressSegment().
+ */
+void
+UndoLogCompressSegments(void)
+{
+	UndoLogSlot *slot = NULL;
+
+	if (!undo_compress_segments)
+		return;
+
+	while ((slot = UndoLogGetNextSlot(slot)))
+	{
+		UndoLogNumber logno;
+		Oid			tablespace;
+		char		persistence;
+		UndoLogOffset discard;
+		UndoLogOffset insert;
+		TransactionId xid;
+		pid_t		pid;
+		int			low_segno;
+		int			high_segno;
+
+		LWLockAcquire(&slot->meta_lock, LW_SHARED);
+		logno = slot->logno;
+		tablespace = slot->meta.tablespace;
+		persistence = slot->meta.persistence;
+		discard = slot->meta.discard;
+		insert = slot->meta.insert;
+		pid = slot->pid;
+		xid = slot->xid;
+		LWLockRelease(&slot->meta_lock);
+
+		if (persistence != RELPERSISTENCE_PERMANENT)
+			continue;
+
+		/*
+		 * Skip logs that are attached to a backend, or whose most recent
+		 * transaction might still be in progress; new records could still
+		 * arrive, or chunks might not be closed yet.  Both fields are
+		 * cleared when a log is returned to a free list.  A backend that
+		 * attaches after this check can only write at or beyond 'insert',
+		 * which is past every segment we'll consider below.
+		 */
+		if (pid != InvalidPid || TransactionIdIsValid(xid))
+			continue;
+
+		/*
+		 * Consider only whole segments between the discard and insert
+		 * pointers.  The segment containing the insert pointer must stay
+		 * uncompressed.
+		 */
+		low_segno = (discard + UndoLogSegmentSize - 1) / UndoLogSegmentSize;
+		high_segno = insert / UndoLogSegmentSize;
+		for (int segno = low_segno; segno < high_segno; ++segno)
+		{
+			CHECK_FOR_INTERRUPTS();
+			compress_undo_segment(slot, logno, tablespace, segno);
+		}
+	}
+}
+
+/*
+ * Replace "<segment>" UndoLogSegmentCompressSuffix with the original
+ * uncompressed segment file, if a compressed copy exists.  Returns true if
+ * the segment file now exists.  This is called by the smgr layer when it
+ * finds a segment file missing; see undofile_open_segment_file().
+ */
+bool
+UndoLogUncompressSegment(UndoLogNumber logno, Oid tablespace, int segno)
+{
+	UndoLogCompressedSegmentHeader header;
+	UndoLogSlot *slot;
+	struct stat stat_buffer;
+	char		path[MAXPGPATH];
+	char		compressed_path[MAXPGPATH];
+	char		tmp_path[MAXPGPATH];
+	char	   *raw;
+	char	   *compressed;
+	off_t		compressed_size;
+	off_t		done;
+	int			fd;
+
+	UndoLogSegmentPath(logno, segno, tablespace, path);
+	snprintf(compressed_path, sizeof(compressed_path), "%s%s",
+			 path, UndoLogSegmentCompressSuffix);
+
+	/*
+	 * Serialize against the launcher compressing this segment, and against
+	 * other backends uncompressing it.  The slot can be gone already if the
+	 * undo log was entirely discarded; then there is certainly no launcher
+	 * working on it, and we use a backend-private temporary file name below
+	 * so concurrent uncompressors can't corrupt each other's work.
+	 */
+	slot = UndoLogGetSlot(logno, true);
+	if (slot)
+		LWLockAcquire(&slot->file_lock, LW_EXCLUSIVE);
+
+	/*
+	 * Someone else may have uncompressed it while we were waiting for the
+	 * lock, or the segment may never have been compressed at all.
+	 */
+	if (stat(path, &stat_buffer) == 0)
+	{
+		if (slot)
+			LWLockRelease(&slot->file_lock);
+		return true;
+	}
+
+	fd = OpenTransientFile(compressed_path, O_RDONLY | PG_BINARY);
+	if (fd < 0)
+	{
+		if (errno != ENOENT)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not open file \"%s\": %m",
+							compressed_path)));
+		if (slot)
+			LWLockRelease(&slot->file_lock);
+		return false;
+	}
+
+	if (fstat(fd, &stat_buffer) < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not fstat \"%s\": %m", compressed_path)));
+
+	pgstat_report_wait_start(WAIT_EVENT_UNDO_FILE_READ);
+	if (read(fd, &header, sizeof(header)) != sizeof(header) ||
+		header.magic != UNDO_COMPRESSED_SEGMENT_MAGIC ||
+		header.rawsize != UndoLogSegmentSize ||
+		stat_buffer.st_size <= sizeof(header))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg("file \"%s\" is not a valid compressed undo segment",
+						compressed_path)));
+	compressed_size = stat_buffer.st_size - sizeof(header);
+	compressed = palloc(compressed_size);
+	done = 0;
+	while (done < compressed_size)
+	{
+		ssize_t		nread;
+
+		nread = read(fd, compressed + done, compressed_size - done);
+		if (nread < 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read file \"%s\": %m",
+							compressed_path)));
+		if (nread == 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("unexpected EOF in file \"%s\"",
+							compressed_path)));
+		done += nread;
+	}
+	pgstat_report_wait_end();
+	CloseTransientFile(fd);
+
+	raw = palloc(UndoLogSegmentSize);
+	if (pglz_decompress(compressed, compressed_size, raw,
+						UndoLogSegmentSize, true) != UndoLogSegmentSize)
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg("could not decompress undo segment \"%s\"",
+						compressed_path)));
+	pfree(compressed);
+
+	/*
+	 * Write the uncompressed segment under a temporary name, and move it
+	 * into place only once its contents are durable.
+	 */
+	snprintf(tmp_path, sizeof(tmp_path), "%s.%d.tmp", path, (int) MyProcPid);
+	fd = OpenTransientFile(tmp_path, O_RDWR | O_CREAT | O_TRUNC | PG_BINARY);
+	if (fd < 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not create file \"%s\": %m", tmp_path)));
+	done = 0;
+	pgstat_report_wait_start(WAIT_EVENT_UNDO_FILE_WRITE);
+	while (done < UndoLogSegmentSize)
+	{
+		ssize_t		written;
+
+		errno = 0;
+		written = write(fd, raw + done, UndoLogSegmentSize - done);
+		if (written <= 0)
+		{
+			/* if write didn't set errno, assume problem is no disk space */
+			if (errno == 0)
+				errno = ENOSPC;
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not write to file \"%s\": %m", tmp_path)));
+		}
+		done += written;
+	}
+	pgstat_report_wait_end();
+	pfree(raw);
+
+	pgstat_report_wait_start(WAIT_EVENT_UNDO_FILE_SYNC);
+	if (pg_fsync(fd) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not fsync file \"%s\": %m", tmp_path)));
+	pgstat_report_wait_end();
+	CloseTransientFile(fd);
+
+	durable_rename(tmp_path, path, ERROR);
+
+	/*
+	 * Now that the uncompressed file is durably back in place, the
+	 * compressed copy is redundant.  Tolerate ENOENT in case a concurrent
+	 * uncompressor of a fully discarded log got there first.
+	 */
+	if (unlink(compressed_path) < 0 && errno != ENOENT)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not unlink \"%s\": %m", compressed_path)));
+
+	elog(DEBUG1, "uncompressed undo segment \"%s\"", path);
+
+	if (slot)
+		LWLockRelease(&slot->file_lock);
+
+	return true;
+}
+
 /*
  * Write out the undo log meta data to the pg_undo directory.  The actual
  * contents of undo logs is in shared buffers and therefore handled by
@@ -996,8 +1868,15 @@ CheckPointUndoLogs(UndoCheckpointContext *ctx)
 		/* Capture snapshot while holding each meta_lock. */
 		LWLockAcquire(&slot->meta_lock, LW_SHARED);
 		serialized[num_logs++] = slot->meta;
+
+		/*
+		 * An entirely discarded slot can only be freed once the background
+		 * reclaim stage has dropped its remaining buffers and files, which
+		 * it records by advancing 'reclaim' past the discard pointer.
+		 */
 		if (slot->meta.discard == slot->meta.insert &&
-			slot->meta.discard == slot->meta.size)
+			slot->meta.discard == slot->meta.size &&
+			slot->reclaim > slot->meta.discard)
 			slots_to_free[nslots_to_free++] = slot;
 		LWLockRelease(&slot->meta_lock);
 	}
@@ -1086,10 +1965,19 @@ StartupUndoLogs(UndoCheckpointContext *ctx)
 		slot->logno = slot->meta.logno;
 		slot->pid = InvalidPid;
 
+		/* No undo buffers survive a restart. */
+		slot->reclaim = slot->meta.discard;
+		slot->discard_lsn = InvalidXLogRecPtr;
+
 		if (slot->meta.insert < slot->meta.size ||
 			slot->meta.discard < slot->meta.insert)
-			slist_push_head(&UndoLogShared->free_lists[GetUndoPersistenceLevel(slot->meta.persistence)],
+		{
+			/* Spread the recovered logs across the free-list stripes. */
+			int		stripe = i % UndoLogShared->nfreelist_stripes;
+
+			slist_push_head(&UndoLogShared->free_lists[GetUndoPersistenceLevel(slot->meta.persistence)][stripe],
 							&slot->next);
+		}
 	}
 
 	/*
@@ -1123,6 +2011,8 @@ allocate_undo_log_slot(void)
 			memset(&slot->meta, 0, sizeof(slot->meta));
 			slot->pid = 0;
 			slot->logno = -1;
+			slot->reclaim = 0;
+			slot->discard_lsn = InvalidXLogRecPtr;
 			return slot;
 		}
 	}
@@ -1544,10 +2434,13 @@ DropUndoLogsInTablespace(Oid tablespace)
 		 */
 		if (return_to_freelist)
 		{
-			LWLockAcquire(UndoLogLock, LW_EXCLUSIVE);
-			slist_push_head(&UndoLogShared->free_lists[GetUndoPersistenceLevel(slot->meta.persistence)],
+			int		stripe = i % UndoLogShared->nfreelist_stripes;
+
+			LWLockAcquire(&UndoLogShared->free_list_locks[stripe],
+						  LW_EXCLUSIVE);
+			slist_push_head(&UndoLogShared->free_lists[GetUndoPersistenceLevel(slot->meta.persistence)][stripe],
 							&slot->next);
-			LWLockRelease(UndoLogLock);
+			LWLockRelease(&UndoLogShared->free_list_locks[stripe]);
 		}
 	}
 
@@ -1561,6 +2454,7 @@ DropUndoLogsInTablespace(Oid tablespace)
 		UndoLogSlot *slot = &UndoLogShared->slots[i];
 		UndoLogNumber logno;
 		UndoLogOffset discard;
+		UndoLogOffset reclaim;
 
 		LWLockAcquire(&slot->meta_lock, LW_SHARED);
 		if (slot->logno == InvalidUndoLogNumber || slot->meta.tablespace != tablespace)
@@ -1570,15 +2464,18 @@ DropUndoLogsInTablespace(Oid tablespace)
 		}
 		logno = slot->meta.logno;
 		discard = slot->meta.discard;
+		reclaim = slot->reclaim;
 		LWLockRelease(&slot->meta_lock);
 
 		/*
 		 * Make sure no buffers remain.  When that is done by
 		 * UndoLogDiscard(), the final page is left in shared_buffers because
 		 * it may contain data, or at least be needed again very soon.  Here
-		 * we need to drop even that page from the buffer pool.
+		 * we need to drop even that page from the buffer pool.  Start from
+		 * 'reclaim' rather than 'discard', in case the background reclaim
+		 * stage hasn't caught up with the discard pointer yet.
 		 */
-		discard_undo_buffers(logno, discard, discard, true);
+		discard_undo_buffers(logno, Min(reclaim, discard), discard, true);
 
 		/*
 		 * Well drop this log.  The rest of its address space is wasted.
@@ -1587,6 +2484,7 @@ DropUndoLogsInTablespace(Oid tablespace)
 		 */
 		LWLockAcquire(&slot->meta_lock, LW_EXCLUSIVE);
 		slot->meta.discard = slot->meta.size = slot->meta.insert;
+		slot->reclaim = (slot->meta.discard / BLCKSZ + 1) * BLCKSZ;
 		LWLockRelease(&slot->meta_lock);
 	}
 
@@ -1621,28 +2519,32 @@ DropUndoLogsInTablespace(Oid tablespace)
 	ndropped = 0;
 
 	/* Remove all dropped undo logs from the free-lists. */
-	LWLockAcquire(UndoLogLock, LW_EXCLUSIVE);
 	for (int i = 0; i < NUndoPersistenceLevels; ++i)
 	{
-		UndoLogSlot *slot;
-		slist_mutable_iter iter;
-
-		slist_foreach_modify(iter, &UndoLogShared->free_lists[i])
+		for (int stripe = 0; stripe < UndoLogShared->nfreelist_stripes; ++stripe)
 		{
-			slot = slist_container(UndoLogSlot, next, iter.cur);
+			UndoLogSlot *slot;
+			slist_mutable_iter iter;
 
-			LWLockAcquire(&slot->meta_lock, LW_SHARED);
-			if (slot->meta.discard == slot->meta.insert &&
-				slot->meta.size == slot->meta.insert)
+			LWLockAcquire(&UndoLogShared->free_list_locks[stripe],
+						  LW_EXCLUSIVE);
+			slist_foreach_modify(iter, &UndoLogShared->free_lists[i][stripe])
 			{
-				slist_delete_current(&iter);
-				dropped_lognos[ndropped] = slot->meta.logno;
-				dropped_slots[ndropped++] = slot;
+				slot = slist_container(UndoLogSlot, next, iter.cur);
+
+				LWLockAcquire(&slot->meta_lock, LW_SHARED);
+				if (slot->meta.discard == slot->meta.insert &&
+					slot->meta.size == slot->meta.insert)
+				{
+					slist_delete_current(&iter);
+					dropped_lognos[ndropped] = slot->meta.logno;
+					dropped_slots[ndropped++] = slot;
+				}
+				LWLockRelease(&slot->meta_lock);
 			}
-			LWLockRelease(&slot->meta_lock);
+			LWLockRelease(&UndoLogShared->free_list_locks[stripe]);
 		}
 	}
-	LWLockRelease(UndoLogLock);
 
 	/* Free all the dropped slots. */
 	for (int i = 0; i < ndropped; ++i)
@@ -1708,13 +2610,15 @@ ResetUndoLogs(char persistence)
 		 */
 		slot->meta.insert = slot->meta.discard = slot->end +
 			SizeOfUndoPageHeaderData;
+		slot->reclaim = slot->meta.discard;
+		slot->discard_lsn = InvalidXLogRecPtr;
 	}
 }
 
 Datum
 pg_stat_get_undo_logs(PG_FUNCTION_ARGS)
 {
-#define PG_STAT_GET_UNDO_LOGS_COLS 9
+#define PG_STAT_GET_UNDO_LOGS_COLS 10
 	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
 	TupleDesc	tupdesc;
 	Tuplestorestate *tupstore;
@@ -1786,19 +2690,22 @@ pg_stat_get_undo_logs(PG_FUNCTION_ARGS)
 				 MakeUndoRecPtr(slot->logno, slot->meta.discard));
 		values[4] = CStringGetTextDatum(buffer);
 		snprintf(buffer, sizeof(buffer), UndoRecPtrFormat,
-				 MakeUndoRecPtr(slot->logno, slot->meta.insert));
+				 MakeUndoRecPtr(slot->logno, slot->reclaim));
 		values[5] = CStringGetTextDatum(buffer);
 		snprintf(buffer, sizeof(buffer), UndoRecPtrFormat,
-				 MakeUndoRecPtr(slot->logno, slot->end));
+				 MakeUndoRecPtr(slot->logno, slot->meta.insert));
 		values[6] = CStringGetTextDatum(buffer);
+		snprintf(buffer, sizeof(buffer), UndoRecPtrFormat,
+				 MakeUndoRecPtr(slot->logno, slot->end));
+		values[7] = CStringGetTextDatum(buffer);
 		if (slot->xid == InvalidTransactionId)
-			nulls[7] = true;
+			nulls[8] = true;
 		else
-			values[7] = TransactionIdGetDatum(slot->xid);
+			values[8] = TransactionIdGetDatum(slot->xid);
 		if (slot->pid == InvalidPid)
-			nulls[8] = true;
+			nulls[9] = true;
 		else
-			values[8] = Int32GetDatum((int32) slot->pid);
+			values[9] = Int32GetDatum((int32) slot->pid);
 		LWLockRelease(&slot->meta_lock);
 
 		/*
@@ -1938,6 +2845,8 @@ undolog_xlog_create(XLogReaderState *record)
 	slot->meta.tablespace = xlrec->tablespace;
 	slot->meta.insert = SizeOfUndoPageHeaderData;
 	slot->meta.discard = SizeOfUndoPageHeaderData;
+	slot->reclaim = SizeOfUndoPageHeaderData;
+	slot->discard_lsn = InvalidXLogRecPtr;
 	LWLockRelease(&slot->meta_lock);
 	UndoLogShared->next_logno = Max(xlrec->logno + 1, UndoLogShared->next_logno);
 	LWLockRelease(UndoLogLock);
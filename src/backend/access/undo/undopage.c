@@ -76,6 +76,24 @@ UndoPageInsertHeader(Page page, int page_offset, int header_offset,
 	/* Insertion point must be as expected. */
 	Assert(page_offset == uph->ud_insertion_point);
 
+	/*
+	 * Fast path: the headers start on this page and fit entirely, so we can
+	 * copy them with no fragment arithmetic, and there is no continuation
+	 * bookkeeping to do.
+	 */
+	if (header_offset == 0 && total_bytes <= BLCKSZ - page_offset)
+	{
+		memcpy(page + page_offset, (char *) header,
+			   SizeOfUndoRecordSetChunkHeader);
+		if (type_header_size > 0)
+			memcpy(page + page_offset + SizeOfUndoRecordSetChunkHeader,
+				   type_header, type_header_size);
+		uph->ud_insertion_point = page_offset + total_bytes;
+		if (uph->ud_first_chunk == 0)
+			uph->ud_first_chunk = page_offset;
+		return total_bytes;
+	}
+
 	/*
 	 * If the entire chunk header hasn't yet been written, then write the
 	 * remaining bytes and start the type header just afterward. If we've
@@ -211,6 +229,23 @@ UndoPageInsertRecord(Page page, int page_offset, int data_offset,
 	/* Insertion point must be as expected. */
 	Assert(page_offset == uph->ud_insertion_point);
 
+	/*
+	 * Fast path: the record starts on this page after some other data and
+	 * fits entirely, which is the dominant case for small records.  There is
+	 * no continuation bookkeeping to do, so a single wide copy and the
+	 * insertion point update suffice.
+	 */
+	if (data_offset == 0 &&
+		page_offset > SizeOfUndoPageHeaderData &&
+		data_size <= BLCKSZ - page_offset)
+	{
+		memcpy(page + page_offset, data, data_size);
+		uph->ud_insertion_point = page_offset + data_size;
+		if (uph->ud_first_record == 0)
+			uph->ud_first_record = page_offset;
+		return data_size;
+	}
+
 	/* Copy as much data as we have, or as much as will fit. */
 	data_bytes = Min(BLCKSZ - page_offset, data_size - data_offset);
 	memcpy(page + page_offset, data + data_offset, data_bytes);
@@ -241,6 +276,60 @@ UndoPageInsertRecord(Page page, int page_offset, int data_offset,
 	return data_bytes;
 }
 
+/*
+ * Reserve space for a record that fits entirely on this page, returning a
+ * pointer to which the caller must write exactly data_size bytes while it
+ * still holds the buffer lock.
+ *
+ * This performs the same page header maintenance as UndoPageInsertRecord
+ * would for a non-spanning record, but leaves the copying of the record data
+ * to the caller, so that the record can be constructed directly in the
+ * shared buffer instead of being staged in backend-local memory first.
+ */
+char *
+UndoPageReserveRecord(Page page, int page_offset, Size data_size,
+					  UndoRecPtr chunk_start, UndoRecordSetType chunk_type)
+{
+	UndoPageHeader uph = (UndoPageHeader) page;
+
+	/* Can't insert nothing. */
+	Assert(data_size > 0);
+
+	/* Must not overwrite the page header. */
+	Assert(page_offset >= SizeOfUndoPageHeaderData);
+
+	/* The whole record must fit on this page. */
+	Assert(page_offset + data_size <= BLCKSZ);
+
+	/* Insertion point must be as expected. */
+	Assert(page_offset == uph->ud_insertion_point);
+
+	/* New insertion point follows the data the caller will write. */
+	uph->ud_insertion_point = page_offset + data_size;
+
+	/*
+	 * The record we're reserving space for starts on this page, so if this
+	 * page doesn't contain any records yet, make the "first record" pointer
+	 * point to it.
+	 */
+	if (uph->ud_first_record == 0)
+		uph->ud_first_record = page_offset;
+
+	/*
+	 * If we're continuing this record set from the previous page, then
+	 * we've got to indicate the chunk type and where it starts.
+	 */
+	if (page_offset == SizeOfUndoPageHeaderData)
+	{
+		Assert(chunk_start != InvalidUndoRecPtr);
+		Assert(chunk_type != URST_INVALID);
+		uph->ud_continue_chunk = chunk_start;
+		uph->ud_continue_chunk_type = (uint8) chunk_type;
+	}
+
+	return (char *) page + page_offset;
+}
+
 /*
  * Compute the number of data bytes that would have been written into a page.
  *
@@ -72,6 +72,7 @@
 #include "storage/buf.h"
 #include "storage/bufmgr.h"
 #include "storage/ipc.h"
+#include "utils/resowner.h"
 
 /*
  * Per-chunk bookkeeping.
@@ -138,6 +139,18 @@ struct UndoRecordSet
 
 	UndoLogOffset	recent_end;
 
+	/*
+	 * Cached pin on the page where the most recent insertion ended.  The
+	 * next insertion will almost always continue on the same page, so we
+	 * hang onto the pin between UndoInsert() calls to avoid repeating the
+	 * buffer lookup.  The pin belongs to the top-level resource owner and
+	 * is dropped when the UndoRecordSet is destroyed.
+	 */
+	Buffer			recent_buffer;
+	UndoLogNumber	recent_logno;
+	BlockNumber		recent_block;
+	int				last_insert_buffer_index;
+
 	/* Resource management. */
 	UndoRecordSetState	state;
 	slist_node		link;
@@ -184,6 +197,8 @@ UndoCreate(UndoRecordSetType type, char persistence, int nestingLevel,
 	urs->max_buffers = 1;
 	urs->type_header_size = type_header_size;
 	urs->need_type_header = true;
+	urs->recent_buffer = InvalidBuffer;
+	urs->last_insert_buffer_index = -1;
 
 	urs->type_header = palloc(type_header_size);
 	memcpy(urs->type_header, type_header, type_header_size);
@@ -610,14 +625,27 @@ UndoPrepareToInsert(UndoRecordSet *urs, size_t record_size)
 		 * with the recovery path, but now UndoAllocateInRecovery is separate
 		 * anyway.)
 		 */
-		/* Get a buffer. */
-		urs->buffers[urs->nbuffers].buffer =
-			ReadBufferWithoutRelcache(rnode,
-									  UndoLogForkNum,
-									  block,
-									  rbm,
-									  NULL,
-									  urs->persistence);
+		/*
+		 * Get a buffer.  Consecutive insertions usually continue on the page
+		 * where the previous one ended; if we still hold a pin on that page,
+		 * we can skip the buffer lookup and just take another pin.
+		 */
+		if (urs->nbuffers == 0 && rbm == RBM_NORMAL &&
+			BufferIsValid(urs->recent_buffer) &&
+			urs->recent_logno == (UndoLogNumber) rnode.relNode &&
+			urs->recent_block == block)
+		{
+			IncrBufferRefCount(urs->recent_buffer);
+			urs->buffers[urs->nbuffers].buffer = urs->recent_buffer;
+		}
+		else
+			urs->buffers[urs->nbuffers].buffer =
+				ReadBufferWithoutRelcache(rnode,
+										  UndoLogForkNum,
+										  block,
+										  rbm,
+										  NULL,
+										  urs->persistence);
 
 		/* How much to go? */
 		bytes_on_this_page = Min(BLCKSZ - offset, total_size);
@@ -640,6 +668,12 @@ UndoPrepareToInsert(UndoRecordSet *urs, size_t record_size)
 	for (int i = 0; i < urs->nbuffers; ++i)
 		LockBuffer(urs->buffers[i].buffer, BUFFER_LOCK_EXCLUSIVE);
 
+	/*
+	 * Remember which buffer holds the end of the insertion, so that
+	 * UndoRelease() can retain a pin on it for the next insertion.
+	 */
+	urs->last_insert_buffer_index = urs->nbuffers - 1;
+
 	/*
 	 * Tell UndoInsert() where the first byte is (which may be pointing to a
 	 * header).
@@ -706,11 +740,34 @@ void
 UndoInsert(UndoRecordSet *urs,
 		   void *record_data,
 		   size_t record_size)
+{
+	UndoRecData rdata;
+
+	rdata.data = record_data;
+	rdata.size = record_size;
+	UndoInsertMulti(urs, &rdata, 1);
+}
+
+/*
+ * Append a batch of records to an undo log in a single pass.  The records
+ * are laid out contiguously, in array order.  The space for the combined
+ * size of all records must previously have been allocated with a single
+ * call to UndoPrepareToInsert(), which also pinned and locked all buffers
+ * in the target range; here we walk those buffers just once and advance
+ * the shared insert pointer under one acquisition of the slot's meta_lock,
+ * rather than paying that overhead per record.
+ */
+void
+UndoInsertMulti(UndoRecordSet *urs,
+				const UndoRecData *records,
+				int nrecords)
 {
 	int bytes_written;
 	int input_offset;
 	int buffer_index;
+	int last_dirtied = -1;
 	int page_offset;
+	size_t all_record_size;
 	int type_header_size = urs->need_type_header ? urs->type_header_size : 0;
 	int chunk_header_size = urs->need_chunk_header ? SizeOfUndoRecordSetChunkHeader : 0;
 	int all_header_size = type_header_size + chunk_header_size;
@@ -799,7 +856,11 @@ UndoInsert(UndoRecordSet *urs,
 									 type_header_size,
 									 urs->type_header,
 									 urs->chunk_start);
-			MarkBufferDirty(ubuf->buffer);
+			if (buffer_index != last_dirtied)
+			{
+				MarkBufferDirty(ubuf->buffer);
+				last_dirtied = buffer_index;
+			}
 			urs->chunks[urs->nchunks - 1].chunk_header_written = true;
 			page_offset += bytes_written;
 			input_offset += bytes_written;
@@ -812,36 +873,55 @@ UndoInsert(UndoRecordSet *urs,
 		}
 	}
 
-	/* Write out the record. */
-	input_offset = 0;
-	for (;;)
+	/* Write out the records. */
+	all_record_size = 0;
+	for (int i = 0; i < nrecords; ++i)
 	{
-		UndoBuffer *ubuf = &urs->buffers[buffer_index];
+		void	   *record_data = records[i].data;
+		size_t		record_size = records[i].size;
 
-		if (buffer_index >= urs->nbuffers)
-			elog(ERROR, "ran out of buffers while inserting undo record");
-		init_if_needed(ubuf);
-		if (URSNeedsWAL(urs))
-			register_insert_page_offset_if_needed(ubuf, page_offset);
-		if (page_offset == SizeOfUndoPageHeaderData)
-			register_new_page(ubuf, urs->type, urs->chunk_start);
-		bytes_written =
-			UndoPageInsertRecord(BufferGetPage(urs->buffers[buffer_index].buffer),
-								 page_offset,
-								 input_offset,
-								 record_size,
-								 record_data,
-								 urs->chunk_start,
-								 urs->type);
-		MarkBufferDirty(urs->buffers[buffer_index].buffer);
-		page_offset += bytes_written;
-		input_offset += bytes_written;
-		if (input_offset >= record_size)
-			break;
-
-		/* Any remaining bytes go onto the next page. */
-		page_offset = SizeOfUndoPageHeaderData;
-		++buffer_index;
+		all_record_size += record_size;
+		input_offset = 0;
+		for (;;)
+		{
+			UndoBuffer *ubuf = &urs->buffers[buffer_index];
+
+			if (buffer_index >= urs->nbuffers)
+				elog(ERROR, "ran out of buffers while inserting undo record");
+			init_if_needed(ubuf);
+			if (URSNeedsWAL(urs))
+				register_insert_page_offset_if_needed(ubuf, page_offset);
+			if (page_offset == SizeOfUndoPageHeaderData)
+				register_new_page(ubuf, urs->type, urs->chunk_start);
+			bytes_written =
+				UndoPageInsertRecord(BufferGetPage(ubuf->buffer),
+									 page_offset,
+									 input_offset,
+									 record_size,
+									 record_data,
+									 urs->chunk_start,
+									 urs->type);
+			if (buffer_index != last_dirtied)
+			{
+				MarkBufferDirty(ubuf->buffer);
+				last_dirtied = buffer_index;
+			}
+			page_offset += bytes_written;
+			input_offset += bytes_written;
+			if (input_offset >= record_size)
+				break;
+
+			/* Any remaining bytes go onto the next page. */
+			page_offset = SizeOfUndoPageHeaderData;
+			++buffer_index;
+		}
+
+		/* If this record ended exactly at a page boundary, move on. */
+		if (page_offset >= BLCKSZ)
+		{
+			page_offset = SizeOfUndoPageHeaderData;
+			++buffer_index;
+		}
 	}
 
 	urs->state = URS_STATE_DIRTY;
@@ -850,9 +930,11 @@ UndoInsert(UndoRecordSet *urs,
 	LWLockAcquire(&urs->slot->meta_lock, LW_EXCLUSIVE);
 	urs->slot->meta.insert =
 		UndoLogOffsetPlusUsableBytes(urs->slot->meta.insert,
-									 all_header_size + record_size);
+									 all_header_size + all_record_size);
 	LWLockRelease(&urs->slot->meta_lock);
 
+	UndoLogCountInsertion(all_header_size + all_record_size, nrecords);
+
 	/*
 	 * If we created a new chunk, we may also need to mark the previous chunk
 	 * closed.  In that case, UndoPrepareToInsert() will have pinned and
@@ -872,6 +954,82 @@ UndoInsert(UndoRecordSet *urs,
 	urs->need_type_header = false;
 }
 
+/*
+ * Test whether a record of the given size could be constructed directly in
+ * the insertion page with UndoBeginInsertInPlace(), rather than being staged
+ * in backend-local memory and copied in with UndoInsert().
+ *
+ * That is only possible if no chunk or type header has to be written first
+ * and the whole record fits on the first prepared page.  The answer remains
+ * valid until the insertion is performed, because the insertion point and
+ * the header requirements were fixed by UndoPrepareToInsert().
+ */
+bool
+UndoCanInsertInPlace(UndoRecordSet *urs, size_t record_size)
+{
+	/* The caller must already have called UndoPrepareToInsert. */
+	Assert(urs->slot);
+	Assert(urs->nbuffers >= 1);
+
+	if (urs->need_chunk_header || urs->need_type_header)
+		return false;
+
+	return urs->begin % BLCKSZ + record_size <= BLCKSZ;
+}
+
+/*
+ * Reserve space for a record in the insertion page, returning a pointer to
+ * which the caller must write exactly record_size bytes of record data
+ * before calling UndoFinishInsertInPlace().  The caller must have verified
+ * with UndoCanInsertInPlace() that this is possible, and must be in a
+ * critical section, since this modifies a shared buffer.
+ */
+char *
+UndoBeginInsertInPlace(UndoRecordSet *urs, size_t record_size)
+{
+	UndoBuffer *ubuf = &urs->buffers[0];
+	int page_offset = urs->begin % BLCKSZ;
+
+	Assert(!InRecovery);
+	Assert(CritSectionCount > 0);
+	Assert(UndoCanInsertInPlace(urs, record_size));
+
+	init_if_needed(ubuf);
+	if (URSNeedsWAL(urs))
+		register_insert_page_offset_if_needed(ubuf, page_offset);
+	if (page_offset == SizeOfUndoPageHeaderData)
+		register_new_page(ubuf, urs->type, urs->chunk_start);
+
+	return UndoPageReserveRecord(BufferGetPage(ubuf->buffer), page_offset,
+								 record_size, urs->chunk_start, urs->type);
+}
+
+/*
+ * Complete an insertion begun with UndoBeginInsertInPlace().  The record
+ * data must by now have been written in full.
+ */
+void
+UndoFinishInsertInPlace(UndoRecordSet *urs, size_t record_size)
+{
+	MarkBufferDirty(urs->buffers[0].buffer);
+	urs->state = URS_STATE_DIRTY;
+
+	/* Advance the insert pointer in shared memory. */
+	LWLockAcquire(&urs->slot->meta_lock, LW_EXCLUSIVE);
+	urs->slot->meta.insert =
+		UndoLogOffsetPlusUsableBytes(urs->slot->meta.insert, record_size);
+	LWLockRelease(&urs->slot->meta_lock);
+
+	UndoLogCountInsertion(record_size, 1);
+
+	/*
+	 * Unlike UndoInsertMulti(), we never have a previous chunk to close
+	 * here: UndoCanInsertInPlace() only permits this path when no chunk
+	 * header was needed, so the current chunk predates this insertion.
+	 */
+	Assert(!urs->need_chunk_header && !urs->need_type_header);
+}
+
 /*
  * Insert an undo record and/or replay other undo data modifications that were
  * performed at DO time.  If an undo record was inserted at DO time, the exact
@@ -884,12 +1042,83 @@ UndoInsert(UndoRecordSet *urs,
  */
 UndoRecPtr
 UndoReplay(XLogReaderState *xlog_record, void *record_data, size_t record_size)
+{
+	UndoRecData rdata;
+
+	rdata.data = record_data;
+	rdata.size = record_size;
+	return UndoReplayMulti(xlog_record, &rdata, record_data != NULL ? 1 : 0);
+}
+
+#ifdef USE_PREFETCH
+/* How far ahead undo_replay_prefetch() has hinted, per most recent log. */
+static UndoLogNumber undo_replay_prefetch_logno = InvalidUndoLogNumber;
+static BlockNumber undo_replay_prefetch_upto = 0;
+#endif
+
+/*
+ * Hint the operating system about the undo blocks that replay is likely to
+ * need soon.
+ *
+ * Undo block references arrive one WAL record at a time, but insertions
+ * advance through each undo log sequentially, so when we're about to read
+ * the page at 'blkno' the pages just after it are very likely to be touched
+ * by upcoming WAL records.  Issue advisory reads for up to
+ * effective_io_concurrency following blocks, within the log's allocated
+ * range.  We remember how far we've already hinted in the most recently
+ * replayed log, so that a stream of small records costs one hint per block
+ * rather than one per record.
+ */
+static void
+undo_replay_prefetch(RelFileNode rnode, UndoLogSlot *slot, BlockNumber blkno)
+{
+#ifdef USE_PREFETCH
+	BlockNumber limit = slot->end / BLCKSZ;
+	BlockNumber target;
+	BlockNumber next;
+
+	if (effective_io_concurrency <= 0)
+		return;
+
+	target = Min(blkno + 1 + effective_io_concurrency, limit);
+	next = blkno + 1;
+
+	/* Skip blocks already hinted, if we're still in the same log. */
+	if (slot->logno != undo_replay_prefetch_logno)
+	{
+		undo_replay_prefetch_logno = slot->logno;
+		undo_replay_prefetch_upto = next;
+	}
+	else
+		next = Max(next, undo_replay_prefetch_upto);
+
+	while (next < target)
+		PrefetchBufferWithoutRelcache(rnode, UndoLogForkNum, next++);
+	if (next > undo_replay_prefetch_upto)
+		undo_replay_prefetch_upto = next;
+#endif							/* USE_PREFETCH */
+}
+
+/*
+ * Re-insert a batch of undo records and/or replay other undo data
+ * modifications that were performed at DO time.  The records must be exactly
+ * those that a single UndoInsertMulti() call wrote at DO time, in the same
+ * order and with the same sizes, so that the page layout (record boundaries,
+ * continuation headers) comes out identically.
+ *
+ * Return a pointer to the record that was inserted, if records were
+ * provided.
+ */
+UndoRecPtr
+UndoReplayMulti(XLogReaderState *xlog_record, const UndoRecData *records,
+				int nrecords)
 {
 	int nbuffers;
 	UndoLogSlot *slot;
 	UndoRecPtr result = InvalidUndoRecPtr;
 	UndoBuffer *buffers;
 	bool record_more = false;
+	int record_index = 0;
 	int record_offset = 0;
 	UndoRecordSetChunkHeader chunk_header;
 	bool header_more = false;
@@ -948,6 +1177,13 @@ UndoReplay(XLogReaderState *xlog_record, void *record_data, size_t record_size)
 			else
 				rbm = RBM_NORMAL;
 
+			/*
+			 * If we're going to read the page, hint the blocks that will
+			 * likely follow it before we block on this one.
+			 */
+			if (rbm == RBM_NORMAL)
+				undo_replay_prefetch(block->rnode, slot, block->blkno);
+
 			/* Read the buffer. */
 			action = XLogReadBufferForRedoExtended(xlog_record,
 												   block_id,
@@ -988,7 +1224,7 @@ UndoReplay(XLogReaderState *xlog_record, void *record_data, size_t record_size)
 			 */
 			if (bufdata->flags & URS_XLOG_INSERT)
 			{
-				if (!record_data)
+				if (record_index >= nrecords)
 					elog(ERROR, "undo buf data contained an insert page offset, but no record was passed to UndoReplay()");
 				/* Update the insertion point on the page. */
 				if (!skip)
@@ -1063,6 +1299,9 @@ UndoReplay(XLogReaderState *xlog_record, void *record_data, size_t record_size)
 			/* Are we still writing a record that spilled into the next page? */
 			else if (record_more)
 			{
+				char	   *record_data = records[record_index].data;
+				size_t		record_size = records[record_index].size;
+
 				if (skip)
 					record_offset += UndoPageSkipRecord(SizeOfUndoPageHeaderData,
 														record_offset,
@@ -1091,7 +1330,8 @@ UndoReplay(XLogReaderState *xlog_record, void *record_data, size_t record_size)
 
 				/* We have finished writing the record.*/
 				record_more = false;
-				record_data = NULL;
+				++record_index;
+				record_offset = 0;
 			}
 
 			/* Check if we need to write a chunk header. */
@@ -1166,8 +1406,11 @@ UndoReplay(XLogReaderState *xlog_record, void *record_data, size_t record_size)
 			}
 
 			/* Check if we need to insert the caller's record data. */
-			if (record_data)
+			while (record_index < nrecords)
 			{
+				char	   *record_data = records[record_index].data;
+				size_t		record_size = records[record_index].size;
+
 				if (skip)
 				{
 					record_offset += UndoPageSkipRecord(SizeOfUndoPageHeaderData,
@@ -1176,6 +1419,16 @@ UndoReplay(XLogReaderState *xlog_record, void *record_data, size_t record_size)
 				}
 				else
 				{
+					/*
+					 * If the previous record ended exactly at the end of the
+					 * page, the next record starts on the next registered
+					 * buffer.
+					 */
+					if (uph->ud_insertion_point >= BLCKSZ)
+					{
+						record_more = true;
+						break;
+					}
 					record_offset = UndoPageInsertRecord(page,
 														 uph->ud_insertion_point,
 														 0,
@@ -1192,10 +1445,17 @@ UndoReplay(XLogReaderState *xlog_record, void *record_data, size_t record_size)
 				if (record_offset < record_size)
 				{
 					record_more = true;
-					nbuffers++;
-					continue;
+					break;
 				}
-				record_data = NULL;
+
+				/* Insert any further records on this same page. */
+				++record_index;
+				record_offset = 0;
+			}
+			if (record_more)
+			{
+				nbuffers++;
+				continue;
 			}
 
 			if (bufdata->flags & URS_XLOG_CLOSE_CHUNK)
@@ -1363,6 +1623,36 @@ UndoPageSetLSN(UndoRecordSet *urs, UndoRecPtr lsn)
 void
 UndoRelease(UndoRecordSet *urs)
 {
+	/*
+	 * Before letting go of everything, move our cached pin to the page
+	 * where this insertion ended, where the next insertion will most
+	 * likely continue.  The pin has to survive subtransaction boundaries,
+	 * so account for it in the top-level resource owner.
+	 */
+	if (urs->last_insert_buffer_index >= 0 &&
+		urs->last_insert_buffer_index < urs->nbuffers)
+	{
+		Buffer		buffer = urs->buffers[urs->last_insert_buffer_index].buffer;
+
+		if (buffer != urs->recent_buffer)
+		{
+			RelFileNode rnode;
+			ForkNumber	forkno;
+			ResourceOwner oldowner = CurrentResourceOwner;
+
+			CurrentResourceOwner = TopTransactionResourceOwner;
+			if (BufferIsValid(urs->recent_buffer))
+				ReleaseBuffer(urs->recent_buffer);
+			IncrBufferRefCount(buffer);
+			CurrentResourceOwner = oldowner;
+
+			urs->recent_buffer = buffer;
+			BufferGetTag(buffer, &rnode, &forkno, &urs->recent_block);
+			urs->recent_logno = (UndoLogNumber) rnode.relNode;
+		}
+		urs->last_insert_buffer_index = -1;
+	}
+
 	for (int i = 0; i < urs->nbuffers; ++i)
 		UnlockReleaseBuffer(urs->buffers[i].buffer);
 	urs->nbuffers = 0;
@@ -1380,6 +1670,17 @@ UndoDestroy(UndoRecordSet *urs)
 	/* Release buffer locks. */
 	UndoRelease(urs);
 
+	/* And the cached insertion-page pin, if we still hold one. */
+	if (BufferIsValid(urs->recent_buffer))
+	{
+		ResourceOwner oldowner = CurrentResourceOwner;
+
+		CurrentResourceOwner = TopTransactionResourceOwner;
+		ReleaseBuffer(urs->recent_buffer);
+		CurrentResourceOwner = oldowner;
+		urs->recent_buffer = InvalidBuffer;
+	}
+
 	/* If you write any data, you also have to close it properly. */
 	if (urs->state == URS_STATE_DIRTY)
 		elog(PANIC, "dirty undo record set not closed before release");
@@ -1415,6 +1716,13 @@ UndoResetInsertion(void)
 		UndoRecordSet *urs = slist_container(UndoRecordSet, link, iter.cur);
 
 		urs->nbuffers = 0;
+
+		/*
+		 * Forget the cached insertion-page pin, too; the abort machinery
+		 * releases the pin itself via the resource owner.
+		 */
+		urs->recent_buffer = InvalidBuffer;
+		urs->last_insert_buffer_index = -1;
 	}
 }
 
@@ -1792,6 +2100,38 @@ CloseDanglingUndoRecordSets(void)
 {
 	UndoLogSlot *slot = NULL;
 
+#ifdef USE_PREFETCH
+	/*
+	 * Hint the final data page of every non-empty undo log before we start
+	 * examining them one by one.  Each log's scan begins with a synchronous
+	 * read of that page, so issuing all the advisory reads up front makes
+	 * the cost of this pass on a many-log cluster bounded by aggregate I/O
+	 * bandwidth rather than log count times read latency.
+	 */
+	while ((slot = UndoLogGetNextSlot(slot)))
+	{
+		UndoLogOffset discard = slot->meta.discard;
+		UndoLogOffset insert = slot->meta.insert;
+		UndoLogOffset last_data_offset;
+		RelFileNode rnode;
+
+		if (insert == discard)
+			continue;
+
+		/* Mirror find_start_of_final_chunk_in_undo_log()'s page choice. */
+		last_data_offset = insert - 1;
+		if (last_data_offset % BLCKSZ < SizeOfUndoPageHeaderData)
+			last_data_offset -= SizeOfUndoPageHeaderData;
+
+		UndoRecPtrAssignRelFileNode(rnode,
+									MakeUndoRecPtr(slot->logno,
+												   last_data_offset));
+		PrefetchBufferWithoutRelcache(rnode, MAIN_FORKNUM,
+									  last_data_offset / BLCKSZ);
+	}
+	slot = NULL;
+#endif							/* USE_PREFETCH */
+
 	while ((slot = UndoLogGetNextSlot(slot)))
 	{
 		UndoLogNumber logno = slot->logno;
@@ -20,6 +20,17 @@
  * is to decide on the order in which undo requests should been processed;
  * see GetNextUndoRequest for details.
  *
+ * Since every undo-writing transaction must register a request at start and
+ * unregister it at commit, the request manager is on the critical path for
+ * write transactions.  To keep it from becoming a single point of
+ * serialization on many-core machines, the manager is partitioned into
+ * shards, each with its own lock, request freelist, and priority structures.
+ * A request lives in the shard chosen by hashing its FullTransactionId, so
+ * registration and unregistration by concurrent backends mostly touch
+ * different shards.  GetNextUndoRequest scans the shards; as a consequence,
+ * prioritization is exact within a shard but only approximate across shards,
+ * which is fine because the prioritization rules are heuristic anyway.
+ *
  * We have only a fixed amount of shared memory to store undo requests;
  * because an undo request has to be created before any undo that might
  * need to be processed is written, we should never end up in a situation
@@ -46,10 +57,41 @@
 #include "funcapi.h"
 #include "lib/ilist.h"
 #include "lib/rbtree.h"
+#include "port/atomics.h"
 #include "storage/shmem.h"
 #include "utils/builtins.h"
 #include "utils/timestamp.h"
 
+/*
+ * Limits on the number of shards into which an UndoRequestManager is split.
+ *
+ * There's no point in splitting a small manager, both because the contention
+ * benefits would be negligible and because dividing the capacity into many
+ * small freelists makes it more likely that one shard fills up while others
+ * still have room.  So we require a minimum capacity per shard, and managers
+ * smaller than twice that minimum get just one shard (which also keeps the
+ * behavior of small test instances exactly as it was before sharding).
+ */
+#define URM_MAX_SHARDS				16
+#define URM_MIN_SHARD_CAPACITY		64
+
+/*
+ * Retry policy for failed undo requests.
+ *
+ * The first retry happens after UNDO_REQUEST_INITIAL_RETRY_MS, and the delay
+ * doubles with each subsequent failure up to UNDO_REQUEST_MAX_RETRY_MS.  Once
+ * a request has failed UNDO_REQUEST_RETRY_BUDGET times, it is quarantined: it
+ * moves to a separate RBTree which GetNextUndoRequest only glances at when
+ * the soonest quarantined retry time has actually arrived, so that a request
+ * which fails persistently (say, because its tablespace is gone) stops
+ * consuming scan cycles that could be spent dispatching healthy requests.
+ * Quarantined requests are still retried at the maximum interval; we can't
+ * ignore them forever, because their undo still has to be applied eventually.
+ */
+#define UNDO_REQUEST_INITIAL_RETRY_MS	(10 * 1000L)
+#define UNDO_REQUEST_MAX_RETRY_MS		(10 * 60 * 1000L)
+#define UNDO_REQUEST_RETRY_BUDGET		8
+
 /*
  * FREE means that the UndoRequest object is not in use. It is available
  * to be allocated.
@@ -132,6 +174,8 @@ struct UndoRequest
 {
 	UndoRequestData	d;
 	TimestampTz retry_time;
+	unsigned	nfailures;		/* # of failed undo attempts */
+	bool		quarantined;	/* in requests_by_quarantine, if WAITING */
 	dlist_node	link;
 };
 
@@ -157,26 +201,30 @@ typedef enum UndoRequestSource
 } UndoRequestSource;
 
 /*
- * An UndoRequestManager manages a collection of UndoRequest and
- * UndoRequestNode objects. Typically, there would only be one such object
- * for the whole system, but it's possible to create others for testing
- * purposes.
+ * One shard of an UndoRequestManager.
+ *
+ * Each shard owns a fixed fraction of the manager's UndoRequest and
+ * UndoRequestNode arenas, and all state needed to manage them.  A request is
+ * assigned to a shard by hashing its FullTransactionId, and never moves to
+ * another shard.  All fields here are protected by the shard's lock.
  *
- * When an UndoRequest managed by an UndoRequestManager is in a state other
+ * When an UndoRequest managed by a shard is in a state other
  * than WAITING, it is not present in any RBTree. When WAITING, if retry_time
  * is DT_NOBEGIN, it is present in both requests_by_fxid and requests_by_size.
  * When WAITING with some other value for retry_time, it is present in
- * requests_by_retry_time.
+ * requests_by_retry_time if it has not yet exhausted its retry budget, and
+ * in requests_by_quarantine if it has (in which case 'quarantined' is also
+ * set).
  *
  * When an UndoRequest is in any state other than ALLOCATED, all changes to it
- * require the UndoRequestManager's lock. When it is ALLOCATED, changes be made
- * without taking the lock, except to status, d.fxid, d.dbid, next_retry_time,
- * and next_request, which still require it. Most code should ignore requests
- * in the ALLOCATED state, and should definitely ignore the values of fields
- * that could be modified without a lock at any time, as they are likely to
- * contain incorrect data. Since an ALLOCATED request corresponds to a
- * transaction which is still running, the final values of fields in
- * the UndoRequestData are not yet known.
+ * require the owning shard's lock. When it is ALLOCATED, changes can be made
+ * without taking the lock, except to status, d.fxid, and d.dbid, which still
+ * require it. Most code should ignore requests in the ALLOCATED state, and
+ * should definitely ignore the values of fields that could be modified
+ * without a lock at any time, as they are likely to contain incorrect data.
+ * Since an ALLOCATED request corresponds to a transaction which is still
+ * running, the final values of fields in the UndoRequestData are not yet
+ * known.
  *
  * Generally, if a request is in the FREE or WAITING state, it should not
  * be examined in any way without holding the lock. In other states, it is
@@ -191,32 +239,57 @@ typedef enum UndoRequestSource
  * that is WAITING should eventually become IN_PROGRESS and then, after the
  * work is completed, FREE.
  *
- * Each UndoRequest is either in a list of free requests or a list of used
- * requests, depending on whether the state is FREE or otherwise. The link
- * field is used for this purpose.
+ * Each UndoRequest is either in its shard's list of free requests or its
+ * shard's list of used requests, depending on whether the state is FREE or
+ * otherwise. The link field is used for this purpose.
  */
-struct UndoRequestManager
+typedef struct UndoRequestShard
 {
-	LWLock	   *lock;			/* for synchronization */
-	unsigned	capacity;		/* max # of UndoRequests */
-	unsigned	utilization;	/* # of non-FREE UndoRequests */
-	unsigned	soft_size_limit;	/* threshold to not background */
+	LWLock		lock;			/* protects all fields in this shard */
+	unsigned	utilization;	/* # of non-FREE UndoRequests in shard */
 	UndoRequestSource source;	/* which RBTree to check next? */
 	RBTree		requests_by_fxid;	/* lower FXIDs first */
 	RBTree		requests_by_size;	/* bigger sizes first */
 	RBTree		requests_by_retry_time; /* sooner retry times first */
+	RBTree		requests_by_quarantine; /* ditto, for quarantined requests */
 	bool		oldest_fxid_valid;	/* true if next field is valid */
-	FullTransactionId oldest_fxid;	/* oldest FXID of any UndoRequest */
+	FullTransactionId oldest_fxid;	/* oldest FXID of any shard UndoRequest */
 	dlist_head	free_requests;
 	dlist_head	used_requests;
 	UndoRequestNode *first_free_request_node;
+} UndoRequestShard;
+
+/*
+ * An UndoRequestManager manages a collection of UndoRequest and
+ * UndoRequestNode objects. Typically, there would only be one such object
+ * for the whole system, but it's possible to create others for testing
+ * purposes.
+ *
+ * Apart from the shards, everything here is read-only after initialization
+ * or updated atomically; there is no manager-wide lock.  The utilization
+ * counter duplicates the sum of the per-shard counters so that the soft
+ * limit can be checked without visiting every shard.
+ */
+struct UndoRequestManager
+{
+	unsigned	capacity;		/* max # of UndoRequests */
+	unsigned	soft_size_limit;	/* threshold to not background */
+	unsigned	nshards;		/* # of shards in use */
+	unsigned	shard_capacity; /* max # of UndoRequests per shard */
+	pg_atomic_uint32 utilization;	/* total # of non-FREE UndoRequests */
+	pg_atomic_uint32 next_scan_shard;	/* rotates GetNextUndoRequest start */
+	UndoRequestShard shards[URM_MAX_SHARDS];
 };
 
 /* Static functions. */
-static UndoRequest *FindUndoRequestForDatabase(UndoRequestManager *urm,
+static unsigned UndoRequestManagerShardCount(unsigned capacity);
+static UndoRequest *FindUndoRequestForDatabase(UndoRequestShard *shard,
 											   Oid dbid);
-static bool BackgroundUndoOK(UndoRequestManager *urm,
-							 UndoRequest *req);
+static UndoRequest *GetNextUndoRequestFromShard(UndoRequestShard *shard,
+												Oid dbid,
+												bool *saw_db_mismatch);
+static void ExtractUndoRequest(UndoRequestShard *shard, UndoRequest *req);
+static bool BackgroundUndoOK(UndoRequestManager *urm);
 static RBTNode *UndoRequestNodeAllocate(void *arg);
 static void UndoRequestNodeFree(RBTNode *x, void *arg);
 static void UndoRequestNodeCombine(RBTNode *existing, const RBTNode *newdata,
@@ -236,6 +309,26 @@ static void RemoveUndoRequest(RBTree *rbt, UndoRequest *req);
 bool undo_force_foreground;
 
 
+/*
+ * Work out how many shards to use for a manager of a given capacity.
+ */
+static unsigned
+UndoRequestManagerShardCount(unsigned capacity)
+{
+	unsigned	nshards = capacity / URM_MIN_SHARD_CAPACITY;
+
+	return Max(1, Min(nshards, URM_MAX_SHARDS));
+}
+
+/*
+ * Find the shard responsible for a given FullTransactionId.
+ */
+static inline UndoRequestShard *
+UndoRequestShardForFXID(UndoRequestManager *urm, FullTransactionId fxid)
+{
+	return &urm->shards[U64FromFullTransactionId(fxid) % urm->nshards];
+}
+
 /*
  * Compute the amount of space that will be needed by an undo request manager.
  *
@@ -243,15 +336,22 @@ bool undo_force_foreground;
  * objects, and for the UndoRequestNode objects.  We need twice as many
  * UndoRequestNode objects as we do UndoRequest objects, because unfailed
  * requests are stored in both requests_by_fxid and requests_by_size; failed
- * requests are stored only in requests_by_retry_time.
+ * requests are stored only in requests_by_retry_time or, once their retry
+ * budget is exhausted, requests_by_quarantine.
+ *
+ * Because the capacity is divided evenly among the shards, rounding up may
+ * make the effective total capacity slightly larger than requested.
  */
 Size
 EstimateUndoRequestManagerSize(unsigned capacity)
 {
+	unsigned	nshards = UndoRequestManagerShardCount(capacity);
+	unsigned	shard_capacity = (capacity + nshards - 1) / nshards;
+	Size		total = mul_size(nshards, shard_capacity);
 	Size		s = MAXALIGN(sizeof(UndoRequestManager));
 
-	s = add_size(s, MAXALIGN(mul_size(capacity, sizeof(UndoRequest))));
-	s = add_size(s, MAXALIGN(mul_size(capacity,
+	s = add_size(s, MAXALIGN(mul_size(total, sizeof(UndoRequest))));
+	s = add_size(s, MAXALIGN(mul_size(total,
 									  mul_size(2, sizeof(UndoRequestNode)))));
 
 	return s;
@@ -265,70 +365,84 @@ EstimateUndoRequestManagerSize(unsigned capacity)
  * be needed. This means that this infrastructure can potentially be used in
  * either shared memory or, if desired, in backend-private memory. It will not
  * work in DSM, though, because it uses pointers.
- *
- * The caller must also provide a lock that will be used to protect access
- * to the data managed by this undo request manager.  This cannot be NULL,
- * even if the memory is private.
  */
 void
-InitializeUndoRequestManager(UndoRequestManager *urm, LWLock *lock,
-							 unsigned capacity, unsigned soft_limit)
+InitializeUndoRequestManager(UndoRequestManager *urm, unsigned capacity,
+							 unsigned soft_limit)
 {
 	UndoRequest *reqs;
 	UndoRequestNode *nodes;
+	unsigned	s;
 	int			i;
 
 	/* Basic initialization. */
-	urm->lock = lock;
 	urm->capacity = capacity;
-	urm->utilization = 0;
 	urm->soft_size_limit = soft_limit;
-	urm->source = UNDO_SOURCE_FXID;
-	rbt_initialize(&urm->requests_by_fxid, sizeof(UndoRequestNode),
-				   UndoRequestNodeCompareFXID, UndoRequestNodeCombine,
-				   UndoRequestNodeAllocate, UndoRequestNodeFree, urm);
-	rbt_initialize(&urm->requests_by_size, sizeof(UndoRequestNode),
-				   UndoRequestNodeCompareSize, UndoRequestNodeCombine,
-				   UndoRequestNodeAllocate, UndoRequestNodeFree, urm);
-	rbt_initialize(&urm->requests_by_retry_time, sizeof(UndoRequestNode),
-				   UndoRequestNodeCompareRetryTime, UndoRequestNodeCombine,
-				   UndoRequestNodeAllocate, UndoRequestNodeFree, urm);
-	urm->oldest_fxid_valid = true;
-	urm->oldest_fxid = InvalidFullTransactionId;
-	dlist_init(&urm->free_requests);
-	dlist_init(&urm->used_requests);
+	urm->nshards = UndoRequestManagerShardCount(capacity);
+	urm->shard_capacity = (capacity + urm->nshards - 1) / urm->nshards;
+	pg_atomic_init_u32(&urm->utilization, 0);
+	pg_atomic_init_u32(&urm->next_scan_shard, 0);
 
 	/* Find memory for UndoRequest and UndoRequestNode arenas. */
 	reqs = (UndoRequest *)
 		(((char *) urm) + MAXALIGN(sizeof(UndoRequestManager)));
 	nodes = (UndoRequestNode *)
-		(((char *) reqs) + MAXALIGN(capacity * sizeof(UndoRequest)));
+		(((char *) reqs) + MAXALIGN(urm->nshards * urm->shard_capacity *
+									sizeof(UndoRequest)));
 
-	/* Build a free list of UndoRequest objects.  */
-	for (i = 0; i < capacity; ++i)
+	for (s = 0; s < urm->nshards; ++s)
 	{
-		UndoRequest *req = &reqs[i];
+		UndoRequestShard *shard = &urm->shards[s];
+
+		LWLockInitialize(&shard->lock, LWTRANCHE_UNDO_REQUEST);
+		shard->utilization = 0;
+		shard->source = UNDO_SOURCE_FXID;
+		rbt_initialize(&shard->requests_by_fxid, sizeof(UndoRequestNode),
+					   UndoRequestNodeCompareFXID, UndoRequestNodeCombine,
+					   UndoRequestNodeAllocate, UndoRequestNodeFree, shard);
+		rbt_initialize(&shard->requests_by_size, sizeof(UndoRequestNode),
+					   UndoRequestNodeCompareSize, UndoRequestNodeCombine,
+					   UndoRequestNodeAllocate, UndoRequestNodeFree, shard);
+		rbt_initialize(&shard->requests_by_retry_time, sizeof(UndoRequestNode),
+					   UndoRequestNodeCompareRetryTime, UndoRequestNodeCombine,
+					   UndoRequestNodeAllocate, UndoRequestNodeFree, shard);
+		rbt_initialize(&shard->requests_by_quarantine, sizeof(UndoRequestNode),
+					   UndoRequestNodeCompareRetryTime, UndoRequestNodeCombine,
+					   UndoRequestNodeAllocate, UndoRequestNodeFree, shard);
+		shard->oldest_fxid_valid = true;
+		shard->oldest_fxid = InvalidFullTransactionId;
+		dlist_init(&shard->free_requests);
+		dlist_init(&shard->used_requests);
+
+		/* Build a free list of this shard's UndoRequest objects.  */
+		for (i = 0; i < urm->shard_capacity; ++i)
+		{
+			UndoRequest *req = &reqs[s * urm->shard_capacity + i];
 
-		req->d.status = UNDO_REQUEST_FREE;
-		dlist_push_tail(&urm->free_requests, &req->link);
-	}
+			req->d.status = UNDO_REQUEST_FREE;
+			dlist_push_tail(&shard->free_requests, &req->link);
+		}
 
-	/*
-	 * Similarly, build a free list of UndoRequestNode objects.  In this case,
-	 * we use the first few bytes of the free object to store a pointer to the
-	 * next free object.
-	 */
-	StaticAssertStmt(sizeof(UndoRequestNode) >= sizeof(UndoRequestNode *),
-					 "UndoRequestNode is too small");
-	urm->first_free_request_node = nodes;
-	for (i = 0; i < 2 * capacity - 1; ++i)
-	{
-		UndoRequestNode *current = &nodes[i];
-		UndoRequestNode *next = &nodes[i + 1];
+		/*
+		 * Similarly, build a free list of UndoRequestNode objects.  In this
+		 * case, we use the first few bytes of the free object to store a
+		 * pointer to the next free object.
+		 */
+		StaticAssertStmt(sizeof(UndoRequestNode) >= sizeof(UndoRequestNode *),
+						 "UndoRequestNode is too small");
+		shard->first_free_request_node = &nodes[s * 2 * urm->shard_capacity];
+		for (i = 0; i < 2 * urm->shard_capacity - 1; ++i)
+		{
+			UndoRequestNode *current =
+				&nodes[s * 2 * urm->shard_capacity + i];
+			UndoRequestNode *next =
+				&nodes[s * 2 * urm->shard_capacity + i + 1];
 
-		*(UndoRequestNode **) current = next;
+			*(UndoRequestNode **) current = next;
+		}
+		*(UndoRequestNode **)
+			&nodes[(s * 2 + 2) * urm->shard_capacity - 1] = NULL;
 	}
-	*(UndoRequestNode **) &nodes[2 * capacity - 1] = NULL;
 }
 
 /*
@@ -346,21 +460,23 @@ InitializeUndoRequestManager(UndoRequestManager *urm, LWLock *lock,
 UndoRequest *
 RegisterUndoRequest(UndoRequestManager *urm, FullTransactionId fxid, Oid dbid)
 {
+	UndoRequestShard *shard = UndoRequestShardForFXID(urm, fxid);
 	UndoRequest *req = NULL;
 
-	LWLockAcquire(urm->lock, LW_EXCLUSIVE);
+	LWLockAcquire(&shard->lock, LW_EXCLUSIVE);
 
-	if (!dlist_is_empty(&urm->free_requests))
+	if (!dlist_is_empty(&shard->free_requests))
 	{
 		dlist_node *dnode;
 
 		/* Allocate a request. */
-		dnode = dlist_pop_head_node(&urm->free_requests);
+		dnode = dlist_pop_head_node(&shard->free_requests);
 		req = dlist_container(UndoRequest, link, dnode);
-		dlist_push_head(&urm->used_requests, &req->link);
+		dlist_push_head(&shard->used_requests, &req->link);
 
 		/* Increase utilization. */
-		++urm->utilization;
+		++shard->utilization;
+		pg_atomic_fetch_add_u32(&urm->utilization, 1);
 
 		/* Initialize request object. */
 		Assert(req->d.status == UNDO_REQUEST_FREE);
@@ -373,15 +489,17 @@ RegisterUndoRequest(UndoRequestManager *urm, FullTransactionId fxid, Oid dbid)
 		req->d.start_location_unlogged = InvalidUndoRecPtr;
 		req->d.end_location_unlogged = InvalidUndoRecPtr;
 		req->retry_time = DT_NOBEGIN;
-
-		/* Save this fxid as the oldest one, if necessary. */
-		if (urm->oldest_fxid_valid &&
-			(!FullTransactionIdIsValid(urm->oldest_fxid)
-			 || FullTransactionIdPrecedes(fxid, urm->oldest_fxid)))
-			urm->oldest_fxid = fxid;
+		req->nfailures = 0;
+		req->quarantined = false;
+
+		/* Save this fxid as the shard's oldest one, if necessary. */
+		if (shard->oldest_fxid_valid &&
+			(!FullTransactionIdIsValid(shard->oldest_fxid)
+			 || FullTransactionIdPrecedes(fxid, shard->oldest_fxid)))
+			shard->oldest_fxid = fxid;
 	}
 
-	LWLockRelease(urm->lock);
+	LWLockRelease(&shard->lock);
 
 	return req;
 }
@@ -437,9 +555,11 @@ FinalizeUndoRequest(UndoRequestManager *urm, UndoRequest *req, Size size,
 
 	if (mark_as_ready)
 	{
-		LWLockAcquire(urm->lock, LW_EXCLUSIVE);
+		UndoRequestShard *shard = UndoRequestShardForFXID(urm, req->d.fxid);
+
+		LWLockAcquire(&shard->lock, LW_EXCLUSIVE);
 		req->d.status = UNDO_REQUEST_READY;
-		LWLockRelease(urm->lock);
+		LWLockRelease(&shard->lock);
 	}
 }
 
@@ -459,9 +579,12 @@ FinalizeUndoRequest(UndoRequestManager *urm, UndoRequest *req, Size size,
 void
 UnregisterUndoRequest(UndoRequestManager *urm, UndoRequest *req)
 {
+	UndoRequestShard *shard;
+
 	Assert(req->d.status != UNDO_REQUEST_FREE);
 
-	LWLockAcquire(urm->lock, LW_EXCLUSIVE);
+	shard = UndoRequestShardForFXID(urm, req->d.fxid);
+	LWLockAcquire(&shard->lock, LW_EXCLUSIVE);
 
 	/*
 	 * If we somehow get here with a request in the UNDO_REQUEST_WAITING state,
@@ -474,31 +597,34 @@ UnregisterUndoRequest(UndoRequestManager *urm, UndoRequest *req)
 		 * finalized and undo has subsequently failed.  If the size is 0, the
 		 * request has not been finalized yet, so it's not in any RBTree.
 		 */
-		if (req->retry_time != DT_NOBEGIN)
-			RemoveUndoRequest(&urm->requests_by_retry_time, req);
+		if (req->quarantined)
+			RemoveUndoRequest(&shard->requests_by_quarantine, req);
+		else if (req->retry_time != DT_NOBEGIN)
+			RemoveUndoRequest(&shard->requests_by_retry_time, req);
 		else if (req->d.size != 0)
 		{
-			RemoveUndoRequest(&urm->requests_by_fxid, req);
-			RemoveUndoRequest(&urm->requests_by_size, req);
+			RemoveUndoRequest(&shard->requests_by_fxid, req);
+			RemoveUndoRequest(&shard->requests_by_size, req);
 		}
 	}
 
-	/* Plan to recompute oldest_fxid, if necessary. */
-	if (FullTransactionIdEquals(req->d.fxid, urm->oldest_fxid))
-		urm->oldest_fxid_valid = false;
+	/* Plan to recompute the shard's oldest_fxid, if necessary. */
+	if (FullTransactionIdEquals(req->d.fxid, shard->oldest_fxid))
+		shard->oldest_fxid_valid = false;
 
 	/* Move to freelist. */
 	dlist_delete(&req->link);
-	dlist_push_head(&urm->free_requests, &req->link);
+	dlist_push_head(&shard->free_requests, &req->link);
 
 	/* Set status to FREE and clear FullTransactionId. */
 	req->d.status = UNDO_REQUEST_FREE;
 	req->d.fxid = InvalidFullTransactionId;
 
 	/* Decrease utilization. */
-	--urm->utilization;
+	--shard->utilization;
+	pg_atomic_fetch_sub_u32(&urm->utilization, 1);
 
-	LWLockRelease(urm->lock);
+	LWLockRelease(&shard->lock);
 }
 
 /*
@@ -527,6 +653,7 @@ UnregisterUndoRequest(UndoRequestManager *urm, UndoRequest *req)
 bool
 PerformUndoInBackground(UndoRequestManager *urm, UndoRequest *req, bool force)
 {
+	UndoRequestShard *shard;
 	bool		background;
 
 	Assert(req->d.status == UNDO_REQUEST_ALLOCATED ||
@@ -545,13 +672,14 @@ PerformUndoInBackground(UndoRequestManager *urm, UndoRequest *req, bool force)
 	}
 
 	/*
-	 * We need to check shared state in order to determine whether or not to
-	 * perform this undo in the background, and if we are going to perform it
-	 * in the background, also to add it to requests_by_fxid and
-	 * requests_by_size.
+	 * If we are going to perform this undo in the background, we must add the
+	 * request to the shard's requests_by_fxid and requests_by_size under the
+	 * shard lock.  The soft-limit check itself only needs the manager-wide
+	 * atomic utilization counter.
 	 */
-	LWLockAcquire(urm->lock, LW_EXCLUSIVE);
-	background = force || BackgroundUndoOK(urm, req);
+	shard = UndoRequestShardForFXID(urm, req->d.fxid);
+	LWLockAcquire(&shard->lock, LW_EXCLUSIVE);
+	background = force || BackgroundUndoOK(urm);
 	if (background)
 	{
 		/*
@@ -560,12 +688,12 @@ PerformUndoInBackground(UndoRequestManager *urm, UndoRequest *req, bool force)
 		 * can find it.
 		 */
 		req->d.status = UNDO_REQUEST_WAITING;
-		InsertUndoRequest(&urm->requests_by_fxid, req);
-		InsertUndoRequest(&urm->requests_by_size, req);
+		InsertUndoRequest(&shard->requests_by_fxid, req);
+		InsertUndoRequest(&shard->requests_by_size, req);
 	}
 	else
 		req->d.status = UNDO_REQUEST_IN_PROGRESS;
-	LWLockRelease(urm->lock);
+	LWLockRelease(&shard->lock);
 
 	return background;
 }
@@ -582,39 +710,110 @@ PerformUndoInBackground(UndoRequestManager *urm, UndoRequest *req, bool force)
 long
 UndoRequestWaitTime(UndoRequestManager *urm, TimestampTz when)
 {
-	UndoRequestNode *node;
-	long	result;
+	long		result = -1;
+	unsigned	s;
 
-	LWLockAcquire(urm->lock, LW_SHARED);
-	node = (UndoRequestNode *) rbt_leftmost(&urm->requests_by_fxid);
-	if (node != NULL)
+	for (s = 0; s < urm->nshards; ++s)
 	{
-		Assert(node->req->d.status == UNDO_REQUEST_WAITING);
-		result = 0;
-	}
-	else
-	{
-		node = (UndoRequestNode *) rbt_leftmost(&urm->requests_by_retry_time);
+		UndoRequestShard *shard = &urm->shards[s];
+		UndoRequestNode *node;
 
-		if (node == NULL)
-			result = -1;
+		LWLockAcquire(&shard->lock, LW_SHARED);
+		node = (UndoRequestNode *) rbt_leftmost(&shard->requests_by_fxid);
+		if (node != NULL)
+		{
+			Assert(node->req->d.status == UNDO_REQUEST_WAITING);
+			result = 0;
+		}
 		else
 		{
-			TimestampTz		retry_time = node->req->retry_time;
-			long	secs;
-			int		microsecs;
+			RBTree	   *retry_rbts[2] = {&shard->requests_by_retry_time,
+										 &shard->requests_by_quarantine};
+			int			i;
 
-			Assert(node->req->d.status == UNDO_REQUEST_WAITING);
-			TimestampDifference(when, retry_time, &secs, &microsecs);
-			result = (secs * 1000) + (microsecs / 1000);
-			Assert(result >= 0);
+			for (i = 0; i < lengthof(retry_rbts); ++i)
+			{
+				node = (UndoRequestNode *) rbt_leftmost(retry_rbts[i]);
+
+				if (node != NULL)
+				{
+					TimestampTz		retry_time = node->req->retry_time;
+					long	secs;
+					int		microsecs;
+					long	shard_result;
+
+					Assert(node->req->d.status == UNDO_REQUEST_WAITING);
+					TimestampDifference(when, retry_time, &secs, &microsecs);
+					shard_result = (secs * 1000) + (microsecs / 1000);
+					Assert(shard_result >= 0);
+					if (result < 0 || shard_result < result)
+						result = shard_result;
+				}
+			}
 		}
+		LWLockRelease(&shard->lock);
+
+		/* Can't do any better than "work available right now". */
+		if (result == 0)
+			break;
 	}
-	LWLockRelease(urm->lock);
 
 	return result;
 }
 
+/*
+ * Count the distinct databases that have at least one undo request which
+ * could be dispatched at time 'when', stopping once 'max_databases' have been
+ * found.  The undo launcher uses this to size a batch of worker launches, so
+ * there's no point in counting past the size of the worker pool.
+ *
+ * As with UndoRequestWaitTime, the answer can be stale by the time the caller
+ * acts on it; that just means launching slightly too many or too few workers,
+ * which is self-correcting.
+ */
+unsigned
+CountPendingUndoRequestDatabases(UndoRequestManager *urm, TimestampTz when,
+								 unsigned max_databases)
+{
+	Oid		   *dbids;
+	unsigned	ndbids = 0;
+	unsigned	s;
+	dlist_iter	iter;
+
+	if (max_databases == 0)
+		return 0;
+	dbids = palloc(max_databases * sizeof(Oid));
+
+	for (s = 0; s < urm->nshards && ndbids < max_databases; ++s)
+	{
+		UndoRequestShard *shard = &urm->shards[s];
+
+		LWLockAcquire(&shard->lock, LW_SHARED);
+		dlist_foreach(iter, &shard->used_requests)
+		{
+			UndoRequest *req = dlist_container(UndoRequest, link, iter.cur);
+			unsigned	i;
+
+			if (req->d.status != UNDO_REQUEST_WAITING)
+				continue;
+			if (req->retry_time != DT_NOBEGIN && req->retry_time > when)
+				continue;
+			for (i = 0; i < ndbids; ++i)
+				if (dbids[i] == req->d.dbid)
+					break;
+			if (i < ndbids)
+				continue;
+			dbids[ndbids++] = req->d.dbid;
+			if (ndbids >= max_databases)
+				break;
+		}
+		LWLockRelease(&shard->lock);
+	}
+
+	pfree(dbids);
+	return ndbids;
+}
+
 /*
  * Get an undo request that needs background processing.
  *
@@ -634,6 +833,12 @@ UndoRequestWaitTime(UndoRequestManager *urm, TimestampTz when)
  * happen that all of the fields get InvalidUndoRecPtr, because that would
  * mean we queued up an UndoRequest to do nothing.
  *
+ * We visit the shards one at a time, starting with a different shard on each
+ * call so that no shard is starved, and take the first suitable request we
+ * find; so the prioritization rules described in
+ * GetNextUndoRequestFromShard are exact only within a shard. Since those
+ * rules are heuristic to begin with, that seems acceptable.
+ *
  * This function, as a side effect, makes the returned UndoRequest IN_PROGRESS,
  * as defined above, so that no other backend will attempt to process it
  * simultaneously. The caller must be certain to call either
@@ -650,16 +855,96 @@ GetNextUndoRequest(UndoRequestManager *urm, Oid dbid,
 				   UndoRecPtr *end_location_unlogged)
 {
 	UndoRequest *req = NULL;
-	int			nloops;
 	bool		saw_db_mismatch = false;
+	unsigned	first_shard;
+	unsigned	s;
 
-	LWLockAcquire(urm->lock, LW_EXCLUSIVE);
+	first_shard = pg_atomic_fetch_add_u32(&urm->next_scan_shard, 1)
+		% urm->nshards;
+
+	for (s = 0; s < urm->nshards; ++s)
+	{
+		UndoRequestShard *shard =
+			&urm->shards[(first_shard + s) % urm->nshards];
+
+		LWLockAcquire(&shard->lock, LW_EXCLUSIVE);
+		req = GetNextUndoRequestFromShard(shard, dbid, &saw_db_mismatch);
+		if (req != NULL)
+		{
+			ExtractUndoRequest(shard, req);
+			LWLockRelease(&shard->lock);
+			break;
+		}
+		LWLockRelease(&shard->lock);
+	}
+
+	/*
+	 * Determine whether we should do a more exhaustive search.
+	 *
+	 * If we found a node, we don't need look any harder.  If we didn't see a
+	 * database mismatch, then looking harder can't help: there's nothing to
+	 * do at all, never mind for which database.  If the caller set
+	 * minimum_runtime_reached, then they don't want us to look harder.
+	 */
+	if (req == NULL && saw_db_mismatch && !minimum_runtime_reached)
+	{
+		for (s = 0; s < urm->nshards; ++s)
+		{
+			UndoRequestShard *shard =
+				&urm->shards[(first_shard + s) % urm->nshards];
+
+			LWLockAcquire(&shard->lock, LW_EXCLUSIVE);
+			req = FindUndoRequestForDatabase(shard, dbid);
+			if (req != NULL)
+			{
+				Assert(req->d.status == UNDO_REQUEST_WAITING);
+				ExtractUndoRequest(shard, req);
+				LWLockRelease(&shard->lock);
+				break;
+			}
+			LWLockRelease(&shard->lock);
+		}
+	}
+
+	/*
+	 * Set output parameters.  We own the request now, so it's safe to do this
+	 * without the lock.
+	 */
+	if (req == NULL)
+		*out_dbid = InvalidOid;
+	else
+	{
+		*out_dbid = req->d.dbid;
+		*fxid = req->d.fxid;
+		*start_location_logged = req->d.start_location_logged;
+		*end_location_logged = req->d.end_location_logged;
+		*start_location_unlogged = req->d.start_location_unlogged;
+		*end_location_unlogged = req->d.end_location_unlogged;
+	}
+
+	/* All done. */
+	return req;
+}
+
+/*
+ * Search one shard for an undo request in need of background processing.
+ *
+ * Caller must hold the shard's lock. *saw_db_mismatch is set to true if we
+ * skipped a request only because it belonged to some database other than
+ * 'dbid'; it is never reset to false here, so the caller can accumulate the
+ * flag across shards.
+ */
+static UndoRequest *
+GetNextUndoRequestFromShard(UndoRequestShard *shard, Oid dbid,
+							bool *saw_db_mismatch)
+{
+	int			nloops;
 
 	/* Some might have no work, so loop until all are checked. */
 	for (nloops = 0; nloops < 3; ++nloops)
 	{
 		RBTree	   *rbt = NULL;
-		UndoRequestSource source = urm->source;
+		UndoRequestSource source = shard->source;
 		UndoRequestNode *node;
 
 		/*
@@ -692,16 +977,16 @@ GetNextUndoRequest(UndoRequestManager *urm, Oid dbid,
 		switch (source)
 		{
 			case UNDO_SOURCE_FXID:
-				rbt = &urm->requests_by_fxid;
-				urm->source = UNDO_SOURCE_SIZE;
+				rbt = &shard->requests_by_fxid;
+				shard->source = UNDO_SOURCE_SIZE;
 				break;
 			case UNDO_SOURCE_SIZE:
-				rbt = &urm->requests_by_size;
-				urm->source = UNDO_SOURCE_RETRY_TIME;
+				rbt = &shard->requests_by_size;
+				shard->source = UNDO_SOURCE_RETRY_TIME;
 				break;
 			case UNDO_SOURCE_RETRY_TIME:
-				rbt = &urm->requests_by_retry_time;
-				urm->source = UNDO_SOURCE_FXID;
+				rbt = &shard->requests_by_retry_time;
+				shard->source = UNDO_SOURCE_FXID;
 				break;
 		}
 
@@ -727,65 +1012,54 @@ GetNextUndoRequest(UndoRequestManager *urm, Oid dbid,
 		 */
 		if (OidIsValid(dbid) && node->req->d.dbid != dbid)
 		{
-			saw_db_mismatch = true;
+			*saw_db_mismatch = true;
 			continue;
 		}
 
 		/* Looks like we have a winner. */
-		req = node->req;
-		break;
+		return node->req;
 	}
 
 	/*
-	 * Determine whether we should do a more exhaustive search.
-	 *
-	 * If we found a node, we don't need look any harder.  If we didn't see a
-	 * database mismatch, then looking harder can't help: there's nothing to
-	 * do at all, never mind for which database.  If the caller set
-	 * minimum_runtime_reached, then they don't want us to look harder.
+	 * No healthy request was suitable.  Glance at the quarantine RBTree, but
+	 * only take a request from it if the soonest quarantined retry time has
+	 * actually arrived; this is a single rbt_leftmost call, so persistently
+	 * failing requests cost next to nothing on the scans in between.
 	 */
-	if (req == NULL && saw_db_mismatch && !minimum_runtime_reached)
 	{
-		req = FindUndoRequestForDatabase(urm, dbid);
-		Assert(req->d.status == UNDO_REQUEST_WAITING);
-	}
+		UndoRequestNode *node;
 
-	/*
-	 * If we found a suitable request, remove it from any RBTree that contains
-	 * it, and adjust the status.
-	 */
-	if (req != NULL)
-	{
-		if (req->retry_time != DT_NOBEGIN)
-			RemoveUndoRequest(&urm->requests_by_retry_time, req);
-		else
+		node = (UndoRequestNode *)
+			rbt_leftmost(&shard->requests_by_quarantine);
+		if (node != NULL && node->req->retry_time <= GetCurrentTimestamp())
 		{
-			RemoveUndoRequest(&urm->requests_by_fxid, req);
-			RemoveUndoRequest(&urm->requests_by_size, req);
+			Assert(node->req->d.status == UNDO_REQUEST_WAITING);
+			if (!OidIsValid(dbid) || node->req->d.dbid == dbid)
+				return node->req;
+			*saw_db_mismatch = true;
 		}
-		req->d.status = UNDO_REQUEST_IN_PROGRESS;
 	}
 
-	LWLockRelease(urm->lock);
+	return NULL;
+}
 
-	/*
-	 * Set output parameters.  We own the request now, so it's safe to do this
-	 * without the lock.
-	 */
-	if (req == NULL)
-		*out_dbid = InvalidOid;
+/*
+ * Remove a WAITING request from whatever RBTrees contain it and mark it
+ * IN_PROGRESS.  Caller must hold the shard's lock.
+ */
+static void
+ExtractUndoRequest(UndoRequestShard *shard, UndoRequest *req)
+{
+	if (req->quarantined)
+		RemoveUndoRequest(&shard->requests_by_quarantine, req);
+	else if (req->retry_time != DT_NOBEGIN)
+		RemoveUndoRequest(&shard->requests_by_retry_time, req);
 	else
 	{
-		*out_dbid = req->d.dbid;
-		*fxid = req->d.fxid;
-		*start_location_logged = req->d.start_location_logged;
-		*end_location_logged = req->d.end_location_logged;
-		*start_location_unlogged = req->d.start_location_unlogged;
-		*end_location_unlogged = req->d.end_location_unlogged;
+		RemoveUndoRequest(&shard->requests_by_fxid, req);
+		RemoveUndoRequest(&shard->requests_by_size, req);
 	}
-
-	/* All done. */
-	return req;
+	req->d.status = UNDO_REQUEST_IN_PROGRESS;
 }
 
 /*
@@ -814,26 +1088,45 @@ GetNextUndoRequest(UndoRequestManager *urm, Oid dbid,
 void
 RescheduleUndoRequest(UndoRequestManager *urm, UndoRequest *req)
 {
-	LWLockAcquire(urm->lock, LW_EXCLUSIVE);
+	UndoRequestShard *shard = UndoRequestShardForFXID(urm, req->d.fxid);
+
+	long		delay_ms;
+
+	LWLockAcquire(&shard->lock, LW_EXCLUSIVE);
 	Assert(req->d.status == UNDO_REQUEST_IN_PROGRESS);
 
 	/*
-	 * This algorithm for determining the next retry time is fairly
-	 * unsophisticated: the first retry happens after 10 seconds, and each
-	 * subsequent retry after 30 seconds. We could do something more
-	 * complicated here, but we'd need to do more bookkeeping and it's unclear
-	 * what we'd gain.
+	 * Back off exponentially: each failure doubles the delay before the next
+	 * retry, up to UNDO_REQUEST_MAX_RETRY_MS.  A failure that's going to
+	 * repeat -- a missing tablespace, say -- thus quickly stops soaking up
+	 * undo worker capacity, while a transient failure still gets retried
+	 * promptly.  (We'd prefer to distinguish the two cases directly from the
+	 * error, but by the time this is reached during abort processing the
+	 * error state has already been flushed, so the failure count is the best
+	 * evidence we have.)
 	 */
-	if (req->retry_time == DT_NOBEGIN)
-		req->retry_time =
-			TimestampTzPlusMilliseconds(GetCurrentTimestamp(), 10 * 1000);
+	++req->nfailures;
+	if (req->nfailures >= UNDO_REQUEST_RETRY_BUDGET)
+		delay_ms = UNDO_REQUEST_MAX_RETRY_MS;
 	else
-		req->retry_time =
-			TimestampTzPlusMilliseconds(GetCurrentTimestamp(), 30 * 1000);
+		delay_ms = Min(UNDO_REQUEST_INITIAL_RETRY_MS << (req->nfailures - 1),
+					   UNDO_REQUEST_MAX_RETRY_MS);
+	req->retry_time =
+		TimestampTzPlusMilliseconds(GetCurrentTimestamp(), delay_ms);
 
-	InsertUndoRequest(&urm->requests_by_retry_time, req);
+	/*
+	 * Once the retry budget is exhausted, move the request to the quarantine
+	 * RBTree, where it no longer participates in the source rotation in
+	 * GetNextUndoRequestFromShard and is only considered once its (long)
+	 * retry delay has elapsed.
+	 */
+	req->quarantined = (req->nfailures >= UNDO_REQUEST_RETRY_BUDGET);
+	if (req->quarantined)
+		InsertUndoRequest(&shard->requests_by_quarantine, req);
+	else
+		InsertUndoRequest(&shard->requests_by_retry_time, req);
 	req->d.status = UNDO_REQUEST_WAITING;
-	LWLockRelease(urm->lock);
+	LWLockRelease(&shard->lock);
 }
 
 /*
@@ -846,6 +1139,15 @@ RescheduleUndoRequest(UndoRequestManager *urm, UndoRequest *req)
  * ALLOCATED request doesn't necessarily contain fully valid data yet, and a
  * FREE request certainly doesn't.
  *
+ * We visit one shard at a time, so that a large, busy request table never
+ * has every shard locked at once during a checkpoint.  Each saved request
+ * only needs to be individually valid at some moment after the checkpoint's
+ * redo point: a request registered or completed while we're scanning other
+ * shards is covered by WAL replay, which begins at the redo point and
+ * re-creates or finishes it as required.  There are no cross-request
+ * invariants in the serialized data, so a shard-at-a-time snapshot is as
+ * good as a global one.
+ *
  * The return value is a pointer to the serialized data; *nbytes is set to
  * the length of that data. The serialized data is allocated in the current
  * memory context and the caller may free it using pfree if desired.
@@ -854,59 +1156,59 @@ char *
 SerializeUndoRequestData(UndoRequestManager *urm, Size *nbytes)
 {
 	UndoRequestData *darray;
-	int		nrequests = 0;
-	int		i = 0;
+	Size		capacity;
+	Size		nrequests = 0;
+	unsigned	s;
 	dlist_iter	iter;
 
-	LWLockAcquire(urm->lock, LW_EXCLUSIVE);
+	/*
+	 * Size the buffer from the manager-wide utilization counter.  It can
+	 * move while we scan, so individual shards may have grown by the time we
+	 * reach them; we enlarge as required below.
+	 */
+	capacity = pg_atomic_read_u32(&urm->utilization);
+	darray = palloc(sizeof(UndoRequestData) * Max(capacity, 1));
 
-	/* Exit quickly if there are no requests at all. */
-	if (urm->utilization == 0)
+	for (s = 0; s < urm->nshards; ++s)
 	{
-		*nbytes = 0;
-		LWLockRelease(urm->lock);
-		return NULL;
-	}
+		UndoRequestShard *shard = &urm->shards[s];
 
-	/* Count the number of requests in interesting states. */
-	dlist_foreach(iter, &urm->used_requests)
-	{
-		UndoRequest *req = dlist_container(UndoRequest, link, iter.cur);
+		LWLockAcquire(&shard->lock, LW_SHARED);
 
-		Assert(req->d.status != UNDO_REQUEST_FREE);
-		if (req->d.status == UNDO_REQUEST_READY ||
-			req->d.status == UNDO_REQUEST_WAITING ||
-			req->d.status == UNDO_REQUEST_IN_PROGRESS)
-			++nrequests;
-	}
+		if (shard->utilization == 0)
+		{
+			LWLockRelease(&shard->lock);
+			continue;
+		}
 
-	/* Exit quickly if we didn't find any requests in the right state. */
-	if (nrequests == 0)
-	{
-		*nbytes = 0;
-		LWLockRelease(urm->lock);
-		return NULL;
-	}
+		/* Make sure there's room for every request in this shard. */
+		if (nrequests + shard->utilization > capacity)
+		{
+			capacity = nrequests + shard->utilization;
+			darray = repalloc(darray, sizeof(UndoRequestData) * capacity);
+		}
 
-	/* Allocate memory. */
-	*nbytes = sizeof(UndoRequestData) * nrequests;
-	darray = palloc(*nbytes);
+		dlist_foreach(iter, &shard->used_requests)
+		{
+			UndoRequest *req = dlist_container(UndoRequest, link, iter.cur);
 
-	/* Save requests. */
-	dlist_foreach(iter, &urm->used_requests)
-	{
-		UndoRequest *req = dlist_container(UndoRequest, link, iter.cur);
+			Assert(req->d.status != UNDO_REQUEST_FREE);
+			if (req->d.status == UNDO_REQUEST_READY ||
+				req->d.status == UNDO_REQUEST_WAITING ||
+				req->d.status == UNDO_REQUEST_IN_PROGRESS)
+				memcpy(&darray[nrequests++], &req->d,
+					   sizeof(UndoRequestData));
+		}
 
-		Assert(req->d.status != UNDO_REQUEST_FREE);
-		if (req->d.status == UNDO_REQUEST_READY ||
-			req->d.status == UNDO_REQUEST_WAITING ||
-			req->d.status == UNDO_REQUEST_IN_PROGRESS)
-			memcpy(&darray[i++], &req->d, sizeof(UndoRequestData));
+		LWLockRelease(&shard->lock);
 	}
-	Assert(i == nrequests);
 
-	/* All done. */
-	LWLockRelease(urm->lock);
+	*nbytes = sizeof(UndoRequestData) * nrequests;
+	if (nrequests == 0)
+	{
+		pfree(darray);
+		darray = NULL;
+	}
 	return (char *) darray;
 }
 
@@ -933,29 +1235,44 @@ RestoreUndoRequestData(UndoRequestManager *urm, Size nbytes, char *data)
 						   nrequests, urm->capacity),
 				 errhint("Consider increasing max_connctions.")));
 
-	/* Now we acquire the lock. */
-	LWLockAcquire(urm->lock, LW_EXCLUSIVE);
-
 	for (i = 0; i < nrequests; ++i)
 	{
 		UndoRequestData	   *d = &darray[i];
+		UndoRequestShard   *shard;
 		UndoRequest		   *req;
 		dlist_node *dnode;
 
-		/* Allocate a request. */
-		Assert(!dlist_is_empty(&urm->free_requests));
-		dnode = dlist_pop_head_node(&urm->free_requests);
-		req = dlist_container(UndoRequest, link, dnode);
-		dlist_push_head(&urm->used_requests, &req->link);
-
-		/* Increase utilization. */
-		++urm->utilization;
-
 		/* Sanity checks. */
 		Assert(FullTransactionIdIsValid(d->fxid));
 		Assert(OidIsValid(d->dbid));
 		Assert(d->size != 0);
 
+		shard = UndoRequestShardForFXID(urm, d->fxid);
+		LWLockAcquire(&shard->lock, LW_EXCLUSIVE);
+
+		/*
+		 * Allocate a request.  The shard is chosen by FXID hash, exactly as
+		 * it was when the request was first registered, so unless the shard
+		 * geometry has changed across the restart, the shard can't be full.
+		 * If the geometry did change (different max_connections, say), it is
+		 * remotely possible for a shard to overflow even though the total
+		 * capacity check above passed; there's nothing sensible we can do
+		 * about that except complain.
+		 */
+		if (dlist_is_empty(&shard->free_requests))
+			ereport(ERROR,
+					(errmsg("too many undo requests"),
+					 errdetail("There is no free space left in the undo request shard for transaction %u.",
+							   XidFromFullTransactionId(d->fxid)),
+					 errhint("Consider increasing max_connctions.")));
+		dnode = dlist_pop_head_node(&shard->free_requests);
+		req = dlist_container(UndoRequest, link, dnode);
+		dlist_push_head(&shard->used_requests, &req->link);
+
+		/* Increase utilization. */
+		++shard->utilization;
+		pg_atomic_fetch_add_u32(&urm->utilization, 1);
+
 		/*
 		 * Populate request data and add to RBTrees.
 		 *
@@ -975,40 +1292,44 @@ RestoreUndoRequestData(UndoRequestManager *urm, Size nbytes, char *data)
 		 */
 		memcpy(&req->d, d, sizeof(UndoRequestData));
 		req->retry_time = DT_NOBEGIN;
+		req->nfailures = 0;
+		req->quarantined = false;
 		switch (req->d.status)
 		{
 			case UNDO_REQUEST_WAITING:
 			case UNDO_REQUEST_IN_PROGRESS:
 				req->d.status = UNDO_REQUEST_WAITING;
-				InsertUndoRequest(&urm->requests_by_fxid, req);
-				InsertUndoRequest(&urm->requests_by_size, req);
+				InsertUndoRequest(&shard->requests_by_fxid, req);
+				InsertUndoRequest(&shard->requests_by_size, req);
 				break;
 			case UNDO_REQUEST_READY:
 				break;
 			default:
 				/* Don't just Assert(), in case on-disk state is corrupt. */
+				LWLockRelease(&shard->lock);
 				elog(ERROR, "undo request state %d is not valid",
 					 (int) req->d.status);
 				break;
 		}
-	}
 
-	/* All done. */
-	LWLockRelease(urm->lock);
+		LWLockRelease(&shard->lock);
+	}
 }
 
 /*
  * Find the undo request for a given FXID, if there is one.
  *
  * This isn't very efficient, so use it sparingly. If necessary, we could
- * add a more efficient lookup method.
+ * add a more efficient lookup method.  At least we only need to search the
+ * one shard that the FXID hashes to.
  */
 UndoRequest *
 FindUndoRequestByFXID(UndoRequestManager *urm, FullTransactionId fxid)
 {
+	UndoRequestShard *shard = UndoRequestShardForFXID(urm, fxid);
 	dlist_iter	iter;
 
-	dlist_foreach(iter, &urm->used_requests)
+	dlist_foreach(iter, &shard->used_requests)
 	{
 		UndoRequest *req = dlist_container(UndoRequest, link, iter.cur);
 
@@ -1114,30 +1435,47 @@ MakeUndoRequestDataTuple(TupleDesc tupdesc, UndoRequestData *d,
 
 /*
  * Make a copy of every UndoRequestData currently in use.
+ *
+ * Unlike SerializeUndoRequestData(), we hold all the shard locks at once so
+ * that the copy is a consistent snapshot. This is a monitoring function, so
+ * it shouldn't be called often enough for that to hurt.
  */
 unsigned
 SnapshotActiveUndoRequests(UndoRequestManager *urm, UndoRequestData **darrayp)
 {
-	unsigned	nrequests;
+	unsigned	nrequests = 0;
+	unsigned	s;
 	UndoRequestData *darray = NULL;
 
-	LWLockAcquire(urm->lock, LW_EXCLUSIVE);
-	nrequests = urm->utilization;
+	for (s = 0; s < urm->nshards; ++s)
+		LWLockAcquire(&urm->shards[s].lock, LW_EXCLUSIVE);
+
+	for (s = 0; s < urm->nshards; ++s)
+		nrequests += urm->shards[s].utilization;
+
 	if (nrequests != 0)
 	{
 		dlist_iter	iter;
 		int			i = 0;
 
 		darray = palloc(sizeof(UndoRequestData) * nrequests);
-		dlist_foreach(iter, &urm->used_requests)
+		for (s = 0; s < urm->nshards; ++s)
 		{
-			UndoRequest *req = dlist_container(UndoRequest, link, iter.cur);
+			UndoRequestShard *shard = &urm->shards[s];
+
+			dlist_foreach(iter, &shard->used_requests)
+			{
+				UndoRequest *req =
+					dlist_container(UndoRequest, link, iter.cur);
 
-			memcpy(&darray[i++], &req->d, sizeof(UndoRequestData));
+				memcpy(&darray[i++], &req->d, sizeof(UndoRequestData));
+			}
 		}
 		Assert(i == nrequests);
 	}
-	LWLockRelease(urm->lock);
+
+	for (s = 0; s < urm->nshards; ++s)
+		LWLockRelease(&urm->shards[s].lock);
 
 	*darrayp = darray;
 	return nrequests;
@@ -1158,13 +1496,14 @@ bool
 UndoRequestExists(UndoRequestManager *urm, FullTransactionId fxid,
 				  bool *is_failed_request)
 {
+	UndoRequestShard *shard = UndoRequestShardForFXID(urm, fxid);
 	dlist_iter	iter;
 	bool		result = false;
 
 	*is_failed_request = false;
 
-	LWLockAcquire(urm->lock, LW_EXCLUSIVE);
-	dlist_foreach(iter, &urm->used_requests)
+	LWLockAcquire(&shard->lock, LW_EXCLUSIVE);
+	dlist_foreach(iter, &shard->used_requests)
 	{
 		UndoRequest *req = dlist_container(UndoRequest, link, iter.cur);
 
@@ -1178,7 +1517,7 @@ UndoRequestExists(UndoRequestManager *urm, FullTransactionId fxid,
 			break;
 		}
 	}
-	LWLockRelease(urm->lock);
+	LWLockRelease(&shard->lock);
 
 	return result;
 }
@@ -1186,63 +1525,83 @@ UndoRequestExists(UndoRequestManager *urm, FullTransactionId fxid,
 /*
  * Get oldest registered FXID, whether LISTED or UNLISTED (as defined above).
  *
- * We cache the result of this computation so as to avoid repeating it too
- * often.
+ * Each shard caches the result of its part of this computation so as to
+ * avoid repeating it too often.
  */
 FullTransactionId
 UndoRequestManagerOldestFXID(UndoRequestManager *urm)
 {
 	FullTransactionId result = InvalidFullTransactionId;
+	unsigned	s;
 
-	LWLockAcquire(urm->lock, LW_EXCLUSIVE);
-
-	if (urm->oldest_fxid_valid)
-		result = urm->oldest_fxid;
-	else
+	for (s = 0; s < urm->nshards; ++s)
 	{
-		dlist_iter	iter;
+		UndoRequestShard *shard = &urm->shards[s];
+		FullTransactionId shard_oldest;
 
-		dlist_foreach(iter, &urm->used_requests)
+		LWLockAcquire(&shard->lock, LW_EXCLUSIVE);
+
+		if (shard->oldest_fxid_valid)
+			shard_oldest = shard->oldest_fxid;
+		else
 		{
-			UndoRequest *req = dlist_container(UndoRequest, link, iter.cur);
+			dlist_iter	iter;
 
-			Assert(req->d.status != UNDO_REQUEST_FREE);
-			Assert(FullTransactionIdIsValid(req->d.fxid));
+			shard_oldest = InvalidFullTransactionId;
+			dlist_foreach(iter, &shard->used_requests)
+			{
+				UndoRequest *req =
+					dlist_container(UndoRequest, link, iter.cur);
+
+				Assert(req->d.status != UNDO_REQUEST_FREE);
+				Assert(FullTransactionIdIsValid(req->d.fxid));
+
+				if (!FullTransactionIdIsValid(shard_oldest) ||
+					FullTransactionIdPrecedes(req->d.fxid, shard_oldest))
+					shard_oldest = req->d.fxid;
+			}
 
-			if (!FullTransactionIdIsValid(result) ||
-				FullTransactionIdPrecedes(req->d.fxid, result))
-				result = req->d.fxid;
+			shard->oldest_fxid = shard_oldest;
+			shard->oldest_fxid_valid = true;
 		}
 
-		urm->oldest_fxid = result;
-		urm->oldest_fxid_valid = true;
-	}
+		LWLockRelease(&shard->lock);
 
-	LWLockRelease(urm->lock);
+		if (FullTransactionIdIsValid(shard_oldest) &&
+			(!FullTransactionIdIsValid(result) ||
+			 FullTransactionIdPrecedes(shard_oldest, result)))
+			result = shard_oldest;
+	}
 
 	return result;
 }
 
 /*
- * Perform a left-to-right search of all three RBTrees, looking for a request
- * for a given database. The searches are interleaved so that we latch
- * onto the highest-priority request in any RBTree.
+ * Perform a left-to-right search of a shard's three RBTrees, looking for a
+ * request for a given database. The searches are interleaved so that we latch
+ * onto the highest-priority request in any RBTree.  Caller must hold the
+ * shard's lock.
  *
  * It's possible that we should have some kind of limit on this search, so
  * that it doesn't do an exhaustive search of every RBTree. However, it's not
  * exactly clear how that would affect the behavior, or how to pick a
  * reasonable limit.
+ *
+ * We deliberately don't search requests_by_quarantine here: a quarantined
+ * request's long retry delay would be defeated if any worker connected to
+ * the right database could pick it up early.  Such requests are dispatched
+ * only by GetNextUndoRequestFromShard, once their retry time has arrived.
  */
 static UndoRequest *
-FindUndoRequestForDatabase(UndoRequestManager *urm, Oid dbid)
+FindUndoRequestForDatabase(UndoRequestShard *shard, Oid dbid)
 {
 	RBTreeIterator iter[3];
 	int			doneflags = 0;
 	int			i = 0;
 
-	rbt_begin_iterate(&urm->requests_by_fxid, LeftRightWalk, &iter[0]);
-	rbt_begin_iterate(&urm->requests_by_size, LeftRightWalk, &iter[1]);
-	rbt_begin_iterate(&urm->requests_by_retry_time, LeftRightWalk, &iter[2]);
+	rbt_begin_iterate(&shard->requests_by_fxid, LeftRightWalk, &iter[0]);
+	rbt_begin_iterate(&shard->requests_by_size, LeftRightWalk, &iter[1]);
+	rbt_begin_iterate(&shard->requests_by_retry_time, LeftRightWalk, &iter[2]);
 
 	while (1)
 	{
@@ -1267,10 +1626,10 @@ FindUndoRequestForDatabase(UndoRequestManager *urm, Oid dbid)
 }
 
 /*
- * Is it OK to handle this UndoRequest in the background?
+ * Is it OK to handle an UndoRequest in the background?
  */
 static bool
-BackgroundUndoOK(UndoRequestManager *urm, UndoRequest *req)
+BackgroundUndoOK(UndoRequestManager *urm)
 {
 	if (undo_force_foreground)
 		return false;
@@ -1278,7 +1637,7 @@ BackgroundUndoOK(UndoRequestManager *urm, UndoRequest *req)
 	/*
 	 * If we've passed the soft size limit, it's not OK to background it.
 	 */
-	if (urm->utilization > urm->soft_size_limit)
+	if (pg_atomic_read_u32(&urm->utilization) > urm->soft_size_limit)
 		return false;
 
 	/*
@@ -1298,13 +1657,14 @@ BackgroundUndoOK(UndoRequestManager *urm, UndoRequest *req)
 static RBTNode *
 UndoRequestNodeAllocate(void *arg)
 {
-	UndoRequestManager *urm = arg;
-	UndoRequestNode *node = urm->first_free_request_node;
+	UndoRequestShard *shard = arg;
+	UndoRequestNode *node = shard->first_free_request_node;
 
 	/*
 	 * Any LISTED UndoRequest should either be in both requests_by_fxid and
-	 * requests_by_size, or it should be in requests_by_retry_time, or it
-	 * should be in neither RBTree; consequently, it should be impossible to
+	 * requests_by_size, or it should be in exactly one of
+	 * requests_by_retry_time and requests_by_quarantine, or it should be in
+	 * no RBTree at all; consequently, it should be impossible to
 	 * use more than 2 UndoRequestNode objects per UndoRequest. Since we
 	 * preallocate that number, we should never run out. In case there's a bug
 	 * in the logic, let's insert a runtime check here even when Asserts are
@@ -1314,7 +1674,7 @@ UndoRequestNodeAllocate(void *arg)
 		elog(ERROR, "no free UndoRequestNode");
 
 	/* Pop freelist. */
-	urm->first_free_request_node = *(UndoRequestNode **) node;
+	shard->first_free_request_node = *(UndoRequestNode **) node;
 
 	return &node->rbtnode;
 }
@@ -1327,11 +1687,11 @@ UndoRequestNodeAllocate(void *arg)
 static void
 UndoRequestNodeFree(RBTNode *x, void *arg)
 {
-	UndoRequestManager *urm = arg;
+	UndoRequestShard *shard = arg;
 	UndoRequestNode *node = (UndoRequestNode *) x;
 
-	*(UndoRequestNode **) node = urm->first_free_request_node;
-	urm->first_free_request_node = node;
+	*(UndoRequestNode **) node = shard->first_free_request_node;
+	shard->first_free_request_node = node;
 }
 
 /*
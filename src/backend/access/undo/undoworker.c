@@ -13,15 +13,21 @@
 
 #include "postgres.h"
 
+#include "access/htup_details.h"
+#include "access/undolog.h"
 #include "access/undoworker.h"
 #include "access/xact.h"
 #include "access/xactundo.h"
+#include "funcapi.h"
 #include "miscadmin.h"
 #include "pgstat.h"
+#include "port/atomics.h"
 #include "postmaster/bgworker.h"
 #include "storage/ipc.h"
 #include "storage/latch.h"
 #include "tcop/tcopprot.h"
+#include "utils/builtins.h"
+#include "utils/resowner.h"
 #include "utils/timestamp.h"
 
 /*
@@ -51,9 +57,16 @@
  * normal periods due to low system activity. If it's true, a backend can set
  * the undo launcher's latch and then change it to false.
  *
- * There's no locking around anything in this structure, so it's possible that
- * a signal intended to wake up the undo launcher could be sent to some other
- * process by mistake, or that we could be working with a stale value of
+ * 'pid' is the undo launcher's PID, or 0 if it has never started.  Like
+ * 'pgprocno', it can be stale if the launcher died.  It is only used for
+ * monitoring, via pg_stat_undo_workers.
+ *
+ * 'workers_launched' counts the undo apply workers launched since startup.
+ * Only the launcher updates it, but other backends read it, so it's atomic.
+ *
+ * There's no locking around anything else in this structure, so it's possible
+ * that a signal intended to wake up the undo launcher could be sent to some
+ * other process by mistake, or that we could be working with a stale value of
  * 'hibernate'. But even if a race occurs here, which should be rare, the
  * worst case scenario should be that we'll try to launch the next undo worker
  * after 1 minute rather than after the configured value of undo_naptime, which
@@ -62,12 +75,14 @@
 typedef struct
 {
 	int			pgprocno;
+	pid_t		pid;
 	bool		hibernate;
+	pg_atomic_uint64 workers_launched;
 } UndoLauncherData;
 
 static long TimestampDifferenceInMilliseconds(TimestampTz older_ts,
 											  TimestampTz newer_ts);
-static void UndoLaunchWorker(void);
+static bool UndoLaunchWorker(void);
 
 /* Shared memory state. */
 UndoLauncherData *UndoLauncher;
@@ -97,7 +112,10 @@ UndoWorkerShmemInit(void)
 		ShmemInitStruct("UndoLauncher", sizeof(UndoLauncherData), &found);
 
 	if (!found)
+	{
 		memset(UndoLauncher, 0, sizeof(UndoLauncherData));
+		pg_atomic_init_u64(&UndoLauncher->workers_launched, 0);
+	}
 }
 
 /*
@@ -144,6 +162,22 @@ DisturbUndoLauncherHibernation(void)
 	}
 }
 
+/*
+ * Wake the undo launcher unconditionally.
+ *
+ * This is used by an exiting undo worker that has noticed dispatchable work
+ * for some other database, so that the launcher can start a replacement
+ * worker right away instead of at the next naptime expiry.  The same caveats
+ * as for DisturbUndoLauncherHibernation apply: we might poke the wrong
+ * process, which is harmless.
+ */
+void
+WakeUndoLauncher(void)
+{
+	UndoLauncher->hibernate = false;
+	SetLatch(&ProcGlobal->allProcs[UndoLauncher->pgprocno].procLatch);
+}
+
 /*
  * Entry point and main loop for the undo launcher process.
  */
@@ -161,8 +195,15 @@ UndoLauncherMain(Datum main_arg)
 	pqsignal(SIGTERM, die);
 	BackgroundWorkerUnblockSignals();
 
-	/* Advertise our pgprocno. */
+	/* Advertise our pgprocno and PID. */
 	UndoLauncher->pgprocno = MyProc->pgprocno;
+	UndoLauncher->pid = MyProcPid;
+
+	/*
+	 * Establish a resource owner, since compressing undo segments may need
+	 * to pin buffers while writing them back.
+	 */
+	CurrentResourceOwner = ResourceOwnerCreate(NULL, "undo launcher");
 
 	/*
 	 * Set up the initial state so that it looks as though undo_naptime has
@@ -191,6 +232,27 @@ UndoLauncherMain(Datum main_arg)
 			ProcessConfigFile(PGC_SIGHUP);
 		}
 
+		/*
+		 * Top up the pool of pre-zeroed spare undo segments, so that
+		 * foreground transactions extending an undo log can claim one
+		 * cheaply instead of zero-filling a segment themselves.
+		 */
+		UndoLogMaintainSpareSegments();
+
+		/*
+		 * Catch up with the expensive part of undo log discarding:
+		 * invalidate buffers in discarded ranges and unlink or recycle
+		 * segment files, which UndoDiscard() leaves to us so that it never
+		 * stalls foreground transactions.
+		 */
+		UndoLogBackgroundReclaim();
+
+		/*
+		 * Replace closed, no-longer-modifiable undo segment files with
+		 * compressed copies, if undo_compress_segments is enabled.
+		 */
+		UndoLogCompressSegments();
+
 		/*
 		 * Get the current time.
 		 */
@@ -249,9 +311,27 @@ UndoLauncherMain(Datum main_arg)
 			timeout = XactUndoWaitTime(now);
 			if (timeout == 0)
 			{
-				/* There's work available now - launch a worker! */
-				elog(DEBUG4, "undo launcher starting worker");
-				UndoLaunchWorker();
+				unsigned	nworkers;
+
+				/*
+				 * There's work available now.  Launch one worker per database
+				 * with dispatchable requests, up to the size of the pool;
+				 * workers bind to a database for their lifetime, so a single
+				 * worker can't drain the backlogs of several databases, and
+				 * launching one worker per cycle would leave the rest of the
+				 * pool idle while one database with a huge rollback hogs the
+				 * only worker.  If the pool is already full, UndoLaunchWorker
+				 * fails and we stop early; slots will be nudged toward
+				 * backlogged databases as their current owners exit.
+				 */
+				nworkers = XactUndoPendingDatabases(now,
+													(unsigned) max_undo_workers);
+				elog(DEBUG4, "undo launcher starting %u worker(s)", nworkers);
+				while (nworkers-- > 0)
+				{
+					if (!UndoLaunchWorker())
+						break;
+				}
 
 				/* Prepare for next cycle. */
 				last_launch_time = sleep_until_time;
@@ -320,8 +400,12 @@ UndoLauncherMain(Datum main_arg)
  * trying to start workers so long as there seems to be work to do, and it
  * hopes (without really caring) that those workers get something useful
  * done.
+ *
+ * The return value is false if the worker could not even be registered,
+ * which in practice means that the pool is already at max_undo_workers;
+ * the caller can use that to stop launching a batch early.
  */
-static void
+static bool
 UndoLaunchWorker(void)
 {
 	BackgroundWorker bgw;
@@ -337,7 +421,10 @@ UndoLaunchWorker(void)
 	snprintf(bgw.bgw_type, BGW_MAXLEN, "undo worker");
 	bgw.bgw_restart_time = BGW_NEVER_RESTART;
 
-	RegisterDynamicBackgroundWorker(&bgw, NULL);
+	if (!RegisterDynamicBackgroundWorker(&bgw, NULL))
+		return false;
+	pg_atomic_fetch_add_u64(&UndoLauncher->workers_launched, 1);
+	return true;
 }
 
 /*
@@ -374,7 +461,20 @@ UndoWorkerMain(Datum main_arg)
 		/* Try to acquire an undo request for processing. */
 		dbid = InitializeBackgroundXactUndo(minimum_runtime_reached);
 		if (!OidIsValid(dbid))
+		{
+			/*
+			 * No request for our database.  A worker can't switch databases
+			 * within its lifetime, so the way work migrates between databases
+			 * is for us to give our pool slot back and for the launcher to
+			 * start a replacement connected to the right database.  If
+			 * something is dispatchable right now -- necessarily for another
+			 * database, or we'd have taken it -- wake the launcher so that
+			 * happens immediately rather than at the next naptime expiry.
+			 */
+			if (XactUndoWaitTime(GetCurrentTimestamp()) == 0)
+				WakeUndoLauncher();
 			break;
+		}
 
 		/*
 		 * If this is the first undo request we've acquired, we need to
@@ -426,6 +526,48 @@ UndoWorkerMain(Datum main_arg)
 	proc_exit(0);
 }
 
+/*
+ * Produce the single row of the pg_stat_undo_workers view: the state of the
+ * undo launcher, plus the subsystem-wide activity counters maintained by
+ * undolog.c.
+ */
+Datum
+pg_stat_get_undo_workers(PG_FUNCTION_ARGS)
+{
+#define PG_STAT_GET_UNDO_WORKERS_COLS 11
+	TupleDesc	tupdesc;
+	Datum		values[PG_STAT_GET_UNDO_WORKERS_COLS];
+	bool		nulls[PG_STAT_GET_UNDO_WORKERS_COLS] = { false };
+	UndoLogStatsData stats;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	/*
+	 * The launcher data isn't protected by any lock; see the comments on
+	 * UndoLauncherData.  Stale values here are tolerable.
+	 */
+	if (UndoLauncher->pid == 0)
+		nulls[0] = true;
+	else
+		values[0] = Int32GetDatum((int32) UndoLauncher->pid);
+	values[1] = BoolGetDatum(UndoLauncher->hibernate);
+	values[2] = Int64GetDatum(
+		(int64) pg_atomic_read_u64(&UndoLauncher->workers_launched));
+
+	UndoLogGetStats(&stats);
+	values[3] = Int64GetDatum((int64) stats.records_inserted);
+	values[4] = Int64GetDatum((int64) stats.bytes_inserted);
+	values[5] = Int64GetDatum((int64) stats.bytes_discarded);
+	values[6] = Int64GetDatum((int64) stats.segments_created);
+	values[7] = Int64GetDatum((int64) stats.spare_segments_claimed);
+	values[8] = Int64GetDatum((int64) stats.segments_recycled);
+	values[9] = Int64GetDatum((int64) stats.buffers_reclaimed);
+	values[10] = Int64GetDatum((int64) stats.reclaim_passes);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
 /*
  * Subtract two timestamps and convert the result to milliseconds.
  *
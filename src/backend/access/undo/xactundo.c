@@ -48,6 +48,7 @@
 #include "access/xactundo.h"
 #include "funcapi.h"
 #include "miscadmin.h"
+#include "storage/bufmgr.h"
 #include "storage/ipc.h"
 #include "storage/shmem.h"
 #include "utils/builtins.h"
@@ -84,6 +85,16 @@
  */
 #define UNDO_SOFT_LIMIT_MULTIPLIER		0.85
 
+/*
+ * When applying undo for a large rollback, we partition the record set's
+ * byte range into chunks of at most this many usable bytes, so that the
+ * chunks can eventually be handed out to multiple undo apply workers.  The
+ * actual apply machinery is not implemented yet, but the partitioning is
+ * done here so that the work distribution policy can be tested and so that
+ * the apply code can be written against per-chunk ranges from the start.
+ */
+#define UNDO_APPLY_CHUNK_SIZE	(8 * 1024 * 1024)
+
 static void
 SerializeUndoData(StringInfo buf, UndoNode *undo_node)
 {
@@ -93,6 +104,30 @@ SerializeUndoData(StringInfo buf, UndoNode *undo_node)
 	appendBinaryStringInfo(buf, undo_node->data, undo_node->length);
 }
 
+/* Compute the number of bytes SerializeUndoData() would emit. */
+static UndoRecordSize
+SerializedUndoDataSize(UndoNode *undo_node)
+{
+	return sizeof(((UndoNode *) NULL)->length) +
+		sizeof(((UndoNode *) NULL)->type) + undo_node->length;
+}
+
+/*
+ * Serialize an undo record directly to 'out', which must have room for
+ * SerializedUndoDataSize() bytes.  The layout must match what
+ * SerializeUndoData() writes, since both DO and REDO must produce identical
+ * record data regardless of which path was taken.
+ */
+static void
+SerializeUndoDataInPlace(char *out, UndoNode *undo_node)
+{
+	memcpy(out, &undo_node->length, sizeof(((UndoNode *) NULL)->length));
+	out += sizeof(((UndoNode *) NULL)->length);
+	memcpy(out, &undo_node->type, sizeof(((UndoNode *) NULL)->type));
+	out += sizeof(((UndoNode *) NULL)->type);
+	memcpy(out, undo_node->data, undo_node->length);
+}
+
 /* Saved state for pg_xact_undo_status. */
 typedef struct
 {
@@ -136,6 +171,11 @@ static XactUndoSubTransaction XactUndoTopState;
 
 static void CollapseXactUndoSubTransactions(void);
 static void ResetXactUndo(void);
+static void XactUndoPrefetchChunk(UndoPersistenceLevel plevel,
+								  UndoRecPtr chunk_start,
+								  UndoRecPtr chunk_end);
+static UndoRecPtr XactUndoChunkEnd(UndoRecPtr chunk_start,
+								   UndoRecPtr end_location);
 static UndoRecPtr XactUndoEndLocation(UndoPersistenceLevel plevel);
 static void XactUndoFinalizeRequest(bool mark_as_ready);
 static const char *UndoPersistenceLevelString(UndoPersistenceLevel plevel);
@@ -167,8 +207,7 @@ XactUndoShmemInit(void)
 	XactUndo.manager = (UndoRequestManager *)
 		ShmemInitStruct("undo request manager", size, &found);
 	if (!found)
-		InitializeUndoRequestManager(XactUndo.manager, UndoRequestLock,
-									 capacity, soft_limit);
+		InitializeUndoRequestManager(XactUndo.manager, capacity, soft_limit);
 	Assert(XactUndo.my_request == NULL);
 	ResetXactUndo();
 }
@@ -210,10 +249,30 @@ CheckPointXactUndo(UndoCheckpointContext *ctx)
 
 /*
  * Prepare to insert a transactional undo record.
+ *
+ * The caller must keep *undo_node valid until InsertXactUndoData() has been
+ * called; when the record does not cross a page boundary, serialization is
+ * deferred until then so that the record can be written directly into the
+ * undo page.
  */
 UndoRecPtr
 PrepareXactUndoData(XactUndoContext *ctx, char persistence,
 					UndoNode *undo_node)
+{
+	return PrepareXactUndoDataMulti(ctx, persistence, undo_node, 1);
+}
+
+/*
+ * Prepare to insert a batch of transactional undo records.
+ *
+ * The records are inserted contiguously by a single InsertXactUndoData()
+ * call, so one WAL record can cover all the undo generated by a multi-row
+ * operation instead of one WAL record per row.  The caller must keep the
+ * undo_nodes array valid until InsertXactUndoData() has been called.
+ */
+UndoRecPtr
+PrepareXactUndoDataMulti(XactUndoContext *ctx, char persistence,
+						 UndoNode *undo_nodes, int nnodes)
 {
 	int			nestingLevel = GetCurrentTransactionNestLevel();
 	UndoPersistenceLevel plevel = GetUndoPersistenceLevel(persistence);
@@ -221,7 +280,9 @@ PrepareXactUndoData(XactUndoContext *ctx, char persistence,
 	UndoRecPtr	result;
 	UndoRecPtr *sub_start_location;
 	UndoRecordSet *urs;
-	UndoRecordSize	size;
+	size_t		size;
+
+	Assert(nnodes > 0);
 
 	/* We should be connected to a database. */
 	Assert(OidIsValid(MyDatabaseId));
@@ -288,10 +349,10 @@ PrepareXactUndoData(XactUndoContext *ctx, char persistence,
 	/* Remember persistence level. */
 	ctx->plevel = plevel;
 
-	/* Prepare serialized undo data. */
-	initStringInfo(&ctx->data);
-	SerializeUndoData(&ctx->data, undo_node);
-	size = ctx->data.len;
+	/* Compute the combined serialized size of the records. */
+	size = 0;
+	for (int i = 0; i < nnodes; ++i)
+		size += SerializedUndoDataSize(&undo_nodes[i]);
 
 	/*
 	 * Find sufficient space for this undo insertion and lock the necessary
@@ -299,6 +360,61 @@ PrepareXactUndoData(XactUndoContext *ctx, char persistence,
 	 */
 	result = UndoPrepareToInsert(urs, size);
 
+	ctx->nrecords = nnodes;
+	if (nnodes == 1)
+	{
+		/*
+		 * If the record fits on the insertion page and no headers have to be
+		 * written first, InsertXactUndoData() will serialize it directly
+		 * into the shared buffer, so that the record data is copied just
+		 * once.  Otherwise, stage the record in a backend-local buffer now,
+		 * while we can still allocate memory; the insertion itself happens
+		 * inside the caller's critical section.
+		 */
+		ctx->node = undo_nodes;
+		ctx->size = size;
+		ctx->rdata = NULL;
+		if (UndoCanInsertInPlace(urs, size))
+			ctx->data.data = NULL;
+		else
+		{
+			initStringInfo(&ctx->data);
+			SerializeUndoData(&ctx->data, undo_nodes);
+			Assert(ctx->data.len == size);
+		}
+	}
+	else
+	{
+		size_t		off = 0;
+
+		/*
+		 * Stage the whole batch in a backend-local buffer, remembering the
+		 * boundaries of the individual records so that InsertXactUndoData()
+		 * can copy them into the undo pages with one UndoInsertMulti() call.
+		 */
+		ctx->node = NULL;
+		ctx->size = size;
+		ctx->rdata = palloc(sizeof(UndoRecData) * nnodes);
+		initStringInfo(&ctx->data);
+		for (int i = 0; i < nnodes; ++i)
+		{
+			int			start = ctx->data.len;
+
+			SerializeUndoData(&ctx->data, &undo_nodes[i]);
+			ctx->rdata[i].size = ctx->data.len - start;
+		}
+
+		/*
+		 * The buffer may have been enlarged while appending, so work out the
+		 * record data pointers only now.
+		 */
+		for (int i = 0; i < nnodes; ++i)
+		{
+			ctx->rdata[i].data = ctx->data.data + off;
+			off += ctx->rdata[i].size;
+		}
+	}
+
 	/*
 	 * If this is the first undo for this persistence level in this
 	 * subtransaction, record the start location.
@@ -329,7 +445,19 @@ InsertXactUndoData(XactUndoContext *ctx, uint8 first_block_id)
 	UndoRecordSet *urs = XactUndo.record_set[ctx->plevel];
 
 	Assert(urs != NULL);
-	UndoInsert(urs, ctx->data.data, ctx->data.len);
+	if (ctx->rdata != NULL)
+		UndoInsertMulti(urs, ctx->rdata, ctx->nrecords);
+	else if (ctx->data.data == NULL)
+	{
+		char	   *out;
+
+		/* Serialize the record directly into the insertion page. */
+		out = UndoBeginInsertInPlace(urs, ctx->size);
+		SerializeUndoDataInPlace(out, ctx->node);
+		UndoFinishInsertInPlace(urs, ctx->size);
+	}
+	else
+		UndoInsert(urs, ctx->data.data, ctx->data.len);
 	UndoXLogRegisterBuffers(urs, first_block_id);
 }
 
@@ -354,7 +482,10 @@ CleanupXactUndoInsertion(XactUndoContext *ctx)
 	UndoRecordSet *urs = XactUndo.record_set[ctx->plevel];
 
 	UndoRelease(urs);
-	pfree(ctx->data.data);
+	if (ctx->data.data != NULL)
+		pfree(ctx->data.data);
+	if (ctx->rdata != NULL)
+		pfree(ctx->rdata);
 }
 
 /*
@@ -374,6 +505,39 @@ XactUndoReplay(XLogReaderState *xlog_record, UndoNode *undo_node)
 	return UndoReplay(xlog_record, data.data, data.len);
 }
 
+/*
+ * Recreate a batch of UNDO records during WAL replay.
+ *
+ * The records must match those passed to PrepareXactUndoDataMulti() at DO
+ * time, so that the replayed undo pages come out identical.
+ */
+UndoRecPtr
+XactUndoReplayMulti(XLogReaderState *xlog_record, UndoNode *undo_nodes,
+					int nnodes)
+{
+	StringInfoData data;
+	UndoRecData *rdata;
+	size_t		off = 0;
+
+	/* Prepare serialized undo data, remembering the record boundaries. */
+	rdata = palloc(sizeof(UndoRecData) * nnodes);
+	initStringInfo(&data);
+	for (int i = 0; i < nnodes; ++i)
+	{
+		int			start = data.len;
+
+		SerializeUndoData(&data, &undo_nodes[i]);
+		rdata[i].size = data.len - start;
+	}
+	for (int i = 0; i < nnodes; ++i)
+	{
+		rdata[i].data = data.data + off;
+		off += rdata[i].size;
+	}
+
+	return UndoReplayMulti(xlog_record, rdata, nnodes);
+}
+
 /*
  * Handle a report that an UndoRecordSet was closed.
  *
@@ -468,6 +632,19 @@ XactUndoWaitTime(TimestampTz now)
 	return UndoRequestWaitTime(XactUndo.manager, now);
 }
 
+/*
+ * Count the distinct databases with undo requests available for processing
+ * at time 'now', up to 'max_databases'.  The undo launcher uses this to
+ * decide how many workers to start in one batch.
+ */
+unsigned
+XactUndoPendingDatabases(TimestampTz now, unsigned max_databases)
+{
+	Assert(XactUndo.manager != NULL);
+	return CountPendingUndoRequestDatabases(XactUndo.manager, now,
+											max_databases);
+}
+
 /*
  * Attempt to obtain an UndoRequest for background processing.
  *
@@ -578,12 +755,45 @@ PerformUndoActions(int nestingLevel)
 	{
 		UndoRecPtr start_location;
 		UndoRecPtr end_location;
+		UndoRecPtr chunk_start;
 
 		start_location = mysubxact->start_location[p];
 		if (!UndoRecPtrIsValid(start_location))
 			continue;
 		end_location = XactUndoEndLocation(p);
 
+		/*
+		 * Partition the range into apply chunks.  A future parallel apply
+		 * mode will hand these chunks out to multiple undo workers, with
+		 * this backend acting as coordinator; for now, we simply walk them
+		 * in order, and "processing" a chunk is a no-op because the apply
+		 * machinery does not exist yet.
+		 */
+		chunk_start = start_location;
+		XactUndoPrefetchChunk(p, chunk_start,
+							  XactUndoChunkEnd(chunk_start, end_location));
+		while (chunk_start < end_location)
+		{
+			UndoRecPtr	chunk_end;
+
+			chunk_end = XactUndoChunkEnd(chunk_start, end_location);
+
+			/*
+			 * Issue read-ahead hints for the chunk after this one, so that
+			 * its undo pages are on their way into shared buffers while
+			 * this chunk is being processed.
+			 */
+			if (chunk_end < end_location)
+				XactUndoPrefetchChunk(p, chunk_end,
+									  XactUndoChunkEnd(chunk_end,
+													   end_location));
+
+			elog(DEBUG2,
+				 "undo apply chunk: " UndoRecPtrFormat " .. " UndoRecPtrFormat,
+				 chunk_start, chunk_end);
+			chunk_start = chunk_end;
+		}
+
 		/*
 		 * AFIXME: until we can show the actual effects of undo processing,
 		 * show a debug message showing when undo is being executed.
@@ -1053,6 +1263,69 @@ ResetXactUndo(void)
 	}
 }
 
+/*
+ * Compute the end of the apply chunk beginning at 'chunk_start', given that
+ * the undo to be applied ends at 'end_location'.
+ *
+ * Byte arithmetic on undo record pointers is only meaningful within a single
+ * undo log, so if the remaining range crosses into another undo log we treat
+ * everything from chunk_start onward as a single chunk rather than trying to
+ * guess where the current log's data ends.  Transactions large enough to
+ * benefit from chunked apply overwhelmingly live in one undo log anyway.
+ */
+static UndoRecPtr
+XactUndoChunkEnd(UndoRecPtr chunk_start, UndoRecPtr end_location)
+{
+	UndoRecPtr	chunk_end;
+
+	Assert(chunk_start < end_location);
+
+	if (UndoRecPtrGetLogNo(chunk_start) != UndoRecPtrGetLogNo(end_location))
+		return end_location;
+
+	chunk_end = UndoRecPtrPlusUsableBytes(chunk_start, UNDO_APPLY_CHUNK_SIZE);
+	return Min(chunk_end, end_location);
+}
+
+/*
+ * Hint to the operating system that we will soon need the undo pages holding
+ * the range [chunk_start, chunk_end).
+ *
+ * We only issue hints for pages not already in shared buffers, and no more
+ * than effective_io_concurrency of them per chunk, the same limit that
+ * governs prefetching during bitmap heap scans.  This is purely advisory:
+ * the apply loop will read whatever wasn't prefetched in the usual way.
+ */
+static void
+XactUndoPrefetchChunk(UndoPersistenceLevel plevel, UndoRecPtr chunk_start,
+					  UndoRecPtr chunk_end)
+{
+#ifdef USE_PREFETCH
+	RelFileNode rnode;
+	BlockNumber blockno;
+	BlockNumber lastblock;
+	int			budget = effective_io_concurrency;
+
+	/* Temporary undo lives in local buffers; don't bother. */
+	if (plevel == UNDOPERSISTENCE_TEMP)
+		return;
+
+	/*
+	 * If the range spans undo logs we can't compute block numbers for it
+	 * with simple pointer arithmetic, so don't bother; the case is rare,
+	 * and prefetching is only a hint.
+	 */
+	if (UndoRecPtrGetLogNo(chunk_start) != UndoRecPtrGetLogNo(chunk_end - 1))
+		return;
+
+	UndoRecPtrAssignRelFileNode(rnode, chunk_start);
+	blockno = UndoRecPtrGetBlockNum(chunk_start);
+	lastblock = UndoRecPtrGetBlockNum(chunk_end - 1);
+	while (blockno <= lastblock && budget-- > 0)
+		PrefetchBufferWithoutRelcache(rnode, UndoLogForkNum, blockno++);
+#endif							/* USE_PREFETCH */
+}
+
 /*
  * Get end location for a persistence level by adding the last size to
  * the last location.
@@ -49,7 +49,7 @@ undoxacttest_init_rel(PG_FUNCTION_ARGS)
 }
 
 static Datum
-undoxacttest_mod_impl(Oid reloid, int64 mod)
+undoxacttest_mod_impl(Oid reloid, int64 mod, int nmods)
 {
 	Relation	rel;
 	Buffer		buf;
@@ -64,7 +64,11 @@ undoxacttest_mod_impl(Oid reloid, int64 mod)
 	data = undoxacttest_fetch(rel, &buf);
 	counter = ((int64 *) &data[0]);
 
-	oldval = undoxacttest_log_execute_mod(rel, buf, counter, mod);
+	if (nmods == 1)
+		oldval = undoxacttest_log_execute_mod(rel, buf, counter, mod);
+	else
+		oldval = undoxacttest_log_execute_mod_multi(rel, buf, counter,
+													mod, nmods);
 
 	UnlockReleaseBuffer(buf);
 
@@ -79,7 +83,7 @@ undoxacttest_fetch_and_inc(PG_FUNCTION_ARGS)
 	Oid reloid = PG_GETARG_OID(0);
 	int64 value = PG_GETARG_INT64(1);
 
-	return undoxacttest_mod_impl(reloid, value);
+	return undoxacttest_mod_impl(reloid, value, 1);
 }
 
 Datum
@@ -88,7 +92,22 @@ undoxacttest_fetch_and_dec(PG_FUNCTION_ARGS)
 	Oid reloid = PG_GETARG_OID(0);
 	int64 value = PG_GETARG_INT64(1);
 
-	return undoxacttest_mod_impl(reloid, -value);
+	return undoxacttest_mod_impl(reloid, -value, 1);
+}
+
+Datum
+undoxacttest_fetch_and_inc_batch(PG_FUNCTION_ARGS)
+{
+	Oid reloid = PG_GETARG_OID(0);
+	int64 value = PG_GETARG_INT64(1);
+	int32 count = PG_GETARG_INT32(2);
+
+	if (count < 1)
+		ereport(ERROR,
+				(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+				 errmsg("batch count must be at least 1")));
+
+	return undoxacttest_mod_impl(reloid, value, count);
 }
 
 Datum
@@ -19,8 +19,6 @@ undoxacttest_log_execute_mod(Relation rel, Buffer buf, int64 *counter, int64 mod
 	int64		newval;
 
 	/* build undo record */
-	// AFIXME: API needs to be changed so serialization happens at a later
-	// stage.
 	undo_rec.mod = mod;
 	undo_node.data = (char *) &undo_rec;
 	undo_node.length = sizeof(undo_rec);
@@ -71,11 +69,88 @@ undoxacttest_log_execute_mod(Relation rel, Buffer buf, int64 *counter, int64 mod
 	return oldval;
 }
 
+/*
+ * Like undoxacttest_log_execute_mod(), but applies the modification nmods
+ * times, emitting one undo record per modification and a single WAL record
+ * covering the whole batch.
+ */
+int64
+undoxacttest_log_execute_mod_multi(Relation rel, Buffer buf, int64 *counter,
+								   int64 mod, int nmods)
+{
+	XactUndoContext undo_context;
+	UndoNode   *undo_nodes;
+	xu_undoxactest_mod undo_rec;
+
+	int64		oldval;
+	int64		newval;
+
+	/* build one undo record per modification */
+	undo_rec.mod = mod;
+	undo_nodes = palloc(sizeof(UndoNode) * nmods);
+	for (int i = 0; i < nmods; i++)
+	{
+		undo_nodes[i].data = (char *) &undo_rec;
+		undo_nodes[i].length = sizeof(undo_rec);
+	}
+
+	PrepareXactUndoDataMulti(&undo_context,
+							 rel->rd_rel->relpersistence,
+							 undo_nodes, nmods);
+
+	LockBuffer(buf, BUFFER_LOCK_EXCLUSIVE);
+
+	START_CRIT_SECTION();
+
+	/* perform the modifications */
+	oldval = *counter;
+	*counter += mod * nmods;
+	newval = *counter;
+
+	MarkBufferDirty(buf);
+
+	if (RelationNeedsWAL(rel))
+	{
+		XLogBeginInsert();
+		XLogRegisterBuffer(0, buf, REGBUF_STANDARD | REGBUF_KEEP_DATA);
+	}
+
+	InsertXactUndoData(&undo_context, 1);
+
+	if (RelationNeedsWAL(rel))
+	{
+		Page		page = BufferGetPage(buf);
+		xl_undoxacttest_mod_multi xlrec = {.newval = newval, .debug_mod = mod,
+										   .debug_oldval = oldval, .nmods = nmods};
+		XLogRecPtr	recptr;
+		uint8		info = XLOG_UNDOXACTTEST_MOD_MULTI;
+
+		XLogRegisterData((char *) &xlrec, sizeof(xlrec));
+
+		recptr = XLogInsert(RM_UNDOXACTTEST_ID, info);
+
+		PageSetLSN(page, recptr);
+
+		SetXactUndoPageLSNs(&undo_context, recptr);
+	}
+
+	END_CRIT_SECTION();
+
+	CleanupXactUndoInsertion(&undo_context);
+
+	pfree(undo_nodes);
+
+	return oldval;
+}
+
+/*
+ * Redo the counter page update common to all modification records.
+ */
 static void
-undoxacttest_redo_mod(XLogReaderState *record)
+undoxacttest_redo_set_counter(XLogReaderState *record, int64 newval,
+							  int64 debug_mod, int64 debug_oldval)
 {
 	Buffer		buf;
-	xl_undoxacttest_mod *xlrec = (xl_undoxacttest_mod *) XLogRecGetData(record);
 
 	if (XLogReadBufferForRedo(record, 0, &buf) == BLK_NEEDS_REDO)
 	{
@@ -107,10 +182,10 @@ undoxacttest_redo_mod(XLogReaderState *record)
 			 ", w/ debug_oldval: "INT64_FORMAT
 			 ", setting to: "INT64_FORMAT
 			 ", for modification: "INT64_FORMAT,
-			 *pagevalue, xlrec->debug_oldval,
-			 xlrec->newval, xlrec->debug_mod);
+			 *pagevalue, debug_oldval,
+			 newval, debug_mod);
 
-		*pagevalue = xlrec->newval;
+		*pagevalue = newval;
 
 		PageSetLSN(page, lsn);
 		MarkBufferDirty(buf);
@@ -118,6 +193,15 @@ undoxacttest_redo_mod(XLogReaderState *record)
 
 	if (BufferIsValid(buf))
 		UnlockReleaseBuffer(buf);
+}
+
+static void
+undoxacttest_redo_mod(XLogReaderState *record)
+{
+	xl_undoxacttest_mod *xlrec = (xl_undoxacttest_mod *) XLogRecGetData(record);
+
+	undoxacttest_redo_set_counter(record, xlrec->newval,
+								  xlrec->debug_mod, xlrec->debug_oldval);
 
 	/* reconstruct undo record */
 	{
@@ -132,6 +216,30 @@ undoxacttest_redo_mod(XLogReaderState *record)
 	}
 }
 
+static void
+undoxacttest_redo_mod_multi(XLogReaderState *record)
+{
+	xl_undoxacttest_mod_multi *xlrec = (xl_undoxacttest_mod_multi *) XLogRecGetData(record);
+	UndoNode   *undo_nodes;
+	xu_undoxactest_mod undo_rec;
+
+	undoxacttest_redo_set_counter(record, xlrec->newval,
+								  xlrec->debug_mod, xlrec->debug_oldval);
+
+	/* reconstruct undo records, exactly as built at DO time */
+	undo_rec.mod = xlrec->debug_mod;
+	undo_nodes = palloc(sizeof(UndoNode) * xlrec->nmods);
+	for (int i = 0; i < xlrec->nmods; i++)
+	{
+		undo_nodes[i].data = (char *) &undo_rec;
+		undo_nodes[i].length = sizeof(undo_rec);
+	}
+
+	XactUndoReplayMulti(record, undo_nodes, xlrec->nmods);
+
+	pfree(undo_nodes);
+}
+
 void
 undoxacttest_redo(XLogReaderState *record)
 {
@@ -142,6 +250,9 @@ undoxacttest_redo(XLogReaderState *record)
 		case XLOG_UNDOXACTTEST_MOD:
 			undoxacttest_redo_mod(record);
 			break;
+		case XLOG_UNDOXACTTEST_MOD_MULTI:
+			undoxacttest_redo_mod_multi(record);
+			break;
 		default:
 			elog(PANIC, "undoxacttest_redo: unknown op code %u", info);
 	}
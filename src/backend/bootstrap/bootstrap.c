@@ -227,7 +227,7 @@ AuxiliaryProcessMain(int argc, char *argv[])
 	/* If no -x argument, we are a CheckerProcess */
 	MyAuxProcType = CheckerProcess;
 
-	while ((flag = getopt(argc, argv, "B:c:d:D:Fkr:x:X:-:")) != -1)
+	while ((flag = getopt(argc, argv, "B:c:d:D:Fkr:R:x:X:-:")) != -1)
 	{
 		switch (flag)
 		{
@@ -259,6 +259,18 @@ AuxiliaryProcessMain(int argc, char *argv[])
 			case 'r':
 				strlcpy(OutputFileName, optarg, MAXPGPATH);
 				break;
+			case 'R':
+				{
+					int			RelSegSz = strtoul(optarg, NULL, 0);
+
+					if (RelSegSz < 1 || (RelSegSz & (RelSegSz - 1)) != 0)
+						ereport(ERROR,
+								(errcode(ERRCODE_INVALID_PARAMETER_VALUE),
+								 errmsg("-R requires a power of two number of blocks")));
+					SetConfigOption("segment_size", optarg, PGC_INTERNAL,
+									PGC_S_OVERRIDE);
+				}
+				break;
 			case 'x':
 				MyAuxProcType = atoi(optarg);
 				break;
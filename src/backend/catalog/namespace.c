@@ -52,6 +52,7 @@
 #include "utils/builtins.h"
 #include "utils/catcache.h"
 #include "utils/guc.h"
+#include "utils/hsearch.h"
 #include "utils/inval.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
@@ -162,6 +163,27 @@ typedef struct
 
 static List *overrideStack = NIL;
 
+/*
+ * Cache of unqualified relation name lookups, so that repeated resolution of
+ * hot names costs one hash probe instead of one syscache probe per schema in
+ * the search path.  Entries are trusted only if they were saved under the
+ * current activePathGeneration; that counter is bumped whenever
+ * activeSearchPath changes and on any pg_class syscache invalidation, which
+ * covers creations, drops and renames in all backends (including our own
+ * temp-table churn).  Negative lookups are recorded with generation zero,
+ * which never matches, so they are not cached.
+ */
+typedef struct RelnameCacheEntry
+{
+	char		relname[NAMEDATALEN];	/* hash key, null-terminated */
+	uint64		generation;		/* activePathGeneration when saved */
+	Oid			relid;			/* resolved OID */
+} RelnameCacheEntry;
+
+static HTAB *RelnameCacheHash = NULL;
+
+static uint64 activePathGeneration = 1;
+
 /*
  * myTempNamespace is InvalidOid until and unless a TEMP namespace is set up
  * in a particular backend session (this happens when a CREATE TEMP TABLE
@@ -197,6 +219,7 @@ static void InitTempTableNamespace(void);
 static void RemoveTempRelations(Oid tempNamespaceId);
 static void RemoveTempRelationsCallback(int code, Datum arg);
 static void NamespaceCallback(Datum arg, int cacheid, uint32 hashvalue);
+static void RelnameCacheCallback(Datum arg, int cacheid, uint32 hashvalue);
 static bool MatchNamedCall(HeapTuple proctup, int nargs, List *argnames,
 						   int **argnumbers);
 
@@ -673,16 +696,63 @@ RelnameGetRelid(const char *relname)
 {
 	Oid			relid;
 	ListCell   *l;
+	RelnameCacheEntry *entry = NULL;
+	uint64		searchGeneration;
 
 	recomputeNamespacePath();
 
+	/*
+	 * Capture the generation before searching.  The catalog lookups below can
+	 * accept invalidation messages and bump activePathGeneration; stamping
+	 * the entry with the pre-search generation ensures that a result made
+	 * stale mid-search is not trusted by later probes.
+	 */
+	searchGeneration = activePathGeneration;
+
+	/*
+	 * Probe the name cache first.  Over-length names can't be valid relation
+	 * names, but play it safe and just skip the cache for them.
+	 */
+	if (strlen(relname) < NAMEDATALEN)
+	{
+		bool		found;
+
+		if (RelnameCacheHash == NULL)
+		{
+			HASHCTL		ctl;
+
+			MemSet(&ctl, 0, sizeof(ctl));
+			ctl.keysize = NAMEDATALEN;
+			ctl.entrysize = sizeof(RelnameCacheEntry);
+			RelnameCacheHash = hash_create("Relname cache", 64, &ctl,
+										   HASH_ELEM);
+		}
+
+		entry = (RelnameCacheEntry *) hash_search(RelnameCacheHash,
+												  relname,
+												  HASH_ENTER,
+												  &found);
+		if (found && entry->generation == activePathGeneration)
+			return entry->relid;
+
+		/* mark not valid, in case we error out partway through the search */
+		entry->generation = 0;
+	}
+
 	foreach(l, activeSearchPath)
 	{
 		Oid			namespaceId = lfirst_oid(l);
 
 		relid = get_relname_relid(relname, namespaceId);
 		if (OidIsValid(relid))
+		{
+			if (entry)
+			{
+				entry->relid = relid;
+				entry->generation = searchGeneration;
+			}
 			return relid;
+		}
 	}
 
 	/* Not found in path */
@@ -3509,6 +3579,7 @@ PushOverrideSearchPath(OverrideSearchPath *newpath)
 	activeSearchPath = entry->searchPath;
 	activeCreationNamespace = entry->creationNamespace;
 	activeTempCreationPending = false;	/* XXX is this OK? */
+	activePathGeneration++;
 
 	MemoryContextSwitchTo(oldcxt);
 }
@@ -3543,6 +3614,7 @@ PopOverrideSearchPath(void)
 		activeSearchPath = entry->searchPath;
 		activeCreationNamespace = entry->creationNamespace;
 		activeTempCreationPending = false;	/* XXX is this OK? */
+		activePathGeneration++;
 	}
 	else
 	{
@@ -3550,6 +3622,7 @@ PopOverrideSearchPath(void)
 		activeSearchPath = baseSearchPath;
 		activeCreationNamespace = baseCreationNamespace;
 		activeTempCreationPending = baseTempCreationPending;
+		activePathGeneration++;
 	}
 }
 
@@ -3835,6 +3908,7 @@ recomputeNamespacePath(void)
 	activeSearchPath = baseSearchPath;
 	activeCreationNamespace = baseCreationNamespace;
 	activeTempCreationPending = baseTempCreationPending;
+	activePathGeneration++;
 
 	/* Clean up. */
 	pfree(rawname);
@@ -4054,6 +4128,7 @@ AtEOXact_Namespace(bool isCommit, bool parallel)
 		activeSearchPath = baseSearchPath;
 		activeCreationNamespace = baseCreationNamespace;
 		activeTempCreationPending = baseTempCreationPending;
+		activePathGeneration++;
 	}
 }
 
@@ -4118,6 +4193,7 @@ AtEOSubXact_Namespace(bool isCommit, SubTransactionId mySubid,
 		activeSearchPath = entry->searchPath;
 		activeCreationNamespace = entry->creationNamespace;
 		activeTempCreationPending = false;	/* XXX is this OK? */
+		activePathGeneration++;
 	}
 	else
 	{
@@ -4125,6 +4201,7 @@ AtEOSubXact_Namespace(bool isCommit, SubTransactionId mySubid,
 		activeSearchPath = baseSearchPath;
 		activeCreationNamespace = baseCreationNamespace;
 		activeTempCreationPending = baseTempCreationPending;
+		activePathGeneration++;
 	}
 }
 
@@ -4264,6 +4341,7 @@ InitializeSearchPath(void)
 		activeSearchPath = baseSearchPath;
 		activeCreationNamespace = baseCreationNamespace;
 		activeTempCreationPending = baseTempCreationPending;
+		activePathGeneration++;
 	}
 	else
 	{
@@ -4274,6 +4352,10 @@ InitializeSearchPath(void)
 		CacheRegisterSyscacheCallback(NAMESPACEOID,
 									  NamespaceCallback,
 									  (Datum) 0);
+		/* Arrange to flush the relation name cache on pg_class changes */
+		CacheRegisterSyscacheCallback(RELNAMENSP,
+									  RelnameCacheCallback,
+									  (Datum) 0);
 		/* Force search path to be recomputed on next use */
 		baseSearchPathValid = false;
 	}
@@ -4290,6 +4372,19 @@ NamespaceCallback(Datum arg, int cacheid, uint32 hashvalue)
 	baseSearchPathValid = false;
 }
 
+/*
+ * RelnameCacheCallback
+ *		Syscache inval callback function
+ *
+ * Rather than tracking which names were affected, just stop trusting all
+ * existing cache entries; they are overwritten as names are looked up again.
+ */
+static void
+RelnameCacheCallback(Datum arg, int cacheid, uint32 hashvalue)
+{
+	activePathGeneration++;
+}
+
 /*
  * Fetch the active search path. The return value is a palloc'ed list
  * of OIDs; the caller is responsible for freeing this storage as
@@ -946,6 +946,16 @@ CREATE VIEW pg_stat_bgwriter AS
         pg_stat_get_buf_alloc() AS buffers_alloc,
         pg_stat_get_bgwriter_stat_reset_time() AS stats_reset;
 
+CREATE VIEW pg_stat_io AS
+    SELECT
+        s.backend_type,
+        s.object,
+        s.op,
+        s.count,
+        s.total_time,
+        s.latency_histogram
+    FROM pg_stat_get_io() s;
+
 CREATE VIEW pg_stat_progress_vacuum AS
     SELECT
         S.pid AS pid, S.datid AS datid, D.datname AS datname,
@@ -1066,6 +1076,10 @@ CREATE VIEW pg_stat_undo_logs AS
     SELECT *
     FROM pg_stat_get_undo_logs();
 
+CREATE VIEW pg_stat_undo_workers AS
+    SELECT *
+    FROM pg_stat_get_undo_workers();
+
 --
 -- We have a few function definitions in here, too.
 -- At some point there might be enough to justify breaking them out into
@@ -236,6 +236,8 @@ typedef struct QueueBackendStatus
 	Oid			dboid;			/* backend's database OID, or InvalidOid */
 	BackendId	nextListener;	/* id of next listener, or InvalidBackendId */
 	QueuePosition pos;			/* backend has read queue up to here */
+	uint64		channelFilter;	/* Bloom filter over listened-to channels; 0
+								 * means "unknown, assume interested in all" */
 } QueueBackendStatus;
 
 /*
@@ -285,6 +287,7 @@ static AsyncQueueControl *asyncQueueControl;
 #define QUEUE_BACKEND_DBOID(i)		(asyncQueueControl->backend[i].dboid)
 #define QUEUE_NEXT_LISTENER(i)		(asyncQueueControl->backend[i].nextListener)
 #define QUEUE_BACKEND_POS(i)		(asyncQueueControl->backend[i].pos)
+#define QUEUE_BACKEND_FILTER(i)		(asyncQueueControl->backend[i].channelFilter)
 
 /*
  * The SLRU buffer area through which we access the notification queue
@@ -405,6 +408,14 @@ typedef struct NotificationHash
 
 static NotificationList *pendingNotifies = NULL;
 
+/*
+ * Union of the channel signatures of all notifications we've added to the
+ * queue but not yet signaled other backends about.  SignalBackends() tests
+ * this against each listener's published channelFilter so that a burst of
+ * traffic on one channel doesn't wake listeners that provably don't care.
+ */
+static uint64 pendingNotifySignature = 0;
+
 /*
  * Inbound notifications are initially processed by HandleNotifyInterrupt(),
  * called from inside a signal handler. That just sets the
@@ -439,6 +450,8 @@ static void Exec_ListenCommit(const char *channel);
 static void Exec_UnlistenCommit(const char *channel);
 static void Exec_UnlistenAllCommit(void);
 static bool IsListeningOn(const char *channel);
+static uint64 asyncChannelSignature(const char *channel);
+static void asyncUpdateChannelFilter(void);
 static void asyncQueueUnregister(void);
 static bool asyncQueueIsFull(void);
 static bool asyncQueueAdvance(volatile QueuePosition *position, int entryLength);
@@ -544,6 +557,7 @@ AsyncShmemInit(void)
 			QUEUE_BACKEND_DBOID(i) = InvalidOid;
 			QUEUE_NEXT_LISTENER(i) = InvalidBackendId;
 			SET_QUEUE_POS(QUEUE_BACKEND_POS(i), 0, 0);
+			QUEUE_BACKEND_FILTER(i) = 0;
 		}
 	}
 
@@ -949,6 +963,14 @@ PreCommit_Notify(void)
 		/* Now push the notifications into the queue */
 		backendHasSentNotifications = true;
 
+		/* Remember the channels' signature for SignalBackends to test */
+		foreach(p, pendingNotifies->events)
+		{
+			Notification *n = (Notification *) lfirst(p);
+
+			pendingNotifySignature |= asyncChannelSignature(n->data);
+		}
+
 		nextNotify = list_head(pendingNotifies->events);
 		while (nextNotify != NULL)
 		{
@@ -1024,6 +1046,10 @@ AtCommit_Notify(void)
 	if (amRegisteredListener && listenChannels == NIL)
 		asyncQueueUnregister();
 
+	/* Let notifiers know which channels we now care about */
+	if (pendingActions != NULL)
+		asyncUpdateChannelFilter();
+
 	/* And clean up */
 	ClearPendingActionsAndNotifies();
 }
@@ -1095,6 +1121,8 @@ Exec_ListenPreCommit(void)
 	QUEUE_BACKEND_POS(MyBackendId) = max;
 	QUEUE_BACKEND_PID(MyBackendId) = MyProcPid;
 	QUEUE_BACKEND_DBOID(MyBackendId) = MyDatabaseId;
+	/* Until we've published our channels, notifiers must assume the worst */
+	QUEUE_BACKEND_FILTER(MyBackendId) = 0;
 	/* Insert backend into list of listeners at correct position */
 	if (prevListener > 0)
 	{
@@ -1300,6 +1328,50 @@ IsListeningOn(const char *channel)
 	return false;
 }
 
+/*
+ * Compute the one-bit Bloom signature of a channel name.
+ *
+ * These signatures exist only in shared memory, never on disk, so we can
+ * use the fast in-memory hash.
+ */
+static uint64
+asyncChannelSignature(const char *channel)
+{
+	uint32		h = hash_bytes_fast((const unsigned char *) channel,
+									strlen(channel));
+
+	return UINT64CONST(1) << (h % 64);
+}
+
+/*
+ * Publish a Bloom filter over our listenChannels in shared memory, so that
+ * notifying backends can skip signaling us about channels we provably do
+ * not listen on.  Called after LISTEN/UNLISTEN actions have updated
+ * listenChannels at transaction commit.
+ *
+ * If the filter computes to zero (no channels), we publish exactly that;
+ * zero doubles as the "unknown" value that makes notifiers assume we could
+ * be interested, which errs on the safe side during the window between
+ * registering and publishing.
+ */
+static void
+asyncUpdateChannelFilter(void)
+{
+	uint64		filter = 0;
+	ListCell   *p;
+
+	if (!amRegisteredListener)
+		return;
+
+	foreach(p, listenChannels)
+		filter |= asyncChannelSignature((const char *) lfirst(p));
+
+	/* Shared lock is enough to update our own entry; see AsyncQueueControl */
+	LWLockAcquire(AsyncQueueLock, LW_SHARED);
+	QUEUE_BACKEND_FILTER(MyBackendId) = filter;
+	LWLockRelease(AsyncQueueLock);
+}
+
 /*
  * Remove our entry from the listeners array when we are no longer listening
  * on any channel.  NB: must not fail if we're already not listening.
@@ -1680,12 +1752,25 @@ SignalBackends(void)
 		pos = QUEUE_BACKEND_POS(i);
 		if (QUEUE_BACKEND_DBOID(i) == MyDatabaseId)
 		{
+			uint64		filter = QUEUE_BACKEND_FILTER(i);
+
 			/*
-			 * Always signal listeners in our own database, unless they're
-			 * already caught up (unlikely, but possible).
+			 * Signal listeners in our own database, unless they're already
+			 * caught up (unlikely, but possible), or their channel filter
+			 * proves they listen to none of the channels we notified.  In
+			 * the latter case, treat them like other-database listeners
+			 * below: wake them anyway once they're far enough behind, so
+			 * their queue position keeps advancing.  A zero filter means
+			 * the listener hasn't published its interests, so we must
+			 * assume it could be interested.
 			 */
 			if (QUEUE_POS_EQUAL(pos, QUEUE_HEAD))
 				continue;
+			if (filter != 0 &&
+				(filter & pendingNotifySignature) == 0 &&
+				asyncQueuePageDiff(QUEUE_POS_PAGE(QUEUE_HEAD),
+								   QUEUE_POS_PAGE(pos)) < QUEUE_CLEANUP_DELAY)
+				continue;
 		}
 		else
 		{
@@ -1721,6 +1806,9 @@ SignalBackends(void)
 
 	pfree(pids);
 	pfree(ids);
+
+	/* All queued-but-unsignaled notifications are now accounted for */
+	pendingNotifySignature = 0;
 }
 
 /*
@@ -62,6 +62,14 @@
 #define ISOCTAL(c) (((c) >= '0') && ((c) <= '7'))
 #define OCTVALUE(c) ((c) - '0')
 
+/*
+ * During COPY TO, we accumulate rows in fe_msgbuf and only hand the data to
+ * the destination once at least this many bytes have been collected.  This
+ * amortizes the per-write overhead (protocol message headers, stdio and
+ * kernel calls) over many rows when the rows are narrow.
+ */
+#define COPY_SEND_FRAME_SIZE 65536
+
 /*
  * Represents the different source/dest cases we need to worry about at
  * the bottom level
@@ -386,6 +394,7 @@ static void CopySendData(CopyState cstate, const void *databuf, int datasize);
 static void CopySendString(CopyState cstate, const char *str);
 static void CopySendChar(CopyState cstate, char c);
 static void CopySendEndOfRow(CopyState cstate);
+static void CopySendFlush(CopyState cstate);
 static int	CopyGetData(CopyState cstate, void *databuf,
 						int minread, int maxread);
 static void CopySendInt32(CopyState cstate, int32 val);
@@ -482,6 +491,7 @@ SendCopyEnd(CopyState cstate)
 		CopySendData(cstate, "\\.", 2);
 		/* Need to flush out the trailer (this also appends a newline) */
 		CopySendEndOfRow(cstate);
+		CopySendFlush(cstate);
 		pq_endcopyout(false);
 	}
 }
@@ -491,7 +501,8 @@ SendCopyEnd(CopyState cstate)
  * CopySendString does the same for null-terminated strings
  * CopySendChar does the same for single characters
  * CopySendEndOfRow does the appropriate thing at end of each data row
- *	(data is not actually flushed except by CopySendEndOfRow)
+ *	(data is not actually flushed except by CopySendFlush, which
+ *	CopySendEndOfRow invokes once enough rows have accumulated)
  *
  * NB: no data conversion is applied by these functions
  *----------
@@ -517,8 +528,6 @@ CopySendChar(CopyState cstate, char c)
 static void
 CopySendEndOfRow(CopyState cstate)
 {
-	StringInfo	fe_msgbuf = cstate->fe_msgbuf;
-
 	switch (cstate->copy_dest)
 	{
 		case COPY_FILE:
@@ -531,7 +540,42 @@ CopySendEndOfRow(CopyState cstate)
 				CopySendString(cstate, "\r\n");
 #endif
 			}
+			break;
+		case COPY_OLD_FE:
+		case COPY_NEW_FE:
+			/* The FE/BE protocol uses \n as newline for all platforms */
+			if (!cstate->binary)
+				CopySendChar(cstate, '\n');
+			break;
+		case COPY_CALLBACK:
+			Assert(false);		/* Not yet supported. */
+			break;
+	}
 
+	/*
+	 * Don't write out each row separately; wait until we've accumulated a
+	 * reasonably sized frame.  CopyData messages need not correspond to row
+	 * boundaries, so batching several rows into one message is transparent
+	 * to frontends.  CopyTo() flushes whatever remains at end of copy.
+	 */
+	if (cstate->fe_msgbuf->len >= COPY_SEND_FRAME_SIZE)
+		CopySendFlush(cstate);
+}
+
+/*
+ * Write out the accumulated contents of fe_msgbuf, if any.
+ */
+static void
+CopySendFlush(CopyState cstate)
+{
+	StringInfo	fe_msgbuf = cstate->fe_msgbuf;
+
+	if (fe_msgbuf->len == 0)
+		return;
+
+	switch (cstate->copy_dest)
+	{
+		case COPY_FILE:
 			if (fwrite(fe_msgbuf->data, fe_msgbuf->len, 1,
 					   cstate->copy_file) != 1 ||
 				ferror(cstate->copy_file))
@@ -566,10 +610,6 @@ CopySendEndOfRow(CopyState cstate)
 			}
 			break;
 		case COPY_OLD_FE:
-			/* The FE/BE protocol uses \n as newline for all platforms */
-			if (!cstate->binary)
-				CopySendChar(cstate, '\n');
-
 			if (pq_putbytes(fe_msgbuf->data, fe_msgbuf->len))
 			{
 				/* no hope of recovering connection sync, so FATAL */
@@ -579,11 +619,7 @@ CopySendEndOfRow(CopyState cstate)
 			}
 			break;
 		case COPY_NEW_FE:
-			/* The FE/BE protocol uses \n as newline for all platforms */
-			if (!cstate->binary)
-				CopySendChar(cstate, '\n');
-
-			/* Dump the accumulated row as one CopyData message */
+			/* Dump the accumulated rows as one CopyData message */
 			(void) pq_putmessage('d', fe_msgbuf->data, fe_msgbuf->len);
 			break;
 		case COPY_CALLBACK:
@@ -2028,7 +2064,7 @@ CopyTo(CopyState cstate)
 	num_phys_attrs = tupDesc->natts;
 	cstate->null_print_client = cstate->null_print; /* default */
 
-	/* We use fe_msgbuf as a per-row buffer regardless of copy_dest */
+	/* We use fe_msgbuf as the output frame buffer regardless of copy_dest */
 	cstate->fe_msgbuf = makeStringInfo();
 
 	/* Get info about the columns we need to process. */
@@ -2145,10 +2181,11 @@ CopyTo(CopyState cstate)
 	{
 		/* Generate trailer for a binary copy */
 		CopySendInt16(cstate, -1);
-		/* Need to flush out the trailer */
-		CopySendEndOfRow(cstate);
 	}
 
+	/* Write out any rows (and trailer) still waiting in the frame buffer */
+	CopySendFlush(cstate);
+
 	MemoryContextDelete(cstate->rowcontext);
 
 	return processed;
@@ -2440,6 +2477,7 @@ CopyMultiInsertBufferFlush(CopyMultiInsertInfo *miinfo,
 	CommandId	mycid = miinfo->mycid;
 	int			ti_options = miinfo->ti_options;
 	bool		line_buf_valid = cstate->line_buf_valid;
+	bool		batched;
 	int			nused = buffer->nused;
 	ResultRelInfo *resultRelInfo = buffer->resultRelInfo;
 	TupleTableSlot **slots = buffer->slots;
@@ -2467,6 +2505,14 @@ CopyMultiInsertBufferFlush(CopyMultiInsertInfo *miinfo,
 					   buffer->bistate);
 	MemoryContextSwitchTo(oldcontext);
 
+	/*
+	 * If no index needs uniqueness or exclusion checks, insert all the index
+	 * entries as a single batch; otherwise we insert them per tuple below.
+	 */
+	batched = false;
+	if (resultRelInfo->ri_NumIndices > 0)
+		batched = ExecInsertIndexTuplesBatch(slots, nused, estate);
+
 	for (i = 0; i < nused; i++)
 	{
 		/*
@@ -2475,12 +2521,13 @@ CopyMultiInsertBufferFlush(CopyMultiInsertInfo *miinfo,
 		 */
 		if (resultRelInfo->ri_NumIndices > 0)
 		{
-			List	   *recheckIndexes;
+			List	   *recheckIndexes = NIL;
 
 			cstate->cur_lineno = buffer->linenos[i];
-			recheckIndexes =
-				ExecInsertIndexTuples(buffer->slots[i], estate, false, NULL,
-									  NIL);
+			if (!batched)
+				recheckIndexes =
+					ExecInsertIndexTuples(buffer->slots[i], estate, false,
+										  NULL, NIL);
 			ExecARInsertTriggers(estate, resultRelInfo,
 								 slots[i], recheckIndexes,
 								 cstate->transition_capture);
@@ -3986,6 +4033,7 @@ CopyReadLineText(CopyState cstate)
 	bool		need_data = false;
 	bool		hit_eof = false;
 	bool		result = false;
+	bool		embeds_ascii;
 	char		mblen_str[2];
 
 	/* CSV variables */
@@ -4004,6 +4052,8 @@ CopyReadLineText(CopyState cstate)
 			escapec = '\0';
 	}
 
+	embeds_ascii = cstate->encoding_embeds_ascii;
+
 	mblen_str[1] = '\0';
 
 	/*
@@ -4071,6 +4121,41 @@ CopyReadLineText(CopyState cstate)
 			need_data = false;
 		}
 
+		/*
+		 * Skip over ordinary characters in bulk, rather than examining them
+		 * one at a time.  An ordinary character can neither end the line,
+		 * begin an escape, quote, or end-of-copy sequence, nor (when the
+		 * encoding embeds ASCII) start a multi-byte sequence, so skipping it
+		 * changes no parsing state.  In text mode quotec and escapec are
+		 * '\0', making those tests no-ops.  We must not skip anything while
+		 * last_was_esc is set, since the character after a CSV escape is
+		 * examined to reset that flag.  The bulk of the input is scanned
+		 * here, so it pays to keep this loop tight.
+		 */
+		if (!last_was_esc)
+		{
+			int			skip = raw_buf_ptr;
+
+			while (skip < copy_buf_len)
+			{
+				char		sc = copy_raw_buf[skip];
+
+				if (sc == '\r' || sc == '\n' || sc == '\\' ||
+					sc == quotec || sc == escapec ||
+					(embeds_ascii && IS_HIGHBIT_SET(sc)))
+					break;
+				skip++;
+			}
+			if (skip > raw_buf_ptr)
+			{
+				raw_buf_ptr = skip;
+				first_char_in_line = false;
+				/* If we consumed the whole buffer, go refill it */
+				if (raw_buf_ptr >= copy_buf_len)
+					continue;
+			}
+		}
+
 		/* OK to fetch a character */
 		prev_raw_ptr = raw_buf_ptr;
 		c = copy_raw_buf[raw_buf_ptr++];
@@ -4444,6 +4529,28 @@ CopyReadAttributesText(CopyState cstate)
 		for (;;)
 		{
 			char		c;
+			char	   *stop_ptr;
+			char	   *delim_ptr;
+
+			/*
+			 * Copy ordinary characters in bulk.  Most field bytes are
+			 * neither the delimiter nor a backslash, so locate the next
+			 * special character with memchr -- which the libc typically
+			 * vectorizes -- and transfer everything before it with a single
+			 * memcpy, instead of testing and copying bytes one at a time.
+			 */
+			stop_ptr = memchr(cur_ptr, '\\', line_end_ptr - cur_ptr);
+			if (stop_ptr == NULL)
+				stop_ptr = line_end_ptr;
+			delim_ptr = memchr(cur_ptr, delimc, stop_ptr - cur_ptr);
+			if (delim_ptr != NULL)
+				stop_ptr = delim_ptr;
+			if (stop_ptr > cur_ptr)
+			{
+				memcpy(output_ptr, cur_ptr, stop_ptr - cur_ptr);
+				output_ptr += stop_ptr - cur_ptr;
+				cur_ptr = stop_ptr;
+			}
 
 			end_ptr = cur_ptr;
 			if (cur_ptr >= line_end_ptr)
@@ -210,6 +210,8 @@ ExecuteQuery(ExecuteStmt *stmt, IntoClause *intoClause,
 	char	   *query_string;
 	int			eflags;
 	long		count;
+	instr_time	exec_start_time;
+	instr_time	exec_end_time;
 
 	/* Look it up in the hash table */
 	entry = FetchPreparedStatement(stmt->name, true);
@@ -301,7 +303,25 @@ ExecuteQuery(ExecuteStmt *stmt, IntoClause *intoClause,
 	 */
 	PortalStart(portal, paramLI, eflags, GetActiveSnapshot());
 
-	(void) PortalRun(portal, count, false, true, dest, dest, completionTag);
+	/*
+	 * Time the execution and feed the result back to the plan cache's
+	 * generic-vs-custom decision, unless we're running with a row limit
+	 * (WITH NO DATA), in which case the timing wouldn't reflect the plan's
+	 * full cost.
+	 */
+	if (count == FETCH_ALL)
+	{
+		INSTR_TIME_SET_CURRENT(exec_start_time);
+
+		(void) PortalRun(portal, count, false, true, dest, dest, completionTag);
+
+		INSTR_TIME_SET_CURRENT(exec_end_time);
+		INSTR_TIME_SUBTRACT(exec_end_time, exec_start_time);
+		CachedPlanReportExecTime(entry->plansource, cplan,
+								 INSTR_TIME_GET_MILLISEC(exec_end_time));
+	}
+	else
+		(void) PortalRun(portal, count, false, true, dest, dest, completionTag);
 
 	PortalDrop(portal, false);
 
@@ -88,6 +88,15 @@ typedef SeqTableData *SeqTable;
 
 static HTAB *seqhashtab = NULL; /* hash table for SeqTable items */
 
+/*
+ * GUC: minimum number of values to cache per backend when fetching from a
+ * sequence, regardless of the sequence's own CACHE setting.  Raising this
+ * lets hot sequences hand out large per-backend ranges with a single buffer
+ * lock acquisition and WAL record per range, at the cost of losing more
+ * unused values when a backend exits or the server crashes.
+ */
+int			sequence_cache = 1;
+
 /*
  * last_used_seq is updated by nextval() to point to the last used
  * sequence.
@@ -642,6 +651,10 @@ nextval_internal(Oid relid, bool check_permissions)
 	cycle = pgsform->seqcycle;
 	ReleaseSysCache(pgstuple);
 
+	/* the sequence_cache GUC can only increase the amount we cache */
+	if (cache < sequence_cache)
+		cache = sequence_cache;
+
 	/* lock page' buffer and read tuple */
 	seq = read_seq_tuple(seqrel, &buf, &seqdatatuple);
 	page = BufferGetPage(buf);
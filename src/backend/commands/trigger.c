@@ -47,6 +47,7 @@
 #include "partitioning/partdesc.h"
 #include "pgstat.h"
 #include "rewrite/rewriteManip.h"
+#include "storage/buffile.h"
 #include "storage/bufmgr.h"
 #include "storage/lmgr.h"
 #include "tcop/utility.h"
@@ -65,6 +66,7 @@
 
 /* GUC variables */
 int			SessionReplicationRole = SESSION_REPLICATION_ROLE_ORIGIN;
+int			after_trigger_spill_threshold = -1;
 
 /* How many levels deep into trigger execution are we? */
 static int	MyTriggerDepth = 0;
@@ -3752,6 +3754,15 @@ typedef struct AfterTriggerEventList
  * tables is a List of AfterTriggersTableData structs for target tables
  * of the current query (see below).
  *
+ * spill_file, if not NULL, is a temporary file holding images of event
+ * chunks that were evicted from events because the query's event queue
+ * exceeded after_trigger_spill_threshold; spill_nchunks counts the images.
+ * Spilled chunks always hold events strictly older than anything still in
+ * events, and they are marked and fired before the in-memory list during
+ * AfterTriggerEndQuery.  replaying is set while that replay is in progress,
+ * to keep afterTriggerSpillEvents from evicting chunks that are being
+ * scanned.
+ *
  * maxquerydepth is just the allocated length of query_stack.
  *
  * trans_stack holds per-subtransaction data, including these fields:
@@ -3814,6 +3825,9 @@ struct AfterTriggersQueryData
 	AfterTriggerEventList events;	/* events pending from this query */
 	Tuplestorestate *fdw_tuplestore;	/* foreign tuples for said events */
 	List	   *tables;			/* list of AfterTriggersTableData, see below */
+	BufFile    *spill_file;		/* spilled event chunk images, or NULL */
+	int			spill_nchunks;	/* number of chunk images in spill_file */
+	bool		replaying;		/* spilled chunks are being replayed? */
 };
 
 struct AfterTriggersTransData
@@ -4587,6 +4601,269 @@ afterTriggerInvokeEvents(AfterTriggerEventList *events,
 }
 
 
+/* ----------
+ * afterTriggerSpillEvents()
+ *
+ *	If the query level's event list has grown past
+ *	after_trigger_spill_threshold, write head chunks out to a temporary
+ *	file so that the backend's memory usage stays bounded.  The chunk
+ *	images are read back, one at a time, by afterTriggerMarkSpilledEvents
+ *	and afterTriggerInvokeSpilledEvents during AfterTriggerEndQuery.
+ *
+ *	We never spill the tail chunk: events are still being appended to it,
+ *	and the shared-data search in afterTriggerAddEvent must be able to
+ *	see it.  We also don't spill at all once per-table data exists for
+ *	this query level.  That's partly because cancel_prior_stmt_triggers
+ *	keeps pointers into the list, and the statement-trigger events it may
+ *	need to cancel must stay reachable; and partly because events using
+ *	transition tables carry an ats_table pointer, whereas chunks we write
+ *	out must be relocatable.  With tables == NIL, every queued event has
+ *	ats_table == NULL and a chunk image contains no pointers other than
+ *	its own header fields.  Finally, we don't spill while the level's
+ *	events are being replayed, else we could yank chunks out from under
+ *	the scans in AfterTriggerEndQuery.
+ * ----------
+ */
+static void
+afterTriggerSpillEvents(AfterTriggersQueryData *qs)
+{
+	Size		threshold;
+	Size		total;
+	AfterTriggerEventChunk *chunk;
+
+	/* A single chunk can always stay in memory */
+	if (qs->events.head == qs->events.tail)
+		return;
+
+	/* See above: per-table data may hold pointers into the list */
+	if (qs->tables != NIL)
+		return;
+
+	/* Don't evict chunks that AfterTriggerEndQuery may be scanning */
+	if (qs->replaying)
+		return;
+
+	threshold = (Size) after_trigger_spill_threshold * 1024;
+
+	total = 0;
+	for (chunk = qs->events.head; chunk != NULL; chunk = chunk->next)
+		total += chunk->endptr - (char *) chunk;
+	if (total <= threshold)
+		return;
+
+	if (qs->spill_file == NULL)
+	{
+		MemoryContext oldcxt;
+		ResourceOwner saveResourceOwner;
+
+		/*
+		 * Make the file valid until end of subtransaction.  We really only
+		 * need it until AfterTriggerEndQuery().
+		 */
+		oldcxt = MemoryContextSwitchTo(CurTransactionContext);
+		saveResourceOwner = CurrentResourceOwner;
+		CurrentResourceOwner = CurTransactionResourceOwner;
+
+		qs->spill_file = BufFileCreateTemp(false);
+
+		CurrentResourceOwner = saveResourceOwner;
+		MemoryContextSwitchTo(oldcxt);
+	}
+
+	/*
+	 * Append whole head chunks until we're back under the threshold.  A
+	 * chunk image is its total size followed by its raw contents; the
+	 * header's pointer fields are written as-is, and are translated to the
+	 * chunk's new location when it is read back.  Appends and reads never
+	 * interleave (reads happen only during replay, when we don't spill), so
+	 * the file position is always at end-of-file here.
+	 */
+	while (total > threshold && qs->events.head != qs->events.tail)
+	{
+		AfterTriggerEventChunk *target = qs->events.head;
+		Size		chunksize = target->endptr - (char *) target;
+
+		if (BufFileWrite(qs->spill_file, &chunksize, sizeof(Size)) != sizeof(Size) ||
+			BufFileWrite(qs->spill_file, target, chunksize) != chunksize)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not write to after-trigger spill file: %m")));
+		qs->spill_nchunks++;
+
+		qs->events.head = target->next;
+		pfree(target);
+		total -= chunksize;
+	}
+}
+
+/*
+ * Read back one chunk image from a spill file, starting at the current read
+ * position.  The chunk is palloc'd in the current memory context; the caller
+ * is responsible for freeing it.
+ */
+static AfterTriggerEventChunk *
+afterTriggerReadSpilledChunk(BufFile *file, Size *chunksize)
+{
+	AfterTriggerEventChunk *chunk;
+	char	   *oldbase;
+
+	if (BufFileRead(file, chunksize, sizeof(Size)) != sizeof(Size))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from after-trigger spill file: %m")));
+	chunk = (AfterTriggerEventChunk *) palloc(*chunksize);
+	if (BufFileRead(file, chunk, *chunksize) != *chunksize)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from after-trigger spill file: %m")));
+
+	/* Translate the stored pointer fields to the chunk's new location */
+	oldbase = chunk->endptr - *chunksize;
+	chunk->next = NULL;
+	chunk->freeptr = (char *) chunk + (chunk->freeptr - oldbase);
+	chunk->endfree = (char *) chunk + (chunk->endfree - oldbase);
+	chunk->endptr = (char *) chunk + *chunksize;
+
+	return chunk;
+}
+
+/* ----------
+ * afterTriggerMarkSpilledEvents()
+ *
+ *	Run afterTriggerMarkEvents over each spilled chunk of the given query
+ *	level, holding only one chunk in memory at a time and writing the
+ *	updated event flags back to the spill file so that the invoke pass
+ *	(and any later mark passes) see them.
+ *
+ *	Returns true if any event was set up for firing.
+ * ----------
+ */
+static bool
+afterTriggerMarkSpilledEvents(AfterTriggersQueryData *qs,
+							  AfterTriggerEventList *move_list)
+{
+	bool		found = false;
+	int			nchunks = qs->spill_nchunks;
+	int			i;
+
+	if (BufFileSeek(qs->spill_file, 0, 0L, SEEK_SET) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not seek in after-trigger spill file: %m")));
+
+	for (i = 0; i < nchunks; i++)
+	{
+		AfterTriggerEventChunk *chunk;
+		Size		chunksize;
+		int			fileno;
+		off_t		offset;
+		AfterTriggerEventList tmp;
+
+		BufFileTell(qs->spill_file, &fileno, &offset);
+		chunk = afterTriggerReadSpilledChunk(qs->spill_file, &chunksize);
+
+		tmp.head = tmp.tail = chunk;
+		tmp.tailfree = chunk->freeptr;
+
+		if (afterTriggerMarkEvents(&tmp, move_list, true))
+			found = true;
+
+		/* Write the marked image back over the original */
+		if (BufFileSeek(qs->spill_file, fileno, offset, SEEK_SET) != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not seek in after-trigger spill file: %m")));
+		if (BufFileWrite(qs->spill_file, &chunksize, sizeof(Size)) != sizeof(Size) ||
+			BufFileWrite(qs->spill_file, chunk, chunksize) != chunksize)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not write to after-trigger spill file: %m")));
+
+		pfree(chunk);
+	}
+
+	return found;
+}
+
+/* ----------
+ * afterTriggerInvokeSpilledEvents()
+ *
+ *	Run afterTriggerInvokeEvents over each spilled chunk of the current
+ *	query level, again one chunk at a time with write-back.  If every
+ *	spilled event ends up fired or done, discard the spill file.
+ *
+ *	As with afterTriggerInvokeEvents, firing a trigger can repalloc
+ *	query_stack, so we must not touch the caller's qs pointer after
+ *	firing; the BufFile itself doesn't move.
+ *
+ *	Returns true if no unfired events remain in the spill file.
+ * ----------
+ */
+static bool
+afterTriggerInvokeSpilledEvents(AfterTriggersQueryData *qs,
+								CommandId firing_id, EState *estate)
+{
+	bool		all_fired = true;
+	BufFile    *file = qs->spill_file;
+	int			nchunks = qs->spill_nchunks;
+	int			i;
+
+	if (BufFileSeek(file, 0, 0L, SEEK_SET) != 0)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not seek in after-trigger spill file: %m")));
+
+	for (i = 0; i < nchunks; i++)
+	{
+		AfterTriggerEventChunk *chunk;
+		Size		chunksize;
+		int			fileno;
+		off_t		offset;
+		AfterTriggerEventList tmp;
+
+		BufFileTell(file, &fileno, &offset);
+		chunk = afterTriggerReadSpilledChunk(file, &chunksize);
+
+		tmp.head = tmp.tail = chunk;
+		tmp.tailfree = chunk->freeptr;
+
+		if (!afterTriggerInvokeEvents(&tmp, firing_id, estate, false))
+			all_fired = false;
+
+		/*
+		 * Write the events back with their DONE flags, so that later scans
+		 * don't re-fire them.  Triggers fired above may have moved the file
+		 * position, so seek explicitly.
+		 */
+		if (BufFileSeek(file, fileno, offset, SEEK_SET) != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not seek in after-trigger spill file: %m")));
+		if (BufFileWrite(file, &chunksize, sizeof(Size)) != sizeof(Size) ||
+			BufFileWrite(file, chunk, chunksize) != chunksize)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not write to after-trigger spill file: %m")));
+
+		pfree(chunk);
+	}
+
+	/* Recalculate qs in case the stack was repalloc'd (see above) */
+	qs = &afterTriggers.query_stack[afterTriggers.query_depth];
+
+	if (all_fired)
+	{
+		/* Everything in the file has been fired; discard it */
+		Assert(qs->spill_file == file && qs->spill_nchunks == nchunks);
+		qs->spill_file = NULL;
+		qs->spill_nchunks = 0;
+		BufFileClose(file);
+	}
+
+	return all_fired;
+}
+
+
 /*
  * GetAfterTriggersTableData
  *
@@ -4838,16 +5115,31 @@ AfterTriggerEndQuery(EState *estate)
 	 * firing_counter.
 	 */
 	qs = &afterTriggers.query_stack[afterTriggers.query_depth];
+	qs->replaying = true;
 
 	for (;;)
 	{
+		bool		found;
+
+		/*
+		 * Spilled chunks hold the oldest events of this query level, so
+		 * they must be marked, and below fired, before the in-memory list.
+		 */
+		found = false;
+		if (qs->spill_file != NULL)
+			found = afterTriggerMarkSpilledEvents(qs, &afterTriggers.events);
 		if (afterTriggerMarkEvents(&qs->events, &afterTriggers.events, true))
+			found = true;
+
+		if (found)
 		{
 			CommandId	firing_id = afterTriggers.firing_counter++;
 			AfterTriggerEventChunk *oldtail = qs->events.tail;
+			bool		all_fired = true;
 
-			if (afterTriggerInvokeEvents(&qs->events, firing_id, estate, false))
-				break;			/* all fired */
+			if (qs->spill_file != NULL &&
+				!afterTriggerInvokeSpilledEvents(qs, firing_id, estate))
+				all_fired = false;
 
 			/*
 			 * Firing a trigger could result in query_stack being repalloc'd,
@@ -4858,6 +5150,12 @@ AfterTriggerEndQuery(EState *estate)
 			 */
 			qs = &afterTriggers.query_stack[afterTriggers.query_depth];
 
+			if (!afterTriggerInvokeEvents(&qs->events, firing_id, estate, false))
+				all_fired = false;
+
+			if (all_fired)
+				break;			/* all fired */
+
 			/*
 			 * We'll need to scan the events list again.  To reduce the cost
 			 * of doing so, get rid of completely-fired chunks.  We know that
@@ -4894,12 +5192,21 @@ static void
 AfterTriggerFreeQuery(AfterTriggersQueryData *qs)
 {
 	Tuplestorestate *ts;
+	BufFile    *bf;
 	List	   *tables;
 	ListCell   *lc;
 
 	/* Drop the trigger events */
 	afterTriggerFreeEventList(&qs->events);
 
+	/* Drop the spill file if any */
+	bf = qs->spill_file;
+	qs->spill_file = NULL;
+	qs->spill_nchunks = 0;
+	qs->replaying = false;
+	if (bf)
+		BufFileClose(bf);
+
 	/* Drop FDW tuplestore if any */
 	ts = qs->fdw_tuplestore;
 	qs->fdw_tuplestore = NULL;
@@ -5236,6 +5543,9 @@ AfterTriggerEnlargeQueryState(void)
 		qs->events.tailfree = NULL;
 		qs->fdw_tuplestore = NULL;
 		qs->tables = NIL;
+		qs->spill_file = NULL;
+		qs->spill_nchunks = 0;
+		qs->replaying = false;
 
 		++init_depth;
 	}
@@ -5675,6 +5985,14 @@ AfterTriggerPendingOnRel(Oid relid)
 	 */
 	for (depth = 0; depth <= afterTriggers.query_depth && depth < afterTriggers.maxquerydepth; depth++)
 	{
+		/*
+		 * Conservatively assume that any spilled chunks contain pending
+		 * events; reading them back just to check isn't worth the cycles
+		 * for this corner case.
+		 */
+		if (afterTriggers.query_stack[depth].spill_file != NULL)
+			return true;
+
 		for_each_event_chunk(event, chunk, afterTriggers.query_stack[depth].events)
 		{
 			AfterTriggerShared evtshared = GetTriggerSharedData(event);
@@ -6028,6 +6346,13 @@ AfterTriggerSaveEvent(EState *estate, ResultRelInfo *relinfo,
 							 &new_event, &new_shared);
 	}
 
+	/*
+	 * If enabled, spill completed event chunks once the query's queue has
+	 * grown past after_trigger_spill_threshold.
+	 */
+	if (after_trigger_spill_threshold >= 0)
+		afterTriggerSpillEvents(&afterTriggers.query_stack[afterTriggers.query_depth]);
+
 	/*
 	 * Finally, spool any foreign tuple(s).  The tuplestore squashes them to
 	 * minimal tuples, so this loses any system columns.  The executor lost
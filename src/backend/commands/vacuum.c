@@ -41,6 +41,7 @@
 #include "miscadmin.h"
 #include "nodes/makefuncs.h"
 #include "pgstat.h"
+#include "portability/instr_time.h"
 #include "postmaster/autovacuum.h"
 #include "storage/bufmgr.h"
 #include "storage/lmgr.h"
@@ -59,6 +60,7 @@
  */
 int			vacuum_freeze_min_age;
 int			vacuum_freeze_table_age;
+int			vacuum_freeze_eager_pages;
 int			vacuum_multixact_freeze_min_age;
 int			vacuum_multixact_freeze_table_age;
 
@@ -67,6 +69,17 @@ int			vacuum_multixact_freeze_table_age;
 static MemoryContext vac_context = NULL;
 static BufferAccessStrategy vac_strategy;
 
+/* Maximum length of a single throttling nap, in msec */
+#define VACUUM_IO_MAX_NAP	1000
+
+/* Working state for the MB/s-based I/O throttle (see vacuum_io_delay) */
+static bool VacuumIOActive = false;
+static double VacuumIOReadTokens = 0;
+static double VacuumIOWriteTokens = 0;
+static int	VacuumIOLastPageMiss = 0;
+static int	VacuumIOLastPageDirty = 0;
+static instr_time VacuumIOLastCheck;
+
 
 /* non-export function prototypes */
 static List *expand_vacuum_rel(VacuumRelation *vrel, int options);
@@ -76,6 +89,7 @@ static void vac_truncate_clog(TransactionId frozenXID,
 							  TransactionId lastSaneFrozenXid,
 							  MultiXactId lastSaneMinMulti);
 static bool vacuum_rel(Oid relid, RangeVar *relation, VacuumParams *params);
+static void vacuum_io_delay(void);
 static VacOptTernaryValue get_vacopt_ternary_value(DefElem *def);
 
 /*
@@ -383,6 +397,12 @@ vacuum(List *relations, VacuumParams *params,
 		VacuumPageHit = 0;
 		VacuumPageMiss = 0;
 		VacuumPageDirty = 0;
+		VacuumIOActive = (VacuumIOReadLimit > 0 || VacuumIOWriteLimit > 0);
+		VacuumIOReadTokens = 0;
+		VacuumIOWriteTokens = 0;
+		VacuumIOLastPageMiss = 0;
+		VacuumIOLastPageDirty = 0;
+		INSTR_TIME_SET_CURRENT(VacuumIOLastCheck);
 
 		/*
 		 * Loop to process each selected relation.
@@ -434,12 +454,14 @@ vacuum(List *relations, VacuumParams *params,
 	{
 		in_vacuum = false;
 		VacuumCostActive = false;
+		VacuumIOActive = false;
 		PG_RE_THROW();
 	}
 	PG_END_TRY();
 
 	in_vacuum = false;
 	VacuumCostActive = false;
+	VacuumIOActive = false;
 
 	/*
 	 * Finish up processing.
@@ -1657,6 +1679,7 @@ vacuum_rel(Oid relid, RangeVar *relation, VacuumParams *params)
 		MyPgXact->vacuumFlags |= PROC_IN_VACUUM;
 		if (params->is_wraparound)
 			MyPgXact->vacuumFlags |= PROC_VACUUM_FOR_WRAPAROUND;
+		ProcGlobal->vacuumFlags[MyProc->pgxactoff] = MyPgXact->vacuumFlags;
 		LWLockRelease(ProcArrayLock);
 	}
 
@@ -1930,6 +1953,70 @@ vac_close_indexes(int nindexes, Relation *Irel, LOCKMODE lockmode)
 	pfree(Irel);
 }
 
+/*
+ * vacuum_io_delay --- throttle vacuum against its direct I/O budget.
+ *
+ * Unlike the cost-based delay, which naps on an abstract ledger that maps
+ * to actual disk throughput only after per-installation tuning, this keeps
+ * one token bucket per direction refilled at VacuumIOReadLimit resp.
+ * VacuumIOWriteLimit MB/s.  Pages read and dirtied are charged against the
+ * buckets by watching the VacuumPageMiss/VacuumPageDirty counters that
+ * bufmgr.c already maintains, and we sleep whenever a bucket is overdrawn.
+ * Each bucket holds at most one second's worth of budget, so a vacuum that
+ * stalls on CPU work cannot bank an unbounded I/O burst.
+ *
+ * The limits are reread on every call, so rebalancing of the cluster-wide
+ * budget by autovac_balance_cost takes effect at the next delay point.
+ */
+static void
+vacuum_io_delay(void)
+{
+	double		read_rate = VacuumIOReadLimit * 1024.0 * 1024.0;
+	double		write_rate = VacuumIOWriteLimit * 1024.0 * 1024.0;
+	instr_time	now;
+	double		elapsed_sec;
+	double		msec = 0;
+
+	/* Charge the pages read and dirtied since the last check */
+	VacuumIOReadTokens -=
+		(double) (VacuumPageMiss - VacuumIOLastPageMiss) * BLCKSZ;
+	VacuumIOWriteTokens -=
+		(double) (VacuumPageDirty - VacuumIOLastPageDirty) * BLCKSZ;
+	VacuumIOLastPageMiss = VacuumPageMiss;
+	VacuumIOLastPageDirty = VacuumPageDirty;
+
+	/* Refill the buckets for the elapsed wall-clock time */
+	INSTR_TIME_SET_CURRENT(now);
+	elapsed_sec = INSTR_TIME_GET_DOUBLE(now) -
+		INSTR_TIME_GET_DOUBLE(VacuumIOLastCheck);
+	VacuumIOLastCheck = now;
+	if (read_rate > 0)
+		VacuumIOReadTokens = Min(VacuumIOReadTokens + elapsed_sec * read_rate,
+								 read_rate);
+	if (write_rate > 0)
+		VacuumIOWriteTokens = Min(VacuumIOWriteTokens + elapsed_sec * write_rate,
+								  write_rate);
+
+	/*
+	 * Sleep just long enough for the next refill to cover the deeper of the
+	 * two deficits.  The tokens stay negative across the nap; they are made
+	 * whole by the elapsed-time refill on the next call.
+	 */
+	if (read_rate > 0 && VacuumIOReadTokens < 0)
+		msec = -VacuumIOReadTokens / read_rate * 1000.0;
+	if (write_rate > 0 && VacuumIOWriteTokens < 0)
+		msec = Max(msec, -VacuumIOWriteTokens / write_rate * 1000.0);
+
+	if (msec > 0)
+	{
+		msec = Min(msec, VACUUM_IO_MAX_NAP);
+		pg_usleep((long) (msec * 1000));
+
+		/* Might have gotten an interrupt while sleeping */
+		CHECK_FOR_INTERRUPTS();
+	}
+}
+
 /*
  * vacuum_delay_point --- check for interrupts and cost-based delay.
  *
@@ -1942,6 +2029,10 @@ vacuum_delay_point(void)
 	/* Always check for interrupts */
 	CHECK_FOR_INTERRUPTS();
 
+	/* Throttle against the direct I/O budget, if one is configured */
+	if (VacuumIOActive && !InterruptPending)
+		vacuum_io_delay();
+
 	/* Nap if appropriate */
 	if (VacuumCostActive && !InterruptPending &&
 		VacuumCostBalance >= VacuumCostLimit)
@@ -59,6 +59,7 @@
 #include "access/heaptoast.h"
 #include "catalog/pg_type.h"
 #include "commands/sequence.h"
+#include "common/int.h"
 #include "executor/execExpr.h"
 #include "executor/nodeSubplan.h"
 #include "funcapi.h"
@@ -72,6 +73,7 @@
 #include "utils/date.h"
 #include "utils/datum.h"
 #include "utils/expandedrecord.h"
+#include "utils/float.h"
 #include "utils/lsyscache.h"
 #include "utils/timestamp.h"
 #include "utils/typcache.h"
@@ -159,6 +161,7 @@ static Datum ExecJustAssignInnerVar(ExprState *state, ExprContext *econtext, boo
 static Datum ExecJustAssignOuterVar(ExprState *state, ExprContext *econtext, bool *isnull);
 static Datum ExecJustAssignScanVar(ExprState *state, ExprContext *econtext, bool *isnull);
 static Datum ExecJustApplyFuncToCase(ExprState *state, ExprContext *econtext, bool *isnull);
+static Datum ExecJustScanQual(ExprState *state, ExprContext *econtext, bool *isnull);
 static Datum ExecJustConst(ExprState *state, ExprContext *econtext, bool *isnull);
 static Datum ExecJustInnerVarVirt(ExprState *state, ExprContext *econtext, bool *isnull);
 static Datum ExecJustOuterVarVirt(ExprState *state, ExprContext *econtext, bool *isnull);
@@ -167,6 +170,18 @@ static Datum ExecJustAssignInnerVarVirt(ExprState *state, ExprContext *econtext,
 static Datum ExecJustAssignOuterVarVirt(ExprState *state, ExprContext *econtext, bool *isnull);
 static Datum ExecJustAssignScanVarVirt(ExprState *state, ExprContext *econtext, bool *isnull);
 
+/* execution helper functions */
+static pg_attribute_always_inline void ExecAggPlainTransByVal(AggState *aggstate,
+															  AggStatePerTrans pertrans,
+															  AggStatePerGroup pergroup,
+															  ExprContext *aggcontext,
+															  int setno);
+static pg_attribute_always_inline void ExecAggPlainTransByRef(AggState *aggstate,
+															  AggStatePerTrans pertrans,
+															  AggStatePerGroup pergroup,
+															  ExprContext *aggcontext,
+															  int setno);
+
 
 /*
  * Prepare ExprState for interpreted execution.
@@ -301,6 +316,53 @@ ExecReadyInterpretedExpr(ExprState *state)
 			return;
 		}
 	}
+	else if (state->steps_len == 5 || state->steps_len == 6)
+	{
+		/*
+		 * A very common shape for simple scan quals: deform the scan tuple,
+		 * load one or two function arguments from it (or from a constant),
+		 * apply a strict function, and check its result as a qual.  Fusing
+		 * those steps into one routine roughly halves the dispatch overhead
+		 * per tuple for filter-heavy scans.
+		 */
+		int			nargsteps = state->steps_len - 4;
+		ExprEvalStep *funcstep = &state->steps[1 + nargsteps];
+
+		if (state->steps[0].opcode == EEOP_SCAN_FETCHSOME &&
+			funcstep->opcode == EEOP_FUNCEXPR_STRICT &&
+			funcstep->d.func.nargs == nargsteps &&
+			state->steps[2 + nargsteps].opcode == EEOP_QUAL)
+		{
+			FunctionCallInfo fcinfo = funcstep->d.func.fcinfo_data;
+			bool		matched = true;
+			int			argno;
+
+			/*
+			 * Each argument must be computed by exactly one step, writing
+			 * straight into the function's argument slot.  That holds for
+			 * plain Vars and Consts; anything fancier doesn't match this
+			 * shape anyway, but be paranoid and verify.
+			 */
+			for (argno = 0; argno < nargsteps; argno++)
+			{
+				ExprEvalStep *argstep = &state->steps[1 + argno];
+
+				if ((argstep->opcode != EEOP_SCAN_VAR &&
+					 argstep->opcode != EEOP_CONST) ||
+					argstep->resvalue != &fcinfo->args[argno].value)
+				{
+					matched = false;
+					break;
+				}
+			}
+
+			if (matched)
+			{
+				state->evalfunc_private = (void *) ExecJustScanQual;
+				return;
+			}
+		}
+	}
 
 #if defined(EEO_USE_COMPUTED_GOTO)
 
@@ -430,10 +492,12 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 		&&CASE_EEOP_AGG_DESERIALIZE,
 		&&CASE_EEOP_AGG_STRICT_INPUT_CHECK_ARGS,
 		&&CASE_EEOP_AGG_STRICT_INPUT_CHECK_NULLS,
-		&&CASE_EEOP_AGG_INIT_TRANS,
-		&&CASE_EEOP_AGG_STRICT_TRANS_CHECK,
+		&&CASE_EEOP_AGG_PLAIN_TRANS_INIT_STRICT_BYVAL,
+		&&CASE_EEOP_AGG_PLAIN_TRANS_STRICT_BYVAL,
 		&&CASE_EEOP_AGG_PLAIN_TRANS_BYVAL,
-		&&CASE_EEOP_AGG_PLAIN_TRANS,
+		&&CASE_EEOP_AGG_PLAIN_TRANS_INIT_STRICT_BYREF,
+		&&CASE_EEOP_AGG_PLAIN_TRANS_STRICT_BYREF,
+		&&CASE_EEOP_AGG_PLAIN_TRANS_BYREF,
 		&&CASE_EEOP_AGG_ORDERED_TRANS_DATUM,
 		&&CASE_EEOP_AGG_ORDERED_TRANS_TUPLE,
 		&&CASE_EEOP_LAST
@@ -1549,7 +1613,7 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 		EEO_CASE(EEOP_AGG_DESERIALIZE)
 		{
 			FunctionCallInfo fcinfo = op->d.agg_deserialize.fcinfo_data;
-			AggState   *aggstate = op->d.agg_deserialize.aggstate;
+			AggState   *aggstate = castNode(AggState, state->parent);
 			MemoryContext oldContext;
 
 			/*
@@ -1598,68 +1662,73 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 		}
 
 		/*
-		 * Initialize an aggregate's first value if necessary.
+		 * There are three specialized cases for aggregate transition function
+		 * invocations with a by-value transition type.  Which one is used is
+		 * determined while building the expression, to avoid incurring
+		 * unnecessary per-input-row branches at execution time.
 		 */
-		EEO_CASE(EEOP_AGG_INIT_TRANS)
+
+		/* when transvalue has not been initialized */
+		EEO_CASE(EEOP_AGG_PLAIN_TRANS_INIT_STRICT_BYVAL)
 		{
-			AggState   *aggstate;
+			AggState   *aggstate = castNode(AggState, state->parent);
+			AggStatePerTrans pertrans = op->d.agg_trans.pertrans;
 			AggStatePerGroup pergroup;
 
-			aggstate = op->d.agg_init_trans.aggstate;
 			pergroup = &aggstate->all_pergroups
-				[op->d.agg_init_trans.setoff]
-				[op->d.agg_init_trans.transno];
+				[op->d.agg_trans.setoff]
+				[op->d.agg_trans.transno];
+
+			Assert(pertrans->transtypeByVal);
 
-			/* If transValue has not yet been initialized, do so now. */
 			if (pergroup->noTransValue)
 			{
-				AggStatePerTrans pertrans = op->d.agg_init_trans.pertrans;
-
-				aggstate->curaggcontext = op->d.agg_init_trans.aggcontext;
-				aggstate->current_set = op->d.agg_init_trans.setno;
+				/* If transValue has not yet been initialized, do so now. */
+				aggstate->curaggcontext = op->d.agg_trans.aggcontext;
+				aggstate->current_set = op->d.agg_trans.setno;
 
 				ExecAggInitGroup(aggstate, pertrans, pergroup);
 
 				/* copied trans value from input, done this round */
-				EEO_JUMP(op->d.agg_init_trans.jumpnull);
+			}
+			else if (likely(!pergroup->transValueIsNull))
+			{
+				/* invoke transition function, unless prevented by strictness */
+				ExecAggPlainTransByVal(aggstate, pertrans, pergroup,
+									   op->d.agg_trans.aggcontext,
+									   op->d.agg_trans.setno);
 			}
 
 			EEO_NEXT();
 		}
 
-		/* check that a strict aggregate's input isn't NULL */
-		EEO_CASE(EEOP_AGG_STRICT_TRANS_CHECK)
+		/* strict, but transvalue was initialized to begin with */
+		EEO_CASE(EEOP_AGG_PLAIN_TRANS_STRICT_BYVAL)
 		{
-			AggState   *aggstate;
+			AggState   *aggstate = castNode(AggState, state->parent);
+			AggStatePerTrans pertrans = op->d.agg_trans.pertrans;
 			AggStatePerGroup pergroup;
 
-			aggstate = op->d.agg_strict_trans_check.aggstate;
 			pergroup = &aggstate->all_pergroups
-				[op->d.agg_strict_trans_check.setoff]
-				[op->d.agg_strict_trans_check.transno];
+				[op->d.agg_trans.setoff]
+				[op->d.agg_trans.transno];
 
-			if (unlikely(pergroup->transValueIsNull))
-				EEO_JUMP(op->d.agg_strict_trans_check.jumpnull);
+			Assert(pertrans->transtypeByVal);
+
+			if (likely(!pergroup->transValueIsNull))
+				ExecAggPlainTransByVal(aggstate, pertrans, pergroup,
+									   op->d.agg_trans.aggcontext,
+									   op->d.agg_trans.setno);
 
 			EEO_NEXT();
 		}
 
-		/*
-		 * Evaluate aggregate transition / combine function that has a
-		 * by-value transition type. That's a separate case from the
-		 * by-reference implementation because it's a bit simpler.
-		 */
+		/* invoke transition function, without strictness checks */
 		EEO_CASE(EEOP_AGG_PLAIN_TRANS_BYVAL)
 		{
-			AggState   *aggstate;
-			AggStatePerTrans pertrans;
+			AggState   *aggstate = castNode(AggState, state->parent);
+			AggStatePerTrans pertrans = op->d.agg_trans.pertrans;
 			AggStatePerGroup pergroup;
-			FunctionCallInfo fcinfo;
-			MemoryContext oldContext;
-			Datum		newVal;
-
-			aggstate = op->d.agg_trans.aggstate;
-			pertrans = op->d.agg_trans.pertrans;
 
 			pergroup = &aggstate->all_pergroups
 				[op->d.agg_trans.setoff]
@@ -1667,50 +1736,60 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 
 			Assert(pertrans->transtypeByVal);
 
-			fcinfo = pertrans->transfn_fcinfo;
+			ExecAggPlainTransByVal(aggstate, pertrans, pergroup,
+								   op->d.agg_trans.aggcontext,
+								   op->d.agg_trans.setno);
 
-			/* cf. select_current_set() */
-			aggstate->curaggcontext = op->d.agg_trans.aggcontext;
-			aggstate->current_set = op->d.agg_trans.setno;
+			EEO_NEXT();
+		}
 
-			/* set up aggstate->curpertrans for AggGetAggref() */
-			aggstate->curpertrans = pertrans;
+		/*
+		 * And the same three cases for by-reference transition types.  The
+		 * by-reference implementation additionally needs to reparent the
+		 * transition value into the aggregate context if the transition
+		 * function returned a freshly allocated datum.
+		 */
 
-			/* invoke transition function in per-tuple context */
-			oldContext = MemoryContextSwitchTo(aggstate->tmpcontext->ecxt_per_tuple_memory);
+		/* when transvalue has not been initialized */
+		EEO_CASE(EEOP_AGG_PLAIN_TRANS_INIT_STRICT_BYREF)
+		{
+			AggState   *aggstate = castNode(AggState, state->parent);
+			AggStatePerTrans pertrans = op->d.agg_trans.pertrans;
+			AggStatePerGroup pergroup;
+
+			pergroup = &aggstate->all_pergroups
+				[op->d.agg_trans.setoff]
+				[op->d.agg_trans.transno];
 
-			fcinfo->args[0].value = pergroup->transValue;
-			fcinfo->args[0].isnull = pergroup->transValueIsNull;
-			fcinfo->isnull = false; /* just in case transfn doesn't set it */
+			Assert(!pertrans->transtypeByVal);
 
-			newVal = FunctionCallInvoke(fcinfo);
+			if (pergroup->noTransValue)
+			{
+				/* If transValue has not yet been initialized, do so now. */
+				aggstate->curaggcontext = op->d.agg_trans.aggcontext;
+				aggstate->current_set = op->d.agg_trans.setno;
 
-			pergroup->transValue = newVal;
-			pergroup->transValueIsNull = fcinfo->isnull;
+				ExecAggInitGroup(aggstate, pertrans, pergroup);
 
-			MemoryContextSwitchTo(oldContext);
+				/* copied trans value from input, done this round */
+			}
+			else if (likely(!pergroup->transValueIsNull))
+			{
+				/* invoke transition function, unless prevented by strictness */
+				ExecAggPlainTransByRef(aggstate, pertrans, pergroup,
+									   op->d.agg_trans.aggcontext,
+									   op->d.agg_trans.setno);
+			}
 
 			EEO_NEXT();
 		}
 
-		/*
-		 * Evaluate aggregate transition / combine function that has a
-		 * by-reference transition type.
-		 *
-		 * Could optimize a bit further by splitting off by-reference
-		 * fixed-length types, but currently that doesn't seem worth it.
-		 */
-		EEO_CASE(EEOP_AGG_PLAIN_TRANS)
+		/* strict, but transvalue was initialized to begin with */
+		EEO_CASE(EEOP_AGG_PLAIN_TRANS_STRICT_BYREF)
 		{
-			AggState   *aggstate;
-			AggStatePerTrans pertrans;
+			AggState   *aggstate = castNode(AggState, state->parent);
+			AggStatePerTrans pertrans = op->d.agg_trans.pertrans;
 			AggStatePerGroup pergroup;
-			FunctionCallInfo fcinfo;
-			MemoryContext oldContext;
-			Datum		newVal;
-
-			aggstate = op->d.agg_trans.aggstate;
-			pertrans = op->d.agg_trans.pertrans;
 
 			pergroup = &aggstate->all_pergroups
 				[op->d.agg_trans.setoff]
@@ -1718,42 +1797,30 @@ ExecInterpExpr(ExprState *state, ExprContext *econtext, bool *isnull)
 
 			Assert(!pertrans->transtypeByVal);
 
-			fcinfo = pertrans->transfn_fcinfo;
-
-			/* cf. select_current_set() */
-			aggstate->curaggcontext = op->d.agg_trans.aggcontext;
-			aggstate->current_set = op->d.agg_trans.setno;
+			if (likely(!pergroup->transValueIsNull))
+				ExecAggPlainTransByRef(aggstate, pertrans, pergroup,
+									   op->d.agg_trans.aggcontext,
+									   op->d.agg_trans.setno);
 
-			/* set up aggstate->curpertrans for AggGetAggref() */
-			aggstate->curpertrans = pertrans;
-
-			/* invoke transition function in per-tuple context */
-			oldContext = MemoryContextSwitchTo(aggstate->tmpcontext->ecxt_per_tuple_memory);
-
-			fcinfo->args[0].value = pergroup->transValue;
-			fcinfo->args[0].isnull = pergroup->transValueIsNull;
-			fcinfo->isnull = false; /* just in case transfn doesn't set it */
+			EEO_NEXT();
+		}
 
-			newVal = FunctionCallInvoke(fcinfo);
+		/* invoke transition function, without strictness checks */
+		EEO_CASE(EEOP_AGG_PLAIN_TRANS_BYREF)
+		{
+			AggState   *aggstate = castNode(AggState, state->parent);
+			AggStatePerTrans pertrans = op->d.agg_trans.pertrans;
+			AggStatePerGroup pergroup;
 
-			/*
-			 * For pass-by-ref datatype, must copy the new value into
-			 * aggcontext and free the prior transValue.  But if transfn
-			 * returned a pointer to its first input, we don't need to do
-			 * anything.  Also, if transfn returned a pointer to a R/W
-			 * expanded object that is already a child of the aggcontext,
-			 * assume we can adopt that value without copying it.
-			 */
-			if (DatumGetPointer(newVal) != DatumGetPointer(pergroup->transValue))
-				newVal = ExecAggTransReparent(aggstate, pertrans,
-											  newVal, fcinfo->isnull,
-											  pergroup->transValue,
-											  pergroup->transValueIsNull);
+			pergroup = &aggstate->all_pergroups
+				[op->d.agg_trans.setoff]
+				[op->d.agg_trans.transno];
 
-			pergroup->transValue = newVal;
-			pergroup->transValueIsNull = fcinfo->isnull;
+			Assert(!pertrans->transtypeByVal);
 
-			MemoryContextSwitchTo(oldContext);
+			ExecAggPlainTransByRef(aggstate, pertrans, pergroup,
+								   op->d.agg_trans.aggcontext,
+								   op->d.agg_trans.setno);
 
 			EEO_NEXT();
 		}
@@ -2126,6 +2193,63 @@ ExecJustApplyFuncToCase(ExprState *state, ExprContext *econtext, bool *isnull)
 	return d;
 }
 
+/* Apply a strict function to scan Vars and/or Consts, qual-checking result */
+static Datum
+ExecJustScanQual(ExprState *state, ExprContext *econtext, bool *isnull)
+{
+	TupleTableSlot *slot = econtext->ecxt_scantuple;
+	int			nargsteps = state->steps_len - 4;
+	ExprEvalStep *op;
+	FunctionCallInfo fcinfo;
+	NullableDatum *args;
+	int			argno;
+	Datum		d;
+
+	CheckOpSlotCompatibility(&state->steps[0], slot);
+
+	/*
+	 * Evaluate the argument steps.  Since we use slot_getattr(), we don't
+	 * need to implement the FETCHSOME step explicitly, and we also needn't
+	 * Assert that the attnum is in range --- slot_getattr() will take care
+	 * of any problems.
+	 */
+	for (argno = 0; argno < nargsteps; argno++)
+	{
+		op = &state->steps[1 + argno];
+
+		if (op->opcode == EEOP_SCAN_VAR)
+			*op->resvalue = slot_getattr(slot, op->d.var.attnum + 1,
+										 op->resnull);
+		else
+		{
+			Assert(op->opcode == EEOP_CONST);
+			*op->resvalue = op->d.constval.value;
+			*op->resnull = op->d.constval.isnull;
+		}
+	}
+
+	op = &state->steps[1 + nargsteps];
+	fcinfo = op->d.func.fcinfo_data;
+	args = fcinfo->args;
+
+	*isnull = false;
+
+	/* strict function, so a NULL arg makes the qual fail outright */
+	for (argno = 0; argno < op->d.func.nargs; argno++)
+	{
+		if (args[argno].isnull)
+			return BoolGetDatum(false);
+	}
+	fcinfo->isnull = false;
+	d = op->d.func.fn_addr(fcinfo);
+
+	/* as in EEOP_QUAL, a null result also counts as false */
+	if (fcinfo->isnull || !DatumGetBool(d))
+		return BoolGetDatum(false);
+
+	return BoolGetDatum(true);
+}
+
 /* Simple Const expression */
 static Datum
 ExecJustConst(ExprState *state, ExprContext *econtext, bool *isnull)
@@ -4150,6 +4274,193 @@ ExecEvalSysVar(ExprState *state, ExprEvalStep *op, ExprContext *econtext,
 		elog(ERROR, "failed to fetch attribute from slot");
 }
 
+/*
+ * Evaluate aggregate transition / combine function that has a by-value
+ * transition type. That's a separate case from the by-reference
+ * implementation because it's a bit simpler.
+ */
+static pg_attribute_always_inline void
+ExecAggPlainTransByVal(AggState *aggstate, AggStatePerTrans pertrans,
+					   AggStatePerGroup pergroup,
+					   ExprContext *aggcontext, int setno)
+{
+	FunctionCallInfo fcinfo = pertrans->transfn_fcinfo;
+	MemoryContext oldContext;
+	Datum		newVal;
+
+	/*
+	 * If the transition function was recognized as one of the supported
+	 * built-ins, apply it inline.  The kernels neither allocate memory nor
+	 * examine the calling context, so no memory context switch or curpertrans
+	 * setup is required.  Strictness has already been handled: for the strict
+	 * kernels the caller and the preceding EEOP_AGG_STRICT_INPUT_CHECK_* step
+	 * guarantee non-null transition value and arguments, while the only
+	 * non-strict kernel (int4_sum) deals with nulls itself, just as the
+	 * built-in does.
+	 */
+	switch (pertrans->transKernel)
+	{
+		case AGG_TRANSKERNEL_NONE:
+			break;
+
+		case AGG_TRANSKERNEL_INT8INC:
+			{
+				int64		result;
+
+				if (unlikely(pg_add_s64_overflow(DatumGetInt64(pergroup->transValue),
+												 1, &result)))
+					ereport(ERROR,
+							(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+							 errmsg("bigint out of range")));
+				pergroup->transValue = Int64GetDatum(result);
+				return;
+			}
+
+		case AGG_TRANSKERNEL_INT8PL:
+			{
+				int64		result;
+
+				if (unlikely(pg_add_s64_overflow(DatumGetInt64(pergroup->transValue),
+												 DatumGetInt64(fcinfo->args[1].value),
+												 &result)))
+					ereport(ERROR,
+							(errcode(ERRCODE_NUMERIC_VALUE_OUT_OF_RANGE),
+							 errmsg("bigint out of range")));
+				pergroup->transValue = Int64GetDatum(result);
+				return;
+			}
+
+		case AGG_TRANSKERNEL_INT4_SUM:
+			if (fcinfo->args[1].isnull)
+				return;			/* sum unchanged by null inputs */
+			if (pergroup->transValueIsNull)
+			{
+				pergroup->transValue =
+					Int64GetDatum((int64) DatumGetInt32(fcinfo->args[1].value));
+				pergroup->transValueIsNull = false;
+			}
+			else
+				pergroup->transValue =
+					Int64GetDatum(DatumGetInt64(pergroup->transValue) +
+								  (int64) DatumGetInt32(fcinfo->args[1].value));
+			return;
+
+		case AGG_TRANSKERNEL_FLOAT8PL:
+			pergroup->transValue =
+				Float8GetDatum(float8_pl(DatumGetFloat8(pergroup->transValue),
+										 DatumGetFloat8(fcinfo->args[1].value)));
+			return;
+
+		case AGG_TRANSKERNEL_INT4_MIN:
+			if (DatumGetInt32(fcinfo->args[1].value) <
+				DatumGetInt32(pergroup->transValue))
+				pergroup->transValue = fcinfo->args[1].value;
+			return;
+
+		case AGG_TRANSKERNEL_INT4_MAX:
+			if (DatumGetInt32(fcinfo->args[1].value) >
+				DatumGetInt32(pergroup->transValue))
+				pergroup->transValue = fcinfo->args[1].value;
+			return;
+
+		case AGG_TRANSKERNEL_INT8_MIN:
+			if (DatumGetInt64(fcinfo->args[1].value) <
+				DatumGetInt64(pergroup->transValue))
+				pergroup->transValue = fcinfo->args[1].value;
+			return;
+
+		case AGG_TRANSKERNEL_INT8_MAX:
+			if (DatumGetInt64(fcinfo->args[1].value) >
+				DatumGetInt64(pergroup->transValue))
+				pergroup->transValue = fcinfo->args[1].value;
+			return;
+
+		case AGG_TRANSKERNEL_FLOAT8_MIN:
+			if (float8_lt(DatumGetFloat8(fcinfo->args[1].value),
+						  DatumGetFloat8(pergroup->transValue)))
+				pergroup->transValue = fcinfo->args[1].value;
+			return;
+
+		case AGG_TRANSKERNEL_FLOAT8_MAX:
+			if (float8_gt(DatumGetFloat8(fcinfo->args[1].value),
+						  DatumGetFloat8(pergroup->transValue)))
+				pergroup->transValue = fcinfo->args[1].value;
+			return;
+	}
+
+	/* cf. select_current_set() */
+	aggstate->curaggcontext = aggcontext;
+	aggstate->current_set = setno;
+
+	/* set up aggstate->curpertrans for AggGetAggref() */
+	aggstate->curpertrans = pertrans;
+
+	/* invoke transition function in per-tuple context */
+	oldContext = MemoryContextSwitchTo(aggstate->tmpcontext->ecxt_per_tuple_memory);
+
+	fcinfo->args[0].value = pergroup->transValue;
+	fcinfo->args[0].isnull = pergroup->transValueIsNull;
+	fcinfo->isnull = false;		/* just in case transfn doesn't set it */
+
+	newVal = FunctionCallInvoke(fcinfo);
+
+	pergroup->transValue = newVal;
+	pergroup->transValueIsNull = fcinfo->isnull;
+
+	MemoryContextSwitchTo(oldContext);
+}
+
+/*
+ * Evaluate aggregate transition / combine function that has a by-reference
+ * transition type.
+ *
+ * Could optimize a bit further by splitting off by-reference fixed-length
+ * types, but currently that doesn't seem worth it.
+ */
+static pg_attribute_always_inline void
+ExecAggPlainTransByRef(AggState *aggstate, AggStatePerTrans pertrans,
+					   AggStatePerGroup pergroup,
+					   ExprContext *aggcontext, int setno)
+{
+	FunctionCallInfo fcinfo = pertrans->transfn_fcinfo;
+	MemoryContext oldContext;
+	Datum		newVal;
+
+	/* cf. select_current_set() */
+	aggstate->curaggcontext = aggcontext;
+	aggstate->current_set = setno;
+
+	/* set up aggstate->curpertrans for AggGetAggref() */
+	aggstate->curpertrans = pertrans;
+
+	/* invoke transition function in per-tuple context */
+	oldContext = MemoryContextSwitchTo(aggstate->tmpcontext->ecxt_per_tuple_memory);
+
+	fcinfo->args[0].value = pergroup->transValue;
+	fcinfo->args[0].isnull = pergroup->transValueIsNull;
+	fcinfo->isnull = false;		/* just in case transfn doesn't set it */
+
+	newVal = FunctionCallInvoke(fcinfo);
+
+	/*
+	 * For pass-by-ref datatype, must copy the new value into aggcontext and
+	 * free the prior transValue.  But if transfn returned a pointer to its
+	 * first input, we don't need to do anything.  Also, if transfn returned a
+	 * pointer to a R/W expanded object that is already a child of the
+	 * aggcontext, assume we can adopt that value without copying it.
+	 */
+	if (DatumGetPointer(newVal) != DatumGetPointer(pergroup->transValue))
+		newVal = ExecAggTransReparent(aggstate, pertrans,
+									  newVal, fcinfo->isnull,
+									  pergroup->transValue,
+									  pergroup->transValueIsNull);
+
+	pergroup->transValue = newVal;
+	pergroup->transValueIsNull = fcinfo->isnull;
+
+	MemoryContextSwitchTo(oldContext);
+}
+
 /*
  * Transition value has not been initialized. This is the first non-NULL input
  * value for a group. We use it as the initial value for transValue.
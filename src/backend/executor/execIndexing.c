@@ -461,6 +461,158 @@ ExecInsertIndexTuples(TupleTableSlot *slot,
 	return result;
 }
 
+/* ----------------------------------------------------------------
+ *		ExecInsertIndexTuplesBatch
+ *
+ *		This routine takes care of inserting index tuples for a
+ *		batch of heap tuples at once, letting index AMs with batch
+ *		support lay out the work efficiently.
+ *
+ *		It can only be used when no index needs uniqueness checking:
+ *		if any index is unique or has an exclusion constraint, it
+ *		returns false without inserting anything and the caller must
+ *		fall back to calling ExecInsertIndexTuples() per tuple.
+ *		Returns true if all index entries were inserted.
+ *
+ *		CAUTION: as above, this must not be called for HOT updates.
+ * ----------------------------------------------------------------
+ */
+bool
+ExecInsertIndexTuplesBatch(TupleTableSlot **slots,
+						   int ntuples,
+						   EState *estate)
+{
+	ResultRelInfo *resultRelInfo;
+	int			i;
+	int			numIndices;
+	RelationPtr relationDescs;
+	Relation	heapRelation;
+	IndexInfo **indexInfoArray;
+	ExprContext *econtext;
+	MemoryContext oldContext;
+	Datum	  **values = NULL;
+	bool	  **isnull = NULL;
+	ItemPointer *tids = NULL;
+
+	/*
+	 * Get information from the result relation info structure.
+	 */
+	resultRelInfo = estate->es_result_relation_info;
+	numIndices = resultRelInfo->ri_NumIndices;
+	relationDescs = resultRelInfo->ri_IndexRelationDescs;
+	indexInfoArray = resultRelInfo->ri_IndexRelationInfo;
+	heapRelation = resultRelInfo->ri_RelationDesc;
+
+	/*
+	 * First check that no index requires uniqueness or exclusion checking;
+	 * the batch path has no way to report rechecks back per tuple.
+	 */
+	for (i = 0; i < numIndices; i++)
+	{
+		Relation	indexRelation = relationDescs[i];
+
+		if (indexRelation == NULL)
+			continue;
+		if (!indexInfoArray[i]->ii_ReadyForInserts)
+			continue;
+		if (indexRelation->rd_index->indisunique ||
+			indexInfoArray[i]->ii_ExclusionOps != NULL)
+			return false;
+	}
+
+	/*
+	 * We will use the EState's per-tuple context for evaluating predicates
+	 * and index expressions, and for the batch arrays themselves (the
+	 * caller is expected to reset it between batches).
+	 */
+	econtext = GetPerTupleExprContext(estate);
+
+	for (i = 0; i < numIndices; i++)
+	{
+		Relation	indexRelation = relationDescs[i];
+		IndexInfo  *indexInfo;
+		int			nvalid;
+		int			j;
+
+		if (indexRelation == NULL)
+			continue;
+
+		indexInfo = indexInfoArray[i];
+
+		/* If the index is marked as read-only, ignore it */
+		if (!indexInfo->ii_ReadyForInserts)
+			continue;
+
+		/* Allocate the per-tuple column arrays on first use */
+		if (values == NULL)
+		{
+			oldContext = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
+			values = (Datum **) palloc(ntuples * sizeof(Datum *));
+			isnull = (bool **) palloc(ntuples * sizeof(bool *));
+			tids = (ItemPointer *) palloc(ntuples * sizeof(ItemPointer));
+			for (j = 0; j < ntuples; j++)
+			{
+				values[j] = (Datum *) palloc(INDEX_MAX_KEYS * sizeof(Datum));
+				isnull[j] = (bool *) palloc(INDEX_MAX_KEYS * sizeof(bool));
+			}
+			MemoryContextSwitchTo(oldContext);
+		}
+
+		nvalid = 0;
+		for (j = 0; j < ntuples; j++)
+		{
+			TupleTableSlot *slot = slots[j];
+
+			/* Arrange for econtext's scan tuple to be the tuple under test */
+			econtext->ecxt_scantuple = slot;
+
+			/* Check for partial index */
+			if (indexInfo->ii_Predicate != NIL)
+			{
+				ExprState  *predicate;
+
+				/*
+				 * If predicate state not set up yet, create it (in the
+				 * estate's per-query context)
+				 */
+				predicate = indexInfo->ii_PredicateState;
+				if (predicate == NULL)
+				{
+					predicate = ExecPrepareQual(indexInfo->ii_Predicate, estate);
+					indexInfo->ii_PredicateState = predicate;
+				}
+
+				/* Skip this index-update if the predicate isn't satisfied */
+				if (!ExecQual(predicate, econtext))
+					continue;
+			}
+
+			/*
+			 * FormIndexDatum fills in its values and isnull parameters with
+			 * the appropriate values for the column(s) of the index.
+			 */
+			FormIndexDatum(indexInfo,
+						   slot,
+						   estate,
+						   values[nvalid],
+						   isnull[nvalid]);
+			tids[nvalid] = &slot->tts_tid;
+			nvalid++;
+		}
+
+		if (nvalid > 0)
+			index_insert_batch(indexRelation,	/* index relation */
+							   values,	/* array of index Datum arrays */
+							   isnull,	/* corresponding null flags */
+							   tids,	/* locations of heap tuples */
+							   nvalid,	/* number of entries to insert */
+							   heapRelation,	/* heap relation */
+							   indexInfo);	/* index AM may need this */
+	}
+
+	return true;
+}
+
 /* ----------------------------------------------------------------
  *		ExecCheckIndexConstraints
  *
@@ -53,6 +53,7 @@
 #include "jit/jit.h"
 #include "mb/pg_wchar.h"
 #include "miscadmin.h"
+#include "optimizer/planfeedback.h"
 #include "parser/parsetree.h"
 #include "storage/bufmgr.h"
 #include "storage/lmgr.h"
@@ -177,6 +178,13 @@ standard_ExecutorStart(QueryDesc *queryDesc, int eflags)
 		!(eflags & EXEC_FLAG_EXPLAIN_ONLY))
 		ExecCheckXactReadOnly(queryDesc->plannedstmt);
 
+	/*
+	 * Cardinality feedback needs per-node row counts; those are cheap, so
+	 * just force them on for every plan while the feature is enabled.
+	 */
+	if (plan_cache_feedback && !(eflags & EXEC_FLAG_EXPLAIN_ONLY))
+		queryDesc->instrument_options |= INSTRUMENT_ROWS;
+
 	/*
 	 * Build EState, switch into per-query memory context for startup.
 	 */
@@ -488,6 +496,14 @@ standard_ExecutorEnd(QueryDesc *queryDesc)
 	Assert(estate->es_finished ||
 		   (estate->es_top_eflags & EXEC_FLAG_EXPLAIN_ONLY));
 
+	/*
+	 * Harvest actual-versus-estimated row counts for cardinality feedback,
+	 * while the planstate tree and its instrumentation are still alive.
+	 */
+	if (plan_cache_feedback &&
+		!(estate->es_top_eflags & EXEC_FLAG_EXPLAIN_ONLY))
+		plan_feedback_record(queryDesc);
+
 	/*
 	 * Switch into per-query memory context to run ExecEndPlan
 	 */
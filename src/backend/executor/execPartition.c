@@ -127,6 +127,13 @@ struct PartitionTupleRouting
  *		routing it through this table). A NULL value is stored if no tuple
  *		conversion is required.
  *
+ * lastDatumIndex
+ *		Index into partdesc->boundinfo->datums of the bound matched by the
+ *		most recently routed tuple, or -1 if none yet.  Since consecutive
+ *		tuples very commonly route to the same partition, we recheck this
+ *		bound before doing a fresh binary search.  Not used for hash
+ *		partitioning, where there is no search to save.
+ *
  * indexes
  *		Array of partdesc->nparts elements.  For leaf partitions the index
  *		corresponds to the partition's ResultRelInfo in the encapsulating
@@ -144,6 +151,7 @@ typedef struct PartitionDispatchData
 	PartitionDesc partdesc;
 	TupleTableSlot *tupslot;
 	AttrNumber *tupmap;
+	int			lastDatumIndex;
 	int			indexes[FLEXIBLE_ARRAY_MEMBER];
 }			PartitionDispatchData;
 
@@ -1048,6 +1056,9 @@ ExecInitPartitionDispatchInfo(EState *estate,
 		pd->tupslot = NULL;
 	}
 
+	/* No tuple routed through this node yet */
+	pd->lastDatumIndex = -1;
+
 	/*
 	 * Initialize with -1 to signify that the corresponding partition's
 	 * ResultRelInfo or PartitionDispatch has not been created yet.
@@ -1263,12 +1274,36 @@ get_partition_for_tuple(PartitionDispatch pd, Datum *values, bool *isnull)
 			{
 				bool		equal = false;
 
+				/*
+				 * Check the bound the previous tuple matched before
+				 * searching; clustered inserts route long runs of tuples to
+				 * the same partition.
+				 */
+				if (pd->lastDatumIndex >= 0)
+				{
+					int			lastidx = pd->lastDatumIndex;
+					int32		cmpval;
+
+					cmpval = DatumGetInt32(FunctionCall2Coll(&key->partsupfunc[0],
+															 key->partcollation[0],
+															 boundinfo->datums[lastidx][0],
+															 values[0]));
+					if (cmpval == 0)
+					{
+						part_index = boundinfo->indexes[lastidx];
+						break;
+					}
+				}
+
 				bound_offset = partition_list_bsearch(key->partsupfunc,
 													  key->partcollation,
 													  boundinfo,
 													  values[0], &equal);
 				if (bound_offset >= 0 && equal)
+				{
 					part_index = boundinfo->indexes[bound_offset];
+					pd->lastDatumIndex = bound_offset;
+				}
 			}
 			break;
 
@@ -1293,6 +1328,35 @@ get_partition_for_tuple(PartitionDispatch pd, Datum *values, bool *isnull)
 
 				if (!range_partkey_has_null)
 				{
+					/*
+					 * As in the LIST case, recheck the bound pair bracketing
+					 * the previous tuple before searching: the tuple belongs
+					 * there if the cached (lower) bound is <= it and the
+					 * following bound, if any, is > it.
+					 */
+					if (pd->lastDatumIndex >= 0)
+					{
+						int			lastidx = pd->lastDatumIndex;
+
+						if (partition_rbound_datum_cmp(key->partsupfunc,
+													   key->partcollation,
+													   boundinfo->datums[lastidx],
+													   boundinfo->kind[lastidx],
+													   values,
+													   key->partnatts) <= 0 &&
+							(lastidx + 1 >= boundinfo->ndatums ||
+							 partition_rbound_datum_cmp(key->partsupfunc,
+														key->partcollation,
+														boundinfo->datums[lastidx + 1],
+														boundinfo->kind[lastidx + 1],
+														values,
+														key->partnatts) > 0))
+						{
+							part_index = boundinfo->indexes[lastidx + 1];
+							break;
+						}
+					}
+
 					bound_offset = partition_range_datum_bsearch(key->partsupfunc,
 																 key->partcollation,
 																 boundinfo,
@@ -1307,6 +1371,8 @@ get_partition_for_tuple(PartitionDispatch pd, Datum *values, bool *isnull)
 					 * actually exists one.
 					 */
 					part_index = boundinfo->indexes[bound_offset + 1];
+					if (bound_offset >= 0)
+						pd->lastDatumIndex = bound_offset;
 				}
 			}
 			break;
@@ -259,12 +259,16 @@ CreateExprContext(EState *estate)
 	econtext->ecxt_per_query_memory = estate->es_query_cxt;
 
 	/*
-	 * Create working memory for expression evaluation in this context.
+	 * Create working memory for expression evaluation in this context.  We
+	 * use a bump context because this is the hottest allocation arena in the
+	 * executor and it is reset for every tuple, so nothing is lost by not
+	 * recycling individual pfree'd chunks.
 	 */
 	econtext->ecxt_per_tuple_memory =
-		AllocSetContextCreate(estate->es_query_cxt,
-							  "ExprContext",
-							  ALLOCSET_DEFAULT_SIZES);
+		BumpContextCreate(estate->es_query_cxt,
+						  "ExprContext",
+						  ALLOCSET_DEFAULT_INITSIZE,
+						  ALLOCSET_DEFAULT_MAXSIZE);
 
 	econtext->ecxt_param_exec_vals = estate->es_param_exec_vals;
 	econtext->ecxt_param_list_info = estate->es_param_list_info;
@@ -328,12 +332,14 @@ CreateStandaloneExprContext(void)
 	econtext->ecxt_per_query_memory = CurrentMemoryContext;
 
 	/*
-	 * Create working memory for expression evaluation in this context.
+	 * Create working memory for expression evaluation in this context, using
+	 * a bump context for the same reasons as in CreateExprContext.
 	 */
 	econtext->ecxt_per_tuple_memory =
-		AllocSetContextCreate(CurrentMemoryContext,
-							  "ExprContext",
-							  ALLOCSET_DEFAULT_SIZES);
+		BumpContextCreate(CurrentMemoryContext,
+						  "ExprContext",
+						  ALLOCSET_DEFAULT_INITSIZE,
+						  ALLOCSET_DEFAULT_MAXSIZE);
 
 	econtext->ecxt_param_exec_vals = NULL;
 	econtext->ecxt_param_list_info = NULL;
@@ -17,6 +17,15 @@
 
 #include "executor/instrument.h"
 
+/*
+ * In sampled-timing mode (INSTRUMENT_SAMPLE), only one node cycle in
+ * instrument_sample_interval is actually timed; the measured time is scaled
+ * up by the inverse sampling fraction when the loop ends.  The untimed
+ * cycles cost only a couple of integer operations, so per-node timing
+ * becomes cheap enough to leave enabled on production systems.
+ */
+int			instrument_sample_interval = 64;
+
 BufferUsage pgBufferUsage;
 static BufferUsage save_pgBufferUsage;
 
@@ -33,16 +42,22 @@ InstrAlloc(int n, int instrument_options)
 
 	/* initialize all fields to zeroes, then modify as needed */
 	instr = palloc0(n * sizeof(Instrumentation));
-	if (instrument_options & (INSTRUMENT_BUFFERS | INSTRUMENT_TIMER))
+	if (instrument_options & (INSTRUMENT_BUFFERS | INSTRUMENT_TIMER |
+							  INSTRUMENT_SAMPLE))
 	{
 		bool		need_buffers = (instrument_options & INSTRUMENT_BUFFERS) != 0;
+		bool		sample_timer = (instrument_options & INSTRUMENT_SAMPLE) != 0;
 		bool		need_timer = (instrument_options & INSTRUMENT_TIMER) != 0;
 		int			i;
 
+		/* sampled timing is still timing */
+		need_timer |= sample_timer;
+
 		for (i = 0; i < n; i++)
 		{
 			instr[i].need_bufusage = need_buffers;
 			instr[i].need_timer = need_timer;
+			instr[i].sample_timer = sample_timer;
 		}
 	}
 
@@ -55,16 +70,28 @@ InstrInit(Instrumentation *instr, int instrument_options)
 {
 	memset(instr, 0, sizeof(Instrumentation));
 	instr->need_bufusage = (instrument_options & INSTRUMENT_BUFFERS) != 0;
-	instr->need_timer = (instrument_options & INSTRUMENT_TIMER) != 0;
+	instr->sample_timer = (instrument_options & INSTRUMENT_SAMPLE) != 0;
+	instr->need_timer = instr->sample_timer ||
+		(instrument_options & INSTRUMENT_TIMER) != 0;
 }
 
 /* Entry to a plan node */
 void
 InstrStartNode(Instrumentation *instr)
 {
-	if (instr->need_timer &&
-		!INSTR_TIME_SET_CURRENT_LAZY(instr->starttime))
-		elog(ERROR, "InstrStartNode called twice in a row");
+	if (instr->need_timer)
+	{
+		/*
+		 * In sampled-timing mode, most cycles are not timed at all; we just
+		 * count down to the next one that will be.  The first cycle of each
+		 * loop is always timed, so that startup time is measured rather than
+		 * extrapolated.
+		 */
+		if (instr->sample_timer && instr->sample_countdown > 0)
+			instr->sample_countdown--;
+		else if (!INSTR_TIME_SET_CURRENT_LAZY(instr->starttime))
+			elog(ERROR, "InstrStartNode called twice in a row");
+	}
 
 	/* save buffer usage totals at node entry, if needed */
 	if (instr->need_bufusage)
@@ -83,13 +110,34 @@ InstrStopNode(Instrumentation *instr, double nTuples)
 	/* let's update the time only if the timer was requested */
 	if (instr->need_timer)
 	{
-		if (INSTR_TIME_IS_ZERO(instr->starttime))
-			elog(ERROR, "InstrStopNode called without start");
+		if (instr->sample_timer)
+		{
+			/*
+			 * In sampled-timing mode a zero start time just means this cycle
+			 * wasn't selected for timing; count it either way, so that the
+			 * sampled time can be scaled up in InstrEndLoop.
+			 */
+			instr->cyclecount += 1;
+			if (!INSTR_TIME_IS_ZERO(instr->starttime))
+			{
+				INSTR_TIME_SET_CURRENT(endtime);
+				INSTR_TIME_ACCUM_DIFF(instr->counter, endtime,
+									  instr->starttime);
+				INSTR_TIME_SET_ZERO(instr->starttime);
+				instr->samplecount += 1;
+				instr->sample_countdown = instrument_sample_interval - 1;
+			}
+		}
+		else
+		{
+			if (INSTR_TIME_IS_ZERO(instr->starttime))
+				elog(ERROR, "InstrStopNode called without start");
 
-		INSTR_TIME_SET_CURRENT(endtime);
-		INSTR_TIME_ACCUM_DIFF(instr->counter, endtime, instr->starttime);
+			INSTR_TIME_SET_CURRENT(endtime);
+			INSTR_TIME_ACCUM_DIFF(instr->counter, endtime, instr->starttime);
 
-		INSTR_TIME_SET_ZERO(instr->starttime);
+			INSTR_TIME_SET_ZERO(instr->starttime);
+		}
 	}
 
 	/* Add delta of buffer usage since entry to node's totals */
@@ -121,6 +169,14 @@ InstrEndLoop(Instrumentation *instr)
 	/* Accumulate per-cycle statistics into totals */
 	totaltime = INSTR_TIME_GET_DOUBLE(instr->counter);
 
+	/*
+	 * In sampled-timing mode only a fraction of the cycles were timed; scale
+	 * the measured time up by the inverse sampling fraction to estimate the
+	 * node's actual total.
+	 */
+	if (instr->sample_timer && instr->samplecount > 0)
+		totaltime *= instr->cyclecount / instr->samplecount;
+
 	instr->startup += instr->firsttuple;
 	instr->total += totaltime;
 	instr->ntuples += instr->tuplecount;
@@ -132,6 +188,9 @@ InstrEndLoop(Instrumentation *instr)
 	INSTR_TIME_SET_ZERO(instr->counter);
 	instr->firsttuple = 0;
 	instr->tuplecount = 0;
+	instr->sample_countdown = 0;
+	instr->cyclecount = 0;
+	instr->samplecount = 0;
 }
 
 /* aggregate instrumentation information */
@@ -149,6 +208,8 @@ InstrAggNode(Instrumentation *dst, Instrumentation *add)
 	INSTR_TIME_ADD(dst->counter, add->counter);
 
 	dst->tuplecount += add->tuplecount;
+	dst->cyclecount += add->cyclecount;
+	dst->samplecount += add->samplecount;
 	dst->startup += add->startup;
 	dst->total += add->total;
 	dst->ntuples += add->ntuples;
@@ -90,7 +90,7 @@
  *	  but in the aggregate case we know the left input is either the initial
  *	  transition value or a previous function result, and in either case its
  *	  value need not be preserved.  See int8inc() for an example.  Notice that
- *	  the EEOP_AGG_PLAIN_TRANS step is coded to avoid a data copy step when
+ *	  the EEOP_AGG_PLAIN_TRANS_BYREF steps are coded to avoid a data copy when
  *	  the previous transition value pointer is returned.  It is also possible
  *	  to avoid repeated data copying when the transition value is an expanded
  *	  object: to do that, the transition function must take care to return
@@ -194,6 +194,19 @@
  *	  transition values.  hashcontext is the single context created to support
  *	  all hash tables.
  *
+ *	  Spilling To Disk
+ *
+ *	  For a plain hashed aggregate over a single grouping set, the number of
+ *	  groups entered into the hash table per pass is capped at roughly what
+ *	  fits in work_mem.  Once the cap is reached, input tuples belonging to
+ *	  groups not already in the table are written out to partition files,
+ *	  scattered by their hash values.  After the in-memory groups have been
+ *	  emitted, the table is reset and refilled from one spilled partition at
+ *	  a time; partitions that still do not fit are repartitioned recursively
+ *	  using further bits of the hash.  Since every pass admits a full table's
+ *	  worth of new groups, progress is guaranteed even when the input hash
+ *	  values are badly skewed.
+ *
  *    Transition / Combine function invocation:
  *
  *    For performance reasons transition functions, including combine
@@ -229,8 +242,10 @@
 #include "optimizer/optimizer.h"
 #include "parser/parse_agg.h"
 #include "parser/parse_coerce.h"
+#include "storage/buffile.h"
 #include "utils/acl.h"
 #include "utils/builtins.h"
+#include "utils/fmgroids.h"
 #include "utils/expandeddatum.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
@@ -239,6 +254,40 @@
 #include "utils/datum.h"
 
 
+/*
+ * Number of hash bits consumed to scatter spilled tuples across partition
+ * files at each spill level.
+ */
+#define HASHAGG_PARTITION_BITS	5
+
+/*
+ * Represents the spill state for one pass over the input: tuples that could
+ * not be entered into the hash table because the group-count budget was
+ * exhausted are routed, by hash value, to one of several partition files for
+ * a later pass.
+ */
+typedef struct HashAggSpill
+{
+	int			npartitions;	/* number of partitions */
+	BufFile   **partitions;		/* spill files, created on first write */
+	int64	   *ntuples;		/* number of tuples in each partition */
+	int			partition_bits; /* hash bits used to choose a partition */
+	int			shift;			/* right-shift applied before masking */
+	uint32		mask;			/* mask to extract the partition number */
+} HashAggSpill;
+
+/*
+ * Represents one spilled partition awaiting re-processing, along with the
+ * number of hash bits that have already been consumed to route tuples to it.
+ */
+typedef struct HashAggBatch
+{
+	BufFile    *input_file;		/* file containing spilled input tuples */
+	int			input_bits;		/* hash bits already used for routing */
+	int64		input_tuples;	/* number of tuples in this batch */
+} HashAggBatch;
+
+
 static void select_current_set(AggState *aggstate, int setno, bool is_hash);
 static void initialize_phase(AggState *aggstate, int newphase);
 static TupleTableSlot *fetch_input_tuple(AggState *aggstate);
@@ -278,6 +327,14 @@ static void lookup_hash_entries(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_direct(AggState *aggstate);
 static void agg_fill_hash_table(AggState *aggstate);
 static TupleTableSlot *agg_retrieve_hash_table(AggState *aggstate);
+static void agg_refill_hash_table(AggState *aggstate);
+static void hashagg_spill_init(AggState *aggstate);
+static void hashagg_spill_tuple(AggState *aggstate,
+								TupleTableSlot *inputslot, uint32 hash);
+static void hashagg_spill_finish(AggState *aggstate);
+static MinimalTuple hashagg_batch_read(HashAggBatch *batch);
+static void hashagg_reset_spill_state(AggState *aggstate);
+static void hashagg_release_hash_tables(AggState *aggstate);
 static Datum GetAggInitVal(Datum textInitVal, Oid transtype);
 static void build_pertrans_for_aggref(AggStatePerTrans pertrans,
 									  AggState *aggstate, EState *estate,
@@ -1266,12 +1323,35 @@ build_hash_table(AggState *aggstate)
 {
 	MemoryContext tmpmem = aggstate->tmpcontext->ecxt_per_tuple_memory;
 	Size		additionalsize;
+	long		maxgroups;
 	int			i;
 
 	Assert(aggstate->aggstrategy == AGG_HASHED || aggstate->aggstrategy == AGG_MIXED);
 
 	additionalsize = aggstate->numtrans * sizeof(AggStatePerGroupData);
 
+	/*
+	 * Clamp the planner's group estimate so that the initial bucket arrays
+	 * cannot be sized far beyond what the memory budget could ever
+	 * accommodate.  This matters particularly in parallel plans, where each
+	 * worker builds its own hash table from the same whole-input numGroups
+	 * estimate even though it will see only a fraction of the input; without
+	 * the clamp, every worker up front allocates a table sized for all
+	 * groups.  The table still grows dynamically if more groups materialize
+	 * than the clamped estimate allows for.
+	 */
+	maxgroups = (long) ((work_mem * 1024L) /
+						hash_agg_entry_size(aggstate->numtrans));
+	maxgroups = Max(maxgroups, 1);
+
+	/*
+	 * The same budget bounds how many groups we admit per pass when spilling
+	 * is possible; see lookup_hash_entry().  Like the planner's estimate, it
+	 * doesn't account for pass-by-reference transition values, but it keeps
+	 * the table size within the same order of magnitude as work_mem.
+	 */
+	aggstate->hash_ngroups_limit = maxgroups;
+
 	for (i = 0; i < aggstate->num_hashes; ++i)
 	{
 		AggStatePerHash perhash = &aggstate->perhash[i];
@@ -1288,7 +1368,8 @@ build_hash_table(AggState *aggstate)
 														perhash->eqfuncoids,
 														perhash->hashfunctions,
 														perhash->aggnode->grpCollations,
-														perhash->aggnode->numGroups,
+														Min(perhash->aggnode->numGroups,
+															maxgroups),
 														additionalsize,
 														aggstate->ss.ps.state->es_query_cxt,
 														aggstate->hashcontext->ecxt_per_tuple_memory,
@@ -1461,6 +1542,10 @@ hash_agg_entry_size(int numAggs)
  * set (which the caller must have selected - note that initialize_aggregate
  * depends on this).
  *
+ * If the group-count budget for the current batch has been exhausted and the
+ * tuple's group is not already in the table, the tuple is instead written to
+ * a spill partition for a later pass and NULL is returned.
+ *
  * When called, CurrentMemoryContext should be the per-query context.
  */
 static TupleHashEntryData *
@@ -1470,7 +1555,8 @@ lookup_hash_entry(AggState *aggstate)
 	AggStatePerHash perhash = &aggstate->perhash[aggstate->current_set];
 	TupleTableSlot *hashslot = perhash->hashslot;
 	TupleHashEntryData *entry;
-	bool		isnew;
+	bool		isnew = false;
+	bool	   *p_isnew;
 	int			i;
 
 	/* transfer just the needed columns into hashslot */
@@ -1486,8 +1572,19 @@ lookup_hash_entry(AggState *aggstate)
 	}
 	ExecStoreVirtualTuple(hashslot);
 
+	/* if we've hit the group limit, do not create new entries */
+	p_isnew = aggstate->hash_spill_mode ? NULL : &isnew;
+
 	/* find or create the hashtable entry using the filtered tuple */
-	entry = LookupTupleHashEntry(perhash->hashtable, hashslot, &isnew);
+	entry = LookupTupleHashEntry(perhash->hashtable, hashslot, p_isnew);
+
+	if (entry == NULL)
+	{
+		/* route the input tuple to a spill partition instead */
+		hashagg_spill_tuple(aggstate, inputslot,
+							TupleHashTableHash(perhash->hashtable, hashslot));
+		return NULL;
+	}
 
 	if (isnew)
 	{
@@ -1510,6 +1607,15 @@ lookup_hash_entry(AggState *aggstate)
 
 			initialize_aggregate(aggstate, pertrans, pergroupstate);
 		}
+
+		/*
+		 * Once the group-count budget for this batch is used up, stop
+		 * admitting new groups; further input belonging to absent groups is
+		 * spilled and aggregated in later passes over the spill files.
+		 */
+		if (aggstate->hash_spill_ok &&
+			++aggstate->hash_ngroups_current >= aggstate->hash_ngroups_limit)
+			aggstate->hash_spill_mode = true;
 	}
 
 	return entry;
@@ -1530,8 +1636,13 @@ lookup_hash_entries(AggState *aggstate)
 
 	for (setno = 0; setno < numHashes; setno++)
 	{
+		TupleHashEntryData *entry;
+
 		select_current_set(aggstate, setno, true);
-		pergroup[setno] = lookup_hash_entry(aggstate)->additional;
+		entry = lookup_hash_entry(aggstate);
+
+		/* a NULL entry means the tuple was spilled for a later pass */
+		pergroup[setno] = entry ? entry->additional : NULL;
 	}
 }
 
@@ -1946,8 +2057,13 @@ agg_fill_hash_table(AggState *aggstate)
 		/* Find or build hashtable entries */
 		lookup_hash_entries(aggstate);
 
-		/* Advance the aggregates (or combine functions) */
-		advance_aggregates(aggstate);
+		/*
+		 * Advance the aggregates (or combine functions), unless the tuple
+		 * was spilled for a later pass (only possible with a single hashed
+		 * grouping set).
+		 */
+		if (aggstate->hash_pergroup[0] != NULL)
+			advance_aggregates(aggstate);
 
 		/*
 		 * Reset per-input-tuple context after each tuple, but note that the
@@ -1956,6 +2072,9 @@ agg_fill_hash_table(AggState *aggstate)
 		ResetExprContext(aggstate->tmpcontext);
 	}
 
+	/* anything we could not fit becomes input for later passes */
+	hashagg_spill_finish(aggstate);
+
 	aggstate->table_filled = true;
 	/* Initialize to walk the first hash table */
 	select_current_set(aggstate, 0, true);
@@ -1963,6 +2082,76 @@ agg_fill_hash_table(AggState *aggstate)
 						   &aggstate->perhash[0].hashiter);
 }
 
+/*
+ * agg_refill_hash_table
+ *		reset the hash table and refill it from the next spilled batch
+ *
+ * Must only be called once all groups of the previous pass have been
+ * emitted.  Groups that again exceed the budget are re-spilled to a deeper
+ * set of partitions; because each pass admits up to hash_ngroups_limit new
+ * groups, the recursion is guaranteed to make forward progress even on
+ * pathological key distributions.
+ */
+static void
+agg_refill_hash_table(AggState *aggstate)
+{
+	ExprContext *tmpcontext = aggstate->tmpcontext;
+	HashAggBatch *batch;
+
+	Assert(aggstate->hash_batches != NIL);
+
+	batch = (HashAggBatch *) linitial(aggstate->hash_batches);
+	aggstate->hash_batches = list_delete_first(aggstate->hash_batches);
+
+	/*
+	 * Free the memory occupied by the previous pass's groups and rebuild an
+	 * empty hash table.  (Resetting the hashcontext also deletes its
+	 * sub-contexts; cf. ExecReScanAgg.)
+	 */
+	ReScanExprContext(aggstate->hashcontext);
+	build_hash_table(aggstate);
+
+	aggstate->hash_spill_mode = false;
+	aggstate->hash_ngroups_current = 0;
+	aggstate->hash_batch_bits = batch->input_bits;
+
+	for (;;)
+	{
+		TupleTableSlot *slot = aggstate->hash_spill_slot;
+		MinimalTuple tuple;
+
+		CHECK_FOR_INTERRUPTS();
+
+		tuple = hashagg_batch_read(batch);
+		if (tuple == NULL)
+			break;
+		ExecStoreMinimalTuple(tuple, slot, true);
+
+		/* set up for lookup_hash_entries and advance_aggregates */
+		tmpcontext->ecxt_outertuple = slot;
+
+		/* Find or build hashtable entries */
+		lookup_hash_entries(aggstate);
+
+		/* advance the aggregates, unless the tuple was re-spilled */
+		if (aggstate->hash_pergroup[0] != NULL)
+			advance_aggregates(aggstate);
+
+		ResetExprContext(tmpcontext);
+	}
+
+	BufFileClose(batch->input_file);
+	pfree(batch);
+
+	/* queue any re-spilled partitions behind their siblings */
+	hashagg_spill_finish(aggstate);
+
+	/* Initialize to walk the newly filled hash table */
+	select_current_set(aggstate, 0, true);
+	ResetTupleHashIterator(aggstate->perhash[0].hashtable,
+						   &aggstate->perhash[0].hashiter);
+}
+
 /*
  * ExecAgg for hashed case: retrieving groups from hash table
  */
@@ -2025,10 +2214,21 @@ agg_retrieve_hash_table(AggState *aggstate)
 
 				continue;
 			}
+			else if (aggstate->hash_batches != NIL)
+			{
+				/* Refill the table from the next spilled batch. */
+				agg_refill_hash_table(aggstate);
+
+				perhash = &aggstate->perhash[aggstate->current_set];
+
+				continue;
+			}
 			else
 			{
 				/* No more hashtables, so done */
 				aggstate->agg_done = true;
+				if (aggstate->hash_release_on_exhaust)
+					hashagg_release_hash_tables(aggstate);
 				return NULL;
 			}
 		}
@@ -2085,6 +2285,248 @@ agg_retrieve_hash_table(AggState *aggstate)
 	return NULL;
 }
 
+/*
+ * hashagg_spill_init
+ *		set up the spill state for the current batch
+ *
+ * Each spill level consumes HASHAGG_PARTITION_BITS further bits of the
+ * 32-bit hash to scatter tuples across partition files.  Once the hash bits
+ * are exhausted we fall back to a single partition, relying on the
+ * group-count budget alone for forward progress.
+ */
+static void
+hashagg_spill_init(AggState *aggstate)
+{
+	MemoryContext oldcontext;
+	HashAggSpill *spill;
+	int			partition_bits;
+
+	Assert(aggstate->hash_spill == NULL);
+
+	partition_bits = HASHAGG_PARTITION_BITS;
+	if (aggstate->hash_batch_bits + partition_bits > 32)
+		partition_bits = 32 - aggstate->hash_batch_bits;
+
+	/* spill state must survive across per-tuple resets */
+	oldcontext = MemoryContextSwitchTo(aggstate->ss.ps.state->es_query_cxt);
+
+	spill = (HashAggSpill *) palloc0(sizeof(HashAggSpill));
+	spill->partition_bits = partition_bits;
+	spill->npartitions = 1 << partition_bits;
+	spill->partitions = (BufFile **)
+		palloc0(spill->npartitions * sizeof(BufFile *));
+	spill->ntuples = (int64 *) palloc0(spill->npartitions * sizeof(int64));
+	spill->shift = 32 - aggstate->hash_batch_bits - partition_bits;
+	spill->mask = spill->npartitions - 1;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	aggstate->hash_spill = spill;
+}
+
+/*
+ * hashagg_spill_tuple
+ *		write an input tuple to the spill partition chosen by its hash value
+ *
+ * Used when the tuple's group could not be entered into the hash table.  The
+ * partition files hold the tuples in MinimalTuple format; they are written
+ * and read back strictly sequentially, so compressed temporary files are
+ * used to save temp-file bandwidth.
+ */
+static void
+hashagg_spill_tuple(AggState *aggstate, TupleTableSlot *inputslot, uint32 hash)
+{
+	HashAggSpill *spill = aggstate->hash_spill;
+	MinimalTuple tuple;
+	int			partidx;
+	size_t		written;
+	bool		shouldFree;
+
+	if (spill == NULL)
+	{
+		hashagg_spill_init(aggstate);
+		spill = aggstate->hash_spill;
+	}
+
+	aggstate->hash_ever_spilled = true;
+
+	partidx = (hash >> spill->shift) & spill->mask;
+
+	if (spill->partitions[partidx] == NULL)
+	{
+		MemoryContext oldcontext;
+
+		oldcontext = MemoryContextSwitchTo(aggstate->ss.ps.state->es_query_cxt);
+		spill->partitions[partidx] = BufFileCreateCompressTemp(false);
+		MemoryContextSwitchTo(oldcontext);
+	}
+
+	tuple = ExecFetchSlotMinimalTuple(inputslot, &shouldFree);
+
+	written = BufFileWrite(spill->partitions[partidx],
+						   (void *) tuple, tuple->t_len);
+	if (written != tuple->t_len)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to hash-aggregate temporary file: %m")));
+
+	spill->ntuples[partidx]++;
+
+	if (shouldFree)
+		pfree(tuple);
+}
+
+/*
+ * hashagg_spill_finish
+ *		turn the written spill partitions into batches for later passes
+ *
+ * Rewinds each partition file that received tuples, queues it as a
+ * HashAggBatch on aggstate->hash_batches, and releases the spill state.
+ * A no-op if nothing was spilled during the pass just completed.
+ */
+static void
+hashagg_spill_finish(AggState *aggstate)
+{
+	HashAggSpill *spill = aggstate->hash_spill;
+	MemoryContext oldcontext;
+	int			i;
+
+	if (spill == NULL)
+		return;
+
+	oldcontext = MemoryContextSwitchTo(aggstate->ss.ps.state->es_query_cxt);
+
+	for (i = 0; i < spill->npartitions; i++)
+	{
+		HashAggBatch *batch;
+
+		if (spill->partitions[i] == NULL)
+			continue;
+
+		if (BufFileSeek(spill->partitions[i], 0, 0L, SEEK_SET))
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not rewind hash-aggregate temporary file: %m")));
+
+		batch = (HashAggBatch *) palloc(sizeof(HashAggBatch));
+		batch->input_file = spill->partitions[i];
+		batch->input_bits = aggstate->hash_batch_bits + spill->partition_bits;
+		batch->input_tuples = spill->ntuples[i];
+
+		aggstate->hash_batches = lappend(aggstate->hash_batches, batch);
+	}
+
+	MemoryContextSwitchTo(oldcontext);
+
+	pfree(spill->partitions);
+	pfree(spill->ntuples);
+	pfree(spill);
+	aggstate->hash_spill = NULL;
+}
+
+/*
+ * hashagg_batch_read
+ *		read the next tuple from a batch file.  Return NULL if no more.
+ *
+ * The tuple is palloc'd in the current memory context; the caller is
+ * expected to store it into a slot that takes ownership.
+ */
+static MinimalTuple
+hashagg_batch_read(HashAggBatch *batch)
+{
+	BufFile    *file = batch->input_file;
+	uint32		t_len;
+	size_t		nread;
+	MinimalTuple tuple;
+
+	nread = BufFileRead(file, (void *) &t_len, sizeof(uint32));
+	if (nread == 0)				/* end of file */
+		return NULL;
+	if (nread != sizeof(uint32))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from hash-aggregate temporary file: %m")));
+	tuple = (MinimalTuple) palloc(t_len);
+	tuple->t_len = t_len;
+	nread = BufFileRead(file,
+						(void *) ((char *) tuple + sizeof(uint32)),
+						t_len - sizeof(uint32));
+	if (nread != t_len - sizeof(uint32))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read from hash-aggregate temporary file: %m")));
+	return tuple;
+}
+
+/*
+ * hashagg_reset_spill_state
+ *		close and forget any spill partition and batch files
+ *
+ * Used during rescan and shutdown; also safe when nothing was spilled.
+ */
+static void
+hashagg_reset_spill_state(AggState *aggstate)
+{
+	ListCell   *lc;
+
+	/* free the spill state of an interrupted pass, if any */
+	if (aggstate->hash_spill != NULL)
+	{
+		HashAggSpill *spill = aggstate->hash_spill;
+		int			i;
+
+		for (i = 0; i < spill->npartitions; i++)
+		{
+			if (spill->partitions[i] != NULL)
+				BufFileClose(spill->partitions[i]);
+		}
+		pfree(spill->partitions);
+		pfree(spill->ntuples);
+		pfree(spill);
+		aggstate->hash_spill = NULL;
+	}
+
+	/* free unprocessed batches */
+	foreach(lc, aggstate->hash_batches)
+	{
+		HashAggBatch *batch = (HashAggBatch *) lfirst(lc);
+
+		BufFileClose(batch->input_file);
+		pfree(batch);
+	}
+	list_free(aggstate->hash_batches);
+	aggstate->hash_batches = NIL;
+}
+
+/*
+ * hashagg_release_hash_tables
+ *		give the hash tables' memory back once all groups have been emitted
+ *
+ * Resetting the hashcontext reclaims the stored tuples and transition
+ * values; destroying the tables additionally releases the bucket arrays,
+ * which ResetTupleHashTable would keep around.  If the node is rescanned
+ * after all, ExecReScanAgg rebuilds from scratch, including rescanning the
+ * input.
+ */
+static void
+hashagg_release_hash_tables(AggState *aggstate)
+{
+	int			i;
+
+	for (i = 0; i < aggstate->num_hashes; ++i)
+	{
+		AggStatePerHash perhash = &aggstate->perhash[i];
+
+		if (perhash->hashtable)
+		{
+			DestroyTupleHashTable(perhash->hashtable);
+			perhash->hashtable = NULL;
+		}
+	}
+	ReScanExprContext(aggstate->hashcontext);
+	aggstate->hash_released = true;
+}
+
 /* -----------------
  * ExecInitAgg
  *
@@ -2148,6 +2590,18 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 	aggstate->sort_in = NULL;
 	aggstate->sort_out = NULL;
 
+	/*
+	 * If no rescan without parameter changes is expected, we can give any
+	 * hash tables back as soon as all groups have been emitted.  That
+	 * matters under an Append of per-partition aggregates, where exhausted
+	 * children would otherwise hold onto their tables until the whole plan
+	 * shuts down.  (Decide this before the REWIND flag is cleared for the
+	 * child plan below.)
+	 */
+	aggstate->hash_release_on_exhaust =
+		(eflags & (EXEC_FLAG_REWIND | EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)) == 0;
+	aggstate->hash_released = false;
+
 	/*
 	 * phases[0] always exists, but is dummy in sorted/plain mode
 	 */
@@ -2500,6 +2954,20 @@ ExecInitAgg(Agg *node, EState *estate, int eflags)
 		find_hash_columns(aggstate);
 		build_hash_table(aggstate);
 		aggstate->table_filled = false;
+
+		/*
+		 * Spilling the hash table to disk is only supported for a plain
+		 * hashed aggregate over a single grouping set: with grouping sets
+		 * the same input row feeds several hash tables, and in AGG_MIXED
+		 * mode it additionally feeds the sort phases, so individual rows
+		 * cannot simply be set aside for a later pass.
+		 */
+		if (node->aggstrategy == AGG_HASHED && aggstate->num_hashes == 1)
+		{
+			aggstate->hash_spill_ok = true;
+			aggstate->hash_spill_slot =
+				ExecInitExtraTupleSlot(estate, scanDesc, &TTSOpsMinimalTuple);
+		}
 	}
 
 	/*
@@ -3068,6 +3536,52 @@ build_pertrans_for_aggref(AggStatePerTrans pertrans,
 					&pertrans->transtypeLen,
 					&pertrans->transtypeByVal);
 
+	/*
+	 * Recognize built-in transition (or combine) functions for which the
+	 * expression interpreter has an inline kernel, so the per-row
+	 * function-call overhead can be skipped.  The kernels assume a by-value
+	 * transition type, which int8/float8 are not on 32-bit builds, so check
+	 * that too.
+	 */
+	pertrans->transKernel = AGG_TRANSKERNEL_NONE;
+	if (pertrans->transtypeByVal)
+	{
+		switch (aggtransfn)
+		{
+			case F_INT8INC:
+			case F_INT8INC_ANY:
+				pertrans->transKernel = AGG_TRANSKERNEL_INT8INC;
+				break;
+			case F_INT8PL:
+				pertrans->transKernel = AGG_TRANSKERNEL_INT8PL;
+				break;
+			case F_INT4_SUM:
+				pertrans->transKernel = AGG_TRANSKERNEL_INT4_SUM;
+				break;
+			case F_FLOAT8PL:
+				pertrans->transKernel = AGG_TRANSKERNEL_FLOAT8PL;
+				break;
+			case F_INT4SMALLER:
+				pertrans->transKernel = AGG_TRANSKERNEL_INT4_MIN;
+				break;
+			case F_INT4LARGER:
+				pertrans->transKernel = AGG_TRANSKERNEL_INT4_MAX;
+				break;
+			case F_INT8SMALLER:
+				pertrans->transKernel = AGG_TRANSKERNEL_INT8_MIN;
+				break;
+			case F_INT8LARGER:
+				pertrans->transKernel = AGG_TRANSKERNEL_INT8_MAX;
+				break;
+			case F_FLOAT8SMALLER:
+				pertrans->transKernel = AGG_TRANSKERNEL_FLOAT8_MIN;
+				break;
+			case F_FLOAT8LARGER:
+				pertrans->transKernel = AGG_TRANSKERNEL_FLOAT8_MAX;
+				break;
+		}
+	}
+
 	if (OidIsValid(aggserialfn))
 	{
 		build_aggregate_serialfn_expr(aggserialfn,
@@ -3410,6 +3924,9 @@ ExecEndAgg(AggState *node)
 		}
 	}
 
+	/* Also close any hash-aggregation spill files still open */
+	hashagg_reset_spill_state(node);
+
 	/* And ensure any agg shutdown callbacks have been called */
 	for (setno = 0; setno < numGroupingSets; setno++)
 		ReScanExprContext(node->aggcontexts[setno]);
@@ -3454,12 +3971,14 @@ ExecReScanAgg(AggState *node)
 			return;
 
 		/*
-		 * If we do have the hash table, and the subplan does not have any
-		 * parameter changes, and none of our own parameter changes affect
-		 * input expressions of the aggregated functions, then we can just
-		 * rescan the existing hash table; no need to build it again.
+		 * If we still have the hash table, and it never spilled (so it still
+		 * holds all the groups), and the subplan does not have any parameter
+		 * changes, and none of our own parameter changes affect input
+		 * expressions of the aggregated functions, then we can just rescan
+		 * the existing hash table; no need to build it again.
 		 */
-		if (outerPlan->chgParam == NULL &&
+		if (!node->hash_released &&
+			outerPlan->chgParam == NULL && !node->hash_ever_spilled &&
 			!bms_overlap(node->ss.ps.chgParam, aggnode->aggParams))
 		{
 			ResetTupleHashIterator(node->perhash[0].hashtable,
@@ -3516,10 +4035,18 @@ ExecReScanAgg(AggState *node)
 	 */
 	if (node->aggstrategy == AGG_HASHED || node->aggstrategy == AGG_MIXED)
 	{
+		hashagg_reset_spill_state(node);
+
+		node->hash_ever_spilled = false;
+		node->hash_spill_mode = false;
+		node->hash_ngroups_current = 0;
+		node->hash_batch_bits = 0;
+
 		ReScanExprContext(node->hashcontext);
 		/* Rebuild an empty hash table */
 		build_hash_table(node);
 		node->table_filled = false;
+		node->hash_released = false;
 		/* iterator will be reset when the table is filled */
 	}
 
@@ -49,6 +49,17 @@ typedef struct GMReaderTupleBuffer
 	int			nTuples;		/* number of tuples currently stored */
 	int			readCounter;	/* index of next tuple to extract */
 	bool		done;			/* true if reader is known exhausted */
+
+	/*
+	 * Recycled tuple storage, assigned round-robin to incoming tuples so
+	 * that we don't palloc/pfree on every tuple crossing the queue.  We
+	 * need one chunk more than MAX_TUPLE_STORE because the most recently
+	 * extracted tuple is still referenced by the merge heap while the
+	 * array is being refilled.
+	 */
+	void	   *space[MAX_TUPLE_STORE + 1];
+	Size		spacelen[MAX_TUPLE_STORE + 1];
+	int			nextspace;		/* next storage chunk to recycle */
 } GMReaderTupleBuffer;
 
 static TupleTableSlot *ExecGatherMerge(PlanState *pstate);
@@ -532,8 +543,8 @@ gather_merge_clear_tuples(GatherMergeState *gm_state)
 	{
 		GMReaderTupleBuffer *tuple_buffer = &gm_state->gm_tuple_buffers[i];
 
-		while (tuple_buffer->readCounter < tuple_buffer->nTuples)
-			heap_freetuple(tuple_buffer->tuple[tuple_buffer->readCounter++]);
+		/* pending tuples live in recycled storage, so just forget them */
+		tuple_buffer->readCounter = tuple_buffer->nTuples = 0;
 
 		ExecClearTuple(gm_state->gm_slots[i + 1]);
 	}
@@ -598,12 +609,21 @@ static void
 load_tuple_array(GatherMergeState *gm_state, int reader)
 {
 	GMReaderTupleBuffer *tuple_buffer;
+	int			maxstore = MAX_TUPLE_STORE;
 	int			i;
 
 	/* Don't do anything if this is the leader. */
 	if (reader == 0)
 		return;
 
+	/*
+	 * If a tuple bound was passed down, no one reader can contribute more
+	 * than that many tuples to the result, so don't eagerly copy more than
+	 * that out of its queue.
+	 */
+	if (gm_state->tuples_needed >= 0 && gm_state->tuples_needed < maxstore)
+		maxstore = (int) gm_state->tuples_needed;
+
 	tuple_buffer = &gm_state->gm_tuple_buffers[reader - 1];
 
 	/* If there's nothing in the array, reset the counters to zero. */
@@ -611,7 +631,7 @@ load_tuple_array(GatherMergeState *gm_state, int reader)
 		tuple_buffer->nTuples = tuple_buffer->readCounter = 0;
 
 	/* Try to fill additional slots in the array. */
-	for (i = tuple_buffer->nTuples; i < MAX_TUPLE_STORE; i++)
+	for (i = tuple_buffer->nTuples; i < maxstore; i++)
 	{
 		HeapTuple	tuple;
 
@@ -703,7 +723,7 @@ gather_merge_readnext(GatherMergeState *gm_state, int reader, bool nowait)
 	ExecStoreHeapTuple(tup,		/* tuple to store */
 					   gm_state->gm_slots[reader],	/* slot in which to store
 													 * the tuple */
-					   true);	/* pfree tuple when done with it */
+					   false);	/* tuple storage is recycled, not freed */
 
 	return true;
 }
@@ -716,7 +736,9 @@ gm_readnext_tuple(GatherMergeState *gm_state, int nreader, bool nowait,
 				  bool *done)
 {
 	TupleQueueReader *reader;
+	GMReaderTupleBuffer *tuple_buffer;
 	HeapTuple	tup;
+	int			k;
 
 	/* Check for async events, particularly messages from workers. */
 	CHECK_FOR_INTERRUPTS();
@@ -730,7 +752,13 @@ gm_readnext_tuple(GatherMergeState *gm_state, int nreader, bool nowait,
 	 * there.
 	 */
 	reader = gm_state->reader[nreader - 1];
-	tup = TupleQueueReaderNext(reader, nowait, done);
+	tuple_buffer = &gm_state->gm_tuple_buffers[nreader - 1];
+	k = tuple_buffer->nextspace;
+	tup = TupleQueueReaderNextReuse(reader, nowait, done,
+									&tuple_buffer->space[k],
+									&tuple_buffer->spacelen[k]);
+	if (HeapTupleIsValid(tup))
+		tuple_buffer->nextspace = (k + 1) % (MAX_TUPLE_STORE + 1);
 
 	return tup;
 }
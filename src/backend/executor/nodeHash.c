@@ -34,6 +34,7 @@
 #include "executor/hashjoin.h"
 #include "executor/nodeHash.h"
 #include "executor/nodeHashjoin.h"
+#include "lib/bloomfilter.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "port/atomics.h"
@@ -41,6 +42,7 @@
 #include "utils/memutils.h"
 #include "utils/lsyscache.h"
 #include "utils/syscache.h"
+#include "utils/typcache.h"
 
 
 static void ExecHashIncreaseNumBatches(HashJoinTable hashtable);
@@ -173,6 +175,11 @@ MultiExecPrivateHash(HashState *node)
 		{
 			int			bucketNumber;
 
+			if (hashtable->bloomFilter)
+				bloom_add_element(hashtable->bloomFilter,
+								  (unsigned char *) &hashvalue,
+								  sizeof(uint32));
+
 			bucketNumber = ExecHashGetSkewBucket(hashtable, hashvalue);
 			if (bucketNumber != INVALID_SKEW_BUCKET_NO)
 			{
@@ -190,6 +197,19 @@ MultiExecPrivateHash(HashState *node)
 		}
 	}
 
+	/*
+	 * If the Bloom filter ended up with most of its bits set, its false
+	 * positive rate is too high for it to filter anything; drop it so that
+	 * the probe side doesn't waste cycles consulting it.  (An optimally
+	 * sized filter has about half of its bits set.)
+	 */
+	if (hashtable->bloomFilter &&
+		bloom_prop_bits_set(hashtable->bloomFilter) > 0.625)
+	{
+		bloom_free(hashtable->bloomFilter);
+		hashtable->bloomFilter = NULL;
+	}
+
 	/* resize the hash table if needed (NTUP_PER_BUCKET exceeded) */
 	if (hashtable->nbuckets != hashtable->nbuckets_optimal)
 		ExecHashIncreaseNumBuckets(hashtable);
@@ -507,6 +527,7 @@ ExecHashTableCreate(HashState *state, List *hashOperators, List *hashCollations,
 	hashtable->spaceUsedSkew = 0;
 	hashtable->spaceAllowedSkew =
 		hashtable->spaceAllowed * SKEW_WORK_MEM_PERCENT / 100;
+	hashtable->bloomFilter = NULL;
 	hashtable->chunks = NULL;
 	hashtable->current_chunk = NULL;
 	hashtable->parallel_state = state->parallel_state;
@@ -577,6 +598,58 @@ ExecHashTableCreate(HashState *state, List *hashOperators, List *hashCollations,
 		PrepareTempTablespaces();
 	}
 
+	/*
+	 * For a private hash table, also build a Bloom filter over the hash
+	 * values of the inner relation, sized for the planner's row estimate.
+	 * It allows the probe side to reject outer tuples that cannot possibly
+	 * have a match without touching a bucket, and in the multi-batch case
+	 * without saving them to an outer batch file.  (A shared hash table
+	 * would need coordinated filter updates across workers; we don't
+	 * attempt that.)
+	 */
+	if (hashtable->parallel_state == NULL)
+		hashtable->bloomFilter = bloom_create((int64) Max(rows, 1.0),
+											  work_mem, 0);
+
+	/*
+	 * Also track the minimum and maximum value of the join key while
+	 * building a private hash table, when that is cheap and safe: a single
+	 * join key whose operator is the default equality of a pass-by-value
+	 * type with a btree comparison function.  This lets the probe side
+	 * reject out-of-range outer tuples before even hashing them, and unlike
+	 * the Bloom filter it is exact; star-schema probes whose keys fall
+	 * outside the dimension table's key range benefit the most.
+	 */
+	hashtable->useKeyRange = false;
+	hashtable->haveKeyRange = false;
+	hashtable->keyRangeMin = (Datum) 0;
+	hashtable->keyRangeMax = (Datum) 0;
+	if (hashtable->parallel_state == NULL && nkeys == 1)
+	{
+		Oid			hashop = linitial_oid(hashOperators);
+		Oid			lefttype;
+		Oid			righttype;
+
+		op_input_types(hashop, &lefttype, &righttype);
+		if (lefttype == righttype)
+		{
+			TypeCacheEntry *typentry;
+
+			typentry = lookup_type_cache(lefttype,
+										 TYPECACHE_EQ_OPR |
+										 TYPECACHE_CMP_PROC_FINFO);
+			if (typentry->eq_opr == hashop &&
+				OidIsValid(typentry->cmp_proc_finfo.fn_oid) &&
+				typentry->typbyval)
+			{
+				fmgr_info_copy(&hashtable->keyRangeCmp,
+							   &typentry->cmp_proc_finfo,
+							   hashtable->hashCxt);
+				hashtable->useKeyRange = true;
+			}
+		}
+	}
+
 	MemoryContextSwitchTo(oldcxt);
 
 	if (hashtable->parallel_state)
@@ -1049,6 +1122,15 @@ ExecHashIncreaseNumBatches(HashJoinTable hashtable)
 	}
 }
 
+/*
+ * If an exhausted batch kept at least this fraction of its parent's tuples
+ * after a repartitioning round, treat the data as extremely skewed and stop
+ * growing the number of batches.  Repartitioning is a stop-the-world affair
+ * for all participants, so repeating it to split off ever-smaller slivers
+ * costs far more than letting the hot partition exceed the memory budget.
+ */
+#define EXTREME_SKEW_FRACTION	0.95
+
 /*
  * ExecParallelHashIncreaseNumBatches
  *		Every participant attached to grow_batches_barrier must run this
@@ -1234,13 +1316,20 @@ ExecParallelHashIncreaseNumBatches(HashJoinTable hashtable)
 						space_exhausted = true;
 
 						/*
-						 * Did this batch receive ALL of the tuples from its
-						 * parent batch?  That would indicate that further
-						 * repartitioning isn't going to help (the hash values
-						 * are probably all the same).
+						 * Did this batch receive nearly all of the tuples
+						 * from its parent batch?  That indicates that
+						 * further repartitioning isn't going to help much:
+						 * most tuples share a hash value, so every doubling
+						 * makes all participants stop and repartition, just
+						 * to peel off a small fraction.  Give up and keep
+						 * the hot partition in memory, overshooting the
+						 * memory budget, rather than paying for rounds of
+						 * repartitioning with no prospect of success.
 						 */
 						parent = i % pstate->old_nbatch;
-						if (batch->ntuples == hashtable->batches[parent].shared->old_ntuples)
+						if (batch->ntuples >=
+							hashtable->batches[parent].shared->old_ntuples *
+							EXTREME_SKEW_FRACTION)
 							extreme_skew_detected = true;
 					}
 				}
@@ -1785,8 +1874,10 @@ ExecParallelHashTableInsertCurrentBatch(HashJoinTable hashtable,
  *
  * A true result means the tuple's hash value has been successfully computed
  * and stored at *hashvalue.  A false result means the tuple cannot match
- * because it contains a null attribute, and hence it should be discarded
- * immediately.  (If keep_nulls is true then false is never returned.)
+ * because it contains a null attribute, or because its key lies outside the
+ * min/max key range collected from the inner relation, and hence it should
+ * be discarded immediately.  (If keep_nulls is true then false is never
+ * returned.)
  */
 bool
 ExecHashGetHashValue(HashJoinTable hashtable,
@@ -1856,6 +1947,49 @@ ExecHashGetHashValue(HashJoinTable hashtable,
 			/* Compute the hash function */
 			uint32		hkey;
 
+			/*
+			 * Maintain (inner side) or apply (outer side) the min/max filter
+			 * over the join key, if we decided at table creation that the key
+			 * type allows it.  An out-of-range outer key cannot match, so it
+			 * can be rejected just like a null key would be.
+			 */
+			if (hashtable->useKeyRange && i == 0)
+			{
+				if (!outer_tuple)
+				{
+					if (!hashtable->haveKeyRange)
+					{
+						hashtable->keyRangeMin = keyval;
+						hashtable->keyRangeMax = keyval;
+						hashtable->haveKeyRange = true;
+					}
+					else if (DatumGetInt32(FunctionCall2Coll(&hashtable->keyRangeCmp,
+															 hashtable->collations[0],
+															 keyval,
+															 hashtable->keyRangeMin)) < 0)
+						hashtable->keyRangeMin = keyval;
+					else if (DatumGetInt32(FunctionCall2Coll(&hashtable->keyRangeCmp,
+															 hashtable->collations[0],
+															 keyval,
+															 hashtable->keyRangeMax)) > 0)
+						hashtable->keyRangeMax = keyval;
+				}
+				else if (!keep_nulls &&
+						 (!hashtable->haveKeyRange ||
+						  DatumGetInt32(FunctionCall2Coll(&hashtable->keyRangeCmp,
+														  hashtable->collations[0],
+														  keyval,
+														  hashtable->keyRangeMin)) < 0 ||
+						  DatumGetInt32(FunctionCall2Coll(&hashtable->keyRangeCmp,
+														  hashtable->collations[0],
+														  keyval,
+														  hashtable->keyRangeMax)) > 0))
+				{
+					MemoryContextSwitchTo(oldContext);
+					return false;	/* out of range, cannot match */
+				}
+			}
+
 			hkey = DatumGetUInt32(FunctionCall1Coll(&hashfunctions[i], hashtable->collations[i], keyval));
 			hashkey ^= hkey;
 		}
@@ -112,6 +112,7 @@
 #include "executor/hashjoin.h"
 #include "executor/nodeHash.h"
 #include "executor/nodeHashjoin.h"
+#include "lib/bloomfilter.h"
 #include "miscadmin.h"
 #include "pgstat.h"
 #include "utils/memutils.h"
@@ -372,6 +373,24 @@ ExecHashJoinImpl(PlanState *pstate, bool parallel)
 				econtext->ecxt_outertuple = outerTupleSlot;
 				node->hj_MatchedOuter = false;
 
+				/*
+				 * If we built a Bloom filter over the inner relation's hash
+				 * values, consult it first.  If it has no trace of this hash
+				 * value then no inner tuple in any batch can match, so we
+				 * can skip the bucket probe, and in the multi-batch case
+				 * avoid saving the tuple to an outer batch file.  Outer
+				 * joins still need to emit the unmatched tuple, which
+				 * HJ_FILL_OUTER_TUPLE takes care of.
+				 */
+				if (hashtable->bloomFilter &&
+					bloom_lacks_element(hashtable->bloomFilter,
+										(unsigned char *) &hashvalue,
+										sizeof(uint32)))
+				{
+					node->hj_JoinState = HJ_FILL_OUTER_TUPLE;
+					continue;
+				}
+
 				/*
 				 * Find the corresponding bucket for this tuple in the main
 				 * hash table or skew hash table.
@@ -1204,8 +1223,12 @@ ExecHashJoinSaveTuple(MinimalTuple tuple, uint32 hashvalue,
 
 	if (file == NULL)
 	{
-		/* First write to this batch file, so open it. */
-		file = BufFileCreateTemp(false);
+		/*
+		 * First write to this batch file, so open it.  Batch files are
+		 * written and read back strictly sequentially, so compress them to
+		 * save temp-file bandwidth.
+		 */
+		file = BufFileCreateCompressTemp(false);
 		*fileptr = file;
 	}
 
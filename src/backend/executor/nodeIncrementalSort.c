@@ -0,0 +1,461 @@
+/*-------------------------------------------------------------------------
+ *
+ * nodeIncrementalSort.c
+ *	  Routines to handle sorting of input that is already sorted on a
+ *	  prefix of the required sort keys.
+ *
+ * DESCRIPTION
+ *
+ *	Incremental sort is an optimized variant of a full sort for cases
+ *	where the input is already sorted on a leading prefix of the required
+ *	sort keys (e.g., an index on (a) feeding ORDER BY a, b).  Instead of
+ *	accumulating the entire input, we read one run of tuples with equal
+ *	prefix-key values (a "group") at a time, sort only that group on the
+ *	full key list, and emit it before reading the next group.
+ *
+ *	This has two advantages over a full sort.  First, only one group has
+ *	to be held in sort memory at a time, so the sort is much less likely
+ *	to spill to disk.  Second, rows are emitted as soon as the first
+ *	group has been read, which matters a great deal for queries with a
+ *	LIMIT: we read only as many groups from the input as are needed to
+ *	satisfy the bound, instead of the whole input.
+ *
+ *	Group boundaries are detected by comparing each input tuple's
+ *	presorted columns against the first tuple of the current group, using
+ *	the equality operators associated with the ordering operators.  The
+ *	first tuple of the next group is necessarily read one step too early;
+ *	it is parked in a separate slot and fed to the next group's sort.
+ *
+ *	We reuse a single tuplesort across groups via tuplesort_reset, so the
+ *	sort's working memory is allocated only once.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/executor/nodeIncrementalSort.c
+ *
+ *-------------------------------------------------------------------------
+ */
+
+#include "postgres.h"
+
+#include "access/htup_details.h"
+#include "executor/execdebug.h"
+#include "executor/nodeIncrementalSort.h"
+#include "miscadmin.h"
+#include "utils/lsyscache.h"
+#include "utils/tuplesort.h"
+
+
+/*
+ * Prepare information for comparing the presorted columns of two tuples.
+ * We use the equality operator belonging to each ordering operator, as
+ * found in its btree opfamily.
+ */
+static void
+preparePresortedCols(IncrementalSortState *node)
+{
+	IncrementalSort *plannode = castNode(IncrementalSort, node->ss.ps.plan);
+	int			i;
+
+	node->presorted_keys =
+		(PresortedKeyData *) palloc(plannode->nPresortedCols *
+									sizeof(PresortedKeyData));
+
+	for (i = 0; i < plannode->nPresortedCols; i++)
+	{
+		Oid			equalityOp,
+					equalityFunc;
+		PresortedKeyData *key;
+
+		key = &node->presorted_keys[i];
+		key->attno = plannode->sort.sortColIdx[i];
+
+		equalityOp = get_equality_op_for_ordering_op(plannode->sort.sortOperators[i],
+													 NULL);
+		if (!OidIsValid(equalityOp))
+			elog(ERROR, "missing equality operator for ordering operator %u",
+				 plannode->sort.sortOperators[i]);
+
+		equalityFunc = get_opcode(equalityOp);
+		if (!OidIsValid(equalityFunc))
+			elog(ERROR, "missing function for operator %u", equalityOp);
+
+		/* Lookup the comparison function */
+		fmgr_info_cxt(equalityFunc, &key->flinfo, CurrentMemoryContext);
+
+		/* We can initialize the callinfo just once and re-use it */
+		key->fcinfo = palloc0(SizeForFunctionCallInfo(2));
+		InitFunctionCallInfoData(*key->fcinfo, &key->flinfo, 2,
+								 plannode->sort.collations[i], NULL, NULL);
+		key->fcinfo->args[0].isnull = false;
+		key->fcinfo->args[1].isnull = false;
+	}
+}
+
+/*
+ * Check whether a given tuple belongs to the current prefix-key group, by
+ * comparing its presorted column values to those of the group's first tuple.
+ */
+static bool
+isCurrentGroup(IncrementalSortState *node, TupleTableSlot *pivot,
+			   TupleTableSlot *tuple)
+{
+	int			nPresortedCols;
+	int			i;
+
+	nPresortedCols = castNode(IncrementalSort, node->ss.ps.plan)->nPresortedCols;
+
+	/*
+	 * That the input is sorted by keys (0, ... n) implies that the tail keys
+	 * are more likely to change.  Therefore we do our comparison starting
+	 * from the last presorted column to detect inequality as early as
+	 * possible and minimize the number of function calls.
+	 */
+	for (i = nPresortedCols - 1; i >= 0; i--)
+	{
+		Datum		datumA,
+					datumB;
+		bool		isnullA,
+					isnullB;
+		AttrNumber	attno = node->presorted_keys[i].attno;
+		PresortedKeyData *key;
+
+		datumA = slot_getattr(pivot, attno, &isnullA);
+		datumB = slot_getattr(tuple, attno, &isnullB);
+
+		/* Special case for NULL-vs-NULL, else use standard comparison */
+		if (isnullA || isnullB)
+		{
+			if (isnullA == isnullB)
+				continue;
+			else
+				return false;
+		}
+
+		key = &node->presorted_keys[i];
+
+		key->fcinfo->args[0].value = datumA;
+		key->fcinfo->args[1].value = datumB;
+
+		/* just for paranoia's sake, we reset isnull each time */
+		key->fcinfo->isnull = false;
+
+		if (!DatumGetBool(FunctionCallInvoke(key->fcinfo)))
+			return false;
+	}
+
+	return true;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecIncrementalSort
+ *
+ *		Collects tuples from the outer subtree one prefix-key group
+ *		at a time, sorts each group on the full sort key list, and
+ *		returns its tuples before reading the next group.
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+ExecIncrementalSort(PlanState *pstate)
+{
+	IncrementalSortState *node = castNode(IncrementalSortState, pstate);
+	EState	   *estate = node->ss.ps.state;
+	ScanDirection dir = estate->es_direction;
+	Tuplesortstate *tuplesortstate = (Tuplesortstate *) node->tuplesortstate;
+	IncrementalSort *plannode = (IncrementalSort *) node->ss.ps.plan;
+	PlanState  *outerNode;
+	TupleTableSlot *slot;
+
+	CHECK_FOR_INTERRUPTS();
+
+	/*
+	 * While the current group's sort is done, just hand out its tuples.
+	 */
+	if (node->sort_Done)
+	{
+		slot = node->ss.ps.ps_ResultTupleSlot;
+		if (tuplesort_gettupleslot(tuplesortstate,
+								   ScanDirectionIsForward(dir),
+								   false, slot, NULL))
+		{
+			node->bound_Done++;
+			return slot;
+		}
+
+		/*
+		 * The group is exhausted.  If the outer node is too, and no tuple of
+		 * the next group is pending, we are done.
+		 */
+		if (node->outerNodeDone && TupIsNull(node->transfer_tuple))
+			return ExecClearTuple(slot);
+
+		/* Otherwise, prepare to collect the next group. */
+		node->sort_Done = false;
+		tuplesort_reset(tuplesortstate);
+	}
+
+	/*
+	 * Initialize tuplesort module on first use.  We never need random access
+	 * to the sort output, since backward scan and mark/restore are not
+	 * supported (see ExecInitIncrementalSort).
+	 */
+	if (tuplesortstate == NULL)
+	{
+		TupleDesc	tupDesc = ExecGetResultType(outerPlanState(node));
+
+		tuplesortstate = tuplesort_begin_heap(tupDesc,
+											  plannode->sort.numCols,
+											  plannode->sort.sortColIdx,
+											  plannode->sort.sortOperators,
+											  plannode->sort.collations,
+											  plannode->sort.nullsFirst,
+											  work_mem,
+											  NULL, false);
+		node->tuplesortstate = (void *) tuplesortstate;
+	}
+
+	/*
+	 * A bound on the overall result bounds each group's sort as well, less
+	 * the tuples already returned from earlier groups.  This must be applied
+	 * before any tuples are loaded.
+	 */
+	if (node->bounded && node->bound - node->bound_Done > 0)
+		tuplesort_set_bound(tuplesortstate, node->bound - node->bound_Done);
+
+	/*
+	 * Want to scan subplan in the forward direction while creating the
+	 * sorted data.
+	 */
+	estate->es_direction = ForwardScanDirection;
+
+	outerNode = outerPlanState(node);
+
+	/*
+	 * If reading the previous group overshot by one tuple, that tuple opens
+	 * the new group.
+	 */
+	if (!TupIsNull(node->transfer_tuple))
+	{
+		ExecCopySlot(node->group_pivot, node->transfer_tuple);
+		tuplesort_puttupleslot(tuplesortstate, node->transfer_tuple);
+		ExecClearTuple(node->transfer_tuple);
+	}
+
+	/*
+	 * Scan the subplan until the prefix keys change or the input runs dry.
+	 */
+	while (!node->outerNodeDone)
+	{
+		slot = ExecProcNode(outerNode);
+
+		if (TupIsNull(slot))
+		{
+			node->outerNodeDone = true;
+			break;
+		}
+
+		if (TupIsNull(node->group_pivot))
+		{
+			/* first tuple of the group defines its prefix-key values */
+			ExecCopySlot(node->group_pivot, slot);
+		}
+		else if (!isCurrentGroup(node, node->group_pivot, slot))
+		{
+			/*
+			 * The prefix keys changed: this tuple belongs to the next group.
+			 * Park it and sort what we have collected so far.
+			 */
+			ExecCopySlot(node->transfer_tuple, slot);
+			break;
+		}
+
+		tuplesort_puttupleslot(tuplesortstate, slot);
+	}
+
+	/*
+	 * restore to user specified direction
+	 */
+	estate->es_direction = dir;
+
+	if (TupIsNull(node->group_pivot))
+	{
+		/* there was no input at all */
+		return ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+	}
+
+	/*
+	 * Complete the sort of this group.
+	 */
+	tuplesort_performsort(tuplesortstate);
+
+	node->group_count++;
+	node->sort_Done = true;
+	ExecClearTuple(node->group_pivot);
+
+	slot = node->ss.ps.ps_ResultTupleSlot;
+	if (tuplesort_gettupleslot(tuplesortstate,
+							   ScanDirectionIsForward(dir),
+							   false, slot, NULL))
+		node->bound_Done++;
+	return slot;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecInitIncrementalSort
+ *
+ *		Creates the run-time state information for the incremental
+ *		sort node produced by the planner and initializes its outer
+ *		subtree.
+ * ----------------------------------------------------------------
+ */
+IncrementalSortState *
+ExecInitIncrementalSort(IncrementalSort *node, EState *estate, int eflags)
+{
+	IncrementalSortState *incrsortstate;
+	TupleDesc	outerTupDesc;
+
+	SO1_printf("ExecInitIncrementalSort: %s\n",
+			   "initializing sort node");
+
+	/*
+	 * Incremental sort can't be used with EXEC_FLAG_BACKWARD or
+	 * EXEC_FLAG_MARK, because the current sort state contains only one sort
+	 * batch rather than the full result set.
+	 */
+	Assert((eflags & (EXEC_FLAG_BACKWARD | EXEC_FLAG_MARK)) == 0);
+
+	/*
+	 * create state structure
+	 */
+	incrsortstate = makeNode(IncrementalSortState);
+	incrsortstate->ss.ps.plan = (Plan *) node;
+	incrsortstate->ss.ps.state = estate;
+	incrsortstate->ss.ps.ExecProcNode = ExecIncrementalSort;
+
+	incrsortstate->bounded = false;
+	incrsortstate->outerNodeDone = false;
+	incrsortstate->sort_Done = false;
+	incrsortstate->bound_Done = 0;
+	incrsortstate->group_count = 0;
+	incrsortstate->tuplesortstate = NULL;
+	incrsortstate->presorted_keys = NULL;
+
+	/*
+	 * Miscellaneous initialization
+	 *
+	 * Sort nodes don't initialize their ExprContexts because they never call
+	 * ExecQual or ExecProject.
+	 */
+
+	/*
+	 * initialize child nodes
+	 *
+	 * Incremental sort does not support backwards scans and mark/restore, so
+	 * we don't bother removing the flags from eflags here.  We allow passing
+	 * a REWIND flag, because although incremental sort can't use it, the
+	 * rescan machinery handles rewinding by rebuilding from scratch.
+	 */
+	outerPlanState(incrsortstate) = ExecInitNode(outerPlan(node), estate, eflags);
+
+	/*
+	 * Initialize scan slot and type.
+	 */
+	ExecCreateScanSlotFromOuterPlan(estate, &incrsortstate->ss,
+									&TTSOpsMinimalTuple);
+
+	/*
+	 * Initialize return slot and type. No need to initialize projection info
+	 * because this node doesn't do projections.
+	 */
+	ExecInitResultTupleSlotTL(&incrsortstate->ss.ps, &TTSOpsMinimalTuple);
+	incrsortstate->ss.ps.ps_ProjInfo = NULL;
+
+	/*
+	 * Initialize standalone slots used to detect group boundaries and to
+	 * carry the first tuple of the next group over to its sort.
+	 */
+	outerTupDesc = ExecGetResultType(outerPlanState(incrsortstate));
+	incrsortstate->group_pivot =
+		MakeSingleTupleTableSlot(outerTupDesc, &TTSOpsMinimalTuple);
+	incrsortstate->transfer_tuple =
+		MakeSingleTupleTableSlot(outerTupDesc, &TTSOpsMinimalTuple);
+
+	preparePresortedCols(incrsortstate);
+
+	SO1_printf("ExecInitIncrementalSort: %s\n",
+			   "sort node initialized");
+
+	return incrsortstate;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecEndIncrementalSort(node)
+ * ----------------------------------------------------------------
+ */
+void
+ExecEndIncrementalSort(IncrementalSortState *node)
+{
+	SO1_printf("ExecEndIncrementalSort: %s\n",
+			   "shutting down sort node");
+
+	/* clean out the scan tuple */
+	ExecClearTuple(node->ss.ss_ScanTupleSlot);
+	/* must drop pointer to sort result tuple */
+	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+	/* must drop standalone tuple slots from outer node */
+	ExecDropSingleTupleTableSlot(node->group_pivot);
+	ExecDropSingleTupleTableSlot(node->transfer_tuple);
+
+	/*
+	 * Release tuplesort resources.
+	 */
+	if (node->tuplesortstate != NULL)
+	{
+		tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+		node->tuplesortstate = NULL;
+	}
+
+	/*
+	 * shut down the subplan
+	 */
+	ExecEndNode(outerPlanState(node));
+
+	SO1_printf("ExecEndIncrementalSort: %s\n",
+			   "sort node shutdown");
+}
+
+void
+ExecReScanIncrementalSort(IncrementalSortState *node)
+{
+	PlanState  *outerPlan = outerPlanState(node);
+
+	/*
+	 * Unlike a full sort, the sorted data is not available for rescanning
+	 * even when the parameters haven't changed, because only the current
+	 * group's tuples are in the tuplesort.  So we always rebuild from
+	 * scratch.
+	 */
+	node->outerNodeDone = false;
+	node->sort_Done = false;
+	node->bound_Done = 0;
+	node->group_count = 0;
+
+	ExecClearTuple(node->group_pivot);
+	ExecClearTuple(node->transfer_tuple);
+	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
+
+	if (node->tuplesortstate != NULL)
+	{
+		tuplesort_end((Tuplesortstate *) node->tuplesortstate);
+		node->tuplesortstate = NULL;
+	}
+
+	/*
+	 * if chgParam of subnode is not null then plan will be re-scanned by
+	 * first ExecProcNode.
+	 */
+	if (outerPlan->chgParam == NULL)
+		ExecReScan(outerPlan);
+}
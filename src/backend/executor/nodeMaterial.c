@@ -18,12 +18,48 @@
  *		ExecInitMaterial		- initialize node and subnodes
  *		ExecEndMaterial			- shutdown node and subnodes
  *
+ *		Parallel Query Support
+ *		ExecMaterialEstimate
+ *		ExecMaterialInitializeDSM
+ *		ExecMaterialReInitializeDSM
+ *		ExecMaterialInitializeWorker
  */
 #include "postgres.h"
 
 #include "executor/executor.h"
 #include "executor/nodeMaterial.h"
 #include "miscadmin.h"
+#include "pgstat.h"
+#include "storage/barrier.h"
+#include "storage/sharedfileset.h"
+#include "utils/sharedtuplestore.h"
+
+/*
+ * Build phases for a parallel-aware Material node.  One participant is
+ * elected to run the subplan and populate the shared tuplestore while any
+ * others wait; once the build barrier reaches MAT_BUILD_DONE, all
+ * participants scan the complete result independently.
+ */
+#define MAT_BUILD_ELECT		0
+#define MAT_BUILD_RUN		1
+#define MAT_BUILD_DONE		2
+
+/*
+ * Shared state for a parallel-aware Material node, stored in the DSM segment
+ * of the enclosing Gather.  The SharedTuplestore control data follows
+ * immediately after this struct.
+ */
+typedef struct ParallelMaterialState
+{
+	Barrier		build_barrier;	/* synchronizes the build phases above */
+	SharedFileSet fileset;		/* holds the shared tuplestore's files */
+	uint32		generation;		/* bumped at each DSM reinitialization */
+} ParallelMaterialState;
+
+#define ParallelMaterialSts(pms) \
+	((SharedTuplestore *) ((char *) (pms) + MAXALIGN(sizeof(ParallelMaterialState))))
+
+static TupleTableSlot *ExecParallelMaterial(MaterialState *node);
 
 /* ----------------------------------------------------------------
  *		ExecMaterial
@@ -48,6 +84,13 @@ ExecMaterial(PlanState *pstate)
 
 	CHECK_FOR_INTERRUPTS();
 
+	/*
+	 * A parallel-aware Material reads from a shared tuplestore instead of a
+	 * private one; that case is handled separately.
+	 */
+	if (node->sts != NULL)
+		return ExecParallelMaterial(node);
+
 	/*
 	 * get state info from node
 	 */
@@ -156,6 +199,75 @@ ExecMaterial(PlanState *pstate)
 	return ExecClearTuple(slot);
 }
 
+/* ----------------------------------------------------------------
+ *		ExecParallelMaterial
+ *
+ *		Parallel-aware variant of ExecMaterial.  On first call, the
+ *		participants that have attached so far elect one of their number
+ *		to run the subplan to completion and store its output in the
+ *		shared tuplestore; the others wait.  Once the store is complete,
+ *		every participant reads the full result independently, so the
+ *		subplan is executed only once per Gather no matter how many
+ *		workers scan this node.
+ * ----------------------------------------------------------------
+ */
+static TupleTableSlot *
+ExecParallelMaterial(MaterialState *node)
+{
+	TupleTableSlot *slot = node->ss.ps.ps_ResultTupleSlot;
+	MinimalTuple tuple;
+
+	if (!node->sts_ready)
+	{
+		Barrier    *build_barrier = &node->parallel_state->build_barrier;
+		int			phase;
+
+		phase = BarrierAttach(build_barrier);
+		if (phase == MAT_BUILD_ELECT)
+		{
+			if (BarrierArriveAndWait(build_barrier,
+									 WAIT_EVENT_PARALLEL_MATERIAL_BUILD))
+			{
+				/* We have been elected to fill the shared tuplestore. */
+				PlanState  *outerNode = outerPlanState(node);
+
+				for (;;)
+				{
+					TupleTableSlot *outerslot;
+					MinimalTuple mintup;
+					bool		shouldFree;
+
+					outerslot = ExecProcNode(outerNode);
+					if (TupIsNull(outerslot))
+						break;
+					mintup = ExecFetchSlotMinimalTuple(outerslot, &shouldFree);
+					sts_puttuple(node->sts, NULL, mintup);
+					if (shouldFree)
+						pfree(mintup);
+				}
+				sts_end_write(node->sts);
+			}
+			phase = MAT_BUILD_RUN;
+		}
+		if (phase == MAT_BUILD_RUN)
+			BarrierArriveAndWait(build_barrier,
+								 WAIT_EVENT_PARALLEL_MATERIAL_BUILD);
+		BarrierDetach(build_barrier);
+
+		/* The store is complete; set up our own scan of the whole thing. */
+		sts_begin_private_scan(node->sts);
+		node->sts_ready = true;
+	}
+
+	tuple = sts_private_scan_next(node->sts, NULL);
+	if (tuple == NULL)
+		return ExecClearTuple(slot);
+
+	/* The tuple points into the accessor's read buffer; don't free it. */
+	ExecStoreMinimalTuple(tuple, slot, false);
+	return slot;
+}
+
 /* ----------------------------------------------------------------
  *		ExecInitMaterial
  * ----------------------------------------------------------------
@@ -196,6 +308,9 @@ ExecInitMaterial(Material *node, EState *estate, int eflags)
 
 	matstate->eof_underlying = false;
 	matstate->tuplestorestate = NULL;
+	matstate->parallel_state = NULL;
+	matstate->sts = NULL;
+	matstate->sts_ready = false;
 
 	/*
 	 * Miscellaneous initialization
@@ -251,6 +366,13 @@ ExecEndMaterial(MaterialState *node)
 		tuplestore_end(node->tuplestorestate);
 	node->tuplestorestate = NULL;
 
+	/*
+	 * Close any file we had open for reading from a shared tuplestore.  The
+	 * DSM segment may be gone already, so touch only backend-local state.
+	 */
+	if (node->sts != NULL)
+		sts_end_parallel_scan(node->sts);
+
 	/*
 	 * shut down the subplan
 	 */
@@ -321,6 +443,25 @@ ExecReScanMaterial(MaterialState *node)
 
 	ExecClearTuple(node->ss.ps.ps_ResultTupleSlot);
 
+	if (node->sts != NULL)
+	{
+		/*
+		 * Parallel-aware case.  If the subplan's parameters haven't changed,
+		 * just rewind our scan of the shared tuplestore.  Otherwise the
+		 * rescan came through ExecParallelReInitialize, which already reset
+		 * the shared store via ExecMaterialReInitializeDSM; forget that it
+		 * was ever built so the build barrier runs again.
+		 */
+		if (outerPlan->chgParam == NULL)
+		{
+			if (node->sts_ready)
+				sts_begin_private_scan(node->sts);
+		}
+		else
+			node->sts_ready = false;
+		return;
+	}
+
 	if (node->eflags != 0)
 	{
 		/*
@@ -366,3 +507,113 @@ ExecReScanMaterial(MaterialState *node)
 		node->eof_underlying = false;
 	}
 }
+
+/* ----------------------------------------------------------------
+ *						Parallel Query Support
+ * ----------------------------------------------------------------
+ */
+
+/* ----------------------------------------------------------------
+ *		ExecMaterialEstimate
+ *
+ *		Estimate space required to propagate material state.
+ * ----------------------------------------------------------------
+ */
+void
+ExecMaterialEstimate(MaterialState *node, ParallelContext *pcxt)
+{
+	size_t		size;
+
+	size = MAXALIGN(sizeof(ParallelMaterialState)) +
+		sts_estimate(pcxt->nworkers + 1);
+	shm_toc_estimate_chunk(&pcxt->estimator, size);
+	shm_toc_estimate_keys(&pcxt->estimator, 1);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecMaterialInitializeDSM
+ *
+ *		Set up the shared tuplestore that all participants will read.
+ * ----------------------------------------------------------------
+ */
+void
+ExecMaterialInitializeDSM(MaterialState *node, ParallelContext *pcxt)
+{
+	ParallelMaterialState *pms;
+	size_t		size;
+	char		name[MAXPGPATH];
+
+	size = MAXALIGN(sizeof(ParallelMaterialState)) +
+		sts_estimate(pcxt->nworkers + 1);
+	pms = shm_toc_allocate(pcxt->toc, size);
+	BarrierInit(&pms->build_barrier, 0);
+	SharedFileSetInit(&pms->fileset, pcxt->seg);
+	pms->generation = 0;
+
+	/*
+	 * The leader is participant 0; workers use ParallelWorkerNumber + 1.
+	 * Name the store after the current generation, so that a rebuild after
+	 * rescan gets fresh files in the same fileset.
+	 */
+	snprintf(name, sizeof(name), "material.%u", pms->generation);
+	node->sts = sts_initialize(ParallelMaterialSts(pms),
+							   pcxt->nworkers + 1,
+							   0,
+							   0,
+							   0,
+							   &pms->fileset,
+							   name);
+	node->parallel_state = pms;
+
+	shm_toc_insert(pcxt->toc, node->ss.ps.plan->plan_node_id, pms);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecMaterialReInitializeDSM
+ *
+ *		Reset shared state before beginning a fresh scan.
+ * ----------------------------------------------------------------
+ */
+void
+ExecMaterialReInitializeDSM(MaterialState *node, ParallelContext *pcxt)
+{
+	ParallelMaterialState *pms = node->parallel_state;
+	char		name[MAXPGPATH];
+
+	/*
+	 * The subplan's parameters have changed, so the stored result is stale.
+	 * Begin a new generation: re-create the shared tuplestore under a new
+	 * name and rerun the build election.  The previous generation's files
+	 * are cleaned up when the fileset is destroyed.
+	 */
+	pms->generation++;
+	BarrierInit(&pms->build_barrier, 0);
+	snprintf(name, sizeof(name), "material.%u", pms->generation);
+	node->sts = sts_initialize(ParallelMaterialSts(pms),
+							   pcxt->nworkers + 1,
+							   0,
+							   0,
+							   0,
+							   &pms->fileset,
+							   name);
+	node->sts_ready = false;
+}
+
+/* ----------------------------------------------------------------
+ *		ExecMaterialInitializeWorker
+ *
+ *		Attach to the shared tuplestore set up by the leader.
+ * ----------------------------------------------------------------
+ */
+void
+ExecMaterialInitializeWorker(MaterialState *node, ParallelWorkerContext *pwcxt)
+{
+	ParallelMaterialState *pms;
+
+	pms = shm_toc_lookup(pwcxt->toc, node->ss.ps.plan->plan_node_id, false);
+	node->parallel_state = pms;
+	node->sts = sts_attach(ParallelMaterialSts(pms),
+						   ParallelWorkerNumber + 1,
+						   &pms->fileset);
+	node->sts_ready = false;
+}
@@ -57,7 +57,19 @@
 #include "utils/memutils.h"
 #include "utils/rel.h"
 
-
+/*
+ * No more than this many tuples may be buffered for a multi-insert before
+ * the buffer is flushed, and the buffer is also flushed once the buffered
+ * tuples exceed this many bytes.  Same limits as used by COPY.
+ */
+#define MT_MAX_BUFFERED_TUPLES	1000
+#define MT_MAX_BUFFERED_BYTES	65535
+
+static void ExecMultiInsertBufferTuple(ModifyTableState *mtstate,
+									   ResultRelInfo *resultRelInfo,
+									   TupleTableSlot *slot,
+									   EState *estate);
+static void ExecMultiInsertFlush(ModifyTableState *mtstate, EState *estate);
 static bool ExecOnConflictUpdate(ModifyTableState *mtstate,
 								 ResultRelInfo *resultRelInfo,
 								 ItemPointer conflictTid,
@@ -330,6 +342,119 @@ ExecComputeStoredGenerated(EState *estate, TupleTableSlot *slot)
 	MemoryContextSwitchTo(oldContext);
 }
 
+/* ----------------------------------------------------------------
+ *		ExecMultiInsertBufferTuple
+ *
+ *		Add one tuple to the multi-insert buffer, flushing the buffer to
+ *		the table if it fills up.  The caller has already checked any
+ *		constraints on the tuple; index entries and AFTER ROW triggers are
+ *		taken care of when the buffer is flushed.
+ * ----------------------------------------------------------------
+ */
+static void
+ExecMultiInsertBufferTuple(ModifyTableState *mtstate,
+						   ResultRelInfo *resultRelInfo,
+						   TupleTableSlot *slot,
+						   EState *estate)
+{
+	TupleTableSlot *batchslot;
+	HeapTuple	tuple;
+
+	/* Allocate the buffer and bulk-insert state on first use */
+	if (mtstate->mt_multi_slots == NULL)
+	{
+		mtstate->mt_multi_slots = (TupleTableSlot **)
+			palloc0(MT_MAX_BUFFERED_TUPLES * sizeof(TupleTableSlot *));
+		mtstate->mt_bistate = GetBulkInsertState();
+	}
+
+	/* Initialize the next buffer slot, if we've not used it before */
+	if (mtstate->mt_multi_slots[mtstate->mt_multi_nused] == NULL)
+		mtstate->mt_multi_slots[mtstate->mt_multi_nused] =
+			table_slot_create(resultRelInfo->ri_RelationDesc, NULL);
+	batchslot = mtstate->mt_multi_slots[mtstate->mt_multi_nused];
+
+	ExecCopySlot(batchslot, slot);
+
+	/*
+	 * Materialize the copied tuple to account for its size; forming the heap
+	 * tuple here is no loss, as table_multi_insert will need it anyway.
+	 */
+	tuple = ExecFetchSlotHeapTuple(batchslot, true, NULL);
+	mtstate->mt_multi_nused++;
+	mtstate->mt_multi_bytes += tuple->t_len;
+
+	if (mtstate->mt_multi_nused >= MT_MAX_BUFFERED_TUPLES ||
+		mtstate->mt_multi_bytes >= MT_MAX_BUFFERED_BYTES)
+		ExecMultiInsertFlush(mtstate, estate);
+}
+
+/* ----------------------------------------------------------------
+ *		ExecMultiInsertFlush
+ *
+ *		Write out any tuples in the multi-insert buffer with a single
+ *		table_multi_insert call, then add index entries and fire AFTER
+ *		ROW triggers for the inserted tuples.
+ * ----------------------------------------------------------------
+ */
+static void
+ExecMultiInsertFlush(ModifyTableState *mtstate, EState *estate)
+{
+	ResultRelInfo *resultRelInfo = estate->es_result_relation_info;
+	TupleTableSlot **slots = mtstate->mt_multi_slots;
+	int			nused = mtstate->mt_multi_nused;
+	MemoryContext oldcontext;
+	bool		batched;
+	int			i;
+
+	if (nused == 0)
+		return;
+
+	/*
+	 * table_multi_insert may leak memory, so switch to short-lived memory
+	 * context before calling it.
+	 */
+	oldcontext = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
+	table_multi_insert(resultRelInfo->ri_RelationDesc,
+					   slots,
+					   nused,
+					   estate->es_output_cid,
+					   0,
+					   mtstate->mt_bistate);
+	MemoryContextSwitchTo(oldcontext);
+
+	if (mtstate->canSetTag)
+		setLastTid(&slots[nused - 1]->tts_tid);
+
+	/*
+	 * If no index needs uniqueness or exclusion checks, insert all the index
+	 * entries as a single batch; otherwise fall back to per-tuple insertion.
+	 */
+	batched = false;
+	if (resultRelInfo->ri_NumIndices > 0)
+		batched = ExecInsertIndexTuplesBatch(slots, nused, estate);
+
+	for (i = 0; i < nused; i++)
+	{
+		List	   *recheckIndexes = NIL;
+
+		/* insert index entries for tuple */
+		if (!batched && resultRelInfo->ri_NumIndices > 0)
+			recheckIndexes = ExecInsertIndexTuples(slots[i], estate, false,
+												   NULL, NIL);
+
+		/* AFTER ROW INSERT Triggers */
+		ExecARInsertTriggers(estate, resultRelInfo, slots[i], recheckIndexes,
+							 mtstate->mt_transition_capture);
+
+		list_free(recheckIndexes);
+		ExecClearTuple(slots[i]);
+	}
+
+	mtstate->mt_multi_nused = 0;
+	mtstate->mt_multi_bytes = 0;
+}
+
 /* ----------------------------------------------------------------
  *		ExecInsert
  *
@@ -466,7 +591,23 @@ ExecInsert(ModifyTableState *mtstate,
 			  resultRelInfo->ri_TrigDesc->trig_insert_before_row)))
 			ExecPartitionCheck(resultRelInfo, slot, estate, true);
 
-		if (onconflict != ONCONFLICT_NONE && resultRelInfo->ri_NumIndices > 0)
+		if (mtstate->mt_use_multi_insert)
+		{
+			/*
+			 * Buffer the tuple for a batched table_multi_insert call.  The
+			 * eligibility checks in ExecInitModifyTable ensure that nothing
+			 * below this point applies: there is no ON CONFLICT clause, no
+			 * RETURNING list, no view WITH CHECK OPTIONS, and AFTER ROW
+			 * triggers are fired when the buffer is flushed.
+			 */
+			ExecMultiInsertBufferTuple(mtstate, resultRelInfo, slot, estate);
+
+			if (canSetTag)
+				(estate->es_processed)++;
+
+			return NULL;
+		}
+		else if (onconflict != ONCONFLICT_NONE && resultRelInfo->ri_NumIndices > 0)
 		{
 			/* Perform a speculative insertion. */
 			uint32		specToken;
@@ -2244,6 +2385,10 @@ ExecModifyTable(PlanState *pstate)
 		}
 	}
 
+	/* Write out any tuples still waiting in the multi-insert buffer */
+	if (node->mt_use_multi_insert)
+		ExecMultiInsertFlush(node, estate);
+
 	/* Restore es_result_relation_info before exiting */
 	estate->es_result_relation_info = saved_resultRelInfo;
 
@@ -2426,6 +2571,36 @@ ExecInitModifyTable(ModifyTable *node, EState *estate, int eflags)
 		mtstate->mt_root_tuple_slot = table_slot_create(rel, NULL);
 	}
 
+	/*
+	 * Check whether inserts can be batched through table_multi_insert.  It's
+	 * generally more efficient to prepare a bunch of tuples for insertion and
+	 * insert them in one table_multi_insert() call than to call
+	 * table_tuple_insert() separately for every tuple, as COPY already does.
+	 * We can only do so for a plain INSERT into a non-partitioned ordinary
+	 * table, with no ON CONFLICT clause and no RETURNING list.  BEFORE or
+	 * INSTEAD OF row triggers might query the table we're inserting into and
+	 * act differently if the tuples that have already been processed and
+	 * prepared for insertion are not there, so they force one-by-one
+	 * inserts, as do WITH CHECK OPTIONS, which the SQL spec requires to be
+	 * checked only after testing uniqueness violations.  Unlike COPY, we
+	 * need no test for volatile default expressions: the rewriter has
+	 * already folded defaults into the subplan, so they are evaluated before
+	 * the tuple is buffered.
+	 */
+	resultRelInfo = mtstate->resultRelInfo;
+	mtstate->mt_use_multi_insert =
+		operation == CMD_INSERT &&
+		nplans == 1 &&
+		node->onConflictAction == ONCONFLICT_NONE &&
+		node->returningLists == NIL &&
+		node->withCheckOptionLists == NIL &&
+		mtstate->mt_partition_tuple_routing == NULL &&
+		resultRelInfo->ri_FdwRoutine == NULL &&
+		resultRelInfo->ri_RelationDesc->rd_rel->relkind == RELKIND_RELATION &&
+		(resultRelInfo->ri_TrigDesc == NULL ||
+		 (!resultRelInfo->ri_TrigDesc->trig_insert_before_row &&
+		  !resultRelInfo->ri_TrigDesc->trig_insert_instead_row));
+
 	/*
 	 * Initialize any WITH CHECK OPTION constraints if needed.
 	 */
@@ -2760,6 +2935,25 @@ ExecEndModifyTable(ModifyTableState *node)
 			ExecDropSingleTupleTableSlot(node->mt_root_tuple_slot);
 	}
 
+	/*
+	 * Release multi-insert resources, if we used any.  Buffered tuples were
+	 * already flushed when the subplan was run to completion.
+	 */
+	if (node->mt_multi_slots)
+	{
+		Assert(node->mt_multi_nused == 0);
+
+		for (i = 0; i < MT_MAX_BUFFERED_TUPLES; i++)
+		{
+			if (node->mt_multi_slots[i] == NULL)
+				break;
+			ExecDropSingleTupleTableSlot(node->mt_multi_slots[i]);
+		}
+		pfree(node->mt_multi_slots);
+		FreeBulkInsertState(node->mt_bistate);
+		table_finish_bulk_insert(node->resultRelInfo->ri_RelationDesc, 0);
+	}
+
 	/*
 	 * Free the exprcontext
 	 */
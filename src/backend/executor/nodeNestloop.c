@@ -24,8 +24,125 @@
 #include "executor/execdebug.h"
 #include "executor/nodeNestloop.h"
 #include "miscadmin.h"
+#include "optimizer/clauses.h"
+#include "optimizer/optimizer.h"
+#include "utils/datum.h"
+#include "utils/lsyscache.h"
 #include "utils/memutils.h"
 
+static bool ExecNestLoopCanCacheInner(Plan *plan);
+
+
+/* ----------------------------------------------------------------
+ *		ExecNestLoopCanCacheInner
+ *
+ *		Decide whether the inner plan's output can safely be stored and
+ *		replayed when consecutive outer tuples supply the same parameter
+ *		values.  That requires the subtree's output to be a pure function
+ *		of its parameters: no volatile functions, no SubPlans (we can't
+ *		cheaply inspect what those execute), no initplans, and only node
+ *		types whose expression fields we know how to examine.  Anything
+ *		we don't recognize is treated as unsafe.
+ * ----------------------------------------------------------------
+ */
+static bool
+ExecNestLoopCanCacheInner(Plan *plan)
+{
+	if (plan == NULL)
+		return true;
+
+	/* initplans could perhaps be proven safe, but don't bother trying */
+	if (plan->initPlan != NIL)
+		return false;
+
+	if (contain_volatile_functions((Node *) plan->targetlist) ||
+		contain_subplans((Node *) plan->targetlist) ||
+		contain_volatile_functions((Node *) plan->qual) ||
+		contain_subplans((Node *) plan->qual))
+		return false;
+
+	switch (nodeTag(plan))
+	{
+		case T_SeqScan:
+		case T_Material:
+		case T_Sort:
+		case T_IncrementalSort:
+		case T_Unique:
+		case T_Group:
+		case T_Agg:
+			/* no expression fields beyond targetlist and qual */
+			break;
+		case T_Result:
+			if (contain_volatile_functions(((Result *) plan)->resconstantqual) ||
+				contain_subplans(((Result *) plan)->resconstantqual))
+				return false;
+			break;
+		case T_Limit:
+			if (contain_volatile_functions(((Limit *) plan)->limitOffset) ||
+				contain_subplans(((Limit *) plan)->limitOffset) ||
+				contain_volatile_functions(((Limit *) plan)->limitCount) ||
+				contain_subplans(((Limit *) plan)->limitCount))
+				return false;
+			break;
+		case T_IndexScan:
+			if (contain_volatile_functions((Node *) ((IndexScan *) plan)->indexqual) ||
+				contain_subplans((Node *) ((IndexScan *) plan)->indexqual) ||
+				contain_volatile_functions((Node *) ((IndexScan *) plan)->indexorderby) ||
+				contain_subplans((Node *) ((IndexScan *) plan)->indexorderby))
+				return false;
+			break;
+		case T_IndexOnlyScan:
+			if (contain_volatile_functions((Node *) ((IndexOnlyScan *) plan)->indexqual) ||
+				contain_subplans((Node *) ((IndexOnlyScan *) plan)->indexqual) ||
+				contain_volatile_functions((Node *) ((IndexOnlyScan *) plan)->indexorderby) ||
+				contain_subplans((Node *) ((IndexOnlyScan *) plan)->indexorderby))
+				return false;
+			break;
+		case T_BitmapHeapScan:
+			if (contain_volatile_functions((Node *) ((BitmapHeapScan *) plan)->bitmapqualorig) ||
+				contain_subplans((Node *) ((BitmapHeapScan *) plan)->bitmapqualorig))
+				return false;
+			break;
+		case T_BitmapIndexScan:
+			if (contain_volatile_functions((Node *) ((BitmapIndexScan *) plan)->indexqual) ||
+				contain_subplans((Node *) ((BitmapIndexScan *) plan)->indexqual))
+				return false;
+			break;
+		case T_TidScan:
+			if (contain_volatile_functions((Node *) ((TidScan *) plan)->tidquals) ||
+				contain_subplans((Node *) ((TidScan *) plan)->tidquals))
+				return false;
+			break;
+		case T_BitmapAnd:
+			{
+				ListCell   *lc;
+
+				foreach(lc, ((BitmapAnd *) plan)->bitmapplans)
+				{
+					if (!ExecNestLoopCanCacheInner((Plan *) lfirst(lc)))
+						return false;
+				}
+			}
+			break;
+		case T_BitmapOr:
+			{
+				ListCell   *lc;
+
+				foreach(lc, ((BitmapOr *) plan)->bitmapplans)
+				{
+					if (!ExecNestLoopCanCacheInner((Plan *) lfirst(lc)))
+						return false;
+				}
+			}
+			break;
+		default:
+			return false;
+	}
+
+	return ExecNestLoopCanCacheInner(plan->lefttree) &&
+		ExecNestLoopCanCacheInner(plan->righttree);
+}
+
 
 /* ----------------------------------------------------------------
  *		ExecNestLoop(node)
@@ -69,6 +186,7 @@ ExecNestLoop(PlanState *pstate)
 	ExprState  *joinqual;
 	ExprState  *otherqual;
 	ExprContext *econtext;
+	MemoryContext oldcontext;
 	ListCell   *lc;
 
 	CHECK_FOR_INTERRUPTS();
@@ -105,6 +223,8 @@ ExecNestLoop(PlanState *pstate)
 		 */
 		if (node->nl_NeedNewOuter)
 		{
+			int			i;
+
 			ENL1_printf("getting new outer tuple");
 			outerTupleSlot = ExecProcNode(outerPlan);
 
@@ -145,6 +265,80 @@ ExecNestLoop(PlanState *pstate)
 													 paramno);
 			}
 
+			/*
+			 * If we captured the previous parameters' complete inner result,
+			 * and the new parameter values are binary-identical to them, we
+			 * can replay the stored tuples instead of rescanning the inner
+			 * plan.  Binary equality is conservative but always safe: the
+			 * inner plan cannot distinguish two identical datum images.
+			 */
+			if (node->nl_CacheUsable)
+			{
+				bool		replay = node->nl_CacheComplete;
+
+				if (replay)
+				{
+					i = 0;
+					foreach(lc, nl->nestParams)
+					{
+						NestLoopParam *nlp = (NestLoopParam *) lfirst(lc);
+						ParamExecData *prm;
+
+						prm = &(econtext->ecxt_param_exec_vals[nlp->paramno]);
+						if (prm->isnull || node->nl_LastParamNulls[i])
+							replay = prm->isnull && node->nl_LastParamNulls[i];
+						else
+							replay = datumIsEqual(prm->value,
+												  node->nl_LastParamValues[i],
+												  node->nl_ParamTypByVals[i],
+												  node->nl_ParamTypLens[i]);
+						if (!replay)
+							break;
+						i++;
+					}
+				}
+
+				if (replay)
+				{
+					ENL1_printf("replaying cached inner tuples");
+					tuplestore_rescan(node->nl_CacheStore);
+					node->nl_CacheReplay = true;
+					continue;
+				}
+
+				/*
+				 * Remember the new parameter values and start filling a
+				 * fresh cache while the inner plan is scanned.  The datums
+				 * must be copied out of the outer slot, since it will be
+				 * replaced before we compare against them.
+				 */
+				MemoryContextReset(node->nl_ParamCxt);
+				oldcontext = MemoryContextSwitchTo(node->nl_ParamCxt);
+				i = 0;
+				foreach(lc, nl->nestParams)
+				{
+					NestLoopParam *nlp = (NestLoopParam *) lfirst(lc);
+					ParamExecData *prm;
+
+					prm = &(econtext->ecxt_param_exec_vals[nlp->paramno]);
+					node->nl_LastParamNulls[i] = prm->isnull;
+					if (prm->isnull)
+						node->nl_LastParamValues[i] = (Datum) 0;
+					else
+						node->nl_LastParamValues[i] =
+							datumCopy(prm->value,
+									  node->nl_ParamTypByVals[i],
+									  node->nl_ParamTypLens[i]);
+					i++;
+				}
+				MemoryContextSwitchTo(oldcontext);
+
+				tuplestore_clear(node->nl_CacheStore);
+				node->nl_CacheComplete = false;
+				node->nl_CacheFilling = true;
+				node->nl_CacheReplay = false;
+			}
+
 			/*
 			 * now rescan the inner plan
 			 */
@@ -153,11 +347,35 @@ ExecNestLoop(PlanState *pstate)
 		}
 
 		/*
-		 * we have an outerTuple, try to get the next inner tuple.
+		 * we have an outerTuple, try to get the next inner tuple, either by
+		 * replaying the cached inner result or by running the inner plan.
 		 */
 		ENL1_printf("getting new inner tuple");
 
-		innerTupleSlot = ExecProcNode(innerPlan);
+		if (node->nl_CacheReplay)
+		{
+			if (tuplestore_gettupleslot(node->nl_CacheStore, true, false,
+										node->nl_CacheSlot))
+				innerTupleSlot = node->nl_CacheSlot;
+			else
+				innerTupleSlot = ExecClearTuple(node->nl_CacheSlot);
+		}
+		else
+		{
+			innerTupleSlot = ExecProcNode(innerPlan);
+			if (node->nl_CacheFilling)
+			{
+				if (!TupIsNull(innerTupleSlot))
+					tuplestore_puttupleslot(node->nl_CacheStore,
+											innerTupleSlot);
+				else
+				{
+					/* captured this parameter set's complete inner result */
+					node->nl_CacheFilling = false;
+					node->nl_CacheComplete = true;
+				}
+			}
+		}
 		econtext->ecxt_innertuple = innerTupleSlot;
 
 		if (TupIsNull(innerTupleSlot))
@@ -301,6 +519,56 @@ ExecInitNestLoop(NestLoop *node, EState *estate, int eflags)
 		eflags &= ~EXEC_FLAG_REWIND;
 	innerPlanState(nlstate) = ExecInitNode(innerPlan(node), estate, eflags);
 
+	/*
+	 * If the inner rel is parameterized by us and its plan's output is a
+	 * pure function of those parameters, arrange to store the inner tuples
+	 * in a tuplestore as they are fetched, so that when consecutive outer
+	 * tuples supply identical parameter values we can replay the stored
+	 * result instead of rescanning the inner plan.  That turns repeated
+	 * index descents for duplicate outer keys into a single one.
+	 */
+	nlstate->nl_CacheUsable = (node->nestParams != NIL &&
+							   ExecNestLoopCanCacheInner(innerPlan(node)));
+	if (nlstate->nl_CacheUsable)
+	{
+		int			nparams = list_length(node->nestParams);
+		ListCell   *lc;
+		int			i;
+
+		/*
+		 * Inner tuples will reach our expressions either from the inner
+		 * plan's own result slot or from our minimal-tuple cache slot, so
+		 * force them to use the generic slot access routines.  This must be
+		 * done before initializing the projection and quals below.
+		 */
+		nlstate->js.ps.inneropsset = true;
+		nlstate->js.ps.inneropsfixed = false;
+
+		nlstate->nl_NumParams = nparams;
+		nlstate->nl_LastParamValues = (Datum *) palloc0(nparams * sizeof(Datum));
+		nlstate->nl_LastParamNulls = (bool *) palloc0(nparams * sizeof(bool));
+		nlstate->nl_ParamTypLens = (int16 *) palloc(nparams * sizeof(int16));
+		nlstate->nl_ParamTypByVals = (bool *) palloc(nparams * sizeof(bool));
+		i = 0;
+		foreach(lc, node->nestParams)
+		{
+			NestLoopParam *nlp = (NestLoopParam *) lfirst(lc);
+
+			get_typlenbyval(nlp->paramval->vartype,
+							&nlstate->nl_ParamTypLens[i],
+							&nlstate->nl_ParamTypByVals[i]);
+			i++;
+		}
+		nlstate->nl_ParamCxt = AllocSetContextCreate(CurrentMemoryContext,
+													 "NestLoopParamCache",
+													 ALLOCSET_SMALL_SIZES);
+		nlstate->nl_CacheStore = tuplestore_begin_heap(false, false, work_mem);
+		nlstate->nl_CacheSlot =
+			ExecInitExtraTupleSlot(estate,
+								   ExecGetResultType(innerPlanState(nlstate)),
+								   &TTSOpsMinimalTuple);
+	}
+
 	/*
 	 * Initialize result slot, type and projection.
 	 */
@@ -369,6 +637,10 @@ ExecEndNestLoop(NestLoopState *node)
 	 */
 	ExecFreeExprContext(&node->js.ps);
 
+	/* release the inner-result cache, if any */
+	if (node->nl_CacheStore)
+		tuplestore_end(node->nl_CacheStore);
+
 	/*
 	 * clean out the tuple table
 	 */
@@ -406,6 +678,18 @@ ExecReScanNestLoop(NestLoopState *node)
 	 * outer Vars are used as run-time keys...
 	 */
 
+	/*
+	 * The cached inner result may depend on params from above us that have
+	 * changed, so it cannot be trusted across a rescan.
+	 */
+	if (node->nl_CacheUsable)
+	{
+		tuplestore_clear(node->nl_CacheStore);
+		node->nl_CacheComplete = false;
+		node->nl_CacheFilling = false;
+		node->nl_CacheReplay = false;
+	}
+
 	node->nl_NeedNewOuter = true;
 	node->nl_MatchedOuter = false;
 }
@@ -60,7 +60,8 @@ tqueueReceiveSlot(TupleTableSlot *slot, DestReceiver *self)
 
 	/* Send the tuple itself. */
 	tuple = ExecFetchSlotHeapTuple(slot, true, &should_free);
-	result = shm_mq_send(tqueue->queue, tuple->t_len, tuple->t_data, false);
+	result = shm_mq_send(tqueue->queue, tuple->t_len, tuple->t_data, false,
+						 false);
 
 	if (should_free)
 		heap_freetuple(tuple);
@@ -210,3 +211,68 @@ TupleQueueReaderNext(TupleQueueReader *reader, bool nowait, bool *done)
 
 	return heap_copytuple(&htup);
 }
+
+/*
+ * Variant of TupleQueueReaderNext that recycles caller-provided storage
+ * instead of palloc'ing a fresh copy of every tuple.
+ *
+ * *buf and *buflen describe a storage chunk owned by the caller, initially
+ * NULL/0; it is allocated or enlarged in CurrentMemoryContext as needed
+ * and reused on subsequent calls.  The returned tuple points into *buf,
+ * so it remains valid only until the same storage is passed back in, and
+ * must not be freed by tuple-consuming code.  This avoids per-tuple
+ * palloc/pfree churn in callers that read many tuples, such as Gather
+ * Merge's read-ahead buffering.
+ */
+HeapTuple
+TupleQueueReaderNextReuse(TupleQueueReader *reader, bool nowait, bool *done,
+						  void **buf, Size *buflen)
+{
+	HeapTuple	tuple;
+	shm_mq_result result;
+	Size		nbytes;
+	Size		required;
+	void	   *data;
+
+	if (done != NULL)
+		*done = false;
+
+	/* Attempt to read a message. */
+	result = shm_mq_receive(reader->queue, &nbytes, &data, nowait);
+
+	/* If queue is detached, set *done and return NULL. */
+	if (result == SHM_MQ_DETACHED)
+	{
+		if (done != NULL)
+			*done = true;
+		return NULL;
+	}
+
+	/* In non-blocking mode, bail out if no message ready yet. */
+	if (result == SHM_MQ_WOULD_BLOCK)
+		return NULL;
+	Assert(result == SHM_MQ_SUCCESS);
+
+	/* Make sure the recycled chunk is big enough, then copy into it. */
+	required = HEAPTUPLESIZE + nbytes;
+	if (*buf == NULL)
+	{
+		*buf = palloc(required);
+		*buflen = required;
+	}
+	else if (*buflen < required)
+	{
+		*buf = repalloc(*buf, required);
+		*buflen = required;
+	}
+
+	/* Lay the tuple out the same way heap_copytuple would. */
+	tuple = (HeapTuple) *buf;
+	tuple->t_len = nbytes;
+	ItemPointerSetInvalid(&tuple->t_self);
+	tuple->t_tableOid = InvalidOid;
+	tuple->t_data = (HeapTupleHeader) ((char *) *buf + HEAPTUPLESIZE);
+	memcpy(tuple->t_data, data, nbytes);
+
+	return tuple;
+}
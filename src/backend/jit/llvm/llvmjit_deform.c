@@ -25,6 +25,189 @@
 #include "executor/tuptable.h"
 #include "jit/llvmjit.h"
 #include "jit/llvmjit_emit.h"
+#include "utils/hashutils.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+
+
+/*
+ * Backend-local cache of compiled deforming functions.
+ *
+ * The code generated by slot_compile_deform() depends only on the contents
+ * of the tuple descriptor, the slot type and the number of leading columns
+ * to deform, so it can be reused whenever the same combination comes up
+ * again -- in another plan node, or in a later query.  The cache maps a
+ * signature of those inputs to the address of the emitted function.  The
+ * code lives in private contexts that are not tied to a resource owner, so
+ * cached entries stay usable for the rest of the backend's life.  This
+ * makes JITed deforming pay off even for short queries that hit the same
+ * tables over and over.
+ */
+typedef struct LLVMJitDeformKey
+{
+	uint32		desc_hash;		/* hash of the descriptor's signature */
+	int32		natts;			/* number of leading columns to deform */
+	const TupleTableSlotOps *ops;	/* slot type */
+	int32		opt3;			/* compiled with PGJIT_OPT3? */
+} LLVMJitDeformKey;
+
+typedef struct LLVMJitDeformEntry
+{
+	LLVMJitDeformKey key;
+	TupleDesc	desc;			/* full copy, to detect hash collisions */
+	void	   *deform_fn;		/* address of the emitted function */
+} LLVMJitDeformEntry;
+
+static HTAB *llvm_deform_cache = NULL;
+
+/* long-lived contexts holding the cached code, one per optimization level */
+static LLVMJitContext *llvm_deform_context[2];
+
+
+/*
+ * Hash the parts of a tuple descriptor that influence the generated code.
+ * Collisions merely disable caching for the losing descriptor; they are
+ * detected with equalTupleDescs() in llvm_get_deform_function().
+ */
+static uint32
+llvm_deform_desc_hash(TupleDesc desc)
+{
+	uint32		h;
+	int			attnum;
+
+	h = murmurhash32((uint32) desc->natts);
+	for (attnum = 0; attnum < desc->natts; attnum++)
+	{
+		Form_pg_attribute att = TupleDescAttr(desc, attnum);
+
+		h = hash_combine(h, murmurhash32((uint32) att->atttypid));
+		h = hash_combine(h, murmurhash32((uint32) (int32) att->attlen));
+		h = hash_combine(h, murmurhash32((uint32) att->attalign));
+	}
+
+	return h;
+}
+
+/*
+ * Return the private context holding cached deforming code for the given
+ * optimization level, creating it on first use.  Unlike contexts made by
+ * llvm_create_context() these are not owned by a resource owner, as the
+ * emitted code has to outlive the current query.
+ */
+static LLVMJitContext *
+llvm_deform_cache_context(int jitFlags)
+{
+	int			idx = (jitFlags & PGJIT_OPT3) ? 1 : 0;
+
+	if (llvm_deform_context[idx] == NULL)
+	{
+		LLVMJitContext *context;
+
+		context = MemoryContextAllocZero(TopMemoryContext,
+										 sizeof(LLVMJitContext));
+		context->base.flags = PGJIT_PERFORM | PGJIT_DEFORM |
+			(jitFlags & PGJIT_OPT3);
+		context->base.resowner = NULL;
+		llvm_deform_context[idx] = context;
+	}
+
+	return llvm_deform_context[idx];
+}
+
+/*
+ * llvm_get_deform_function
+ *		Return the address of compiled deforming code for desc/ops/natts.
+ *
+ * The returned function has the same signature as those built by
+ * slot_compile_deform(), but has already been emitted and may be called,
+ * via a constant pointer, from any module for the rest of the backend's
+ * life.  Returns NULL if no cacheable deformer is available; the caller
+ * should then fall back to generating a per-query deform function.
+ */
+void *
+llvm_get_deform_function(LLVMJitContext *context, TupleDesc desc,
+						 const TupleTableSlotOps *ops, int natts)
+{
+	LLVMJitDeformKey key;
+	LLVMJitDeformEntry *entry;
+	LLVMJitContext *cachectx;
+	LLVMValueRef v_deform_fn;
+	void	   *deform_fn;
+	char	   *funcname;
+	TupleDesc	desccopy;
+	MemoryContext oldcontext;
+	bool		found;
+
+	/* only slot types slot_compile_deform() knows how to handle */
+	if (ops != &TTSOpsHeapTuple && ops != &TTSOpsBufferHeapTuple &&
+		ops != &TTSOpsMinimalTuple)
+		return NULL;
+
+	if (llvm_deform_cache == NULL)
+	{
+		HASHCTL		ctl;
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(LLVMJitDeformKey);
+		ctl.entrysize = sizeof(LLVMJitDeformEntry);
+		ctl.hcxt = TopMemoryContext;
+		llvm_deform_cache = hash_create("LLVM deform cache", 64, &ctl,
+										HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
+	MemSet(&key, 0, sizeof(key));
+	key.desc_hash = llvm_deform_desc_hash(desc);
+	key.natts = natts;
+	key.ops = ops;
+	key.opt3 = (context->base.flags & PGJIT_OPT3) ? 1 : 0;
+
+	entry = hash_search(llvm_deform_cache, &key, HASH_FIND, NULL);
+	if (entry != NULL)
+	{
+		/*
+		 * A signature collision between different descriptors would hand
+		 * out code compiled for the wrong layout, so verify with a full
+		 * comparison before trusting the entry.
+		 */
+		if (!equalTupleDescs(entry->desc, desc))
+			return NULL;
+
+		return entry->deform_fn;
+	}
+
+	/*
+	 * Not cached yet, so compile into the long-lived context.  If anything
+	 * errors out below no cache entry has been created, leaving the cache
+	 * consistent.
+	 */
+	cachectx = llvm_deform_cache_context(context->base.flags);
+
+	v_deform_fn = slot_compile_deform(cachectx, desc, ops, natts);
+	if (v_deform_fn == NULL)
+		return NULL;
+
+	/*
+	 * Optimize and emit the module, and resolve the function's address.
+	 * The time this takes is covered by the caller's generation counter;
+	 * just account for the function itself.
+	 */
+	funcname = pstrdup(LLVMGetValueName(v_deform_fn));
+	deform_fn = llvm_get_function(cachectx, funcname);
+	pfree(funcname);
+
+	context->base.instr.created_functions++;
+
+	oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+	desccopy = CreateTupleDescCopyConstr(desc);
+	MemoryContextSwitchTo(oldcontext);
+
+	entry = hash_search(llvm_deform_cache, &key, HASH_ENTER, &found);
+	Assert(!found);
+	entry->desc = desccopy;
+	entry->deform_fn = deform_fn;
+
+	return deform_fn;
+}
 
 
 /*
@@ -321,10 +321,38 @@ llvm_compile_expr(ExprState *state)
 					 */
 					if (tts_ops && desc && (context->base.flags & PGJIT_DEFORM))
 					{
-						l_jit_deform =
-							slot_compile_deform(context, desc,
-												tts_ops,
-												op->d.fetch.last_var);
+						void	   *deform_fn;
+
+						/*
+						 * Reuse an already compiled deform function for this
+						 * descriptor/slot type if there is one; otherwise
+						 * generate one local to this module.  The cached
+						 * variant is called through a constant pointer, which
+						 * forgoes inlining into the expression, but avoids
+						 * compiling the same deformer over and over.
+						 */
+						deform_fn = llvm_get_deform_function(context, desc,
+															 tts_ops,
+															 op->d.fetch.last_var);
+						if (deform_fn)
+						{
+							LLVMTypeRef param_types[1];
+							LLVMTypeRef deform_sig;
+
+							param_types[0] = l_ptr(StructTupleTableSlot);
+							deform_sig = LLVMFunctionType(LLVMVoidType(),
+														  param_types,
+														  lengthof(param_types),
+														  false);
+							l_jit_deform =
+								l_ptr_const(deform_fn,
+											LLVMPointerType(deform_sig, 0));
+						}
+						else
+							l_jit_deform =
+								slot_compile_deform(context, desc,
+													tts_ops,
+													op->d.fetch.last_var);
 					}
 
 					if (l_jit_deform)
@@ -1995,7 +2023,7 @@ llvm_compile_expr(ExprState *state)
 					LLVMValueRef v_tmpcontext;
 					LLVMValueRef v_oldcontext;
 
-					aggstate = op->d.agg_deserialize.aggstate;
+					aggstate = castNode(AggState, state->parent);
 					fcinfo = op->d.agg_deserialize.fcinfo_data;
 
 					v_tmpcontext =
@@ -2083,155 +2111,12 @@ llvm_compile_expr(ExprState *state)
 					break;
 				}
 
-			case EEOP_AGG_INIT_TRANS:
-				{
-					AggState   *aggstate;
-					AggStatePerTrans pertrans;
-
-					LLVMValueRef v_aggstatep;
-					LLVMValueRef v_pertransp;
-
-					LLVMValueRef v_allpergroupsp;
-
-					LLVMValueRef v_pergroupp;
-
-					LLVMValueRef v_setoff,
-								v_transno;
-
-					LLVMValueRef v_notransvalue;
-
-					LLVMBasicBlockRef b_init;
-
-					aggstate = op->d.agg_init_trans.aggstate;
-					pertrans = op->d.agg_init_trans.pertrans;
-
-					v_aggstatep = l_ptr_const(aggstate,
-											  l_ptr(StructAggState));
-					v_pertransp = l_ptr_const(pertrans,
-											  l_ptr(StructAggStatePerTransData));
-
-					/*
-					 * pergroup = &aggstate->all_pergroups
-					 * [op->d.agg_init_trans_check.setoff]
-					 * [op->d.agg_init_trans_check.transno];
-					 */
-					v_allpergroupsp =
-						l_load_struct_gep(b, v_aggstatep,
-										  FIELDNO_AGGSTATE_ALL_PERGROUPS,
-										  "aggstate.all_pergroups");
-					v_setoff = l_int32_const(op->d.agg_init_trans.setoff);
-					v_transno = l_int32_const(op->d.agg_init_trans.transno);
-					v_pergroupp =
-						LLVMBuildGEP(b,
-									 l_load_gep1(b, v_allpergroupsp, v_setoff, ""),
-									 &v_transno, 1, "");
-
-					v_notransvalue =
-						l_load_struct_gep(b, v_pergroupp,
-										  FIELDNO_AGGSTATEPERGROUPDATA_NOTRANSVALUE,
-										  "notransvalue");
-
-					b_init = l_bb_before_v(opblocks[i + 1],
-										   "op.%d.inittrans", i);
-
-					LLVMBuildCondBr(b,
-									LLVMBuildICmp(b, LLVMIntEQ, v_notransvalue,
-												  l_sbool_const(1), ""),
-									b_init,
-									opblocks[i + 1]);
-
-					LLVMPositionBuilderAtEnd(b, b_init);
-
-					{
-						LLVMValueRef params[3];
-						LLVMValueRef v_curaggcontext;
-						LLVMValueRef v_current_set;
-						LLVMValueRef v_aggcontext;
-
-						v_aggcontext = l_ptr_const(op->d.agg_init_trans.aggcontext,
-												   l_ptr(StructExprContext));
-
-						v_current_set =
-							LLVMBuildStructGEP(b,
-											   v_aggstatep,
-											   FIELDNO_AGGSTATE_CURRENT_SET,
-											   "aggstate.current_set");
-						v_curaggcontext =
-							LLVMBuildStructGEP(b,
-											   v_aggstatep,
-											   FIELDNO_AGGSTATE_CURAGGCONTEXT,
-											   "aggstate.curaggcontext");
-
-						LLVMBuildStore(b, l_int32_const(op->d.agg_init_trans.setno),
-									   v_current_set);
-						LLVMBuildStore(b, v_aggcontext,
-									   v_curaggcontext);
-
-						params[0] = v_aggstatep;
-						params[1] = v_pertransp;
-						params[2] = v_pergroupp;
-
-						LLVMBuildCall(b,
-									  llvm_get_decl(mod, FuncExecAggInitGroup),
-									  params, lengthof(params),
-									  "");
-					}
-					LLVMBuildBr(b, opblocks[op->d.agg_init_trans.jumpnull]);
-
-					break;
-				}
-
-			case EEOP_AGG_STRICT_TRANS_CHECK:
-				{
-					AggState   *aggstate;
-					LLVMValueRef v_setoff,
-								v_transno;
-
-					LLVMValueRef v_aggstatep;
-					LLVMValueRef v_allpergroupsp;
-
-					LLVMValueRef v_transnull;
-					LLVMValueRef v_pergroupp;
-
-					int			jumpnull = op->d.agg_strict_trans_check.jumpnull;
-
-					aggstate = op->d.agg_strict_trans_check.aggstate;
-					v_aggstatep = l_ptr_const(aggstate, l_ptr(StructAggState));
-
-					/*
-					 * pergroup = &aggstate->all_pergroups
-					 * [op->d.agg_strict_trans_check.setoff]
-					 * [op->d.agg_init_trans_check.transno];
-					 */
-					v_allpergroupsp =
-						l_load_struct_gep(b, v_aggstatep,
-										  FIELDNO_AGGSTATE_ALL_PERGROUPS,
-										  "aggstate.all_pergroups");
-					v_setoff =
-						l_int32_const(op->d.agg_strict_trans_check.setoff);
-					v_transno =
-						l_int32_const(op->d.agg_strict_trans_check.transno);
-					v_pergroupp =
-						LLVMBuildGEP(b,
-									 l_load_gep1(b, v_allpergroupsp, v_setoff, ""),
-									 &v_transno, 1, "");
-
-					v_transnull =
-						l_load_struct_gep(b, v_pergroupp,
-										  FIELDNO_AGGSTATEPERGROUPDATA_TRANSVALUEISNULL,
-										  "transnull");
-
-					LLVMBuildCondBr(b,
-									LLVMBuildICmp(b, LLVMIntEQ, v_transnull,
-												  l_sbool_const(1), ""),
-									opblocks[jumpnull],
-									opblocks[i + 1]);
-
-					break;
-				}
-
+			case EEOP_AGG_PLAIN_TRANS_INIT_STRICT_BYVAL:
+			case EEOP_AGG_PLAIN_TRANS_STRICT_BYVAL:
 			case EEOP_AGG_PLAIN_TRANS_BYVAL:
-			case EEOP_AGG_PLAIN_TRANS:
+			case EEOP_AGG_PLAIN_TRANS_INIT_STRICT_BYREF:
+			case EEOP_AGG_PLAIN_TRANS_STRICT_BYREF:
+			case EEOP_AGG_PLAIN_TRANS_BYREF:
 				{
 					AggState   *aggstate;
 					AggStatePerTrans pertrans;
@@ -2263,7 +2148,7 @@ llvm_compile_expr(ExprState *state)
 					LLVMValueRef v_tmpcontext;
 					LLVMValueRef v_oldcontext;
 
-					aggstate = op->d.agg_trans.aggstate;
+					aggstate = castNode(AggState, state->parent);
 					pertrans = op->d.agg_trans.pertrans;
 
 					fcinfo = pertrans->transfn_fcinfo;
@@ -2275,8 +2160,8 @@ llvm_compile_expr(ExprState *state)
 
 					/*
 					 * pergroup = &aggstate->all_pergroups
-					 * [op->d.agg_strict_trans_check.setoff]
-					 * [op->d.agg_init_trans_check.transno];
+					 * [op->d.agg_trans.setoff]
+					 * [op->d.agg_trans.transno];
 					 */
 					v_allpergroupsp =
 						l_load_struct_gep(b, v_aggstatep,
@@ -2294,6 +2179,94 @@ llvm_compile_expr(ExprState *state)
 					v_aggcontext = l_ptr_const(op->d.agg_trans.aggcontext,
 											   l_ptr(StructExprContext));
 
+					if (opcode == EEOP_AGG_PLAIN_TRANS_INIT_STRICT_BYVAL ||
+						opcode == EEOP_AGG_PLAIN_TRANS_INIT_STRICT_BYREF)
+					{
+						LLVMValueRef v_notransvalue;
+						LLVMBasicBlockRef b_init;
+						LLVMBasicBlockRef b_no_init;
+
+						v_notransvalue =
+							l_load_struct_gep(b, v_pergroupp,
+											  FIELDNO_AGGSTATEPERGROUPDATA_NOTRANSVALUE,
+											  "notransvalue");
+
+						b_init = l_bb_before_v(opblocks[i + 1],
+											   "op.%d.inittrans", i);
+						b_no_init = l_bb_before_v(opblocks[i + 1],
+												  "op.%d.no_inittrans", i);
+
+						/* if transition value hasn't been initialized yet */
+						LLVMBuildCondBr(b,
+										LLVMBuildICmp(b, LLVMIntEQ, v_notransvalue,
+													  l_sbool_const(1), ""),
+										b_init,
+										b_no_init);
+
+						LLVMPositionBuilderAtEnd(b, b_init);
+
+						{
+							LLVMValueRef params[3];
+							LLVMValueRef v_curaggcontext;
+							LLVMValueRef v_current_set;
+
+							v_current_set =
+								LLVMBuildStructGEP(b,
+												   v_aggstatep,
+												   FIELDNO_AGGSTATE_CURRENT_SET,
+												   "aggstate.current_set");
+							v_curaggcontext =
+								LLVMBuildStructGEP(b,
+												   v_aggstatep,
+												   FIELDNO_AGGSTATE_CURAGGCONTEXT,
+												   "aggstate.curaggcontext");
+
+							LLVMBuildStore(b, l_int32_const(op->d.agg_trans.setno),
+										   v_current_set);
+							LLVMBuildStore(b, v_aggcontext,
+										   v_curaggcontext);
+
+							params[0] = v_aggstatep;
+							params[1] = v_pertransp;
+							params[2] = v_pergroupp;
+
+							LLVMBuildCall(b,
+										  llvm_get_decl(mod, FuncExecAggInitGroup),
+										  params, lengthof(params),
+										  "");
+						}
+
+						/* copied transition value from input, done this round */
+						LLVMBuildBr(b, opblocks[i + 1]);
+
+						LLVMPositionBuilderAtEnd(b, b_no_init);
+					}
+
+					if (opcode == EEOP_AGG_PLAIN_TRANS_INIT_STRICT_BYVAL ||
+						opcode == EEOP_AGG_PLAIN_TRANS_INIT_STRICT_BYREF ||
+						opcode == EEOP_AGG_PLAIN_TRANS_STRICT_BYVAL ||
+						opcode == EEOP_AGG_PLAIN_TRANS_STRICT_BYREF)
+					{
+						LLVMValueRef v_transnull;
+						LLVMBasicBlockRef b_strictpass;
+
+						b_strictpass = l_bb_before_v(opblocks[i + 1],
+													 "op.%d.strictpass", i);
+						v_transnull =
+							l_load_struct_gep(b, v_pergroupp,
+											  FIELDNO_AGGSTATEPERGROUPDATA_TRANSVALUEISNULL,
+											  "transnull");
+
+						/* skip transition function if transition value is NULL */
+						LLVMBuildCondBr(b,
+										LLVMBuildICmp(b, LLVMIntEQ, v_transnull,
+													  l_sbool_const(1), ""),
+										opblocks[i + 1],
+										b_strictpass);
+
+						LLVMPositionBuilderAtEnd(b, b_strictpass);
+					}
+
 					v_current_setp =
 						LLVMBuildStructGEP(b,
 										   v_aggstatep,
@@ -2352,7 +2325,9 @@ llvm_compile_expr(ExprState *state)
 					 * child of the aggcontext, assume we can adopt that value
 					 * without copying it.
 					 */
-					if (opcode == EEOP_AGG_PLAIN_TRANS)
+					if (opcode == EEOP_AGG_PLAIN_TRANS_INIT_STRICT_BYREF ||
+						opcode == EEOP_AGG_PLAIN_TRANS_STRICT_BYREF ||
+						opcode == EEOP_AGG_PLAIN_TRANS_BYREF)
 					{
 						LLVMBasicBlockRef b_call;
 						LLVMBasicBlockRef b_nocall;
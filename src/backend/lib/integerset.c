@@ -970,6 +970,36 @@ simple8b_encode(const uint64 *ints, int *num_encoded, uint64 base)
 	return codeword;
 }
 
+/*
+ * Workhorse for simple8b_decode().
+ *
+ * This is always called with compile-time constant 'bits' and 'nints'
+ * (from the switch statement in simple8b_decode), so that the extraction
+ * loop operates with fixed shift widths and a fixed trip count.  That lets
+ * the compiler unroll it, and vectorize it on targets where it can.  The
+ * extracted deltas are turned into absolute values in a second pass; that
+ * running sum is inherently serial, but it's cheap compared to the
+ * variable-width bit twiddling that the old all-in-one loop did.
+ */
+static pg_attribute_always_inline int
+simple8b_decode_impl(uint64 codeword, uint64 *decoded, uint64 base,
+					 int bits, int nints)
+{
+	uint64		mask = (UINT64CONST(1) << bits) - 1;
+	uint64		curr_value;
+
+	for (int i = 0; i < nints; i++)
+		decoded[i] = (codeword >> (i * bits)) & mask;
+
+	curr_value = base;
+	for (int i = 0; i < nints; i++)
+	{
+		curr_value += 1 + decoded[i];
+		decoded[i] = curr_value;
+	}
+	return nints;
+}
+
 /*
  * Decode a codeword into an array of integers.
  * Returns the number of integers decoded.
@@ -978,24 +1008,57 @@ static int
 simple8b_decode(uint64 codeword, uint64 *decoded, uint64 base)
 {
 	int			selector = (codeword >> 60);
-	int			nints = simple8b_modes[selector].num_ints;
-	int			bits = simple8b_modes[selector].bits_per_int;
-	uint64		mask = (UINT64CONST(1) << bits) - 1;
-	uint64		curr_value;
 
 	if (codeword == EMPTY_CODEWORD)
 		return 0;
 
-	curr_value = base;
-	for (int i = 0; i < nints; i++)
+	switch (selector)
 	{
-		uint64		diff = codeword & mask;
-
-		curr_value += 1 + diff;
-		decoded[i] = curr_value;
-		codeword >>= bits;
+		case 0:
+		case 1:
+			{
+				/*
+				 * Modes 0 and 1 encode a run of 240 or 120 consecutive
+				 * integers; there are no packed deltas to extract.
+				 */
+				int			nints = simple8b_modes[selector].num_ints;
+
+				for (int i = 0; i < nints; i++)
+					decoded[i] = base + 1 + i;
+				return nints;
+			}
+		case 2:
+			return simple8b_decode_impl(codeword, decoded, base, 1, 60);
+		case 3:
+			return simple8b_decode_impl(codeword, decoded, base, 2, 30);
+		case 4:
+			return simple8b_decode_impl(codeword, decoded, base, 3, 20);
+		case 5:
+			return simple8b_decode_impl(codeword, decoded, base, 4, 15);
+		case 6:
+			return simple8b_decode_impl(codeword, decoded, base, 5, 12);
+		case 7:
+			return simple8b_decode_impl(codeword, decoded, base, 6, 10);
+		case 8:
+			return simple8b_decode_impl(codeword, decoded, base, 7, 8);
+		case 9:
+			return simple8b_decode_impl(codeword, decoded, base, 8, 7);
+		case 10:
+			return simple8b_decode_impl(codeword, decoded, base, 10, 6);
+		case 11:
+			return simple8b_decode_impl(codeword, decoded, base, 12, 5);
+		case 12:
+			return simple8b_decode_impl(codeword, decoded, base, 15, 4);
+		case 13:
+			return simple8b_decode_impl(codeword, decoded, base, 20, 3);
+		case 14:
+			return simple8b_decode_impl(codeword, decoded, base, 30, 2);
+		case 15:
+			return simple8b_decode_impl(codeword, decoded, base, 60, 1);
+		default:
+			pg_unreachable();
+			return 0;
 	}
-	return nints;
 }
 
 /*
@@ -221,9 +221,21 @@ struct TBMSharedIterator
 	PTEntryArray *ptbase;		/* pagetable element array */
 	PTIterationArray *ptpages;	/* sorted exact page index list */
 	PTIterationArray *ptchunks; /* sorted lossy page index list */
+	int			batchpos;		/* next claimed-but-unconsumed ptpages pos */
+	int			batchend;		/* end of the claimed run */
 	TBMIterateResult output;	/* MUST BE LAST (because variable-size) */
 };
 
+/*
+ * Number of exact pages a process claims from a shared iterator in one go.
+ * Claiming a run at a time keeps the iterator lock off the per-page path
+ * and lets each process visit consecutive blocks, which reads far more
+ * sequentially than interleaving single pages among all processes.  Runs
+ * are capped so that the tail end of the bitmap still spreads across
+ * processes evenly.
+ */
+#define TBM_SHARED_BATCH_SIZE	16
+
 /* Local function prototypes */
 static void tbm_union_page(TIDBitmap *a, const PagetableEntry *bpage);
 static bool tbm_intersect_page(TIDBitmap *a, PagetableEntry *apage,
@@ -1046,6 +1058,11 @@ tbm_iterate(TBMIterator *iterator)
  *	As above, but this will iterate using an iterator which is shared
  *	across multiple processes.  We need to acquire the iterator LWLock,
  *	before accessing the shared members.
+ *
+ *	To keep the lock out of the per-page path, exact pages are claimed
+ *	from the shared state in runs of up to TBM_SHARED_BATCH_SIZE and then
+ *	consumed locally.  Each process therefore sees its pages in increasing
+ *	block order, but no ordering holds across processes.
  */
 TBMIterateResult *
 tbm_shared_iterate(TBMSharedIterator *iterator)
@@ -1063,6 +1080,25 @@ tbm_shared_iterate(TBMSharedIterator *iterator)
 	if (iterator->ptchunks != NULL)
 		idxchunks = iterator->ptchunks->index;
 
+	/*
+	 * If we are still holding exact pages claimed by a previous call,
+	 * consume the next one without touching the shared state at all.
+	 */
+	if (iterator->batchpos < iterator->batchend)
+	{
+		PagetableEntry *page = &ptbase[idxpages[iterator->batchpos]];
+		int			ntuples;
+
+		/* scan bitmap to extract individual offset numbers */
+		ntuples = tbm_extract_page_tuple(page, output);
+		output->blockno = page->blockno;
+		output->ntuples = ntuples;
+		output->recheck = page->recheck;
+		iterator->batchpos++;
+
+		return output;
+	}
+
 	/* Acquire the LWLock before accessing the shared members */
 	LWLockAcquire(&istate->lock, LW_EXCLUSIVE);
 
@@ -1113,17 +1149,44 @@ tbm_shared_iterate(TBMSharedIterator *iterator)
 
 	if (istate->spageptr < istate->npages)
 	{
-		PagetableEntry *page = &ptbase[idxpages[istate->spageptr]];
+		int			pos = istate->spageptr;
+		int			nclaim = 1;
+		PagetableEntry *page = &ptbase[idxpages[pos]];
 		int			ntuples;
 
+		/*
+		 * Claim a whole run of consecutive exact pages, so that subsequent
+		 * calls can be satisfied without the lock and this process visits
+		 * neighboring blocks.  The run must not extend past the next lossy
+		 * chunk page: that page has to be emitted before any exact pages
+		 * numerically beyond it.
+		 */
+		if (istate->schunkptr < istate->nchunks)
+		{
+			PagetableEntry *chunk = &ptbase[idxchunks[istate->schunkptr]];
+			BlockNumber chunk_blockno = chunk->blockno + istate->schunkbit;
+
+			while (nclaim < TBM_SHARED_BATCH_SIZE &&
+				   pos + nclaim < istate->npages &&
+				   ptbase[idxpages[pos + nclaim]].blockno < chunk_blockno)
+				nclaim++;
+		}
+		else
+			nclaim = Min(TBM_SHARED_BATCH_SIZE, istate->npages - pos);
+
+		istate->spageptr += nclaim;
+
+		LWLockRelease(&istate->lock);
+
+		/* the first claimed page is returned now, the rest later */
+		iterator->batchpos = pos + 1;
+		iterator->batchend = pos + nclaim;
+
 		/* scan bitmap to extract individual offset numbers */
 		ntuples = tbm_extract_page_tuple(page, output);
 		output->blockno = page->blockno;
 		output->ntuples = ntuples;
 		output->recheck = page->recheck;
-		istate->spageptr++;
-
-		LWLockRelease(&istate->lock);
 
 		return output;
 	}
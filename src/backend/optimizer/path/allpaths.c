@@ -61,6 +61,7 @@ typedef struct pushdown_safety_info
 /* These parameters are set by GUC */
 bool		enable_geqo = false;	/* just in case GUC doesn't set it */
 int			geqo_threshold;
+int			join_search_budget = 0; /* 0 disables budgeted join search */
 int			min_parallel_table_scan_size;
 int			min_parallel_index_scan_size;
 
@@ -125,6 +126,12 @@ static void set_result_pathlist(PlannerInfo *root, RelOptInfo *rel,
 static void set_worktable_pathlist(PlannerInfo *root, RelOptInfo *rel,
 								   RangeTblEntry *rte);
 static RelOptInfo *make_rel_from_joinlist(PlannerInfo *root, List *joinlist);
+static RelOptInfo *budgeted_join_search(PlannerInfo *root, int levels_needed,
+										List *initial_rels);
+static RelOptInfo *budgeted_join_search_pass(PlannerInfo *root,
+											 int levels_needed,
+											 List *initial_rels);
+static int	joinrel_cost_compare(const ListCell *a, const ListCell *b);
 static bool subquery_is_pushdown_safe(Query *subquery, Query *topquery,
 									  pushdown_safety_info *safetyInfo);
 static bool recurse_pushdown_safe(Node *setOp, Query *topquery,
@@ -2803,6 +2810,8 @@ make_rel_from_joinlist(PlannerInfo *root, List *joinlist)
 
 		if (join_search_hook)
 			return (*join_search_hook) (root, levels_needed, initial_rels);
+		else if (join_search_budget > 0 && levels_needed >= geqo_threshold)
+			return budgeted_join_search(root, levels_needed, initial_rels);
 		else if (enable_geqo && levels_needed >= geqo_threshold)
 			return geqo(root, levels_needed, initial_rels);
 		else
@@ -2924,6 +2933,189 @@ standard_join_search(PlannerInfo *root, int levels_needed, List *initial_rels)
 	return rel;
 }
 
+/*
+ * budgeted_join_search
+ *	  Bounded-effort, deterministic alternative to GEQO for large join
+ *	  problems; used when join_search_budget > 0.
+ *
+ * This runs the same bottom-up dynamic program as standard_join_search(),
+ * but after finishing each join level keeps only the join_search_budget
+ * cheapest joinrels for the higher levels to extend ("beam search").  That
+ * caps the number of joinrels considered at roughly budget * levels_needed
+ * * levels_needed, making planning time predictable, and unlike GEQO the
+ * same query always produces the same plan.  The price is that we can miss
+ * plans whose cheap endgame depends on a subjoin that looked expensive in
+ * isolation.
+ *
+ * Pruning can also paint us into a corner: every surviving joinrel of some
+ * level might be impossible to join further (e.g. for lack of join clauses
+ * combined with outer-join ordering constraints), even though the full
+ * search would have succeeded.  If that happens, we throw away the pruned
+ * pass's joinrels, using the same state save/restore trick as geqo_eval(),
+ * and redo the search with standard_join_search().
+ */
+static RelOptInfo *
+budgeted_join_search(PlannerInfo *root, int levels_needed, List *initial_rels)
+{
+	RelOptInfo *rel;
+	int			savelength;
+	struct HTAB *savehash;
+
+	Assert(join_search_budget > 0);
+
+	/*
+	 * Save join_rel_list state so that a failed pruned pass can be
+	 * discarded.  As in geqo_eval(), hide any pre-existing hashtable so the
+	 * pass's new joinrels only reach data structures we can undo.  (On
+	 * success we just keep whatever state the pass built, as
+	 * standard_join_search() would.)
+	 */
+	savelength = list_length(root->join_rel_list);
+	savehash = root->join_rel_hash;
+	root->join_rel_hash = NULL;
+
+	rel = budgeted_join_search_pass(root, levels_needed, initial_rels);
+
+	if (rel == NULL)
+	{
+		/*
+		 * Dead end: restore the saved state and plan the old, exhaustive
+		 * way.  The discarded joinrels' memory is not reclaimed until end of
+		 * planning, but this case should be rare.
+		 */
+		root->join_rel_list = list_truncate(root->join_rel_list, savelength);
+		root->join_rel_hash = savehash;
+
+		rel = standard_join_search(root, levels_needed, initial_rels);
+	}
+
+	return rel;
+}
+
+/*
+ * budgeted_join_search_pass
+ *	  One beam-pruned pass of the dynamic-programming join search.
+ *
+ * Returns NULL (with root->join_rel_level reset) if pruning made some join
+ * level unreachable; the caller is responsible for retrying without a
+ * budget.
+ */
+static RelOptInfo *
+budgeted_join_search_pass(PlannerInfo *root, int levels_needed,
+						  List *initial_rels)
+{
+	int			lev;
+	RelOptInfo *rel;
+	bool		pruned = false;
+
+	/* see standard_join_search */
+	Assert(root->join_rel_level == NULL);
+
+	root->join_rel_level = (List **) palloc0((levels_needed + 1) * sizeof(List *));
+
+	root->join_rel_level[1] = initial_rels;
+
+	for (lev = 2; lev <= levels_needed; lev++)
+	{
+		ListCell   *lc;
+
+		/*
+		 * Determine all possible pairs of relations to be joined at this
+		 * level, and build paths for making each one from every available
+		 * pair of lower-level relations.
+		 */
+		join_search_one_level(root, lev);
+
+		/*
+		 * An empty level is legitimate when only bushy plans are possible
+		 * (higher levels can still join two lower-level joinrels), but once
+		 * we have pruned we cannot tell that apart from having discarded
+		 * the only viable building blocks, so treat it as a dead end.
+		 */
+		if (root->join_rel_level[lev] == NIL && pruned)
+		{
+			root->join_rel_level = NULL;
+			return NULL;
+		}
+
+		/*
+		 * Post-process and cost the new joinrels, exactly as in
+		 * standard_join_search().
+		 */
+		foreach(lc, root->join_rel_level[lev])
+		{
+			rel = (RelOptInfo *) lfirst(lc);
+
+			/* Create paths for partitionwise joins. */
+			generate_partitionwise_join_paths(root, rel);
+
+			/*
+			 * Except for the topmost scan/join rel, consider gathering
+			 * partial paths.  We'll do the same for the topmost scan/join rel
+			 * once we know the final targetlist (see grouping_planner).
+			 */
+			if (lev < levels_needed)
+				generate_gather_paths(root, rel, false);
+
+			/* Find and save the cheapest paths for this rel */
+			set_cheapest(rel);
+
+#ifdef OPTIMIZER_DEBUG
+			debug_print_rel(root, rel);
+#endif
+		}
+
+		/*
+		 * Apply the budget: keep only the cheapest joinrels of this level
+		 * for the upper levels to build on.  The level-1 list is never
+		 * pruned (removing a base rel would make the query unplannable),
+		 * and pruning the final level would be pointless.
+		 */
+		if (lev < levels_needed &&
+			list_length(root->join_rel_level[lev]) > join_search_budget)
+		{
+			list_sort(root->join_rel_level[lev], joinrel_cost_compare);
+			root->join_rel_level[lev] =
+				list_truncate(root->join_rel_level[lev], join_search_budget);
+			pruned = true;
+		}
+	}
+
+	/*
+	 * We should have a single rel at the final level.
+	 */
+	if (root->join_rel_level[levels_needed] == NIL)
+	{
+		root->join_rel_level = NULL;
+		return NULL;
+	}
+	Assert(list_length(root->join_rel_level[levels_needed]) == 1);
+
+	rel = (RelOptInfo *) linitial(root->join_rel_level[levels_needed]);
+
+	root->join_rel_level = NULL;
+
+	return rel;
+}
+
+/*
+ * list_sort comparator to order joinrels by cheapest total cost
+ */
+static int
+joinrel_cost_compare(const ListCell *a, const ListCell *b)
+{
+	const RelOptInfo *rel1 = (const RelOptInfo *) lfirst(a);
+	const RelOptInfo *rel2 = (const RelOptInfo *) lfirst(b);
+
+	if (rel1->cheapest_total_path->total_cost <
+		rel2->cheapest_total_path->total_cost)
+		return -1;
+	if (rel1->cheapest_total_path->total_cost >
+		rel2->cheapest_total_path->total_cost)
+		return 1;
+	return 0;
+}
+
 /*****************************************************************************
  *			PUSHING QUALS DOWN INTO SUBQUERIES
  *****************************************************************************/
@@ -1658,6 +1658,25 @@ consider_parallel_nestloop(PlannerInfo *root,
 
 			try_partial_nestloop_path(root, joinrel, outerpath, innerpath,
 									  pathkeys, jointype, extra);
+
+			/*
+			 * Also consider materializing the inner path into a shared
+			 * tuplestore that is built once and then scanned by every
+			 * worker, rather than having each worker run the inner subtree
+			 * for itself.  Only unparameterized inner paths qualify, since
+			 * the shared result cannot depend on values from the outer side.
+			 */
+			if (enable_material && save_jointype != JOIN_UNIQUE_INNER &&
+				innerpath->param_info == NULL &&
+				!ExecMaterializesOutput(innerpath->pathtype))
+			{
+				Path	   *matpath = (Path *)
+					create_material_path(innerrel, innerpath);
+
+				matpath->parallel_aware = true;
+				try_partial_nestloop_path(root, joinrel, outerpath, matpath,
+										  pathkeys, jointype, extra);
+			}
 		}
 	}
 }
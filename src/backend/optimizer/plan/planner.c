@@ -4595,6 +4595,57 @@ create_window_paths(PlannerInfo *root,
 								   activeWindows);
 	}
 
+	/*
+	 * Also consider sorting the cheapest partial path in the workers and
+	 * feeding the bottommost WindowAgg from an order-preserving Gather
+	 * Merge.  The window functions themselves still run serially, but the
+	 * sort is usually the dominant cost below them, and that way it scales
+	 * with the number of workers.  (If a partial path is already suitably
+	 * sorted, generate_gather_paths() has created a Gather Merge path on it
+	 * already, and the loop above has considered the result.)
+	 */
+	if (window_rel->consider_parallel && root->window_pathkeys != NIL &&
+		input_rel->partial_pathlist != NIL)
+	{
+		Path	   *cheapest_partial_path;
+
+		cheapest_partial_path = linitial(input_rel->partial_pathlist);
+
+		/*
+		 * If cheapest partial path doesn't need a sort, this is redundant
+		 * with what's already been tried.
+		 */
+		if (!pathkeys_contained_in(root->window_pathkeys,
+								   cheapest_partial_path->pathkeys))
+		{
+			Path	   *path;
+			double		total_groups;
+
+			path = (Path *) create_sort_path(root,
+											 window_rel,
+											 cheapest_partial_path,
+											 root->window_pathkeys,
+											 -1.0);
+
+			total_groups = cheapest_partial_path->rows *
+				cheapest_partial_path->parallel_workers;
+			path = (Path *)
+				create_gather_merge_path(root, window_rel,
+										 path,
+										 path->pathtarget,
+										 root->window_pathkeys, NULL,
+										 &total_groups);
+
+			create_one_window_path(root,
+								   window_rel,
+								   path,
+								   input_target,
+								   output_target,
+								   wflists,
+								   activeWindows);
+		}
+	}
+
 	/*
 	 * If there is an FDW that's responsible for all baserels of the query,
 	 * let it consider adding ForeignPaths.
@@ -4924,8 +4975,9 @@ create_distinct_paths(PlannerInfo *root,
  * Build a new upperrel containing Paths for ORDER BY evaluation.
  *
  * All paths in the result must satisfy the ORDER BY ordering.
- * The only new path we need consider is an explicit sort on the
- * cheapest-total existing path.
+ * The new paths we need consider are an explicit sort on the
+ * cheapest-total existing path, plus incremental sorts on any paths
+ * that are already sorted on a useful prefix of the required ordering.
  *
  * input_rel: contains the source-data Paths
  * target: the output tlist the result Paths must emit
@@ -4964,13 +5016,17 @@ create_ordered_paths(PlannerInfo *root,
 
 	foreach(lc, input_rel->pathlist)
 	{
-		Path	   *path = (Path *) lfirst(lc);
+		Path	   *input_path = (Path *) lfirst(lc);
+		Path	   *path;
 		bool		is_sorted;
+		int			presorted_keys;
 
-		is_sorted = pathkeys_contained_in(root->sort_pathkeys,
-										  path->pathkeys);
-		if (path == cheapest_input_path || is_sorted)
+		is_sorted = pathkeys_count_contained_in(root->sort_pathkeys,
+												input_path->pathkeys,
+												&presorted_keys);
+		if (input_path == cheapest_input_path || is_sorted)
 		{
+			path = input_path;
 			if (!is_sorted)
 			{
 				/* An explicit sort here can take advantage of LIMIT */
@@ -4988,6 +5044,29 @@ create_ordered_paths(PlannerInfo *root,
 
 			add_path(ordered_rel, path);
 		}
+
+		/*
+		 * If the input path is already sorted on a prefix of the required
+		 * pathkeys, an incremental sort may beat a full sort: it sorts one
+		 * prefix group at a time, and under a LIMIT it need not even read
+		 * the whole input.
+		 */
+		if (enable_incrementalsort && !is_sorted && presorted_keys > 0)
+		{
+			path = (Path *) create_incremental_sort_path(root,
+														 ordered_rel,
+														 input_path,
+														 root->sort_pathkeys,
+														 presorted_keys,
+														 limit_tuples);
+
+			/* Add projection step if needed */
+			if (path->pathtarget != target)
+				path = apply_projection_to_path(root, ordered_rel,
+												path, target);
+
+			add_path(ordered_rel, path);
+		}
 	}
 
 	/*
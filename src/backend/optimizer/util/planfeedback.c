@@ -0,0 +1,228 @@
+/*-------------------------------------------------------------------------
+ *
+ * planfeedback.c
+ *	  Runtime cardinality feedback for the planner.
+ *
+ * When plan_cache_feedback is enabled, executions are instrumented with
+ * row counts, and at executor shutdown we compare each scan node's actual
+ * row count against the planner's estimate.  The resulting correction
+ * factors are remembered in a backend-local cache keyed by relation OID
+ * and a hash of the applied quals, and set_baserel_size_estimates()
+ * multiplies them back into its row estimates, so that replanning of the
+ * same (cached or repeated) query converges towards observed
+ * cardinalities even where the statistics-based estimates are badly off,
+ * e.g. for correlated predicates.
+ *
+ * The cache is backend-local on purpose: plan caches are backend-local
+ * too, so the feedback reaches exactly the replanning events that can
+ * benefit, without shared-memory sizing or locking concerns.
+ *
+ * Only plain relation SeqScan nodes feed the cache; their qual list is
+ * exactly the relation's baserestrictinfo clauses, so the observed output
+ * directly corresponds to what set_baserel_size_estimates() computes.
+ * Matching planner clauses against executor quals relies on a stable
+ * nodeToString() representation, which holds for unflattened top-level
+ * range tables; quals that fail to match simply get no correction.
+ *
+ * Caveat: actual row counts from queries that stopped early (e.g. under
+ * LIMIT) understate reality.  Corrections are multiplicatively composed
+ * and clamped, so a bad sample is overwritten as soon as a complete
+ * execution is seen.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/optimizer/util/planfeedback.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "executor/executor.h"
+#include "executor/instrument.h"
+#include "nodes/nodeFuncs.h"
+#include "optimizer/planfeedback.h"
+#include "parser/parsetree.h"
+#include "utils/hsearch.h"
+#include "utils/memutils.h"
+
+/* GUC parameter */
+bool		plan_cache_feedback = false;
+
+/* Bounds for a stored correction factor */
+#define PLAN_FEEDBACK_MIN_CORRECTION	0.001
+#define PLAN_FEEDBACK_MAX_CORRECTION	1000.0
+
+typedef struct PlanFeedbackKey
+{
+	Oid			relid;			/* table being scanned */
+	uint32		qualhash;		/* hash of the applied qual clauses */
+} PlanFeedbackKey;
+
+typedef struct PlanFeedbackEntry
+{
+	PlanFeedbackKey key;		/* hash key; must be first */
+	double		correction;		/* multiplier for the row estimate */
+} PlanFeedbackEntry;
+
+static HTAB *PlanFeedbackHash = NULL;
+
+static uint32 plan_feedback_qual_hash(List *quals);
+static bool plan_feedback_walker(PlanState *planstate, void *context);
+
+
+/*
+ * Compute an order-independent hash of a list of qual clauses.  The input
+ * may be bare expressions (executor quals) or RestrictInfos (planner
+ * clauses); both hash to the same value for the same clause.
+ */
+static uint32
+plan_feedback_qual_hash(List *quals)
+{
+	uint32		result = 0;
+	ListCell   *lc;
+
+	foreach(lc, quals)
+	{
+		Node	   *clause = (Node *) lfirst(lc);
+		char	   *str;
+
+		if (IsA(clause, RestrictInfo))
+			clause = (Node *) ((RestrictInfo *) clause)->clause;
+
+		/*
+		 * Executor quals have had their opfuncids filled in by setrefs.c;
+		 * make sure planner clauses match.  (fix_opfuncids just fills in
+		 * derivable cache fields, so mutating in place is OK.)
+		 */
+		fix_opfuncids(clause);
+
+		str = nodeToString(clause);
+		result ^= DatumGetUInt32(hash_any((const unsigned char *) str,
+										  strlen(str)));
+		pfree(str);
+	}
+
+	return result;
+}
+
+/*
+ * plan_feedback_correction
+ *		Return the remembered row-estimate correction factor for the given
+ *		base relation with its current baserestrictinfo list, or 1.0 if we
+ *		have no applicable feedback.
+ */
+double
+plan_feedback_correction(PlannerInfo *root, RelOptInfo *rel)
+{
+	RangeTblEntry *rte;
+	PlanFeedbackKey key;
+	PlanFeedbackEntry *ent;
+
+	if (!plan_cache_feedback || PlanFeedbackHash == NULL)
+		return 1.0;
+
+	/* without quals the estimate is just rel->tuples; nothing to correct */
+	if (rel->baserestrictinfo == NIL)
+		return 1.0;
+
+	rte = planner_rt_fetch(rel->relid, root);
+	if (rte->rtekind != RTE_RELATION)
+		return 1.0;
+
+	key.relid = rte->relid;
+	key.qualhash = plan_feedback_qual_hash(rel->baserestrictinfo);
+
+	ent = (PlanFeedbackEntry *) hash_search(PlanFeedbackHash, &key,
+											HASH_FIND, NULL);
+
+	return ent ? ent->correction : 1.0;
+}
+
+/*
+ * Per-node worker for plan_feedback_record().
+ */
+static bool
+plan_feedback_walker(PlanState *planstate, void *context)
+{
+	PlannedStmt *pstmt = (PlannedStmt *) context;
+
+	if (IsA(planstate, SeqScanState) && planstate->instrument != NULL)
+	{
+		SeqScan    *plan = (SeqScan *) planstate->plan;
+		RangeTblEntry *rte = rt_fetch(plan->scanrelid, pstmt->rtable);
+
+		if (rte->rtekind == RTE_RELATION && plan->plan.qual != NIL)
+		{
+			Instrumentation *instr = planstate->instrument;
+
+			/* count any unfinished loop, then read the totals */
+			InstrEndLoop(instr);
+
+			if (instr->nloops > 0 && plan->plan.plan_rows > 0)
+			{
+				double		actual = instr->ntuples / instr->nloops;
+				double		ratio = actual / plan->plan.plan_rows;
+				PlanFeedbackKey key;
+				PlanFeedbackEntry *ent;
+				bool		found;
+
+				if (PlanFeedbackHash == NULL)
+				{
+					HASHCTL		ctl;
+
+					memset(&ctl, 0, sizeof(ctl));
+					ctl.keysize = sizeof(PlanFeedbackKey);
+					ctl.entrysize = sizeof(PlanFeedbackEntry);
+					ctl.hcxt = TopMemoryContext;
+					PlanFeedbackHash = hash_create("Plan feedback cache",
+												   64,
+												   &ctl,
+												   HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+				}
+
+				key.relid = rte->relid;
+				key.qualhash = plan_feedback_qual_hash(plan->plan.qual);
+
+				ent = (PlanFeedbackEntry *) hash_search(PlanFeedbackHash,
+														&key,
+														HASH_ENTER, &found);
+
+				/*
+				 * The estimate we just compared against already contained
+				 * any previously stored correction, so compose rather than
+				 * replace; the fixed point is estimate == actual.
+				 */
+				if (found)
+					ent->correction *= ratio;
+				else
+					ent->correction = ratio;
+
+				if (ent->correction < PLAN_FEEDBACK_MIN_CORRECTION)
+					ent->correction = PLAN_FEEDBACK_MIN_CORRECTION;
+				if (ent->correction > PLAN_FEEDBACK_MAX_CORRECTION)
+					ent->correction = PLAN_FEEDBACK_MAX_CORRECTION;
+			}
+		}
+	}
+
+	return planstate_tree_walker(planstate, plan_feedback_walker, context);
+}
+
+/*
+ * plan_feedback_record
+ *		Harvest actual-versus-estimated row counts from a finished plan
+ *		tree.  Called from standard_ExecutorEnd() when feedback is enabled.
+ */
+void
+plan_feedback_record(QueryDesc *queryDesc)
+{
+	if (!plan_cache_feedback ||
+		queryDesc->planstate == NULL ||
+		!(queryDesc->instrument_options & INSTRUMENT_ROWS))
+		return;
+
+	plan_feedback_walker(queryDesc->planstate, queryDesc->plannedstmt);
+}
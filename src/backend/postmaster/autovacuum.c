@@ -184,6 +184,14 @@ typedef struct av_relation
 								 * reloptions, or NULL if none */
 } av_relation;
 
+/* struct to remember a candidate table and its scheduling priority */
+typedef struct av_candidate
+{
+	Oid			av_relid;
+	double		av_priority;	/* from relation_needs_vacanalyze */
+	BlockNumber av_relpages;	/* pg_class.relpages, for tiebreaks */
+} av_candidate;
+
 /* struct to keep track of tables to vacuum and/or analyze, after rechecking */
 typedef struct autovac_table
 {
@@ -228,6 +236,8 @@ typedef struct WorkerInfoData
 	double		wi_cost_delay;
 	int			wi_cost_limit;
 	int			wi_cost_limit_base;
+	int			wi_io_read_limit;
+	int			wi_io_write_limit;
 } WorkerInfoData;
 
 typedef struct WorkerInfoData *WorkerInfo;
@@ -329,7 +339,9 @@ static void relation_needs_vacanalyze(Oid relid, AutoVacOpts *relopts,
 									  Form_pg_class classForm,
 									  PgStat_StatTabEntry *tabentry,
 									  int effective_multixact_freeze_max_age,
-									  bool *dovacuum, bool *doanalyze, bool *wraparound);
+									  bool *dovacuum, bool *doanalyze, bool *wraparound,
+									  double *priority);
+static int	av_candidate_compare(const ListCell *a, const ListCell *b);
 
 static void autovacuum_do_vac_analyze(autovac_table *tab,
 									  BufferAccessStrategy bstrategy);
@@ -1738,6 +1750,8 @@ FreeWorkerInfo(int code, Datum arg)
 		MyWorkerInfo->wi_cost_delay = 0;
 		MyWorkerInfo->wi_cost_limit = 0;
 		MyWorkerInfo->wi_cost_limit_base = 0;
+		MyWorkerInfo->wi_io_read_limit = 0;
+		MyWorkerInfo->wi_io_write_limit = 0;
 		dlist_push_head(&AutoVacuumShmem->av_freeWorkers,
 						&MyWorkerInfo->wi_links);
 		/* not mine anymore */
@@ -1763,6 +1777,8 @@ AutoVacuumUpdateDelay(void)
 	{
 		VacuumCostDelay = MyWorkerInfo->wi_cost_delay;
 		VacuumCostLimit = MyWorkerInfo->wi_cost_limit;
+		VacuumIOReadLimit = MyWorkerInfo->wi_io_read_limit;
+		VacuumIOWriteLimit = MyWorkerInfo->wi_io_write_limit;
 	}
 }
 
@@ -1791,6 +1807,40 @@ autovac_balance_cost(void)
 	double		cost_avail;
 	dlist_iter	iter;
 
+	/*
+	 * The MB/s I/O budgets are simpler to ration than the cost-based
+	 * parameters: the configured limits are a cluster-wide budget, which we
+	 * split evenly among all active workers so that vacuum as a whole never
+	 * consumes more than the given headroom no matter how many workers are
+	 * running.  Each worker's share is at least 1 MB/s, else progress could
+	 * stall entirely.
+	 */
+	if (VacuumIOReadLimit > 0 || VacuumIOWriteLimit > 0)
+	{
+		int			nworkers = 0;
+
+		dlist_foreach(iter, &AutoVacuumShmem->av_runningWorkers)
+		{
+			WorkerInfo	worker = dlist_container(WorkerInfoData, wi_links, iter.cur);
+
+			if (worker->wi_proc != NULL)
+				nworkers++;
+		}
+
+		dlist_foreach(iter, &AutoVacuumShmem->av_runningWorkers)
+		{
+			WorkerInfo	worker = dlist_container(WorkerInfoData, wi_links, iter.cur);
+
+			if (worker->wi_proc != NULL)
+			{
+				worker->wi_io_read_limit = (VacuumIOReadLimit > 0) ?
+					Max(VacuumIOReadLimit / nworkers, 1) : 0;
+				worker->wi_io_write_limit = (VacuumIOWriteLimit > 0) ?
+					Max(VacuumIOWriteLimit / nworkers, 1) : 0;
+			}
+		}
+	}
+
 	/* not set? nothing to do */
 	if (vac_cost_limit <= 0 || vac_cost_delay <= 0)
 		return;
@@ -1920,6 +1970,28 @@ get_database_list(void)
 	return dblist;
 }
 
+/*
+ * list_sort comparator to order candidate tables by decreasing priority;
+ * ties go to the smaller table, so that quick vacuums of small hot tables
+ * are never stuck behind long-running vacuums of large ones.
+ */
+static int
+av_candidate_compare(const ListCell *a, const ListCell *b)
+{
+	const av_candidate *ca = (const av_candidate *) lfirst(a);
+	const av_candidate *cb = (const av_candidate *) lfirst(b);
+
+	if (ca->av_priority > cb->av_priority)
+		return -1;
+	if (ca->av_priority < cb->av_priority)
+		return 1;
+	if (ca->av_relpages < cb->av_relpages)
+		return -1;
+	if (ca->av_relpages > cb->av_relpages)
+		return 1;
+	return 0;
+}
+
 /*
  * Process a database table-by-table
  *
@@ -1933,6 +2005,7 @@ do_autovacuum(void)
 	HeapTuple	tuple;
 	TableScanDesc relScan;
 	Form_pg_database dbForm;
+	List	   *candidates = NIL;
 	List	   *table_oids = NIL;
 	List	   *orphan_oids = NIL;
 	HASHCTL		ctl;
@@ -2058,6 +2131,7 @@ do_autovacuum(void)
 		bool		dovacuum;
 		bool		doanalyze;
 		bool		wraparound;
+		double		priority;
 
 		if (classForm->relkind != RELKIND_RELATION &&
 			classForm->relkind != RELKIND_MATVIEW)
@@ -2097,11 +2171,19 @@ do_autovacuum(void)
 		/* Check if it needs vacuum or analyze */
 		relation_needs_vacanalyze(relid, relopts, classForm, tabentry,
 								  effective_multixact_freeze_max_age,
-								  &dovacuum, &doanalyze, &wraparound);
+								  &dovacuum, &doanalyze, &wraparound,
+								  &priority);
 
-		/* Relations that need work are added to table_oids */
+		/* Relations that need work are added to the candidate list */
 		if (dovacuum || doanalyze)
-			table_oids = lappend_oid(table_oids, relid);
+		{
+			av_candidate *cand = palloc(sizeof(av_candidate));
+
+			cand->av_relid = relid;
+			cand->av_priority = priority;
+			cand->av_relpages = classForm->relpages;
+			candidates = lappend(candidates, cand);
+		}
 
 		/*
 		 * Remember TOAST associations for the second pass.  Note: we must do
@@ -2150,6 +2232,7 @@ do_autovacuum(void)
 		bool		dovacuum;
 		bool		doanalyze;
 		bool		wraparound;
+		double		priority;
 
 		/*
 		 * We cannot safely process other backends' temp tables, so skip 'em.
@@ -2180,16 +2263,38 @@ do_autovacuum(void)
 
 		relation_needs_vacanalyze(relid, relopts, classForm, tabentry,
 								  effective_multixact_freeze_max_age,
-								  &dovacuum, &doanalyze, &wraparound);
+								  &dovacuum, &doanalyze, &wraparound,
+								  &priority);
 
 		/* ignore analyze for toast tables */
 		if (dovacuum)
-			table_oids = lappend_oid(table_oids, relid);
+		{
+			av_candidate *cand = palloc(sizeof(av_candidate));
+
+			cand->av_relid = relid;
+			cand->av_priority = priority;
+			cand->av_relpages = classForm->relpages;
+			candidates = lappend(candidates, cand);
+		}
 	}
 
 	table_endscan(relScan);
 	table_close(classRel, AccessShareLock);
 
+	/*
+	 * Order the candidates by decreasing urgency rather than by the
+	 * accidental pg_class scan order, so that tables close to wraparound or
+	 * badly bloated get a worker first and small hot tables don't queue
+	 * behind huge cold ones.  Concurrent workers skip tables that another
+	 * worker has already claimed, so all workers sharing one ordering is
+	 * fine.
+	 */
+	list_sort(candidates, av_candidate_compare);
+	foreach(cell, candidates)
+		table_oids = lappend_oid(table_oids,
+								 ((av_candidate *) lfirst(cell))->av_relid);
+	list_free_deep(candidates);
+
 	/*
 	 * Recheck orphan temporary tables, and if they still seem orphaned, drop
 	 * them.  We'll eat a transaction per dropped table, which might seem
@@ -2304,6 +2409,8 @@ do_autovacuum(void)
 		bool		skipit;
 		double		stdVacuumCostDelay;
 		int			stdVacuumCostLimit;
+		int			stdVacuumIOReadLimit;
+		int			stdVacuumIOWriteLimit;
 		dlist_iter	iter;
 
 		CHECK_FOR_INTERRUPTS();
@@ -2417,6 +2524,8 @@ do_autovacuum(void)
 		 */
 		stdVacuumCostDelay = VacuumCostDelay;
 		stdVacuumCostLimit = VacuumCostLimit;
+		stdVacuumIOReadLimit = VacuumIOReadLimit;
+		stdVacuumIOWriteLimit = VacuumIOWriteLimit;
 
 		/* Must hold AutovacuumLock while mucking with cost balance info */
 		LWLockAcquire(AutovacuumLock, LW_EXCLUSIVE);
@@ -2532,6 +2641,8 @@ deleted:
 		/* restore vacuum cost GUCs for the next iteration */
 		VacuumCostDelay = stdVacuumCostDelay;
 		VacuumCostLimit = stdVacuumCostLimit;
+		VacuumIOReadLimit = stdVacuumIOReadLimit;
+		VacuumIOWriteLimit = stdVacuumIOWriteLimit;
 	}
 
 	/*
@@ -2817,7 +2928,7 @@ table_recheck_autovac(Oid relid, HTAB *table_toast_map,
 
 	relation_needs_vacanalyze(relid, avopts, classForm, tabentry,
 							  effective_multixact_freeze_max_age,
-							  &dovacuum, &doanalyze, &wraparound);
+							  &dovacuum, &doanalyze, &wraparound, NULL);
 
 	/* ignore ANALYZE for toast tables */
 	if (classForm->relkind == RELKIND_TOASTVALUE)
@@ -2950,6 +3061,13 @@ table_recheck_autovac(Oid relid, HTAB *table_toast_map,
  * autovacuum_vacuum_threshold GUC variable.  Similarly, a vac_scale_factor
  * value < 0 is substituted with the value of
  * autovacuum_vacuum_scale_factor GUC variable.  Ditto for analyze.
+ *
+ * If priority isn't NULL, we additionally report a scheduling priority for
+ * the table: the larger the value, the more urgently it needs attention.
+ * Proximity to the relfrozenxid/relminmxid force limits dominates (a table
+ * at its limit scores 10), while how far the dead-tuple or analyze counters
+ * exceed their thresholds contributes a score capped at 5, so anti-wraparound
+ * work always sorts ahead of mere bloat.
  */
 static void
 relation_needs_vacanalyze(Oid relid,
@@ -2960,7 +3078,8 @@ relation_needs_vacanalyze(Oid relid,
  /* output params below */
 						  bool *dovacuum,
 						  bool *doanalyze,
-						  bool *wraparound)
+						  bool *wraparound,
+						  double *priority)
 {
 	bool		force_vacuum;
 	bool		av_enabled;
@@ -2989,6 +3108,9 @@ relation_needs_vacanalyze(Oid relid,
 	AssertArg(classForm != NULL);
 	AssertArg(OidIsValid(relid));
 
+	if (priority)
+		*priority = 0.0;
+
 	/*
 	 * Determine vacuum/analyze equation parameters.  We have two possible
 	 * sources: the passed reloptions (which could be a main table or a toast
@@ -3039,6 +3161,24 @@ relation_needs_vacanalyze(Oid relid,
 	}
 	*wraparound = force_vacuum;
 
+	/*
+	 * Score wraparound urgency as the fraction of the applicable freeze age
+	 * already consumed, scaled so that a table right at its force limit
+	 * scores 10.  Note the ages are computed with unsigned arithmetic, as
+	 * usual for XIDs.
+	 */
+	if (priority)
+	{
+		if (TransactionIdIsNormal(classForm->relfrozenxid))
+			*priority = Max(*priority,
+							10.0 * (double) (recentXid - classForm->relfrozenxid) /
+							(double) freeze_max_age);
+		if (MultiXactIdIsValid(classForm->relminmxid))
+			*priority = Max(*priority,
+							10.0 * (double) (recentMulti - classForm->relminmxid) /
+							(double) multixact_freeze_max_age);
+	}
+
 	/* User disabled it in pg_class.reloptions?  (But ignore if at risk) */
 	if (!av_enabled && !force_vacuum)
 	{
@@ -3075,6 +3215,20 @@ relation_needs_vacanalyze(Oid relid,
 		/* Determine if this table needs vacuum or analyze. */
 		*dovacuum = force_vacuum || (vactuples > vacthresh);
 		*doanalyze = (anltuples > anlthresh);
+
+		/*
+		 * Bloat urgency is how far the counters exceed their thresholds,
+		 * capped at 5 so it can never outrank a table at its freeze limit.
+		 */
+		if (priority)
+		{
+			if (vacthresh > 0)
+				*priority = Max(*priority,
+								Min((double) (vactuples / vacthresh), 5.0));
+			if (anlthresh > 0)
+				*priority = Max(*priority,
+								Min((double) (anltuples / anlthresh), 5.0));
+		}
 	}
 	else
 	{
@@ -1067,6 +1067,139 @@ RegisterDynamicBackgroundWorker(BackgroundWorker *worker,
 	return success;
 }
 
+/*
+ * Register a batch of new background workers from a regular backend.
+ *
+ * This is like calling RegisterDynamicBackgroundWorker() once per worker,
+ * except that the shared bgworker array is locked, and the postmaster
+ * notified, only once for the whole batch.  That matters to parallel query,
+ * which registers several identical workers in the middle of executing a
+ * latency-sensitive plan; with this entry point the postmaster receives a
+ * single signal and can fork all of the workers in one pass over its list.
+ *
+ * Registers workers[0] through workers[nworkers - 1] in order, stopping
+ * early if no slot is available or a worker-class limit has been reached
+ * (in which case later registrations would almost certainly fail too).
+ * Returns the number of workers successfully registered; for each of those,
+ * handles[i] is filled the same way RegisterDynamicBackgroundWorker() fills
+ * *handle.
+ */
+int
+RegisterDynamicBackgroundWorkers(BackgroundWorker *workers, int nworkers,
+								 BackgroundWorkerHandle **handles)
+{
+	int			nregistered = 0;
+	int			slotno = 0;
+	int		   *slotnos;
+	uint64	   *generations;
+	int			i;
+
+	/* As above, dynamic registration is impossible without a postmaster. */
+	if (!IsUnderPostmaster)
+		return 0;
+
+	for (i = 0; i < nworkers; ++i)
+	{
+		if (!SanityCheckBackgroundWorker(&workers[i], ERROR))
+			return 0;
+	}
+
+	/*
+	 * Remember each worker's slot assignment outside the lock, so that we
+	 * need not allocate memory (which could error out) while holding it.
+	 */
+	slotnos = palloc(nworkers * sizeof(int));
+	generations = palloc(nworkers * sizeof(uint64));
+
+	LWLockAcquire(BackgroundWorkerLock, LW_EXCLUSIVE);
+
+	for (i = 0; i < nworkers; ++i)
+	{
+		BackgroundWorker *worker = &workers[i];
+		bool		parallel;
+		bool		undo;
+		bool		found = false;
+
+		parallel = (worker->bgw_flags & BGWORKER_CLASS_PARALLEL) != 0;
+		undo = (worker->bgw_flags & BGWORKER_CLASS_UNDO) != 0;
+
+		/*
+		 * Enforce the per-class limits; see RegisterDynamicBackgroundWorker
+		 * for why a slightly stale view of the counters is acceptable.  The
+		 * registrations we have already made in this loop are reflected in
+		 * the counters, so the limits hold across the whole batch.
+		 */
+		if (parallel && (BackgroundWorkerData->parallel_register_count -
+						 BackgroundWorkerData->parallel_terminate_count) >=
+			max_parallel_workers)
+			break;
+		if (undo && (BackgroundWorkerData->undo_register_count -
+					 BackgroundWorkerData->undo_terminate_count) >=
+			max_undo_workers)
+			break;
+
+		/*
+		 * Look for an unused slot.  Slots we have already claimed for this
+		 * batch are in use, so the scan can resume where it left off.
+		 */
+		for (; slotno < BackgroundWorkerData->total_slots; ++slotno)
+		{
+			BackgroundWorkerSlot *slot = &BackgroundWorkerData->slot[slotno];
+
+			if (!slot->in_use)
+			{
+				memcpy(&slot->worker, worker, sizeof(BackgroundWorker));
+				slot->pid = InvalidPid; /* indicates not started yet */
+				slot->generation++;
+				slot->terminate = false;
+				slotnos[nregistered] = slotno;
+				generations[nregistered] = slot->generation;
+				if (parallel)
+					BackgroundWorkerData->parallel_register_count++;
+				if (undo)
+					BackgroundWorkerData->undo_register_count++;
+
+				/*
+				 * Make sure postmaster doesn't see the slot as in use before
+				 * it sees the new contents.
+				 */
+				pg_write_barrier();
+
+				slot->in_use = true;
+				found = true;
+				++slotno;
+				break;
+			}
+		}
+
+		if (!found)
+			break;
+		++nregistered;
+	}
+
+	LWLockRelease(BackgroundWorkerLock);
+
+	/* If we claimed any slots, tell the postmaster to notice the change. */
+	if (nregistered > 0)
+		SendPostmasterSignal(PMSIGNAL_BACKGROUND_WORKER_CHANGE);
+
+	/* Initialize the handles the caller provided for registered workers. */
+	if (handles)
+	{
+		for (i = 0; i < nregistered; ++i)
+		{
+			handles[i] = palloc(sizeof(BackgroundWorkerHandle));
+			handles[i]->slot = slotnos[i];
+			handles[i]->generation = generations[i];
+		}
+	}
+
+	pfree(slotnos);
+	pfree(generations);
+
+	return nregistered;
+}
+
 /*
  * Get the PID of a dynamically-registered background worker.
  *
@@ -35,6 +35,7 @@
 
 #include "access/xlog.h"
 #include "access/xlog_internal.h"
+#include "fmgr.h"
 #include "libpq/pqsignal.h"
 #include "miscadmin.h"
 #include "pgstat.h"
@@ -72,6 +73,18 @@
  */
 #define NUM_ORPHAN_CLEANUP_RETRIES 3
 
+/*
+ * Maximum number of ready files passed to an archive module's batch
+ * callback in one call.
+ */
+#define PGARCH_MAX_BATCH 64
+
+
+/* ----------
+ * GUC parameters
+ * ----------
+ */
+char	   *XLogArchiveLibrary = "";
 
 /* ----------
  * Local data
@@ -80,6 +93,12 @@
 static time_t last_pgarch_start_time;
 static time_t last_sigterm_time = 0;
 
+/*
+ * Callbacks of the loaded archive module, or the shell fallbacks when
+ * archive_library is not set.
+ */
+static ArchiveModuleCallbacks ArchiveContext;
+
 /*
  * Flags set by interrupt handlers for later service in the main loop.
  */
@@ -103,10 +122,19 @@ static void ArchSigTermHandler(SIGNAL_ARGS);
 static void pgarch_waken(SIGNAL_ARGS);
 static void pgarch_waken_stop(SIGNAL_ARGS);
 static void pgarch_MainLoop(void);
+static void pgarch_reloadConfig(void);
 static void pgarch_ArchiverCopyLoop(void);
-static bool pgarch_archiveXlog(char *xlog);
+static void pgarch_ArchiverBatchLoop(void);
+static bool pgarch_archiveXlog(const char *xlog);
 static bool pgarch_readyXlog(char *xlog);
+static int	pgarch_readyXlogBatch(char files[][MAX_XFN_CHARS + 1],
+								  int maxfiles);
+static int	ready_file_comparator(const void *a, const void *b);
 static void pgarch_archiveDone(char *xlog);
+static void LoadArchiveLibrary(void);
+static void pgarch_call_shutdown_cb(void);
+static bool pgarch_shell_check_configured(void);
+static bool pgarch_shell_archive_file(const char *file, const char *path);
 
 
 /* ------------------------------------------------------------
@@ -246,8 +274,13 @@ PgArchiverMain(int argc, char *argv[])
 	 */
 	init_ps_display("archiver", "", "", "");
 
+	/* Load the archive_library, if any, and set up its callbacks. */
+	LoadArchiveLibrary();
+
 	pgarch_MainLoop();
 
+	pgarch_call_shutdown_cb();
+
 	exit(0);
 }
 
@@ -349,10 +382,7 @@ pgarch_MainLoop(void)
 
 		/* Check for config update */
 		if (got_SIGHUP)
-		{
-			got_SIGHUP = false;
-			ProcessConfigFile(PGC_SIGHUP);
-		}
+			pgarch_reloadConfig();
 
 		/*
 		 * If we've gotten SIGTERM, we normally just sit and do nothing until
@@ -416,6 +446,32 @@ pgarch_MainLoop(void)
 	} while (!time_to_stop);
 }
 
+/*
+ * pgarch_reloadConfig
+ *
+ * Re-read the configuration file.  If archive_library changed, restart the
+ * archiver process, so that the new library is loaded into a clean process;
+ * dynamically loaded libraries cannot be unloaded in place.
+ */
+static void
+pgarch_reloadConfig(void)
+{
+	char	   *archiveLib = pstrdup(XLogArchiveLibrary);
+
+	got_SIGHUP = false;
+	ProcessConfigFile(PGC_SIGHUP);
+
+	if (strcmp(archiveLib, XLogArchiveLibrary) != 0)
+	{
+		ereport(LOG,
+				(errmsg("restarting archiver process because value of "
+						"\"archive_library\" was changed")));
+		pgarch_call_shutdown_cb();
+		exit(0);
+	}
+	pfree(archiveLib);
+}
+
 /*
  * pgarch_ArchiverCopyLoop
  *
@@ -426,6 +482,13 @@ pgarch_ArchiverCopyLoop(void)
 {
 	char		xlog[MAX_XFN_CHARS + 1];
 
+	/* Modules that can multiplex uploads get whole batches at once. */
+	if (ArchiveContext.archive_batch_cb != NULL)
+	{
+		pgarch_ArchiverBatchLoop();
+		return;
+	}
+
 	/*
 	 * loop through all xlogs with archive_status of .ready and archive
 	 * them...mostly we expect this to be a single file, though it is possible
@@ -458,16 +521,14 @@ pgarch_ArchiverCopyLoop(void)
 			 * is a backlog of files to be archived.
 			 */
 			if (got_SIGHUP)
-			{
-				got_SIGHUP = false;
-				ProcessConfigFile(PGC_SIGHUP);
-			}
+				pgarch_reloadConfig();
 
-			/* can't do anything if no command ... */
-			if (!XLogArchiveCommandSet())
+			/* can't do anything if archiving is not configured ... */
+			if (ArchiveContext.check_configured_cb != NULL &&
+				!ArchiveContext.check_configured_cb())
 			{
 				ereport(WARNING,
-						(errmsg("archive_mode enabled, yet archive_command is not set")));
+						(errmsg("archive_mode enabled, yet archiving is not configured")));
 				return;
 			}
 
@@ -511,7 +572,7 @@ pgarch_ArchiverCopyLoop(void)
 				continue;
 			}
 
-			if (pgarch_archiveXlog(xlog))
+			if (ArchiveContext.archive_file_cb(xlog, pathname))
 			{
 				/* successful */
 				pgarch_archiveDone(xlog);
@@ -545,6 +606,118 @@ pgarch_ArchiverCopyLoop(void)
 	}
 }
 
+/*
+ * pgarch_ArchiverBatchLoop
+ *
+ * Like pgarch_ArchiverCopyLoop, but hands the archive module's batch
+ * callback an array of ready files at a time, so that it can multiplex
+ * uploads and pipeline compression instead of paying a round trip per
+ * segment.  The callback must archive a prefix of the array, in order, and
+ * report how many files it completed; the rest are retried later.
+ */
+static void
+pgarch_ArchiverBatchLoop(void)
+{
+	char		files[PGARCH_MAX_BATCH][MAX_XFN_CHARS + 1];
+	int			nfiles;
+	int			failures = 0;
+
+	while ((nfiles = pgarch_readyXlogBatch(files, PGARCH_MAX_BATCH)) > 0)
+	{
+		char		paths[PGARCH_MAX_BATCH][MAXPGPATH];
+		const char *fileptrs[PGARCH_MAX_BATCH];
+		const char *pathptrs[PGARCH_MAX_BATCH];
+		char		activitymsg[MAXFNAMELEN + 16];
+		int			ngood = 0;
+		int			archived;
+		int			i;
+
+		/* Same stop conditions as for the one-file-at-a-time loop. */
+		if (got_SIGTERM || !PostmasterIsAlive())
+			return;
+
+		if (got_SIGHUP)
+			pgarch_reloadConfig();
+
+		if (ArchiveContext.check_configured_cb != NULL &&
+			!ArchiveContext.check_configured_cb())
+		{
+			ereport(WARNING,
+					(errmsg("archive_mode enabled, yet archiving is not configured")));
+			return;
+		}
+
+		/*
+		 * Weed out status files for WAL segments that no longer exist; a
+		 * crash can leave .ready files behind for recycled segments.  See
+		 * pgarch_ArchiverCopyLoop.
+		 */
+		for (i = 0; i < nfiles; i++)
+		{
+			struct stat stat_buf;
+
+			snprintf(paths[ngood], MAXPGPATH, XLOGDIR "/%s", files[i]);
+			if (stat(paths[ngood], &stat_buf) != 0 && errno == ENOENT)
+			{
+				char		xlogready[MAXPGPATH];
+
+				StatusFilePath(xlogready, files[i], ".ready");
+				if (unlink(xlogready) == 0)
+					ereport(WARNING,
+							(errmsg("removed orphan archive status file \"%s\"",
+									xlogready)));
+				continue;
+			}
+
+			if (ngood != i)
+				strcpy(files[ngood], files[i]);
+			fileptrs[ngood] = files[ngood];
+			pathptrs[ngood] = paths[ngood];
+			ngood++;
+		}
+		nfiles = ngood;
+		if (nfiles == 0)
+			continue;
+
+		snprintf(activitymsg, sizeof(activitymsg), "archiving %s", files[0]);
+		set_ps_display(activitymsg, false);
+
+		archived = ArchiveContext.archive_batch_cb(nfiles, fileptrs, pathptrs);
+		archived = Min(archived, nfiles);
+
+		for (i = 0; i < archived; i++)
+		{
+			pgarch_archiveDone(files[i]);
+
+			/* tell the collector about each archived WAL file */
+			pgstat_send_archiver(files[i], false);
+		}
+
+		if (archived < nfiles)
+		{
+			/* report the first failure, as the per-file loop would */
+			pgstat_send_archiver(files[archived], true);
+
+			if (++failures >= NUM_ARCHIVE_RETRIES)
+			{
+				ereport(WARNING,
+						(errmsg("archiving write-ahead log file \"%s\" failed too many times, will try again later",
+								files[archived])));
+				return;		/* give up archiving for now */
+			}
+			pg_usleep(1000000L);	/* wait a bit before retrying */
+		}
+		else
+		{
+			failures = 0;
+
+			snprintf(activitymsg, sizeof(activitymsg), "last was %s",
+					 files[nfiles - 1]);
+			set_ps_display(activitymsg, false);
+		}
+	}
+}
+
 /*
  * pgarch_archiveXlog
  *
@@ -553,7 +726,7 @@ pgarch_ArchiverCopyLoop(void)
  * Returns true if successful
  */
 static bool
-pgarch_archiveXlog(char *xlog)
+pgarch_archiveXlog(const char *xlog)
 {
 	char		xlogarchcmd[MAXPGPATH];
 	char		pathname[MAXPGPATH];
@@ -771,6 +944,111 @@ pgarch_readyXlog(char *xlog)
 	return found;
 }
 
+/*
+ * pgarch_readyXlogBatch
+ *
+ * Fill 'files' with the names of up to 'maxfiles' un-archived xlog files,
+ * oldest first, and return how many were found.  The ordering rules are the
+ * same as pgarch_readyXlog's: history files come before everything else,
+ * and otherwise names sort according to the order the segments were
+ * written.
+ */
+static int
+pgarch_readyXlogBatch(char files[][MAX_XFN_CHARS + 1], int maxfiles)
+{
+	char		XLogArchiveStatusDir[MAXPGPATH];
+	DIR		   *rldir;
+	struct dirent *rlde;
+	char	   *names;
+	int			nfound = 0;
+	int			maxfound = maxfiles * 2;
+	int			i;
+
+	/*
+	 * Collect candidate names into a scratch array, sort, and return the
+	 * oldest ones.  We deliberately collect more than one batch's worth so
+	 * that a directory full of newer segments can't starve an older one
+	 * that a readdir() happens to return late, but there's no need to sort
+	 * an unbounded list just to archive maxfiles of them.
+	 */
+	names = palloc(maxfound * (MAX_XFN_CHARS + 1));
+
+	snprintf(XLogArchiveStatusDir, MAXPGPATH, XLOGDIR "/archive_status");
+	rldir = AllocateDir(XLogArchiveStatusDir);
+
+	while ((rlde = ReadDir(rldir, XLogArchiveStatusDir)) != NULL)
+	{
+		int			basenamelen = (int) strlen(rlde->d_name) - 6;
+		char		basename[MAX_XFN_CHARS + 1];
+
+		/* Ignore entries with unexpected number of characters */
+		if (basenamelen < MIN_XFN_CHARS ||
+			basenamelen > MAX_XFN_CHARS)
+			continue;
+
+		/* Ignore entries with unexpected characters */
+		if (strspn(rlde->d_name, VALID_XFN_CHARS) < basenamelen)
+			continue;
+
+		/* Ignore anything not suffixed with .ready */
+		if (strcmp(rlde->d_name + basenamelen, ".ready") != 0)
+			continue;
+
+		/* Truncate off the .ready */
+		memcpy(basename, rlde->d_name, basenamelen);
+		basename[basenamelen] = '\0';
+
+		if (nfound < maxfound)
+		{
+			strcpy(names + nfound * (MAX_XFN_CHARS + 1), basename);
+			nfound++;
+		}
+		else
+		{
+			/* Replace the newest remembered name if this one is older. */
+			int			newest = 0;
+
+			for (i = 1; i < nfound; i++)
+				if (ready_file_comparator(names + i * (MAX_XFN_CHARS + 1),
+										  names + newest * (MAX_XFN_CHARS + 1)) > 0)
+					newest = i;
+			if (ready_file_comparator(basename,
+									  names + newest * (MAX_XFN_CHARS + 1)) < 0)
+				strcpy(names + newest * (MAX_XFN_CHARS + 1), basename);
+		}
+	}
+	FreeDir(rldir);
+
+	qsort(names, nfound, MAX_XFN_CHARS + 1, ready_file_comparator);
+
+	if (nfound > maxfiles)
+		nfound = maxfiles;
+	for (i = 0; i < nfound; i++)
+		strcpy(files[i], names + i * (MAX_XFN_CHARS + 1));
+
+	pfree(names);
+
+	return nfound;
+}
+
+/*
+ * Sorts ready files oldest-first: history files have the highest priority,
+ * and otherwise plain name order matches segment creation order.
+ */
+static int
+ready_file_comparator(const void *a, const void *b)
+{
+	const char *f1 = (const char *) a;
+	const char *f2 = (const char *) b;
+	bool		ishistory1 = IsTLHistoryFileName(f1);
+	bool		ishistory2 = IsTLHistoryFileName(f2);
+
+	if (ishistory1 != ishistory2)
+		return ishistory1 ? -1 : 1;
+
+	return strcmp(f1, f2);
+}
+
 /*
  * pgarch_archiveDone
  *
@@ -789,3 +1067,72 @@ pgarch_archiveDone(char *xlog)
 	StatusFilePath(rlogdone, xlog, ".done");
 	(void) durable_rename(rlogready, rlogdone, WARNING);
 }
+
+/*
+ * LoadArchiveLibrary
+ *
+ * Loads the archiving callbacks into our local ArchiveContext.  When no
+ * archive_library is configured, fall back on running archive_command
+ * through the shell, one file at a time.
+ */
+static void
+LoadArchiveLibrary(void)
+{
+	ArchiveModuleInit archive_init;
+
+	memset(&ArchiveContext, 0, sizeof(ArchiveModuleCallbacks));
+
+	if (XLogArchiveLibrary[0] == '\0')
+	{
+		ArchiveContext.check_configured_cb = pgarch_shell_check_configured;
+		ArchiveContext.archive_file_cb = pgarch_shell_archive_file;
+		return;
+	}
+
+	/*
+	 * If this fails, the resulting FATAL exit gets the archiver restarted
+	 * by the postmaster, so a bad archive_library setting is retried (and
+	 * complained about) rather than silently disabling archiving.
+	 */
+	archive_init = (ArchiveModuleInit)
+		load_external_function(XLogArchiveLibrary,
+							   "_PG_archive_module_init", false, NULL);
+
+	if (archive_init == NULL)
+		ereport(ERROR,
+				(errmsg("archive modules have to declare the %s symbol",
+						"_PG_archive_module_init")));
+
+	archive_init(&ArchiveContext);
+
+	if (ArchiveContext.archive_file_cb == NULL &&
+		ArchiveContext.archive_batch_cb == NULL)
+		ereport(ERROR,
+				(errmsg("archive modules must register an archive callback")));
+}
+
+/*
+ * Call the shutdown callback of the loaded archive module, if defined.
+ */
+static void
+pgarch_call_shutdown_cb(void)
+{
+	if (ArchiveContext.shutdown_cb != NULL)
+		ArchiveContext.shutdown_cb();
+}
+
+/*
+ * Archiving callbacks used when no archive_library is configured; these
+ * preserve the traditional archive_command behavior.
+ */
+static bool
+pgarch_shell_check_configured(void)
+{
+	return XLogArchiveCommandSet();
+}
+
+static bool
+pgarch_shell_archive_file(const char *file, const char *path)
+{
+	return pgarch_archiveXlog(file);
+}
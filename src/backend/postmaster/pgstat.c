@@ -93,8 +93,22 @@
 #define PGSTAT_POLL_LOOP_COUNT	(PGSTAT_MAX_WAIT_TIME / PGSTAT_RETRY_DELAY)
 #define PGSTAT_INQ_LOOP_COUNT	(PGSTAT_INQ_INTERVAL / PGSTAT_RETRY_DELAY)
 
-/* Minimum receive buffer size for the collector's socket. */
-#define PGSTAT_MIN_RCVBUF		(100 * 1024)
+/*
+ * Minimum receive buffer size for the collector's socket.  The collector can
+ * fall far behind while it is busy rewriting stats files for installations
+ * with very many tables, and every message that doesn't fit in the socket
+ * buffer during that time is silently dropped; a roomy buffer is the only
+ * defense this transport has.  (The kernel may cap the value we request.)
+ *
+ * XXX The real fix for stats message loss, the per-database stats file
+ * rewrite traffic, and collector lag is to keep the cumulative stats in
+ * shared memory, with per-backend deltas applied in batches, instead of
+ * shipping them over a lossy socket to a process that serializes them to
+ * disk.  That is a rewrite of this whole file rather than an adjustment,
+ * since every reader currently expects a private snapshot loaded from the
+ * stats files.
+ */
+#define PGSTAT_MIN_RCVBUF		(1024 * 1024)
 
 
 /* ----------
@@ -3747,6 +3761,9 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 
 	switch (w)
 	{
+		case WAIT_EVENT_APPEND_READY:
+			event_name = "AppendReady";
+			break;
 		case WAIT_EVENT_BGWORKER_SHUTDOWN:
 			event_name = "BgWorkerShutdown";
 			break;
@@ -3840,6 +3857,9 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 		case WAIT_EVENT_PARALLEL_FINISH:
 			event_name = "ParallelFinish";
 			break;
+		case WAIT_EVENT_PARALLEL_MATERIAL_BUILD:
+			event_name = "ParallelMaterialBuild";
+			break;
 		case WAIT_EVENT_PROCARRAY_GROUP_UPDATE:
 			event_name = "ProcArrayGroupUpdate";
 			break;
@@ -3858,6 +3878,9 @@ pgstat_get_wait_ipc(WaitEventIPC w)
 		case WAIT_EVENT_SYNC_REP:
 			event_name = "SyncRep";
 			break;
+		case WAIT_EVENT_WAL_RESERVE_GROUP_UPDATE:
+			event_name = "WALReserveGroupUpdate";
+			break;
 			/* no default case, so that compiler will warn */
 	}
 
@@ -4094,6 +4117,9 @@ pgstat_get_wait_io(WaitEventIO w)
 		case WAIT_EVENT_UNDO_FILE_SYNC:
 			event_name = "UndoFileSync";
 			break;
+		case WAIT_EVENT_UNDO_SEGMENT_INIT:
+			event_name = "UndoSegmentInit";
+			break;
 		case WAIT_EVENT_WALSENDER_TIMELINE_HISTORY_READ:
 			event_name = "WALSenderTimelineHistoryRead";
 			break;
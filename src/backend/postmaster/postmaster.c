@@ -410,6 +410,7 @@ static void SendNegotiateProtocolVersion(List *unrecognized_protocol_options);
 static void processCancelRequest(Port *port, void *pkt);
 static int	initMasks(fd_set *rmask);
 static void report_fork_failure_to_client(Port *port, int errnum);
+static void report_rejection_to_client(Port *port, CAC_state cac);
 static CAC_state canAcceptConnections(void);
 static bool RandomCancelKey(int32 *cancel_key);
 static void signal_child(pid_t pid, int signal);
@@ -419,6 +420,7 @@ static void TerminateChildren(int signal);
 #define SignalChildren(sig)			   SignalSomeChildren(sig, BACKEND_TYPE_ALL)
 
 static int	CountChildren(int target);
+static int	CountDeadEndChildren(void);
 static bool assign_backendlist_entry(RegisteredBgWorker *rw);
 static void maybe_start_bgworkers(void);
 static bool CreateOptsFile(int argc, char *argv[], char *fullprogname);
@@ -4082,11 +4084,39 @@ TerminateChildren(int signal)
  *
  * Note: if you change this code, also consider StartAutovacuumWorker.
  */
+
+/*
+ * Cap on the number of dead_end children we'll fork just to deliver an error
+ * message.  A saturated server accumulating more doomed connections than
+ * this is under a connection storm, and further rejections are reported
+ * directly from the postmaster instead.
+ */
+#define MAX_DEAD_END_CHILDREN	100
+
 static int
 BackendStartup(Port *port)
 {
 	Backend    *bn;				/* for backend cleanup */
 	pid_t		pid;
+	CAC_state	cac;
+
+	/*
+	 * If this connection is doomed to be rejected anyway, and we are already
+	 * servicing an unreasonable number of doomed connections, don't spend a
+	 * fork on delivering this one's error message: report it directly from
+	 * the postmaster and hang up.  This keeps a connection storm against a
+	 * saturated or recovering server from bloating the box with dead_end
+	 * children.  The cost is that such clients get a terse pre-protocol
+	 * error, and cancel requests arriving while we're in this state go
+	 * unserviced; both beat forking ourselves to death.
+	 */
+	cac = canAcceptConnections();
+	if (cac != CAC_OK && cac != CAC_WAITBACKUP &&
+		CountDeadEndChildren() >= MAX_DEAD_END_CHILDREN)
+	{
+		report_rejection_to_client(port, cac);
+		return STATUS_ERROR;
+	}
 
 	/*
 	 * Create backend data structure.  Better before the fork() so we can
@@ -4118,9 +4148,8 @@ BackendStartup(Port *port)
 	bn->cancel_key = MyCancelKey;
 
 	/* Pass down canAcceptConnections state */
-	port->canAcceptConnections = canAcceptConnections();
-	bn->dead_end = (port->canAcceptConnections != CAC_OK &&
-					port->canAcceptConnections != CAC_WAITBACKUP);
+	port->canAcceptConnections = cac;
+	bn->dead_end = (cac != CAC_OK && cac != CAC_WAITBACKUP);
 
 	/*
 	 * Unless it's a dead_end child, assign it a child slot number
@@ -4221,6 +4250,51 @@ report_fork_failure_to_client(Port *port, int errnum)
 	} while (rc < 0 && errno == EINTR);
 }
 
+/*
+ * Try to report a connection rejection to the client before we close the
+ * connection, when there are already too many dead_end children to justify
+ * forking another one just to do the talking.  As in
+ * report_fork_failure_to_client, we cannot use backend libpq and do not
+ * care to risk blocking the postmaster, so this is best-effort only.
+ */
+static void
+report_rejection_to_client(Port *port, CAC_state cac)
+{
+	char		buffer[1000];
+	const char *msg;
+	int			rc;
+
+	switch (cac)
+	{
+		case CAC_STARTUP:
+			msg = _("the database system is starting up");
+			break;
+		case CAC_SHUTDOWN:
+			msg = _("the database system is shutting down");
+			break;
+		case CAC_RECOVERY:
+			msg = _("the database system is in recovery mode");
+			break;
+		case CAC_TOOMANY:
+		default:
+			msg = _("sorry, too many clients already");
+			break;
+	}
+
+	/* Format the error message packet (always V2 protocol) */
+	snprintf(buffer, sizeof(buffer), "E%s\n", msg);
+
+	/* Set port to non-blocking.  Don't do send() if this fails */
+	if (!pg_set_noblock(port->sock))
+		return;
+
+	/* We'll retry after EINTR, but ignore all other failures */
+	do
+	{
+		rc = send(port->sock, buffer, strlen(buffer) + 1, 0);
+	} while (rc < 0 && errno == EINTR);
+}
+
 
 /*
  * BackendInitialize -- initialize an interactive (postmaster-child)
@@ -5364,6 +5438,25 @@ CountChildren(int target)
 	return cnt;
 }
 
+/*
+ * Count up number of dead_end child processes.
+ */
+static int
+CountDeadEndChildren(void)
+{
+	dlist_iter	iter;
+	int			cnt = 0;
+
+	dlist_foreach(iter, &BackendList)
+	{
+		Backend    *bp = dlist_container(Backend, elem, iter.cur);
+
+		if (bp->dead_end)
+			cnt++;
+	}
+	return cnt;
+}
+
 
 /*
  * StartChildProcess -- start an auxiliary process for the postmaster
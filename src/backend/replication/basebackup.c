@@ -12,6 +12,14 @@
  */
 #include "postgres.h"
 
+#ifdef USE_LZ4
+#include <lz4frame.h>
+#endif
+
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
+
 #include <sys/stat.h>
 #include <unistd.h>
 #include <time.h>
@@ -36,6 +44,7 @@
 #include "storage/dsm_impl.h"
 #include "storage/fd.h"
 #include "storage/ipc.h"
+#include "storage/md.h"
 #include "storage/reinit.h"
 #include "utils/builtins.h"
 #include "utils/ps_status.h"
@@ -43,6 +52,16 @@
 #include "utils/timestamp.h"
 
 
+/*
+ * Compression applied to the tar streams on the server before transmission.
+ */
+typedef enum
+{
+	BACKUP_COMPRESSION_NONE = 0,
+	BACKUP_COMPRESSION_LZ4,
+	BACKUP_COMPRESSION_ZSTD
+} basebackup_compression_method;
+
 typedef struct
 {
 	const char *label;
@@ -52,6 +71,7 @@ typedef struct
 	bool		includewal;
 	uint32		maxrate;
 	bool		sendtblspcmapfile;
+	basebackup_compression_method compression;
 } basebackup_options;
 
 
@@ -73,6 +93,10 @@ static void SendXlogRecPtrResult(XLogRecPtr ptr, TimeLineID tli);
 static int	compareWalFileNames(const ListCell *a, const ListCell *b);
 static void throttle(size_t increment);
 static bool is_checksummed_file(const char *fullpath, const char *filename);
+static void SendCopyData(const char *data, size_t len);
+static void StartTarCompression(void);
+static void SendTarData(const char *data, size_t len);
+static void EndTarCompression(void);
 
 /* Was the backup currently in-progress initiated in recovery mode? */
 static bool backup_started_in_recovery = false;
@@ -81,9 +105,12 @@ static bool backup_started_in_recovery = false;
 static char *statrelpath = NULL;
 
 /*
- * Size of each block sent into the tar stream for larger files.
+ * Size of each block sent into the tar stream for larger files.  Must be a
+ * multiple of BLCKSZ, so that checksum verification can work on whole pages
+ * within each chunk.  Larger chunks mean fewer reads and fewer CopyData
+ * messages per file.
  */
-#define TAR_SEND_SIZE 32768
+#define TAR_SEND_SIZE 131072
 
 /*
  * How frequently to throttle, as a fraction of the specified rate-second.
@@ -123,6 +150,22 @@ static long long int total_checksum_failures;
 /* Do not verify checksums. */
 static bool noverify_checksums = false;
 
+/* Compression method applied to the tar streams of the current backup. */
+static basebackup_compression_method compression_method = BACKUP_COMPRESSION_NONE;
+
+#ifdef USE_LZ4
+static LZ4F_compressionContext_t lz4_cctx = NULL;
+#endif
+#ifdef USE_ZSTD
+static ZSTD_CStream *zstd_cstream = NULL;
+#endif
+
+#if defined(USE_LZ4) || defined(USE_ZSTD)
+/* Scratch buffer holding compressed data awaiting transmission. */
+static char *compress_buf = NULL;
+static size_t compress_buf_size = 0;
+#endif
+
 /*
  * The contents of these directories are removed or recreated during server
  * start so they are not included in backups.  The directories themselves are
@@ -254,6 +297,8 @@ perform_base_backup(basebackup_options *opt)
 
 	total_checksum_failures = 0;
 
+	compression_method = opt->compression;
+
 	startptr = do_pg_start_backup(opt->label, opt->fastcheckpoint, &starttli,
 								  labelfile, &tablespaces,
 								  tblspc_map_file,
@@ -329,6 +374,9 @@ perform_base_backup(basebackup_options *opt)
 			pq_sendint16(&buf, 0);	/* natts */
 			pq_endmessage(&buf);
 
+			/* Each tablespace's tar is a separate compressed stream */
+			StartTarCompression();
+
 			if (ti->path == NULL)
 			{
 				struct stat statbuf;
@@ -370,7 +418,10 @@ perform_base_backup(basebackup_options *opt)
 				Assert(lnext(tablespaces, lc) == NULL);
 			}
 			else
+			{
+				EndTarCompression();
 				pq_putemptymessage('c');	/* CopyDone */
+			}
 		}
 
 		endptr = do_pg_stop_backup(labelfile->data, !opt->nowait, &endtli);
@@ -543,10 +594,7 @@ perform_base_backup(basebackup_options *opt)
 								fp)) > 0)
 			{
 				CheckXLogRemoved(segno, tli);
-				/* Send the chunk as a CopyData message */
-				if (pq_putmessage('d', buf, cnt))
-					ereport(ERROR,
-							(errmsg("base backup could not send data, aborting backup")));
+				SendTarData(buf, cnt);
 
 				len += cnt;
 				throttle(cnt);
@@ -607,6 +655,7 @@ perform_base_backup(basebackup_options *opt)
 		}
 
 		/* Send CopyDone message for the last tar file */
+		EndTarCompression();
 		pq_putemptymessage('c');
 	}
 	SendXlogRecPtrResult(endptr, endtli);
@@ -652,6 +701,7 @@ parse_basebackup_options(List *options, basebackup_options *opt)
 	bool		o_maxrate = false;
 	bool		o_tablespace_map = false;
 	bool		o_noverify_checksums = false;
+	bool		o_compression = false;
 
 	MemSet(opt, 0, sizeof(*opt));
 	foreach(lopt, options)
@@ -740,6 +790,46 @@ parse_basebackup_options(List *options, basebackup_options *opt)
 			noverify_checksums = true;
 			o_noverify_checksums = true;
 		}
+		else if (strcmp(defel->defname, "compression") == 0)
+		{
+			char	   *method = strVal(defel->arg);
+
+			if (o_compression)
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("duplicate option \"%s\"", defel->defname)));
+
+			if (strcmp(method, "none") == 0)
+				opt->compression = BACKUP_COMPRESSION_NONE;
+			else if (strcmp(method, "lz4") == 0)
+			{
+#ifdef USE_LZ4
+				opt->compression = BACKUP_COMPRESSION_LZ4;
+#else
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("compression method \"%s\" not supported by this build",
+								method)));
+#endif
+			}
+			else if (strcmp(method, "zstd") == 0)
+			{
+#ifdef USE_ZSTD
+				opt->compression = BACKUP_COMPRESSION_ZSTD;
+#else
+				ereport(ERROR,
+						(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+						 errmsg("compression method \"%s\" not supported by this build",
+								method)));
+#endif
+			}
+			else
+				ereport(ERROR,
+						(errcode(ERRCODE_SYNTAX_ERROR),
+						 errmsg("unrecognized compression method: \"%s\"",
+								method)));
+			o_compression = true;
+		}
 		else
 			elog(ERROR, "option \"%s\" not recognized",
 				 defel->defname);
@@ -946,8 +1036,7 @@ sendFileWithContent(const char *filename, const char *content)
 	statbuf.st_size = len;
 
 	_tarWriteHeader(filename, NULL, &statbuf, false);
-	/* Send the contents as a CopyData message */
-	pq_putmessage('d', content, len);
+	SendTarData(content, len);
 
 	/* Pad to 512 byte boundary, per tar format requirements */
 	pad = ((len + 511) & ~511) - len;
@@ -956,7 +1045,7 @@ sendFileWithContent(const char *filename, const char *content)
 		char		buf[512];
 
 		MemSet(buf, 0, pad);
-		pq_putmessage('d', buf, pad);
+		SendTarData(buf, pad);
 	}
 }
 
@@ -1424,7 +1513,8 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 				if (strstr(readfilename, "undo"))
 					first_blkno = strtol(segmentpath + 1, &end, 16) / BLCKSZ;
 				else
-					first_blkno = strtol(segmentpath + 1, &end, 10) * RELSEG_SIZE;
+					first_blkno = strtol(segmentpath + 1, &end, 10) *
+						rel_segment_size;
 				if (*end != '\0')
 					ereport(ERROR,
 							(errmsg("invalid segment number in file \"%s\"",
@@ -1555,10 +1645,7 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 			}
 		}
 
-		/* Send the chunk as a CopyData message */
-		if (pq_putmessage('d', buf, cnt))
-			ereport(ERROR,
-					(errmsg("base backup could not send data, aborting backup")));
+		SendTarData(buf, cnt);
 
 		len += cnt;
 		throttle(cnt);
@@ -1583,7 +1670,7 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 		while (len < statbuf->st_size)
 		{
 			cnt = Min(sizeof(buf), statbuf->st_size - len);
-			pq_putmessage('d', buf, cnt);
+			SendTarData(buf, cnt);
 			len += cnt;
 			throttle(cnt);
 		}
@@ -1597,7 +1684,7 @@ sendFile(const char *readfilename, const char *tarfilename, struct stat *statbuf
 	if (pad > 0)
 	{
 		MemSet(buf, 0, pad);
-		pq_putmessage('d', buf, pad);
+		SendTarData(buf, pad);
 	}
 
 	FreeFile(fp);
@@ -1651,7 +1738,7 @@ _tarWriteHeader(const char *filename, const char *linktarget,
 				elog(ERROR, "unrecognized tar error: %d", rc);
 		}
 
-		pq_putmessage('d', h, sizeof(h));
+		SendTarData(h, sizeof(h));
 	}
 
 	return sizeof(h);
@@ -1749,3 +1836,208 @@ throttle(size_t increment)
 	 */
 	throttled_last = GetCurrentTimestamp();
 }
+
+/*
+ * Send a chunk of the output stream to the client as a CopyData message.
+ */
+static void
+SendCopyData(const char *data, size_t len)
+{
+	if (pq_putmessage('d', data, len))
+		ereport(ERROR,
+				(errmsg("base backup could not send data, aborting backup")));
+}
+
+/*
+ * Prepare to emit one tar stream, opening a fresh compressed frame if the
+ * client requested compression.  Each tablespace's tar is compressed as a
+ * separate frame, so the client can decompress the archives independently.
+ */
+static void
+StartTarCompression(void)
+{
+	switch (compression_method)
+	{
+		case BACKUP_COMPRESSION_NONE:
+			break;
+
+#ifdef USE_LZ4
+		case BACKUP_COMPRESSION_LZ4:
+			{
+				size_t		hdrlen;
+
+				if (compress_buf == NULL)
+				{
+					compress_buf_size = LZ4F_compressBound(TAR_SEND_SIZE, NULL);
+					compress_buf = palloc(compress_buf_size);
+				}
+
+				if (LZ4F_isError(LZ4F_createCompressionContext(&lz4_cctx,
+															   LZ4F_VERSION)))
+					elog(ERROR, "could not create LZ4 compression context");
+
+				hdrlen = LZ4F_compressBegin(lz4_cctx, compress_buf,
+											compress_buf_size, NULL);
+				if (LZ4F_isError(hdrlen))
+					elog(ERROR, "could not begin LZ4 compression: %s",
+						 LZ4F_getErrorName(hdrlen));
+				SendCopyData(compress_buf, hdrlen);
+				break;
+			}
+#endif
+
+#ifdef USE_ZSTD
+		case BACKUP_COMPRESSION_ZSTD:
+			if (compress_buf == NULL)
+			{
+				compress_buf_size = ZSTD_CStreamOutSize();
+				compress_buf = palloc(compress_buf_size);
+			}
+
+			zstd_cstream = ZSTD_createCStream();
+			if (zstd_cstream == NULL)
+				elog(ERROR, "could not create zstd compression stream");
+			ZSTD_initCStream(zstd_cstream, ZSTD_CLEVEL_DEFAULT);
+			break;
+#endif
+
+		default:
+			elog(ERROR, "unsupported compression method: %d",
+				 compression_method);
+	}
+}
+
+/*
+ * Send bytes of the current tar stream, compressing them first if the client
+ * requested compression.  The throttling of the network transfer is driven
+ * by the uncompressed byte counts at the callers, so the effective rate limit
+ * stays proportional to the amount of data read from disk.
+ */
+static void
+SendTarData(const char *data, size_t len)
+{
+	switch (compression_method)
+	{
+		case BACKUP_COMPRESSION_NONE:
+			SendCopyData(data, len);
+			break;
+
+#ifdef USE_LZ4
+		case BACKUP_COMPRESSION_LZ4:
+			while (len > 0)
+			{
+				size_t		chunk = Min(len, (size_t) TAR_SEND_SIZE);
+				size_t		outlen;
+
+				outlen = LZ4F_compressUpdate(lz4_cctx,
+											 compress_buf, compress_buf_size,
+											 data, chunk, NULL);
+				if (LZ4F_isError(outlen))
+					elog(ERROR, "could not compress data: %s",
+						 LZ4F_getErrorName(outlen));
+				if (outlen > 0)
+					SendCopyData(compress_buf, outlen);
+
+				data += chunk;
+				len -= chunk;
+			}
+			break;
+#endif
+
+#ifdef USE_ZSTD
+		case BACKUP_COMPRESSION_ZSTD:
+			{
+				ZSTD_inBuffer inbuf = {data, len, 0};
+
+				while (inbuf.pos < inbuf.size)
+				{
+					ZSTD_outBuffer outbuf = {compress_buf, compress_buf_size, 0};
+					size_t		ret;
+
+					ret = ZSTD_compressStream(zstd_cstream, &outbuf, &inbuf);
+					if (ZSTD_isError(ret))
+						elog(ERROR, "could not compress data: %s",
+							 ZSTD_getErrorName(ret));
+					if (outbuf.pos > 0)
+						SendCopyData(compress_buf, outbuf.pos);
+				}
+				break;
+			}
+#endif
+
+		default:
+			elog(ERROR, "unsupported compression method: %d",
+				 compression_method);
+	}
+}
+
+/*
+ * Finish the compressed frame of the current tar stream and send whatever
+ * output the compressor still had buffered.
+ */
+static void
+EndTarCompression(void)
+{
+	/*
+	 * The client normally appends the two trailing zero blocks of the tar
+	 * format itself, but it cannot append anything to a compressed stream, so
+	 * include them in the frame here.
+	 */
+	if (compression_method != BACKUP_COMPRESSION_NONE)
+	{
+		char		zerobuf[1024];
+
+		MemSet(zerobuf, 0, sizeof(zerobuf));
+		SendTarData(zerobuf, sizeof(zerobuf));
+	}
+
+	switch (compression_method)
+	{
+		case BACKUP_COMPRESSION_NONE:
+			break;
+
+#ifdef USE_LZ4
+		case BACKUP_COMPRESSION_LZ4:
+			{
+				size_t		outlen;
+
+				outlen = LZ4F_compressEnd(lz4_cctx, compress_buf,
+										  compress_buf_size, NULL);
+				if (LZ4F_isError(outlen))
+					elog(ERROR, "could not end LZ4 compression: %s",
+						 LZ4F_getErrorName(outlen));
+				if (outlen > 0)
+					SendCopyData(compress_buf, outlen);
+
+				LZ4F_freeCompressionContext(lz4_cctx);
+				lz4_cctx = NULL;
+				break;
+			}
+#endif
+
+#ifdef USE_ZSTD
+		case BACKUP_COMPRESSION_ZSTD:
+			for (;;)
+			{
+				ZSTD_outBuffer outbuf = {compress_buf, compress_buf_size, 0};
+				size_t		remaining;
+
+				remaining = ZSTD_endStream(zstd_cstream, &outbuf);
+				if (ZSTD_isError(remaining))
+					elog(ERROR, "could not end zstd compression: %s",
+						 ZSTD_getErrorName(remaining));
+				if (outbuf.pos > 0)
+					SendCopyData(compress_buf, outbuf.pos);
+				if (remaining == 0)
+					break;
+			}
+			ZSTD_freeCStream(zstd_cstream);
+			zstd_cstream = NULL;
+			break;
+#endif
+
+		default:
+			elog(ERROR, "unsupported compression method: %d",
+				 compression_method);
+	}
+}
@@ -56,6 +56,10 @@
 #include <unistd.h>
 #include <sys/stat.h>
 
+#ifdef USE_LZ4
+#include <lz4.h>
+#endif
+
 #include "access/detoast.h"
 #include "access/heapam.h"
 #include "access/rewriteheap.h"
@@ -137,25 +141,39 @@ typedef struct ReorderBufferToastEnt
 /* Disk serialization support datastructures */
 typedef struct ReorderBufferDiskChange
 {
-	Size		size;
+	Size		size;			/* on-disk size of this entry, including the
+								 * header itself */
+	Size		raw_size;		/* in-memory size; differs from "size" only if
+								 * the trailing data is LZ4 compressed */
 	ReorderBufferChange change;
 	/* data follows */
 } ReorderBufferDiskChange;
 
+/* GUC variable */
+int			logical_decoding_work_mem;
+
 /*
- * Maximum number of changes kept in memory, per transaction. After that,
- * changes are spooled to disk.
- *
- * The current value should be sufficient to decode the entire transaction
- * without hitting disk in OLTP workloads, while starting to spool to disk in
- * other workloads reasonably fast.
- *
- * At some point in the future it probably makes sense to have a more elaborate
- * resource management here, but it's not entirely clear what that would look
- * like.
+ * Maximum number of changes kept in memory, per transaction. This used to be
+ * the spill-to-disk threshold; nowadays eviction is driven by the memory
+ * accounting in ReorderBufferCheckMemoryLimit(), and this constant merely
+ * limits how many spilled changes we restore into memory in one batch.
  */
 static const Size max_changes_in_memory = 4096;
 
+/*
+ * Changes whose variable-length data is at least this large get LZ4
+ * compressed when spilled to disk.  Smaller payloads aren't worth the cycles
+ * and can easily expand rather than shrink.
+ */
+#define REORDER_BUFFER_COMPRESS_THRESHOLD 512
+
+/*
+ * Size of the write-combining buffer used while spilling; individual changes
+ * are accumulated here so that spill files are written in large chunks
+ * instead of one write() per change.
+ */
+#define REORDER_BUFFER_SPILL_BUFFER_SIZE (64 * 1024)
+
 /* ---------------------------------------
  * primary reorderbuffer support routines
  * ---------------------------------------
@@ -184,15 +202,28 @@ static void ReorderBufferIterTXNFinish(ReorderBuffer *rb,
 									   ReorderBufferIterTXNState *state);
 static void ReorderBufferExecuteInvalidations(ReorderBuffer *rb, ReorderBufferTXN *txn);
 
+/* ---------------------------------------
+ * streaming of in-progress transactions
+ * ---------------------------------------
+ */
+static bool ReorderBufferCanStream(ReorderBuffer *rb);
+static bool ReorderBufferTXNIsStreamable(ReorderBuffer *rb, ReorderBufferTXN *txn);
+static ReorderBufferTXN *ReorderBufferLargestStreamableTopTXN(ReorderBuffer *rb);
+static void ReorderBufferStreamTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
+static void ReorderBufferTruncateTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
+
 /*
  * ---------------------------------------
  * Disk serialization support functions
  * ---------------------------------------
  */
-static void ReorderBufferCheckSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
 static void ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn);
 static void ReorderBufferSerializeChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
 										 int fd, ReorderBufferChange *change);
+static void ReorderBufferSpillWrite(ReorderBuffer *rb, ReorderBufferTXN *txn,
+									int fd, const char *data, Size size);
+static void ReorderBufferSpillFlush(ReorderBuffer *rb, ReorderBufferTXN *txn,
+									int fd);
 static Size ReorderBufferRestoreChanges(ReorderBuffer *rb, ReorderBufferTXN *txn,
 										int *fd, XLogSegNo *segno);
 static void ReorderBufferRestoreChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
@@ -217,6 +248,17 @@ static void ReorderBufferToastReplace(ReorderBuffer *rb, ReorderBufferTXN *txn,
 static void ReorderBufferToastAppendChunk(ReorderBuffer *rb, ReorderBufferTXN *txn,
 										  Relation relation, ReorderBufferChange *change);
 
+/* ---------------------------------------
+ * memory accounting
+ * ---------------------------------------
+ */
+static Size ReorderBufferChangeSize(ReorderBufferChange *change);
+static void ReorderBufferChangeMemoryUpdate(ReorderBuffer *rb,
+											ReorderBufferChange *change,
+											bool addition);
+static void ReorderBufferCheckMemoryLimit(ReorderBuffer *rb);
+static ReorderBufferTXN *ReorderBufferLargestTXN(ReorderBuffer *rb);
+
 
 /*
  * Allocate a new ReorderBuffer and clean out any old serialized state from
@@ -269,6 +311,11 @@ ReorderBufferAllocate(void)
 
 	buffer->outbuf = NULL;
 	buffer->outbufsize = 0;
+	buffer->compressbuf = NULL;
+	buffer->compressbufsize = 0;
+	buffer->spillbuf = NULL;
+	buffer->spillbuf_used = 0;
+	buffer->size = 0;
 
 	buffer->current_restart_decoding_lsn = InvalidXLogRecPtr;
 
@@ -374,6 +421,9 @@ ReorderBufferGetChange(ReorderBuffer *rb)
 void
 ReorderBufferReturnChange(ReorderBuffer *rb, ReorderBufferChange *change)
 {
+	/* update memory accounting info */
+	ReorderBufferChangeMemoryUpdate(rb, change, false);
+
 	/* free contained data */
 	switch (change->action)
 	{
@@ -573,6 +623,123 @@ ReorderBufferTXNByXid(ReorderBuffer *rb, TransactionId xid, bool create,
 	return txn;
 }
 
+/*
+ * Compute the size of a change in memory, for the purposes of memory
+ * accounting.  This must stay in sync with the way ReorderBufferSerializeChange
+ * computes the on-disk size of a change.
+ */
+static Size
+ReorderBufferChangeSize(ReorderBufferChange *change)
+{
+	Size		sz = sizeof(ReorderBufferChange);
+
+	switch (change->action)
+	{
+			/* fall through these, they're all similar enough */
+		case REORDER_BUFFER_CHANGE_INSERT:
+		case REORDER_BUFFER_CHANGE_UPDATE:
+		case REORDER_BUFFER_CHANGE_DELETE:
+		case REORDER_BUFFER_CHANGE_INTERNAL_SPEC_INSERT:
+			{
+				ReorderBufferTupleBuf *oldtup,
+						   *newtup;
+
+				oldtup = change->data.tp.oldtuple;
+				newtup = change->data.tp.newtuple;
+
+				if (oldtup)
+				{
+					sz += sizeof(HeapTupleData);
+					sz += oldtup->tuple.t_len;
+				}
+
+				if (newtup)
+				{
+					sz += sizeof(HeapTupleData);
+					sz += newtup->tuple.t_len;
+				}
+
+				break;
+			}
+		case REORDER_BUFFER_CHANGE_MESSAGE:
+			{
+				Size		prefix_size = strlen(change->data.msg.prefix) + 1;
+
+				sz += prefix_size + change->data.msg.message_size +
+					sizeof(Size) + sizeof(Size);
+
+				break;
+			}
+		case REORDER_BUFFER_CHANGE_INTERNAL_SNAPSHOT:
+			{
+				Snapshot	snap;
+
+				snap = change->data.snapshot;
+
+				sz += sizeof(SnapshotData) +
+					sizeof(TransactionId) * snap->xcnt +
+					sizeof(TransactionId) * snap->subxcnt;
+
+				break;
+			}
+		case REORDER_BUFFER_CHANGE_TRUNCATE:
+			{
+				sz += sizeof(Oid) * change->data.truncate.nrelids;
+
+				break;
+			}
+		case REORDER_BUFFER_CHANGE_INTERNAL_SPEC_CONFIRM:
+		case REORDER_BUFFER_CHANGE_INTERNAL_COMMAND_ID:
+		case REORDER_BUFFER_CHANGE_INTERNAL_TUPLECID:
+			/* ReorderBufferChange contains everything important */
+			break;
+	}
+
+	return sz;
+}
+
+/*
+ * Update memory counters to account for the new or removed change.
+ *
+ * We update two counters - in the reorder buffer, and in the transaction
+ * containing the change.  The reorder buffer counter allows us to quickly
+ * decide if we reached the memory limit, the transaction counter allows
+ * us to quickly pick the largest transaction for eviction.
+ */
+static void
+ReorderBufferChangeMemoryUpdate(ReorderBuffer *rb,
+								ReorderBufferChange *change,
+								bool addition)
+{
+	Size		sz;
+	ReorderBufferTXN *txn;
+
+	Assert(change->txn);
+
+	/*
+	 * Ignore tuple CID changes, because those are not evicted when reaching
+	 * memory limit.  So we just don't count them, because it might easily
+	 * trigger a pointless attempt to spill.
+	 */
+	if (change->action == REORDER_BUFFER_CHANGE_INTERNAL_TUPLECID)
+		return;
+
+	txn = change->txn;
+	sz = ReorderBufferChangeSize(change);
+
+	if (addition)
+	{
+		txn->size += sz;
+		rb->size += sz;
+	}
+	else
+	{
+		Assert((rb->size >= sz) && (txn->size >= sz));
+		txn->size -= sz;
+		rb->size -= sz;
+	}
+}
+
 /*
  * Queue a change into a transaction so it can be replayed upon commit.
  */
@@ -585,12 +752,18 @@ ReorderBufferQueueChange(ReorderBuffer *rb, TransactionId xid, XLogRecPtr lsn,
 	txn = ReorderBufferTXNByXid(rb, xid, true, NULL, lsn, true);
 
 	change->lsn = lsn;
+	change->txn = txn;
+
 	Assert(InvalidXLogRecPtr != lsn);
 	dlist_push_tail(&txn->changes, &change->node);
 	txn->nentries++;
 	txn->nentries_mem++;
 
-	ReorderBufferCheckSerializeTXN(rb, txn);
+	/* update memory accounting information */
+	ReorderBufferChangeMemoryUpdate(rb, change, true);
+
+	/* check the memory limits and evict something if necessary */
+	ReorderBufferCheckMemoryLimit(rb);
 }
 
 /*
@@ -1242,6 +1415,15 @@ ReorderBufferCleanupTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 		dlist_delete(&txn->base_snapshot_node);
 	}
 
+	/*
+	 * Cleanup the snapshot remembered for the next streaming run, if any.
+	 */
+	if (txn->snapshot_now != NULL)
+	{
+		Assert(txn->snapshot_now->copied);
+		ReorderBufferFreeSnap(rb, txn->snapshot_now);
+	}
+
 	/*
 	 * Remove TXN from its containing list.
 	 *
@@ -1267,6 +1449,74 @@ ReorderBufferCleanupTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 	ReorderBufferReturnTXN(rb, txn);
 }
 
+/*
+ * Discard changes from a transaction (and subtransactions), after streaming
+ * them to the output plugin.  We do not cleanup the transaction itself - it
+ * is still in progress, and further changes may yet be queued for it.
+ *
+ * The toast hash is deliberately kept around: toast chunks queued before the
+ * tuple referencing them may have already been moved there by the streamed
+ * run, and are still needed to reassemble that tuple later on.
+ */
+static void
+ReorderBufferTruncateTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
+{
+	dlist_mutable_iter iter;
+
+	/* cleanup subtransactions & their changes */
+	dlist_foreach_modify(iter, &txn->subtxns)
+	{
+		ReorderBufferTXN *subtxn;
+
+		subtxn = dlist_container(ReorderBufferTXN, node, iter.cur);
+
+		/*
+		 * Subtransactions are always associated to the toplevel TXN, even if
+		 * they originally were happening inside another subtxn, so we won't
+		 * ever recurse more than one level deep here.
+		 */
+		Assert(subtxn->is_known_as_subxact);
+		Assert(subtxn->nsubtxns == 0);
+
+		ReorderBufferTruncateTXN(rb, subtxn);
+	}
+
+	/* cleanup changes in the txn */
+	dlist_foreach_modify(iter, &txn->changes)
+	{
+		ReorderBufferChange *change;
+
+		change = dlist_container(ReorderBufferChange, node, iter.cur);
+
+		/* remove the change from its containing list */
+		dlist_delete(&change->node);
+
+		ReorderBufferReturnChange(rb, change);
+	}
+
+	/*
+	 * Mark the transaction as streamed.
+	 *
+	 * The toplevel transaction is marked as streamed always, even if it does
+	 * not contain any changes (that is, when all the changes are in
+	 * subtransactions).
+	 *
+	 * For subtransactions, we only mark them as streamed when there are
+	 * changes in them.
+	 *
+	 * We do it this way because of aborts - we don't want to send aborts for
+	 * XIDs the downstream is not aware of. And of course, it always knows
+	 * about the toplevel xact (we send the XID in all messages), but we never
+	 * stream XIDs of empty subxacts.
+	 */
+	if ((!txn->is_known_as_subxact) || (txn->nentries_mem != 0))
+		txn->streamed = true;
+
+	/* also reset the number of entries in the transaction */
+	txn->nentries_mem = 0;
+	txn->nentries = 0;
+}
+
 /*
  * Build a hash with a (relfilenode, ctid) -> (cmin, cmax) mapping for use by
  * HeapTupleSatisfiesHistoricMVCC.
@@ -1424,51 +1674,24 @@ ReorderBufferFreeSnap(ReorderBuffer *rb, Snapshot snap)
  * ReorderBufferCommitChild(), even if previously assigned to the toplevel
  * transaction with ReorderBufferAssignChild.
  *
- * We currently can only decode a transaction's contents when its commit
- * record is read because that's the only place where we know about cache
- * invalidations. Thus, once a toplevel commit is read, we iterate over the top
- * and subtransactions (using a k-way merge) and replay the changes in lsn
- * order.
+ * This interface is called once at commit to replay the whole transaction,
+ * and any number of times from ReorderBufferStreamTXN() to incrementally
+ * stream the changes accumulated so far for an in-progress transaction.  In
+ * the streaming case the apply callbacks are replaced by their stream_*
+ * counterparts, and instead of cleaning the transaction up at the end we
+ * merely discard the changes that have been sent, keeping the transaction
+ * itself (and the snapshot/command id state needed to continue) around.
  */
-void
-ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
-					XLogRecPtr commit_lsn, XLogRecPtr end_lsn,
-					TimestampTz commit_time,
-					RepOriginId origin_id, XLogRecPtr origin_lsn)
+static void
+ReorderBufferProcessTXN(ReorderBuffer *rb, ReorderBufferTXN *txn,
+						XLogRecPtr commit_lsn,
+						volatile Snapshot snapshot_now,
+						volatile CommandId command_id,
+						bool streaming)
 {
-	ReorderBufferTXN *txn;
-	volatile Snapshot snapshot_now;
-	volatile CommandId command_id = FirstCommandId;
 	bool		using_subtxn;
 	ReorderBufferIterTXNState *volatile iterstate = NULL;
-
-	txn = ReorderBufferTXNByXid(rb, xid, false, NULL, InvalidXLogRecPtr,
-								false);
-
-	/* unknown transaction, nothing to replay */
-	if (txn == NULL)
-		return;
-
-	txn->final_lsn = commit_lsn;
-	txn->end_lsn = end_lsn;
-	txn->commit_time = commit_time;
-	txn->origin_id = origin_id;
-	txn->origin_lsn = origin_lsn;
-
-	/*
-	 * If this transaction has no snapshot, it didn't make any changes to the
-	 * database, so there's nothing to decode.  Note that
-	 * ReorderBufferCommitChild will have transferred any snapshots from
-	 * subtransactions if there were any.
-	 */
-	if (txn->base_snapshot == NULL)
-	{
-		Assert(txn->ninvalidations == 0);
-		ReorderBufferCleanupTXN(rb, txn);
-		return;
-	}
-
-	snapshot_now = txn->base_snapshot;
+	XLogRecPtr	last_lsn = txn->first_lsn;
 
 	/* build data to be able to lookup the CommandIds of catalog tuples */
 	ReorderBufferBuildTupleCidHash(rb, txn);
@@ -1494,11 +1717,14 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 		ReorderBufferChange *specinsert = NULL;
 
 		if (using_subtxn)
-			BeginInternalSubTransaction("replay");
+			BeginInternalSubTransaction(streaming ? "stream" : "replay");
 		else
 			StartTransactionCommand();
 
-		rb->begin(rb, txn);
+		if (streaming)
+			rb->stream_start(rb, txn, txn->first_lsn);
+		else
+			rb->begin(rb, txn);
 
 		iterstate = ReorderBufferIterTXNInit(rb, txn);
 		while ((change = ReorderBufferIterTXNNext(rb, iterstate)) != NULL)
@@ -1506,6 +1732,8 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 			Relation	relation = NULL;
 			Oid			reloid;
 
+			last_lsn = change->lsn;
+
 			switch (change->action)
 			{
 				case REORDER_BUFFER_CHANGE_INTERNAL_SPEC_CONFIRM:
@@ -1582,7 +1810,10 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 					if (!IsToastRelation(relation))
 					{
 						ReorderBufferToastReplace(rb, txn, relation, change);
-						rb->apply_change(rb, txn, relation, change);
+						if (streaming)
+							rb->stream_change(rb, txn, relation, change);
+						else
+							rb->apply_change(rb, txn, relation, change);
 
 						/*
 						 * Only clear reassembled toast chunks if we're sure
@@ -1680,7 +1911,10 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 							relations[nrelations++] = relation;
 						}
 
-						rb->apply_truncate(rb, txn, nrelations, relations, change);
+						if (streaming)
+							rb->stream_truncate(rb, txn, nrelations, relations, change);
+						else
+							rb->apply_truncate(rb, txn, nrelations, relations, change);
 
 						for (i = 0; i < nrelations; i++)
 							RelationClose(relations[i]);
@@ -1689,10 +1923,16 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 					}
 
 				case REORDER_BUFFER_CHANGE_MESSAGE:
-					rb->message(rb, txn, change->lsn, true,
-								change->data.msg.prefix,
-								change->data.msg.message_size,
-								change->data.msg.message);
+					if (streaming)
+						rb->stream_message(rb, txn, change->lsn, true,
+										   change->data.msg.prefix,
+										   change->data.msg.message_size,
+										   change->data.msg.message);
+					else
+						rb->message(rb, txn, change->lsn, true,
+									change->data.msg.prefix,
+									change->data.msg.message_size,
+									change->data.msg.message);
 					break;
 
 				case REORDER_BUFFER_CHANGE_INTERNAL_SNAPSHOT:
@@ -1778,8 +2018,11 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 		ReorderBufferIterTXNFinish(rb, iterstate);
 		iterstate = NULL;
 
-		/* call commit callback */
-		rb->commit(rb, txn, commit_lsn);
+		/* call commit or stream_stop callback, as appropriate */
+		if (streaming)
+			rb->stream_stop(rb, txn, last_lsn);
+		else
+			rb->commit(rb, txn, commit_lsn);
 
 		/* this is just a sanity check against bad output plugin behaviour */
 		if (GetCurrentTransactionIdIfAny() != InvalidTransactionId)
@@ -1803,11 +2046,32 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 		if (using_subtxn)
 			RollbackAndReleaseCurrentSubTransaction();
 
-		if (snapshot_now->copied)
-			ReorderBufferFreeSnap(rb, snapshot_now);
+		if (streaming)
+		{
+			/*
+			 * Remember the snapshot and command id as of the end of this run,
+			 * so the next run can continue where we left off, and discard the
+			 * changes we have just sent downstream.
+			 */
+			txn->command_id = command_id;
 
-		/* remove potential on-disk data, and deallocate */
-		ReorderBufferCleanupTXN(rb, txn);
+			/* Avoid copying if it's already copied. */
+			if (snapshot_now->copied)
+				txn->snapshot_now = snapshot_now;
+			else
+				txn->snapshot_now = ReorderBufferCopySnap(rb, snapshot_now,
+														  txn, command_id);
+
+			ReorderBufferTruncateTXN(rb, txn);
+		}
+		else
+		{
+			if (snapshot_now->copied)
+				ReorderBufferFreeSnap(rb, snapshot_now);
+
+			/* remove potential on-disk data, and deallocate */
+			ReorderBufferCleanupTXN(rb, txn);
+		}
 	}
 	PG_CATCH();
 	{
@@ -1840,6 +2104,101 @@ ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
 	PG_END_TRY();
 }
 
+/*
+ * Commit a transaction.
+ *
+ * See comments for ReorderBufferProcessTXN(). If parts of the transaction
+ * have already been streamed to the output plugin, we only need to send the
+ * remaining changes and let the plugin know the transaction committed.
+ */
+void
+ReorderBufferCommit(ReorderBuffer *rb, TransactionId xid,
+					XLogRecPtr commit_lsn, XLogRecPtr end_lsn,
+					TimestampTz commit_time,
+					RepOriginId origin_id, XLogRecPtr origin_lsn)
+{
+	ReorderBufferTXN *txn;
+
+	txn = ReorderBufferTXNByXid(rb, xid, false, NULL, InvalidXLogRecPtr,
+								false);
+
+	/* unknown transaction, nothing to replay */
+	if (txn == NULL)
+		return;
+
+	txn->final_lsn = commit_lsn;
+	txn->end_lsn = end_lsn;
+	txn->commit_time = commit_time;
+	txn->origin_id = origin_id;
+	txn->origin_lsn = origin_lsn;
+
+	/*
+	 * If the transaction was (partially) streamed before, stream whatever is
+	 * left and tell the plugin to commit the already-streamed changes.
+	 */
+	if (txn->streamed)
+	{
+		ReorderBufferStreamTXN(rb, txn);
+		rb->stream_commit(rb, txn, commit_lsn);
+		ReorderBufferCleanupTXN(rb, txn);
+		return;
+	}
+
+	/*
+	 * If this transaction has no snapshot, it didn't make any changes to the
+	 * database, so there's nothing to decode.  Note that
+	 * ReorderBufferCommitChild will have transferred any snapshots from
+	 * subtransactions if there were any.
+	 */
+	if (txn->base_snapshot == NULL)
+	{
+		Assert(txn->ninvalidations == 0);
+		ReorderBufferCleanupTXN(rb, txn);
+		return;
+	}
+
+	ReorderBufferProcessTXN(rb, txn, commit_lsn, txn->base_snapshot,
+							FirstCommandId, false);
+}
+
+/*
+ * Stream the changes accumulated so far for an in-progress transaction to
+ * the output plugin.
+ *
+ * Subsequent runs continue where the previous one left off, using the
+ * snapshot and command id remembered at the end of the last run.
+ */
+static void
+ReorderBufferStreamTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
+{
+	Snapshot	snapshot_now;
+	CommandId	command_id;
+
+	/* We can never reach here for a subtransaction. */
+	Assert(!txn->is_known_as_subxact);
+
+	if (txn->streamed)
+	{
+		/* Continue where the previous streaming run left off. */
+		Assert(txn->snapshot_now != NULL);
+		snapshot_now = txn->snapshot_now;
+		command_id = txn->command_id;
+
+		/* ProcessTXN below takes over the reference. */
+		txn->snapshot_now = NULL;
+	}
+	else
+	{
+		/* First streaming run for this transaction. */
+		Assert(txn->base_snapshot != NULL);
+		snapshot_now = txn->base_snapshot;
+		command_id = FirstCommandId;
+	}
+
+	ReorderBufferProcessTXN(rb, txn, InvalidXLogRecPtr, snapshot_now,
+							command_id, true);
+}
+
 /*
  * Abort a transaction that possibly has previous changes. Needs to be first
  * called for subtransactions and then for the toplevel xid.
@@ -1867,6 +2226,10 @@ ReorderBufferAbort(ReorderBuffer *rb, TransactionId xid, XLogRecPtr lsn)
 	/* cosmetic... */
 	txn->final_lsn = lsn;
 
+	/* the downstream has to discard changes streamed so far */
+	if (txn->streamed)
+		rb->stream_abort(rb, txn, lsn);
+
 	/* remove potential on-disk data, and deallocate */
 	ReorderBufferCleanupTXN(rb, txn);
 }
@@ -1915,6 +2278,10 @@ ReorderBufferAbortOld(ReorderBuffer *rb, TransactionId oldestRunningXid)
 
 			elog(DEBUG2, "aborting old transaction %u", txn->xid);
 
+			/* the downstream has to discard changes streamed so far */
+			if (txn->streamed)
+				rb->stream_abort(rb, txn, txn->final_lsn);
+
 			/* remove potential on-disk data, and deallocate this tx */
 			ReorderBufferCleanupTXN(rb, txn);
 		}
@@ -1951,6 +2318,13 @@ ReorderBufferForget(ReorderBuffer *rb, TransactionId xid, XLogRecPtr lsn)
 	/* cosmetic... */
 	txn->final_lsn = lsn;
 
+	/*
+	 * The transaction may have been streamed before we learned that we're not
+	 * interested in it; if so the downstream has to discard those changes.
+	 */
+	if (txn->streamed)
+		rb->stream_abort(rb, txn, lsn);
+
 	/*
 	 * Process cache invalidation messages if there are any. Even if we're not
 	 * interested in the transaction's contents, it could have manipulated the
@@ -2103,6 +2477,7 @@ ReorderBufferAddNewTupleCids(ReorderBuffer *rb, TransactionId xid,
 	change->data.tuplecid.cmax = cmax;
 	change->data.tuplecid.combocid = combocid;
 	change->lsn = lsn;
+	change->txn = txn;
 	change->action = REORDER_BUFFER_CHANGE_INTERNAL_TUPLECID;
 
 	dlist_push_tail(&txn->tuplecids, &change->node);
@@ -2230,19 +2605,220 @@ ReorderBufferSerializeReserve(ReorderBuffer *rb, Size sz)
 }
 
 /*
- * Check whether the transaction tx should spill its data to disk.
+ * Find the largest transaction (toplevel or subxact) to evict (spill to disk).
+ *
+ * XXX With many subtransactions this might be quite slow, because we'll have
+ * to walk through all of them.  There are some options how we could improve
+ * that: (a) maintain some secondary structure with transactions sorted by
+ * amount of changes, (b) not looking for the entirely largest transaction,
+ * but e.g. for transaction using at least some fraction of the memory limit,
+ * and (c) evicting multiple transactions at once, e.g. to free a given portion
+ * of the memory limit (e.g. 50%).
+ */
+static ReorderBufferTXN *
+ReorderBufferLargestTXN(ReorderBuffer *rb)
+{
+	HASH_SEQ_STATUS hash_seq;
+	ReorderBufferTXNByIdEnt *ent;
+	ReorderBufferTXN *largest = NULL;
+
+	hash_seq_init(&hash_seq, rb->by_txn);
+	while ((ent = hash_seq_search(&hash_seq)) != NULL)
+	{
+		ReorderBufferTXN *txn = ent->txn;
+
+		/* if the current transaction is larger, remember it */
+		if ((!largest) || (txn->size > largest->size))
+			largest = txn;
+	}
+
+	Assert(largest);
+	Assert(largest->size > 0);
+	Assert(largest->size <= rb->size);
+
+	return largest;
+}
+
+/*
+ * Check whether the output plugin supports streaming of in-progress
+ * transactions.
+ */
+static bool
+ReorderBufferCanStream(ReorderBuffer *rb)
+{
+	LogicalDecodingContext *ctx = rb->private_data;
+
+	return ctx->streaming;
+}
+
+/*
+ * Check whether a (toplevel) transaction is suitable for streaming.
+ *
+ * We only stream transactions that don't modify the catalog: their decoding
+ * needs nothing but the committed catalog state, so we neither need to detect
+ * concurrent aborts while accessing the catalog, nor replay any of the
+ * transaction's own catalog changes.  We also refuse transactions that have
+ * already been spilled to disk - streaming them would replay the serialized
+ * changes a second time at commit.
+ */
+static bool
+ReorderBufferTXNIsStreamable(ReorderBuffer *rb, ReorderBufferTXN *txn)
+{
+	dlist_iter	iter;
+	Size		nentries_mem = txn->nentries_mem;
+
+	/* without a base snapshot there's nothing we could stream yet */
+	if (txn->base_snapshot == NULL)
+		return false;
+
+	if (txn->has_catalog_changes || txn->serialized)
+		return false;
+
+	/*
+	 * Never cut off an unconfirmed speculative insertion - the confirmation
+	 * (or the superseding insertion) has to be applied together with it.
+	 */
+	if (txn->nentries_mem > 0)
+	{
+		ReorderBufferChange *change =
+		dlist_tail_element(ReorderBufferChange, node, &txn->changes);
+
+		if (change->action == REORDER_BUFFER_CHANGE_INTERNAL_SPEC_INSERT)
+			return false;
+	}
+
+	dlist_foreach(iter, &txn->subtxns)
+	{
+		ReorderBufferTXN *subtxn;
+
+		subtxn = dlist_container(ReorderBufferTXN, node, iter.cur);
+
+		if (subtxn->has_catalog_changes || subtxn->serialized)
+			return false;
+
+		if (subtxn->nentries_mem > 0)
+		{
+			ReorderBufferChange *change =
+			dlist_tail_element(ReorderBufferChange, node, &subtxn->changes);
+
+			if (change->action == REORDER_BUFFER_CHANGE_INTERNAL_SPEC_INSERT)
+				return false;
+		}
+
+		nentries_mem += subtxn->nentries_mem;
+	}
+
+	/* streaming an empty transaction would accomplish nothing */
+	return nentries_mem > 0;
+}
+
+/*
+ * Find the largest streamable toplevel transaction to evict (by streaming).
+ *
+ * Unlike ReorderBufferLargestTXN() this only considers toplevel transactions
+ * (we can't stream a subtransaction on its own), and sizes them including
+ * their subtransactions.
+ */
+static ReorderBufferTXN *
+ReorderBufferLargestStreamableTopTXN(ReorderBuffer *rb)
+{
+	dlist_iter	iter;
+	ReorderBufferTXN *largest = NULL;
+	Size		largest_size = 0;
+
+	dlist_foreach(iter, &rb->toplevel_by_lsn)
+	{
+		ReorderBufferTXN *txn;
+		dlist_iter	subtxn_i;
+		Size		size;
+
+		txn = dlist_container(ReorderBufferTXN, node, iter.cur);
+
+		size = txn->size;
+		dlist_foreach(subtxn_i, &txn->subtxns)
+		{
+			ReorderBufferTXN *subtxn;
+
+			subtxn = dlist_container(ReorderBufferTXN, node, subtxn_i.cur);
+			size += subtxn->size;
+		}
+
+		if (size > largest_size && ReorderBufferTXNIsStreamable(rb, txn))
+		{
+			largest = txn;
+			largest_size = size;
+		}
+	}
+
+	return largest;
+}
+
+/*
+ * Check whether the logical_decoding_work_mem limit was reached, and if yes
+ * pick the largest transaction at-a-time to evict until we reach under the
+ * memory limit.  If the output plugin supports it and the transaction is
+ * eligible, evict by streaming its changes downstream; otherwise spill its
+ * changes to disk.
+ *
+ * Evicting the largest transaction first frees the most memory per eviction
+ * and keeps many small transactions decodable without ever touching disk.
  */
 static void
-ReorderBufferCheckSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
+ReorderBufferCheckMemoryLimit(ReorderBuffer *rb)
 {
+	ReorderBufferTXN *txn;
+
+	/* bail out if we haven't exceeded the memory limit */
+	if (rb->size < logical_decoding_work_mem * 1024L)
+		return;
+
 	/*
-	 * TODO: improve accounting so we cheaply can take subtransactions into
-	 * account here.
+	 * Loop until we reach under the memory limit.  One might think that just
+	 * by evicting the largest (sub)transaction we will come under the memory
+	 * limit based on assumption that the selected transaction is at least as
+	 * large as the most recent change (which caused us to go over the memory
+	 * limit). However, that is not true because a user can reduce the
+	 * logical_decoding_work_mem to a smaller value before the most recent
+	 * change.
 	 */
-	if (txn->nentries_mem >= max_changes_in_memory)
+	while (rb->size >= logical_decoding_work_mem * 1024L)
 	{
-		ReorderBufferSerializeTXN(rb, txn);
+		Size		size_before = rb->size;
+
+		if (ReorderBufferCanStream(rb) &&
+			(txn = ReorderBufferLargestStreamableTopTXN(rb)) != NULL)
+		{
+			/*
+			 * Stream the largest eligible toplevel transaction, discarding
+			 * its changes once they've been sent downstream.
+			 */
+			ReorderBufferStreamTXN(rb, txn);
+		}
+		else
+		{
+			/*
+			 * Pick the largest transaction (or subtransaction) and evict it
+			 * from memory by serializing it to disk.
+			 */
+			txn = ReorderBufferLargestTXN(rb);
+
+			ReorderBufferSerializeTXN(rb, txn);
+		}
+
+		/*
+		 * After eviction, the transaction should have no entries in memory.
+		 * It may still account for a small amount of memory, though: toast
+		 * chunks whose main tuple has not arrived yet are carried over in the
+		 * toast hash rather than evicted.
+		 */
 		Assert(txn->nentries_mem == 0);
+
+		/*
+		 * If the eviction didn't free any memory (e.g. everything left is
+		 * carried-over toast chunks), give up rather than loop forever.
+		 */
+		if (rb->size >= size_before)
+			break;
 	}
 }
 
@@ -2287,7 +2863,10 @@ ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 			char		path[MAXPGPATH];
 
 			if (fd != -1)
+			{
+				ReorderBufferSpillFlush(rb, txn, fd);
 				CloseTransientFile(fd);
+			}
 
 			XLByteToSeg(change->lsn, curOpenSegNo, wal_segment_size);
 
@@ -2321,7 +2900,85 @@ ReorderBufferSerializeTXN(ReorderBuffer *rb, ReorderBufferTXN *txn)
 	txn->serialized = true;
 
 	if (fd != -1)
+	{
+		ReorderBufferSpillFlush(rb, txn, fd);
 		CloseTransientFile(fd);
+	}
+}
+
+/*
+ * Append data destined for a spill file to the write-combining buffer,
+ * flushing it to disk whenever it fills up.  Data larger than the buffer
+ * itself is written out directly.
+ */
+static void
+ReorderBufferSpillWrite(ReorderBuffer *rb, ReorderBufferTXN *txn,
+						int fd, const char *data, Size size)
+{
+	if (rb->spillbuf == NULL)
+		rb->spillbuf = MemoryContextAlloc(rb->context,
+										  REORDER_BUFFER_SPILL_BUFFER_SIZE);
+
+	/* flush whatever we have if the new data doesn't fit anymore */
+	if (rb->spillbuf_used + size > REORDER_BUFFER_SPILL_BUFFER_SIZE)
+		ReorderBufferSpillFlush(rb, txn, fd);
+
+	if (size >= REORDER_BUFFER_SPILL_BUFFER_SIZE)
+	{
+		/* oversized entry, write it out directly */
+		errno = 0;
+		pgstat_report_wait_start(WAIT_EVENT_REORDER_BUFFER_WRITE);
+		if (write(fd, data, size) != size)
+		{
+			int			save_errno = errno;
+
+			CloseTransientFile(fd);
+
+			/* if write didn't set errno, assume problem is no disk space */
+			errno = save_errno ? save_errno : ENOSPC;
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not write to data file for XID %u: %m",
+							txn->xid)));
+		}
+		pgstat_report_wait_end();
+	}
+	else
+	{
+		memcpy(rb->spillbuf + rb->spillbuf_used, data, size);
+		rb->spillbuf_used += size;
+	}
+}
+
+/*
+ * Write out the contents of the spill write-combining buffer.
+ */
+static void
+ReorderBufferSpillFlush(ReorderBuffer *rb, ReorderBufferTXN *txn, int fd)
+{
+	if (rb->spillbuf_used == 0)
+		return;
+
+	errno = 0;
+	pgstat_report_wait_start(WAIT_EVENT_REORDER_BUFFER_WRITE);
+	if (write(fd, rb->spillbuf, rb->spillbuf_used) != rb->spillbuf_used)
+	{
+		int			save_errno = errno;
+
+		/* discard the buffered data, it has no other place to go */
+		rb->spillbuf_used = 0;
+		CloseTransientFile(fd);
+
+		/* if write didn't set errno, assume problem is no disk space */
+		errno = save_errno ? save_errno : ENOSPC;
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write to data file for XID %u: %m",
+						txn->xid)));
+	}
+	pgstat_report_wait_end();
+
+	rb->spillbuf_used = 0;
 }
 
 /*
@@ -2491,23 +3148,51 @@ ReorderBufferSerializeChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
 	}
 
 	ondisk->size = sz;
+	ondisk->raw_size = sz;
 
-	errno = 0;
-	pgstat_report_wait_start(WAIT_EVENT_REORDER_BUFFER_WRITE);
-	if (write(fd, rb->outbuf, ondisk->size) != ondisk->size)
+#ifdef USE_LZ4
 	{
-		int			save_errno = errno;
+		Size		datalen = sz - sizeof(ReorderBufferDiskChange);
 
-		CloseTransientFile(fd);
+		/*
+		 * Try to compress the variable-length portion of the change.  If that
+		 * doesn't save anything, store it uncompressed; the header records
+		 * which case applies (size != raw_size means compressed).  The spill
+		 * files are private to this walsender run, so there are no on-disk
+		 * compatibility concerns.
+		 */
+		if (datalen >= REORDER_BUFFER_COMPRESS_THRESHOLD &&
+			datalen <= (Size) LZ4_MAX_INPUT_SIZE)
+		{
+			Size		bound = LZ4_compressBound(datalen);
+			int			complen;
 
-		/* if write didn't set errno, assume problem is no disk space */
-		errno = save_errno ? save_errno : ENOSPC;
-		ereport(ERROR,
-				(errcode_for_file_access(),
-				 errmsg("could not write to data file for XID %u: %m",
-						txn->xid)));
+			if (rb->compressbuf == NULL)
+			{
+				rb->compressbuf = MemoryContextAlloc(rb->context, bound);
+				rb->compressbufsize = bound;
+			}
+			else if (rb->compressbufsize < bound)
+			{
+				rb->compressbuf = repalloc(rb->compressbuf, bound);
+				rb->compressbufsize = bound;
+			}
+
+			complen = LZ4_compress_default(rb->outbuf + sizeof(ReorderBufferDiskChange),
+										   rb->compressbuf,
+										   datalen, bound);
+
+			if (complen > 0 && complen < datalen)
+			{
+				memcpy(rb->outbuf + sizeof(ReorderBufferDiskChange),
+					   rb->compressbuf, complen);
+				ondisk->size = sizeof(ReorderBufferDiskChange) + complen;
+			}
+		}
 	}
-	pgstat_report_wait_end();
+#endif
+
+	ReorderBufferSpillWrite(rb, txn, fd, rb->outbuf, ondisk->size);
 
 	Assert(ondisk->change.action == change->action);
 }
@@ -2628,10 +3313,55 @@ ReorderBufferRestoreChanges(ReorderBuffer *rb, ReorderBufferTXN *txn,
 							(uint32) (ondisk->size - sizeof(ReorderBufferDiskChange)))));
 
 		/*
-		 * ok, read a full change from disk, now restore it into proper
-		 * in-memory format
+		 * If the trailing data was compressed when spilled, decompress it
+		 * into the scratch buffer (preceded by a copy of the header) and
+		 * restore from there instead.
 		 */
-		ReorderBufferRestoreChange(rb, txn, rb->outbuf);
+		if (ondisk->raw_size != ondisk->size)
+		{
+#ifdef USE_LZ4
+			Size		complen = ondisk->size - sizeof(ReorderBufferDiskChange);
+			Size		rawlen = ondisk->raw_size - sizeof(ReorderBufferDiskChange);
+			int			decomplen;
+
+			if (rb->compressbuf == NULL)
+			{
+				rb->compressbuf = MemoryContextAlloc(rb->context,
+													 ondisk->raw_size);
+				rb->compressbufsize = ondisk->raw_size;
+			}
+			else if (rb->compressbufsize < ondisk->raw_size)
+			{
+				rb->compressbuf = repalloc(rb->compressbuf, ondisk->raw_size);
+				rb->compressbufsize = ondisk->raw_size;
+			}
+
+			memcpy(rb->compressbuf, rb->outbuf,
+				   sizeof(ReorderBufferDiskChange));
+
+			decomplen = LZ4_decompress_safe(rb->outbuf + sizeof(ReorderBufferDiskChange),
+											rb->compressbuf + sizeof(ReorderBufferDiskChange),
+											complen, rawlen);
+			if (decomplen < 0 || decomplen != rawlen)
+				ereport(ERROR,
+						(errcode(ERRCODE_DATA_CORRUPTED),
+						 errmsg("could not decompress change from reorderbuffer spill file")));
+
+			ReorderBufferRestoreChange(rb, txn, rb->compressbuf);
+#else
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("reorderbuffer spill file contains compressed data, but this build lacks LZ4 support")));
+#endif
+		}
+		else
+		{
+			/*
+			 * ok, read a full change from disk, now restore it into proper
+			 * in-memory format
+			 */
+			ReorderBufferRestoreChange(rb, txn, rb->outbuf);
+		}
 		restored++;
 	}
 
@@ -2784,6 +3514,17 @@ ReorderBufferRestoreChange(ReorderBuffer *rb, ReorderBufferTXN *txn,
 
 	dlist_push_tail(&txn->changes, &change->node);
 	txn->nentries_mem++;
+	change->txn = txn;
+
+	/*
+	 * Update memory accounting for the restored change.  We need to do this
+	 * although we don't check the memory limit when restoring the changes in
+	 * this branch (we only do that when initially queueing the changes).  We
+	 * will release the changes later, and that will update the accounting too
+	 * (subtracting the size from the counters).  And we don't want to
+	 * underflow there.
+	 */
+	ReorderBufferChangeMemoryUpdate(rb, change, true);
 }
 
 /*
@@ -3023,6 +3764,13 @@ ReorderBufferToastReplace(ReorderBuffer *rb, ReorderBufferTXN *txn,
 	if (txn->toast_hash == NULL)
 		return;
 
+	/*
+	 * We're going to modify the size of the change, so to make sure the
+	 * accounting is correct we'll make it look like we're removing the change
+	 * now (with the old size), and then re-add it at the end.
+	 */
+	ReorderBufferChangeMemoryUpdate(rb, change, false);
+
 	oldcontext = MemoryContextSwitchTo(rb->context);
 
 	/* we should only have toast tuples in an INSERT or UPDATE */
@@ -3172,6 +3920,9 @@ ReorderBufferToastReplace(ReorderBuffer *rb, ReorderBufferTXN *txn,
 	pfree(isnull);
 
 	MemoryContextSwitchTo(oldcontext);
+
+	/* subject the change to the memory accounting with its new size */
+	ReorderBufferChangeMemoryUpdate(rb, change, true);
 }
 
 /*
@@ -705,7 +705,6 @@ apply_handle_update(StringInfo s)
 	EvalPlanQualInit(&epqstate, estate, NULL, NIL, -1);
 
 	PushActiveSnapshot(GetTransactionSnapshot());
-	ExecOpenIndices(estate->es_result_relation_info, false);
 
 	/* Build the search tuple. */
 	oldctx = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
@@ -746,8 +745,16 @@ apply_handle_update(StringInfo s)
 
 		EvalPlanQualSetSlot(&epqstate, remoteslot);
 
+		/*
+		 * Only open the indexes now that we know the update will actually
+		 * happen; they are only needed to insert the new index entries.
+		 */
+		ExecOpenIndices(estate->es_result_relation_info, false);
+
 		/* Do the actual update. */
 		ExecSimpleRelationUpdate(estate, &epqstate, localslot, remoteslot);
+
+		ExecCloseIndices(estate->es_result_relation_info);
 	}
 	else
 	{
@@ -763,7 +770,6 @@ apply_handle_update(StringInfo s)
 	}
 
 	/* Cleanup. */
-	ExecCloseIndices(estate->es_result_relation_info);
 	PopActiveSnapshot();
 
 	/* Handle queued AFTER triggers. */
@@ -824,7 +830,12 @@ apply_handle_delete(StringInfo s)
 	EvalPlanQualInit(&epqstate, estate, NULL, NIL, -1);
 
 	PushActiveSnapshot(GetTransactionSnapshot());
-	ExecOpenIndices(estate->es_result_relation_info, false);
+
+	/*
+	 * There's no index maintenance to do for a delete (and the replica
+	 * identity lookup below opens the index it scans itself), so there's no
+	 * need for ExecOpenIndices here.
+	 */
 
 	/* Find the tuple using the replica identity index. */
 	oldctx = MemoryContextSwitchTo(GetPerTupleMemoryContext(estate));
@@ -864,7 +875,6 @@ apply_handle_delete(StringInfo s)
 	}
 
 	/* Cleanup. */
-	ExecCloseIndices(estate->es_result_relation_info);
 	PopActiveSnapshot();
 
 	/* Handle queued AFTER triggers. */
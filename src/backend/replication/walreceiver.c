@@ -74,6 +74,7 @@
 /* GUC variables */
 int			wal_receiver_status_interval;
 int			wal_receiver_timeout;
+int			wal_receiver_write_size;
 bool		hot_standby_feedback;
 
 /* libpqwalreceiver connection */
@@ -92,6 +93,18 @@ static TimeLineID recvFileTLI = 0;
 static XLogSegNo recvSegNo = 0;
 static uint32 recvOff = 0;
 
+/*
+ * Buffer used to coalesce small incoming WAL messages into larger writes,
+ * cutting down on write() calls when the primary sends many small chunks.
+ * Allocated lazily, with the size wal_receiver_write_size had at that point;
+ * a size of zero disables the buffering.  Buffered data is always written
+ * out before fsyncing or reporting positions to the primary.
+ */
+static char *recvWriteBuf = NULL;
+static Size recvWriteBufSize = 0;
+static Size recvWriteBufUsed = 0;
+static XLogRecPtr recvWriteBufStart = InvalidXLogRecPtr;
+
 /*
  * Flags set by interrupt handlers of walreceiver for later service in the
  * main loop.
@@ -117,6 +130,8 @@ static void WalRcvFetchTimeLineHistoryFiles(TimeLineID first, TimeLineID last);
 static void WalRcvWaitForStartPosition(XLogRecPtr *startpoint, TimeLineID *startpointTLI);
 static void WalRcvDie(int code, Datum arg);
 static void XLogWalRcvProcessMsg(unsigned char type, char *buf, Size len);
+static void XLogWalRcvQueueWrite(char *buf, Size nbytes, XLogRecPtr recptr);
+static void XLogWalRcvWriteQueued(void);
 static void XLogWalRcvWrite(char *buf, Size nbytes, XLogRecPtr recptr);
 static void XLogWalRcvFlush(bool dying);
 static void XLogWalRcvSendReply(bool force, bool requestReply);
@@ -851,7 +866,7 @@ XLogWalRcvProcessMsg(unsigned char type, char *buf, Size len)
 
 				buf += hdrlen;
 				len -= hdrlen;
-				XLogWalRcvWrite(buf, len, dataStart);
+				XLogWalRcvQueueWrite(buf, len, dataStart);
 				break;
 			}
 		case 'k':				/* Keepalive */
@@ -884,6 +899,72 @@ XLogWalRcvProcessMsg(unsigned char type, char *buf, Size len)
 	}
 }
 
+/*
+ * Queue XLOG data for writing, coalescing it into larger writes.
+ *
+ * Data that doesn't fit (or doesn't follow) what's buffered already, and
+ * chunks at least as large as the buffer, are written out directly.
+ */
+static void
+XLogWalRcvQueueWrite(char *buf, Size nbytes, XLogRecPtr recptr)
+{
+	/* nothing to do if buffering is disabled */
+	if (wal_receiver_write_size <= 0 && recvWriteBuf == NULL)
+	{
+		XLogWalRcvWrite(buf, nbytes, recptr);
+		return;
+	}
+
+	if (recvWriteBuf == NULL)
+	{
+		recvWriteBufSize = wal_receiver_write_size * (Size) 1024;
+		recvWriteBuf = palloc(recvWriteBufSize);
+	}
+
+	/* incoming data not contiguous with what we've buffered? */
+	if (recvWriteBufUsed > 0 &&
+		recptr != recvWriteBufStart + recvWriteBufUsed)
+		XLogWalRcvWriteQueued();
+
+	/* oversized chunks are written directly, bypassing the buffer */
+	if (nbytes >= recvWriteBufSize)
+	{
+		XLogWalRcvWriteQueued();
+		XLogWalRcvWrite(buf, nbytes, recptr);
+		return;
+	}
+
+	if (recvWriteBufUsed + nbytes > recvWriteBufSize)
+		XLogWalRcvWriteQueued();
+
+	if (recvWriteBufUsed == 0)
+		recvWriteBufStart = recptr;
+
+	memcpy(recvWriteBuf + recvWriteBufUsed, buf, nbytes);
+	recvWriteBufUsed += nbytes;
+}
+
+/*
+ * Write out any queued XLOG data.
+ */
+static void
+XLogWalRcvWriteQueued(void)
+{
+	Size		nbytes = recvWriteBufUsed;
+
+	if (nbytes == 0)
+		return;
+
+	/*
+	 * Reset the buffer before writing: XLogWalRcvWrite() re-enters
+	 * XLogWalRcvFlush() (and thus this function) when it crosses a segment
+	 * boundary.
+	 */
+	recvWriteBufUsed = 0;
+
+	XLogWalRcvWrite(recvWriteBuf, nbytes, recvWriteBufStart);
+}
+
 /*
  * Write XLOG data to disk.
  */
@@ -999,6 +1080,9 @@ XLogWalRcvWrite(char *buf, Size nbytes, XLogRecPtr recptr)
 static void
 XLogWalRcvFlush(bool dying)
 {
+	/* write out data still sitting in the coalescing buffer first */
+	XLogWalRcvWriteQueued();
+
 	if (LogstreamResult.Flush < LogstreamResult.Write)
 	{
 		WalRcvData *walrcv = WalRcv;
@@ -2553,6 +2553,7 @@ XLogSendPhysical(void)
 	XLogRecPtr	startptr;
 	XLogRecPtr	endptr;
 	Size		nbytes;
+	Size		nread;
 
 	/* If requested switch the WAL sender to the stopping state. */
 	if (got_STOPPING)
@@ -2766,9 +2767,20 @@ XLogSendPhysical(void)
 	/*
 	 * Read the log directly into the output buffer to avoid extra memcpy
 	 * calls.
+	 *
+	 * On a primary, recently flushed WAL is usually still present in the WAL
+	 * buffers, so try to copy it from there first and read only the
+	 * remainder (if any) from disk.
 	 */
 	enlargeStringInfo(&output_message, nbytes);
-	XLogRead(sendCxt, &output_message.data[output_message.len], startptr, nbytes);
+
+	nread = 0;
+	if (!sendTimeLineIsHistoric && !am_cascading_walsender)
+		nread = XLogReadFromBuffers(&output_message.data[output_message.len],
+									startptr, nbytes);
+	if (nread < nbytes)
+		XLogRead(sendCxt, &output_message.data[output_message.len] + nread,
+				 startptr + nread, nbytes - nread);
 	output_message.len += nbytes;
 	output_message.data[output_message.len] = '\0';
 
@@ -72,6 +72,14 @@ InitBufferPool(void)
 				foundIOLocks,
 				foundBufCkpt;
 
+#if SIZEOF_VOID_P == 8 && !defined(LOCK_DEBUG)
+	/* The hot/cold split in BufferDesc relies on this layout. */
+	StaticAssertStmt(offsetof(BufferDesc, tag) == 64,
+					 "read-mostly BufferDesc fields must start on the second cache line");
+	StaticAssertStmt(sizeof(BufferDescPadded) == BUFFERDESC_PAD_TO_SIZE,
+					 "BufferDesc must fit in BUFFERDESC_PAD_TO_SIZE");
+#endif
+
 	/* Align descriptors to a cacheline boundary. */
 	BufferDescriptors = (BufferDescPadded *)
 		ShmemInitStruct("Buffer Descriptors",
@@ -50,6 +50,7 @@
 #include "storage/proc.h"
 #include "storage/smgr.h"
 #include "storage/standby.h"
+#include "utils/memutils.h"
 #include "utils/rel.h"
 #include "utils/resowner_private.h"
 #include "utils/timestamp.h"
@@ -137,6 +138,27 @@ static bool IsForInput;
 /* local state for LockBufferForCleanup */
 static BufferDesc *PinCountWaitBuf = NULL;
 
+/*
+ * Backend-local cache of recent buffer mappings.
+ *
+ * On a mapping cache hit, BufferAlloc() can pin the remembered buffer and
+ * recheck its tag without taking the shared mapping table's partition lock,
+ * which is a significant win on read-mostly workloads whose working set sits
+ * in shared buffers.  Entries may go stale at any time (the buffer may have
+ * been evicted and reused for another block); that is harmless, because a
+ * pinned buffer cannot change identity, so rechecking the tag after pinning
+ * verifies the mapping.  Stale entries are simply replaced on miss.
+ */
+typedef struct BufMappingCacheEnt
+{
+	BufferTag	tag;			/* block identity; zeroed while unused */
+	int			buf_id;			/* buffer it mapped to when last looked up */
+} BufMappingCacheEnt;
+
+#define BUF_MAPPING_CACHE_SIZE	1024	/* must be a power of 2 */
+
+static BufMappingCacheEnt BufMappingCache[BUF_MAPPING_CACHE_SIZE];
+
 /*
  * Backend-Private refcount management:
  *
@@ -590,6 +612,44 @@ PrefetchBuffer(Relation reln, ForkNumber forkNum, BlockNumber blockNum)
 }
 
 
+/*
+ * PrefetchBufferWithoutRelcache -- like PrefetchBuffer, but doesn't require
+ *		a relcache entry for the relation.
+ *
+ * Only shared buffers are supported; callers working with another session's
+ * temporary relations shouldn't be prefetching them anyway.
+ */
+void
+PrefetchBufferWithoutRelcache(RelFileNode rnode, ForkNumber forkNum,
+							  BlockNumber blockNum)
+{
+#ifdef USE_PREFETCH
+	SMgrRelation smgr = smgropen(rnode, InvalidBackendId);
+	BufferTag	newTag;		/* identity of requested block */
+	uint32		newHash;	/* hash value for newTag */
+	LWLock	   *newPartitionLock;	/* buffer partition lock for it */
+	int			buf_id;
+
+	Assert(BlockNumberIsValid(blockNum));
+
+	/* create a tag so we can lookup the buffer */
+	INIT_BUFFERTAG(newTag, rnode, forkNum, blockNum);
+
+	/* determine its hash code and partition lock ID */
+	newHash = BufTableHashCode(&newTag);
+	newPartitionLock = BufMappingPartitionLock(newHash);
+
+	/* see if the block is in the buffer pool already */
+	LWLockAcquire(newPartitionLock, LW_SHARED);
+	buf_id = BufTableLookup(&newTag, newHash);
+	LWLockRelease(newPartitionLock);
+
+	/* If not in buffers, initiate prefetch */
+	if (buf_id < 0)
+		smgrprefetch(smgr, forkNum, blockNum);
+#endif							/* USE_PREFETCH */
+}
+
 /*
  * ReadBuffer -- a shorthand for ReadBufferExtended, for reading from main
  *		fork with RBM_NORMAL mode and default strategy.
@@ -695,6 +755,299 @@ ReadBufferWithoutRelcache(RelFileNode rnode, ForkNumber forkNum,
 							 mode, strategy, &hit);
 }
 
+/*
+ * StartReadBuffer -- begin a split read of a block of a relation
+ *
+ * This is the first half of a ReadBuffer() that has been split in two so
+ * that callers can have several reads in flight before stopping to wait for
+ * the data.  If the block is already cached, it is pinned here so that it
+ * cannot be evicted before WaitReadBuffer() collects it; otherwise an
+ * asynchronous read of the block is initiated and WaitReadBuffer() will
+ * complete it.  Every StartReadBuffer() call must be balanced by exactly
+ * one WaitReadBuffer() on the same ReadBufferOp, in any order with respect
+ * to other in-flight reads.
+ *
+ * Only RBM_NORMAL semantics are provided, and P_NEW is not supported.
+ */
+void
+StartReadBuffer(Relation reln, ForkNumber forkNum, BlockNumber blockNum,
+				BufferAccessStrategy strategy, ReadBufferOp *op)
+{
+	Assert(RelationIsValid(reln));
+	Assert(BlockNumberIsValid(blockNum));
+
+	op->rel = reln;
+	op->forkNum = forkNum;
+	op->blockNum = blockNum;
+	op->strategy = strategy;
+	op->pinned_buffer = InvalidBuffer;
+
+	/* Open it at the smgr level if not already done */
+	RelationOpenSmgr(reln);
+
+	if (RelationUsesLocalBuffers(reln))
+	{
+		/* see comments in ReadBufferExtended */
+		if (RELATION_IS_OTHER_TEMP(reln))
+			ereport(ERROR,
+					(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+					 errmsg("cannot access temporary tables of other sessions")));
+
+		/*
+		 * Local buffers can't be evicted by other backends, so there is no
+		 * need to pin anything here; just give the kernel a head start on
+		 * any block that has spilled to disk.
+		 */
+		LocalPrefetchBuffer(reln->rd_smgr, forkNum, blockNum);
+	}
+	else
+	{
+		BufferTag	newTag;		/* identity of requested block */
+		uint32		newHash;	/* hash value for newTag */
+		LWLock	   *newPartitionLock;	/* buffer partition lock for it */
+		int			buf_id;
+
+		/* create a tag so we can lookup the buffer */
+		INIT_BUFFERTAG(newTag, reln->rd_smgr->smgr_rnode.node,
+					   forkNum, blockNum);
+
+		/* determine its hash code and partition lock ID */
+		newHash = BufTableHashCode(&newTag);
+		newPartitionLock = BufMappingPartitionLock(newHash);
+
+		/* Make sure we will have room to remember the buffer pin */
+		ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
+
+		/* see if the block is in the buffer pool already */
+		LWLockAcquire(newPartitionLock, LW_SHARED);
+		buf_id = BufTableLookup(&newTag, newHash);
+		if (buf_id >= 0)
+		{
+			BufferDesc *bufHdr = GetBufferDescriptor(buf_id);
+			bool		valid;
+
+			/*
+			 * Pin the buffer so that it can't be evicted between now and
+			 * WaitReadBuffer().  This also tells us whether it is valid; if
+			 * somebody else's read is still in progress, drop the pin again
+			 * and let WaitReadBuffer() wait for that I/O the usual way.
+			 */
+			valid = PinBuffer(bufHdr, strategy);
+			LWLockRelease(newPartitionLock);
+
+			if (valid)
+				op->pinned_buffer = BufferDescriptorGetBuffer(bufHdr);
+			else
+				UnpinBuffer(bufHdr, true);
+			return;
+		}
+		LWLockRelease(newPartitionLock);
+
+#ifdef USE_PREFETCH
+		/* Not in the buffer pool, so start the read at the kernel level */
+		smgrprefetch(reln->rd_smgr, forkNum, blockNum);
+#endif
+	}
+}
+
+/*
+ * WaitReadBuffer -- complete a read begun by StartReadBuffer()
+ *
+ * Returns the buffer, pinned, exactly as ReadBuffer() would have.
+ */
+Buffer
+WaitReadBuffer(ReadBufferOp *op)
+{
+	Buffer		buffer = op->pinned_buffer;
+
+	if (BufferIsValid(buffer))
+	{
+		/*
+		 * The buffer was pinned, and hence valid and immovable, when the
+		 * read was started; all that remains is to account for the hit.
+		 */
+		pgstat_count_buffer_read(op->rel);
+		pgstat_count_buffer_hit(op->rel);
+		pgBufferUsage.shared_blks_hit++;
+		if (VacuumCostActive)
+			VacuumCostBalance += VacuumCostPageHit;
+
+		op->pinned_buffer = InvalidBuffer;
+		return buffer;
+	}
+
+	return ReadBufferExtended(op->rel, op->forkNum, op->blockNum,
+							  RBM_NORMAL, op->strategy);
+}
+
+/*
+ * ReadBufferExtent -- load a run of consecutive blocks into shared buffers.
+ *
+ * This reads up to READ_EXTENT_SIZE blocks of the given fork, starting at
+ * blockNum, into shared buffers with as few smgr calls as possible: blocks
+ * that are already resident are left alone, and each maximal run of
+ * non-resident blocks is fetched with a single smgrreadmulti() call.  It is
+ * strictly an optimization for callers (such as sequential scans) that are
+ * about to read the blocks one by one anyway; the subsequent per-block
+ * ReadBuffer() calls then find the pages already in the buffer pool.
+ *
+ * Because the buffer manager permits only one I/O in progress per backend,
+ * we cannot claim all the buffers up front and read into them directly.
+ * Instead the extent is read into a backend-local staging buffer with one
+ * kernel call, and the pages are then transferred into shared buffers one
+ * at a time under the normal StartBufferIO/TerminateBufferIO protocol.
+ * The extra memcpy is cheap compared to the per-block kernel calls saved.
+ *
+ * This is best-effort in every respect: blocks that another backend reads
+ * concurrently, or that smgr reports as discarded, are simply skipped.
+ * Temp relations are not handled; the caller gets per-block reads there.
+ */
+void
+ReadBufferExtent(Relation reln, ForkNumber forkNum, BlockNumber blockNum,
+				 int nblocks, BufferAccessStrategy strategy)
+{
+	static char *extentbuf = NULL;
+	bool		missing[READ_EXTENT_SIZE];
+	SMgrRelation smgr;
+	int			i;
+
+	Assert(BlockNumberIsValid(blockNum));
+	Assert(nblocks > 0);
+
+	/* Open it at the smgr level if not already done */
+	RelationOpenSmgr(reln);
+
+	if (RelationUsesLocalBuffers(reln))
+		return;
+
+	smgr = reln->rd_smgr;
+
+	if (nblocks > READ_EXTENT_SIZE)
+		nblocks = READ_EXTENT_SIZE;
+
+	/*
+	 * Find out which of the requested blocks are not already resident.  We
+	 * only take the mapping partition locks in shared mode, so this can race
+	 * against concurrent reads and evictions; BufferAlloc() below resolves
+	 * any such race in favor of whoever inserts the page first.
+	 */
+	for (i = 0; i < nblocks; i++)
+	{
+		BufferTag	newTag;		/* identity of requested block */
+		uint32		newHash;	/* hash value for newTag */
+		LWLock	   *newPartitionLock;	/* buffer partition lock for it */
+
+		INIT_BUFFERTAG(newTag, smgr->smgr_rnode.node, forkNum, blockNum + i);
+		newHash = BufTableHashCode(&newTag);
+		newPartitionLock = BufMappingPartitionLock(newHash);
+
+		LWLockAcquire(newPartitionLock, LW_SHARED);
+		missing[i] = (BufTableLookup(&newTag, newHash) < 0);
+		LWLockRelease(newPartitionLock);
+	}
+
+	/* Allocate the staging buffer on first use; it is kept for the rest of
+	 * the backend's life. */
+	if (extentbuf == NULL)
+		extentbuf = MemoryContextAlloc(TopMemoryContext,
+									   (Size) READ_EXTENT_SIZE * BLCKSZ);
+
+	for (i = 0; i < nblocks; i++)
+	{
+		int			runend;
+		int			j;
+		instr_time	io_start,
+					io_time;
+
+		if (!missing[i])
+			continue;
+
+		/* Find the maximal run of non-resident blocks starting here. */
+		for (runend = i + 1; runend < nblocks && missing[runend]; runend++)
+			;
+
+		if (track_io_timing)
+			INSTR_TIME_SET_CURRENT(io_start);
+
+		if (!smgrreadmulti(smgr, forkNum, blockNum + i, runend - i,
+						   extentbuf + (Size) i * BLCKSZ))
+		{
+			/*
+			 * Part of the run has been discarded; give up and let the
+			 * regular per-block path sort it out.
+			 */
+			return;
+		}
+
+		if (track_io_timing)
+		{
+			INSTR_TIME_SET_CURRENT(io_time);
+			INSTR_TIME_SUBTRACT(io_time, io_start);
+			pgstat_count_buffer_read_time(INSTR_TIME_GET_MICROSEC(io_time));
+			INSTR_TIME_ADD(pgBufferUsage.blk_read_time, io_time);
+		}
+
+		/* Transfer the pages we read into shared buffers. */
+		for (j = i; j < runend; j++)
+		{
+			BufferDesc *bufHdr;
+			Block		bufBlock;
+			bool		found;
+
+			/* Make sure we will have room to remember the buffer pin */
+			ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
+
+			bufHdr = BufferAlloc(smgr, reln->rd_rel->relpersistence, forkNum,
+								 blockNum + j, strategy, &found);
+			if (found)
+			{
+				/* Somebody else read it concurrently; their copy wins. */
+				UnpinBuffer(bufHdr, true);
+				continue;
+			}
+
+			/* IO_IN_PROGRESS is set; fill the page from the staging buffer */
+			bufBlock = BufHdrGetBlock(bufHdr);
+			memcpy((char *) bufBlock, extentbuf + (Size) j * BLCKSZ, BLCKSZ);
+
+			/* check for garbage data */
+			// See the corresponding comment in ReadBuffer_common about
+			// undo pages and PageIsVerified().
+			if (smgr->smgr_rnode.node.dbNode != UndoDbOid &&
+				!PageIsVerified((Page) bufBlock, blockNum + j))
+			{
+				if (zero_damaged_pages)
+				{
+					ereport(WARNING,
+							(errcode(ERRCODE_DATA_CORRUPTED),
+							 errmsg("invalid page in block %u of relation %s; zeroing out page",
+									blockNum + j,
+									relpath(smgr->smgr_rnode, forkNum))));
+					MemSet((char *) bufBlock, 0, BLCKSZ);
+				}
+				else
+					ereport(ERROR,
+							(errcode(ERRCODE_DATA_CORRUPTED),
+							 errmsg("invalid page in block %u of relation %s",
+									blockNum + j,
+									relpath(smgr->smgr_rnode, forkNum))));
+			}
+
+			/* Set BM_VALID, terminate IO, and wake up any waiters */
+			TerminateBufferIO(bufHdr, false, BM_VALID);
+
+			UnpinBuffer(bufHdr, true);
+
+			pgBufferUsage.shared_blks_read++;
+			VacuumPageMiss++;
+			if (VacuumCostActive)
+				VacuumCostBalance += VacuumCostPageMiss;
+		}
+
+		i = runend;
+	}
+}
+
 
 /*
  * ReadBuffer_common -- common logic for all ReadBuffer variants
@@ -1025,6 +1378,7 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 	BufferDesc *buf;
 	bool		valid;
 	uint32		buf_state;
+	BufMappingCacheEnt *mapent;
 
 	/* create a tag so we can lookup the buffer */
 	INIT_BUFFERTAG(newTag, smgr->smgr_rnode.node, forkNum, blockNum);
@@ -1033,6 +1387,41 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 	newHash = BufTableHashCode(&newTag);
 	newPartitionLock = BufMappingPartitionLock(newHash);
 
+	/*
+	 * First consult the backend-local mapping cache, so that a repeat visit
+	 * to a resident block can skip the shared mapping table and its
+	 * partition lock entirely.  The cache entry may be stale, so we pin the
+	 * buffer optimistically and then recheck its tag: once pinned, the
+	 * buffer cannot be renamed, so a (still) matching tag proves we have the
+	 * right buffer.  A transient pin on a non-matching buffer is harmless;
+	 * at worst a concurrent eviction retries.
+	 */
+	mapent = &BufMappingCache[newHash % BUF_MAPPING_CACHE_SIZE];
+	if (BUFFERTAGS_EQUAL(mapent->tag, newTag))
+	{
+		buf = GetBufferDescriptor(mapent->buf_id);
+
+		valid = PinBuffer(buf, strategy);
+
+		if (BUFFERTAGS_EQUAL(buf->tag, newTag))
+		{
+			/* identical to the shared-lookup hit case below */
+			*foundPtr = true;
+
+			if (!valid)
+			{
+				if (StartBufferIO(buf, true))
+					*foundPtr = false;
+			}
+
+			return buf;
+		}
+
+		/* stale entry; forget it and fall through to a regular lookup */
+		UnpinBuffer(buf, true);
+		CLEAR_BUFFERTAG(mapent->tag);
+	}
+
 	/* see if the block is in the buffer pool already */
 	LWLockAcquire(newPartitionLock, LW_SHARED);
 	buf_id = BufTableLookup(&newTag, newHash);
@@ -1050,6 +1439,10 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 		/* Can release the mapping lock as soon as we've pinned it */
 		LWLockRelease(newPartitionLock);
 
+		/* remember the mapping for next time */
+		mapent->tag = newTag;
+		mapent->buf_id = buf_id;
+
 		*foundPtr = true;
 
 		if (!valid)
@@ -1168,6 +1561,15 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 				ScheduleBufferTagForWriteback(&BackendWritebackContext,
 											  &buf->tag);
 
+				/*
+				 * Tell the bgwriter that a foreground process had to do its
+				 * job, so that it scans further ahead.  Ring-buffer evictions
+				 * don't count: the ring is recycled by this backend by
+				 * design, and the bgwriter can't usefully get ahead of it.
+				 */
+				if (strategy == NULL)
+					StrategyReportBackendWrite();
+
 				TRACE_POSTGRESQL_BUFFER_WRITE_DIRTY_DONE(forkNum, blockNum,
 														 smgr->smgr_rnode.node.spcNode,
 														 smgr->smgr_rnode.node.dbNode,
@@ -1262,6 +1664,10 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 			/* Can release the mapping lock as soon as we've pinned it */
 			LWLockRelease(newPartitionLock);
 
+			/* remember the mapping for next time */
+			mapent->tag = newTag;
+			mapent->buf_id = buf_id;
+
 			*foundPtr = true;
 
 			if (!valid)
@@ -1343,6 +1749,10 @@ BufferAlloc(SMgrRelation smgr, char relpersistence, ForkNumber forkNum,
 
 	LWLockRelease(newPartitionLock);
 
+	/* remember the new mapping for next time */
+	mapent->tag = newTag;
+	mapent->buf_id = buf->buf_id;
+
 	/*
 	 * Buffer contents are currently invalid.  Try to get the io_in_progress
 	 * lock.  If StartBufferIO returns false, then someone else managed to
@@ -1428,6 +1838,65 @@ DiscardBuffer(RelFileNode rnode, ForkNumber forkNum, BlockNumber blockNum)
 		UnlockBufHdr(bufHdr, buf_state);
 }
 
+/*
+ * FlushBufferIfPresent -- write out one buffer, if present and dirty
+ *
+ * If the given page is in the buffer pool and dirty, write it out to the
+ * operating system; otherwise do nothing.  The buffer remains valid.  This
+ * is used when the underlying file is about to be read directly, to make
+ * sure that its on-disk contents are current.
+ */
+void
+FlushBufferIfPresent(RelFileNode rnode, ForkNumber forkNum,
+					 BlockNumber blockNum)
+{
+	BufferTag	tag;			/* identity of target block */
+	uint32		hash;			/* hash value for tag */
+	LWLock	   *partitionLock;	/* buffer partition lock for it */
+	int			buf_id;
+	BufferDesc *bufHdr;
+	uint32		buf_state;
+
+	/* create a tag so we can lookup the buffer */
+	INIT_BUFFERTAG(tag, rnode, forkNum, blockNum);
+
+	/* determine its hash code and partition lock ID */
+	hash = BufTableHashCode(&tag);
+	partitionLock = BufMappingPartitionLock(hash);
+
+	/* see if the block is in the buffer pool */
+	LWLockAcquire(partitionLock, LW_SHARED);
+	buf_id = BufTableLookup(&tag, hash);
+	LWLockRelease(partitionLock);
+
+	/* didn't find it, so nothing to do */
+	if (buf_id < 0)
+		return;
+
+	/* Make sure we can handle the pin */
+	ReservePrivateRefCountEntry();
+	ResourceOwnerEnlargeBuffers(CurrentResourceOwner);
+
+	bufHdr = GetBufferDescriptor(buf_id);
+	buf_state = LockBufHdr(bufHdr);
+
+	/*
+	 * The buffer might have been evicted, or cleaned, after we released the
+	 * partition lock and before we acquired the buffer header lock.
+	 */
+	if (BUFFERTAGS_EQUAL(bufHdr->tag, tag) &&
+		(buf_state & (BM_VALID | BM_DIRTY)) == (BM_VALID | BM_DIRTY))
+	{
+		PinBuffer_Locked(bufHdr);	/* releases spinlock */
+		LWLockAcquire(BufferDescriptorGetContentLock(bufHdr), LW_SHARED);
+		FlushBuffer(bufHdr, NULL);
+		LWLockRelease(BufferDescriptorGetContentLock(bufHdr));
+		UnpinBuffer(bufHdr, true);
+	}
+	else
+		UnlockBufHdr(bufHdr, buf_state);
+}
+
 /*
  * InvalidateBuffer -- mark a shared buffer invalid and return it to the
  * freelist.
@@ -2082,6 +2551,17 @@ BufferSync(int flags)
 		 * page and dirtied it.  In that improbable case, SyncOneBuffer will
 		 * write the buffer though we didn't need to.  It doesn't seem worth
 		 * guarding against this, though.
+		 *
+		 * Note that although the sorted order means runs of consecutive
+		 * blocks of the same relation are written back to back, we make no
+		 * attempt to combine them into larger vectored writes: the
+		 * IO-in-progress protocol (StartBufferIO/AbortBufferIO) only supports
+		 * one buffer IO per backend at a time, so error recovery couldn't
+		 * cope with a multi-buffer write.  Instead we rely on the kernel to
+		 * merge the sequential 8kB writes in the page cache, and on the
+		 * writeback machinery (checkpoint_flush_after, via wb_context) to
+		 * push them to the device in larger sorted batches while we keep
+		 * writing.
 		 */
 		if (pg_atomic_read_u32(&bufHdr->state) & BM_CHECKPOINT_NEEDED)
 		{
@@ -2152,6 +2632,7 @@ BgBufferSync(WritebackContext *wb_context)
 	int			strategy_buf_id;
 	uint32		strategy_passes;
 	uint32		recent_alloc;
+	uint32		recent_backend_writes;
 
 	/*
 	 * Information saved between calls so we can determine the strategy
@@ -2167,6 +2648,9 @@ BgBufferSync(WritebackContext *wb_context)
 	static float smoothed_alloc = 0;
 	static float smoothed_density = 10.0;
 
+	/* Moving average of backend-initiated eviction writes */
+	static float smoothed_backend_writes = 0;
+
 	/* Potentially these could be tunables, but for now, not */
 	float		smoothing_samples = 16;
 	float		scan_whole_pool_milliseconds = 120000.0;
@@ -2193,7 +2677,8 @@ BgBufferSync(WritebackContext *wb_context)
 	 * Find out where the freelist clock sweep currently is, and how many
 	 * buffer allocations have happened since our last call.
 	 */
-	strategy_buf_id = StrategySyncStart(&strategy_passes, &recent_alloc);
+	strategy_buf_id = StrategySyncStart(&strategy_passes, &recent_alloc,
+										&recent_backend_writes);
 
 	/* Report buffer alloc counts to pgstat */
 	BgWriterStats.m_buf_alloc += recent_alloc;
@@ -2319,8 +2804,23 @@ BgBufferSync(WritebackContext *wb_context)
 		smoothed_alloc += ((float) recent_alloc - smoothed_alloc) /
 			smoothing_samples;
 
+	/*
+	 * Track backend-initiated eviction writes the same way.  Each one means a
+	 * foreground process ran past the buffers we had cleaned and had to do
+	 * the write itself -- direct evidence that our allocation estimate was
+	 * too low.  Weight them double when sizing the upcoming-allocations
+	 * estimate, so that the target overshoots while backends are being forced
+	 * to write and decays back once they stop.
+	 */
+	if (smoothed_backend_writes <= (float) recent_backend_writes)
+		smoothed_backend_writes = recent_backend_writes;
+	else
+		smoothed_backend_writes += ((float) recent_backend_writes - smoothed_backend_writes) /
+			smoothing_samples;
+
 	/* Scale the estimate by a GUC to allow more aggressive tuning. */
-	upcoming_alloc_est = (int) (smoothed_alloc * bgwriter_lru_multiplier);
+	upcoming_alloc_est = (int) ((smoothed_alloc + 2.0f * smoothed_backend_writes) *
+								bgwriter_lru_multiplier);
 
 	/*
 	 * If recent_alloc remains at zero for many cycles, smoothed_alloc will
@@ -2331,7 +2831,10 @@ BgBufferSync(WritebackContext *wb_context)
 	 * syndrome.  It will pop back up as soon as recent_alloc increases.
 	 */
 	if (upcoming_alloc_est == 0)
+	{
 		smoothed_alloc = 0;
+		smoothed_backend_writes = 0;
+	}
 
 	/*
 	 * Even in cases where there's been little or no buffer allocation
@@ -23,6 +23,49 @@
 #define INT_ACCESS_ONCE(var)	((int)(*((volatile int *)&(var))))
 
 
+/*
+ * The buffer freelist is striped across NUM_BUFFER_FREE_LISTS separate
+ * lists, each on its own cache line with its own spinlock.  On large
+ * multi-socket machines a single freelist spinlock and list head become a
+ * cross-node cache line ping-pong hotspot; striping lets concurrent
+ * allocations proceed on different lists.  Backends prefer the list keyed
+ * by their PGPROC slot and fall back to the others, so all free buffers
+ * remain reachable from every backend.
+ */
+#define NUM_BUFFER_FREE_LISTS	16
+
+typedef struct BufferFreeList
+{
+	/* Spinlock: protects the values below */
+	slock_t		free_list_lock;
+
+	int			firstFreeBuffer;	/* Head of list of unused buffers */
+	int			lastFreeBuffer; /* Tail of list of unused buffers */
+
+	/*
+	 * NOTE: lastFreeBuffer is undefined when firstFreeBuffer is -1 (that is,
+	 * when the list is empty)
+	 */
+} BufferFreeList;
+
+/* Padded to avoid false sharing between the stripes. */
+typedef union BufferFreeListPadded
+{
+	BufferFreeList list;
+	char		pad[PG_CACHE_LINE_SIZE];
+} BufferFreeListPadded;
+
+/*
+ * When all the free lists are empty, the backend that runs the clock sweep
+ * pre-evicts a batch of victims into them rather than claiming just one, so
+ * that under cache pressure the common allocation path is a pop from a free
+ * list instead of every backend walking the clock over the same hot
+ * buffers.  The scan limit bounds the work a single refill may do when few
+ * buffers are evictable.
+ */
+#define CLOCK_SWEEP_BATCH_SIZE		16
+#define CLOCK_SWEEP_BATCH_SCAN_LIMIT	(4 * CLOCK_SWEEP_BATCH_SIZE)
+
 /*
  * The shared freelist control information.
  */
@@ -38,20 +81,14 @@ typedef struct
 	 */
 	pg_atomic_uint32 nextVictimBuffer;
 
-	int			firstFreeBuffer;	/* Head of list of unused buffers */
-	int			lastFreeBuffer; /* Tail of list of unused buffers */
-
-	/*
-	 * NOTE: lastFreeBuffer is undefined when firstFreeBuffer is -1 (that is,
-	 * when the list is empty)
-	 */
-
 	/*
 	 * Statistics.  These counters should be wide enough that they can't
 	 * overflow during a single bgwriter cycle.
 	 */
 	uint32		completePasses; /* Complete cycles of the clock sweep */
 	pg_atomic_uint32 numBufferAllocs;	/* Buffers allocated since last reset */
+	pg_atomic_uint32 numBackendWrites;	/* Dirty buffers written by backends
+										 * during eviction since last reset */
 
 	/*
 	 * Bgworker process to be notified upon activity or -1 if none. See
@@ -62,6 +99,14 @@ typedef struct
 
 /* Pointers to shared state */
 static BufferStrategyControl *StrategyControl = NULL;
+static BufferFreeListPadded *BufferFreeLists = NULL;
+
+/*
+ * GUC: size of the buffer ring used for bulk reads, in kilobytes.  Sessions
+ * running deliberately scan-heavy workloads can raise this to give their
+ * scans a larger working set without giving up scan-resistance entirely.
+ */
+int			bulk_read_ring_size = 256;
 
 /*
  * Private (non-shared) state for managing a ring of shared buffers to re-use.
@@ -102,6 +147,26 @@ static BufferDesc *GetBufferFromRing(BufferAccessStrategy strategy,
 									 uint32 *buf_state);
 static void AddBufferToRing(BufferAccessStrategy strategy,
 							BufferDesc *buf);
+static BufferDesc *GetBufferFromFreeLists(BufferAccessStrategy strategy,
+										  uint32 *buf_state);
+static bool StrategySweepBatch(void);
+
+/*
+ * GetBufferFreeList - look up the free list that owns a given buffer
+ *
+ * Buffers are assigned to free lists in contiguous ranges, so that the
+ * buffers a backend obtains from its preferred list tend to be neighbors in
+ * the descriptor array.
+ */
+static inline BufferFreeList *
+GetBufferFreeList(int buf_id)
+{
+	int			buffers_per_list;
+
+	buffers_per_list = (NBuffers + NUM_BUFFER_FREE_LISTS - 1) /
+		NUM_BUFFER_FREE_LISTS;
+	return &BufferFreeLists[buf_id / buffers_per_list].list;
+}
 
 /*
  * ClockSweepTick - Helper routine for StrategyGetBuffer()
@@ -168,6 +233,150 @@ ClockSweepTick(void)
 	return victim;
 }
 
+/*
+ * GetBufferFromFreeLists - try to pop a usable buffer off the free lists
+ *
+ * Try the striped free lists, starting with the one keyed by our PGPROC
+ * slot so that concurrent backends spread across the stripes, and falling
+ * back to the others so that no free buffer is unreachable.
+ *
+ * For each list, first check without acquiring its lock whether it has
+ * buffers at all. Since we otherwise don't require the spinlock in every
+ * StrategyGetBuffer() invocation, it'd be sad to acquire it here -
+ * uselessly in most cases. That obviously leaves a race where a buffer is
+ * put on the freelist but we don't see the store yet - but that's pretty
+ * harmless, it'll just get used during the next buffer acquisition.
+ *
+ * If there's buffers on the freelist, acquire the spinlock to pop one
+ * buffer of the freelist. Then check whether that buffer is usable and
+ * repeat if not.
+ *
+ * Note that the freeNext fields are considered to be protected by the
+ * owning free list's lock not the individual buffer spinlocks, so it's OK
+ * to manipulate them without holding the buffer spinlock.
+ *
+ * On success the buffer is returned with its header spinlock held, as for
+ * StrategyGetBuffer(); otherwise returns NULL.
+ */
+static BufferDesc *
+GetBufferFromFreeLists(BufferAccessStrategy strategy, uint32 *buf_state)
+{
+	int			home_list;
+	int			i;
+
+	home_list = (MyProc != NULL ? MyProc->pgprocno : 0) %
+		NUM_BUFFER_FREE_LISTS;
+	for (i = 0; i < NUM_BUFFER_FREE_LISTS; i++)
+	{
+		BufferFreeList *list =
+			&BufferFreeLists[(home_list + i) % NUM_BUFFER_FREE_LISTS].list;
+
+		if (list->firstFreeBuffer < 0)
+			continue;
+
+		while (true)
+		{
+			BufferDesc *buf;
+			uint32		local_buf_state;
+
+			/* Acquire the spinlock to remove element from the freelist */
+			SpinLockAcquire(&list->free_list_lock);
+
+			if (list->firstFreeBuffer < 0)
+			{
+				SpinLockRelease(&list->free_list_lock);
+				break;
+			}
+
+			buf = GetBufferDescriptor(list->firstFreeBuffer);
+			Assert(buf->freeNext != FREENEXT_NOT_IN_LIST);
+
+			/* Unconditionally remove buffer from freelist */
+			list->firstFreeBuffer = buf->freeNext;
+			buf->freeNext = FREENEXT_NOT_IN_LIST;
+
+			/*
+			 * Release the lock so someone else can access the freelist while
+			 * we check out this buffer.
+			 */
+			SpinLockRelease(&list->free_list_lock);
+
+			/*
+			 * If the buffer is pinned or has a nonzero usage_count, we cannot
+			 * use it; discard it and retry.  (This can only happen if VACUUM
+			 * put a valid buffer in the freelist and then someone else used
+			 * it before we got to it.  It's probably impossible altogether as
+			 * of 8.3, but we'd better check anyway.)
+			 */
+			local_buf_state = LockBufHdr(buf);
+			if (BUF_STATE_GET_REFCOUNT(local_buf_state) == 0
+				&& BUF_STATE_GET_USAGECOUNT(local_buf_state) == 0)
+			{
+				if (strategy != NULL)
+					AddBufferToRing(strategy, buf);
+				*buf_state = local_buf_state;
+				return buf;
+			}
+			UnlockBufHdr(buf, local_buf_state);
+
+		}
+	}
+
+	return NULL;
+}
+
+/*
+ * StrategySweepBatch - pre-evict a batch of clock sweep victims
+ *
+ * Advance the clock hand over a bounded number of buffers, decrementing
+ * usage counts as usual, and push every immediately evictable buffer
+ * (unpinned, usage count zero) onto the free list that owns it.  The
+ * buffers are not modified otherwise; whoever pops one rechecks its state
+ * and performs the actual eviction in BufferAlloc(), exactly as for valid
+ * buffers placed on the freelist by VACUUM or relation drops.
+ *
+ * Returns true if at least one buffer was pushed onto a free list.
+ */
+static bool
+StrategySweepBatch(void)
+{
+	int			npushed = 0;
+	int			nscanned = 0;
+
+	while (npushed < CLOCK_SWEEP_BATCH_SIZE &&
+		   nscanned < CLOCK_SWEEP_BATCH_SCAN_LIMIT)
+	{
+		BufferDesc *buf = GetBufferDescriptor(ClockSweepTick());
+		uint32		local_buf_state;
+		bool		push = false;
+
+		nscanned++;
+
+		local_buf_state = LockBufHdr(buf);
+		if (BUF_STATE_GET_REFCOUNT(local_buf_state) == 0)
+		{
+			if (BUF_STATE_GET_USAGECOUNT(local_buf_state) != 0)
+				local_buf_state -= BUF_USAGECOUNT_ONE;
+			else
+				push = true;
+		}
+		UnlockBufHdr(buf, local_buf_state);
+
+		/*
+		 * Push after releasing the buffer header spinlock; if somebody pins
+		 * or touches the buffer before it is popped again, the popping
+		 * backend will notice and discard it.
+		 */
+		if (push)
+		{
+			StrategyFreeBuffer(buf);
+			npushed++;
+		}
+	}
+
+	return npushed > 0;
+}
+
 /*
  * have_free_buffer -- a lockless check to see if there is a free buffer in
  *					   buffer pool.
@@ -179,10 +388,14 @@ ClockSweepTick(void)
 bool
 have_free_buffer()
 {
-	if (StrategyControl->firstFreeBuffer >= 0)
-		return true;
-	else
-		return false;
+	int			i;
+
+	for (i = 0; i < NUM_BUFFER_FREE_LISTS; i++)
+	{
+		if (BufferFreeLists[i].list.firstFreeBuffer >= 0)
+			return true;
+	}
+	return false;
 }
 
 /*
@@ -249,67 +462,24 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 	 */
 	pg_atomic_fetch_add_u32(&StrategyControl->numBufferAllocs, 1);
 
+	/* Try the striped free lists before resorting to the clock sweep. */
+	buf = GetBufferFromFreeLists(strategy, buf_state);
+	if (buf != NULL)
+		return buf;
+
 	/*
-	 * First check, without acquiring the lock, whether there's buffers in the
-	 * freelist. Since we otherwise don't require the spinlock in every
-	 * StrategyGetBuffer() invocation, it'd be sad to acquire it here -
-	 * uselessly in most cases. That obviously leaves a race where a buffer is
-	 * put on the freelist but we don't see the store yet - but that's pretty
-	 * harmless, it'll just get used during the next buffer acquisition.
-	 *
-	 * If there's buffers on the freelist, acquire the spinlock to pop one
-	 * buffer of the freelist. Then check whether that buffer is usable and
-	 * repeat if not.
-	 *
-	 * Note that the freeNext fields are considered to be protected by the
-	 * buffer_strategy_lock not the individual buffer spinlocks, so it's OK to
-	 * manipulate them without holding the spinlock.
+	 * All the free lists were empty.  Sweep a batch of victims into them and
+	 * try the pop once more, so that backends allocating concurrently or
+	 * right after us can pop instead of repeating the sweep over the same
+	 * hot buffers.  If the batch sweep couldn't evict anything, fall through
+	 * to the classic clock sweep, which retains the error check for a
+	 * completely pinned buffer pool.
 	 */
-	if (StrategyControl->firstFreeBuffer >= 0)
+	if (StrategySweepBatch())
 	{
-		while (true)
-		{
-			/* Acquire the spinlock to remove element from the freelist */
-			SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
-
-			if (StrategyControl->firstFreeBuffer < 0)
-			{
-				SpinLockRelease(&StrategyControl->buffer_strategy_lock);
-				break;
-			}
-
-			buf = GetBufferDescriptor(StrategyControl->firstFreeBuffer);
-			Assert(buf->freeNext != FREENEXT_NOT_IN_LIST);
-
-			/* Unconditionally remove buffer from freelist */
-			StrategyControl->firstFreeBuffer = buf->freeNext;
-			buf->freeNext = FREENEXT_NOT_IN_LIST;
-
-			/*
-			 * Release the lock so someone else can access the freelist while
-			 * we check out this buffer.
-			 */
-			SpinLockRelease(&StrategyControl->buffer_strategy_lock);
-
-			/*
-			 * If the buffer is pinned or has a nonzero usage_count, we cannot
-			 * use it; discard it and retry.  (This can only happen if VACUUM
-			 * put a valid buffer in the freelist and then someone else used
-			 * it before we got to it.  It's probably impossible altogether as
-			 * of 8.3, but we'd better check anyway.)
-			 */
-			local_buf_state = LockBufHdr(buf);
-			if (BUF_STATE_GET_REFCOUNT(local_buf_state) == 0
-				&& BUF_STATE_GET_USAGECOUNT(local_buf_state) == 0)
-			{
-				if (strategy != NULL)
-					AddBufferToRing(strategy, buf);
-				*buf_state = local_buf_state;
-				return buf;
-			}
-			UnlockBufHdr(buf, local_buf_state);
-
-		}
+		buf = GetBufferFromFreeLists(strategy, buf_state);
+		if (buf != NULL)
+			return buf;
 	}
 
 	/* Nothing on the freelist, so run the "clock sweep" algorithm */
@@ -363,7 +533,9 @@ StrategyGetBuffer(BufferAccessStrategy strategy, uint32 *buf_state)
 void
 StrategyFreeBuffer(BufferDesc *buf)
 {
-	SpinLockAcquire(&StrategyControl->buffer_strategy_lock);
+	BufferFreeList *list = GetBufferFreeList(buf->buf_id);
+
+	SpinLockAcquire(&list->free_list_lock);
 
 	/*
 	 * It is possible that we are told to put something in the freelist that
@@ -371,13 +543,13 @@ StrategyFreeBuffer(BufferDesc *buf)
 	 */
 	if (buf->freeNext == FREENEXT_NOT_IN_LIST)
 	{
-		buf->freeNext = StrategyControl->firstFreeBuffer;
+		buf->freeNext = list->firstFreeBuffer;
 		if (buf->freeNext < 0)
-			StrategyControl->lastFreeBuffer = buf->buf_id;
-		StrategyControl->firstFreeBuffer = buf->buf_id;
+			list->lastFreeBuffer = buf->buf_id;
+		list->firstFreeBuffer = buf->buf_id;
 	}
 
-	SpinLockRelease(&StrategyControl->buffer_strategy_lock);
+	SpinLockRelease(&list->free_list_lock);
 }
 
 /*
@@ -387,12 +559,14 @@ StrategyFreeBuffer(BufferDesc *buf)
  * BufferSync() will proceed circularly around the buffer array from there.
  *
  * In addition, we return the completed-pass count (which is effectively
- * the higher-order bits of nextVictimBuffer) and the count of recent buffer
- * allocs if non-NULL pointers are passed.  The alloc count is reset after
- * being read.
+ * the higher-order bits of nextVictimBuffer), the count of recent buffer
+ * allocs, and the count of dirty buffers recently written by backends during
+ * eviction, if non-NULL pointers are passed.  The alloc and backend-write
+ * counts are reset after being read.
  */
 int
-StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc)
+StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc,
+				  uint32 *num_backend_writes)
 {
 	uint32		nextVictimBuffer;
 	int			result;
@@ -416,10 +590,28 @@ StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc)
 	{
 		*num_buf_alloc = pg_atomic_exchange_u32(&StrategyControl->numBufferAllocs, 0);
 	}
+	if (num_backend_writes)
+	{
+		*num_backend_writes = pg_atomic_exchange_u32(&StrategyControl->numBackendWrites, 0);
+	}
 	SpinLockRelease(&StrategyControl->buffer_strategy_lock);
 	return result;
 }
 
+/*
+ * StrategyReportBackendWrite -- count a backend-initiated eviction write
+ *
+ * Called by bufmgr when a backend has to write out a dirty buffer itself in
+ * order to reclaim it.  The count is handed to the bgwriter through
+ * StrategySyncStart; each such write is evidence that the bgwriter is not
+ * keeping far enough ahead of the clock sweep.
+ */
+void
+StrategyReportBackendWrite(void)
+{
+	pg_atomic_fetch_add_u32(&StrategyControl->numBackendWrites, 1);
+}
+
 /*
  * StrategyNotifyBgWriter -- set or clear allocation notification latch
  *
@@ -461,6 +653,10 @@ StrategyShmemSize(void)
 	/* size of the shared replacement strategy control block */
 	size = add_size(size, MAXALIGN(sizeof(BufferStrategyControl)));
 
+	/* size of the striped buffer free lists */
+	size = add_size(size, mul_size(NUM_BUFFER_FREE_LISTS,
+								   sizeof(BufferFreeListPadded)));
+
 	return size;
 }
 
@@ -496,8 +692,17 @@ StrategyInitialize(bool init)
 						sizeof(BufferStrategyControl),
 						&found);
 
+	BufferFreeLists = (BufferFreeListPadded *)
+		ShmemInitStruct("Buffer Free Lists",
+						mul_size(NUM_BUFFER_FREE_LISTS,
+								 sizeof(BufferFreeListPadded)),
+						&found);
+
 	if (!found)
 	{
+		int			buffers_per_list;
+		int			i;
+
 		/*
 		 * Only done once, usually in postmaster
 		 */
@@ -506,11 +711,29 @@ StrategyInitialize(bool init)
 		SpinLockInit(&StrategyControl->buffer_strategy_lock);
 
 		/*
-		 * Grab the whole linked list of free buffers for our strategy. We
-		 * assume it was previously set up by InitBufferPool().
+		 * Carve the linked list of free buffers set up by InitBufferPool()
+		 * into one contiguous range per free list.  The list was linked in
+		 * buf_id order, so we need only terminate each range and record its
+		 * head and tail.
 		 */
-		StrategyControl->firstFreeBuffer = 0;
-		StrategyControl->lastFreeBuffer = NBuffers - 1;
+		buffers_per_list = (NBuffers + NUM_BUFFER_FREE_LISTS - 1) /
+			NUM_BUFFER_FREE_LISTS;
+		for (i = 0; i < NUM_BUFFER_FREE_LISTS; i++)
+		{
+			BufferFreeList *list = &BufferFreeLists[i].list;
+			int			first = i * buffers_per_list;
+			int			last = Min(first + buffers_per_list, NBuffers) - 1;
+
+			SpinLockInit(&list->free_list_lock);
+			if (first < NBuffers)
+			{
+				list->firstFreeBuffer = first;
+				list->lastFreeBuffer = last;
+				GetBufferDescriptor(last)->freeNext = FREENEXT_END_OF_LIST;
+			}
+			else
+				list->firstFreeBuffer = -1;
+		}
 
 		/* Initialize the clock sweep pointer */
 		pg_atomic_init_u32(&StrategyControl->nextVictimBuffer, 0);
@@ -518,6 +741,7 @@ StrategyInitialize(bool init)
 		/* Clear statistics */
 		StrategyControl->completePasses = 0;
 		pg_atomic_init_u32(&StrategyControl->numBufferAllocs, 0);
+		pg_atomic_init_u32(&StrategyControl->numBackendWrites, 0);
 
 		/* No pending notification */
 		StrategyControl->bgwprocno = -1;
@@ -557,7 +781,7 @@ GetAccessStrategy(BufferAccessStrategyType btype)
 			return NULL;
 
 		case BAS_BULKREAD:
-			ring_size = 256 * 1024 / BLCKSZ;
+			ring_size = bulk_read_ring_size / (BLCKSZ / 1024);
 			break;
 		case BAS_BULKWRITE:
 			ring_size = 16 * 1024 * 1024 / BLCKSZ;
@@ -619,6 +843,20 @@ GetBufferFromRing(BufferAccessStrategy strategy, uint32 *buf_state)
 	if (++strategy->current >= strategy->ring_size)
 		strategy->current = 0;
 
+	/*
+	 * While the buffer pool still has completely free buffers, don't recycle
+	 * the ring: evicting our own recently read pages while most of
+	 * shared_buffers sits cold helps nobody.  Allocating normally fills this
+	 * ring slot with the free buffer instead, and once the free lists are
+	 * exhausted the ring resumes recycling as usual, so scan-resistance in
+	 * a warm pool is unaffected.
+	 */
+	if (have_free_buffer())
+	{
+		strategy->current_was_in_ring = false;
+		return NULL;
+	}
+
 	/*
 	 * If the slot hasn't been filled yet, tell the caller to allocate a new
 	 * buffer with the normal allocation strategy.  He will then fill this
@@ -42,6 +42,7 @@
 #include "postgres.h"
 
 #include "commands/tablespace.h"
+#include "common/pg_lzcompress.h"
 #include "executor/instrument.h"
 #include "miscadmin.h"
 #include "pgstat.h"
@@ -72,6 +73,7 @@ struct BufFile
 	bool		isInterXact;	/* keep open over transactions? */
 	bool		dirty;			/* does buffer need to be written? */
 	bool		readOnly;		/* has the file been set to read only? */
+	bool		compress;		/* compress buffers on disk? */
 
 	SharedFileSet *fileset;		/* space for segment files if shared */
 	const char *name;			/* name of this BufFile if shared */
@@ -91,6 +93,7 @@ struct BufFile
 	off_t		curOffset;		/* offset part of current pos */
 	int			pos;			/* next read/write position in buffer */
 	int			nbytes;			/* total # of valid bytes in buffer */
+	char	   *cbuffer;		/* compressed-data workspace, if compress */
 	PGAlignedBlock buffer;
 };
 
@@ -98,7 +101,11 @@ static BufFile *makeBufFileCommon(int nfiles);
 static BufFile *makeBufFile(File firstfile);
 static void extendBufFile(BufFile *file);
 static void BufFileLoadBuffer(BufFile *file);
+static void BufFileLoadCompressedBuffer(BufFile *file);
+static size_t BufFileLoadRawBytes(BufFile *file, void *ptr, size_t size);
 static void BufFileDumpBuffer(BufFile *file);
+static void BufFileDumpCompressedBuffer(BufFile *file);
+static bool BufFileDumpRawBytes(BufFile *file, const char *ptr, int nbytes);
 static int	BufFileFlush(BufFile *file);
 static File MakeNewSharedSegment(BufFile *file, int segment);
 
@@ -113,11 +120,13 @@ makeBufFileCommon(int nfiles)
 	file->numFiles = nfiles;
 	file->isInterXact = false;
 	file->dirty = false;
+	file->compress = false;
 	file->resowner = CurrentResourceOwner;
 	file->curFile = 0;
 	file->curOffset = 0L;
 	file->pos = 0;
 	file->nbytes = 0;
+	file->cbuffer = NULL;
 
 	return file;
 }
@@ -206,6 +215,24 @@ BufFileCreateTemp(bool interXact)
 	return file;
 }
 
+/*
+ * Create a BufFile that compresses each buffer with pglz before it is
+ * written out, for spill files that are written and read strictly
+ * sequentially (such as hash join batch files).
+ *
+ * Because the on-disk blocks are variable length, the only supported
+ * repositioning of such a file is rewinding to the start; see BufFileSeek.
+ */
+BufFile *
+BufFileCreateCompressTemp(bool interXact)
+{
+	BufFile    *file = BufFileCreateTemp(interXact);
+
+	file->compress = true;
+
+	return file;
+}
+
 /*
  * Build the name for a given segment of a given BufFile.
  */
@@ -398,6 +425,8 @@ BufFileClose(BufFile *file)
 	for (i = 0; i < file->numFiles; i++)
 		FileClose(file->files[i]);
 	/* release the buffer space */
+	if (file->cbuffer)
+		pfree(file->cbuffer);
 	pfree(file->files);
 	pfree(file);
 }
@@ -414,6 +443,12 @@ BufFileLoadBuffer(BufFile *file)
 {
 	File		thisfile;
 
+	if (file->compress)
+	{
+		BufFileLoadCompressedBuffer(file);
+		return;
+	}
+
 	/*
 	 * Advance to next component file if necessary and possible.
 	 */
@@ -441,6 +476,100 @@ BufFileLoadBuffer(BufFile *file)
 		pgBufferUsage.temp_blks_read++;
 }
 
+/*
+ * BufFileLoadRawBytes
+ *
+ * Read exactly the next "size" physical bytes into "ptr", advancing
+ * curOffset across component-file boundaries as needed.  Returns the number
+ * of bytes actually read, which is only less than "size" at end of file.
+ */
+static size_t
+BufFileLoadRawBytes(BufFile *file, void *ptr, size_t size)
+{
+	size_t		nread = 0;
+
+	while (size > 0)
+	{
+		File		thisfile;
+		int			nthistime;
+
+		/*
+		 * Advance to next component file if necessary and possible.
+		 */
+		if (file->curOffset >= MAX_PHYSICAL_FILESIZE &&
+			file->curFile + 1 < file->numFiles)
+		{
+			file->curFile++;
+			file->curOffset = 0L;
+		}
+
+		thisfile = file->files[file->curFile];
+		nthistime = FileRead(thisfile,
+							 (char *) ptr + nread,
+							 size,
+							 file->curOffset,
+							 WAIT_EVENT_BUFFILE_READ);
+		if (nthistime <= 0)
+			break;				/* end of this (and hence the) file */
+		file->curOffset += nthistime;
+		nread += nthistime;
+		size -= nthistime;
+	}
+
+	return nread;
+}
+
+/*
+ * BufFileLoadCompressedBuffer
+ *
+ * Load the next compressed block into the buffer.  Each block on disk is a
+ * pair of uint16 lengths (raw length, stored length) followed by the stored
+ * payload; equal lengths mean the payload was stored uncompressed.  Unlike
+ * BufFileLoadBuffer, this advances curOffset past the consumed bytes, since
+ * the physical and logical positions of a compressed file do not correspond.
+ */
+static void
+BufFileLoadCompressedBuffer(BufFile *file)
+{
+	uint16		lengths[2];
+	size_t		nread;
+
+	nread = BufFileLoadRawBytes(file, lengths, sizeof(lengths));
+	if (nread == 0)
+		return;					/* end of file, nbytes stays 0 */
+	if (nread != sizeof(lengths) ||
+		lengths[0] > BLCKSZ || lengths[1] > lengths[0])
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg("compressed temporary file is corrupt")));
+
+	if (lengths[1] == lengths[0])
+	{
+		/* stored uncompressed */
+		if (BufFileLoadRawBytes(file, file->buffer.data,
+								lengths[0]) != lengths[0])
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("compressed temporary file is corrupt")));
+	}
+	else
+	{
+		if (file->cbuffer == NULL)
+			file->cbuffer = palloc(PGLZ_MAX_OUTPUT(BLCKSZ));
+
+		if (BufFileLoadRawBytes(file, file->cbuffer,
+								lengths[1]) != lengths[1] ||
+			pglz_decompress(file->cbuffer, lengths[1],
+							file->buffer.data, lengths[0], true) < 0)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("compressed temporary file is corrupt")));
+	}
+
+	file->nbytes = lengths[0];
+	pgBufferUsage.temp_blks_read++;
+}
+
 /*
  * BufFileDumpBuffer
  *
@@ -455,6 +584,12 @@ BufFileDumpBuffer(BufFile *file)
 	int			bytestowrite;
 	File		thisfile;
 
+	if (file->compress)
+	{
+		BufFileDumpCompressedBuffer(file);
+		return;
+	}
+
 	/*
 	 * Unlike BufFileLoadBuffer, we must dump the whole buffer even if it
 	 * crosses a component-file boundary; so we need a loop.
@@ -519,6 +654,106 @@ BufFileDumpBuffer(BufFile *file)
 	file->nbytes = 0;
 }
 
+/*
+ * BufFileDumpRawBytes
+ *
+ * Write "nbytes" physical bytes from "ptr" at curOffset, advancing across
+ * component-file boundaries as needed.  Returns true if all bytes were
+ * written.
+ */
+static bool
+BufFileDumpRawBytes(BufFile *file, const char *ptr, int nbytes)
+{
+	int			wpos = 0;
+
+	while (wpos < nbytes)
+	{
+		off_t		availbytes;
+		int			bytestowrite;
+		File		thisfile;
+
+		/*
+		 * Advance to next component file if necessary and possible.
+		 */
+		if (file->curOffset >= MAX_PHYSICAL_FILESIZE)
+		{
+			while (file->curFile + 1 >= file->numFiles)
+				extendBufFile(file);
+			file->curFile++;
+			file->curOffset = 0L;
+		}
+
+		/*
+		 * Determine how much we need to write into this file.
+		 */
+		bytestowrite = nbytes - wpos;
+		availbytes = MAX_PHYSICAL_FILESIZE - file->curOffset;
+
+		if ((off_t) bytestowrite > availbytes)
+			bytestowrite = (int) availbytes;
+
+		thisfile = file->files[file->curFile];
+		bytestowrite = FileWrite(thisfile,
+								 unconstify(char *, ptr) + wpos,
+								 bytestowrite,
+								 file->curOffset,
+								 WAIT_EVENT_BUFFILE_WRITE);
+		if (bytestowrite <= 0)
+			return false;		/* failed to write */
+		file->curOffset += bytestowrite;
+		wpos += bytestowrite;
+	}
+
+	return true;
+}
+
+/*
+ * BufFileDumpCompressedBuffer
+ *
+ * Compress the buffer with pglz and write it out as a block of the format
+ * described in BufFileLoadCompressedBuffer.  If the data does not compress,
+ * store it raw.  Only strictly sequential writing is supported, so on
+ * success the buffer is left empty with curOffset pointing just past the
+ * block written.
+ */
+static void
+BufFileDumpCompressedBuffer(BufFile *file)
+{
+	uint16		lengths[2];
+	const char *payload;
+	int32		complen;
+
+	/* compressed files may not mix writes into buffered read data */
+	Assert(file->pos == file->nbytes);
+
+	if (file->cbuffer == NULL)
+		file->cbuffer = palloc(PGLZ_MAX_OUTPUT(BLCKSZ));
+
+	complen = pglz_compress(file->buffer.data, file->nbytes,
+							file->cbuffer, PGLZ_strategy_default);
+	if (complen < 0)
+	{
+		/* incompressible, store it raw */
+		payload = file->buffer.data;
+		complen = file->nbytes;
+	}
+	else
+		payload = file->cbuffer;
+
+	lengths[0] = (uint16) file->nbytes;
+	lengths[1] = (uint16) complen;
+
+	if (!BufFileDumpRawBytes(file, (const char *) lengths, sizeof(lengths)) ||
+		!BufFileDumpRawBytes(file, payload, complen))
+		return;					/* failed to write, leave buffer dirty */
+
+	pgBufferUsage.temp_blks_written++;
+
+	file->dirty = false;
+	file->pos = 0;
+	file->nbytes = 0;
+}
+
 /*
  * BufFileRead
  *
@@ -541,8 +776,13 @@ BufFileRead(BufFile *file, void *ptr, size_t size)
 	{
 		if (file->pos >= file->nbytes)
 		{
-			/* Try to load more data into buffer. */
-			file->curOffset += file->pos;
+			/*
+			 * Try to load more data into buffer.  For a compressed file the
+			 * physical position does not track the logical one, and is
+			 * advanced by the load itself.
+			 */
+			if (!file->compress)
+				file->curOffset += file->pos;
 			file->pos = 0;
 			file->nbytes = 0;
 			BufFileLoadBuffer(file);
@@ -593,6 +833,7 @@ BufFileWrite(BufFile *file, void *ptr, size_t size)
 			else
 			{
 				/* Hmm, went directly from reading to writing? */
+				Assert(!file->compress);
 				file->curOffset += file->pos;
 				file->pos = 0;
 				file->nbytes = 0;
@@ -652,6 +893,24 @@ BufFileSeek(BufFile *file, int fileno, off_t offset, int whence)
 	int			newFile;
 	off_t		newOffset;
 
+	if (file->compress)
+	{
+		/*
+		 * Blocks of a compressed file are variable length, so arbitrary
+		 * repositioning is not possible; only rewinding to the start of the
+		 * file is supported.
+		 */
+		if (whence != SEEK_SET || fileno != 0 || offset != 0)
+			return EOF;
+		if (BufFileFlush(file) != 0)
+			return EOF;
+		file->curFile = 0;
+		file->curOffset = 0L;
+		file->pos = 0;
+		file->nbytes = 0;
+		return 0;
+	}
+
 	switch (whence)
 	{
 		case SEEK_SET:
@@ -132,6 +132,16 @@
  */
 int			max_files_per_process = 1000;
 
+/*
+ * Soft per-process budget of kernel FDs kept open for cached VFDs; -1 means
+ * no limit short of max_safe_fds.  On clusters with very many relation
+ * segment files, every backend otherwise creeps up to max_safe_fds and stays
+ * there, and further opens proceed only by evicting someone else's
+ * still-warm fd.  A budget below max_safe_fds keeps the per-backend cache to
+ * the files it actually revisits and returns the rest to the kernel early.
+ */
+int			max_cached_files = -1;
+
 /*
  * Maximum number of file descriptors to open for either VFD entries or
  * AllocateFile/AllocateDir/OpenTransientFile operations.  This is initialized
@@ -148,6 +158,9 @@ int			max_safe_fds = 32;	/* default if not changed */
 /* Whether it is safe to continue running after fsync() fails. */
 bool		data_sync_retry = false;
 
+/* How SyncDataDirectory() should do its job. */
+int			recovery_init_sync_method = RECOVERY_INIT_SYNC_METHOD_FSYNC;
+
 /* Debugging.... */
 
 #ifdef FDDEBUG
@@ -269,6 +282,7 @@ static int	nextTempTableSpace = 0;
  * LruInsert	   - put a file at the front of the Lru ring and open it
  * ReleaseLruFile  - Release an fd by closing the last entry in the Lru ring
  * ReleaseLruFiles - Release fd(s) until we're under the max_safe_fds limit
+ * ReleaseColdFiles - Release fd(s) until we're within the max_cached_files budget
  * AllocateVfd	   - grab a free (or new) file record (from VfdCache)
  * FreeVfd		   - free a file record
  *
@@ -297,6 +311,7 @@ static void Insert(File file);
 static int	LruInsert(File file);
 static bool ReleaseLruFile(void);
 static void ReleaseLruFiles(void);
+static void ReleaseColdFiles(void);
 static File AllocateVfd(void);
 static void FreeVfd(File file);
 
@@ -1153,6 +1168,28 @@ ReleaseLruFiles(void)
 		if (!ReleaseLruFile())
 			break;
 	}
+
+	/* also respect the DBA-imposed fd budget, if any */
+	ReleaseColdFiles();
+}
+
+/*
+ * Release kernel FDs as needed to get within the max_cached_files budget.
+ *
+ * This closes the coldest cached fds first, so a backend whose working set
+ * fits within the budget never loses a file it is actively using.
+ */
+static void
+ReleaseColdFiles(void)
+{
+	if (max_cached_files < 0)
+		return;
+
+	while (nfile > max_cached_files)
+	{
+		if (!ReleaseLruFile())
+			break;
+	}
 }
 
 static File
@@ -2028,6 +2065,49 @@ FileSync(File file, uint32 wait_event_info)
 	return returnCode;
 }
 
+/*
+ * FileFallocate - reserve disk space for the byte range of a file
+ *
+ * Space becomes allocated on disk and reads of the range return zeroes,
+ * without the data having to be written out first.  Returns 0 on success,
+ * -1 with errno set otherwise.  On platforms without posix_fallocate() we
+ * fail with EINVAL, and the caller is expected to fall back to writing
+ * zeroes.
+ */
+int
+FileFallocate(File file, off_t offset, off_t amount, uint32 wait_event_info)
+{
+#ifdef HAVE_POSIX_FALLOCATE
+	int			returnCode;
+
+	Assert(FileIsValid(file));
+
+	DO_DB(elog(LOG, "FileFallocate: %d (%s) " INT64_FORMAT " " INT64_FORMAT,
+			   file, VfdCache[file].fileName,
+			   (int64) offset, (int64) amount));
+
+	returnCode = FileAccess(file);
+	if (returnCode < 0)
+		return returnCode;
+
+retry:
+	pgstat_report_wait_start(wait_event_info);
+	returnCode = posix_fallocate(VfdCache[file].fd, offset, amount);
+	pgstat_report_wait_end();
+
+	if (returnCode == 0)
+		return 0;
+	else if (returnCode == EINTR)
+		goto retry;
+
+	/* for compatibility with %m printing etc */
+	errno = returnCode;
+#else
+	errno = EINVAL;
+#endif
+	return -1;
+}
+
 off_t
 FileSize(File file)
 {
@@ -2775,6 +2855,12 @@ AtEOSubXact_Files(bool isCommit, SubTransactionId mySubid,
  *
  * The isCommit flag is used only to decide whether to emit warnings about
  * unclosed files.
+ *
+ * This is also a convenient point to enforce the max_cached_files budget:
+ * trimming here (rather than only when opening yet another file) means a
+ * backend gives surplus kernel FDs back promptly once its transaction is
+ * over, and a reduction of the budget takes effect without waiting for the
+ * backend to open anything new.
  */
 void
 AtEOXact_Files(bool isCommit)
@@ -2782,6 +2868,7 @@ AtEOXact_Files(bool isCommit)
 	CleanupTempFiles(isCommit, false);
 	tempTableSpaces = NULL;
 	numTempTableSpaces = -1;
+	ReleaseColdFiles();
 }
 
 /*
@@ -3108,8 +3195,37 @@ looks_like_temp_rel_name(const char *name)
 }
 
 
+#ifdef HAVE_SYNCFS
 /*
- * Issue fsync recursively on PGDATA and all its contents.
+ * Sync the whole filesystem containing the given path, logging (but not
+ * raising) any error.
+ */
+static void
+do_syncfs(const char *path)
+{
+	int			fd;
+
+	fd = OpenTransientFile(path, O_RDONLY);
+	if (fd < 0)
+	{
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not open file \"%s\": %m", path)));
+		return;
+	}
+	if (syncfs(fd) < 0)
+		ereport(LOG,
+				(errcode_for_file_access(),
+				 errmsg("could not synchronize file system for file \"%s\": %m",
+						path)));
+	CloseTransientFile(fd);
+}
+#endif							/* HAVE_SYNCFS */
+
+/*
+ * Issue fsync recursively on PGDATA and all its contents, or issue syncfs()
+ * for all potential filesystems, depending on the recovery_init_sync_method
+ * setting.
  *
  * We fsync regular files and directories wherever they are, but we
  * follow symlinks only for pg_wal and immediately under pg_tblspc.
@@ -3161,6 +3277,41 @@ SyncDataDirectory(void)
 		xlog_is_symlink = true;
 #endif
 
+#ifdef HAVE_SYNCFS
+	if (recovery_init_sync_method == RECOVERY_INIT_SYNC_METHOD_SYNCFS)
+	{
+		DIR		   *dir;
+		struct dirent *de;
+
+		/*
+		 * On Linux, we don't have to open every single file one by one.  We
+		 * can use syncfs() to sync whole filesystems.  We only expect
+		 * filesystem boundaries to exist where we tolerate symlinks, namely
+		 * pg_wal and the tablespaces, so we call syncfs() for the data
+		 * directory, each of the tablespaces, and pg_wal if it's a symlink.
+		 */
+
+		/* Sync the top level pgdata directory. */
+		do_syncfs(".");
+		/* If any tablespaces are configured, sync each of those. */
+		dir = AllocateDir("pg_tblspc");
+		while ((de = ReadDirExtended(dir, "pg_tblspc", LOG)))
+		{
+			char		path[MAXPGPATH];
+
+			if (strcmp(de->d_name, ".") == 0 || strcmp(de->d_name, "..") == 0)
+				continue;
+			snprintf(path, MAXPGPATH, "pg_tblspc/%s", de->d_name);
+			do_syncfs(path);
+		}
+		FreeDir(dir);
+		/* If pg_wal is a symlink, process that too. */
+		if (xlog_is_symlink)
+			do_syncfs("pg_wal");
+		return;
+	}
+#endif							/* !HAVE_SYNCFS */
+
 	/*
 	 * If possible, hint to the kernel that we're soon going to fsync the data
 	 * directory and its contents.  Errors in this step are even less
@@ -112,6 +112,19 @@ static uint8 fsm_vacuum_page(Relation rel, FSMAddress addr,
 							 BlockNumber start, BlockNumber end,
 							 bool *eof);
 
+/*
+ * Per-backend cache of the bottom-level FSM page that most recently
+ * satisfied a search.  A leaf FSM page covers SlotsPerFSMPage heap pages,
+ * so as long as that neighborhood keeps having free space, repeat searches
+ * can go straight to it and skip the descent through the root and mid-level
+ * pages, which are shared by every inserter into the relation.  The cache
+ * is just a hint: if the leaf no longer has enough space (or belongs to a
+ * different relation), we fall back to a full search.
+ */
+static RelFileNode fsm_cached_rnode;
+static FSMAddress fsm_cached_addr;
+static bool fsm_cached_valid = false;
+
 
 /******** Public API ********/
 
@@ -133,6 +146,32 @@ GetPageWithFreeSpace(Relation rel, Size spaceNeeded)
 {
 	uint8		min_cat = fsm_space_needed_to_cat(spaceNeeded);
 
+	/*
+	 * First try the leaf FSM page that satisfied our last search of this
+	 * relation, bypassing the upper levels of the tree.
+	 */
+	if (fsm_cached_valid &&
+		RelFileNodeEquals(fsm_cached_rnode, rel->rd_node))
+	{
+		Buffer		buf;
+
+		buf = fsm_readbuf(rel, fsm_cached_addr, false);
+		if (BufferIsValid(buf))
+		{
+			int			slot;
+
+			LockBuffer(buf, BUFFER_LOCK_SHARE);
+			slot = fsm_search_avail(buf, min_cat, true, false, -1);
+			UnlockReleaseBuffer(buf);
+
+			if (slot != -1)
+				return fsm_get_heap_blk(fsm_cached_addr, slot);
+		}
+
+		/* No luck there; forget the hint and search from the top */
+		fsm_cached_valid = false;
+	}
+
 	return fsm_search(rel, min_cat);
 }
 
@@ -165,7 +204,14 @@ RecordAndGetPageWithFreeSpace(Relation rel, BlockNumber oldPage,
 	 * Otherwise, search as usual.
 	 */
 	if (search_slot != -1)
+	{
+		/* Remember this leaf page for the next search */
+		fsm_cached_rnode = rel->rd_node;
+		fsm_cached_addr = addr;
+		fsm_cached_valid = true;
+
 		return fsm_get_heap_blk(addr, search_slot);
+	}
 	else
 		return fsm_search(rel, search_cat);
 }
@@ -672,7 +718,7 @@ fsm_set_and_search(Relation rel, FSMAddress addr, uint16 slot,
 		/* Search while we still hold the lock */
 		newslot = fsm_search_avail(buf, minValue,
 								   addr.level == FSM_BOTTOM_LEVEL,
-								   true);
+								   true, -1);
 	}
 
 	UnlockReleaseBuffer(buf);
@@ -701,10 +747,21 @@ fsm_search(Relation rel, uint8 min_cat)
 		/* Search within the page */
 		if (BufferIsValid(buf))
 		{
+			int			start_slot = -1;
+
+			/*
+			 * At the root, start the search at a randomly chosen slot
+			 * rather than the page's shared next-slot hint, so that
+			 * concurrent inserters descend into different subtrees instead
+			 * of stampeding toward the same heap pages.
+			 */
+			if (addr.level == FSM_ROOT_LEVEL)
+				start_slot = random() % SlotsPerFSMPage;
+
 			LockBuffer(buf, BUFFER_LOCK_SHARE);
 			slot = fsm_search_avail(buf, min_cat,
 									(addr.level == FSM_BOTTOM_LEVEL),
-									false);
+									false, start_slot);
 			if (slot == -1)
 				max_avail = fsm_get_max_avail(BufferGetPage(buf));
 			UnlockReleaseBuffer(buf);
@@ -719,7 +776,14 @@ fsm_search(Relation rel, uint8 min_cat)
 			 * bottom.
 			 */
 			if (addr.level == FSM_BOTTOM_LEVEL)
+			{
+				/* Remember this leaf page for the next search */
+				fsm_cached_rnode = rel->rd_node;
+				fsm_cached_addr = addr;
+				fsm_cached_valid = true;
+
 				return fsm_get_heap_blk(addr, slot);
+			}
 
 			addr = fsm_get_child(addr, slot);
 		}
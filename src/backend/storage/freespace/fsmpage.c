@@ -153,10 +153,16 @@ fsm_get_max_avail(Page page)
  *
  * If advancenext is false, fp_next_slot is set to point to the returned
  * slot, and if it's true, to the slot after the returned slot.
+ *
+ * start_slot determines where the search begins: normally pass -1 to start
+ * from the page's shared fp_next_slot hint, but a caller can pass a slot
+ * number of its own choosing (for instance a randomized one, to spread
+ * concurrent searchers over the page instead of having them all chase the
+ * same hint).
  */
 int
 fsm_search_avail(Buffer buf, uint8 minvalue, bool advancenext,
-				 bool exclusive_lock_held)
+				 bool exclusive_lock_held, int start_slot)
 {
 	Page		page = BufferGetPage(buf);
 	FSMPage		fsmpage = (FSMPage) PageGetContents(page);
@@ -174,11 +180,14 @@ restart:
 		return -1;
 
 	/*
-	 * Start search using fp_next_slot.  It's just a hint, so check that it's
-	 * sane.  (This also handles wrapping around when the prior call returned
-	 * the last slot on the page.)
+	 * Start search using the caller-provided slot, or failing that the
+	 * page's fp_next_slot.  Either is just a hint, so check that it's sane.
+	 * (This also handles wrapping around when the prior call returned the
+	 * last slot on the page.)
 	 */
-	target = fsmpage->fp_next_slot;
+	target = start_slot;
+	if (target < 0 || target >= LeafNodesPerPage)
+		target = fsmpage->fp_next_slot;
 	if (target < 0 || target >= LeafNodesPerPage)
 		target = 0;
 	target += NonLeafNodesPerPage;
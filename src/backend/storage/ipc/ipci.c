@@ -36,6 +36,7 @@
 #include "replication/origin.h"
 #include "storage/bufmgr.h"
 #include "storage/dsm.h"
+#include "storage/iostats.h"
 #include "storage/ipc.h"
 #include "storage/pg_shmem.h"
 #include "storage/pmsignal.h"
@@ -96,6 +97,14 @@ CreateSharedMemoryAndSemaphores(void)
 {
 	PGShmemHeader *shim = NULL;
 
+	/*
+	 * Determine the number of fast-path lock groups before sizing anything;
+	 * the per-backend fast-path arrays in ProcGlobalShmemSize() depend on
+	 * it.  In the EXEC_BACKEND case this also initializes the value in each
+	 * backend.
+	 */
+	InitializeFastPathLocks();
+
 	if (!IsUnderPostmaster)
 	{
 		PGShmemHeader *seghdr;
@@ -149,6 +158,8 @@ CreateSharedMemoryAndSemaphores(void)
 		size = add_size(size, SyncScanShmemSize());
 		size = add_size(size, AsyncShmemSize());
 		size = add_size(size, UndoShmemSize());
+		size = add_size(size, IOStatsShmemSize());
+		size = add_size(size, dsm_estimate_size());
 #ifdef EXEC_BACKEND
 		size = add_size(size, ShmemBackendArraySize());
 #endif
@@ -266,6 +277,13 @@ CreateSharedMemoryAndSemaphores(void)
 	SyncScanShmemInit();
 	AsyncShmemInit();
 	UndoShmemInit();
+	IOStatsShmemInit();
+
+	/*
+	 * Set up the space preallocated for dynamic shared memory segments,
+	 * if any.
+	 */
+	dsm_shmem_init();
 
 #ifdef EXEC_BACKEND
 
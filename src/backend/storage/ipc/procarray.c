@@ -106,6 +106,7 @@ static PGXACT *allPgXact;
  */
 static TransactionId *KnownAssignedXids;
 static bool *KnownAssignedXidsValid;
+static int32 *KnownAssignedXidsNext;
 static TransactionId latestObservedXid = InvalidTransactionId;
 
 /*
@@ -172,6 +173,7 @@ static void KnownAssignedXidsReset(void);
 static inline void ProcArrayEndTransactionInternal(PGPROC *proc,
 												   PGXACT *pgxact, TransactionId latestXid);
 static void ProcArrayGroupClearXid(PGPROC *proc, TransactionId latestXid);
+static bool GetSnapshotDataReuse(Snapshot snapshot);
 
 /*
  * Report shared-memory space needed by CreateSharedProcArray.
@@ -210,6 +212,8 @@ ProcArrayShmemSize(void)
 								 TOTAL_MAX_CACHED_SUBXIDS));
 		size = add_size(size,
 						mul_size(sizeof(bool), TOTAL_MAX_CACHED_SUBXIDS));
+		size = add_size(size,
+						mul_size(sizeof(int32), TOTAL_MAX_CACHED_SUBXIDS));
 	}
 
 	return size;
@@ -263,6 +267,10 @@ CreateSharedProcArray(void)
 			ShmemInitStruct("KnownAssignedXidsValid",
 							mul_size(sizeof(bool), TOTAL_MAX_CACHED_SUBXIDS),
 							&found);
+		KnownAssignedXidsNext = (int32 *)
+			ShmemInitStruct("KnownAssignedXidsNext",
+							mul_size(sizeof(int32), TOTAL_MAX_CACHED_SUBXIDS),
+							&found);
 	}
 
 	LWLockRegisterTranche(LWTRANCHE_PROC, "proc");
@@ -270,14 +278,21 @@ CreateSharedProcArray(void)
 
 /*
  * Add the specified PGPROC to the shared array.
+ *
+ * We hold XidGenLock in addition to ProcArrayLock while relocating dense
+ * array entries, because GetNewTransactionId() updates its backend's
+ * entries holding only XidGenLock; see PROC_HDR.
  */
 void
 ProcArrayAdd(PGPROC *proc)
 {
 	ProcArrayStruct *arrayP = procArray;
+	PGXACT	   *pgxact = &allPgXact[proc->pgprocno];
 	int			index;
+	int			movecount;
 
 	LWLockAcquire(ProcArrayLock, LW_EXCLUSIVE);
+	LWLockAcquire(XidGenLock, LW_EXCLUSIVE);
 
 	if (arrayP->numProcs >= arrayP->maxProcs)
 	{
@@ -286,6 +301,7 @@ ProcArrayAdd(PGPROC *proc)
 		 * fixed supply of PGPROC structs too, and so we should have failed
 		 * earlier.)
 		 */
+		LWLockRelease(XidGenLock);
 		LWLockRelease(ProcArrayLock);
 		ereport(FATAL,
 				(errcode(ERRCODE_TOO_MANY_CONNECTIONS),
@@ -311,11 +327,35 @@ ProcArrayAdd(PGPROC *proc)
 			break;
 	}
 
+	movecount = arrayP->numProcs - index;
 	memmove(&arrayP->pgprocnos[index + 1], &arrayP->pgprocnos[index],
-			(arrayP->numProcs - index) * sizeof(int));
+			movecount * sizeof(*arrayP->pgprocnos));
+	memmove(&ProcGlobal->xids[index + 1], &ProcGlobal->xids[index],
+			movecount * sizeof(*ProcGlobal->xids));
+	memmove(&ProcGlobal->subxidStates[index + 1], &ProcGlobal->subxidStates[index],
+			movecount * sizeof(*ProcGlobal->subxidStates));
+	memmove(&ProcGlobal->vacuumFlags[index + 1], &ProcGlobal->vacuumFlags[index],
+			movecount * sizeof(*ProcGlobal->vacuumFlags));
+
 	arrayP->pgprocnos[index] = proc->pgprocno;
+	proc->pgxactoff = index;
+	ProcGlobal->xids[index] = pgxact->xid;
+	ProcGlobal->subxidStates[index].count = pgxact->nxids;
+	ProcGlobal->subxidStates[index].overflowed = pgxact->overflowed;
+	ProcGlobal->vacuumFlags[index] = pgxact->vacuumFlags;
+
 	arrayP->numProcs++;
 
+	/* adjust pgxactoff for all procs that were shifted */
+	for (index++; index < arrayP->numProcs; index++)
+	{
+		int			procno = arrayP->pgprocnos[index];
+
+		Assert(allProcs[procno].pgxactoff == index - 1);
+		allProcs[procno].pgxactoff = index;
+	}
+
+	LWLockRelease(XidGenLock);
 	LWLockRelease(ProcArrayLock);
 }
 
@@ -333,6 +373,8 @@ void
 ProcArrayRemove(PGPROC *proc, TransactionId latestXid)
 {
 	ProcArrayStruct *arrayP = procArray;
+	int			myoff;
+	int			movecount;
 	int			index;
 
 #ifdef XIDCACHE_DEBUG
@@ -341,41 +383,59 @@ ProcArrayRemove(PGPROC *proc, TransactionId latestXid)
 		DisplayXidCache();
 #endif
 
+	/* See ProcArrayAdd's comment about holding both locks */
 	LWLockAcquire(ProcArrayLock, LW_EXCLUSIVE);
+	LWLockAcquire(XidGenLock, LW_EXCLUSIVE);
+
+	myoff = proc->pgxactoff;
+	Assert(myoff >= 0 && myoff < arrayP->numProcs);
+	Assert(arrayP->pgprocnos[myoff] == proc->pgprocno);
 
 	if (TransactionIdIsValid(latestXid))
 	{
 		Assert(TransactionIdIsValid(allPgXact[proc->pgprocno].xid));
+		Assert(TransactionIdIsValid(ProcGlobal->xids[myoff]));
 
 		/* Advance global latestCompletedXid while holding the lock */
 		if (TransactionIdPrecedes(ShmemVariableCache->latestCompletedXid,
 								  latestXid))
 			ShmemVariableCache->latestCompletedXid = latestXid;
+
+		/* Same with xactCompletionCount */
+		ShmemVariableCache->xactCompletionCount++;
 	}
 	else
 	{
 		/* Shouldn't be trying to remove a live transaction here */
 		Assert(!TransactionIdIsValid(allPgXact[proc->pgprocno].xid));
+		Assert(!TransactionIdIsValid(ProcGlobal->xids[myoff]));
 	}
 
-	for (index = 0; index < arrayP->numProcs; index++)
+	/* Keep the PGPROC array sorted. See notes above */
+	movecount = arrayP->numProcs - myoff - 1;
+	memmove(&arrayP->pgprocnos[myoff], &arrayP->pgprocnos[myoff + 1],
+			movecount * sizeof(*arrayP->pgprocnos));
+	memmove(&ProcGlobal->xids[myoff], &ProcGlobal->xids[myoff + 1],
+			movecount * sizeof(*ProcGlobal->xids));
+	memmove(&ProcGlobal->subxidStates[myoff], &ProcGlobal->subxidStates[myoff + 1],
+			movecount * sizeof(*ProcGlobal->subxidStates));
+	memmove(&ProcGlobal->vacuumFlags[myoff], &ProcGlobal->vacuumFlags[myoff + 1],
+			movecount * sizeof(*ProcGlobal->vacuumFlags));
+
+	arrayP->pgprocnos[arrayP->numProcs - 1] = -1;	/* for debugging */
+	arrayP->numProcs--;
+
+	/* adjust pgxactoff for all procs that were shifted */
+	for (index = myoff; index < arrayP->numProcs; index++)
 	{
-		if (arrayP->pgprocnos[index] == proc->pgprocno)
-		{
-			/* Keep the PGPROC array sorted. See notes above */
-			memmove(&arrayP->pgprocnos[index], &arrayP->pgprocnos[index + 1],
-					(arrayP->numProcs - index - 1) * sizeof(int));
-			arrayP->pgprocnos[arrayP->numProcs - 1] = -1;	/* for debugging */
-			arrayP->numProcs--;
-			LWLockRelease(ProcArrayLock);
-			return;
-		}
+		int			procno = arrayP->pgprocnos[index];
+
+		Assert(allProcs[procno].pgxactoff == index + 1);
+		allProcs[procno].pgxactoff = index;
 	}
 
-	/* Oops */
+	LWLockRelease(XidGenLock);
 	LWLockRelease(ProcArrayLock);
-
-	elog(LOG, "failed to find proc %p in ProcArray", proc);
 }
 
 
@@ -431,11 +491,23 @@ ProcArrayEndTransaction(PGPROC *proc, TransactionId latestXid)
 
 		proc->lxid = InvalidLocalTransactionId;
 		pgxact->xmin = InvalidTransactionId;
-		/* must be cleared with xid/xmin: */
-		pgxact->vacuumFlags &= ~PROC_VACUUM_STATE_MASK;
 		pgxact->delayChkpt = false; /* be sure this is cleared in abort */
 		proc->recoveryConflictPending = false;
 
+		/*
+		 * The vacuum flags must be cleared with xid/xmin, but updating the
+		 * dense mirror requires ProcArrayLock; avoid taking it (and
+		 * unnecessarily dirtying shared cache lines) when no flags are set.
+		 */
+		if (pgxact->vacuumFlags & PROC_VACUUM_STATE_MASK)
+		{
+			LWLockAcquire(ProcArrayLock, LW_EXCLUSIVE);
+			Assert(ProcGlobal->vacuumFlags[proc->pgxactoff] == pgxact->vacuumFlags);
+			pgxact->vacuumFlags &= ~PROC_VACUUM_STATE_MASK;
+			ProcGlobal->vacuumFlags[proc->pgxactoff] = pgxact->vacuumFlags;
+			LWLockRelease(ProcArrayLock);
+		}
+
 		Assert(pgxact->nxids == 0);
 		Assert(pgxact->overflowed == false);
 	}
@@ -450,22 +522,33 @@ static inline void
 ProcArrayEndTransactionInternal(PGPROC *proc, PGXACT *pgxact,
 								TransactionId latestXid)
 {
+	int			pgxactoff = proc->pgxactoff;
+
+	Assert(ProcGlobal->xids[pgxactoff] == pgxact->xid);
+
 	pgxact->xid = InvalidTransactionId;
+	ProcGlobal->xids[pgxactoff] = InvalidTransactionId;
 	proc->lxid = InvalidLocalTransactionId;
 	pgxact->xmin = InvalidTransactionId;
 	/* must be cleared with xid/xmin: */
 	pgxact->vacuumFlags &= ~PROC_VACUUM_STATE_MASK;
+	ProcGlobal->vacuumFlags[pgxactoff] = pgxact->vacuumFlags;
 	pgxact->delayChkpt = false; /* be sure this is cleared in abort */
 	proc->recoveryConflictPending = false;
 
 	/* Clear the subtransaction-XID cache too while holding the lock */
 	pgxact->nxids = 0;
 	pgxact->overflowed = false;
+	ProcGlobal->subxidStates[pgxactoff].count = 0;
+	ProcGlobal->subxidStates[pgxactoff].overflowed = false;
 
 	/* Also advance global latestCompletedXid while holding the lock */
 	if (TransactionIdPrecedes(ShmemVariableCache->latestCompletedXid,
 							  latestXid))
 		ShmemVariableCache->latestCompletedXid = latestXid;
+
+	/* Same with xactCompletionCount */
+	ShmemVariableCache->xactCompletionCount++;
 }
 
 /*
@@ -599,25 +682,37 @@ void
 ProcArrayClearTransaction(PGPROC *proc)
 {
 	PGXACT	   *pgxact = &allPgXact[proc->pgprocno];
+	int			pgxactoff;
 
 	/*
-	 * We can skip locking ProcArrayLock here, because this action does not
-	 * actually change anyone's view of the set of running XIDs: our entry is
-	 * duplicate with the gxact that has already been inserted into the
-	 * ProcArray.
+	 * This action does not change anyone's view of the set of running XIDs
+	 * (our entry is duplicate with the gxact that has already been inserted
+	 * into the ProcArray), but we must hold ProcArrayLock while updating the
+	 * dense mirror arrays, since a concurrent ProcArrayAdd/Remove could
+	 * relocate our entries underneath us.
 	 */
+	LWLockAcquire(ProcArrayLock, LW_EXCLUSIVE);
+
+	pgxactoff = proc->pgxactoff;
+
 	pgxact->xid = InvalidTransactionId;
+	ProcGlobal->xids[pgxactoff] = InvalidTransactionId;
 	proc->lxid = InvalidLocalTransactionId;
 	pgxact->xmin = InvalidTransactionId;
 	proc->recoveryConflictPending = false;
 
 	/* redundant, but just in case */
 	pgxact->vacuumFlags &= ~PROC_VACUUM_STATE_MASK;
+	ProcGlobal->vacuumFlags[pgxactoff] = pgxact->vacuumFlags;
 	pgxact->delayChkpt = false;
 
 	/* Clear the subtransaction-XID cache too */
 	pgxact->nxids = 0;
 	pgxact->overflowed = false;
+	ProcGlobal->subxidStates[pgxactoff].count = 0;
+	ProcGlobal->subxidStates[pgxactoff].overflowed = false;
+
+	LWLockRelease(ProcArrayLock);
 }
 
 /*
@@ -1463,6 +1558,66 @@ GetMaxSnapshotSubxidCount(void)
 	return TOTAL_MAX_CACHED_SUBXIDS;
 }
 
+/*
+ * GetSnapshotDataReuse -- attempt to reuse a previously built snapshot
+ *
+ * If no transaction has completed since the given snapshot was built,
+ * rebuilding it from the proc array would yield exactly the same contents,
+ * so we can simply reuse it and skip the whole proc array scan.  The caller
+ * must hold ProcArrayLock (shared mode suffices), which prevents the
+ * completion count from moving under us.
+ *
+ * Note that transactions may well have started and been assigned XIDs since
+ * the snapshot was built; that doesn't invalidate it, since such XIDs are
+ * necessarily >= the snapshot's xmax and hence treated as still running
+ * anyway.
+ *
+ * Returns true if the snapshot was reused, in which case it has been
+ * refreshed the same way GetSnapshotData() would have refreshed it.
+ */
+static bool
+GetSnapshotDataReuse(Snapshot snapshot)
+{
+	uint64		curXactCompletionCount;
+
+	Assert(LWLockHeldByMe(ProcArrayLock));
+
+	if (unlikely(snapshot->snapXactCompletionCount == 0))
+		return false;
+
+	/*
+	 * If the "snapshot too old" feature is active we cannot reuse snapshots,
+	 * because the stale lsn and whenTaken would defeat the early-pruning
+	 * bookkeeping done by MaintainOldSnapshotTimeMapping().
+	 */
+	if (old_snapshot_threshold >= 0)
+		return false;
+
+	curXactCompletionCount = ShmemVariableCache->xactCompletionCount;
+	if (curXactCompletionCount != snapshot->snapXactCompletionCount)
+		return false;
+
+	/*
+	 * It's safe to re-install the snapshot's xmin as our advertised xmin
+	 * even though it may be older than what a fresh scan would compute: the
+	 * transaction it refers to was running when the snapshot was built and,
+	 * the completion count not having moved, is running still, so no
+	 * computed horizon can have advanced past it.
+	 */
+	if (!TransactionIdIsValid(MyPgXact->xmin))
+		MyPgXact->xmin = TransactionXmin = snapshot->xmin;
+
+	RecentXmin = snapshot->xmin;
+	Assert(TransactionIdPrecedesOrEquals(TransactionXmin, RecentXmin));
+
+	snapshot->curcid = GetCurrentCommandId(false);
+	snapshot->active_count = 0;
+	snapshot->regd_count = 0;
+	snapshot->copied = false;
+
+	return true;
+}
+
 /*
  * GetSnapshotData -- returns information about running transactions.
  *
@@ -1510,6 +1665,7 @@ GetSnapshotData(Snapshot snapshot)
 	int			count = 0;
 	int			subcount = 0;
 	bool		suboverflowed = false;
+	uint64		curXactCompletionCount;
 	TransactionId replication_slot_xmin = InvalidTransactionId;
 	TransactionId replication_slot_catalog_xmin = InvalidTransactionId;
 
@@ -1553,6 +1709,20 @@ GetSnapshotData(Snapshot snapshot)
 	 */
 	LWLockAcquire(ProcArrayLock, LW_SHARED);
 
+	/*
+	 * If nothing has committed or aborted since this backend last built a
+	 * snapshot, the previous one is still good; reuse it and skip the proc
+	 * array scan entirely.  This is the common case for back-to-back
+	 * statements on read-mostly systems.
+	 */
+	if (GetSnapshotDataReuse(snapshot))
+	{
+		LWLockRelease(ProcArrayLock);
+		return snapshot;
+	}
+
+	curXactCompletionCount = ShmemVariableCache->xactCompletionCount;
+
 	/* xmax is always latestCompletedXid + 1 */
 	xmax = ShmemVariableCache->latestCompletedXid;
 	Assert(TransactionIdIsNormal(xmax));
@@ -1566,12 +1736,20 @@ GetSnapshotData(Snapshot snapshot)
 	if (!snapshot->takenDuringRecovery)
 	{
 		int		   *pgprocnos = arrayP->pgprocnos;
+		TransactionId *other_xids = ProcGlobal->xids;
+		XidCacheStatus *subxidStates = ProcGlobal->subxidStates;
+		uint8	   *vacuumFlags = ProcGlobal->vacuumFlags;
+		int			mypgxactoff = MyProc->pgxactoff;
 		int			numProcs;
 
 		/*
 		 * Spin over procArray checking xid, xmin, and subxids.  The goal is
 		 * to gather all active xids, find the lowest xmin, and try to record
-		 * subxids.
+		 * subxids.  The hot transaction state is read from the dense mirror
+		 * arrays in ProcGlobal rather than the sparse PGXACT array, so we
+		 * touch consecutive cache lines for exactly the backends that are in
+		 * the procarray; only xmin (updated locklessly by its owner, and
+		 * hence not mirrored) still comes from PGXACT.
 		 */
 		numProcs = arrayP->numProcs;
 		for (index = 0; index < numProcs; index++)
@@ -1584,7 +1762,7 @@ GetSnapshotData(Snapshot snapshot)
 			 * Skip over backends doing logical decoding which manages xmin
 			 * separately (check below) and ones running LAZY VACUUM.
 			 */
-			if (pgxact->vacuumFlags &
+			if (vacuumFlags[index] &
 				(PROC_IN_LOGICAL_DECODING | PROC_IN_VACUUM))
 				continue;
 
@@ -1595,7 +1773,7 @@ GetSnapshotData(Snapshot snapshot)
 				globalxmin = xid;
 
 			/* Fetch xid just once - see GetNewTransactionId */
-			xid = UINT32_ACCESS_ONCE(pgxact->xid);
+			xid = UINT32_ACCESS_ONCE(other_xids[index]);
 
 			/*
 			 * If the transaction has no XID assigned, we can skip it; it
@@ -1613,7 +1791,7 @@ GetSnapshotData(Snapshot snapshot)
 			 */
 			if (NormalTransactionIdPrecedes(xid, xmin))
 				xmin = xid;
-			if (pgxact == MyPgXact)
+			if (index == mypgxactoff)
 				continue;
 
 			/* Add XID to snapshot. */
@@ -1636,11 +1814,11 @@ GetSnapshotData(Snapshot snapshot)
 			 */
 			if (!suboverflowed)
 			{
-				if (pgxact->overflowed)
+				if (subxidStates[index].overflowed)
 					suboverflowed = true;
 				else
 				{
-					int			nxids = pgxact->nxids;
+					int			nxids = subxidStates[index].count;
 
 					if (nxids > 0)
 					{
@@ -1745,6 +1923,7 @@ GetSnapshotData(Snapshot snapshot)
 	snapshot->xcnt = count;
 	snapshot->subxcnt = subcount;
 	snapshot->suboverflowed = suboverflowed;
+	snapshot->snapXactCompletionCount = curXactCompletionCount;
 
 	snapshot->curcid = GetCurrentCommandId(false);
 
@@ -3095,7 +3274,16 @@ XidCacheRemoveRunningXids(TransactionId xid,
 	if (j < 0 && !MyPgXact->overflowed)
 		elog(WARNING, "did not find subXID %u in MyProc", xid);
 
-	/* Also advance global latestCompletedXid while holding the lock */
+	/* Keep the dense subxid-state mirror in step */
+	ProcGlobal->subxidStates[MyProc->pgxactoff].count = MyPgXact->nxids;
+
+	/*
+	 * Also advance global latestCompletedXid while holding the lock.  There
+	 * is no need to advance xactCompletionCount, however: subtransaction
+	 * abort doesn't change the contents of any snapshot, since aborted
+	 * subtransaction XIDs are invisible whether they are listed as running
+	 * or looked up in pg_xact.
+	 */
 	if (TransactionIdPrecedes(ShmemVariableCache->latestCompletedXid,
 							  latestXid))
 		ShmemVariableCache->latestCompletedXid = latestXid;
@@ -3281,6 +3469,9 @@ ExpireTreeKnownAssignedTransactionIds(TransactionId xid, int nsubxids,
 							  max_xid))
 		ShmemVariableCache->latestCompletedXid = max_xid;
 
+	/* ... and xactCompletionCount */
+	ShmemVariableCache->xactCompletionCount++;
+
 	LWLockRelease(ProcArrayLock);
 }
 
@@ -3344,6 +3535,19 @@ ExpireOldKnownAssignedTransactionIds(TransactionId xid)
  * out the unused entries; that's much cheaper than having to compress the
  * array immediately on every deletion.
  *
+ * So that snapshot scans do not degrade to O(spread) when the array is
+ * sparse, a second parallel array KnownAssignedXidsNext[] records, for each
+ * position, how far to advance to reach the next possibly-valid element.
+ * New elements start with an offset of 1; the offsets over runs of invalid
+ * elements are widened lazily by scans, which remember the previous valid
+ * position they saw and write back the observed gap.  Since deletions and
+ * compression require exclusive ProcArrayLock, the validity map cannot
+ * change under a scan holding shared lock, so all concurrent scans compute
+ * and write identical offsets and the aligned int32 stores are safe.  An
+ * offset is thus never too large, merely possibly smaller than it could be,
+ * and a later scan will widen it; this gives snapshot cost that amortizes
+ * to the number of valid entries rather than the occupied spread.
+ *
  * The actually valid items in KnownAssignedXids[] and KnownAssignedXidsValid[]
  * are those with indexes tail <= i < head; items outside this subscript range
  * have unspecified contents.  When head reaches the end of the array, we
@@ -3380,7 +3584,8 @@ ExpireOldKnownAssignedTransactionIds(TransactionId xid)
  *		must happen)
  *	* Compressing the array is O(S) and requires exclusive lock
  *	* Removing an XID is O(logS) and requires exclusive lock
- *	* Taking a snapshot is O(S) and requires shared lock
+ *	* Taking a snapshot is O(S) worst case, amortizing towards O(N) as
+ *		the skip offsets absorb the gaps, and requires shared lock
  *	* Checking for an XID is O(logS) and requires shared lock
  *
  * In comparison, using a hash table for KnownAssignedXids would mean that
@@ -3446,6 +3651,7 @@ KnownAssignedXidsCompress(bool force)
 		{
 			KnownAssignedXids[compress_index] = KnownAssignedXids[i];
 			KnownAssignedXidsValid[compress_index] = true;
+			KnownAssignedXidsNext[compress_index] = 1;
 			compress_index++;
 		}
 	}
@@ -3548,6 +3754,7 @@ KnownAssignedXidsAdd(TransactionId from_xid, TransactionId to_xid,
 	{
 		KnownAssignedXids[head] = next_xid;
 		KnownAssignedXidsValid[head] = true;
+		KnownAssignedXidsNext[head] = 1;
 		TransactionIdAdvance(next_xid);
 		head++;
 	}
@@ -3837,6 +4044,7 @@ KnownAssignedXidsGetAndSetXmin(TransactionId *xarray, TransactionId *xmin,
 	int			head,
 				tail;
 	int			i;
+	int			prev = -1;
 
 	/*
 	 * Fetch head just once, since it may change while we loop. We can stop
@@ -3852,13 +4060,21 @@ KnownAssignedXidsGetAndSetXmin(TransactionId *xarray, TransactionId *xmin,
 	head = procArray->headKnownAssignedXids;
 	SpinLockRelease(&procArray->known_assigned_xids_lck);
 
-	for (i = tail; i < head; i++)
+	for (i = tail; i < head; i += KnownAssignedXidsNext[i])
 	{
 		/* Skip any gaps in the array */
 		if (KnownAssignedXidsValid[i])
 		{
 			TransactionId knownXid = KnownAssignedXids[i];
 
+			/*
+			 * Widen the skip offset of the previous valid element, so that
+			 * later scans step over the gap we just walked in one go.
+			 */
+			if (prev >= 0 && i - prev > KnownAssignedXidsNext[prev])
+				KnownAssignedXidsNext[prev] = i - prev;
+			prev = i;
+
 			/*
 			 * Update xmin if required.  Only the first XID need be checked,
 			 * since the array is sorted.
@@ -3902,7 +4118,7 @@ KnownAssignedXidsGetOldestXmin(void)
 	head = procArray->headKnownAssignedXids;
 	SpinLockRelease(&procArray->known_assigned_xids_lck);
 
-	for (i = tail; i < head; i++)
+	for (i = tail; i < head; i += KnownAssignedXidsNext[i])
 	{
 		/* Skip any gaps in the array */
 		if (KnownAssignedXidsValid[i])
@@ -71,7 +71,12 @@ void
 ReceiveSharedInvalidMessages(void (*invalFunction) (SharedInvalidationMessage *msg),
 							 void (*resetFunction) (void))
 {
-#define MAXINVALMSGS 32
+	/*
+	 * The larger this buffer, the fewer SIGetDataEntries calls (and hence
+	 * SInvalReadLock acquisitions) are needed to catch up after a burst of
+	 * DDL, at the cost of a bit of static memory per backend.
+	 */
+#define MAXINVALMSGS 128
 	static SharedInvalidationMessage messages[MAXINVALMSGS];
 
 	/*
@@ -112,12 +117,31 @@ ReceiveSharedInvalidMessages(void (*invalFunction) (SharedInvalidationMessage *m
 		nextmsg = 0;
 		nummsgs = getResult;
 
-		while (nextmsg < nummsgs)
 		{
-			SharedInvalidationMessage msg = messages[nextmsg++];
-
-			SharedInvalidMessageCounter++;
-			invalFunction(&msg);
+			SharedInvalidationMessage lastmsg;
+			bool		havelast = false;
+
+			while (nextmsg < nummsgs)
+			{
+				SharedInvalidationMessage msg = messages[nextmsg++];
+
+				SharedInvalidMessageCounter++;
+
+				/*
+				 * DDL bursts commonly queue runs of identical messages (the
+				 * same catcache entry or relation invalidated by successive
+				 * subcommands).  Applying an invalidation is idempotent, so
+				 * consecutive duplicates can simply be skipped.  Comparing
+				 * the raw bytes can only miss duplicates (e.g. if padding
+				 * differs), never skip a message that matters.
+				 */
+				if (havelast && memcmp(&msg, &lastmsg, sizeof(msg)) == 0)
+					continue;
+				lastmsg = msg;
+				havelast = true;
+
+				invalFunction(&msg);
+			}
 		}
 
 		/*
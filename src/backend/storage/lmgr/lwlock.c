@@ -524,6 +524,8 @@ RegisterLWLockTranches(void)
 	LWLockRegisterTranche(LWTRANCHE_SXACT, "serializable_xact");
 	LWLockRegisterTranche(LWTRANCHE_UNDOLOG, "undo_log");
 	LWLockRegisterTranche(LWTRANCHE_UNDOFILE, "undo_file");
+	LWLockRegisterTranche(LWTRANCHE_UNDO_REQUEST, "undo_request");
+	LWLockRegisterTranche(LWTRANCHE_UNDO_FREELIST, "undo_freelist");
 
 	/* Register named tranches. */
 	for (i = 0; i < NamedLWLockTrancheRequests; i++)
@@ -801,6 +803,69 @@ LWLockAttemptLock(LWLock *lock, LWLockMode mode)
 	pg_unreachable();
 }
 
+/*
+ * Maximum number of spin-delay iterations to perform on a contended lock
+ * before joining the wait queue.  The value matches DEFAULT_SPINS_PER_DELAY,
+ * the point at which the spinlock code considers a lock no longer
+ * short-held.
+ */
+#define LW_MAX_SPINS_BEFORE_QUEUE	100
+
+/*
+ * Spin briefly on a contended lock before taking the slow path.
+ *
+ * Most LWLocks are held only long enough to examine or update a few words of
+ * shared memory, so under contention the lock is frequently released again
+ * within tens of nanoseconds, while the semaphore sleep/wakeup round trip
+ * costs several microseconds and two context switches.  Re-check the lock's
+ * state a bounded number of times, with exponentially growing pauses, before
+ * queueing.  The small fixed bound keeps the worst case (the holder is
+ * descheduled, or sleeps while holding the lock) cheap, which is also why no
+ * per-tranche tuning of the bound is needed.
+ *
+ * Returns true if the lock isn't free and the caller needs to queue.
+ */
+static bool
+LWLockSpinBeforeQueue(LWLock *lock, LWLockMode mode)
+{
+	int			delay = 1;
+	int			spins = 0;
+
+	while (spins < LW_MAX_SPINS_BEFORE_QUEUE)
+	{
+		uint32		old_state;
+		int			i;
+
+		for (i = 0; i < delay; i++)
+			SPIN_DELAY();
+		spins += delay;
+		if (delay < 32)
+			delay *= 2;
+
+		/*
+		 * Only attempt the compare-and-exchange once the lock appears free
+		 * for our mode; hammering a held lock's cache line with failed
+		 * updates would slow down the holder (and other spinners).
+		 */
+		old_state = pg_atomic_read_u32(&lock->state);
+		if (mode == LW_EXCLUSIVE)
+		{
+			if ((old_state & LW_LOCK_MASK) != 0)
+				continue;
+		}
+		else
+		{
+			if ((old_state & LW_VAL_EXCLUSIVE) != 0)
+				continue;
+		}
+
+		if (!LWLockAttemptLock(lock, mode))
+			return false;
+	}
+
+	return true;
+}
+
 /*
  * Lock the LWLock's wait list against concurrent activity.
  *
@@ -1125,6 +1190,7 @@ LWLockAcquire(LWLock *lock, LWLockMode mode)
 {
 	PGPROC	   *proc = MyProc;
 	bool		result = true;
+	bool		spun = false;
 	int			extraWaits = 0;
 #ifdef LWLOCK_STATS
 	lwlock_stats *lwstats;
@@ -1194,6 +1260,24 @@ LWLockAcquire(LWLock *lock, LWLockMode mode)
 			break;				/* got the lock */
 		}
 
+		/*
+		 * Spin a little before queueing, in the hope that the lock is
+		 * released quickly.  But do so only the first time through this
+		 * loop: if we have already slept on the lock, it is evidently not
+		 * short-held at the moment, and spinning again would just burn CPU
+		 * that the lock holder may need.
+		 */
+		if (!spun)
+		{
+			spun = true;
+			mustwait = LWLockSpinBeforeQueue(lock, mode);
+			if (!mustwait)
+			{
+				LOG_LWDEBUG("LWLockAcquire", lock, "acquired while spinning");
+				break;			/* got the lock */
+			}
+		}
+
 		/*
 		 * Ok, at this point we couldn't grab the lock on the first try. We
 		 * cannot simply queue ourselves to the end of the list and wait to be
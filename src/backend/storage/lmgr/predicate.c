@@ -134,6 +134,16 @@
  *	SerializableXactHashLock
  *		- Protects both PredXact and SerializableXidHash.
  *
+ * XXX SerializableXactHashLock is the remaining scalability limit for
+ * SERIALIZABLE on high core counts: it is taken (often exclusively) on
+ * every conflict check in/out, at snapshot acquisition, and at commit.
+ * Splitting it would require either partitioning SerializableXidHash and
+ * the PredXact active list (conflict checks would then need a consistent
+ * view across partitions), or making the read paths lock-free with
+ * carefully ordered flag updates on SERIALIZABLEXACT.  Neither is a local
+ * change, because the conflict flags and the rw-conflict lists are mutated
+ * from both sides of a conflict under this one lock.
+ *
  *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -103,6 +103,7 @@ Size
 ProcGlobalShmemSize(void)
 {
 	Size		size = 0;
+	Size		TotalProcs;
 
 	/* ProcGlobal */
 	size = add_size(size, sizeof(PROC_HDR));
@@ -119,6 +120,23 @@ ProcGlobalShmemSize(void)
 	size = add_size(size, mul_size(NUM_AUXILIARY_PROCS, sizeof(PGXACT)));
 	size = add_size(size, mul_size(max_prepared_xacts, sizeof(PGXACT)));
 
+	/* Dense mirrors of PGXACT fields for procarray members, see proc.h */
+	TotalProcs = add_size(MaxBackends,
+						  add_size(NUM_AUXILIARY_PROCS, max_prepared_xacts));
+	size = add_size(size, mul_size(TotalProcs, sizeof(TransactionId)));
+	size = add_size(size, mul_size(TotalProcs, sizeof(XidCacheStatus)));
+	size = add_size(size, mul_size(TotalProcs, sizeof(uint8)));
+
+	/* Fast-path lock arrays, one of each per PGPROC */
+	size = add_size(size,
+					mul_size(TotalProcs,
+							 MAXALIGN(FastPathLockGroupsPerBackend *
+									  sizeof(uint64))));
+	size = add_size(size,
+					mul_size(TotalProcs,
+							 MAXALIGN(FP_LOCK_SLOTS_PER_BACKEND *
+									  sizeof(Oid))));
+
 	return size;
 }
 
@@ -170,6 +188,11 @@ InitProcGlobal(void)
 	bool		found;
 	uint32		TotalProcs = MaxBackends + NUM_AUXILIARY_PROCS + max_prepared_xacts;
 
+	/* Used for setup of per-backend fast-path slots. */
+	char	   *fpPtr;
+	Size		fpLockBitsSize,
+				fpRelIdSize;
+
 	/* Create the ProcGlobal shared structure */
 	ProcGlobal = (PROC_HDR *)
 		ShmemInitStruct("Proc Header", sizeof(PROC_HDR), &found);
@@ -217,6 +240,33 @@ InitProcGlobal(void)
 	MemSet(pgxacts, 0, TotalProcs * sizeof(PGXACT));
 	ProcGlobal->allPgXact = pgxacts;
 
+	/*
+	 * Allocate arrays mirroring PGXACT fields in a dense manner.  See the
+	 * PROC_HDR definition for how these are maintained and who may read and
+	 * write them.
+	 */
+	ProcGlobal->xids =
+		(TransactionId *) ShmemAlloc(TotalProcs * sizeof(*ProcGlobal->xids));
+	MemSet(ProcGlobal->xids, 0, TotalProcs * sizeof(*ProcGlobal->xids));
+	ProcGlobal->subxidStates =
+		(XidCacheStatus *) ShmemAlloc(TotalProcs * sizeof(*ProcGlobal->subxidStates));
+	MemSet(ProcGlobal->subxidStates, 0, TotalProcs * sizeof(*ProcGlobal->subxidStates));
+	ProcGlobal->vacuumFlags =
+		(uint8 *) ShmemAlloc(TotalProcs * sizeof(*ProcGlobal->vacuumFlags));
+	MemSet(ProcGlobal->vacuumFlags, 0, TotalProcs * sizeof(*ProcGlobal->vacuumFlags));
+
+	/*
+	 * Allocate arrays for fast-path locks.  Those are variable-length, so
+	 * they cannot be included in the PGPROC structure directly.  We allocate
+	 * a separate chunk for each backend, with the bitmap and the relid array
+	 * MAXALIGNed so the accesses are aligned nicely.
+	 */
+	fpLockBitsSize = MAXALIGN(FastPathLockGroupsPerBackend * sizeof(uint64));
+	fpRelIdSize = MAXALIGN(FP_LOCK_SLOTS_PER_BACKEND * sizeof(Oid));
+
+	fpPtr = ShmemAlloc(TotalProcs * (fpLockBitsSize + fpRelIdSize));
+	MemSet(fpPtr, 0, TotalProcs * (fpLockBitsSize + fpRelIdSize));
+
 	for (i = 0; i < TotalProcs; i++)
 	{
 		/* Common initialization for all PGPROCs, regardless of type. */
@@ -234,6 +284,13 @@ InitProcGlobal(void)
 		}
 		procs[i].pgprocno = i;
 
+		/* Assign the next chunk of fast-path lock arrays to this PGPROC. */
+		procs[i].fpLockBits = (uint64 *) fpPtr;
+		fpPtr += fpLockBitsSize;
+
+		procs[i].fpRelId = (Oid *) fpPtr;
+		fpPtr += fpRelIdSize;
+
 		/*
 		 * Newly created PGPROCs for normal backends, autovacuum and bgworkers
 		 * must be queued up on the appropriate free list.  Because there can
@@ -284,6 +341,7 @@ InitProcGlobal(void)
 		 */
 		pg_atomic_init_u32(&(procs[i].procArrayGroupNext), INVALID_PGPROCNO);
 		pg_atomic_init_u32(&(procs[i].clogGroupNext), INVALID_PGPROCNO);
+		pg_atomic_init_u32(&(procs[i].walReserveNext), INVALID_PGPROCNO);
 	}
 
 	/*
@@ -442,6 +500,11 @@ InitProcess(void)
 	MyProc->clogGroupMemberLsn = InvalidXLogRecPtr;
 	Assert(pg_atomic_read_u32(&MyProc->clogGroupNext) == INVALID_PGPROCNO);
 
+	/* Initialize fields for group WAL space reservation. */
+	MyProc->walReserveMember = false;
+	MyProc->walReserveSize = 0;
+	Assert(pg_atomic_read_u32(&MyProc->walReserveNext) == INVALID_PGPROCNO);
+
 	/*
 	 * Acquire ownership of the PGPROC's latch, so that we can use WaitLatch
 	 * on it.  That allows us to repoint the process latch, which so far
@@ -1691,6 +1754,20 @@ CheckDeadLock(void)
 {
 	int			i;
 
+	/*
+	 * Before seizing the (expensive) partition locks, take a cheap unlocked
+	 * peek at our wait status.  If the lock has been granted in the interim,
+	 * there's no point in running the deadlock check at all.  This matters
+	 * when many backends hit deadlock_timeout at about the same time, e.g.
+	 * while queueing for the same hot page: the first few checks wake most
+	 * of the herd, and this test keeps the remainder from serializing on an
+	 * exclusive sweep of all the lock partition locks.  A stale read here is
+	 * harmless -- if we see STATUS_WAITING when we've in fact been granted
+	 * the lock, we just fall through to the properly locked check below.
+	 */
+	if (*((volatile int *) &MyProc->waitStatus) != STATUS_WAITING)
+		return;
+
 	/*
 	 * Acquire exclusive lock on the entire shared lock data structures. Must
 	 * grab LWLocks in partition-number order to avoid LWLock deadlock.
@@ -0,0 +1,303 @@
+/*-------------------------------------------------------------------------
+ *
+ * iostats.c
+ *	  Shared-memory I/O statistics with latency histograms.
+ *
+ * We keep a small fixed-size array of counters in shared memory, indexed
+ * by process type, object class (relation fork or undo), and operation
+ * (read, write, extend).  The md.c and undofile.c I/O routines bump the
+ * counters directly with atomic adds; there are no locks on the update
+ * path, so this is cheap enough to leave enabled in production.  Latency
+ * is recorded, in a histogram of log2(microseconds) buckets, only when
+ * track_io_timing is on, since reading the clock is the expensive part.
+ *
+ * The counters accumulate from postmaster start and are exposed through
+ * the pg_stat_io view.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * IDENTIFICATION
+ *	  src/backend/storage/smgr/iostats.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "catalog/pg_type.h"
+#include "funcapi.h"
+#include "miscadmin.h"
+#include "port/atomics.h"
+#include "port/pg_bitutils.h"
+#include "postmaster/autovacuum.h"
+#include "storage/bufmgr.h"
+#include "storage/iostats.h"
+#include "storage/shmem.h"
+#include "utils/array.h"
+#include "utils/builtins.h"
+#include "utils/tuplestore.h"
+
+/*
+ * Process classification.  This predates any common backend-type
+ * machinery, so we keep our own list; it must stay in sync with
+ * iostat_backend_type_names below.
+ */
+#define IOSTAT_BACKEND_CLIENT		0
+#define IOSTAT_BACKEND_AUTOVACUUM	1
+#define IOSTAT_BACKEND_BGWORKER		2
+#define IOSTAT_BACKEND_STARTUP		3
+#define IOSTAT_BACKEND_BGWRITER		4
+#define IOSTAT_BACKEND_CHECKPOINTER 5
+#define IOSTAT_BACKEND_WALRECEIVER	6
+#define IOSTAT_BACKEND_OTHER		7
+#define IOSTAT_NUM_BACKEND_TYPES	8
+
+static const char *const iostat_backend_type_names[IOSTAT_NUM_BACKEND_TYPES] = {
+	"client backend",
+	"autovacuum",
+	"background worker",
+	"startup",
+	"background writer",
+	"checkpointer",
+	"walreceiver",
+	"other"
+};
+
+static const char *const iostat_op_names[IOSTAT_NUM_OPS] = {
+	"read",
+	"write",
+	"extend"
+};
+
+/* One counter cell; all updates use unlocked atomic adds. */
+typedef struct IOStatCell
+{
+	pg_atomic_uint64 count;		/* number of operations */
+	pg_atomic_uint64 time_us;	/* total elapsed microseconds */
+	pg_atomic_uint64 hist[IOSTAT_NUM_BUCKETS];	/* log2(us) buckets */
+} IOStatCell;
+
+typedef struct IOStatsShmemStruct
+{
+	IOStatCell	cells[IOSTAT_NUM_BACKEND_TYPES][IOSTAT_NUM_OBJECTS][IOSTAT_NUM_OPS];
+} IOStatsShmemStruct;
+
+static IOStatsShmemStruct *IOStats = NULL;
+
+/* cached classification of this process, computed on first use */
+static int	iostat_my_backend_type = -1;
+
+/*
+ * Report space needed for our shared memory area.
+ */
+Size
+IOStatsShmemSize(void)
+{
+	return sizeof(IOStatsShmemStruct);
+}
+
+/*
+ * Allocate and initialize our shared memory area.
+ */
+void
+IOStatsShmemInit(void)
+{
+	bool		found;
+
+	IOStats = (IOStatsShmemStruct *)
+		ShmemInitStruct("I/O Statistics", IOStatsShmemSize(), &found);
+
+	if (!found)
+	{
+		int			btype,
+					object,
+					op,
+					i;
+
+		for (btype = 0; btype < IOSTAT_NUM_BACKEND_TYPES; btype++)
+			for (object = 0; object < IOSTAT_NUM_OBJECTS; object++)
+				for (op = 0; op < IOSTAT_NUM_OPS; op++)
+				{
+					IOStatCell *cell = &IOStats->cells[btype][object][op];
+
+					pg_atomic_init_u64(&cell->count, 0);
+					pg_atomic_init_u64(&cell->time_us, 0);
+					for (i = 0; i < IOSTAT_NUM_BUCKETS; i++)
+						pg_atomic_init_u64(&cell->hist[i], 0);
+				}
+	}
+}
+
+/*
+ * Classify the current process for statistics purposes.
+ */
+static int
+iostat_classify_backend(void)
+{
+	switch (MyAuxProcType)
+	{
+		case StartupProcess:
+			return IOSTAT_BACKEND_STARTUP;
+		case BgWriterProcess:
+			return IOSTAT_BACKEND_BGWRITER;
+		case CheckpointerProcess:
+			return IOSTAT_BACKEND_CHECKPOINTER;
+		case WalReceiverProcess:
+			return IOSTAT_BACKEND_WALRECEIVER;
+		default:
+			break;
+	}
+
+	if (IsAutoVacuumWorkerProcess() || IsAutoVacuumLauncherProcess())
+		return IOSTAT_BACKEND_AUTOVACUUM;
+	if (IsBackgroundWorker)
+		return IOSTAT_BACKEND_BGWORKER;
+	if (MyAuxProcType == NotAnAuxProcess)
+		return IOSTAT_BACKEND_CLIENT;
+
+	return IOSTAT_BACKEND_OTHER;
+}
+
+/*
+ * Note the start of an I/O operation.  We only read the clock when
+ * track_io_timing is on; otherwise the zero start time tells
+ * iostat_io_end to skip the latency accounting.
+ */
+void
+iostat_io_begin(instr_time *start)
+{
+	if (track_io_timing)
+		INSTR_TIME_SET_CURRENT(*start);
+	else
+		INSTR_TIME_SET_ZERO(*start);
+}
+
+/*
+ * Count a completed I/O operation, and its latency if we have it.
+ */
+void
+iostat_io_end(int object, int op, instr_time start)
+{
+	IOStatCell *cell;
+
+	if (IOStats == NULL)
+		return;					/* shared memory not set up yet */
+
+	if (iostat_my_backend_type < 0)
+		iostat_my_backend_type = iostat_classify_backend();
+
+	Assert(object >= 0 && object < IOSTAT_NUM_OBJECTS);
+	Assert(op >= 0 && op < IOSTAT_NUM_OPS);
+
+	cell = &IOStats->cells[iostat_my_backend_type][object][op];
+	pg_atomic_fetch_add_u64(&cell->count, 1);
+
+	if (!INSTR_TIME_IS_ZERO(start))
+	{
+		instr_time	elapsed;
+		uint64		us;
+		int			bucket;
+
+		INSTR_TIME_SET_CURRENT(elapsed);
+		INSTR_TIME_SUBTRACT(elapsed, start);
+		us = (uint64) INSTR_TIME_GET_MICROSEC(elapsed);
+
+		pg_atomic_fetch_add_u64(&cell->time_us, us);
+
+		/* bucket i covers latencies in [2^i, 2^(i+1)) microseconds */
+		bucket = pg_leftmost_one_pos64(us | 1);
+		if (bucket >= IOSTAT_NUM_BUCKETS)
+			bucket = IOSTAT_NUM_BUCKETS - 1;
+		pg_atomic_fetch_add_u64(&cell->hist[bucket], 1);
+	}
+}
+
+/*
+ * Returns accumulated I/O statistics, one row per (backend type, object,
+ * operation) combination that has seen any I/O.
+ */
+Datum
+pg_stat_get_io(PG_FUNCTION_ARGS)
+{
+#define PG_STAT_GET_IO_COLS 6
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	int			btype,
+				object,
+				op;
+
+	/* check to see if caller supports us returning a tuplestore */
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not " \
+						"allowed in this context")));
+
+	/* Build a tuple descriptor for our result type */
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+	MemoryContextSwitchTo(oldcontext);
+
+	if (IOStats == NULL)
+		return (Datum) 0;
+
+	for (btype = 0; btype < IOSTAT_NUM_BACKEND_TYPES; btype++)
+	{
+		for (object = 0; object < IOSTAT_NUM_OBJECTS; object++)
+		{
+			for (op = 0; op < IOSTAT_NUM_OPS; op++)
+			{
+				IOStatCell *cell = &IOStats->cells[btype][object][op];
+				uint64		count = pg_atomic_read_u64(&cell->count);
+				Datum		values[PG_STAT_GET_IO_COLS];
+				bool		nulls[PG_STAT_GET_IO_COLS];
+				Datum		histdatums[IOSTAT_NUM_BUCKETS];
+				ArrayType  *hist;
+				int			i;
+
+				/* Skip combinations that have seen no I/O at all */
+				if (count == 0)
+					continue;
+
+				MemSet(nulls, 0, sizeof(nulls));
+
+				values[0] = CStringGetTextDatum(iostat_backend_type_names[btype]);
+				values[1] = CStringGetTextDatum(object == IOSTAT_OBJ_UNDO ?
+												"undo" : forkNames[object]);
+				values[2] = CStringGetTextDatum(iostat_op_names[op]);
+				values[3] = Int64GetDatum((int64) count);
+				values[4] = Float8GetDatum(pg_atomic_read_u64(&cell->time_us) / 1000.0);
+
+				for (i = 0; i < IOSTAT_NUM_BUCKETS; i++)
+					histdatums[i] =
+						Int64GetDatum((int64) pg_atomic_read_u64(&cell->hist[i]));
+				hist = construct_array(histdatums, IOSTAT_NUM_BUCKETS,
+									   INT8OID, sizeof(int64),
+									   FLOAT8PASSBYVAL, 'd');
+				values[5] = PointerGetDatum(hist);
+
+				tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+			}
+		}
+	}
+
+	/* clean up and return the tuplestore */
+	tuplestore_donestoring(tupstore);
+
+	return (Datum) 0;
+}
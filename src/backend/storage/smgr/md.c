@@ -33,6 +33,7 @@
 #include "postmaster/bgwriter.h"
 #include "storage/fd.h"
 #include "storage/bufmgr.h"
+#include "storage/iostats.h"
 #include "storage/md.h"
 #include "storage/relfilenode.h"
 #include "storage/smgr.h"
@@ -47,13 +48,14 @@
  *	easier to support relations that are larger than the operating
  *	system's file size limit (often 2GBytes).  In order to do that,
  *	we break relations up into "segment" files that are each shorter than
- *	the OS file size limit.  The segment size is set by the RELSEG_SIZE
- *	configuration constant in pg_config.h.
+ *	the OS file size limit.  The segment size is chosen at initdb time and
+ *	thereafter read from the control file at startup; RELSEG_SIZE from
+ *	pg_config.h merely supplies the default.
  *
  *	On disk, a relation must consist of consecutively numbered segment
  *	files in the pattern
- *		-- Zero or more full segments of exactly RELSEG_SIZE blocks each
- *		-- Exactly one partial segment of size 0 <= size < RELSEG_SIZE blocks
+ *		-- Zero or more full segments of exactly rel_segment_size blocks each
+ *		-- Exactly one partial segment of size 0 <= size < rel_segment_size blocks
  *		-- Optionally, any number of inactive segments of size 0 blocks.
  *	The full and partial segments are collectively the "active" segments.
  *	Inactive segments are those that once contained data but are currently
@@ -85,6 +87,13 @@ typedef struct _MdfdVec
 	BlockNumber mdfd_segno;		/* segment number, from 0 */
 } MdfdVec;
 
+/*
+ * Relation segment size in blocks.  This is an initdb-time choice recorded
+ * in the control file; ReadControlFile() overwrites the default before any
+ * relation file is accessed.
+ */
+int			rel_segment_size = RELSEG_SIZE;
+
 static MemoryContext MdCxt;		/* context for all MdfdVec objects */
 
 
@@ -110,7 +119,7 @@ static MemoryContext MdCxt;		/* context for all MdfdVec objects */
 #define EXTENSION_CREATE_RECOVERY	(1 << 3)
 /*
  * Allow opening segments which are preceded by segments smaller than
- * RELSEG_SIZE, e.g. inactive segments (see above). Note that this breaks
+ * rel_segment_size, e.g. inactive segments (see above). Note that this breaks
  * mdnblocks() and related functionality henceforth - which currently is ok,
  * because this is only required in the checkpointer which never uses
  * mdnblocks().
@@ -391,6 +400,7 @@ mdextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	off_t		seekpos;
 	int			nbytes;
 	MdfdVec    *v;
+	instr_time	io_start;
 
 	/* This assert is too expensive to have on normally ... */
 #ifdef CHECK_WRITE_VS_EXTEND
@@ -411,11 +421,14 @@ mdextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 
 	v = _mdfd_getseg(reln, forknum, blocknum, skipFsync, EXTENSION_CREATE);
 
-	seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) RELSEG_SIZE));
+	seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) rel_segment_size));
 
-	Assert(seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
+	Assert(seekpos < (off_t) BLCKSZ * rel_segment_size);
 
-	if ((nbytes = FileWrite(v->mdfd_vfd, buffer, BLCKSZ, seekpos, WAIT_EVENT_DATA_FILE_EXTEND)) != BLCKSZ)
+	iostat_io_begin(&io_start);
+	nbytes = FileWrite(v->mdfd_vfd, buffer, BLCKSZ, seekpos, WAIT_EVENT_DATA_FILE_EXTEND);
+	iostat_io_end(forknum, IOSTAT_OP_EXTEND, io_start);
+	if (nbytes != BLCKSZ)
 	{
 		if (nbytes < 0)
 			ereport(ERROR,
@@ -435,7 +448,131 @@ mdextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	if (!skipFsync && !SmgrIsTemp(reln))
 		register_dirty_segment(reln, forknum, v);
 
-	Assert(_mdnblocks(reln, forknum, v) <= ((BlockNumber) RELSEG_SIZE));
+	Assert(_mdnblocks(reln, forknum, v) <= ((BlockNumber) rel_segment_size));
+}
+
+/*
+ *	mdzeroextend() -- Add new zeroed out blocks to the specified relation.
+ *
+ *		Similar to mdextend(), except the relation can be extended by
+ *		multiple blocks at once and the added blocks will be filled with
+ *		zeroes.
+ */
+void
+mdzeroextend(SMgrRelation reln, ForkNumber forknum,
+			 BlockNumber blocknum, int nblocks, bool skipFsync)
+{
+	MdfdVec    *v;
+	BlockNumber curblocknum = blocknum;
+	int			remblocks = nblocks;
+
+	Assert(nblocks > 0);
+
+	/* This assert is too expensive to have on normally ... */
+#ifdef CHECK_WRITE_VS_EXTEND
+	Assert(blocknum >= mdnblocks(reln, forknum));
+#endif
+
+	/*
+	 * If a relation manages to grow to 2^32-1 blocks, refuse to extend it any
+	 * more --- we mustn't create a block whose number actually is
+	 * InvalidBlockNumber or larger.
+	 */
+	if ((uint64) blocknum + nblocks >= (uint64) InvalidBlockNumber)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROGRAM_LIMIT_EXCEEDED),
+				 errmsg("cannot extend file \"%s\" beyond %u blocks",
+						relpath(reln->smgr_rnode, forknum),
+						InvalidBlockNumber)));
+
+	while (remblocks > 0)
+	{
+		BlockNumber segstartblock = curblocknum % ((BlockNumber) rel_segment_size);
+		off_t		seekpos = (off_t) BLCKSZ * segstartblock;
+		int			numblocks;
+		bool		extended = false;
+		instr_time	io_start;
+
+		if (segstartblock + remblocks > rel_segment_size)
+			numblocks = rel_segment_size - segstartblock;
+		else
+			numblocks = remblocks;
+
+		v = _mdfd_getseg(reln, forknum, curblocknum, skipFsync,
+						 EXTENSION_CREATE);
+
+		Assert(segstartblock < rel_segment_size);
+		Assert(segstartblock + numblocks <= rel_segment_size);
+
+		/*
+		 * For larger extensions, reserve the space with one fallocate call
+		 * rather than writing each block: that commonly avoids dirtying
+		 * kernel page cache for pages that will be written through shared
+		 * buffers later anyway.  Small extensions keep using writes, which
+		 * interact better with filesystems' delayed allocation.  If the
+		 * filesystem doesn't support fallocate, fall through to writing
+		 * zeroes.
+		 */
+		if (numblocks > 8)
+		{
+			iostat_io_begin(&io_start);
+			if (FileFallocate(v->mdfd_vfd, seekpos,
+							  (off_t) BLCKSZ * numblocks,
+							  WAIT_EVENT_DATA_FILE_EXTEND) == 0)
+			{
+				iostat_io_end(forknum, IOSTAT_OP_EXTEND, io_start);
+				extended = true;
+			}
+			else if (errno != EINVAL && errno != EOPNOTSUPP)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not extend file \"%s\": %m",
+								FilePathName(v->mdfd_vfd)),
+						 errhint("Check free disk space.")));
+		}
+
+		if (!extended)
+		{
+			static const PGAlignedBlock zerobuf;	/* zero-initialized */
+			int			i;
+
+			for (i = 0; i < numblocks; i++)
+			{
+				int			nbytes;
+
+				iostat_io_begin(&io_start);
+				nbytes = FileWrite(v->mdfd_vfd,
+								   unconstify(char *, &zerobuf.data[0]), BLCKSZ,
+								   seekpos + (off_t) BLCKSZ * i,
+								   WAIT_EVENT_DATA_FILE_EXTEND);
+				iostat_io_end(forknum, IOSTAT_OP_EXTEND, io_start);
+				if (nbytes != BLCKSZ)
+				{
+					if (nbytes < 0)
+						ereport(ERROR,
+								(errcode_for_file_access(),
+								 errmsg("could not extend file \"%s\": %m",
+										FilePathName(v->mdfd_vfd)),
+								 errhint("Check free disk space.")));
+					/* short write: complain appropriately */
+					ereport(ERROR,
+							(errcode(ERRCODE_DISK_FULL),
+							 errmsg("could not extend file \"%s\": wrote only %d of %d bytes at block %u",
+									FilePathName(v->mdfd_vfd),
+									nbytes, BLCKSZ, curblocknum + i),
+							 errhint("Check free disk space.")));
+				}
+			}
+		}
+
+		if (!skipFsync && !SmgrIsTemp(reln))
+			register_dirty_segment(reln, forknum, v);
+
+		Assert(_mdnblocks(reln, forknum, v) <= ((BlockNumber) rel_segment_size));
+
+		remblocks -= numblocks;
+		curblocknum += numblocks;
+	}
 }
 
 /*
@@ -483,7 +620,7 @@ mdopenfork(SMgrRelation reln, ForkNumber forknum, int behavior)
 	mdfd->mdfd_vfd = fd;
 	mdfd->mdfd_segno = 0;
 
-	Assert(_mdnblocks(reln, forknum, mdfd) <= ((BlockNumber) RELSEG_SIZE));
+	Assert(_mdnblocks(reln, forknum, mdfd) <= ((BlockNumber) rel_segment_size));
 
 	return mdfd;
 }
@@ -542,9 +679,9 @@ mdprefetch(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum)
 
 	v = _mdfd_getseg(reln, forknum, blocknum, false, EXTENSION_FAIL);
 
-	seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) RELSEG_SIZE));
+	seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) rel_segment_size));
 
-	Assert(seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
+	Assert(seekpos < (off_t) BLCKSZ * rel_segment_size);
 
 	(void) FilePrefetch(v->mdfd_vfd, seekpos, BLCKSZ, WAIT_EVENT_DATA_FILE_PREFETCH);
 #endif							/* USE_PREFETCH */
@@ -583,17 +720,17 @@ mdwriteback(SMgrRelation reln, ForkNumber forknum,
 			return;
 
 		/* compute offset inside the current segment */
-		segnum_start = blocknum / RELSEG_SIZE;
+		segnum_start = blocknum / rel_segment_size;
 
 		/* compute number of desired writes within the current segment */
-		segnum_end = (blocknum + nblocks - 1) / RELSEG_SIZE;
+		segnum_end = (blocknum + nblocks - 1) / rel_segment_size;
 		if (segnum_start != segnum_end)
-			nflush = RELSEG_SIZE - (blocknum % ((BlockNumber) RELSEG_SIZE));
+			nflush = rel_segment_size - (blocknum % ((BlockNumber) rel_segment_size));
 
 		Assert(nflush >= 1);
 		Assert(nflush <= nblocks);
 
-		seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) RELSEG_SIZE));
+		seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) rel_segment_size));
 
 		FileWriteback(v->mdfd_vfd, seekpos, (off_t) BLCKSZ * nflush, WAIT_EVENT_DATA_FILE_FLUSH);
 
@@ -612,6 +749,7 @@ mdread(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	off_t		seekpos;
 	int			nbytes;
 	MdfdVec    *v;
+	instr_time	io_start;
 
 	TRACE_POSTGRESQL_SMGR_MD_READ_START(forknum, blocknum,
 										reln->smgr_rnode.node.spcNode,
@@ -622,11 +760,13 @@ mdread(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	v = _mdfd_getseg(reln, forknum, blocknum, false,
 					 EXTENSION_FAIL | EXTENSION_CREATE_RECOVERY);
 
-	seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) RELSEG_SIZE));
+	seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) rel_segment_size));
 
-	Assert(seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
+	Assert(seekpos < (off_t) BLCKSZ * rel_segment_size);
 
+	iostat_io_begin(&io_start);
 	nbytes = FileRead(v->mdfd_vfd, buffer, BLCKSZ, seekpos, WAIT_EVENT_DATA_FILE_READ);
+	iostat_io_end(forknum, IOSTAT_OP_READ, io_start);
 
 	TRACE_POSTGRESQL_SMGR_MD_READ_DONE(forknum, blocknum,
 									   reln->smgr_rnode.node.spcNode,
@@ -665,6 +805,95 @@ mdread(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	return true;
 }
 
+/*
+ *	mdreadmulti() -- Read several consecutive blocks from a relation.
+ *
+ *		The blocks are read with as few kernel calls as possible: one per
+ *		segment file touched by the requested range.  Apart from that this
+ *		behaves exactly like nblocks calls of mdread().
+ */
+bool
+mdreadmulti(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+			int nblocks, char *buffer)
+{
+	while (nblocks > 0)
+	{
+		off_t		seekpos;
+		int			nbytes;
+		int			nthisseg;
+		int			amount;
+		MdfdVec    *v;
+		instr_time	io_start;
+
+		v = _mdfd_getseg(reln, forknum, blocknum, false,
+						 EXTENSION_FAIL | EXTENSION_CREATE_RECOVERY);
+
+		seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) rel_segment_size));
+
+		Assert(seekpos < (off_t) BLCKSZ * rel_segment_size);
+
+		/* The request must not cross a segment boundary in one read. */
+		nthisseg = Min(nblocks,
+					   rel_segment_size - (int) (blocknum % ((BlockNumber) rel_segment_size)));
+		amount = nthisseg * BLCKSZ;
+
+		TRACE_POSTGRESQL_SMGR_MD_READ_START(forknum, blocknum,
+											reln->smgr_rnode.node.spcNode,
+											reln->smgr_rnode.node.dbNode,
+											reln->smgr_rnode.node.relNode,
+											reln->smgr_rnode.backend);
+
+		iostat_io_begin(&io_start);
+		nbytes = FileRead(v->mdfd_vfd, buffer, amount, seekpos,
+						  WAIT_EVENT_DATA_FILE_READ);
+		iostat_io_end(forknum, IOSTAT_OP_READ, io_start);
+
+		TRACE_POSTGRESQL_SMGR_MD_READ_DONE(forknum, blocknum,
+										   reln->smgr_rnode.node.spcNode,
+										   reln->smgr_rnode.node.dbNode,
+										   reln->smgr_rnode.node.relNode,
+										   reln->smgr_rnode.backend,
+										   nbytes,
+										   amount);
+
+		if (nbytes != amount)
+		{
+			if (nbytes < 0)
+				ereport(ERROR,
+						(errcode_for_file_access(),
+						 errmsg("could not read block %u in file \"%s\": %m",
+								blocknum, FilePathName(v->mdfd_vfd))));
+
+			/*
+			 * Short read: as in mdread(), zero the rest if zero_damaged_pages
+			 * is ON or we are InRecovery; everything past the point of the
+			 * short read is at or beyond EOF, so that covers the remaining
+			 * segments too, and we are done.
+			 */
+			if (zero_damaged_pages || InRecovery)
+			{
+				MemSet(buffer + nbytes,
+					   0,
+					   (Size) nblocks * BLCKSZ - nbytes);
+				return true;
+			}
+			else
+				ereport(ERROR,
+						(errcode(ERRCODE_DATA_CORRUPTED),
+						 errmsg("could not read block %u in file \"%s\": read only %d of %d bytes",
+								blocknum + nbytes / BLCKSZ,
+								FilePathName(v->mdfd_vfd),
+								nbytes % BLCKSZ, BLCKSZ)));
+		}
+
+		blocknum += nthisseg;
+		nblocks -= nthisseg;
+		buffer += (Size) amount;
+	}
+
+	return true;
+}
+
 /*
  *	mdwrite() -- Write the supplied block at the appropriate location.
  *
@@ -679,6 +908,7 @@ mdwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	off_t		seekpos;
 	int			nbytes;
 	MdfdVec    *v;
+	instr_time	io_start;
 
 	/* This assert is too expensive to have on normally ... */
 #ifdef CHECK_WRITE_VS_EXTEND
@@ -694,11 +924,13 @@ mdwrite(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	v = _mdfd_getseg(reln, forknum, blocknum, skipFsync,
 					 EXTENSION_FAIL | EXTENSION_CREATE_RECOVERY);
 
-	seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) RELSEG_SIZE));
+	seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) rel_segment_size));
 
-	Assert(seekpos < (off_t) BLCKSZ * RELSEG_SIZE);
+	Assert(seekpos < (off_t) BLCKSZ * rel_segment_size);
 
+	iostat_io_begin(&io_start);
 	nbytes = FileWrite(v->mdfd_vfd, buffer, BLCKSZ, seekpos, WAIT_EVENT_DATA_FILE_WRITE);
+	iostat_io_end(forknum, IOSTAT_OP_WRITE, io_start);
 
 	TRACE_POSTGRESQL_SMGR_MD_WRITE_DONE(forknum, blocknum,
 										reln->smgr_rnode.node.spcNode,
@@ -749,7 +981,7 @@ mdnblocks(SMgrRelation reln, ForkNumber forknum)
 
 	/*
 	 * Start from the last open segments, to avoid redundant seeks.  We have
-	 * previously verified that these segments are exactly RELSEG_SIZE long,
+	 * previously verified that these segments are exactly rel_segment_size long,
 	 * and it's useless to recheck that each time.
 	 *
 	 * NOTE: this assumption could only be wrong if another backend has
@@ -766,13 +998,13 @@ mdnblocks(SMgrRelation reln, ForkNumber forknum)
 	for (;;)
 	{
 		nblocks = _mdnblocks(reln, forknum, v);
-		if (nblocks > ((BlockNumber) RELSEG_SIZE))
+		if (nblocks > ((BlockNumber) rel_segment_size))
 			elog(FATAL, "segment too big");
-		if (nblocks < ((BlockNumber) RELSEG_SIZE))
-			return (segno * ((BlockNumber) RELSEG_SIZE)) + nblocks;
+		if (nblocks < ((BlockNumber) rel_segment_size))
+			return (segno * ((BlockNumber) rel_segment_size)) + nblocks;
 
 		/*
-		 * If segment is exactly RELSEG_SIZE, advance to next one.
+		 * If segment is exactly rel_segment_size, advance to next one.
 		 */
 		segno++;
 
@@ -785,7 +1017,7 @@ mdnblocks(SMgrRelation reln, ForkNumber forknum)
 		 */
 		v = _mdfd_openseg(reln, forknum, segno, 0);
 		if (v == NULL)
-			return segno * ((BlockNumber) RELSEG_SIZE);
+			return segno * ((BlockNumber) rel_segment_size);
 	}
 }
 
@@ -826,7 +1058,7 @@ mdtruncate(SMgrRelation reln, ForkNumber forknum, BlockNumber nblocks)
 	{
 		MdfdVec    *v;
 
-		priorblocks = (curopensegs - 1) * RELSEG_SIZE;
+		priorblocks = (curopensegs - 1) * rel_segment_size;
 
 		v = &reln->md_seg_fds[forknum][curopensegs - 1];
 
@@ -851,12 +1083,12 @@ mdtruncate(SMgrRelation reln, ForkNumber forknum, BlockNumber nblocks)
 			FileClose(v->mdfd_vfd);
 			_fdvec_resize(reln, forknum, curopensegs - 1);
 		}
-		else if (priorblocks + ((BlockNumber) RELSEG_SIZE) > nblocks)
+		else if (priorblocks + ((BlockNumber) rel_segment_size) > nblocks)
 		{
 			/*
 			 * This is the last segment we want to keep. Truncate the file to
 			 * the right length. NOTE: if nblocks is exactly a multiple K of
-			 * RELSEG_SIZE, we will truncate the K+1st segment to 0 length but
+			 * rel_segment_size, we will truncate the K+1st segment to 0 length but
 			 * keep it. This adheres to the invariant given in the header
 			 * comments.
 			 */
@@ -1118,7 +1350,7 @@ _mdfd_openseg(SMgrRelation reln, ForkNumber forknum, BlockNumber segno,
 	v->mdfd_vfd = fd;
 	v->mdfd_segno = segno;
 
-	Assert(_mdnblocks(reln, forknum, v) <= ((BlockNumber) RELSEG_SIZE));
+	Assert(_mdnblocks(reln, forknum, v) <= ((BlockNumber) rel_segment_size));
 
 	/* all done */
 	return v;
@@ -1144,7 +1376,7 @@ _mdfd_getseg(SMgrRelation reln, ForkNumber forknum, BlockNumber blkno,
 	Assert(behavior &
 		   (EXTENSION_FAIL | EXTENSION_CREATE | EXTENSION_RETURN_NULL));
 
-	targetseg = blkno / ((BlockNumber) RELSEG_SIZE);
+	targetseg = blkno / ((BlockNumber) rel_segment_size);
 
 	/* if an existing and opened segment, we're done */
 	if (targetseg < reln->md_num_open_segs[forknum])
@@ -1177,7 +1409,7 @@ _mdfd_getseg(SMgrRelation reln, ForkNumber forknum, BlockNumber blkno,
 
 		Assert(nextsegno == v->mdfd_segno + 1);
 
-		if (nblocks > ((BlockNumber) RELSEG_SIZE))
+		if (nblocks > ((BlockNumber) rel_segment_size))
 			elog(FATAL, "segment too big");
 
 		if ((behavior & EXTENSION_CREATE) ||
@@ -1192,29 +1424,29 @@ _mdfd_getseg(SMgrRelation reln, ForkNumber forknum, BlockNumber blkno,
 			 * ahead and create the segments so we can finish out the replay.
 			 *
 			 * We have to maintain the invariant that segments before the last
-			 * active segment are of size RELSEG_SIZE; therefore, if
+			 * active segment are of size rel_segment_size; therefore, if
 			 * extending, pad them out with zeroes if needed.  (This only
 			 * matters if in recovery, or if the caller is extending the
 			 * relation discontiguously, but that can happen in hash indexes.)
 			 */
-			if (nblocks < ((BlockNumber) RELSEG_SIZE))
+			if (nblocks < ((BlockNumber) rel_segment_size))
 			{
 				char	   *zerobuf = palloc0(BLCKSZ);
 
 				mdextend(reln, forknum,
-						 nextsegno * ((BlockNumber) RELSEG_SIZE) - 1,
+						 nextsegno * ((BlockNumber) rel_segment_size) - 1,
 						 zerobuf, skipFsync);
 				pfree(zerobuf);
 			}
 			flags = O_CREAT;
 		}
 		else if (!(behavior & EXTENSION_DONT_CHECK_SIZE) &&
-				 nblocks < ((BlockNumber) RELSEG_SIZE))
+				 nblocks < ((BlockNumber) rel_segment_size))
 		{
 			/*
 			 * When not extending (or explicitly including truncated
 			 * segments), only open the next segment if the current one is
-			 * exactly RELSEG_SIZE.  If not (this branch), either return NULL
+			 * exactly rel_segment_size.  If not (this branch), either return NULL
 			 * or fail.
 			 */
 			if (behavior & EXTENSION_RETURN_NULL)
@@ -1293,7 +1525,7 @@ mdsyncfiletag(const FileTag *ftag, char *path)
 	/* Try to open the requested segment. */
 	v = _mdfd_getseg(reln,
 					 ftag->forknum,
-					 ftag->segno * (BlockNumber) RELSEG_SIZE,
+					 ftag->segno * (BlockNumber) rel_segment_size,
 					 false,
 					 EXTENSION_RETURN_NULL | EXTENSION_DONT_CHECK_SIZE);
 	if (v == NULL)
@@ -1303,6 +1535,41 @@ mdsyncfiletag(const FileTag *ftag, char *path)
 	return FileSync(v->mdfd_vfd, WAIT_EVENT_DATA_FILE_SYNC);
 }
 
+/*
+ * Initiate writeback of a file, given a file tag.  Write the path into an
+ * output buffer so the caller can use it in error messages.
+ *
+ * This only nudges the kernel into starting the I/O; a later call to
+ * mdsyncfiletag() is still needed to make the data durable.
+ *
+ * Return 0 on success, -1 on failure, with errno set.
+ */
+int
+mdpresyncfiletag(const FileTag *ftag, char *path)
+{
+	SMgrRelation reln = smgropen(ftag->rnode, InvalidBackendId);
+	MdfdVec    *v;
+	char	   *p;
+
+	/* Provide the path for informational messages. */
+	p = _mdfd_segpath(reln, ftag->forknum, ftag->segno);
+	strlcpy(path, p, MAXPGPATH);
+	pfree(p);
+
+	/* Try to open the requested segment. */
+	v = _mdfd_getseg(reln,
+					 ftag->forknum,
+					 ftag->segno * (BlockNumber) rel_segment_size,
+					 false,
+					 EXTENSION_RETURN_NULL | EXTENSION_DONT_CHECK_SIZE);
+	if (v == NULL)
+		return -1;
+
+	/* Ask the kernel to start writing the whole file out. */
+	FileWriteback(v->mdfd_vfd, 0, 0, WAIT_EVENT_DATA_FILE_FLUSH);
+	return 0;
+}
+
 /*
  * Unlink a file, given a file tag.  Write the path into an output
  * buffer so the caller can use it in error messages.
@@ -51,10 +51,16 @@ typedef struct f_smgr
 								bool isRedo);
 	void		(*smgr_extend) (SMgrRelation reln, ForkNumber forknum,
 								BlockNumber blocknum, char *buffer, bool skipFsync);
+	void		(*smgr_zeroextend) (SMgrRelation reln, ForkNumber forknum,
+									BlockNumber blocknum, int nblocks,
+									bool skipFsync);	/* may be NULL */
 	void		(*smgr_prefetch) (SMgrRelation reln, ForkNumber forknum,
 								  BlockNumber blocknum);
 	bool		(*smgr_read) (SMgrRelation reln, ForkNumber forknum,
 							  BlockNumber blocknum, char *buffer);
+	bool		(*smgr_readmulti) (SMgrRelation reln, ForkNumber forknum,
+								   BlockNumber blocknum, int nblocks,
+								   char *buffer);	/* may be NULL */
 	void		(*smgr_write) (SMgrRelation reln, ForkNumber forknum,
 							   BlockNumber blocknum, char *buffer, bool skipFsync);
 	void		(*smgr_writeback) (SMgrRelation reln, ForkNumber forknum,
@@ -76,8 +82,10 @@ static const f_smgr smgrsw[] = {
 		.smgr_exists = mdexists,
 		.smgr_unlink = mdunlink,
 		.smgr_extend = mdextend,
+		.smgr_zeroextend = mdzeroextend,
 		.smgr_prefetch = mdprefetch,
 		.smgr_read = mdread,
+		.smgr_readmulti = mdreadmulti,
 		.smgr_write = mdwrite,
 		.smgr_writeback = mdwriteback,
 		.smgr_nblocks = mdnblocks,
@@ -94,8 +102,10 @@ static const f_smgr smgrsw[] = {
 		.smgr_exists = undofile_exists,
 		.smgr_unlink = undofile_unlink,
 		.smgr_extend = undofile_extend,
+		.smgr_zeroextend = NULL,
 		.smgr_prefetch = undofile_prefetch,
 		.smgr_read = undofile_read,
+		.smgr_readmulti = NULL,
 		.smgr_write = undofile_write,
 		.smgr_writeback = undofile_writeback,
 		.smgr_nblocks = undofile_nblocks,
@@ -522,6 +532,33 @@ smgrextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 										 buffer, skipFsync);
 }
 
+/*
+ *	smgrzeroextend() -- Add new zeroed out blocks to a file.
+ *
+ *		Similar to smgrextend(), except the relation can be extended by
+ *		multiple blocks at once and the added blocks will be filled with
+ *		zeroes.  Storage managers that don't provide a specialized
+ *		implementation get the equivalent via repeated smgrextend() calls.
+ */
+void
+smgrzeroextend(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+			   int nblocks, bool skipFsync)
+{
+	if (smgrsw[reln->smgr_which].smgr_zeroextend)
+		smgrsw[reln->smgr_which].smgr_zeroextend(reln, forknum, blocknum,
+												 nblocks, skipFsync);
+	else
+	{
+		static const PGAlignedBlock zerobuf;	/* zero-initialized */
+		int			i;
+
+		for (i = 0; i < nblocks; i++)
+			smgrsw[reln->smgr_which].smgr_extend(reln, forknum, blocknum + i,
+												 unconstify(char *, &zerobuf.data[0]),
+												 skipFsync);
+	}
+}
+
 /*
  *	smgrprefetch() -- Initiate asynchronous read of the specified block of a relation.
  */
@@ -547,6 +584,38 @@ smgrread(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	return smgrsw[reln->smgr_which].smgr_read(reln, forknum, blocknum, buffer);
 }
 
+/*
+ *	smgrreadmulti() -- read several consecutive blocks from a relation into
+ *					   the supplied buffer.
+ *
+ *		Like smgrread(), but reads nblocks consecutive blocks starting at
+ *		blocknum, letting the storage manager combine them into fewer,
+ *		larger I/O requests where it can.  Returns true on success, and
+ *		false if any of the blocks has been discarded.
+ */
+bool
+smgrreadmulti(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
+			  int nblocks, char *buffer)
+{
+	if (smgrsw[reln->smgr_which].smgr_readmulti)
+		return smgrsw[reln->smgr_which].smgr_readmulti(reln, forknum,
+													   blocknum, nblocks,
+													   buffer);
+	else
+	{
+		int			i;
+
+		for (i = 0; i < nblocks; i++)
+		{
+			if (!smgrsw[reln->smgr_which].smgr_read(reln, forknum,
+													blocknum + i,
+													buffer + (Size) i * BLCKSZ))
+				return false;
+		}
+		return true;
+	}
+}
+
 /*
  *	smgrwrite() -- Write the supplied buffer out.
  *
@@ -22,6 +22,7 @@
 #include "pgstat.h"
 #include "postmaster/bgwriter.h"
 #include "storage/fd.h"
+#include "storage/iostats.h"
 #include "storage/smgr.h"
 #include "storage/undofile.h"
 #include "utils/memutils.h"
@@ -42,14 +43,21 @@
  * segments, undofile.c manages a potentially very large number of smaller
  * segments and has a less random access pattern.  Therefore, instead of
  * keeping a potentially huge array of vfds we'll just keep the most
- * recently accessed N.
- *
- * For now, N == 1, so we just need to hold onto one 'File' handle.
+ * recently accessed N, in most-recently-used order.  Checkpoints in
+ * particular bounce between segments when writing back dirty undo pages,
+ * and would otherwise close and reopen files over and over.
  */
+#define UNDOFILE_NUM_OPEN_SEGMENTS 4
+
+typedef struct UndoFileOpenSegment
+{
+	int		segno;
+	File	file;
+} UndoFileOpenSegment;
+
 typedef struct UndoFileState
 {
-	int		mru_segno;
-	File	mru_file;
+	UndoFileOpenSegment open_segments[UNDOFILE_NUM_OPEN_SEGMENTS];
 } UndoFileState;
 
 static MemoryContext UndoFileCxt;
@@ -119,7 +127,23 @@ undofile_extend(SMgrRelation reln, ForkNumber forknum,
 void
 undofile_prefetch(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum)
 {
-	elog(ERROR, "undofile_prefetch is not supported");
+#ifdef USE_PREFETCH
+	File		file;
+	off_t		seekpos;
+
+	Assert(forknum == MAIN_FORKNUM);
+
+	/* Nothing to do for a block that has already been discarded. */
+	if (UndoRecPtrIsDiscarded(MakeUndoRecPtr(reln->smgr_rnode.node.relNode,
+											 BLCKSZ * (blocknum + 1))))
+		return;
+
+	file = undofile_get_segment_file(reln, blocknum / UNDOSEG_SIZE);
+	seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) UNDOSEG_SIZE));
+	Assert(seekpos < (off_t) BLCKSZ * UNDOSEG_SIZE);
+
+	(void) FilePrefetch(file, seekpos, BLCKSZ, WAIT_EVENT_UNDO_FILE_READ);
+#endif							/* USE_PREFETCH */
 }
 
 bool
@@ -129,6 +153,7 @@ undofile_read(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	File		file;
 	off_t		seekpos;
 	int			nbytes;
+	instr_time	io_start;
 
 	Assert(forknum == MAIN_FORKNUM);
 
@@ -140,7 +165,9 @@ undofile_read(SMgrRelation reln, ForkNumber forknum, BlockNumber blocknum,
 	file = undofile_get_segment_file(reln, blocknum / UNDOSEG_SIZE);
 	seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) UNDOSEG_SIZE));
 	Assert(seekpos < (off_t) BLCKSZ * UNDOSEG_SIZE);
+	iostat_io_begin(&io_start);
 	nbytes = FileRead(file, buffer, BLCKSZ, seekpos, WAIT_EVENT_UNDO_FILE_READ);
+	iostat_io_end(IOSTAT_OBJ_UNDO, IOSTAT_OP_READ, io_start);
 	if (nbytes != BLCKSZ)
 	{
 		if (nbytes < 0)
@@ -166,12 +193,15 @@ undofile_write(SMgrRelation reln, ForkNumber forknum,
 	File		file;
 	off_t		seekpos;
 	int			nbytes;
+	instr_time	io_start;
 
 	Assert(forknum == MAIN_FORKNUM);
 	file = undofile_get_segment_file(reln, blocknum / UNDOSEG_SIZE);
 	seekpos = (off_t) BLCKSZ * (blocknum % ((BlockNumber) UNDOSEG_SIZE));
 	Assert(seekpos < (off_t) BLCKSZ * UNDOSEG_SIZE);
+	iostat_io_begin(&io_start);
 	nbytes = FileWrite(file, buffer, BLCKSZ, seekpos, WAIT_EVENT_UNDO_FILE_WRITE);
+	iostat_io_end(IOSTAT_OBJ_UNDO, IOSTAT_OP_WRITE, io_start);
 	if (nbytes != BLCKSZ)
 	{
 		if (nbytes < 0)
@@ -254,6 +284,14 @@ static File undofile_open_segment_file(Oid relNode, Oid spcNode,
 	UndoLogSegmentPath(relNode, segno, spcNode, path);
 	file = PathNameOpenFile(path, O_RDWR | PG_BINARY);
 
+	/*
+	 * The undo launcher may have replaced the segment with a compressed
+	 * copy; if so, bring the uncompressed file back and try again.
+	 */
+	if (file <= 0 && errno == ENOENT &&
+		UndoLogUncompressSegment(relNode, spcNode, segno))
+		file = PathNameOpenFile(path, O_RDWR | PG_BINARY);
+
 	if (file <= 0 && (!missing_ok || errno != ENOENT))
 		elog(ERROR, "cannot open undo segment file '%s': %m", path);
 
@@ -267,23 +305,32 @@ static File undofile_open_segment_file(Oid relNode, Oid spcNode,
 static File undofile_get_segment_file(SMgrRelation reln, BlockNumber segno)
 {
 	UndoFileState *state = (UndoFileState *) reln->private_data;
+	int			i;
 
-	/* If we have a file open already, check if we need to close it. */
-	if (state->mru_file > 0 && state->mru_segno != segno)
+	/* Do we have this segment open already? */
+	for (i = 0; i < UNDOFILE_NUM_OPEN_SEGMENTS; ++i)
 	{
-		/* These are not the blocks we're looking for. */
-		FileClose(state->mru_file);
-		state->mru_file = 0;
+		if (state->open_segments[i].file > 0 &&
+			state->open_segments[i].segno == segno)
+			break;
 	}
 
-	/* Check if we need to open a new file. */
-	if (state->mru_file <= 0)
+	/* If not, evict the least recently used entry and open it. */
+	if (i == UNDOFILE_NUM_OPEN_SEGMENTS)
 	{
-		state->mru_file =
-			undofile_open_segment_file(reln->smgr_rnode.node.relNode,
-									   reln->smgr_rnode.node.spcNode,
-									   segno, InRecovery);
-		if (InRecovery && state->mru_file <= 0)
+		File		file;
+
+		--i;
+		if (state->open_segments[i].file > 0)
+		{
+			FileClose(state->open_segments[i].file);
+			state->open_segments[i].file = 0;
+		}
+
+		file = undofile_open_segment_file(reln->smgr_rnode.node.relNode,
+										  reln->smgr_rnode.node.spcNode,
+										  segno, InRecovery);
+		if (InRecovery && file <= 0)
 		{
 			/*
 			 * If in recovery, we may be trying to access a file that will
@@ -293,16 +340,26 @@ static File undofile_get_segment_file(SMgrRelation reln, BlockNumber segno)
 			UndoLogNewSegment(reln->smgr_rnode.node.relNode,
 							  reln->smgr_rnode.node.spcNode,
 							  segno);
-			state->mru_file =
-				undofile_open_segment_file(reln->smgr_rnode.node.relNode,
-										   reln->smgr_rnode.node.spcNode,
-										   segno, false);
-			Assert(state->mru_file > 0);
+			file = undofile_open_segment_file(reln->smgr_rnode.node.relNode,
+											  reln->smgr_rnode.node.spcNode,
+											  segno, false);
+			Assert(file > 0);
 		}
-		state->mru_segno = segno;
+		state->open_segments[i].file = file;
+		state->open_segments[i].segno = segno;
 	}
 
-	return state->mru_file;
+	/* Move it to the front, so recently used entries stay open. */
+	if (i > 0)
+	{
+		UndoFileOpenSegment tmp = state->open_segments[i];
+
+		memmove(&state->open_segments[1], &state->open_segments[0],
+				sizeof(UndoFileOpenSegment) * i);
+		state->open_segments[0] = tmp;
+	}
+
+	return state->open_segments[0].file;
 }
 
 /*
@@ -339,6 +396,37 @@ undofile_syncfiletag(const FileTag *tag, char *path)
 	}
 }
 
+/*
+ * Initiate writeback of an undo segment file, as a prelude to a later
+ * undofile_syncfiletag() call.
+ */
+int
+undofile_presyncfiletag(const FileTag *tag, char *path)
+{
+	SMgrRelation reln = smgropen(tag->rnode, InvalidBackendId);
+	File		file;
+
+	if (tag->rnode.relNode == (Oid) InvalidUndoLogNumber)
+	{
+		/* Directory syncs have no useful writeback to start early. */
+		UndoLogDirectory(tag->rnode.spcNode, path);
+		return 0;
+	}
+
+	UndoLogSegmentPath(tag->rnode.relNode, tag->segno, tag->rnode.spcNode,
+					   path);
+
+	file = undofile_get_segment_file(reln, tag->segno);
+	if (file <= 0)
+	{
+		/* errno set by undofile_get_segment_file() */
+		return -1;
+	}
+
+	FileWriteback(file, 0, 0, WAIT_EVENT_UNDO_FILE_FLUSH);
+	return 0;
+}
+
 /*
  * Filtering callback used by SYNC_FILTER_REQUEST to forget some requests.
  */
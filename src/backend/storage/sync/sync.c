@@ -86,6 +86,7 @@ static CycleCtr checkpoint_cycle_ctr = 0;
 typedef struct SyncOps
 {
 	int			(*sync_syncfiletag) (const FileTag *ftag, char *path);
+	int			(*sync_presyncfiletag) (const FileTag *ftag, char *path);
 	int			(*sync_unlinkfiletag) (const FileTag *ftag, char *path);
 	bool		(*sync_filetagmatches) (const FileTag *ftag,
 										const FileTag *candidate);
@@ -95,12 +96,14 @@ static const SyncOps syncsw[] = {
 	/* magnetic disk */
 	{
 		.sync_syncfiletag = mdsyncfiletag,
+		.sync_presyncfiletag = mdpresyncfiletag,
 		.sync_unlinkfiletag = mdunlinkfiletag,
 		.sync_filetagmatches = mdfiletagmatches
 	},
 	/* undo log segment files */
 	{
 		.sync_syncfiletag = undofile_syncfiletag,
+		.sync_presyncfiletag = undofile_presyncfiletag,
 		.sync_filetagmatches = undofile_filetagmatches
 	}
 };
@@ -314,6 +317,29 @@ ProcessSyncRequests(void)
 	/* Set flag to detect failure if we don't reach the end of the loop */
 	sync_in_progress = true;
 
+	/*
+	 * Before fsyncing anything, make a pass over the table asking the kernel
+	 * to initiate writeback of every file we are about to sync.  The fsyncs
+	 * below then mostly wait for I/O that the devices have already accepted,
+	 * and independent devices make progress concurrently instead of being
+	 * driven one serial fsync at a time.  This is purely advisory: failures
+	 * are ignored here, since the fsync loop below will report them, and any
+	 * entry may still be canceled in the meantime.
+	 */
+	if (enableFsync)
+	{
+		hash_seq_init(&hstat, pendingOps);
+		while ((entry = (PendingFsyncEntry *) hash_seq_search(&hstat)) != NULL)
+		{
+			char		path[MAXPGPATH];
+
+			if (entry->cycle_ctr == sync_cycle_ctr || entry->canceled)
+				continue;
+			(void) syncsw[entry->tag.handler].sync_presyncfiletag(&entry->tag,
+																  path);
+		}
+	}
+
 	/* Now scan the hashtable for fsync requests to process */
 	absorb_counter = FSYNCS_PER_ABSORB;
 	hash_seq_init(&hstat, pendingOps);
@@ -55,6 +55,7 @@
 #include "parser/analyze.h"
 #include "parser/parser.h"
 #include "pg_getopt.h"
+#include "portability/instr_time.h"
 #include "postmaster/autovacuum.h"
 #include "postmaster/postmaster.h"
 #include "replication/logicallauncher.h"
@@ -1908,14 +1909,23 @@ exec_bind_message(StringInfo input_message)
 					  cplan->stmt_list,
 					  cplan);
 
-	/* Done with the snapshot used for parameter I/O and parsing/planning */
-	if (snapshot_set)
-		PopActiveSnapshot();
-
 	/*
 	 * And we're ready to start portal execution.
+	 *
+	 * If we pushed a snapshot for parameter I/O and parsing/planning, let
+	 * portal startup reuse it instead of computing another one.  Nothing run
+	 * under that snapshot can have changed what the query should see, and
+	 * snapshot computation is not cheap under concurrency; a pipelined
+	 * stream of small statements would otherwise pay for two snapshots per
+	 * Bind message.
 	 */
-	PortalStart(portal, params, 0, InvalidSnapshot);
+	if (snapshot_set)
+	{
+		PortalStart(portal, params, 0, GetActiveSnapshot());
+		PopActiveSnapshot();
+	}
+	else
+		PortalStart(portal, params, 0, InvalidSnapshot);
 
 	/*
 	 * Apply the result format requests to the portal.
@@ -1978,6 +1988,9 @@ exec_execute_message(const char *portal_name, long max_rows)
 	bool		execute_is_fetch;
 	bool		was_logged = false;
 	char		msec_str[32];
+	bool		report_exec_time;
+	instr_time	exec_start_time;
+	instr_time	exec_end_time;
 
 	/* Adjust destination to tell printtup.c what to do */
 	dest = whereToSendOutput;
@@ -2107,6 +2120,19 @@ exec_execute_message(const char *portal_name, long max_rows)
 	if (max_rows <= 0)
 		max_rows = FETCH_ALL;
 
+	/*
+	 * If this Execute will run a cached plan from the start, time it so we
+	 * can feed the result back to the plan cache's generic-vs-custom
+	 * decision.  Partial executions (row-limited fetches, resumed portals)
+	 * are not timed, since they don't measure the plan's full cost.
+	 */
+	report_exec_time = (portal->cplan != NULL &&
+						!execute_is_fetch &&
+						!is_xact_command &&
+						max_rows == FETCH_ALL);
+	if (report_exec_time)
+		INSTR_TIME_SET_CURRENT(exec_start_time);
+
 	completed = PortalRun(portal,
 						  max_rows,
 						  true, /* always top level */
@@ -2117,6 +2143,30 @@ exec_execute_message(const char *portal_name, long max_rows)
 
 	receiver->rDestroy(receiver);
 
+	/* Report timing feedback to the plan cache, if we collected any */
+	if (report_exec_time && completed)
+	{
+		CachedPlanSource *psrc = NULL;
+
+		INSTR_TIME_SET_CURRENT(exec_end_time);
+		INSTR_TIME_SUBTRACT(exec_end_time, exec_start_time);
+
+		if (portal->prepStmtName)
+		{
+			PreparedStatement *pstmt;
+
+			pstmt = FetchPreparedStatement(portal->prepStmtName, false);
+			if (pstmt)
+				psrc = pstmt->plansource;
+		}
+		else
+			psrc = unnamed_stmt_psrc;
+
+		if (psrc)
+			CachedPlanReportExecTime(psrc, portal->cplan,
+									 INSTR_TIME_GET_MILLISEC(exec_end_time));
+	}
+
 	if (completed)
 	{
 		if (is_xact_command)
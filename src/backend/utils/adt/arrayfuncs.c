@@ -972,6 +972,63 @@ CopyArrayEls(ArrayType *array,
 	if (typbyval)
 		freedata = false;
 
+	/*
+	 * Fast path for pass-by-value elements going into an array with no null
+	 * bitmap: the elements land at a fixed stride, so we can store them with
+	 * a tight per-size loop instead of calling ArrayCastAndSet() for each
+	 * one.  This is worthwhile for bulk operations on large arrays of
+	 * fixed-width types such as float8[].
+	 */
+	if (typbyval && bitmap == NULL &&
+		att_align_nominal(typlen, typalign) == typlen)
+	{
+		switch (typlen)
+		{
+			case 1:
+				for (i = 0; i < nitems; i++)
+				{
+					if (nulls && nulls[i])
+						elog(ERROR, "null array element where not supported");
+					p[i] = DatumGetChar(values[i]);
+				}
+				return;
+			case 2:
+				for (i = 0; i < nitems; i++)
+				{
+					if (nulls && nulls[i])
+						elog(ERROR, "null array element where not supported");
+					((int16 *) p)[i] = DatumGetInt16(values[i]);
+				}
+				return;
+			case 4:
+				for (i = 0; i < nitems; i++)
+				{
+					if (nulls && nulls[i])
+						elog(ERROR, "null array element where not supported");
+					((int32 *) p)[i] = DatumGetInt32(values[i]);
+				}
+				return;
+#if SIZEOF_DATUM == 8
+			case 8:
+				if (nulls == NULL)
+					memcpy(p, values, nitems * sizeof(Datum));
+				else
+				{
+					for (i = 0; i < nitems; i++)
+					{
+						if (nulls[i])
+							elog(ERROR, "null array element where not supported");
+						((Datum *) p)[i] = values[i];
+					}
+				}
+				return;
+#endif
+			default:
+				/* fall through to the generic loop */
+				break;
+		}
+	}
+
 	for (i = 0; i < nitems; i++)
 	{
 		if (nulls && nulls[i])
@@ -3485,6 +3542,41 @@ deconstruct_array(ArrayType *array,
 	bitmap = ARR_NULLBITMAP(array);
 	bitmask = 1;
 
+	/*
+	 * Fast path for pass-by-value elements with no null bitmap: the elements
+	 * lie at a fixed stride in the data area, so we can fetch them with a
+	 * tight per-size loop instead of re-deciding the element size and
+	 * alignment for every element.  This is worthwhile for bulk operations
+	 * on large arrays of fixed-width types such as float8[].
+	 */
+	if (elmbyval && bitmap == NULL &&
+		att_align_nominal(elmlen, elmalign) == elmlen)
+	{
+		switch (elmlen)
+		{
+			case 1:
+				for (i = 0; i < nelems; i++)
+					elems[i] = CharGetDatum(p[i]);
+				return;
+			case 2:
+				for (i = 0; i < nelems; i++)
+					elems[i] = Int16GetDatum(((int16 *) p)[i]);
+				return;
+			case 4:
+				for (i = 0; i < nelems; i++)
+					elems[i] = Int32GetDatum(((int32 *) p)[i]);
+				return;
+#if SIZEOF_DATUM == 8
+			case 8:
+				memcpy(elems, p, nelems * sizeof(Datum));
+				return;
+#endif
+			default:
+				/* fall through to the generic loop */
+				break;
+		}
+	}
+
 	for (i = 0; i < nelems; i++)
 	{
 		/* Get source element, checking for NULL */
@@ -93,6 +93,7 @@
 #include "utils/datetime.h"
 #include "utils/float.h"
 #include "utils/formatting.h"
+#include "utils/hsearch.h"
 #include "utils/int8.h"
 #include "utils/memutils.h"
 #include "utils/numeric.h"
@@ -401,12 +402,16 @@ typedef struct
  * we don't waste too much space by palloc'ing them individually.  Be sure
  * to adjust those macros if you add fields to those structs.
  *
- * The max number of entries in each cache is DCH_CACHE_ENTRIES
- * resp. NUM_CACHE_ENTRIES.
+ * The datetime cache is kept in a dynahash table so that lookups stay cheap
+ * when applications use many distinct format pictures (report generators
+ * routinely do); it holds up to DCH_CACHE_ENTRIES entries, with the oldest
+ * entry dropped when that limit is exceeded.  The number cache sees far
+ * less picture diversity in practice and remains a small linear array of
+ * NUM_CACHE_ENTRIES entries.
  * ----------
  */
 #define DCH_CACHE_OVERHEAD \
-	MAXALIGN(sizeof(bool) + sizeof(int))
+	MAXALIGN(sizeof(bool) + sizeof(bool) + sizeof(int))
 #define NUM_CACHE_OVERHEAD \
 	MAXALIGN(sizeof(bool) + sizeof(int) + sizeof(NUMDesc))
 
@@ -415,14 +420,24 @@ typedef struct
 #define NUM_CACHE_SIZE \
 	((1024 - NUM_CACHE_OVERHEAD) / (sizeof(FormatNode) + sizeof(char)) - 1)
 
-#define DCH_CACHE_ENTRIES	20
+#define DCH_CACHE_ENTRIES	256
 #define NUM_CACHE_ENTRIES	20
 
+/*
+ * Hash key for the datetime cache: the format picture plus the
+ * to_timestamp() "standard mode" flag.  All padding within the key,
+ * including unused bytes of str, must be zeroed for hashing to work.
+ */
 typedef struct
 {
-	FormatNode	format[DCH_CACHE_SIZE + 1];
 	char		str[DCH_CACHE_SIZE + 1];
 	bool		std;
+} DCHCacheKey;
+
+typedef struct
+{
+	DCHCacheKey key;			/* hash key; must be first */
+	FormatNode	format[DCH_CACHE_SIZE + 1];
 	bool		valid;
 	int			age;
 } DCHCacheEntry;
@@ -437,8 +452,7 @@ typedef struct
 } NUMCacheEntry;
 
 /* global cache for date/time format pictures */
-static DCHCacheEntry *DCHCache[DCH_CACHE_ENTRIES];
-static int	n_DCHCache = 0;		/* current number of entries */
+static HTAB *DCHCacheHash = NULL;	/* DCHCacheKey -> DCHCacheEntry */
 static int	DCHCounter = 0;		/* aging-event counter */
 
 /* global cache for number format pictures */
@@ -1088,6 +1102,8 @@ static char *NUM_processor(FormatNode *node, NUMDesc *Num, char *inout,
 static DCHCacheEntry *DCH_cache_getnew(const char *str, bool std);
 static DCHCacheEntry *DCH_cache_search(const char *str, bool std);
 static DCHCacheEntry *DCH_cache_fetch(const char *str, bool std);
+static bool DCH_fast_to_char(const char *fmt_str, TmToChar *tmtc,
+							 bool is_interval, char *result);
 static NUMCacheEntry *NUM_cache_getnew(const char *str);
 static NUMCacheEntry *NUM_cache_search(const char *str);
 static NUMCacheEntry *NUM_cache_fetch(const char *str);
@@ -3647,8 +3663,15 @@ DCH_prevent_counter_overflow(void)
 {
 	if (DCHCounter >= (INT_MAX - 1))
 	{
-		for (int i = 0; i < n_DCHCache; i++)
-			DCHCache[i]->age >>= 1;
+		if (DCHCacheHash != NULL)
+		{
+			HASH_SEQ_STATUS status;
+			DCHCacheEntry *ent;
+
+			hash_seq_init(&status, DCHCacheHash);
+			while ((ent = (DCHCacheEntry *) hash_seq_search(&status)) != NULL)
+				ent->age >>= 1;
+		}
 		DCHCounter >>= 1;
 	}
 }
@@ -3761,82 +3784,93 @@ on_error:
 	return flags;
 }
 
+/* build the hash key for the given format picture */
+static void
+DCH_cache_key(DCHCacheKey *key, const char *str, bool std)
+{
+	/* zero everything first, since padding bytes participate in hashing */
+	memset(key, 0, sizeof(DCHCacheKey));
+	strlcpy(key->str, str, DCH_CACHE_SIZE + 1);
+	key->std = std;
+}
+
 /* select a DCHCacheEntry to hold the given format picture */
 static DCHCacheEntry *
 DCH_cache_getnew(const char *str, bool std)
 {
+	DCHCacheKey key;
 	DCHCacheEntry *ent;
 
 	/* Ensure we can advance DCHCounter below */
 	DCH_prevent_counter_overflow();
 
+	if (DCHCacheHash == NULL)
+	{
+		HASHCTL		ctl;
+
+		memset(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(DCHCacheKey);
+		ctl.entrysize = sizeof(DCHCacheEntry);
+		ctl.hcxt = TopMemoryContext;
+		DCHCacheHash = hash_create("Datetime format picture cache",
+								   DCH_CACHE_ENTRIES,
+								   &ctl,
+								   HASH_ELEM | HASH_BLOBS | HASH_CONTEXT);
+	}
+
 	/*
 	 * If cache is full, remove oldest entry (or recycle first not-valid one)
 	 */
-	if (n_DCHCache >= DCH_CACHE_ENTRIES)
+	if (hash_get_num_entries(DCHCacheHash) >= DCH_CACHE_ENTRIES)
 	{
-		DCHCacheEntry *old = DCHCache[0];
+		HASH_SEQ_STATUS status;
+		DCHCacheEntry *old = NULL;
 
-#ifdef DEBUG_TO_FROM_CHAR
-		elog(DEBUG_elog_output, "cache is full (%d)", n_DCHCache);
-#endif
-		if (old->valid)
+		hash_seq_init(&status, DCHCacheHash);
+		while ((ent = (DCHCacheEntry *) hash_seq_search(&status)) != NULL)
 		{
-			for (int i = 1; i < DCH_CACHE_ENTRIES; i++)
+			if (!ent->valid)
 			{
-				ent = DCHCache[i];
-				if (!ent->valid)
-				{
-					old = ent;
-					break;
-				}
-				if (ent->age < old->age)
-					old = ent;
+				old = ent;
+				hash_seq_term(&status);
+				break;
 			}
+			if (old == NULL || ent->age < old->age)
+				old = ent;
 		}
 #ifdef DEBUG_TO_FROM_CHAR
-		elog(DEBUG_elog_output, "OLD: '%s' AGE: %d", old->str, old->age);
+		elog(DEBUG_elog_output, "OLD: '%s' AGE: %d", old->key.str, old->age);
 #endif
-		old->valid = false;
-		StrNCpy(old->str, str, DCH_CACHE_SIZE + 1);
-		old->age = (++DCHCounter);
-		/* caller is expected to fill format, then set valid */
-		return old;
-	}
-	else
-	{
-#ifdef DEBUG_TO_FROM_CHAR
-		elog(DEBUG_elog_output, "NEW (%d)", n_DCHCache);
-#endif
-		Assert(DCHCache[n_DCHCache] == NULL);
-		DCHCache[n_DCHCache] = ent = (DCHCacheEntry *)
-			MemoryContextAllocZero(TopMemoryContext, sizeof(DCHCacheEntry));
-		ent->valid = false;
-		StrNCpy(ent->str, str, DCH_CACHE_SIZE + 1);
-		ent->std = std;
-		ent->age = (++DCHCounter);
-		/* caller is expected to fill format, then set valid */
-		++n_DCHCache;
-		return ent;
+		hash_search(DCHCacheHash, &old->key, HASH_REMOVE, NULL);
 	}
+
+	DCH_cache_key(&key, str, std);
+	ent = (DCHCacheEntry *) hash_search(DCHCacheHash, &key, HASH_ENTER, NULL);
+	ent->valid = false;
+	ent->age = (++DCHCounter);
+	/* caller is expected to fill format, then set valid */
+	return ent;
 }
 
 /* look for an existing DCHCacheEntry matching the given format picture */
 static DCHCacheEntry *
 DCH_cache_search(const char *str, bool std)
 {
+	DCHCacheKey key;
+	DCHCacheEntry *ent;
+
 	/* Ensure we can advance DCHCounter below */
 	DCH_prevent_counter_overflow();
 
-	for (int i = 0; i < n_DCHCache; i++)
-	{
-		DCHCacheEntry *ent = DCHCache[i];
+	if (DCHCacheHash == NULL)
+		return NULL;
 
-		if (ent->valid && strcmp(ent->str, str) == 0 && ent->std == std)
-		{
-			ent->age = (++DCHCounter);
-			return ent;
-		}
+	DCH_cache_key(&key, str, std);
+	ent = (DCHCacheEntry *) hash_search(DCHCacheHash, &key, HASH_FIND, NULL);
+	if (ent != NULL && ent->valid)
+	{
+		ent->age = (++DCHCounter);
+		return ent;
 	}
 
 	return NULL;
@@ -3865,6 +3899,49 @@ DCH_cache_fetch(const char *str, bool std)
 	return ent;
 }
 
+/*
+ * Handle a few very common ISO-style format pictures directly, without
+ * compiling the picture into FormatNodes and interpreting them.  Returns
+ * true if it filled result, false if the caller must take the generic path.
+ *
+ * The pictures handled here contain only zero-padded numeric fields with no
+ * FM/TH/TM modifiers, so the output is locale-independent and each field is
+ * a plain "%02d"/"%04d" of the corresponding pg_tm member.  Intervals and
+ * non-positive years are left to the generic path, which knows the interval
+ * sign and BC conventions.
+ */
+static bool
+DCH_fast_to_char(const char *fmt_str, TmToChar *tmtc, bool is_interval,
+				 char *result)
+{
+	struct pg_tm *tm = tmtcTm(tmtc);
+
+	if (is_interval || tm->tm_year <= 0)
+		return false;
+
+	if (strcmp(fmt_str, "YYYY-MM-DD") == 0)
+	{
+		sprintf(result, "%04d-%02d-%02d",
+				tm->tm_year, tm->tm_mon, tm->tm_mday);
+		return true;
+	}
+	if (strcmp(fmt_str, "YYYY-MM-DD HH24:MI:SS") == 0)
+	{
+		sprintf(result, "%04d-%02d-%02d %02d:%02d:%02d",
+				tm->tm_year, tm->tm_mon, tm->tm_mday,
+				tm->tm_hour, tm->tm_min, tm->tm_sec);
+		return true;
+	}
+	if (strcmp(fmt_str, "HH24:MI:SS") == 0)
+	{
+		sprintf(result, "%02d:%02d:%02d",
+				tm->tm_hour, tm->tm_min, tm->tm_sec);
+		return true;
+	}
+
+	return false;
+}
+
 /*
  * Format a date/time or interval into a string according to fmt.
  * We parse fmt into a list of FormatNodes.  This is then passed to DCH_to_char
@@ -3892,6 +3969,17 @@ datetime_to_char_body(TmToChar *tmtc, text *fmt, bool is_interval, Oid collid)
 	result = palloc((fmt_len * DCH_MAX_ITEM_SIZ) + 1);
 	*result = '\0';
 
+	/* Fast path for common ISO format pictures */
+	if (DCH_fast_to_char(fmt_str, tmtc, is_interval, result))
+	{
+		pfree(fmt_str);
+
+		res = cstring_to_text(result);
+
+		pfree(result);
+		return res;
+	}
+
 	if (fmt_len > DCH_CACHE_SIZE)
 	{
 		/*
@@ -452,14 +452,16 @@ getKeyJsonValueFromContainer(JsonbContainer *container,
 }
 
 /*
- * Get i-th value of a Jsonb array.
+ * Get i-th value of a Jsonb array and fetch it into 'res', which is also
+ * returned.
  *
- * Returns palloc()'d copy of the value, or NULL if it does not exist.
+ * 'res' can be passed in as NULL, in which case it's newly palloc'ed here.
+ * Returns NULL if the index is out of range.
  */
 JsonbValue *
-getIthJsonbValueFromContainer(JsonbContainer *container, uint32 i)
+getIthJsonbValueFromContainer(JsonbContainer *container, uint32 i,
+							  JsonbValue *res)
 {
-	JsonbValue *result;
 	char	   *base_addr;
 	uint32		nelements;
 
@@ -472,13 +474,14 @@ getIthJsonbValueFromContainer(JsonbContainer *container, uint32 i)
 	if (i >= nelements)
 		return NULL;
 
-	result = palloc(sizeof(JsonbValue));
+	if (!res)
+		res = palloc(sizeof(JsonbValue));
 
 	fillJsonbValue(container, i, base_addr,
 				   getJsonbOffset(container, i),
-				   result);
+				   res);
 
-	return result;
+	return res;
 }
 
 /*
@@ -647,21 +647,25 @@ executeItemOptUnwrapTarget(JsonPathExecContext *cxt, JsonPathItem *jsp,
 			{
 				JsonbValue *v;
 				JsonbValue	key;
+				JsonbValue	valbuf;
+				bool		transient = jspHasNext(jsp) || !found;
 
 				key.type = jbvString;
 				key.val.string.val = jspGetString(jsp, &key.val.string.len);
 
-				v = findJsonbValueFromContainer(jb->val.binary.data,
-												JB_FOBJECT, &key);
+				/*
+				 * The fetched value need only be palloc'd if it may be
+				 * appended to the found list; otherwise use a stack buffer.
+				 */
+				v = getKeyJsonValueFromContainer(jb->val.binary.data,
+												 key.val.string.val,
+												 key.val.string.len,
+												 transient ? &valbuf : NULL);
 
 				if (v != NULL)
 				{
 					res = executeNextItem(cxt, jsp, NULL,
 										  v, found, false);
-
-					/* free value if it was not added to found list */
-					if (jspHasNext(jsp) || !found)
-						pfree(v);
 				}
 				else if (!jspIgnoreStructuralErrors(cxt))
 				{
@@ -784,7 +788,8 @@ executeItemOptUnwrapTarget(JsonPathExecContext *cxt, JsonPathItem *jsp,
 						else
 						{
 							v = getIthJsonbValueFromContainer(jb->val.binary.data,
-															  (uint32) index);
+															  (uint32) index,
+															  NULL);
 
 							if (v == NULL)
 								continue;
@@ -2100,7 +2105,6 @@ getJsonPathVariable(JsonPathExecContext *cxt, JsonPathItem *variable,
 	char	   *varName;
 	int			varNameLength;
 	JsonbValue	tmp;
-	JsonbValue *v;
 
 	if (!vars)
 	{
@@ -2110,24 +2114,13 @@ getJsonPathVariable(JsonPathExecContext *cxt, JsonPathItem *variable,
 
 	Assert(variable->type == jpiVariable);
 	varName = jspGetString(variable, &varNameLength);
-	tmp.type = jbvString;
-	tmp.val.string.val = varName;
-	tmp.val.string.len = varNameLength;
-
-	v = findJsonbValueFromContainer(&vars->root, JB_FOBJECT, &tmp);
 
-	if (v)
-	{
-		*value = *v;
-		pfree(v);
-	}
-	else
-	{
+	if (!getKeyJsonValueFromContainer(&vars->root, varName, varNameLength,
+									  value))
 		ereport(ERROR,
 				(errcode(ERRCODE_UNDEFINED_OBJECT),
 				 errmsg("could not find jsonpath variable \"%s\"",
 						pnstrdup(varName, varNameLength))));
-	}
 
 	JsonbInitBinary(&tmp, vars);
 	setBaseObject(cxt, &tmp, 1);
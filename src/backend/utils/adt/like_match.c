@@ -15,6 +15,9 @@
  * MatchText - to name of function wanted
  * do_like_escape - name of function if wanted - needs CHAREQ and CopyAdvChar
  * MATCH_LOWER - define for case (4) to specify case folding for 1-byte chars
+ * MATCH_SCAN_MEMCHR - define if a %-scan may locate candidate positions
+ *	with memchr; requires that GETCHAR is the identity and that a pattern
+ *	byte can never match a non-first byte of a text character
  *
  * Copyright (c) 1996-2019, PostgreSQL Global Development Group
  *
@@ -171,6 +174,35 @@ MatchText(const char *t, int tlen, const char *p, int plen,
 			else
 				firstpat = GETCHAR(*p);
 
+#ifdef MATCH_SCAN_MEMCHR
+
+			/*
+			 * Candidate positions are exactly the occurrences of the first
+			 * pattern byte, so find them with memchr, which is typically
+			 * vectorized by the C library.  As firstpat is taken from a
+			 * character boundary of the pattern, it cannot match a non-first
+			 * byte of a text character (see the MATCH_SCAN_MEMCHR contract),
+			 * so the candidates found are character-aligned and stepping a
+			 * single byte past a failed candidate is enough.
+			 */
+			while (tlen > 0)
+			{
+				const char *t2 = memchr(t, (unsigned char) firstpat, tlen);
+				int			matched;
+
+				if (t2 == NULL)
+					break;
+				tlen -= t2 - t;
+				t = t2;
+
+				matched = MatchText(t, tlen, p, plen,
+									locale, locale_is_c);
+				if (matched != LIKE_FALSE)
+					return matched; /* TRUE or ABORT */
+
+				NextByte(t, tlen);
+			}
+#else
 			while (tlen > 0)
 			{
 				if (GETCHAR(*t) == firstpat)
@@ -184,6 +216,7 @@ MatchText(const char *t, int tlen, const char *p, int plen,
 
 				NextChar(t, tlen);
 			}
+#endif
 
 			/*
 			 * End of text with no match, so no point in trying later places
@@ -354,6 +387,10 @@ do_like_escape(text *pat, text *esc)
 
 #undef GETCHAR
 
+#ifdef MATCH_SCAN_MEMCHR
+#undef MATCH_SCAN_MEMCHR
+#endif
+
 #ifdef MATCH_LOWER
 #undef MATCH_LOWER
 
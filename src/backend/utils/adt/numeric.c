@@ -485,6 +485,8 @@ static void int64_to_numericvar(int64 val, NumericVar *var);
 #ifdef HAVE_INT128
 static bool numericvar_to_int128(const NumericVar *var, int128 *result);
 static void int128_to_numericvar(int128 val, NumericVar *var);
+static bool numeric_to_int128_fixed(Numeric num, int scale, int128 *result);
+static Numeric int128_fixed_to_numeric(int128 val, int scale);
 #endif
 static double numeric_to_double_no_overflow(Numeric num);
 static double numericvar_to_double_no_overflow(const NumericVar *var);
@@ -2399,6 +2401,30 @@ hash_numeric_extended(PG_FUNCTION_ARGS)
  * ----------------------------------------------------------------------
  */
 
+#ifdef HAVE_INT128
+
+/*
+ * Upper bound on the number of decimal digits needed for the value of 'num'
+ * once represented as an int128 scaled by 10^scale.  Used to decide whether
+ * the fixed-point fast paths below can be taken safely: int128 accommodates
+ * a bit over 10^38, so e.g. two addends bounded by 10^37 are safe.
+ *
+ * Note that we round 'scale' up to a whole number of NBASE digit groups.
+ * numeric_to_int128_fixed() accumulates the stored digits as full groups
+ * before dividing away any positions beyond 'scale', so its intermediate
+ * value can be up to DEC_DIGITS - 1 decimal digits wider than the final
+ * result; we must bound that intermediate, not just the result.
+ */
+static inline int
+numeric_fixed_ddigits(Numeric num, int scale)
+{
+	int			ddigits = (NUMERIC_WEIGHT(num) + 1) * DEC_DIGITS;
+	int			fracdigits = ((scale + DEC_DIGITS - 1) / DEC_DIGITS) * DEC_DIGITS;
+
+	return Max(ddigits, 0) + fracdigits;
+}
+#endif							/* HAVE_INT128 */
+
 
 /*
  * numeric_add() -
@@ -2438,6 +2464,27 @@ numeric_add_opt_error(Numeric num1, Numeric num2, bool *have_error)
 	if (NUMERIC_IS_NAN(num1) || NUMERIC_IS_NAN(num2))
 		return make_result(&const_nan);
 
+#ifdef HAVE_INT128
+
+	/*
+	 * Fast path for short values, such as typical money amounts: compute in
+	 * int128 fixed point at the result's display scale, avoiding the digit
+	 * vectors and palloc traffic of add_var().  The sum of two values below
+	 * 10^37 cannot overflow int128.
+	 */
+	{
+		int			scale = Max(NUMERIC_DSCALE(num1), NUMERIC_DSCALE(num2));
+		int128		val1,
+					val2;
+
+		if (numeric_fixed_ddigits(num1, scale) <= 37 &&
+			numeric_fixed_ddigits(num2, scale) <= 37 &&
+			numeric_to_int128_fixed(num1, scale, &val1) &&
+			numeric_to_int128_fixed(num2, scale, &val2))
+			return int128_fixed_to_numeric(val1 + val2, scale);
+	}
+#endif
+
 	/*
 	 * Unpack the values, let add_var() compute the result and return it.
 	 */
@@ -2494,6 +2541,21 @@ numeric_sub_opt_error(Numeric num1, Numeric num2, bool *have_error)
 	if (NUMERIC_IS_NAN(num1) || NUMERIC_IS_NAN(num2))
 		return make_result(&const_nan);
 
+#ifdef HAVE_INT128
+	/* Fast path for short values; see numeric_add_opt_error() */
+	{
+		int			scale = Max(NUMERIC_DSCALE(num1), NUMERIC_DSCALE(num2));
+		int128		val1,
+					val2;
+
+		if (numeric_fixed_ddigits(num1, scale) <= 37 &&
+			numeric_fixed_ddigits(num2, scale) <= 37 &&
+			numeric_to_int128_fixed(num1, scale, &val1) &&
+			numeric_to_int128_fixed(num2, scale, &val2))
+			return int128_fixed_to_numeric(val1 - val2, scale);
+	}
+#endif
+
 	/*
 	 * Unpack the values, let sub_var() compute the result and return it.
 	 */
@@ -2550,6 +2612,28 @@ numeric_mul_opt_error(Numeric num1, Numeric num2, bool *have_error)
 	if (NUMERIC_IS_NAN(num1) || NUMERIC_IS_NAN(num2))
 		return make_result(&const_nan);
 
+#ifdef HAVE_INT128
+
+	/*
+	 * Fast path for short values: with each input scaled to its own display
+	 * scale, the exact product at scale dscale1 + dscale2 is just the int128
+	 * product, which cannot overflow when the inputs' decimal digit counts
+	 * sum to at most 38.
+	 */
+	{
+		int			dscale1 = NUMERIC_DSCALE(num1);
+		int			dscale2 = NUMERIC_DSCALE(num2);
+		int128		val1,
+					val2;
+
+		if (numeric_fixed_ddigits(num1, dscale1) +
+			numeric_fixed_ddigits(num2, dscale2) <= 38 &&
+			numeric_to_int128_fixed(num1, dscale1, &val1) &&
+			numeric_to_int128_fixed(num2, dscale2, &val2))
+			return int128_fixed_to_numeric(val1 * val2, dscale1 + dscale2);
+	}
+#endif
+
 	/*
 	 * Unpack the values, let mul_var() compute the result and return it.
 	 * Unlike add_var() and sub_var(), mul_var() will round its result. In the
@@ -6671,6 +6755,140 @@ int128_to_numericvar(int128 val, NumericVar *var)
 	var->ndigits = ndigits;
 	var->weight = ndigits - 1;
 }
+
+/*
+ * Convert a packed numeric directly to an int128 value scaled by 10^scale,
+ * i.e. fixed-point with 'scale' fractional decimal digits.  Returns false
+ * if the value has more fractional digits than 'scale'.
+ *
+ * The caller must have verified with numeric_fixed_ddigits() that the scaled
+ * value fits in an int128; we do not check for overflow here.  Note that the
+ * intermediate below can exceed the final value by up to DEC_DIGITS - 1
+ * decimal digits; numeric_fixed_ddigits() accounts for that.
+ */
+static bool
+numeric_to_int128_fixed(Numeric num, int scale, int128 *result)
+{
+	NumericDigit *digits = NUMERIC_DIGITS(num);
+	int			ndigits = NUMERIC_NDIGITS(num);
+	int			weight = NUMERIC_WEIGHT(num);
+	int			frac;
+	int128		val;
+	int			i;
+
+	val = 0;
+	for (i = 0; i < ndigits; i++)
+		val = val * NBASE + digits[i];
+
+	/* val is now the value scaled by 10^frac; bring it to 10^scale */
+	frac = DEC_DIGITS * (ndigits - 1 - weight);
+	if (frac > scale)
+	{
+		/*
+		 * The last NBASE digit holds up to DEC_DIGITS - 1 decimal positions
+		 * beyond 'scale'.  Those must be trailing zeroes (the value was
+		 * rounded to its display scale when it was formed); if not, the
+		 * value really has more fractional digits than 'scale' and we cannot
+		 * represent it.
+		 */
+		int128		div = 1;
+
+		while (frac > scale)
+		{
+			div *= 10;
+			frac--;
+		}
+		if (val % div != 0)
+			return false;
+		val /= div;
+	}
+	while (frac < scale)
+	{
+		val *= 10;
+		frac++;
+	}
+
+	*result = (NUMERIC_SIGN(num) == NUMERIC_NEG) ? -val : val;
+	return true;
+}
+
+/*
+ * Convert an int128 value scaled by 10^scale back to a packed numeric with
+ * display scale 'scale'.  This is the inverse of numeric_to_int128_fixed().
+ */
+static Numeric
+int128_fixed_to_numeric(int128 val, int scale)
+{
+	NumericVar	result;
+	Numeric		res;
+	uint128		uval,
+				newuval;
+	NumericDigit *ptr;
+	int			ndigits;
+	int			fracdigits;
+
+	init_var(&result);
+
+	/* int128 can require at most 39 decimal digits; add some slop */
+	alloc_var(&result, 40 / DEC_DIGITS + 2);
+	if (val < 0)
+	{
+		result.sign = NUMERIC_NEG;
+		uval = -val;
+	}
+	else
+	{
+		result.sign = NUMERIC_POS;
+		uval = val;
+	}
+	result.dscale = scale;
+
+	ptr = result.digits + result.ndigits;
+	ndigits = 0;
+	fracdigits = scale / DEC_DIGITS;
+
+	/*
+	 * The decimal point must fall on an NBASE-digit boundary.  If scale is
+	 * not a multiple of DEC_DIGITS, peel the lowest decimal digits off into
+	 * the high end of the last NBASE digit; scaling uval up to the boundary
+	 * instead could overflow.
+	 */
+	if (scale % DEC_DIGITS != 0)
+	{
+		int			div = 1;
+
+		for (int i = 0; i < scale % DEC_DIGITS; i++)
+			div *= 10;
+
+		ptr--;
+		ndigits++;
+		*ptr = (NumericDigit) ((uval % div) * (NBASE / div));
+		uval = uval / div;
+		fracdigits++;
+	}
+
+	while (uval)
+	{
+		ptr--;
+		ndigits++;
+		newuval = uval / NBASE;
+		*ptr = (NumericDigit) (uval - newuval * NBASE);
+		uval = newuval;
+	}
+
+	result.digits = ptr;
+	result.ndigits = ndigits;
+	result.weight = ndigits - 1 - fracdigits;
+
+	/* remove any leading or trailing zero NBASE digits (and handle zero) */
+	strip_var(&result);
+
+	res = make_result(&result);
+
+	free_var(&result);
+
+	return res;
+}
 #endif
 
 /*
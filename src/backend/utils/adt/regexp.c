@@ -31,10 +31,13 @@
 
 #include "catalog/pg_type.h"
 #include "funcapi.h"
+#include "lib/ilist.h"
 #include "miscadmin.h"
 #include "regex/regex.h"
 #include "utils/array.h"
 #include "utils/builtins.h"
+#include "utils/hashutils.h"
+#include "utils/hsearch.h"
 #include "utils/memutils.h"
 #include "utils/varlena.h"
 
@@ -68,46 +71,73 @@ typedef struct regexp_matches_ctx
 } regexp_matches_ctx;
 
 /*
- * We cache precompiled regular expressions using a "self organizing list"
- * structure, in which recently-used items tend to be near the front.
- * Whenever we use an entry, it's moved up to the front of the list.
- * Over time, an item's average position corresponds to its frequency of use.
+ * We cache precompiled regular expressions in a hash table keyed by the
+ * source pattern plus its compile flags and collation, with an LRU list
+ * threaded through the entries for eviction.  Whenever we use an entry,
+ * it's moved to the front of the list; when the table grows past
+ * regex_cache_size entries, the least recently used one is recompiled out.
  *
- * When we first create an entry, it's inserted at the front of
- * the array, dropping the entry at the end of the array if necessary to
- * make room.  (This might seem to be weighting the new entry too heavily,
- * but if we insert new entries further back, we'll be unable to adjust to
- * a sudden shift in the query mix where we are presented with MAX_CACHED_RES
- * never-before-seen items used circularly.  We ought to be able to handle
- * that case, so we have to insert at the front.)
- *
- * Knuth mentions a variant strategy in which a used item is moved up just
- * one place in the list.  Although he says this uses fewer comparisons on
- * average, it seems not to adapt very well to the situation where you have
- * both some reusable patterns and a steady stream of non-reusable patterns.
- * A reusable pattern that isn't used at least as often as non-reusable
- * patterns are seen will "fail to keep up" and will drop off the end of the
- * cache.  With move-to-front, a reusable pattern is guaranteed to stay in
- * the cache as long as it's used at least once in every MAX_CACHED_RES uses.
+ * An LRU-managed cache guarantees that a reusable pattern stays cached as
+ * long as it's used at least once in every regex_cache_size uses, so
+ * workloads that cycle through a large rule set of patterns can raise the
+ * GUC to hold all of them at once.
  */
 
-/* this is the maximum number of cached regular expressions */
-#ifndef MAX_CACHED_RES
-#define MAX_CACHED_RES	32
-#endif
+/* GUC: maximum number of cached regular expressions per backend */
+int			regex_cache_size = 32;
+
+/* lookup key for the compiled-RE hash table */
+typedef struct cached_re_key
+{
+	const char *pat;			/* original RE (not null terminated!) */
+	int			pat_len;		/* length of original RE, in bytes */
+	int			flags;			/* compile flags: extended,icase etc */
+	Oid			collation;		/* collation to use */
+} cached_re_key;
 
 /* this structure describes one cached regular expression */
 typedef struct cached_re_str
 {
-	char	   *cre_pat;		/* original RE (not null terminated!) */
-	int			cre_pat_len;	/* length of original RE, in bytes */
-	int			cre_flags;		/* compile flags: extended,icase etc */
-	Oid			cre_collation;	/* collation to use */
+	cached_re_key cre_key;		/* hash key; cre_key.pat is malloc'd */
 	regex_t		cre_re;			/* the compiled regular expression */
+	dlist_node	cre_lru;		/* link in LRU list */
 } cached_re_str;
 
-static int	num_res = 0;		/* # of cached re's */
-static cached_re_str re_array[MAX_CACHED_RES];	/* cached re's */
+static HTAB *re_hash = NULL;	/* cached re's */
+static dlist_head re_lru = DLIST_STATIC_INIT(re_lru);	/* MRU order */
+
+/*
+ * Hash and match support for the compiled-RE hash table.  The key holds a
+ * pointer to the pattern rather than the pattern itself, so we need custom
+ * functions that look through the pointer.
+ */
+static uint32
+re_hash_func(const void *key, Size keysize)
+{
+	const cached_re_key *k = (const cached_re_key *) key;
+	uint32		h;
+
+	Assert(keysize == sizeof(cached_re_key));
+	h = DatumGetUInt32(hash_any((const unsigned char *) k->pat, k->pat_len));
+	h = hash_combine(h, (uint32) k->flags);
+	h = hash_combine(h, (uint32) k->collation);
+	return h;
+}
+
+static int
+re_match_func(const void *key1, const void *key2, Size keysize)
+{
+	const cached_re_key *k1 = (const cached_re_key *) key1;
+	const cached_re_key *k2 = (const cached_re_key *) key2;
+
+	Assert(keysize == sizeof(cached_re_key));
+	if (k1->pat_len == k2->pat_len &&
+		k1->flags == k2->flags &&
+		k1->collation == k2->collation &&
+		memcmp(k1->pat, k2->pat, k1->pat_len) == 0)
+		return 0;
+	return 1;
+}
 
 
 /* Local functions */
@@ -140,35 +170,44 @@ RE_compile_and_cache(text *text_re, int cflags, Oid collation)
 	char	   *text_re_val = VARDATA_ANY(text_re);
 	pg_wchar   *pattern;
 	int			pattern_len;
-	int			i;
 	int			regcomp_result;
-	cached_re_str re_temp;
+	cached_re_key re_key;
+	cached_re_str *re_entry;
+	regex_t		re_temp;
+	char	   *pat_copy;
+	bool		found;
 	char		errMsg[100];
 
-	/*
-	 * Look for a match among previously compiled REs.  Since the data
-	 * structure is self-organizing with most-used entries at the front, our
-	 * search strategy can just be to scan from the front.
-	 */
-	for (i = 0; i < num_res; i++)
+	if (re_hash == NULL)
 	{
-		if (re_array[i].cre_pat_len == text_re_len &&
-			re_array[i].cre_flags == cflags &&
-			re_array[i].cre_collation == collation &&
-			memcmp(re_array[i].cre_pat, text_re_val, text_re_len) == 0)
-		{
-			/*
-			 * Found a match; move it to front if not there already.
-			 */
-			if (i > 0)
-			{
-				re_temp = re_array[i];
-				memmove(&re_array[1], &re_array[0], i * sizeof(cached_re_str));
-				re_array[0] = re_temp;
-			}
+		HASHCTL		ctl;
+
+		MemSet(&ctl, 0, sizeof(ctl));
+		ctl.keysize = sizeof(cached_re_key);
+		ctl.entrysize = sizeof(cached_re_str);
+		ctl.hash = re_hash_func;
+		ctl.match = re_match_func;
+		ctl.hcxt = TopMemoryContext;
+		re_hash = hash_create("Compiled regex cache", 64, &ctl,
+							  HASH_ELEM | HASH_FUNCTION | HASH_COMPARE |
+							  HASH_CONTEXT);
+	}
 
-			return &re_array[0].cre_re;
-		}
+	/* Look for a match among previously compiled REs */
+	re_key.pat = text_re_val;
+	re_key.pat_len = text_re_len;
+	re_key.flags = cflags;
+	re_key.collation = collation;
+
+	re_entry = (cached_re_str *) hash_search(re_hash, &re_key,
+											 HASH_FIND, NULL);
+	if (re_entry != NULL)
+	{
+		/* Found a match; move it to the LRU front if not there already */
+		if (dlist_head_node(&re_lru) != &re_entry->cre_lru)
+			dlist_move_head(&re_lru, &re_entry->cre_lru);
+
+		return &re_entry->cre_re;
 	}
 
 	/*
@@ -182,7 +221,7 @@ RE_compile_and_cache(text *text_re, int cflags, Oid collation)
 									   pattern,
 									   text_re_len);
 
-	regcomp_result = pg_regcomp(&re_temp.cre_re,
+	regcomp_result = pg_regcomp(&re_temp,
 								pattern,
 								pattern_len,
 								cflags,
@@ -202,50 +241,62 @@ RE_compile_and_cache(text *text_re, int cflags, Oid collation)
 		 */
 		CHECK_FOR_INTERRUPTS();
 
-		pg_regerror(regcomp_result, &re_temp.cre_re, errMsg, sizeof(errMsg));
+		pg_regerror(regcomp_result, &re_temp, errMsg, sizeof(errMsg));
 		ereport(ERROR,
 				(errcode(ERRCODE_INVALID_REGULAR_EXPRESSION),
 				 errmsg("invalid regular expression: %s", errMsg)));
 	}
 
 	/*
-	 * We use malloc/free for the cre_pat field because the storage has to
-	 * persist across transactions, and because we want to get control back on
-	 * out-of-memory.  The Max() is because some malloc implementations return
-	 * NULL for malloc(0).
+	 * We use malloc/free for the pattern copy because the storage has to
+	 * persist across transactions, and because we want to get control back
+	 * on out-of-memory.  The Max() is because some malloc implementations
+	 * return NULL for malloc(0).
 	 */
-	re_temp.cre_pat = malloc(Max(text_re_len, 1));
-	if (re_temp.cre_pat == NULL)
+	pat_copy = malloc(Max(text_re_len, 1));
+	if (pat_copy == NULL)
 	{
-		pg_regfree(&re_temp.cre_re);
+		pg_regfree(&re_temp);
 		ereport(ERROR,
 				(errcode(ERRCODE_OUT_OF_MEMORY),
 				 errmsg("out of memory")));
 	}
-	memcpy(re_temp.cre_pat, text_re_val, text_re_len);
-	re_temp.cre_pat_len = text_re_len;
-	re_temp.cre_flags = cflags;
-	re_temp.cre_collation = collation;
+	memcpy(pat_copy, text_re_val, text_re_len);
 
 	/*
-	 * Okay, we have a valid new item in re_temp; insert it into the storage
-	 * array.  Discard last entry if needed.
+	 * Okay, we have a valid new item; discard least recently used entries
+	 * as needed to respect regex_cache_size, then enter it into the hash
+	 * table and LRU list.
 	 */
-	if (num_res >= MAX_CACHED_RES)
+	while (hash_get_num_entries(re_hash) >= regex_cache_size)
 	{
-		--num_res;
-		Assert(num_res < MAX_CACHED_RES);
-		pg_regfree(&re_array[num_res].cre_re);
-		free(re_array[num_res].cre_pat);
-	}
+		cached_re_str *victim;
+		cached_re_key victim_key;
+		regex_t		victim_re;
+
+		victim = dlist_container(cached_re_str, cre_lru,
+								 dlist_tail_node(&re_lru));
 
-	if (num_res > 0)
-		memmove(&re_array[1], &re_array[0], num_res * sizeof(cached_re_str));
+		/* copy out what we must release; removal recycles the entry */
+		victim_key = victim->cre_key;
+		victim_re = victim->cre_re;
+
+		dlist_delete(&victim->cre_lru);
+		if (hash_search(re_hash, &victim_key, HASH_REMOVE, NULL) == NULL)
+			elog(ERROR, "compiled regex cache is corrupted");
+
+		pg_regfree(&victim_re);
+		free(unconstify(char *, victim_key.pat));
+	}
 
-	re_array[0] = re_temp;
-	num_res++;
+	re_key.pat = pat_copy;
+	re_entry = (cached_re_str *) hash_search(re_hash, &re_key,
+											 HASH_ENTER, &found);
+	Assert(!found);
+	re_entry->cre_re = re_temp;
+	dlist_push_head(&re_lru, &re_entry->cre_lru);
 
-	return &re_array[0].cre_re;
+	return &re_entry->cre_re;
 }
 
 /*
@@ -161,12 +161,43 @@ typedef struct RI_CompareHashEntry
 } RI_CompareHashEntry;
 
 
+/*
+ * RI_ValidatedKeyEntry
+ *
+ *	Remembers, per constraint, the FK key most recently validated against
+ *	the PK table in the current transaction.  Because the validating query
+ *	took a FOR KEY SHARE lock on the referenced row, no other transaction
+ *	can delete it or change its key until we commit, so a subsequent check
+ *	of an equal key can be skipped outright.  That turns bulk loads that
+ *	reference the same parent rows repeatedly from one SPI query per row
+ *	into one per distinct consecutive key.
+ *
+ *	An entry is trusted only while its epoch matches
+ *	ri_validated_key_epoch; the epoch advances whenever something happens
+ *	that could break the reasoning above: our own transaction modifies
+ *	referenced rows (any PK-side RI trigger runs), a subtransaction aborts
+ *	(releasing its row locks), the transaction ends, or a relcache
+ *	invalidation arrives (covering TRUNCATE and DDL on either table).
+ */
+typedef struct RI_ValidatedKeyEntry
+{
+	Oid			constraint_id;	/* hash key -- must be first */
+	uint64		epoch;			/* ri_validated_key_epoch at save time */
+	bool		valid;			/* are key_values[] filled and owned? */
+	int			nkeys;			/* number of stored key columns */
+	bool		key_byval[RI_MAX_NUMKEYS];	/* for freeing on overwrite */
+	Datum		key_values[RI_MAX_NUMKEYS]; /* copies in TopMemoryContext */
+} RI_ValidatedKeyEntry;
+
+
 /*
  * Local data
  */
 static HTAB *ri_constraint_cache = NULL;
 static HTAB *ri_query_cache = NULL;
 static HTAB *ri_compare_cache = NULL;
+static HTAB *ri_validated_key_cache = NULL;
+static uint64 ri_validated_key_epoch = 0;
 static dlist_head ri_constraint_cache_valid_list;
 static int	ri_constraint_cache_valid_count = 0;
 
@@ -199,6 +230,16 @@ static bool ri_AttributesEqual(Oid eq_opr, Oid typeid,
 
 static void ri_InitHashTables(void);
 static void InvalidateConstraintCacheCallBack(Datum arg, int cacheid, uint32 hashvalue);
+static bool ri_KeyAlreadyValidated(const RI_ConstraintInfo *riinfo,
+								   Relation fk_rel, TupleTableSlot *newslot);
+static void ri_SaveValidatedKey(const RI_ConstraintInfo *riinfo,
+								Relation fk_rel, TupleTableSlot *newslot);
+static void InvalidateValidatedKeyCacheCallBack(Datum arg, Oid relid);
+static void ri_ValidatedKeyXactCallback(XactEvent event, void *arg);
+static void ri_ValidatedKeySubXactCallback(SubXactEvent event,
+										   SubTransactionId mySubid,
+										   SubTransactionId parentSubid,
+										   void *arg);
 static SPIPlanPtr ri_FetchPreparedPlan(RI_QueryKey *key);
 static void ri_HashPreparedPlan(RI_QueryKey *key, SPIPlanPtr plan);
 static RI_CompareHashEntry *ri_HashCompareOp(Oid eq_opr, Oid typeid);
@@ -335,6 +376,17 @@ RI_FKey_check(TriggerData *trigdata)
 			break;
 	}
 
+	/*
+	 * If we validated this very key against the PK table earlier in this
+	 * transaction, we still hold a KEY SHARE lock on the referenced row, so
+	 * there is no need to look it up again.
+	 */
+	if (ri_KeyAlreadyValidated(riinfo, fk_rel, newslot))
+	{
+		table_close(pk_rel, RowShareLock);
+		return PointerGetDatum(NULL);
+	}
+
 	if (SPI_connect() != SPI_OK_CONNECT)
 		elog(ERROR, "SPI_connect failed");
 
@@ -400,6 +452,9 @@ RI_FKey_check(TriggerData *trigdata)
 	if (SPI_finish() != SPI_OK_FINISH)
 		elog(ERROR, "SPI_finish failed");
 
+	/* Remember the key so equal keys can skip the next lookup */
+	ri_SaveValidatedKey(riinfo, fk_rel, newslot);
+
 	table_close(pk_rel, RowShareLock);
 
 	return PointerGetDatum(NULL);
@@ -624,6 +679,9 @@ ri_restrict(TriggerData *trigdata, bool is_no_action)
 	riinfo = ri_FetchConstraintInfo(trigdata->tg_trigger,
 									trigdata->tg_relation, true);
 
+	/* Our transaction modifies PK rows; stop trusting validated FK keys */
+	ri_validated_key_epoch++;
+
 	/*
 	 * Get the relation descriptors of the FK and PK tables and the old tuple.
 	 *
@@ -747,6 +805,9 @@ RI_FKey_cascade_del(PG_FUNCTION_ARGS)
 	riinfo = ri_FetchConstraintInfo(trigdata->tg_trigger,
 									trigdata->tg_relation, true);
 
+	/* Our transaction modifies PK rows; stop trusting validated FK keys */
+	ri_validated_key_epoch++;
+
 	/*
 	 * Get the relation descriptors of the FK and PK tables and the old tuple.
 	 *
@@ -854,6 +915,9 @@ RI_FKey_cascade_upd(PG_FUNCTION_ARGS)
 	riinfo = ri_FetchConstraintInfo(trigdata->tg_trigger,
 									trigdata->tg_relation, true);
 
+	/* Our transaction modifies PK rows; stop trusting validated FK keys */
+	ri_validated_key_epoch++;
+
 	/*
 	 * Get the relation descriptors of the FK and PK tables and the new and
 	 * old tuple.
@@ -1031,6 +1095,9 @@ ri_set(TriggerData *trigdata, bool is_set_null)
 	riinfo = ri_FetchConstraintInfo(trigdata->tg_trigger,
 									trigdata->tg_relation, true);
 
+	/* Our transaction modifies PK rows; stop trusting validated FK keys */
+	ri_validated_key_epoch++;
+
 	/*
 	 * Get the relation descriptors of the FK and PK tables and the old tuple.
 	 *
@@ -2563,6 +2630,159 @@ ri_InitHashTables(void)
 	ri_compare_cache = hash_create("RI compare cache",
 								   RI_INIT_QUERYHASHSIZE,
 								   &ctl, HASH_ELEM | HASH_BLOBS);
+
+	memset(&ctl, 0, sizeof(ctl));
+	ctl.keysize = sizeof(Oid);
+	ctl.entrysize = sizeof(RI_ValidatedKeyEntry);
+	ri_validated_key_cache = hash_create("RI validated key cache",
+										 RI_INIT_CONSTRAINTHASHSIZE,
+										 &ctl, HASH_ELEM | HASH_BLOBS);
+
+	/*
+	 * Validated keys can't be trusted across transaction end or a
+	 * subtransaction abort (the row locks backing them go away), nor across
+	 * anything that invalidates a relcache entry (TRUNCATE, DDL).
+	 */
+	RegisterXactCallback(ri_ValidatedKeyXactCallback, NULL);
+	RegisterSubXactCallback(ri_ValidatedKeySubXactCallback, NULL);
+	CacheRegisterRelcacheCallback(InvalidateValidatedKeyCacheCallBack,
+								  (Datum) 0);
+}
+
+/*
+ * ri_KeyAlreadyValidated -
+ *
+ * Is the (fully non-null) FK key in newslot equal to the key we most
+ * recently validated for this constraint, under an epoch we still trust?
+ */
+static bool
+ri_KeyAlreadyValidated(const RI_ConstraintInfo *riinfo,
+					   Relation fk_rel, TupleTableSlot *newslot)
+{
+	RI_ValidatedKeyEntry *entry;
+
+	if (!ri_validated_key_cache)
+		ri_InitHashTables();
+
+	entry = (RI_ValidatedKeyEntry *) hash_search(ri_validated_key_cache,
+												 (void *) &riinfo->constraint_id,
+												 HASH_FIND, NULL);
+	if (entry == NULL ||
+		!entry->valid ||
+		entry->epoch != ri_validated_key_epoch ||
+		entry->nkeys != riinfo->nkeys)
+		return false;
+
+	for (int i = 0; i < riinfo->nkeys; i++)
+	{
+		Datum		value;
+		bool		isnull;
+
+		value = slot_getattr(newslot, riinfo->fk_attnums[i], &isnull);
+		if (isnull)
+			return false;
+		if (!ri_AttributesEqual(riinfo->ff_eq_oprs[i],
+								RIAttType(fk_rel, riinfo->fk_attnums[i]),
+								entry->key_values[i], value))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * ri_SaveValidatedKey -
+ *
+ * Remember the FK key we just successfully validated (and row-locked) for
+ * this constraint, replacing whatever the entry held before.
+ */
+static void
+ri_SaveValidatedKey(const RI_ConstraintInfo *riinfo,
+					Relation fk_rel, TupleTableSlot *newslot)
+{
+	RI_ValidatedKeyEntry *entry;
+	TupleDesc	tupdesc = RelationGetDescr(fk_rel);
+	bool		found;
+
+	if (!ri_validated_key_cache)
+		ri_InitHashTables();
+
+	entry = (RI_ValidatedKeyEntry *) hash_search(ri_validated_key_cache,
+												 (void *) &riinfo->constraint_id,
+												 HASH_ENTER, &found);
+
+	/* Release the datums owned by a previous incarnation of the entry */
+	if (found && entry->valid)
+	{
+		for (int i = 0; i < entry->nkeys; i++)
+		{
+			if (!entry->key_byval[i])
+				pfree(DatumGetPointer(entry->key_values[i]));
+		}
+	}
+	entry->valid = false;
+
+	entry->nkeys = riinfo->nkeys;
+	for (int i = 0; i < riinfo->nkeys; i++)
+	{
+		Form_pg_attribute att = TupleDescAttr(tupdesc,
+											  riinfo->fk_attnums[i] - 1);
+		Datum		value;
+		bool		isnull;
+		MemoryContext oldcontext;
+
+		value = slot_getattr(newslot, riinfo->fk_attnums[i], &isnull);
+		if (isnull)				/* can't happen, but don't cache if so */
+			return;
+
+		/* the other RI caches live in TopMemoryContext, so this does too */
+		oldcontext = MemoryContextSwitchTo(TopMemoryContext);
+		entry->key_values[i] = datumCopy(value, att->attbyval, att->attlen);
+		MemoryContextSwitchTo(oldcontext);
+		entry->key_byval[i] = att->attbyval;
+		entry->nkeys = i + 1;	/* so a partial fill is freed correctly */
+		entry->valid = true;	/* datums up to nkeys are owned */
+	}
+
+	entry->epoch = ri_validated_key_epoch;
+}
+
+/*
+ * InvalidateValidatedKeyCacheCallBack -
+ *
+ * Relcache inval callback: some relation changed in a way we can't analyze
+ * here (TRUNCATE, ALTER TABLE, ...), so stop trusting validated keys.
+ */
+static void
+InvalidateValidatedKeyCacheCallBack(Datum arg, Oid relid)
+{
+	ri_validated_key_epoch++;
+}
+
+/*
+ * ri_ValidatedKeyXactCallback -
+ *
+ * Row locks don't survive transaction end, so neither may validated keys.
+ */
+static void
+ri_ValidatedKeyXactCallback(XactEvent event, void *arg)
+{
+	ri_validated_key_epoch++;
+}
+
+/*
+ * ri_ValidatedKeySubXactCallback -
+ *
+ * A subtransaction abort releases the row locks it took, so validated keys
+ * saved underneath it must die with it.  (We can't tell which those were,
+ * so all of them do.)
+ */
+static void
+ri_ValidatedKeySubXactCallback(SubXactEvent event, SubTransactionId mySubid,
+							   SubTransactionId parentSubid, void *arg)
+{
+	if (event == SUBXACT_EVENT_ABORT_SUB)
+		ri_validated_key_epoch++;
 }
 
 
@@ -2139,7 +2139,18 @@ timestamp_sortsupport(PG_FUNCTION_ARGS)
 {
 	SortSupport ssup = (SortSupport) PG_GETARG_POINTER(0);
 
+#if SIZEOF_DATUM >= 8
+	/*
+	 * If this build has pass-by-value timestamps, then we can use a standard
+	 * comparator function.
+	 */
+	if (FLOAT8PASSBYVAL)
+		ssup->comparator = ssup_datum_signed_cmp;
+	else
+		ssup->comparator = timestamp_fastcmp;
+#else
 	ssup->comparator = timestamp_fastcmp;
+#endif
 	PG_RETURN_VOID();
 }
 
@@ -39,8 +39,30 @@ typedef struct
 	WordEntry  *arre;
 	char	   *values;
 	char	   *operand;
+	QueryItem  *items;			/* start of the query's items, or NULL */
+	struct TSMatchCache *cache; /* cross-row match cache, or NULL */
 } CHKVAL;
 
+/*
+ * Cached per-query state for repeated @@ evaluation, kept in fn_extra by
+ * ts_match_vq.  A tsquery often names the same lexeme in several operands
+ * (e.g. queries produced by websearch_to_tsquery, or hand-written ones such
+ * as 'x & (x <-> y)').  We assign each distinct (lexeme, prefix, weight)
+ * combination a slot once per query, and then memoize the slot's boolean
+ * result within each evaluation, so the tsvector is binary-searched only
+ * once per distinct lexeme per row.  Position-collecting lookups made on
+ * behalf of phrase operators bypass the cache.
+ */
+typedef struct TSMatchCache
+{
+	TSQuery		query;			/* verification copy of the tsquery */
+	int		   *slotmap;		/* QueryItem index -> slot, -1 for operators */
+	int			nslots;			/* number of distinct lexeme slots */
+	uint64		seqno;			/* current evaluation's sequence number */
+	uint64	   *slot_seqno;		/* seqno at which each slot was computed */
+	bool	   *slot_res;		/* each slot's cached result */
+} TSMatchCache;
+
 
 typedef struct StatEntry
 {
@@ -1269,8 +1291,24 @@ checkcondition_str(void *checkval, QueryOperand *val, ExecPhraseData *data)
 	WordEntry  *StopHigh = chkval->arre;
 	WordEntry  *StopMiddle = StopHigh;
 	int			difference = -1;
+	int			slot = -1;
 	bool		res = false;
 
+	/*
+	 * Boolean lookups can be served from the per-row memo if this lexeme was
+	 * already checked during the current evaluation.  Position-collecting
+	 * lookups must always examine the tsvector.
+	 */
+	if (chkval->cache != NULL && data == NULL)
+	{
+		TSMatchCache *cache = chkval->cache;
+
+		slot = cache->slotmap[(QueryItem *) val - chkval->items];
+		Assert(slot >= 0 && slot < cache->nslots);
+		if (cache->slot_seqno[slot] == cache->seqno)
+			return cache->slot_res[slot];
+	}
+
 	/* Loop invariant: StopLow <= val < StopHigh */
 	while (StopLow < StopHigh)
 	{
@@ -1359,6 +1397,13 @@ checkcondition_str(void *checkval, QueryOperand *val, ExecPhraseData *data)
 		}
 	}
 
+	/* Remember the result for any further occurrences of this lexeme */
+	if (slot >= 0)
+	{
+		chkval->cache->slot_seqno[slot] = chkval->cache->seqno;
+		chkval->cache->slot_res[slot] = res;
+	}
+
 	return res;
 }
 
@@ -1864,6 +1909,96 @@ tsquery_requires_match(QueryItem *curitem)
 	return false;
 }
 
+/*
+ * Fetch, building or rebuilding it if necessary, the TSMatchCache for the
+ * given query.  The cache lives in fn_mcxt so that, in the common case of
+ * evaluating one constant tsquery against many rows, the query's operands
+ * are analyzed just once.
+ */
+static TSMatchCache *
+ts_match_get_cache(FmgrInfo *flinfo, TSQuery query)
+{
+	TSMatchCache *cache = (TSMatchCache *) flinfo->fn_extra;
+	MemoryContext oldcontext;
+	QueryItem  *items;
+	char	   *operand;
+	int			nslots;
+	int			i;
+
+	if (cache != NULL)
+	{
+		if (VARSIZE(cache->query) == VARSIZE(query) &&
+			memcmp(cache->query, query, VARSIZE(query)) == 0)
+			return cache;
+
+		/* different query than last time; drop the stale state */
+		pfree(cache->query);
+		pfree(cache->slotmap);
+		pfree(cache->slot_seqno);
+		pfree(cache->slot_res);
+	}
+	else
+	{
+		cache = (TSMatchCache *)
+			MemoryContextAllocZero(flinfo->fn_mcxt, sizeof(TSMatchCache));
+		flinfo->fn_extra = (void *) cache;
+	}
+
+	oldcontext = MemoryContextSwitchTo(flinfo->fn_mcxt);
+
+	cache->query = (TSQuery) palloc(VARSIZE(query));
+	memcpy(cache->query, query, VARSIZE(query));
+	cache->slotmap = (int *) palloc(query->size * sizeof(int));
+
+	/*
+	 * Assign each operand a slot, giving repeated occurrences of the same
+	 * lexeme (with the same prefix and weight treatment) the same slot.
+	 * Queries are small, so a quadratic scan is fine here.
+	 */
+	items = GETQUERY(query);
+	operand = GETOPERAND(query);
+	nslots = 0;
+	for (i = 0; i < query->size; i++)
+	{
+		QueryOperand *op = &items[i].qoperand;
+		int			slot = -1;
+		int			j;
+
+		if (items[i].type != QI_VAL)
+		{
+			cache->slotmap[i] = -1;
+			continue;
+		}
+
+		for (j = 0; j < i; j++)
+		{
+			QueryOperand *prev = &items[j].qoperand;
+
+			if (cache->slotmap[j] >= 0 &&
+				prev->length == op->length &&
+				prev->prefix == op->prefix &&
+				prev->weight == op->weight &&
+				memcmp(operand + prev->distance, operand + op->distance,
+					   op->length) == 0)
+			{
+				slot = cache->slotmap[j];
+				break;
+			}
+		}
+
+		cache->slotmap[i] = (slot >= 0) ? slot : nslots++;
+	}
+
+	cache->nslots = nslots;
+	cache->seqno = 0;
+	cache->slot_seqno = (uint64 *) palloc0(nslots * sizeof(uint64));
+	cache->slot_res = (bool *) palloc(nslots * sizeof(bool));
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return cache;
+}
+
 /*
  * boolean operations
  */
@@ -1895,6 +2030,17 @@ ts_match_vq(PG_FUNCTION_ARGS)
 	chkval.arre = chkval.arrb + val->size;
 	chkval.values = STRPTR(val);
 	chkval.operand = GETOPERAND(query);
+	chkval.items = GETQUERY(query);
+
+	/* use the cross-row match cache unless called without flinfo support */
+	if (fcinfo->flinfo != NULL)
+	{
+		chkval.cache = ts_match_get_cache(fcinfo->flinfo, query);
+		chkval.cache->seqno++;
+	}
+	else
+		chkval.cache = NULL;
+
 	result = TS_execute(GETQUERY(query),
 						&chkval,
 						TS_EXEC_CALC_NOT,
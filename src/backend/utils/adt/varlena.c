@@ -40,6 +40,17 @@
 /* GUC variable */
 int			bytea_output = BYTEA_OUTPUT_HEX;
 
+/*
+ * GUC variable: whether strxfrm() can be trusted to produce results that are
+ * consistent with strcoll(), which the abbreviated-key optimization requires.
+ * Building with -DTRUST_STRXFRM changes the default.
+ */
+#ifdef TRUST_STRXFRM
+bool		trust_strxfrm = true;
+#else
+bool		trust_strxfrm = false;
+#endif
+
 typedef struct varlena unknown;
 typedef struct varlena VarString;
 
@@ -112,7 +123,6 @@ static int	namefastcmp_c(Datum x, Datum y, SortSupport ssup);
 static int	varlenafastcmp_locale(Datum x, Datum y, SortSupport ssup);
 static int	namefastcmp_locale(Datum x, Datum y, SortSupport ssup);
 static int	varstrfastcmp_locale(char *a1p, int len1, char *a2p, int len2, SortSupport ssup);
-static int	varstrcmp_abbrev(Datum x, Datum y, SortSupport ssup);
 static Datum varstr_abbrev_convert(Datum original, SortSupport ssup);
 static bool varstr_abbrev_abort(int memtupcount, SortSupport ssup);
 static int32 text_length(Datum str);
@@ -1352,29 +1362,41 @@ text_position_next_internal(char *start_ptr, TextPositionState *state)
 
 	if (needle_len == 1)
 	{
-		/* No point in using B-M-H for a one-character needle */
-		char		nchar = *needle;
-
-		hptr = start_ptr;
-		while (hptr < haystack_end)
-		{
-			if (*hptr == nchar)
-				return (char *) hptr;
-			hptr++;
-		}
+		/*
+		 * No point in using B-M-H for a one-character needle; memchr is
+		 * typically vectorized by the C library.
+		 */
+		return memchr(start_ptr, (unsigned char) *needle,
+					  haystack_end - start_ptr);
 	}
 	else
 	{
 		const char *needle_last = &needle[needle_len - 1];
+		char		lastchar = *needle_last;
 
 		/* Start at startpos plus the length of the needle */
 		hptr = start_ptr + needle_len - 1;
 		while (hptr < haystack_end)
 		{
-			/* Match the needle scanning *backward* */
 			const char *nptr;
 			const char *p;
 
+			/*
+			 * A match must place the last needle byte here, so positions
+			 * where that byte differs cannot end a match; use memchr, which
+			 * is typically vectorized by the C library, to jump straight to
+			 * the next position that can.  The skip table below still
+			 * provides the B-M-H shift once a candidate fails.
+			 */
+			if (*hptr != lastchar)
+			{
+				hptr = memchr(hptr, (unsigned char) lastchar,
+							  haystack_end - hptr);
+				if (hptr == NULL)
+					break;
+			}
+
+			/* Match the needle scanning *backward* */
 			nptr = needle_last;
 			p = hptr;
 			while (*nptr == *p)
@@ -2038,7 +2060,9 @@ varstr_sortsupport(SortSupport ssup, Oid typid, Oid collid)
 	 * other libc other than Cygwin has so far been shown to have a problem,
 	 * we take the conservative course of action for right now and disable
 	 * this categorically.  (Users who are certain this isn't a problem on
-	 * their system can define TRUST_STRXFRM.)
+	 * their system can enable the trust_strxfrm GUC, or define TRUST_STRXFRM
+	 * to change its default.)  ICU is not affected; its sort keys are
+	 * documented to be consistent with its comparisons.
 	 *
 	 * Even apart from the risk of broken locales, it's possible that there
 	 * are platforms where the use of abbreviated keys should be disabled at
@@ -2051,10 +2075,9 @@ varstr_sortsupport(SortSupport ssup, Oid typid, Oid collid)
 	 * categorically, we may still want or need to disable it for particular
 	 * platforms.
 	 */
-#ifndef TRUST_STRXFRM
-	if (!collate_c && !(locale && locale->provider == COLLPROVIDER_ICU))
+	if (!trust_strxfrm &&
+		!collate_c && !(locale && locale->provider == COLLPROVIDER_ICU))
 		abbreviate = false;
-#endif
 
 	/*
 	 * If we're using abbreviated keys, or if we're using a locale-aware
@@ -2107,7 +2130,7 @@ varstr_sortsupport(SortSupport ssup, Oid typid, Oid collid)
 			initHyperLogLog(&sss->abbr_card, 10);
 			initHyperLogLog(&sss->full_card, 10);
 			ssup->abbrev_full_comparator = ssup->comparator;
-			ssup->comparator = varstrcmp_abbrev;
+			ssup->comparator = ssup_datum_unsigned_cmp;
 			ssup->abbrev_converter = varstr_abbrev_convert;
 			ssup->abbrev_abort = varstr_abbrev_abort;
 		}
@@ -2393,27 +2416,6 @@ varstrfastcmp_locale(char *a1p, int len1, char *a2p, int len2, SortSupport ssup)
 	return result;
 }
 
-/*
- * Abbreviated key comparison func
- */
-static int
-varstrcmp_abbrev(Datum x, Datum y, SortSupport ssup)
-{
-	/*
-	 * When 0 is returned, the core system will call varstrfastcmp_c()
-	 * (bpcharfastcmp_c() in BpChar case) or varlenafastcmp_locale().  Even a
-	 * strcmp() on two non-truncated strxfrm() blobs cannot indicate *equality*
-	 * authoritatively, for the same reason that there is a strcoll()
-	 * tie-breaker call to strcmp() in varstr_cmp().
-	 */
-	if (x > y)
-		return 1;
-	else if (x == y)
-		return 0;
-	else
-		return -1;
-}
-
 /*
  * Conversion routine for sortsupport.  Converts original to abbreviated key
  * representation.  Our encoding strategy is simple -- pack the first 8 bytes
@@ -2452,7 +2454,7 @@ varstr_abbrev_convert(Datum original, SortSupport ssup)
 	 * strings may contain NUL bytes.  Besides, this should be faster, too.
 	 *
 	 * More generally, it's okay that bytea callers can have NUL bytes in
-	 * strings because varstrcmp_abbrev() need not make a distinction between
+	 * strings because ssup_datum_unsigned_cmp() need not make a distinction between
 	 * terminating NUL bytes, and NUL bytes representing actual NULs in the
 	 * authoritative representation.  Hopefully a comparison at or past one
 	 * abbreviated key's terminating NUL byte will resolve the comparison
@@ -2642,7 +2644,7 @@ done:
 	/*
 	 * Byteswap on little-endian machines.
 	 *
-	 * This is needed so that varstrcmp_abbrev() (an unsigned integer 3-way
+	 * This is needed so that ssup_datum_unsigned_cmp() (an unsigned integer 3-way
 	 * comparator) works correctly on all platforms.  If we didn't do this,
 	 * the comparator would have to call memcmp() with a pair of pointers to
 	 * the first byte of each abbreviated key, which is slower.
@@ -5325,14 +5327,30 @@ text_left(PG_FUNCTION_ARGS)
 
 	if (n < 0)
 	{
-		text	   *str = PG_GETARG_TEXT_PP(0);
-		const char *p = VARDATA_ANY(str);
-		int			len = VARSIZE_ANY_EXHDR(str);
-		int			rlen;
+		/*
+		 * In single-byte encodings the character count equals the byte
+		 * count, which the toast metadata can tell us without detoasting
+		 * anything; text_substring() then fetches only the prefix slice.
+		 */
+		if (pg_database_encoding_max_length() == 1)
+		{
+			Datum		str = PG_GETARG_DATUM(0);
+			int64		len = toast_raw_datum_size(str) - VARHDRSZ;
 
-		n = pg_mbstrlen_with_len(p, len) + n;
-		rlen = pg_mbcharcliplen(p, len, n);
-		PG_RETURN_TEXT_P(cstring_to_text_with_len(p, rlen));
+			len = Max(len + n, (int64) 0);
+			PG_RETURN_TEXT_P(text_substring(str, 1, (int32) len, false));
+		}
+		else
+		{
+			text	   *str = PG_GETARG_TEXT_PP(0);
+			const char *p = VARDATA_ANY(str);
+			int			len = VARSIZE_ANY_EXHDR(str);
+			int			rlen;
+
+			n = pg_mbstrlen_with_len(p, len) + n;
+			rlen = pg_mbcharcliplen(p, len, n);
+			PG_RETURN_TEXT_P(cstring_to_text_with_len(p, rlen));
+		}
 	}
 	else
 		PG_RETURN_TEXT_P(text_substring(PG_GETARG_DATUM(0), 1, n, false));
@@ -5345,19 +5363,41 @@ text_left(PG_FUNCTION_ARGS)
 Datum
 text_right(PG_FUNCTION_ARGS)
 {
-	text	   *str = PG_GETARG_TEXT_PP(0);
-	const char *p = VARDATA_ANY(str);
-	int			len = VARSIZE_ANY_EXHDR(str);
 	int			n = PG_GETARG_INT32(1);
-	int			off;
 
-	if (n < 0)
-		n = -n;
+	/*
+	 * As in text_left, a single-byte encoding lets us find the split point
+	 * from the toast metadata alone and fetch just the suffix slice,
+	 * instead of detoasting and decompressing the whole value.
+	 */
+	if (pg_database_encoding_max_length() == 1)
+	{
+		Datum		str = PG_GETARG_DATUM(0);
+		int64		len = toast_raw_datum_size(str) - VARHDRSZ;
+		int64		off;
+
+		if (n < 0)
+			off = Min((int64) -((int64) n), len);
+		else
+			off = Max(len - n, (int64) 0);
+
+		PG_RETURN_TEXT_P(DatumGetTextPSlice(str, (int32) off, -1));
+	}
 	else
-		n = pg_mbstrlen_with_len(p, len) - n;
-	off = pg_mbcharcliplen(p, len, n);
+	{
+		text	   *str = PG_GETARG_TEXT_PP(0);
+		const char *p = VARDATA_ANY(str);
+		int			len = VARSIZE_ANY_EXHDR(str);
+		int			off;
 
-	PG_RETURN_TEXT_P(cstring_to_text_with_len(p + off, len - off));
+		if (n < 0)
+			n = -n;
+		else
+			n = pg_mbstrlen_with_len(p, len) - n;
+		off = pg_mbcharcliplen(p, len, n);
+
+		PG_RETURN_TEXT_P(cstring_to_text_with_len(p + off, len - off));
+	}
 }
 
 /*
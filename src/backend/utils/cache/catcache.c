@@ -60,6 +60,13 @@
 #define CACHE_elog(...)
 #endif
 
+/*
+ * GUC: upper bound on the total number of entries across all catcaches, or
+ * -1 for no limit.  When the limit is exceeded we evict cold entries; see
+ * CatCacheCheckBudget.
+ */
+int			syscache_max_entries = -1;
+
 /* Cache management header --- pointer is NULL until created */
 static CatCacheHeader *CacheHdr = NULL;
 
@@ -88,6 +95,7 @@ static void CatCachePrintStats(int code, Datum arg);
 #endif
 static void CatCacheRemoveCTup(CatCache *cache, CatCTup *ct);
 static void CatCacheRemoveCList(CatCache *cache, CatCList *cl);
+static void CatCacheCheckBudget(CatCTup *protect_ct);
 static void CatalogCacheInitializeCache(CatCache *cache);
 static CatCTup *CatalogCacheCreateEntry(CatCache *cache, HeapTuple ntp,
 										Datum *arguments,
@@ -1263,6 +1271,7 @@ SearchCatCacheInternal(CatCache *cache,
 		 * near the front of the hashbucket's list.)
 		 */
 		dlist_move_head(bucket, &ct->cache_elem);
+		ct->recently_used = true;
 
 		/*
 		 * If it's a positive entry, bump its refcount and return it. If it's
@@ -1887,6 +1896,7 @@ CatalogCacheCreateEntry(CatCache *cache, HeapTuple ntp, Datum *arguments,
 	ct->refcount = 0;			/* for the moment */
 	ct->dead = false;
 	ct->negative = negative;
+	ct->recently_used = true;
 	ct->hash_value = hashValue;
 
 	dlist_push_head(&cache->cc_bucket[hashIndex], &ct->cache_elem);
@@ -1894,6 +1904,10 @@ CatalogCacheCreateEntry(CatCache *cache, HeapTuple ntp, Datum *arguments,
 	cache->cc_ntup++;
 	CacheHdr->ch_ntup++;
 
+	/* Evict cold entries if we have a budget and have exceeded it. */
+	if (syscache_max_entries >= 0 && CacheHdr->ch_ntup > syscache_max_entries)
+		CatCacheCheckBudget(ct);
+
 	/*
 	 * If the hash table has become too full, enlarge the buckets array. Quite
 	 * arbitrarily, we enlarge when fill factor > 2.
@@ -1904,6 +1918,80 @@ CatalogCacheCreateEntry(CatCache *cache, HeapTuple ntp, Datum *arguments,
 	return ct;
 }
 
+/*
+ * CatCacheCheckBudget
+ *
+ * Reduce the total number of cache entries to somewhat below
+ * syscache_max_entries by evicting cold entries.  We approximate LRU with a
+ * second-chance scheme: every lookup sets the entry's recently_used flag,
+ * and a sweep evicts entries whose flag is clear while clearing the flag of
+ * the survivors.  Negative entries are evicted preferentially, since they
+ * are the usual cause of unbounded growth (e.g. repeated lookups of dropped
+ * temp tables) and are the cheapest to rebuild if they do turn out to be
+ * needed.
+ *
+ * Entries that are referenced, dead (awaiting unreference), or members of a
+ * CatCList are skipped; so is protect_ct, the entry whose creation triggered
+ * the sweep, which the caller is about to use.  Because of that, and because
+ * everything might be hot, a sweep is not guaranteed to reach the target;
+ * that's fine, we'll try again at the next entry creation.
+ */
+static void
+CatCacheCheckBudget(CatCTup *protect_ct)
+{
+	/* Aim 10% below the limit so we don't sweep on every creation. */
+	int			target = syscache_max_entries - syscache_max_entries / 10;
+	int			pass;
+
+	for (pass = 0; pass < 2 && CacheHdr->ch_ntup > target; pass++)
+	{
+		slist_iter	cache_iter;
+
+		slist_foreach(cache_iter, &CacheHdr->ch_caches)
+		{
+			CatCache   *cache = slist_container(CatCache, cc_next,
+												cache_iter.cur);
+			int			i;
+
+			for (i = 0; i < cache->cc_nbuckets; i++)
+			{
+				dlist_mutable_iter iter;
+
+				dlist_foreach_modify(iter, &cache->cc_bucket[i])
+				{
+					CatCTup    *ct = dlist_container(CatCTup, cache_elem,
+													 iter.cur);
+
+					if (ct == protect_ct || ct->refcount > 0 || ct->dead ||
+						ct->c_list != NULL)
+						continue;
+
+					if (pass == 0)
+					{
+						/* first pass: only cold negative entries */
+						if (!ct->negative || ct->recently_used)
+							continue;
+					}
+					else
+					{
+						/* second pass: any cold entry; survivors go cold */
+						if (ct->recently_used)
+						{
+							ct->recently_used = false;
+							continue;
+						}
+					}
+
+					CatCacheRemoveCTup(cache, ct);
+
+					if (CacheHdr->ch_ntup <= target)
+						return;
+				}
+			}
+		}
+	}
+}
+
 /*
  * Helper routine that frees keys stored in the keys array.
  */
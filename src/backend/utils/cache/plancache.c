@@ -219,6 +219,10 @@ CreateCachedPlan(RawStmt *raw_parse_tree,
 	plansource->generic_cost = -1;
 	plansource->total_custom_cost = 0;
 	plansource->num_custom_plans = 0;
+	plansource->total_generic_exec_time = 0;
+	plansource->num_generic_execs = 0;
+	plansource->total_custom_exec_time = 0;
+	plansource->num_custom_execs = 0;
 
 	MemoryContextSwitchTo(oldcxt);
 
@@ -286,6 +290,10 @@ CreateOneShotCachedPlan(RawStmt *raw_parse_tree,
 	plansource->generic_cost = -1;
 	plansource->total_custom_cost = 0;
 	plansource->num_custom_plans = 0;
+	plansource->total_generic_exec_time = 0;
+	plansource->num_generic_execs = 0;
+	plansource->total_custom_exec_time = 0;
+	plansource->num_custom_execs = 0;
 
 	return plansource;
 }
@@ -1013,6 +1021,19 @@ BuildCachedPlan(CachedPlanSource *plansource, List *qlist,
 	return plan;
 }
 
+/*
+ * If run-time feedback shows the generic plan to be at least this many times
+ * slower than the custom plans were, stop using it no matter how cheap its
+ * estimated cost looks.  The factor is large because the failure mode we're
+ * defending against (a generic plan that's catastrophic for the actual
+ * parameter distribution) is typically orders of magnitude off, and we don't
+ * want ordinary timing noise to defeat the cost-based choice.
+ */
+#define GENERIC_PLAN_SLOWDOWN_FACTOR	10.0
+
+/* Require this many timed executions of each kind before trusting feedback */
+#define PLAN_EXEC_TIME_MIN_SAMPLES		3
+
 /*
  * choose_custom_plan: choose whether to use custom or generic plan
  *
@@ -1063,7 +1084,35 @@ choose_custom_plan(CachedPlanSource *plansource, ParamListInfo boundParams)
 	 * the generic plan cost), we'll always prefer generic at this point.
 	 */
 	if (plansource->generic_cost < avg_custom_cost)
+	{
+		/*
+		 * ... but don't trust the estimate if run-time feedback contradicts
+		 * it.  Estimated costs of generic and custom plans are not really
+		 * comparable when the parameter distribution is skewed: the generic
+		 * plan is costed for hypothetical average parameters, which may bear
+		 * no relation to the values actually supplied.  If callers have
+		 * reported enough observed execution times for both kinds of plan,
+		 * and the generic plan has proven drastically slower in practice,
+		 * go back to custom planning.
+		 */
+		if (plansource->num_generic_execs >= PLAN_EXEC_TIME_MIN_SAMPLES &&
+			plansource->num_custom_execs >= PLAN_EXEC_TIME_MIN_SAMPLES)
+		{
+			double		avg_generic_time;
+			double		avg_custom_time;
+
+			avg_generic_time = plansource->total_generic_exec_time /
+				plansource->num_generic_execs;
+			avg_custom_time = plansource->total_custom_exec_time /
+				plansource->num_custom_execs;
+
+			if (avg_generic_time >
+				avg_custom_time * GENERIC_PLAN_SLOWDOWN_FACTOR)
+				return true;
+		}
+
 		return false;
+	}
 
 	return true;
 }
@@ -1194,6 +1243,13 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
 			/* Update generic_cost whenever we make a new generic plan */
 			plansource->generic_cost = cached_plan_cost(plan, false);
 
+			/*
+			 * Any execution times observed for a previous generic plan don't
+			 * apply to this one; give the new plan a clean slate.
+			 */
+			plansource->total_generic_exec_time = 0;
+			plansource->num_generic_execs = 0;
+
 			/*
 			 * If, based on the now-known value of generic_cost, we'd not have
 			 * chosen to use a generic plan, then forget it and make a custom
@@ -1250,6 +1306,46 @@ GetCachedPlan(CachedPlanSource *plansource, ParamListInfo boundParams,
 	return plan;
 }
 
+/*
+ * CachedPlanReportExecTime: feed back the observed execution time of a plan.
+ *
+ * Callers that run a plan obtained from GetCachedPlan to completion, and
+ * measure how long that took, may report the result here (exec_time is in
+ * milliseconds).  We accumulate times separately for generic and custom
+ * plans, so that choose_custom_plan can abandon a generic plan whose actual
+ * performance belies its estimated cost.  Reporting is entirely optional;
+ * unreported executions just leave the feedback heuristic with less to go on.
+ */
+void
+CachedPlanReportExecTime(CachedPlanSource *plansource, CachedPlan *plan,
+						 double exec_time)
+{
+	Assert(plansource->magic == CACHEDPLANSOURCE_MAGIC);
+	Assert(plan->magic == CACHEDPLAN_MAGIC);
+
+	/* One-shot plans are always custom, so there's no decision to influence */
+	if (plansource->is_oneshot)
+		return;
+
+	if (plan == plansource->gplan)
+	{
+		/* Accumulate, but 'ware overflow, as for total_custom_cost */
+		if (plansource->num_generic_execs < INT_MAX)
+		{
+			plansource->total_generic_exec_time += exec_time;
+			plansource->num_generic_execs++;
+		}
+	}
+	else
+	{
+		if (plansource->num_custom_execs < INT_MAX)
+		{
+			plansource->total_custom_exec_time += exec_time;
+			plansource->num_custom_execs++;
+		}
+	}
+}
+
 /*
  * ReleaseCachedPlan: release active use of a cached plan.
  *
@@ -1283,6 +1379,148 @@ ReleaseCachedPlan(CachedPlan *plan, bool useResOwner)
 	}
 }
 
+/*
+ * CachedPlanAllowsSimpleValidityCheck: can we use CachedPlanIsSimplyValid?
+ *
+ * This function, together with CachedPlanIsSimplyValid, provides a fast path
+ * for callers that wish to repeatedly re-use a cached plan under conditions
+ * where the plan is not expected to change.  The caller must have acquired
+ * the plan with GetCachedPlan; then, if this function returns true, later
+ * uses of the plan can be validated with CachedPlanIsSimplyValid, which is
+ * far cheaper than a full GetCachedPlan call.
+ *
+ * The assumptions we can make are:
+ * 1. The plan cannot need replanning on account of concurrent DDL, except
+ * through the invalidation mechanism clearing plan->is_valid; in particular,
+ * no locks need be taken before use, which requires that the plan touch no
+ * tables at all.
+ * 2. The plan isn't dependent on context that could change, such as the
+ * calling role or the transaction's advertised xmin.
+ *
+ * If owner is not NULL, the plan's refcount is incremented and the reference
+ * recorded with that ResourceOwner, which must then hold the refcount for as
+ * long as CachedPlanIsSimplyValid might be applied to the plan.
+ */
+bool
+CachedPlanAllowsSimpleValidityCheck(CachedPlanSource *plansource,
+									CachedPlan *plan, ResourceOwner owner)
+{
+	ListCell   *lc;
+
+	/* Sanity-check arguments */
+	Assert(plansource->magic == CACHEDPLANSOURCE_MAGIC);
+	Assert(plansource->is_complete);
+	Assert(plan->magic == CACHEDPLAN_MAGIC);
+
+	/*
+	 * Has cache invalidation fired on this plan?  We'd better validate the
+	 * expensive way if so.  (Only a valid saved generic plan is a candidate
+	 * for cheap revalidation.)
+	 */
+	if (!plansource->is_valid ||
+		plan != plansource->gplan ||
+		!plan->is_valid)
+		return false;
+
+	/* We don't support oneshot plans here. */
+	if (plansource->is_oneshot)
+		return false;
+	Assert(!plan->is_oneshot);
+
+	/*
+	 * If the plan is dependent on the calling role, or is only good for the
+	 * current transaction, reject.  These shouldn't arise for the sort of
+	 * trivial queries this is meant for, but check to be safe.
+	 */
+	if (plan->dependsOnRole)
+		return false;
+	if (TransactionIdIsValid(plan->saved_xmin))
+		return false;
+
+	/*
+	 * Reject if AcquireExecutorLocks would have anything to do.  This
+	 * restricts the fast path to plans that reference no relations at all,
+	 * so that there's no question of needing to take locks before relying
+	 * on plan->is_valid.
+	 */
+	foreach(lc, plan->stmt_list)
+	{
+		PlannedStmt *plannedstmt = lfirst_node(PlannedStmt, lc);
+		ListCell   *lc2;
+
+		if (plannedstmt->commandType == CMD_UTILITY)
+			return false;		/* might be a hazard, don't risk it */
+
+		foreach(lc2, plannedstmt->rtable)
+		{
+			RangeTblEntry *rte = (RangeTblEntry *) lfirst(lc2);
+
+			if (rte->rtekind == RTE_RELATION)
+				return false;
+		}
+	}
+
+	/*
+	 * Okay, we'd better bump the refcount to keep the plan from being freed
+	 * underneath later CachedPlanIsSimplyValid calls.
+	 */
+	if (owner)
+	{
+		ResourceOwnerEnlargePlanCacheRefs(owner);
+		plan->refcount++;
+		ResourceOwnerRememberPlanCacheRef(owner, plan);
+	}
+
+	return true;
+}
+
+/*
+ * CachedPlanIsSimplyValid: quick check for plan still being valid
+ *
+ * This function must not be used unless CachedPlanAllowsSimpleValidityCheck
+ * previously said it was OK.
+ *
+ * If the plan is valid, and "owner" is not NULL, record a refcount on the
+ * plan in that ResourceOwner before returning.  It is caller's responsibility
+ * to be sure that a refcount is held on any plan that's being actively used.
+ *
+ * The code here is unconditionally safe as long as the only use of this
+ * CachedPlanSource is in connection with its CachedPlan.
+ */
+bool
+CachedPlanIsSimplyValid(CachedPlanSource *plansource, CachedPlan *plan,
+						ResourceOwner owner)
+{
+	/*
+	 * Careful here: since the caller doesn't necessarily hold a refcount on
+	 * the plan to start with, it's possible that "plan" is a dangling
+	 * pointer.  Don't dereference it until we've verified that it still
+	 * matches the plansource's gplan (which is either valid or NULL).
+	 */
+	Assert(plansource->magic == CACHEDPLANSOURCE_MAGIC);
+
+	/*
+	 * Has cache invalidation fired on this plan?
+	 */
+	if (!plansource->is_valid ||
+		plan == NULL ||
+		plan != plansource->gplan ||
+		!plan->is_valid)
+		return false;
+
+	Assert(plan->magic == CACHEDPLAN_MAGIC);
+
+	/* Bump refcount if requested. */
+	if (owner)
+	{
+		ResourceOwnerEnlargePlanCacheRefs(owner);
+		plan->refcount++;
+		ResourceOwnerRememberPlanCacheRef(owner, plan);
+	}
+
+	return true;
+}
+
 /*
  * CachedPlanSetParentContext: move a CachedPlanSource to a new memory context
  *
@@ -1403,6 +1641,10 @@ CopyCachedPlan(CachedPlanSource *plansource)
 	newsource->generic_cost = plansource->generic_cost;
 	newsource->total_custom_cost = plansource->total_custom_cost;
 	newsource->num_custom_plans = plansource->num_custom_plans;
+	newsource->total_generic_exec_time = plansource->total_generic_exec_time;
+	newsource->num_generic_execs = plansource->num_generic_execs;
+	newsource->total_custom_exec_time = plansource->total_custom_exec_time;
+	newsource->num_custom_execs = plansource->num_custom_execs;
 
 	MemoryContextSwitchTo(oldcxt);
 
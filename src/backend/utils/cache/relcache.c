@@ -3671,6 +3671,22 @@ RelationCacheInitializePhase2(void)
  *		indexes.  Once we've done all this, we have enough infrastructure to
  *		open any system catalog or use any catcache.  The last step is to
  *		rewrite the cache files if needed.
+ *
+ *		XXX It is tempting to extend this warm-start mechanism beyond the
+ *		nailed entries -- say, a shared-memory image of fully built
+ *		RelationData for hot relations, so that startup cost stops scaling
+ *		with how much of a large catalog each new backend touches.  That
+ *		doesn't work with the current entry layout: a built relcache entry is
+ *		riddled with backend-local state (rd_rulescxt/rd_pdcxt memory
+ *		contexts and the parse trees inside them, rd_indexcxt with FmgrInfo
+ *		for index support functions, rd_refcnt, resource-owner bookkeeping,
+ *		smgr pointers), none of which can be shared or mapped read-only.  A
+ *		shareable warm cache would first need a flattened, pointer-free
+ *		representation -- in effect what load_relcache_init_file parses, but
+ *		in shared memory with sinval-driven invalidation -- from which each
+ *		backend still builds its private entry.  That reduces the catalog
+ *		scans but not the per-backend build step, which is where most of the
+ *		cycles go.
  */
 void
 RelationCacheInitializePhase3(void)
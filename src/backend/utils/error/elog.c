@@ -105,6 +105,7 @@ int			Log_error_verbosity = PGERROR_VERBOSE;
 char	   *Log_line_prefix = NULL; /* format for extra log line info */
 int			Log_destination = LOG_DESTINATION_STDERR;
 char	   *Log_destination_string = NULL;
+bool		Log_async = false;
 bool		syslog_sequence_numbers = true;
 bool		syslog_split_messages = true;
 
@@ -3073,6 +3074,17 @@ send_message_to_server_log(ErrorData *edata)
  * the result from write().  However, on some platforms you get a compiler
  * warning from ignoring write()'s result, so do a little dance with casting
  * rc to void to shut up the compiler.
+ *
+ * When log_async is on, we put the pipe into non-blocking mode so that a
+ * syslogger that cannot keep up stalls logging rather than transactions.  A
+ * whole message is dropped (and counted) if its first chunk would block;
+ * once a chunk of a message has been sent we instead retry briefly on
+ * EAGAIN, because abandoning a message midway would garble the syslogger's
+ * chunk reassembly for this PID.  The count of dropped messages is reported
+ * on the next write that finds room in the pipe.  Note that O_NONBLOCK
+ * lives on the shared pipe itself, so once any process sets it, writers
+ * that have not yet seen the new GUC value behave as if it were already set
+ * for them; that is harmless since they follow the same protocol.
  */
 static void
 write_pipe_chunks(char *data, int len, int dest)
@@ -3080,9 +3092,39 @@ write_pipe_chunks(char *data, int len, int dest)
 	PipeProtoChunk p;
 	int			fd = fileno(stderr);
 	int			rc;
+	bool		started = false;
+	static bool pipe_nonblocking = false;
+	static uint64 async_dropped_count = 0;
 
 	Assert(len > 0);
 
+	/* Adopt the blocking mode implied by log_async, if we haven't yet */
+	if (Log_async != pipe_nonblocking)
+	{
+		if (Log_async ? pg_set_noblock(fd) : pg_set_block(fd))
+			pipe_nonblocking = Log_async;
+	}
+
+	/* If we dropped messages earlier, try to report that first */
+	if (pipe_nonblocking && async_dropped_count > 0)
+	{
+		/*
+		 * This line bypasses the normal formatting path, so it carries no
+		 * log_line_prefix; we cannot build one here without risking
+		 * recursion.
+		 */
+		p.proto.nuls[0] = p.proto.nuls[1] = '\0';
+		p.proto.pid = MyProcPid;
+		p.proto.is_last = 't';
+		p.proto.len = snprintf(p.proto.data, PIPE_MAX_PAYLOAD,
+							   "LOG:  discarded " UINT64_FORMAT " log messages because the syslogger pipe was full\n",
+							   async_dropped_count);
+		rc = write(fd, &p, PIPE_HEADER_SIZE + p.proto.len);
+		if (rc < 0)
+			return;				/* still no room; keep counting */
+		async_dropped_count = 0;
+	}
+
 	p.proto.nuls[0] = p.proto.nuls[1] = '\0';
 	p.proto.pid = MyProcPid;
 
@@ -3093,7 +3135,25 @@ write_pipe_chunks(char *data, int len, int dest)
 		p.proto.len = PIPE_MAX_PAYLOAD;
 		memcpy(p.proto.data, data, PIPE_MAX_PAYLOAD);
 		rc = write(fd, &p, PIPE_HEADER_SIZE + PIPE_MAX_PAYLOAD);
+		if (rc < 0 && pipe_nonblocking &&
+			(errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			if (!started)
+			{
+				/* Nothing sent yet; drop the whole message */
+				async_dropped_count++;
+				return;
+			}
+
+			/*
+			 * Mid-message; wait for the syslogger to drain some data rather
+			 * than corrupt the chunk stream.
+			 */
+			pg_usleep(1000L);
+			continue;
+		}
 		(void) rc;
+		started = true;
 		data += PIPE_MAX_PAYLOAD;
 		len -= PIPE_MAX_PAYLOAD;
 	}
@@ -3102,8 +3162,23 @@ write_pipe_chunks(char *data, int len, int dest)
 	p.proto.is_last = (dest == LOG_DESTINATION_CSVLOG ? 'T' : 't');
 	p.proto.len = len;
 	memcpy(p.proto.data, data, len);
-	rc = write(fd, &p, PIPE_HEADER_SIZE + len);
-	(void) rc;
+	for (;;)
+	{
+		rc = write(fd, &p, PIPE_HEADER_SIZE + len);
+		if (rc < 0 && pipe_nonblocking &&
+			(errno == EAGAIN || errno == EWOULDBLOCK))
+		{
+			if (!started)
+			{
+				async_dropped_count++;
+				return;
+			}
+			pg_usleep(1000L);
+			continue;
+		}
+		(void) rc;
+		break;
+	}
 }
 
 
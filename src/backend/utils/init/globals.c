@@ -139,6 +139,8 @@ int			VacuumCostPageMiss = 10;
 int			VacuumCostPageDirty = 20;
 int			VacuumCostLimit = 200;
 double		VacuumCostDelay = 0;
+int			VacuumIOReadLimit = 0;	/* in MB/s; 0 disables */
+int			VacuumIOWriteLimit = 0; /* in MB/s; 0 disables */
 
 int			VacuumPageHit = 0;
 int			VacuumPageMiss = 0;
@@ -26,12 +26,14 @@
 #include <syslog.h>
 #endif
 
+#include "access/clog.h"
 #include "access/commit_ts.h"
 #include "access/gin.h"
 #include "access/rmgr.h"
 #include "access/tableam.h"
 #include "access/transam.h"
 #include "access/twophase.h"
+#include "access/undolog.h"
 #include "access/undorequest.h"
 #include "access/undoworker.h"
 #include "access/xact.h"
@@ -40,11 +42,13 @@
 #include "catalog/pg_authid.h"
 #include "commands/async.h"
 #include "commands/prepare.h"
+#include "commands/sequence.h"
 #include "commands/user.h"
 #include "commands/vacuum.h"
 #include "commands/variable.h"
 #include "commands/trigger.h"
 #include "common/string.h"
+#include "executor/instrument.h"
 #include "funcapi.h"
 #include "jit/jit.h"
 #include "libpq/auth.h"
@@ -55,6 +59,7 @@
 #include "optimizer/geqo.h"
 #include "optimizer/optimizer.h"
 #include "optimizer/paths.h"
+#include "optimizer/planfeedback.h"
 #include "optimizer/planmain.h"
 #include "parser/parse_expr.h"
 #include "parser/parse_type.h"
@@ -64,10 +69,13 @@
 #include "postmaster/autovacuum.h"
 #include "postmaster/bgworker_internals.h"
 #include "postmaster/bgwriter.h"
+#include "postmaster/pgarch.h"
 #include "postmaster/postmaster.h"
 #include "postmaster/syslogger.h"
 #include "postmaster/walwriter.h"
+#include "regex/regex.h"
 #include "replication/logicallauncher.h"
+#include "replication/reorderbuffer.h"
 #include "replication/slot.h"
 #include "replication/syncrep.h"
 #include "replication/walreceiver.h"
@@ -77,6 +85,7 @@
 #include "storage/standby.h"
 #include "storage/fd.h"
 #include "storage/large_object.h"
+#include "storage/md.h"
 #include "storage/pg_shmem.h"
 #include "storage/proc.h"
 #include "storage/predicate.h"
@@ -84,6 +93,7 @@
 #include "tsearch/ts_cache.h"
 #include "utils/builtins.h"
 #include "utils/bytea.h"
+#include "utils/catcache.h"
 #include "utils/guc_tables.h"
 #include "utils/float.h"
 #include "utils/memutils.h"
@@ -121,6 +131,7 @@
 extern bool Log_disconnections;
 extern int	CommitDelay;
 extern int	CommitSiblings;
+extern int	WalGroupCommitWindow;
 extern char *default_tablespace;
 extern char *temp_tablespaces;
 extern char *undo_tablespaces;
@@ -384,6 +395,37 @@ static const struct config_enum_entry constraint_exclusion_options[] = {
  * Although only "on", "off", "remote_apply", "remote_write", and "local" are
  * documented, we accept all the likely variants of "on" and "off".
  */
+/*
+ * Although only "on", "off", "pglz", "lz4" and "zstd" are documented, we
+ * accept all the likely variants of "on" and "off".
+ */
+static const struct config_enum_entry wal_compression_options[] = {
+	{"pglz", WAL_COMPRESSION_PGLZ, false},
+#ifdef USE_LZ4
+	{"lz4", WAL_COMPRESSION_LZ4, false},
+#endif
+#ifdef USE_ZSTD
+	{"zstd", WAL_COMPRESSION_ZSTD, false},
+#endif
+	{"on", WAL_COMPRESSION_PGLZ, false},
+	{"off", WAL_COMPRESSION_NONE, false},
+	{"true", WAL_COMPRESSION_PGLZ, true},
+	{"false", WAL_COMPRESSION_NONE, true},
+	{"yes", WAL_COMPRESSION_PGLZ, true},
+	{"no", WAL_COMPRESSION_NONE, true},
+	{"1", WAL_COMPRESSION_PGLZ, true},
+	{"0", WAL_COMPRESSION_NONE, true},
+	{NULL, 0, false}
+};
+
+static const struct config_enum_entry recovery_init_sync_method_options[] = {
+	{"fsync", RECOVERY_INIT_SYNC_METHOD_FSYNC, false},
+#ifdef HAVE_SYNCFS
+	{"syncfs", RECOVERY_INIT_SYNC_METHOD_SYNCFS, false},
+#endif
+	{NULL, 0, false}
+};
+
 static const struct config_enum_entry synchronous_commit_options[] = {
 	{"local", SYNCHRONOUS_COMMIT_LOCAL_FLUSH, false},
 	{"remote_write", SYNCHRONOUS_COMMIT_REMOTE_WRITE, false},
@@ -573,7 +615,6 @@ static int	max_function_args;
 static int	max_index_keys;
 static int	max_identifier_length;
 static int	block_size;
-static int	segment_size;
 static int	wal_block_size;
 static bool data_checksums;
 static bool integer_datetimes;
@@ -943,6 +984,16 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"enable_incrementalsort", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables the planner's use of incremental sort steps."),
+			NULL,
+			GUC_EXPLAIN
+		},
+		&enable_incrementalsort,
+		true,
+		NULL, NULL, NULL
+	},
 	{
 		{"enable_hashagg", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("Enables the planner's use of hashed aggregation plans."),
@@ -1066,6 +1117,17 @@ static struct config_bool ConfigureNamesBool[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"plan_cache_feedback", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Feeds executed plans' actual row counts back into planning."),
+			gettext_noop("Scan-level corrections are remembered per backend and applied "
+						 "when the same quals are planned again."),
+			GUC_EXPLAIN
+		},
+		&plan_cache_feedback,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		/* Not for general use --- used by SET SESSION AUTHORIZATION */
 		{"is_superuser", PGC_INTERNAL, UNGROUPED,
@@ -1149,6 +1211,24 @@ static struct config_bool ConfigureNamesBool[] =
 		false,
 		NULL, NULL, NULL
 	},
+	{
+		{"trust_strxfrm", PGC_SUSET, DEVELOPER_OPTIONS,
+			gettext_noop("Allows abbreviated keys for sorts using libc collations."),
+			gettext_noop("The abbreviated-key sort optimization relies on strxfrm() producing "
+						 "results that are consistent with strcoll(), which is known to be "
+						 "broken for some locales on some platforms. Enable this only after "
+						 "verifying that the two agree for the locales in use. ICU collations "
+						 "do not depend on this setting."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&trust_strxfrm,
+#ifdef TRUST_STRXFRM
+		true,
+#else
+		false,
+#endif
+		NULL, NULL, NULL
+	},
 	{
 		{"zero_damaged_pages", PGC_SUSET, DEVELOPER_OPTIONS,
 			gettext_noop("Continues processing past damaged page headers."),
@@ -1187,16 +1267,6 @@ static struct config_bool ConfigureNamesBool[] =
 		NULL, NULL, NULL
 	},
 
-	{
-		{"wal_compression", PGC_SUSET, WAL_SETTINGS,
-			gettext_noop("Compresses full-page writes written in WAL file."),
-			NULL
-		},
-		&wal_compression,
-		false,
-		NULL, NULL, NULL
-	},
-
 	{
 		{"wal_init_zero", PGC_SUSET, WAL_SETTINGS,
 			gettext_noop("Writes zeroes to new WAL files before first use."),
@@ -1625,6 +1695,17 @@ static struct config_bool ConfigureNamesBool[] =
 		false,
 		NULL, NULL, NULL
 	},
+	{
+		{"log_async", PGC_SIGHUP, LOGGING_WHERE,
+			gettext_noop("Drop log messages rather than block when the syslogger cannot keep up."),
+			gettext_noop("This only has an effect when messages are sent to the "
+						 "logging collector; the number of dropped messages is "
+						 "reported when the log pipe has room again.")
+		},
+		&Log_async,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"log_truncate_on_rotation", PGC_SIGHUP, LOGGING_WHERE,
 			gettext_noop("Truncate existing log files of same name during log rotation."),
@@ -1955,6 +2036,16 @@ static struct config_bool ConfigureNamesBool[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"undo_compress_segments", PGC_SIGHUP, UNDO_OPTIONS,
+			gettext_noop("Compress closed undo segment files in the background."),
+			gettext_noop("Segments are uncompressed transparently when accessed again.")
+		},
+		&undo_compress_segments,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"undo_force_foreground", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Force UNDO execution to happen in foreground."),
@@ -2042,6 +2133,17 @@ static struct config_int ConfigureNamesInt[] =
 		12, 2, INT_MAX,
 		NULL, NULL, NULL
 	},
+	{
+		{"join_search_budget", PGC_USERSET, QUERY_TUNING_GEQO,
+			gettext_noop("Sets the number of join relations kept per level by budgeted join search."),
+			gettext_noop("When greater than zero, queries with at least geqo_threshold FROM "
+						 "items are planned with a deterministic pruned search instead of GEQO."),
+			GUC_EXPLAIN
+		},
+		&join_search_budget,
+		0, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
 	{
 		{"geqo_effort", PGC_USERSET, QUERY_TUNING_GEQO,
 			gettext_noop("GEQO: effort is used to set the default for other GEQO parameters."),
@@ -2140,6 +2242,17 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"wal_receiver_write_size", PGC_SIGHUP, REPLICATION_STANDBY,
+			gettext_noop("Size of the buffer the WAL receiver uses to coalesce writes."),
+			gettext_noop("Zero disables the buffering. Takes effect when a WAL receiver starts."),
+			GUC_UNIT_KB
+		},
+		&wal_receiver_write_size,
+		1024, 0, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"max_connections", PGC_POSTMASTER, CONN_AUTH_SETTINGS,
 			gettext_noop("Sets the maximum number of concurrent connections."),
@@ -2176,6 +2289,16 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"clog_buffers", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Sets the number of shared memory buffers used for the transaction status log."),
+			gettext_noop("0 selects a size based on shared_buffers.")
+		},
+		&clog_buffers,
+		0, 0, 16384,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"temp_buffers", PGC_USERSET, RESOURCES_MEM,
 			gettext_noop("Sets the maximum number of temporary buffers used by each session."),
@@ -2187,6 +2310,18 @@ static struct config_int ConfigureNamesInt[] =
 		check_temp_buffers, NULL, NULL
 	},
 
+	{
+		{"bulk_read_ring_size", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the size of the buffer ring used for bulk reads."),
+			gettext_noop("A larger ring lets a large sequential scan keep more "
+						 "of its own pages in shared buffers."),
+			GUC_UNIT_KB
+		},
+		&bulk_read_ring_size,
+		256, 128, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"port", PGC_POSTMASTER, CONN_AUTH_SETTINGS,
 			gettext_noop("Sets the TCP port the server listens on."),
@@ -2265,6 +2400,40 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"logical_decoding_work_mem", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the maximum memory to be used for logical decoding."),
+			gettext_noop("This much memory can be used by each internal "
+						 "reorder buffer before spilling to disk."),
+			GUC_UNIT_KB
+		},
+		&logical_decoding_work_mem,
+		65536, 64, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"after_trigger_spill_threshold", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the maximum memory to be used for a query's AFTER trigger event queue."),
+			gettext_noop("Event chunks beyond this amount are spilled to "
+						 "disk and replayed in order; -1 disables spilling."),
+			GUC_UNIT_KB
+		},
+		&after_trigger_spill_threshold,
+		-1, -1, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"syscache_max_entries", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the maximum number of system catalog cache entries per backend."),
+			gettext_noop("-1 means no limit.")
+		},
+		&syscache_max_entries,
+		-1, -1, INT_MAX,
+		NULL, NULL, NULL
+	},
+
 	/*
 	 * We use the hopefully-safely-small value of 100kB as the compiled-in
 	 * default for max_stack_depth.  InitializeGUCOptions will increase it if
@@ -2281,6 +2450,27 @@ static struct config_int ConfigureNamesInt[] =
 		check_max_stack_depth, assign_max_stack_depth, NULL
 	},
 
+	{
+		{"regex_cache_size", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the maximum number of compiled regular expressions cached per backend."),
+			NULL
+		},
+		&regex_cache_size,
+		32, 1, 4096,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"min_dynamic_shared_memory", PGC_POSTMASTER, RESOURCES_MEM,
+			gettext_noop("Amount of dynamic shared memory reserved at startup."),
+			NULL,
+			GUC_UNIT_MB
+		},
+		&min_dynamic_shared_memory,
+		0, 0, (int) Min((size_t) INT_MAX, SIZE_MAX / (1024 * 1024)),
+		NULL, NULL, NULL
+	},
+
 	{
 		{"temp_file_limit", PGC_SUSET, RESOURCES_DISK,
 			gettext_noop("Limits the total size of all temporary files used by each process."),
@@ -2332,6 +2522,28 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"vacuum_io_read_limit", PGC_USERSET, RESOURCES_VACUUM_DELAY,
+			gettext_noop("Vacuum read I/O budget, in megabytes per second."),
+			gettext_noop("Zero disables read throttling.  For autovacuum this is "
+						 "a cluster-wide budget, split among the active workers.")
+		},
+		&VacuumIOReadLimit,
+		0, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"vacuum_io_write_limit", PGC_USERSET, RESOURCES_VACUUM_DELAY,
+			gettext_noop("Vacuum write I/O budget, in megabytes per second."),
+			gettext_noop("Zero disables write throttling.  For autovacuum this is "
+						 "a cluster-wide budget, split among the active workers.")
+		},
+		&VacuumIOWriteLimit,
+		0, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"autovacuum_vacuum_cost_limit", PGC_SIGHUP, AUTOVACUUM,
 			gettext_noop("Vacuum cost amount available before napping, for autovacuum."),
@@ -2352,6 +2564,17 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"max_cached_files", PGC_USERSET, RESOURCES_KERNEL,
+			gettext_noop("Soft budget of kernel file descriptors each server process keeps cached."),
+			gettext_noop("Surplus descriptors are closed coldest-first at transaction end. "
+						 "-1 imposes no limit short of the max_files_per_process-derived cap.")
+		},
+		&max_cached_files,
+		-1, -1, INT_MAX,
+		NULL, NULL, NULL
+	},
+
 	/*
 	 * See also CheckRequiredParameterValues() if this parameter changes
 	 */
@@ -2421,6 +2644,17 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"sequence_cache", PGC_USERSET, CLIENT_CONN_STATEMENT,
+			gettext_noop("Minimum number of sequence values to cache per backend."),
+			gettext_noop("The larger of this setting and the sequence's own CACHE "
+						 "option is used.")
+		},
+		&sequence_cache,
+		1, 1, INT_MAX,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"vacuum_freeze_min_age", PGC_USERSET, CLIENT_CONN_STATEMENT,
 			gettext_noop("Minimum age at which VACUUM should freeze a table row."),
@@ -2431,6 +2665,16 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"vacuum_freeze_eager_pages", PGC_USERSET, CLIENT_CONN_STATEMENT,
+			gettext_noop("Number of extra all-visible pages VACUUM will scan to freeze them."),
+			gettext_noop("A value of 0 disables eager freezing.")
+		},
+		&vacuum_freeze_eager_pages,
+		0, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"vacuum_freeze_table_age", PGC_USERSET, CLIENT_CONN_STATEMENT,
 			gettext_noop("Age at which VACUUM should scan whole table to freeze tuples."),
@@ -2624,6 +2868,27 @@ static struct config_int ConfigureNamesInt[] =
 		check_wal_buffers, NULL, NULL
 	},
 
+	{
+		{"wal_prealloc_segments", PGC_SIGHUP, WAL_SETTINGS,
+			gettext_noop("Sets the number of ready WAL segments maintained ahead of the insert position."),
+			gettext_noop("Values above one make the WAL writer and checkpointer keep a pool of "
+						 "pre-created segments so that backends never create one themselves.")
+		},
+		&wal_prealloc_segments,
+		1, 1, 1024,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"wal_insertion_locks", PGC_POSTMASTER, WAL_SETTINGS,
+			gettext_noop("Sets the number of WAL insertion locks."),
+			gettext_noop("More locks allow more concurrent WAL inserts on machines with many cores.")
+		},
+		&num_xloginsert_locks,
+		8, 1, 256,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"wal_writer_delay", PGC_SIGHUP, WAL_SETTINGS,
 			gettext_noop("Time between WAL flushes performed in the WAL writer."),
@@ -2690,6 +2955,18 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"wal_group_commit_window", PGC_SUSET, WAL_SETTINGS,
+			gettext_noop("Sets the minimum time in microseconds between WAL flushes."),
+			gettext_noop("Commits arriving within the window are flushed together "
+						 "with a single sync operation.")
+			/* we have no microseconds designation, so can't supply units here */
+		},
+		&WalGroupCommitWindow,
+		0, 0, 100000,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"commit_siblings", PGC_USERSET, WAL_SETTINGS,
 			gettext_noop("Sets the minimum concurrent open transactions before performing "
@@ -2907,8 +3184,8 @@ static struct config_int ConfigureNamesInt[] =
 			NULL,
 			GUC_UNIT_BLOCKS | GUC_NOT_IN_SAMPLE | GUC_DISALLOW_IN_FILE
 		},
-		&segment_size,
-		RELSEG_SIZE, RELSEG_SIZE, RELSEG_SIZE,
+		&rel_segment_size,
+		RELSEG_SIZE, 1, INT_MAX,
 		NULL, NULL, NULL
 	},
 
@@ -3175,6 +3452,18 @@ static struct config_int ConfigureNamesInt[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"instrument_sample_interval", PGC_USERSET, STATS_MONITORING,
+			gettext_noop("Sets the interval between timed plan node cycles "
+						 "when sampled timing is in use."),
+			gettext_noop("With sampled timing, one plan node cycle in this "
+						 "many is timed and the result extrapolated.")
+		},
+		&instrument_sample_interval,
+		64, 1, INT_MAX,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"track_activity_query_size", PGC_POSTMASTER, RESOURCES_MEM,
 			gettext_noop("Sets the size reserved for pg_stat_activity.query, in bytes."),
@@ -3228,6 +3517,24 @@ static struct config_int ConfigureNamesInt[] =
 		3, 1, MAX_UNDO_WORKER_LIMIT,
 		NULL, NULL, NULL
 	},
+	{
+		{"undo_prealloc_segments", PGC_SIGHUP, UNDO_OPTIONS,
+			gettext_noop("Number of spare undo segments to preallocate per tablespace."),
+			gettext_noop("A value of 0 disables undo segment preallocation.")
+		},
+		&undo_prealloc_segments,
+		2, 0, 64,
+		NULL, NULL, NULL
+	},
+	{
+		{"undo_freelist_stripes", PGC_POSTMASTER, UNDO_OPTIONS,
+			gettext_noop("Number of shared undo log free-list stripes per persistence level."),
+			gettext_noop("A value of 0 selects a number based on max_connections.")
+		},
+		&undo_freelist_stripes,
+		0, 0, 32,
+		NULL, NULL, NULL
+	},
 
 	/* End-of-list marker */
 	{
@@ -3496,6 +3803,16 @@ static struct config_string ConfigureNamesString[] =
 		NULL, NULL, show_archive_command
 	},
 
+	{
+		{"archive_library", PGC_SIGHUP, WAL_ARCHIVING,
+			gettext_noop("Sets the library that will be called to archive a WAL file."),
+			gettext_noop("An empty string indicates that archive_command should be used.")
+		},
+		&XLogArchiveLibrary,
+		"",
+		NULL, NULL, NULL
+	},
+
 	{
 		{"restore_command", PGC_POSTMASTER, WAL_ARCHIVE_RECOVERY,
 			gettext_noop("Sets the shell command that will retrieve an archived WAL file."),
@@ -4386,6 +4703,15 @@ static struct config_enum ConfigureNamesEnum[] =
 		NULL, assign_syslog_facility, NULL
 	},
 
+	{
+		{"recovery_init_sync_method", PGC_SIGHUP, ERROR_HANDLING_OPTIONS,
+			gettext_noop("Sets the method for synchronizing the data directory before crash recovery."),
+		},
+		&recovery_init_sync_method,
+		RECOVERY_INIT_SYNC_METHOD_FSYNC, recovery_init_sync_method_options,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"session_replication_role", PGC_SUSET, CLIENT_CONN_STATEMENT,
 			gettext_noop("Sets the session's behavior for triggers and rewrite rules."),
@@ -4452,6 +4778,16 @@ static struct config_enum ConfigureNamesEnum[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"wal_compression", PGC_SUSET, WAL_SETTINGS,
+			gettext_noop("Compresses full-page writes written in WAL file with specified method."),
+			NULL
+		},
+		&wal_compression,
+		WAL_COMPRESSION_NONE, wal_compression_options,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"wal_level", PGC_POSTMASTER, WAL_SETTINGS,
 			gettext_noop("Set the level of information written to the WAL."),
@@ -4622,6 +4958,19 @@ static int	size_guc_variables;
 
 static bool guc_dirty;			/* true if need to do commit/abort work */
 
+/*
+ * Variables that (may) have active stack entries, maintained so that
+ * AtEOXact_GUC need only visit these instead of scanning the whole
+ * guc_variables array.  push_old_value adds a variable here when pushing its
+ * first stack entry, and AtEOXact_GUC drops it once its stack is empty
+ * again.  The list can transiently contain duplicates, or variables whose
+ * stack has been emptied behind our back (see reapply_stacked_values); both
+ * cases are handled harmlessly by AtEOXact_GUC.
+ */
+static struct config_generic **guc_stacked_vars = NULL;
+static int	num_stacked_vars = 0;
+static int	size_stacked_vars = 0;
+
 static bool reporting_enabled;	/* true to enable GUC_REPORT */
 
 static int	GUCNestLevel = 0;	/* 1 when in main transaction */
@@ -4632,6 +4981,8 @@ static int	guc_name_compare(const char *namea, const char *nameb);
 static void InitializeGUCOptionsFromEnvironment(void);
 static void InitializeOneGUCOption(struct config_generic *gconf);
 static void push_old_value(struct config_generic *gconf, GucAction action);
+static void remember_stacked_variable(struct config_generic *gconf);
+static void forget_stacked_variable(struct config_generic *gconf);
 static void ReportGUCOption(struct config_generic *record);
 static void reapply_stacked_values(struct config_generic *variable,
 								   struct config_string *pHolder,
@@ -5652,6 +6003,43 @@ ResetAllOptions(void)
 }
 
 
+/*
+ * Enter a variable into guc_stacked_vars, so that AtEOXact_GUC will visit
+ * it.  Duplicate entries are harmless, so we don't bother to check.
+ */
+static void
+remember_stacked_variable(struct config_generic *gconf)
+{
+	if (num_stacked_vars >= size_stacked_vars)
+	{
+		size_stacked_vars = size_stacked_vars ? size_stacked_vars * 2 : 32;
+		guc_stacked_vars = (struct config_generic **)
+			guc_realloc(ERROR, guc_stacked_vars,
+						size_stacked_vars * sizeof(struct config_generic *));
+	}
+	guc_stacked_vars[num_stacked_vars++] = gconf;
+}
+
+/*
+ * Remove any guc_stacked_vars entries for a variable that is about to go
+ * away (currently, that's only a custom-variable placeholder being replaced
+ * by the real variable).  AtEOXact_GUC must not see a pointer to freed
+ * memory.
+ */
+static void
+forget_stacked_variable(struct config_generic *gconf)
+{
+	int			i = 0;
+
+	while (i < num_stacked_vars)
+	{
+		if (guc_stacked_vars[i] == gconf)
+			guc_stacked_vars[i] = guc_stacked_vars[--num_stacked_vars];
+		else
+			i++;
+	}
+}
+
 /*
  * push_old_value
  *		Push previous state during transactional assignment to a GUC variable.
@@ -5727,6 +6115,10 @@ push_old_value(struct config_generic *gconf, GucAction action)
 	stack->scontext = gconf->scontext;
 	set_stack_value(gconf, &stack->prior);
 
+	/* If this is the variable's first stack entry, remember the variable */
+	if (gconf->stack == NULL)
+		remember_stacked_variable(gconf);
+
 	gconf->stack = stack;
 
 	/* Ensure we remember to pop at end of xact */
@@ -5774,7 +6166,6 @@ NewGUCNestLevel(void)
 void
 AtEOXact_GUC(bool isCommit, int nestLevel)
 {
-	bool		still_dirty;
 	int			i;
 
 	/*
@@ -5793,10 +6184,10 @@ AtEOXact_GUC(bool isCommit, int nestLevel)
 		return;
 	}
 
-	still_dirty = false;
-	for (i = 0; i < num_guc_variables; i++)
+	i = 0;
+	while (i < num_stacked_vars)
 	{
-		struct config_generic *gconf = guc_variables[i];
+		struct config_generic *gconf = guc_stacked_vars[i];
 		GucStack   *stack;
 
 		/*
@@ -6037,12 +6428,17 @@ AtEOXact_GUC(bool isCommit, int nestLevel)
 				ReportGUCOption(gconf);
 		}						/* end of stack-popping loop */
 
-		if (stack != NULL)
-			still_dirty = true;
+		if (gconf->stack == NULL)
+		{
+			/* stack is empty, drop the variable (order doesn't matter) */
+			guc_stacked_vars[i] = guc_stacked_vars[--num_stacked_vars];
+		}
+		else
+			i++;
 	}
 
 	/* If there are no remaining stack entries, we can reset guc_dirty */
-	guc_dirty = still_dirty;
+	guc_dirty = (num_stacked_vars > 0);
 
 	/* Update nesting level */
 	GUCNestLevel = nestLevel - 1;
@@ -8524,6 +8920,17 @@ define_custom_variable(struct config_generic *variable)
 	set_string_field(pHolder, pHolder->variable, NULL);
 	set_string_field(pHolder, &pHolder->reset_val, NULL);
 
+	/*
+	 * If the placeholder ever had stack entries, it is in guc_stacked_vars;
+	 * drop it from there before freeing it.  The real variable should have
+	 * been entered there by push_old_value while its stack was being rebuilt
+	 * above, but that depends on the nest level, so enter it explicitly if it
+	 * now has a stack (a duplicate entry is harmless).
+	 */
+	forget_stacked_variable(&pHolder->gen);
+	if (variable->stack != NULL)
+		remember_stacked_variable(variable);
+
 	free(pHolder);
 }
 
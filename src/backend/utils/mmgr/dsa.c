@@ -250,6 +250,19 @@ static const uint16 dsa_size_classes[] = {
 #define DSA_SCLASS_BLOCK_OF_SPANS		0
 #define DSA_SCLASS_SPAN_LARGE			1
 
+/*
+ * Parameters of the backend-local object cache.  For each size class, a
+ * backend keeps up to DSA_CACHE_OBJECTS objects that are allocated as far as
+ * the shared state is concerned but locally free, so that most
+ * allocate/free cycles need not touch the per-pool LWLock at all.  When the
+ * cache is empty, it is refilled with DSA_CACHE_BATCH objects obtained under
+ * a single lock acquisition.  The cache is bounded at a few objects per size
+ * class so that an idle backend can sit on at most a few tens of kilobytes
+ * per attached area.
+ */
+#define DSA_CACHE_OBJECTS				8
+#define DSA_CACHE_BATCH					4
+
 /*
  * The following lookup table is used to map the size of small objects
  * (less than 1kB) onto the corresponding size class.  To use this table,
@@ -372,6 +385,15 @@ struct dsa_area
 
 	/* The last observed freed_segment_counter. */
 	size_t		freed_segment_counter;
+
+	/* Is the object cache in use?  (Disabled while it is being flushed.) */
+	bool		cache_enabled;
+
+	/* Number of cached objects for each size class. */
+	int			ncached_objects[DSA_NUM_SIZE_CLASSES];
+
+	/* Cached objects: allocated in the shared state, but locally free. */
+	dsa_pointer cached_objects[DSA_NUM_SIZE_CLASSES][DSA_CACHE_OBJECTS];
 };
 
 #define DSA_SPAN_NOTHING_FREE	((uint16) -1)
@@ -387,6 +409,10 @@ static void init_span(dsa_area *area, dsa_pointer span_pointer,
 static bool transfer_first_span(dsa_area *area, dsa_area_pool *pool,
 								int fromclass, int toclass);
 static inline dsa_pointer alloc_object(dsa_area *area, int size_class);
+static int	alloc_object_batch(dsa_area *area, int size_class,
+							   dsa_pointer *objects, int nobjects);
+static dsa_pointer alloc_object_cached(dsa_area *area, int size_class);
+static void flush_object_cache(dsa_area *area);
 static bool ensure_active_superblock(dsa_area *area, dsa_area_pool *pool,
 									 int size_class);
 static dsa_segment_map *get_segment_by_index(dsa_area *area,
@@ -691,7 +717,7 @@ dsa_allocate_extended(dsa_area *area, size_t size, int flags)
 		dsa_area_pool *pool = &area->control->pools[DSA_SCLASS_SPAN_LARGE];
 
 		/* Obtain a span object. */
-		span_pointer = alloc_object(area, DSA_SCLASS_BLOCK_OF_SPANS);
+		span_pointer = alloc_object_cached(area, DSA_SCLASS_BLOCK_OF_SPANS);
 		if (!DsaPointerIsValid(span_pointer))
 		{
 			/* Raise error unless asked not to. */
@@ -792,7 +818,7 @@ dsa_allocate_extended(dsa_area *area, size_t size, int flags)
 	Assert(size_class == 0 || size > dsa_size_classes[size_class - 1]);
 
 	/* Attempt to allocate an object from the appropriate pool. */
-	result = alloc_object(area, size_class);
+	result = alloc_object_cached(area, size_class);
 
 	/* Check for failure to allocate. */
 	if (!DsaPointerIsValid(result))
@@ -872,6 +898,19 @@ dsa_free(dsa_area *area, dsa_pointer dp)
 	memset(object, 0x7f, size);
 #endif
 
+	/*
+	 * Stash the object in the backend-local cache if there's room, avoiding
+	 * any lock traffic.  It remains allocated as far as the shared state is
+	 * concerned, so its span cannot be destroyed under us, and any process
+	 * may later free an object we hand back out of the cache.
+	 */
+	if (area->cache_enabled &&
+		area->ncached_objects[size_class] < DSA_CACHE_OBJECTS)
+	{
+		area->cached_objects[size_class][area->ncached_objects[size_class]++] = dp;
+		return;
+	}
+
 	LWLockAcquire(DSA_SCLASS_LOCK(area, size_class), LW_EXCLUSIVE);
 
 	/* Put the object on the span's freelist. */
@@ -1021,6 +1060,9 @@ dsa_trim(dsa_area *area)
 {
 	int			size_class;
 
+	/* Give back cached objects, so their superblocks can become empty. */
+	flush_object_cache(area);
+
 	/*
 	 * Trim in reverse pool order so we get to the spans-of-spans last, just
 	 * in case any become entirely free while processing all the other pools.
@@ -1254,6 +1296,8 @@ create_internal(void *place, size_t size,
 	memset(area->segment_maps, 0, sizeof(dsa_segment_map) * DSA_MAX_SEGMENTS);
 	area->high_segment_index = 0;
 	area->freed_segment_counter = 0;
+	area->cache_enabled = true;
+	memset(area->ncached_objects, 0, sizeof(area->ncached_objects));
 	LWLockInitialize(&control->lock, control->lwlock_tranche_id);
 	for (i = 0; i < DSA_NUM_SIZE_CLASSES; ++i)
 		LWLockInitialize(DSA_SCLASS_LOCK(area, i),
@@ -1333,6 +1377,8 @@ attach_internal(void *place, dsm_segment *segment, dsa_handle handle)
 	}
 	++control->refcnt;
 	area->freed_segment_counter = area->control->freed_segment_counter;
+	area->cache_enabled = true;
+	memset(area->ncached_objects, 0, sizeof(area->ncached_objects));
 	LWLockRelease(DSA_AREA_LOCK(area));
 
 	return area;
@@ -1438,6 +1484,24 @@ transfer_first_span(dsa_area *area,
  */
 static inline dsa_pointer
 alloc_object(dsa_area *area, int size_class)
+{
+	dsa_pointer result;
+
+	if (alloc_object_batch(area, size_class, &result, 1) == 0)
+		result = InvalidDsaPointer;
+
+	return result;
+}
+
+/*
+ * Allocate up to 'nobjects' objects of the requested size class from the
+ * given area, under a single acquisition of the pool's lock.  Returns the
+ * number of objects actually obtained, which is less than requested only if
+ * no more superblocks can be had.
+ */
+static int
+alloc_object_batch(dsa_area *area, int size_class, dsa_pointer *objects,
+				   int nobjects)
 {
 	dsa_area_pool *pool = &area->control->pools[size_class];
 	dsa_area_span *span;
@@ -1445,6 +1509,7 @@ alloc_object(dsa_area *area, int size_class)
 	dsa_pointer result;
 	char	   *object;
 	size_t		size;
+	int			count = 0;
 
 	/*
 	 * Even though ensure_active_superblock can in turn call alloc_object if
@@ -1455,17 +1520,16 @@ alloc_object(dsa_area *area, int size_class)
 	Assert(!LWLockHeldByMe(DSA_SCLASS_LOCK(area, size_class)));
 	LWLockAcquire(DSA_SCLASS_LOCK(area, size_class), LW_EXCLUSIVE);
 
-	/*
-	 * If there's no active superblock, we must successfully obtain one or
-	 * fail the request.
-	 */
-	if (!DsaPointerIsValid(pool->spans[1]) &&
-		!ensure_active_superblock(area, pool, size_class))
-	{
-		result = InvalidDsaPointer;
-	}
-	else
+	while (count < nobjects)
 	{
+		/*
+		 * If there's no active superblock, we must successfully obtain one
+		 * or fail the request.
+		 */
+		if (!DsaPointerIsValid(pool->spans[1]) &&
+			!ensure_active_superblock(area, pool, size_class))
+			break;
+
 		/*
 		 * There should be a block in fullness class 1 at this point, and it
 		 * should never be completely full.  Thus we can either pop an object
@@ -1494,12 +1558,70 @@ alloc_object(dsa_area *area, int size_class)
 		/* If it's now full, move it to the highest-numbered fullness class. */
 		if (span->nallocatable == 0)
 			transfer_first_span(area, pool, 1, DSA_FULLNESS_CLASSES - 1);
+
+		objects[count++] = result;
 	}
 
 	Assert(LWLockHeldByMe(DSA_SCLASS_LOCK(area, size_class)));
 	LWLockRelease(DSA_SCLASS_LOCK(area, size_class));
 
-	return result;
+	return count;
+}
+
+/*
+ * As alloc_object, but served from the backend-local object cache when
+ * possible.  On a cache miss we refill the cache with a batch of objects,
+ * so a stream of allocations of the same size class pays for one lock
+ * acquisition per DSA_CACHE_BATCH objects rather than one per object.
+ */
+static dsa_pointer
+alloc_object_cached(dsa_area *area, int size_class)
+{
+	dsa_pointer objects[DSA_CACHE_BATCH];
+	int			n;
+
+	StaticAssertStmt(DSA_CACHE_BATCH <= DSA_CACHE_OBJECTS,
+					 "DSA cache batch must fit in the cache");
+
+	if (!area->cache_enabled)
+		return alloc_object(area, size_class);
+
+	if (area->ncached_objects[size_class] > 0)
+		return area->cached_objects[size_class][--area->ncached_objects[size_class]];
+
+	/* Cache is empty; refill it, handing out the last object obtained. */
+	n = alloc_object_batch(area, size_class, objects, DSA_CACHE_BATCH);
+	if (n == 0)
+		return InvalidDsaPointer;
+	--n;
+	memcpy(area->cached_objects[size_class], objects, n * sizeof(dsa_pointer));
+	area->ncached_objects[size_class] = n;
+
+	return objects[n];
+}
+
+/*
+ * Return all cached objects to the shared pools.  This is done before
+ * operations that expect unused memory to be reclaimable (dsa_trim), and on
+ * detach, since a cached object would otherwise remain allocated for the
+ * lifetime of the area.
+ */
+static void
+flush_object_cache(dsa_area *area)
+{
+	int			size_class;
+
+	/* Prevent dsa_free from putting the objects straight back. */
+	area->cache_enabled = false;
+
+	for (size_class = 0; size_class < DSA_NUM_SIZE_CLASSES; ++size_class)
+	{
+		while (area->ncached_objects[size_class] > 0)
+			dsa_free(area,
+					 area->cached_objects[size_class][--area->ncached_objects[size_class]]);
+	}
+
+	area->cache_enabled = true;
 }
 
 /*
@@ -1914,6 +2036,15 @@ dsa_detach(dsa_area *area)
 {
 	int			i;
 
+	/*
+	 * Give back any cached objects before unmapping; otherwise they would
+	 * stay allocated for as long as the area lives.  (If a backend exits
+	 * through an error path without reaching here, its cached objects are
+	 * leaked until the area is destroyed; the cache is small enough for that
+	 * to be tolerable.)
+	 */
+	flush_object_cache(area);
+
 	/* Detach from all segments. */
 	for (i = 0; i <= area->high_segment_index; ++i)
 		if (area->segment_maps[i].segment != NULL)
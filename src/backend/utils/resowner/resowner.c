@@ -1121,6 +1121,30 @@ ResourceOwnerForgetPlanCacheRef(ResourceOwner owner, CachedPlan *plan)
 			 plan, owner->name);
 }
 
+/*
+ * Release all plancache references (if any) owned by a ResourceOwner.
+ *
+ * This provides for early release of plancache references held by a
+ * long-lived ResourceOwner, without warnings; it's for use by modules that
+ * use such an owner to hold plan refcounts across transactions.
+ */
+void
+ResourceOwnerReleaseAllPlanCacheRefs(ResourceOwner owner)
+{
+	ResourceOwner save;
+	Datum		foundres;
+
+	save = CurrentResourceOwner;
+	CurrentResourceOwner = owner;
+	while (ResourceArrayGetAny(&(owner->planrefarr), &foundres))
+	{
+		CachedPlan *res = (CachedPlan *) DatumGetPointer(foundres);
+
+		ReleaseCachedPlan(res, true);
+	}
+	CurrentResourceOwner = save;
+}
+
 /*
  * Debugging subroutine
  */
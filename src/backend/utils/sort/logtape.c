@@ -49,6 +49,19 @@
  * when reading, and read multiple blocks from the same tape in one go,
  * whenever the buffer becomes empty.
  *
+ * For serial tape sets, each block is additionally compressed with pglz
+ * and checksummed before it is written out.  Compressed blocks are variable
+ * length on disk, so they are simply appended to the underlying file in
+ * whatever order they are dumped, and a map from block number to physical
+ * location provides the fixed-size-block illusion that the rest of this
+ * module relies on.  Because the blocks of any one run are dumped and later
+ * read back in nearly the same order, consecutive reads from a tape land on
+ * adjacent file positions and are serviced together by buffile.c's buffer,
+ * which acts as readahead over multiple small compressed blocks.  The map
+ * is private to the process that wrote it, and concatenation of worker
+ * tapes in a leader requires block numbers to translate directly to file
+ * offsets, so parallel sort tape sets are stored uncompressed.
+ *
  * To support the above policy of writing to the lowest free block,
  * ltsGetFreeBlock sorts the list of free block numbers into decreasing
  * order each time it is asked for a block and the list isn't currently
@@ -82,6 +95,8 @@
 
 #include "postgres.h"
 
+#include "common/pg_lzcompress.h"
+#include "port/pg_crc32c.h"
 #include "storage/buffile.h"
 #include "utils/builtins.h"
 #include "utils/logtape.h"
@@ -114,6 +129,30 @@ typedef struct TapeBlockTrailer
 #define TapeBlockSetNBytes(buf, nbytes) \
 	(TapeBlockGetTrailer(buf)->next = -(nbytes))
 
+/*
+ * When block compression is enabled, blocks are variable length on disk.
+ * Each one starts with this header, followed by 'storedlen' bytes of
+ * payload; storedlen == BLCKSZ means the block did not compress and was
+ * stored raw.  The CRC always covers the full uncompressed block.
+ */
+typedef struct LtsCompressedBlockHeader
+{
+	uint16		storedlen;		/* bytes of payload stored on disk */
+	pg_crc32c	crc;			/* CRC-32C of uncompressed block */
+} LtsCompressedBlockHeader;
+
+/*
+ * Physical location of one compressed block's latest incarnation, in terms
+ * a BufFile understands.  Rewriting a recycled block appends a fresh
+ * incarnation and abandons the old one's space.
+ */
+typedef struct LtsBlockMapEntry
+{
+	int			fileno;			/* physical file number, or -1 if the block
+								 * has never been written */
+	off_t		offset;			/* offset of block header in that file */
+} LtsBlockMapEntry;
+
 
 /*
  * This data structure represents a single "logical tape" within the set
@@ -200,13 +239,31 @@ struct LogicalTapeSet
 	int			nFreeBlocks;	/* # of currently free blocks */
 	int			freeBlocksLen;	/* current allocated length of freeBlocks[] */
 
+	/*
+	 * Block compression state.  When 'compress' is true, each block is
+	 * compressed and checksummed before being written, and is appended at
+	 * the current physical end of file rather than at the file position its
+	 * block number implies; blockMap[] remembers where each block actually
+	 * went.  Serial tape sets only; see file header comments.
+	 */
+	bool		compress;		/* compress blocks on disk? */
+	char	   *cbuffer;		/* compressed-data workspace, if compress */
+	LtsBlockMapEntry *blockMap; /* per-block physical locations */
+	long		blockMapLen;	/* allocated length of blockMap[] */
+	int			nextFileno;		/* physical append position: file number... */
+	off_t		nextOffset;		/* ...and offset within that file */
+
 	/* The array of logical tapes. */
 	int			nTapes;			/* # of logical tapes in set */
 	LogicalTape tapes[FLEXIBLE_ARRAY_MEMBER];	/* has nTapes nentries */
 };
 
 static void ltsWriteBlock(LogicalTapeSet *lts, long blocknum, void *buffer);
+static void ltsWriteCompressedBlock(LogicalTapeSet *lts, long blocknum,
+									void *buffer);
 static void ltsReadBlock(LogicalTapeSet *lts, long blocknum, void *buffer);
+static void ltsReadCompressedBlock(LogicalTapeSet *lts, long blocknum,
+								   void *buffer);
 static long ltsGetFreeBlock(LogicalTapeSet *lts);
 static void ltsReleaseBlock(LogicalTapeSet *lts, long blocknum);
 static void ltsConcatWorkerTapes(LogicalTapeSet *lts, TapeShare *shared,
@@ -221,6 +278,12 @@ static void ltsConcatWorkerTapes(LogicalTapeSet *lts, TapeShare *shared,
 static void
 ltsWriteBlock(LogicalTapeSet *lts, long blocknum, void *buffer)
 {
+	if (lts->compress)
+	{
+		ltsWriteCompressedBlock(lts, blocknum, buffer);
+		return;
+	}
+
 	/*
 	 * BufFile does not support "holes", so if we're about to write a block
 	 * that's past the current end of file, fill the space between the current
@@ -260,6 +323,70 @@ ltsWriteBlock(LogicalTapeSet *lts, long blocknum, void *buffer)
 		lts->nBlocksWritten++;
 }
 
+/*
+ * As ltsWriteBlock, but for a tape set with block compression enabled.
+ *
+ * The compressed incarnation of the block is appended at the current
+ * physical end of file, and its location is remembered in the block map.
+ * No zero-filling of holes is needed, since block numbers no longer
+ * correspond to file positions.
+ */
+static void
+ltsWriteCompressedBlock(LogicalTapeSet *lts, long blocknum, void *buffer)
+{
+	LtsCompressedBlockHeader header;
+	char	   *payload;
+	int32		complen;
+
+	/* Enlarge the block map if needed, marking new entries unwritten */
+	if (blocknum >= lts->blockMapLen)
+	{
+		long		newlen = lts->blockMapLen;
+		long		i;
+
+		while (newlen <= blocknum)
+			newlen *= 2;
+		lts->blockMap = (LtsBlockMapEntry *)
+			repalloc(lts->blockMap, newlen * sizeof(LtsBlockMapEntry));
+		for (i = lts->blockMapLen; i < newlen; i++)
+			lts->blockMap[i].fileno = -1;
+		lts->blockMapLen = newlen;
+	}
+
+	complen = pglz_compress((const char *) buffer, BLCKSZ, lts->cbuffer,
+							PGLZ_strategy_default);
+	if (complen < 0)
+	{
+		/* incompressible, store it raw */
+		payload = (char *) buffer;
+		complen = BLCKSZ;
+	}
+	else
+		payload = lts->cbuffer;
+
+	header.storedlen = (uint16) complen;
+	INIT_CRC32C(header.crc);
+	COMP_CRC32C(header.crc, buffer, BLCKSZ);
+	FIN_CRC32C(header.crc);
+
+	if (BufFileSeek(lts->pfile, lts->nextFileno, lts->nextOffset,
+					SEEK_SET) != 0 ||
+		BufFileWrite(lts->pfile, &header, sizeof(header)) != sizeof(header) ||
+		BufFileWrite(lts->pfile, payload, complen) != (size_t) complen)
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not write block %ld of temporary file: %m",
+						blocknum)));
+
+	lts->blockMap[blocknum].fileno = lts->nextFileno;
+	lts->blockMap[blocknum].offset = lts->nextOffset;
+	BufFileTell(lts->pfile, &lts->nextFileno, &lts->nextOffset);
+
+	/* Update nBlocksWritten, if we extended the file (logically) */
+	if (blocknum >= lts->nBlocksWritten)
+		lts->nBlocksWritten = blocknum + 1;
+}
+
 /*
  * Read a block-sized buffer from the specified block of the underlying file.
  *
@@ -269,6 +396,12 @@ ltsWriteBlock(LogicalTapeSet *lts, long blocknum, void *buffer)
 static void
 ltsReadBlock(LogicalTapeSet *lts, long blocknum, void *buffer)
 {
+	if (lts->compress)
+	{
+		ltsReadCompressedBlock(lts, blocknum, buffer);
+		return;
+	}
+
 	if (BufFileSeekBlock(lts->pfile, blocknum) != 0 ||
 		BufFileRead(lts->pfile, buffer, BLCKSZ) != BLCKSZ)
 		ereport(ERROR,
@@ -277,6 +410,67 @@ ltsReadBlock(LogicalTapeSet *lts, long blocknum, void *buffer)
 						blocknum)));
 }
 
+/*
+ * As ltsReadBlock, but for a tape set with block compression enabled.
+ *
+ * The block is located through the block map, decompressed if necessary,
+ * and verified against its checksum.  Because blocks of a run are appended
+ * in nearly the order they are later read back, consecutive reads usually
+ * fall within buffile.c's buffer, so several compressed blocks are fetched
+ * with a single physical read.
+ */
+static void
+ltsReadCompressedBlock(LogicalTapeSet *lts, long blocknum, void *buffer)
+{
+	LtsCompressedBlockHeader header;
+	LtsBlockMapEntry *entry;
+	pg_crc32c	crc;
+
+	if (blocknum < 0 || blocknum >= lts->blockMapLen ||
+		lts->blockMap[blocknum].fileno < 0)
+		elog(ERROR, "could not read unwritten block %ld of temporary file",
+			 blocknum);
+	entry = &lts->blockMap[blocknum];
+
+	if (BufFileSeek(lts->pfile, entry->fileno, entry->offset, SEEK_SET) != 0 ||
+		BufFileRead(lts->pfile, &header, sizeof(header)) != sizeof(header))
+		ereport(ERROR,
+				(errcode_for_file_access(),
+				 errmsg("could not read block %ld of temporary file: %m",
+						blocknum)));
+
+	if (header.storedlen == BLCKSZ)
+	{
+		/* stored raw */
+		if (BufFileRead(lts->pfile, buffer, BLCKSZ) != BLCKSZ)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("compressed block %ld of temporary file is corrupt",
+							blocknum)));
+	}
+	else
+	{
+		if (header.storedlen > BLCKSZ ||
+			BufFileRead(lts->pfile, lts->cbuffer,
+						header.storedlen) != header.storedlen ||
+			pglz_decompress(lts->cbuffer, header.storedlen,
+							(char *) buffer, BLCKSZ, true) != BLCKSZ)
+			ereport(ERROR,
+					(errcode(ERRCODE_DATA_CORRUPTED),
+					 errmsg("compressed block %ld of temporary file is corrupt",
+							blocknum)));
+	}
+
+	INIT_CRC32C(crc);
+	COMP_CRC32C(crc, buffer, BLCKSZ);
+	FIN_CRC32C(crc);
+	if (!EQ_CRC32C(crc, header.crc))
+		ereport(ERROR,
+				(errcode(ERRCODE_DATA_CORRUPTED),
+				 errmsg("checksum failure in block %ld of temporary file",
+						blocknum)));
+}
+
 /*
  * Read as many blocks as we can into the per-tape buffer.
  *
@@ -528,6 +722,12 @@ LogicalTapeSetCreate(int ntapes, TapeShare *shared, SharedFileSet *fileset,
 	lts->freeBlocksLen = 32;	/* reasonable initial guess */
 	lts->freeBlocks = (long *) palloc(lts->freeBlocksLen * sizeof(long));
 	lts->nFreeBlocks = 0;
+	lts->compress = false;
+	lts->cbuffer = NULL;
+	lts->blockMap = NULL;
+	lts->blockMapLen = 0;
+	lts->nextFileno = 0;
+	lts->nextOffset = 0L;
 	lts->nTapes = ntapes;
 
 	/*
@@ -572,8 +772,27 @@ LogicalTapeSetCreate(int ntapes, TapeShare *shared, SharedFileSet *fileset,
 		lts->pfile = BufFileCreateShared(fileset, filename);
 	}
 	else
+	{
+		long		j;
+
 		lts->pfile = BufFileCreateTemp(false);
 
+		/*
+		 * Serial tape sets compress and checksum their blocks.  Worker and
+		 * leader tape sets cannot, because concatenating worker tapes in the
+		 * leader requires block numbers to translate directly to file
+		 * offsets, and the block map is private to the process that wrote
+		 * it.
+		 */
+		lts->compress = true;
+		lts->cbuffer = (char *) palloc(PGLZ_MAX_OUTPUT(BLCKSZ));
+		lts->blockMapLen = 64;	/* reasonable initial guess */
+		lts->blockMap = (LtsBlockMapEntry *)
+			palloc(lts->blockMapLen * sizeof(LtsBlockMapEntry));
+		for (j = 0; j < lts->blockMapLen; j++)
+			lts->blockMap[j].fileno = -1;
+	}
+
 	return lts;
 }
 
@@ -593,6 +812,10 @@ LogicalTapeSetClose(LogicalTapeSet *lts)
 		if (lt->buffer)
 			pfree(lt->buffer);
 	}
+	if (lts->cbuffer)
+		pfree(lts->cbuffer);
+	if (lts->blockMap)
+		pfree(lts->blockMap);
 	pfree(lts->freeBlocks);
 	pfree(lts);
 }
@@ -6,9 +6,9 @@
  * This module contains a shared temporary tuple storage mechanism providing
  * a parallel-aware subset of the features of tuplestore.c.  Multiple backends
  * can write to a SharedTuplestore, and then multiple backends can later scan
- * the stored tuples.  Currently, the only scan type supported is a parallel
- * scan where each backend reads an arbitrary subset of the tuples that were
- * written.
+ * the stored tuples.  Two scan types are supported: a parallel scan, where
+ * each backend reads an arbitrary subset of the tuples that were written,
+ * and a private scan, where each backend independently reads all of them.
  *
  * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
  * Portions Copyright (c) 1994, Regents of the University of California
@@ -158,6 +158,7 @@ sts_initialize(SharedTuplestore *sts, int participants,
 		LWLockInitialize(&sts->participants[i].lock,
 						 LWTRANCHE_SHARED_TUPLESTORE);
 		sts->participants[i].read_page = 0;
+		sts->participants[i].npages = 0;
 		sts->participants[i].writing = false;
 	}
 
@@ -621,6 +622,113 @@ sts_parallel_scan_next(SharedTuplestoreAccessor *accessor, void *meta_data)
 	return NULL;
 }
 
+/*
+ * Begin a private scan of the full contents.  Unlike a parallel scan, every
+ * participant that does this reads all of the stored tuples, not just a
+ * share of them, and participants do not affect each other's progress.
+ * All writers must already have called sts_end_write().  Can be called again
+ * to restart the scan from the beginning.
+ */
+void
+sts_begin_private_scan(SharedTuplestoreAccessor *accessor)
+{
+	int			i PG_USED_FOR_ASSERTS_ONLY;
+
+	/* End any existing scan that was in progress. */
+	sts_end_parallel_scan(accessor);
+
+	/* All writes must be finished, just as for a parallel scan. */
+	for (i = 0; i < accessor->sts->nparticipants; ++i)
+		Assert(!accessor->sts->participants[i].writing);
+
+	/* Scan every participant's file, starting with the first. */
+	accessor->read_participant = 0;
+	accessor->read_file = NULL;
+	accessor->read_next_page = 0;
+	accessor->read_ntuples = 0;
+	accessor->read_ntuples_available = 0;
+}
+
+/*
+ * Get the next tuple in a private scan begun with sts_begin_private_scan().
+ */
+MinimalTuple
+sts_private_scan_next(SharedTuplestoreAccessor *accessor, void *meta_data)
+{
+	for (;;)
+	{
+		BlockNumber read_page;
+		SharedTuplestoreChunk chunk_header;
+
+		/* Can we read more tuples from the current chunk? */
+		if (accessor->read_ntuples < accessor->read_ntuples_available)
+			return sts_read_tuple(accessor, meta_data);
+
+		/*
+		 * Find the next chunk to read.  Unlike a parallel scan, we track our
+		 * position privately in read_next_page instead of claiming chunks
+		 * from the shared read head, so nothing is skipped.
+		 */
+		while (accessor->read_participant < accessor->sts->nparticipants &&
+			   accessor->read_next_page >=
+			   accessor->sts->participants[accessor->read_participant].npages)
+		{
+			/* This participant's file is exhausted.  Try the next one. */
+			if (accessor->read_file != NULL)
+			{
+				BufFileClose(accessor->read_file);
+				accessor->read_file = NULL;
+			}
+			accessor->read_participant++;
+			accessor->read_next_page = 0;
+		}
+		if (accessor->read_participant >= accessor->sts->nparticipants)
+			return NULL;
+
+		read_page = accessor->read_next_page;
+		accessor->read_next_page += STS_CHUNK_PAGES;
+
+		/* Make sure we have the file open. */
+		if (accessor->read_file == NULL)
+		{
+			char		name[MAXPGPATH];
+
+			sts_filename(name, accessor, accessor->read_participant);
+			accessor->read_file = BufFileOpenShared(accessor->fileset, name);
+		}
+
+		/* Seek and load the chunk header. */
+		if (BufFileSeekBlock(accessor->read_file, read_page) != 0)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read from shared tuplestore temporary file"),
+					 errdetail_internal("Could not seek to next block.")));
+		if (BufFileRead(accessor->read_file, &chunk_header,
+						STS_CHUNK_HEADER_SIZE) != STS_CHUNK_HEADER_SIZE)
+			ereport(ERROR,
+					(errcode_for_file_access(),
+					 errmsg("could not read from shared tuplestore temporary file"),
+					 errdetail_internal("Short read while reading chunk header.")));
+
+		/*
+		 * Skip overflow chunks; they are consumed by sts_read_tuple() along
+		 * with the oversized tuple that begins in the preceding chunk.
+		 */
+		if (chunk_header.overflow > 0)
+		{
+			accessor->read_next_page = read_page +
+				chunk_header.overflow * STS_CHUNK_PAGES;
+			continue;
+		}
+
+		accessor->read_ntuples = 0;
+		accessor->read_ntuples_available = chunk_header.ntuples;
+		accessor->read_bytes = STS_CHUNK_HEADER_SIZE;
+
+		/* Go around again, so we can get a tuple from this chunk. */
+	}
+}
+
 /*
  * Create the name used for the BufFile that a given participant will write.
  */
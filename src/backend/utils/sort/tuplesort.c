@@ -96,6 +96,8 @@
 
 #include <limits.h>
 
+#include "access/genam.h"
+#include "access/gist.h"
 #include "access/hash.h"
 #include "access/htup_details.h"
 #include "access/nbtree.h"
@@ -221,6 +223,15 @@ typedef enum
 #define TAPE_BUFFER_OVERHEAD		BLCKSZ
 #define MERGE_BUFFER_SIZE			(BLCKSZ * 32)
 
+/*
+ * Initial size of memtuples array.  We're trying to select this size so that
+ * the array doesn't exceed ALLOCSET_SEPARATE_THRESHOLD and so that the
+ * overall memory consumption doesn't exceed the allowed memory limit by too
+ * much.  See comments in grow_memtuples().
+ */
+#define INITIAL_MEMTUPSIZE Max(1024, \
+	ALLOCSET_SEPARATE_THRESHOLD / sizeof(SortTuple) + 1)
+
 typedef int (*SortTupleComparator) (const SortTuple *a, const SortTuple *b,
 									Tuplesortstate *state);
 
@@ -241,6 +252,8 @@ struct Tuplesortstate
 	int64		allowedMem;		/* total memory allowed, in bytes */
 	int			maxTapes;		/* number of tapes (Knuth's T) */
 	int			tapeRange;		/* maxTapes-1 (Knuth's P) */
+	MemoryContext maincontext;	/* memory context for tuple sort metadata that
+								 * persists across multiple batches */
 	MemoryContext sortcontext;	/* memory context holding most sort data */
 	MemoryContext tuplecontext; /* sub-context of sortcontext for tuple data */
 	LogicalTapeSet *tapeset;	/* logtape.c object for tapes in a temp file */
@@ -591,6 +604,8 @@ struct Sharedsort
 static Tuplesortstate *tuplesort_begin_common(int workMem,
 											  SortCoordinate coordinate,
 											  bool randomAccess);
+static void tuplesort_begin_batch(Tuplesortstate *state);
+static void tuplesort_free(Tuplesortstate *state);
 static void puttuple_common(Tuplesortstate *state, SortTuple *tuple);
 static bool consider_abort_common(Tuplesortstate *state);
 static void inittapes(Tuplesortstate *state, bool mergeruns);
@@ -604,6 +619,7 @@ static bool mergereadnext(Tuplesortstate *state, int srcTape, SortTuple *stup);
 static void dumptuples(Tuplesortstate *state, bool alltuples);
 static void make_bounded_heap(Tuplesortstate *state);
 static void sort_bounded_heap(Tuplesortstate *state);
+static bool tuplesort_radix_sort(Tuplesortstate *state);
 static void tuplesort_sort_memtuples(Tuplesortstate *state);
 static void tuplesort_heap_insert(Tuplesortstate *state, SortTuple *tuple);
 static void tuplesort_heap_replace_top(Tuplesortstate *state, SortTuple *tuple);
@@ -630,6 +646,8 @@ static int	comparetup_index_btree(const SortTuple *a, const SortTuple *b,
 								   Tuplesortstate *state);
 static int	comparetup_index_hash(const SortTuple *a, const SortTuple *b,
 								  Tuplesortstate *state);
+static int	comparetup_index_gist(const SortTuple *a, const SortTuple *b,
+								  Tuplesortstate *state);
 static void copytup_index(Tuplesortstate *state, SortTuple *stup, void *tup);
 static void writetup_index(Tuplesortstate *state, int tapenum,
 						   SortTuple *stup);
@@ -682,8 +700,8 @@ tuplesort_begin_common(int workMem, SortCoordinate coordinate,
 					   bool randomAccess)
 {
 	Tuplesortstate *state;
+	MemoryContext maincontext;
 	MemoryContext sortcontext;
-	MemoryContext tuplecontext;
 	MemoryContext oldcontext;
 
 	/* See leader_takeover_tapes() remarks on randomAccess support */
@@ -691,31 +709,31 @@ tuplesort_begin_common(int workMem, SortCoordinate coordinate,
 		elog(ERROR, "random access disallowed under parallel sort");
 
 	/*
-	 * Create a working memory context for this sort operation. All data
-	 * needed by the sort will live inside this context.
+	 * Memory context surviving tuplesort_reset.  This memory context holds
+	 * data which is useful to keep while sorting multiple similar batches.
 	 */
-	sortcontext = AllocSetContextCreate(CurrentMemoryContext,
+	maincontext = AllocSetContextCreate(CurrentMemoryContext,
 										"TupleSort main",
 										ALLOCSET_DEFAULT_SIZES);
 
 	/*
-	 * Caller tuple (e.g. IndexTuple) memory context.
-	 *
-	 * A dedicated child context used exclusively for caller passed tuples
-	 * eases memory management.  Resetting at key points reduces
-	 * fragmentation. Note that the memtuples array of SortTuples is allocated
-	 * in the parent context, not this context, because there is no need to
-	 * free memtuples early.
+	 * Create a working memory context for one sort operation.  The content of
+	 * this context is deleted by tuplesort_reset.
+	 */
+	sortcontext = AllocSetContextCreate(maincontext,
+										"TupleSort sort",
+										ALLOCSET_DEFAULT_SIZES);
+
+	/*
+	 * Additionally a working memory context for tuples is created in
+	 * tuplesort_begin_batch.
 	 */
-	tuplecontext = AllocSetContextCreate(sortcontext,
-										 "Caller tuples",
-										 ALLOCSET_DEFAULT_SIZES);
 
 	/*
-	 * Make the Tuplesortstate within the per-sort context.  This way, we
-	 * don't need a separate pfree() operation for it at shutdown.
+	 * Make the Tuplesortstate within the per-sort-state context.  This way,
+	 * we don't need a separate pfree() operation for it at shutdown.
 	 */
-	oldcontext = MemoryContextSwitchTo(sortcontext);
+	oldcontext = MemoryContextSwitchTo(maincontext);
 
 	state = (Tuplesortstate *) palloc0(sizeof(Tuplesortstate));
 
@@ -724,11 +742,8 @@ tuplesort_begin_common(int workMem, SortCoordinate coordinate,
 		pg_rusage_init(&state->ru_start);
 #endif
 
-	state->status = TSS_INITIAL;
 	state->randomAccess = randomAccess;
-	state->bounded = false;
 	state->tuples = true;
-	state->boundUsed = false;
 
 	/*
 	 * workMem is forced to be at least 64KB, the current minimum valid value
@@ -737,38 +752,21 @@ tuplesort_begin_common(int workMem, SortCoordinate coordinate,
 	 * with very little memory.
 	 */
 	state->allowedMem = Max(workMem, 64) * (int64) 1024;
-	state->availMem = state->allowedMem;
 	state->sortcontext = sortcontext;
-	state->tuplecontext = tuplecontext;
-	state->tapeset = NULL;
-
-	state->memtupcount = 0;
+	state->maincontext = maincontext;
 
 	/*
 	 * Initial size of array must be more than ALLOCSET_SEPARATE_THRESHOLD;
 	 * see comments in grow_memtuples().
 	 */
-	state->memtupsize = Max(1024,
-							ALLOCSET_SEPARATE_THRESHOLD / sizeof(SortTuple) + 1);
-
-	state->growmemtuples = true;
-	state->slabAllocatorUsed = false;
-	state->memtuples = (SortTuple *) palloc(state->memtupsize * sizeof(SortTuple));
-
-	USEMEM(state, GetMemoryChunkSpace(state->memtuples));
-
-	/* workMem must be large enough for the minimal memtuples array */
-	if (LACKMEM(state))
-		elog(ERROR, "insufficient memory allowed for sort");
-
-	state->currentRun = 0;
+	state->memtupsize = INITIAL_MEMTUPSIZE;
+	state->memtuples = NULL;
 
 	/*
-	 * maxTapes, tapeRange, and Algorithm D variables will be initialized by
-	 * inittapes(), if needed
+	 * After all of the other non-parallel-related state, we setup all of the
+	 * state needed for each batch.
 	 */
-
-	state->result_tape = -1;	/* flag that result tape has not been formed */
+	tuplesort_begin_batch(state);
 
 	/*
 	 * Initialize parallel-related state based on coordination information
@@ -802,6 +800,75 @@ tuplesort_begin_common(int workMem, SortCoordinate coordinate,
 	return state;
 }
 
+/*
+ *		tuplesort_begin_batch
+ *
+ * Setup, or reset, all state need for processing a new set of tuples with this
+ * sort state. Called both from tuplesort_begin_common (the first time sorting
+ * with this sort state) and tuplesort_reset (for subsequent usages).
+ */
+static void
+tuplesort_begin_batch(Tuplesortstate *state)
+{
+	MemoryContext oldcontext;
+
+	oldcontext = MemoryContextSwitchTo(state->maincontext);
+
+	/*
+	 * Caller tuple (e.g. IndexTuple) memory context.
+	 *
+	 * A dedicated child context used exclusively for caller passed tuples
+	 * eases memory management.  Resetting at key points reduces
+	 * fragmentation. Note that the memtuples array of SortTuples is allocated
+	 * in the parent context, not this context, because there is no need to
+	 * free memtuples early.
+	 */
+	state->tuplecontext = AllocSetContextCreate(state->sortcontext,
+												"Caller tuples",
+												ALLOCSET_DEFAULT_SIZES);
+
+	state->status = TSS_INITIAL;
+	state->bounded = false;
+	state->boundUsed = false;
+
+	state->availMem = state->allowedMem;
+
+	state->tapeset = NULL;
+
+	state->memtupcount = 0;
+
+	/*
+	 * Initial size of array must be more than ALLOCSET_SEPARATE_THRESHOLD;
+	 * see comments in grow_memtuples().
+	 */
+	state->growmemtuples = true;
+	state->slabAllocatorUsed = false;
+	if (state->memtuples != NULL && state->memtupsize != INITIAL_MEMTUPSIZE)
+	{
+		pfree(state->memtuples);
+		state->memtuples = NULL;
+		state->memtupsize = INITIAL_MEMTUPSIZE;
+	}
+	if (state->memtuples == NULL)
+		state->memtuples = (SortTuple *) palloc(state->memtupsize * sizeof(SortTuple));
+	USEMEM(state, GetMemoryChunkSpace(state->memtuples));
+
+	/* workMem must be large enough for the minimal memtuples array */
+	if (LACKMEM(state))
+		elog(ERROR, "insufficient memory allowed for sort");
+
+	state->currentRun = 0;
+
+	/*
+	 * maxTapes, tapeRange, and Algorithm D variables will be initialized by
+	 * inittapes(), if needed
+	 */
+
+	state->result_tape = -1;	/* flag that result tape has not been formed */
+
+	MemoryContextSwitchTo(oldcontext);
+}
+
 Tuplesortstate *
 tuplesort_begin_heap(TupleDesc tupDesc,
 					 int nkeys, AttrNumber *attNums,
@@ -814,7 +881,7 @@ tuplesort_begin_heap(TupleDesc tupDesc,
 	MemoryContext oldcontext;
 	int			i;
 
-	oldcontext = MemoryContextSwitchTo(state->sortcontext);
+	oldcontext = MemoryContextSwitchTo(state->maincontext);
 
 	AssertArg(nkeys > 0);
 
@@ -890,7 +957,7 @@ tuplesort_begin_cluster(TupleDesc tupDesc,
 
 	Assert(indexRel->rd_rel->relam == BTREE_AM_OID);
 
-	oldcontext = MemoryContextSwitchTo(state->sortcontext);
+	oldcontext = MemoryContextSwitchTo(state->maincontext);
 
 #ifdef TRACE_SORT
 	if (trace_sort)
@@ -985,7 +1052,7 @@ tuplesort_begin_index_btree(Relation heapRel,
 	MemoryContext oldcontext;
 	int			i;
 
-	oldcontext = MemoryContextSwitchTo(state->sortcontext);
+	oldcontext = MemoryContextSwitchTo(state->maincontext);
 
 #ifdef TRACE_SORT
 	if (trace_sort)
@@ -1063,7 +1130,7 @@ tuplesort_begin_index_hash(Relation heapRel,
 												   randomAccess);
 	MemoryContext oldcontext;
 
-	oldcontext = MemoryContextSwitchTo(state->sortcontext);
+	oldcontext = MemoryContextSwitchTo(state->maincontext);
 
 #ifdef TRACE_SORT
 	if (trace_sort)
@@ -1095,6 +1162,54 @@ tuplesort_begin_index_hash(Relation heapRel,
 	return state;
 }
 
+Tuplesortstate *
+tuplesort_begin_index_gist(Relation heapRel,
+						   Relation indexRel,
+						   int workMem,
+						   SortCoordinate coordinate,
+						   bool randomAccess)
+{
+	Tuplesortstate *state = tuplesort_begin_common(workMem, coordinate,
+												   randomAccess);
+	MemoryContext oldcontext;
+
+	oldcontext = MemoryContextSwitchTo(state->maincontext);
+
+#ifdef TRACE_SORT
+	if (trace_sort)
+		elog(LOG,
+			 "begin index sort: workMem = %d, randomAccess = %c",
+			 workMem, randomAccess ? 't' : 'f');
+#endif
+
+	state->nKeys = 1;			/* Only the leading column is sorted on */
+
+	state->comparetup = comparetup_index_gist;
+	state->copytup = copytup_index;
+	state->writetup = writetup_index;
+	state->readtup = readtup_index;
+
+	state->heapRel = heapRel;
+	state->indexRel = indexRel;
+
+	/* Prepare SortSupport data for the leading column */
+	state->sortKeys = (SortSupport) palloc0(sizeof(SortSupportData));
+
+	state->sortKeys->ssup_cxt = CurrentMemoryContext;
+	state->sortKeys->ssup_collation = indexRel->rd_indcollation[0];
+	state->sortKeys->ssup_nulls_first = false;
+	state->sortKeys->ssup_attno = 1;
+	state->sortKeys->abbreviate = false;
+
+	/* Look up the opclass sortsupport function and let it fill the rest */
+	FunctionCall1(index_getprocinfo(indexRel, 1, GIST_SORTSUPPORT_PROC),
+				  PointerGetDatum(state->sortKeys));
+
+	MemoryContextSwitchTo(oldcontext);
+
+	return state;
+}
+
 Tuplesortstate *
 tuplesort_begin_datum(Oid datumType, Oid sortOperator, Oid sortCollation,
 					  bool nullsFirstFlag, int workMem,
@@ -1106,7 +1221,7 @@ tuplesort_begin_datum(Oid datumType, Oid sortOperator, Oid sortCollation,
 	int16		typlen;
 	bool		typbyval;
 
-	oldcontext = MemoryContextSwitchTo(state->sortcontext);
+	oldcontext = MemoryContextSwitchTo(state->maincontext);
 
 #ifdef TRACE_SORT
 	if (trace_sort)
@@ -1224,16 +1339,12 @@ tuplesort_set_bound(Tuplesortstate *state, int64 bound)
 }
 
 /*
- * tuplesort_end
- *
- *	Release resources and clean up.
+ * tuplesort_free
  *
- * NOTE: after calling this, any pointers returned by tuplesort_getXXX are
- * pointing to garbage.  Be careful not to attempt to use or free such
- * pointers afterwards!
+ *	Internal routine for freeing resources of tuplesort.
  */
-void
-tuplesort_end(Tuplesortstate *state)
+static void
+tuplesort_free(Tuplesortstate *state)
 {
 	/* context swap probably not needed, but let's be safe */
 	MemoryContext oldcontext = MemoryContextSwitchTo(state->sortcontext);
@@ -1286,15 +1397,61 @@ tuplesort_end(Tuplesortstate *state)
 
 		ExecDropSingleTupleTableSlot(econtext->ecxt_scantuple);
 		FreeExecutorState(state->estate);
+		state->estate = NULL;
 	}
 
 	MemoryContextSwitchTo(oldcontext);
 
 	/*
-	 * Free the per-sort memory context, thereby releasing all working memory,
-	 * including the Tuplesortstate struct itself.
+	 * Free the per-sort memory context, thereby releasing all working memory.
 	 */
-	MemoryContextDelete(state->sortcontext);
+	MemoryContextReset(state->sortcontext);
+}
+
+/*
+ * tuplesort_end
+ *
+ *	Release resources and clean up.
+ *
+ * NOTE: after calling this, any pointers returned by tuplesort_getXXX are
+ * pointing to garbage.  Be careful not to attempt to use or free such
+ * pointers afterwards!
+ */
+void
+tuplesort_end(Tuplesortstate *state)
+{
+	tuplesort_free(state);
+
+	/*
+	 * Free the main memory context, including the Tuplesortstate struct
+	 * itself.
+	 */
+	MemoryContextDelete(state->maincontext);
+}
+
+/*
+ * tuplesort_reset
+ *
+ *	Reset the tuplesort.  Reset all the data in the tuplesort, but leave the
+ *	meta-information in.  After tuplesort_reset, tuplesort is ready to start
+ *	a new sort.  This allows avoiding recreation of tuple sort states (and
+ *	save resources) when sorting multiple small batches.
+ */
+void
+tuplesort_reset(Tuplesortstate *state)
+{
+	tuplesort_free(state);
+
+	/*
+	 * After we've freed up per-batch memory, re-setup all of the state common
+	 * to both the first batch and any subsequent batch.
+	 */
+	tuplesort_begin_batch(state);
+
+	state->lastReturnedTuple = NULL;
+	state->slabMemoryBegin = NULL;
+	state->slabMemoryEnd = NULL;
+	state->slabFreeHead = NULL;
 }
 
 /*
@@ -2642,7 +2799,8 @@ mergeruns(Tuplesortstate *state)
 	 * from each input tape.
 	 */
 	state->memtupsize = numInputTapes;
-	state->memtuples = (SortTuple *) palloc(numInputTapes * sizeof(SortTuple));
+	state->memtuples = (SortTuple *) MemoryContextAlloc(state->maincontext,
+														numInputTapes * sizeof(SortTuple));
 	USEMEM(state, GetMemoryChunkSpace(state->memtuples));
 
 	/*
@@ -3300,6 +3458,227 @@ sort_bounded_heap(Tuplesortstate *state)
 	state->boundUsed = true;
 }
 
+/*
+ * Below this many tuples, the bucket bookkeeping of the radix sort
+ * specialization isn't worth it and we just use quicksort.
+ */
+#define RADIX_SORT_MIN_TUPLES	1024
+
+/*
+ * Ways of mapping datum1 onto an unsigned 64-bit key that sorts in the same
+ * order as the comparator the datatype's sort support function installed.
+ */
+typedef enum
+{
+	RADIX_KEY_UNSIGNED,			/* ssup_datum_unsigned_cmp */
+	RADIX_KEY_SIGNED,			/* ssup_datum_signed_cmp */
+	RADIX_KEY_INT32				/* ssup_datum_int32_cmp */
+} RadixKeyKind;
+
+/*
+ * Map a SortTuple's datum1/isnull1 onto an unsigned 64-bit radix sort key,
+ * accounting for sort direction and NULL placement.  NULLs are given the
+ * appropriate extreme key value; they share it with real extreme datums, but
+ * the tie-break pass in tuplesort_radix_sort() puts such runs in exact order.
+ */
+static inline uint64
+radix_sort_key(const SortTuple *stup, RadixKeyKind kind, SortSupport ssup)
+{
+	uint64		key;
+
+	if (stup->isnull1)
+		return ssup->ssup_nulls_first ? 0 : PG_UINT64_MAX;
+
+	switch (kind)
+	{
+		case RADIX_KEY_UNSIGNED:
+			key = (uint64) stup->datum1;
+			break;
+		case RADIX_KEY_SIGNED:
+			/* flip the sign bit so that negative values sort first */
+			key = (uint64) stup->datum1 ^ (UINT64CONST(1) << 63);
+			break;
+		case RADIX_KEY_INT32:
+			key = (uint32) DatumGetInt32(stup->datum1) ^ ((uint32) 1 << 31);
+			break;
+		default:
+			key = 0;			/* keep compiler quiet */
+			break;
+	}
+
+	if (ssup->ssup_reverse)
+		key = ~key;
+
+	return key;
+}
+
+/*
+ * Attempt to sort memtuples with an LSD radix sort on the leading key.
+ *
+ * This applies when the leading sort key is stored in datum1 and compares
+ * like an integer, which we recognize by the comparator installed by the
+ * datatype's sort support function (possibly for an abbreviated key).  The
+ * radix passes order the tuples by the leading-key bytes only; each run of
+ * equal keys is then re-sorted with the full comparator, which orders any
+ * additional sort keys, resolves abbreviated-key ties authoritatively, and
+ * puts NULLs in place.
+ *
+ * Returns false, leaving memtuples untouched, if the specialization does not
+ * apply or there is no memory for the scratch array; the caller falls back
+ * to quicksort.
+ */
+static bool
+tuplesort_radix_sort(Tuplesortstate *state)
+{
+	SortSupport ssup = state->sortKeys;
+	RadixKeyKind kind;
+	SortTuple  *src;
+	SortTuple  *dst;
+	SortTuple  *scratch;
+	int64		scratch_size;
+	uint64		counts[sizeof(uint64)][256];
+	bool		have_nulls = false;
+	int			digit;
+	int			i;
+
+	if (state->memtupcount < RADIX_SORT_MIN_TUPLES)
+		return false;
+
+	if (ssup == NULL)
+		return false;
+	if (ssup->comparator == ssup_datum_unsigned_cmp)
+		kind = RADIX_KEY_UNSIGNED;
+#if SIZEOF_DATUM >= 8
+	else if (ssup->comparator == ssup_datum_signed_cmp)
+		kind = RADIX_KEY_SIGNED;
+#endif
+	else if (ssup->comparator == ssup_datum_int32_cmp)
+		kind = RADIX_KEY_INT32;
+	else
+		return false;
+
+	/* CLUSTER sorts with an expression as leading key don't fill datum1 */
+	if (state->comparetup == comparetup_cluster &&
+		state->indexInfo->ii_IndexAttrNumbers[0] == 0)
+		return false;
+
+	/*
+	 * We need a scratch array as large as the input.  Honor the memory
+	 * budget like any other allocation; in particular, while building
+	 * external sort runs memory is mostly exhausted and we'll usually take
+	 * the quicksort path instead.
+	 */
+	scratch_size = state->memtupcount * (int64) sizeof(SortTuple);
+	if (state->availMem < scratch_size)
+		return false;
+
+	/* the memtuples array may exceed MaxAllocSize, and so may the copy */
+	scratch = (SortTuple *) palloc_extended(scratch_size,
+											MCXT_ALLOC_HUGE | MCXT_ALLOC_NO_OOM);
+	if (scratch == NULL)
+		return false;
+	USEMEM(state, GetMemoryChunkSpace(scratch));
+
+	/* Build the histograms for all key bytes in a single pass */
+	memset(counts, 0, sizeof(counts));
+	for (i = 0; i < state->memtupcount; i++)
+	{
+		uint64		key = radix_sort_key(&state->memtuples[i], kind, ssup);
+
+		if (state->memtuples[i].isnull1)
+			have_nulls = true;
+		for (digit = 0; digit < (int) sizeof(uint64); digit++)
+			counts[digit][(key >> (digit * 8)) & 0xFF]++;
+	}
+
+	src = state->memtuples;
+	dst = scratch;
+
+	/* Scatter, least significant byte first */
+	for (digit = 0; digit < (int) sizeof(uint64); digit++)
+	{
+		uint64	   *count = counts[digit];
+		int			shift = digit * 8;
+		uint64		total = 0;
+		int			b;
+
+		/* skip this byte if all keys agree on it */
+		for (b = 0; b < 256; b++)
+		{
+			if (count[b] == (uint64) state->memtupcount)
+				break;
+		}
+		if (b < 256)
+			continue;
+
+		CHECK_FOR_INTERRUPTS();
+
+		/* turn the histogram into exclusive prefix sums */
+		for (b = 0; b < 256; b++)
+		{
+			uint64		c = count[b];
+
+			count[b] = total;
+			total += c;
+		}
+
+		for (i = 0; i < state->memtupcount; i++)
+		{
+			uint64		key = radix_sort_key(&src[i], kind, ssup);
+
+			dst[count[(key >> shift) & 0xFF]++] = src[i];
+		}
+
+		if (src == state->memtuples)
+		{
+			src = scratch;
+			dst = state->memtuples;
+		}
+		else
+		{
+			src = state->memtuples;
+			dst = scratch;
+		}
+	}
+
+	/* after an odd number of passes the result is in the scratch array */
+	if (src != state->memtuples)
+		memcpy(state->memtuples, src, scratch_size);
+
+	/*
+	 * Re-sort runs of equal keys with the full comparator.  This can be
+	 * skipped entirely for single-key sorts without abbreviation or NULLs,
+	 * where equal keys mean genuinely tied tuples.
+	 */
+	if (state->onlyKey == NULL || have_nulls)
+	{
+		int			start = 0;
+		uint64		runkey = radix_sort_key(&state->memtuples[0], kind, ssup);
+
+		for (i = 1; i <= state->memtupcount; i++)
+		{
+			uint64		key = 0;
+
+			if (i < state->memtupcount)
+			{
+				key = radix_sort_key(&state->memtuples[i], kind, ssup);
+				if (key == runkey)
+					continue;
+			}
+			if (i - start > 1)
+				qsort_tuple(state->memtuples + start, i - start,
+							state->comparetup, state);
+			start = i;
+			runkey = key;
+		}
+	}
+
+	FREEMEM(state, GetMemoryChunkSpace(scratch));
+	pfree(scratch);
+
+	return true;
+}
+
 /*
  * Sort all memtuples using specialized qsort() routines.
  *
@@ -3312,6 +3691,13 @@ tuplesort_sort_memtuples(Tuplesortstate *state)
 
 	if (state->memtupcount > 1)
 	{
+		/*
+		 * Try the radix sort specialization for integer-like leading keys;
+		 * it declines when it does not apply.
+		 */
+		if (tuplesort_radix_sort(state))
+			return;
+
 		/* Can we use the single-key sort function? */
 		if (state->onlyKey != NULL)
 			qsort_ssup(state->memtuples, state->memtupcount,
@@ -4138,6 +4524,50 @@ comparetup_index_hash(const SortTuple *a, const SortTuple *b,
 	return 0;
 }
 
+static int
+comparetup_index_gist(const SortTuple *a, const SortTuple *b,
+					  Tuplesortstate *state)
+{
+	IndexTuple	tuple1;
+	IndexTuple	tuple2;
+	int32		compare;
+
+	/* Compare the leading sort key, using the opclass sortsupport proc */
+	compare = ApplySortComparator(a->datum1, a->isnull1,
+								  b->datum1, b->isnull1,
+								  state->sortKeys);
+	if (compare != 0)
+		return compare;
+
+	/*
+	 * If the keys are deemed equal, we sort on ItemPointer.  The resulting
+	 * order has no significance for the index; it just makes the sort
+	 * deterministic.
+	 */
+	tuple1 = (IndexTuple) a->tuple;
+	tuple2 = (IndexTuple) b->tuple;
+
+	{
+		BlockNumber blk1 = ItemPointerGetBlockNumber(&tuple1->t_tid);
+		BlockNumber blk2 = ItemPointerGetBlockNumber(&tuple2->t_tid);
+
+		if (blk1 != blk2)
+			return (blk1 < blk2) ? -1 : 1;
+	}
+	{
+		OffsetNumber pos1 = ItemPointerGetOffsetNumber(&tuple1->t_tid);
+		OffsetNumber pos2 = ItemPointerGetOffsetNumber(&tuple2->t_tid);
+
+		if (pos1 != pos2)
+			return (pos1 < pos2) ? -1 : 1;
+	}
+
+	/* ItemPointer values should never be equal */
+	Assert(false);
+
+	return 0;
+}
+
 static void
 copytup_index(Tuplesortstate *state, SortTuple *stup, void *tup)
 {
@@ -145,6 +145,8 @@ static bool data_checksums = false;
 static char *xlog_dir = NULL;
 static char *str_wal_segment_size_mb = NULL;
 static int	wal_segment_size_mb;
+static char *str_rel_segment_size_mb = NULL;
+static int	rel_segment_size_blocks;
 
 
 /* internal vars */
@@ -1423,9 +1425,10 @@ bootstrap_template1(void)
 	unsetenv("PGCLIENTENCODING");
 
 	snprintf(cmd, sizeof(cmd),
-			 "\"%s\" --boot -x1 -X %u %s %s %s",
+			 "\"%s\" --boot -x1 -X %u -R %u %s %s %s",
 			 backend_exec,
 			 wal_segment_size_mb * (1024 * 1024),
+			 rel_segment_size_blocks,
 			 data_checksums ? "-k" : "",
 			 boot_options,
 			 debug ? "-d 5" : "");
@@ -2351,6 +2354,7 @@ usage(const char *progname)
 	printf(_("  -W, --pwprompt            prompt for a password for the new superuser\n"));
 	printf(_("  -X, --waldir=WALDIR       location for the write-ahead log directory\n"));
 	printf(_("      --wal-segsize=SIZE    size of WAL segments, in megabytes\n"));
+	printf(_("      --rel-segsize=SIZE    size of relation segment files, in megabytes\n"));
 	printf(_("\nLess commonly used options:\n"));
 	printf(_("  -d, --debug               generate lots of debugging output\n"));
 	printf(_("  -k, --data-checksums      use data page checksums\n"));
@@ -3029,6 +3033,7 @@ main(int argc, char *argv[])
 		{"sync-only", no_argument, NULL, 'S'},
 		{"waldir", required_argument, NULL, 'X'},
 		{"wal-segsize", required_argument, NULL, 12},
+		{"rel-segsize", required_argument, NULL, 13},
 		{"data-checksums", no_argument, NULL, 'k'},
 		{"allow-group-access", no_argument, NULL, 'g'},
 		{NULL, 0, NULL, 0}
@@ -3166,6 +3171,9 @@ main(int argc, char *argv[])
 			case 12:
 				str_wal_segment_size_mb = pg_strdup(optarg);
 				break;
+			case 13:
+				str_rel_segment_size_mb = pg_strdup(optarg);
+				break;
 			case 'g':
 				SetDataDirectoryCreatePerm(PG_DIR_MODE_GROUP);
 				break;
@@ -3255,6 +3263,35 @@ main(int argc, char *argv[])
 		}
 	}
 
+	/* set relation segment size */
+	if (str_rel_segment_size_mb == NULL)
+		rel_segment_size_blocks = RELSEG_SIZE;
+	else
+	{
+		char	   *endptr;
+		long		rel_segment_size_mb;
+
+		/* check that the argument is a number */
+		rel_segment_size_mb = strtol(str_rel_segment_size_mb, &endptr, 10);
+
+		/* verify that relation segment size is valid */
+		if (endptr == str_rel_segment_size_mb || *endptr != '\0')
+		{
+			pg_log_error("argument of --rel-segsize must be a number");
+			exit(1);
+		}
+		if (rel_segment_size_mb < 1 ||
+			rel_segment_size_mb > (long) 1024 * BLCKSZ ||
+			(rel_segment_size_mb & (rel_segment_size_mb - 1)) != 0)
+		{
+			pg_log_error("argument of --rel-segsize must be a power of 2 between 1 and %ld",
+						 (long) 1024 * BLCKSZ);
+			exit(1);
+		}
+		rel_segment_size_blocks =
+			(int) (rel_segment_size_mb * (1024 * 1024 / BLCKSZ));
+	}
+
 	get_restricted_token();
 
 	setup_pgdata();
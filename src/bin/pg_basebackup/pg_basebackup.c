@@ -25,6 +25,12 @@
 #ifdef HAVE_LIBZ
 #include <zlib.h>
 #endif
+#ifdef USE_LZ4
+#include <lz4frame.h>
+#endif
+#ifdef USE_ZSTD
+#include <zstd.h>
+#endif
 
 #include "access/xlog_internal.h"
 #include "common/file_perm.h"
@@ -68,6 +74,11 @@ typedef struct TablespaceList
  */
 #define MINIMUM_VERSION_FOR_TEMP_SLOTS 100000
 
+/*
+ * Server-side compression of the backup stream is supported from version 13.
+ */
+#define MINIMUM_VERSION_FOR_SERVER_COMPRESSION 130000
+
 /*
  * Different ways to include WAL
  */
@@ -78,6 +89,16 @@ typedef enum
 	STREAM_WAL
 } IncludeWal;
 
+/*
+ * Compression the server applies to the backup stream before transmission.
+ */
+typedef enum
+{
+	SERVER_COMPRESSION_NONE,
+	SERVER_COMPRESSION_LZ4,
+	SERVER_COMPRESSION_ZSTD
+} ServerCompressionMethod;
+
 /* Global options */
 static char *basedir = NULL;
 static TablespaceList tablespace_dirs = {NULL, NULL};
@@ -101,6 +122,7 @@ static bool temp_replication_slot = true;
 static bool create_slot = false;
 static bool no_slot = false;
 static bool verify_checksums = true;
+static ServerCompressionMethod server_compression = SERVER_COMPRESSION_NONE;
 
 static bool success = false;
 static bool made_new_pgdata = false;
@@ -335,6 +357,8 @@ usage(void)
 			 "                         include required WAL files with specified method\n"));
 	printf(_("  -z, --gzip             compress tar output\n"));
 	printf(_("  -Z, --compress=0-9     compress tar output with given compression level\n"));
+	printf(_("      --server-compression=none|lz4|zstd\n"
+			 "                         compress backup stream on the server\n"));
 	printf(_("\nGeneral options:\n"));
 	printf(_("  -c, --checkpoint=fast|spread\n"
 			 "                         set fast or spread checkpointing\n"));
@@ -910,6 +934,24 @@ writeTarData(
 #define WRITE_TAR_DATA(buf, sz) writeTarData(tarfile, buf, sz, filename)
 #endif
 
+/*
+ * Suffix for tar archives written to disk, reflecting any compression the
+ * server applied to the stream.
+ */
+static const char *
+tar_file_suffix(void)
+{
+	switch (server_compression)
+	{
+		case SERVER_COMPRESSION_LZ4:
+			return ".tar.lz4";
+		case SERVER_COMPRESSION_ZSTD:
+			return ".tar.zst";
+		default:
+			return ".tar";
+	}
+}
+
 /*
  * Receive a tar format file from the connection to the server, and write
  * the data from this file directly into a tar file. If compression is
@@ -991,7 +1033,8 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 			else
 #endif
 			{
-				snprintf(filename, sizeof(filename), "%s/base.tar", basedir);
+				snprintf(filename, sizeof(filename), "%s/base%s", basedir,
+						 tar_file_suffix());
 				tarfile = fopen(filename, "wb");
 			}
 		}
@@ -1018,8 +1061,8 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 		else
 #endif
 		{
-			snprintf(filename, sizeof(filename), "%s/%s.tar", basedir,
-					 PQgetvalue(res, rownum, 0));
+			snprintf(filename, sizeof(filename), "%s/%s%s", basedir,
+					 PQgetvalue(res, rownum, 0), tar_file_suffix());
 			tarfile = fopen(filename, "wb");
 		}
 	}
@@ -1129,8 +1172,13 @@ ReceiveTarFile(PGconn *conn, PGresult *res, int rownum)
 				}
 			}
 
-			/* 2 * 512 bytes empty data at end of file */
-			WRITE_TAR_DATA(zerobuf, sizeof(zerobuf));
+			/*
+			 * 2 * 512 bytes empty data at end of file.  When the server
+			 * compresses the stream it includes this trailer in the
+			 * compressed data itself, since we cannot append to it here.
+			 */
+			if (server_compression == SERVER_COMPRESSION_NONE)
+				WRITE_TAR_DATA(zerobuf, sizeof(zerobuf));
 
 #ifdef HAVE_LIBZ
 			if (ztarfile != NULL)
@@ -1372,6 +1420,401 @@ get_tablespace_mapping(const char *dir)
 }
 
 
+/*
+ * Re-framing states for tar data recovered from a compressed stream.
+ */
+typedef enum
+{
+	TAR_FRAME_HEADER,
+	TAR_FRAME_CONTENT,
+	TAR_FRAME_PADDING,
+	TAR_FRAME_TRAILER
+} TarFrameState;
+
+/*
+ * State carried across the chunks of one tar stream while unpacking it into
+ * the target directory.
+ */
+typedef struct UnpackTarState
+{
+	int			rownum;
+	char		current_path[MAXPGPATH];
+	char		filename[MAXPGPATH];
+	pgoff_t		current_len_left;
+	int			current_padding;
+	FILE	   *file;
+
+	/*
+	 * When the server compresses the stream, the decompressed data comes out
+	 * with arbitrary boundaries, while UnpackTarChunk() relies on the
+	 * server's framing: each tar header arrives as a chunk of exactly 512
+	 * bytes, file contents never cross into the next header, and padding
+	 * arrives as a chunk of its own.  These fields track the position within
+	 * the tar stream so that ReframeTarData() can restore those boundaries.
+	 */
+	TarFrameState frame_state;
+	char		frame_hdr[512];
+	size_t		frame_hdrlen;
+	pgoff_t		frame_len_left;
+	size_t		frame_padding;
+	char		frame_padbuf[512];
+	size_t		frame_padlen;
+} UnpackTarState;
+
+/* Decompression state for a server-compressed stream, one tar at a time */
+#ifdef USE_LZ4
+static LZ4F_decompressionContext_t lz4_dctx = NULL;
+#endif
+#ifdef USE_ZSTD
+static ZSTD_DStream *zstd_dstream = NULL;
+#endif
+
+/*
+ * Unpack one chunk of tar data into the target directory.  The chunk
+ * boundaries must follow the server's framing of the stream; see
+ * ReframeTarData().
+ */
+static void
+UnpackTarChunk(const char *copybuf, int r, UnpackTarState *state)
+{
+	const char *mapped_tblspc_path;
+
+	if (state->file == NULL)
+	{
+#ifndef WIN32
+		int			filemode;
+#endif
+
+		/*
+		 * No current file, so this must be the header for a new file
+		 */
+		if (r != 512)
+		{
+			pg_log_error("invalid tar block header size: %d", r);
+			exit(1);
+		}
+		totaldone += 512;
+
+		state->current_len_left = read_tar_number(&copybuf[124], 12);
+
+#ifndef WIN32
+		/* Set permissions on the file */
+		filemode = read_tar_number(&copybuf[100], 8);
+#endif
+
+		/*
+		 * All files are padded up to 512 bytes
+		 */
+		state->current_padding =
+			((state->current_len_left + 511) & ~511) - state->current_len_left;
+
+		/*
+		 * First part of header is zero terminated filename
+		 */
+		snprintf(state->filename, sizeof(state->filename), "%s/%s",
+				 state->current_path, copybuf);
+		if (state->filename[strlen(state->filename) - 1] == '/')
+		{
+			/*
+			 * Ends in a slash means directory or symlink to directory
+			 */
+			if (copybuf[156] == '5')
+			{
+				/*
+				 * Directory
+				 */
+				state->filename[strlen(state->filename) - 1] = '\0';	/* Remove trailing slash */
+				if (mkdir(state->filename, pg_dir_create_mode) != 0)
+				{
+					/*
+					 * When streaming WAL, pg_wal (or pg_xlog for pre-9.6
+					 * clusters) will have been created by the wal receiver
+					 * process. Also, when the WAL directory location was
+					 * specified, pg_wal (or pg_xlog) has already been created
+					 * as a symbolic link before starting the actual backup.
+					 * So just ignore creation failures on related
+					 * directories.
+					 */
+					if (!((pg_str_endswith(state->filename, "/pg_wal") ||
+						   pg_str_endswith(state->filename, "/pg_xlog") ||
+						   pg_str_endswith(state->filename, "/archive_status")) &&
+						  errno == EEXIST))
+					{
+						pg_log_error("could not create directory \"%s\": %m",
+									 state->filename);
+						exit(1);
+					}
+				}
+#ifndef WIN32
+				if (chmod(state->filename, (mode_t) filemode))
+					pg_log_error("could not set permissions on directory \"%s\": %m",
+								 state->filename);
+#endif
+			}
+			else if (copybuf[156] == '2')
+			{
+				/*
+				 * Symbolic link
+				 *
+				 * It's most likely a link in pg_tblspc directory, to the
+				 * location of a tablespace. Apply any tablespace mapping
+				 * given on the command line (--tablespace-mapping). (We
+				 * blindly apply the mapping without checking that the link
+				 * really is inside pg_tblspc. We don't expect there to be
+				 * other symlinks in a data directory, but if there are, you
+				 * can call it an undocumented feature that you can map them
+				 * too.)
+				 */
+				state->filename[strlen(state->filename) - 1] = '\0';	/* Remove trailing slash */
+
+				mapped_tblspc_path = get_tablespace_mapping(&copybuf[157]);
+				if (symlink(mapped_tblspc_path, state->filename) != 0)
+				{
+					pg_log_error("could not create symbolic link from \"%s\" to \"%s\": %m",
+								 state->filename, mapped_tblspc_path);
+					exit(1);
+				}
+			}
+			else
+			{
+				pg_log_error("unrecognized link indicator \"%c\"",
+							 copybuf[156]);
+				exit(1);
+			}
+			return;				/* directory or link handled */
+		}
+
+		/*
+		 * regular file
+		 */
+		state->file = fopen(state->filename, "wb");
+		if (!state->file)
+		{
+			pg_log_error("could not create file \"%s\": %m", state->filename);
+			exit(1);
+		}
+
+#ifndef WIN32
+		if (chmod(state->filename, (mode_t) filemode))
+			pg_log_error("could not set permissions on file \"%s\": %m",
+						 state->filename);
+#endif
+
+		if (state->current_len_left == 0)
+		{
+			/*
+			 * Done with this file, next one will be a new tar header
+			 */
+			fclose(state->file);
+			state->file = NULL;
+			return;
+		}
+	}							/* new file */
+	else
+	{
+		/*
+		 * Continuing blocks in existing file
+		 */
+		if (state->current_len_left == 0 && r == state->current_padding)
+		{
+			/*
+			 * Received the padding block for this file, ignore it and close
+			 * the file, then move on to the next tar header.
+			 */
+			fclose(state->file);
+			state->file = NULL;
+			totaldone += r;
+			return;
+		}
+
+		if (fwrite(copybuf, r, 1, state->file) != 1)
+		{
+			pg_log_error("could not write to file \"%s\": %m", state->filename);
+			exit(1);
+		}
+		totaldone += r;
+		progress_report(state->rownum, state->filename, false);
+
+		state->current_len_left -= r;
+		if (state->current_len_left == 0 && state->current_padding == 0)
+		{
+			/*
+			 * Received the last block, and there is no padding to be
+			 * expected. Close the file and move on to the next tar header.
+			 */
+			fclose(state->file);
+			state->file = NULL;
+			return;
+		}
+	}							/* continuing data in existing file */
+}
+
+#if defined(USE_LZ4) || defined(USE_ZSTD)
+/*
+ * Deliver tar data recovered from a compressed stream to UnpackTarChunk(),
+ * restoring the chunk boundaries it expects: each header as exactly 512
+ * bytes, file contents never crossing into the following header, and padding
+ * as a chunk of its own.  The tar trailer the server appends to a compressed
+ * stream is recognized and discarded here.
+ */
+static void
+ReframeTarData(const char *data, size_t len, UnpackTarState *state)
+{
+	while (len > 0)
+	{
+		size_t		chunk;
+
+		switch (state->frame_state)
+		{
+			case TAR_FRAME_HEADER:
+				chunk = Min(len, 512 - state->frame_hdrlen);
+				memcpy(state->frame_hdr + state->frame_hdrlen, data, chunk);
+				state->frame_hdrlen += chunk;
+				data += chunk;
+				len -= chunk;
+
+				if (state->frame_hdrlen < 512)
+					break;
+
+				state->frame_hdrlen = 0;
+
+				/* An all-zero header starts the end-of-archive trailer */
+				{
+					int			i;
+
+					for (i = 0; i < 512; i++)
+						if (state->frame_hdr[i] != 0)
+							break;
+					if (i == 512)
+					{
+						state->frame_state = TAR_FRAME_TRAILER;
+						break;
+					}
+				}
+
+				state->frame_len_left = read_tar_number(&state->frame_hdr[124], 12);
+				state->frame_padding =
+					((state->frame_len_left + 511) & ~511) - state->frame_len_left;
+
+				UnpackTarChunk(state->frame_hdr, 512, state);
+
+				if (state->frame_len_left > 0)
+					state->frame_state = TAR_FRAME_CONTENT;
+				else if (state->frame_padding > 0)
+					state->frame_state = TAR_FRAME_PADDING;
+				break;
+
+			case TAR_FRAME_CONTENT:
+				chunk = Min(len, (size_t) state->frame_len_left);
+				UnpackTarChunk(data, chunk, state);
+				state->frame_len_left -= chunk;
+				data += chunk;
+				len -= chunk;
+
+				if (state->frame_len_left == 0)
+					state->frame_state = state->frame_padding > 0 ?
+						TAR_FRAME_PADDING : TAR_FRAME_HEADER;
+				break;
+
+			case TAR_FRAME_PADDING:
+				chunk = Min(len, state->frame_padding - state->frame_padlen);
+				memcpy(state->frame_padbuf + state->frame_padlen, data, chunk);
+				state->frame_padlen += chunk;
+				data += chunk;
+				len -= chunk;
+
+				if (state->frame_padlen == state->frame_padding)
+				{
+					UnpackTarChunk(state->frame_padbuf,
+								   state->frame_padding, state);
+					state->frame_padlen = 0;
+					state->frame_state = TAR_FRAME_HEADER;
+				}
+				break;
+
+			case TAR_FRAME_TRAILER:
+				/* Ignore everything after the trailer */
+				len = 0;
+				break;
+		}
+	}
+}
+#endif							/* USE_LZ4 || USE_ZSTD */
+
+/*
+ * Feed one CopyData chunk of the backup stream into the unpacker,
+ * decompressing it first if the server compressed the stream.
+ */
+static void
+DecompressTarData(const char *copybuf, int r, UnpackTarState *state)
+{
+	switch (server_compression)
+	{
+		case SERVER_COMPRESSION_NONE:
+			UnpackTarChunk(copybuf, r, state);
+			break;
+
+#ifdef USE_LZ4
+		case SERVER_COMPRESSION_LZ4:
+			{
+				size_t		pos = 0;
+
+				while (pos < (size_t) r)
+				{
+					char		outbuf[65536];
+					size_t		outlen = sizeof(outbuf);
+					size_t		inlen = r - pos;
+					size_t		ret;
+
+					ret = LZ4F_decompress(lz4_dctx, outbuf, &outlen,
+										  copybuf + pos, &inlen, NULL);
+					if (LZ4F_isError(ret))
+					{
+						pg_log_error("could not decompress data: %s",
+									 LZ4F_getErrorName(ret));
+						exit(1);
+					}
+					pos += inlen;
+					if (outlen > 0)
+						ReframeTarData(outbuf, outlen, state);
+					if (inlen == 0 && outlen == 0)
+						break;
+				}
+				break;
+			}
+#endif
+
+#ifdef USE_ZSTD
+		case SERVER_COMPRESSION_ZSTD:
+			{
+				ZSTD_inBuffer inbuf = {copybuf, (size_t) r, 0};
+
+				while (inbuf.pos < inbuf.size)
+				{
+					char		outspace[65536];
+					ZSTD_outBuffer outbuf = {outspace, sizeof(outspace), 0};
+					size_t		ret;
+
+					ret = ZSTD_decompressStream(zstd_dstream, &outbuf, &inbuf);
+					if (ZSTD_isError(ret))
+					{
+						pg_log_error("could not decompress data: %s",
+									 ZSTD_getErrorName(ret));
+						exit(1);
+					}
+					if (outbuf.pos > 0)
+						ReframeTarData(outspace, outbuf.pos, state);
+				}
+				break;
+			}
+#endif
+
+		default:
+			pg_log_error("unsupported server compression method");
+			exit(1);
+	}
+}
+
 /*
  * Receive a tar format stream from the connection to the server, and unpack
  * the contents of it into a directory. Only files, directories and
@@ -1384,22 +1827,45 @@ get_tablespace_mapping(const char *dir)
 static void
 ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 {
-	char		current_path[MAXPGPATH];
-	char		filename[MAXPGPATH];
-	const char *mapped_tblspc_path;
-	pgoff_t		current_len_left = 0;
-	int			current_padding = 0;
 	bool		basetablespace;
 	char	   *copybuf = NULL;
-	FILE	   *file = NULL;
+	UnpackTarState state;
+
+	memset(&state, 0, sizeof(state));
+	state.rownum = rownum;
 
 	basetablespace = PQgetisnull(res, rownum, 0);
 	if (basetablespace)
-		strlcpy(current_path, basedir, sizeof(current_path));
+		strlcpy(state.current_path, basedir, sizeof(state.current_path));
 	else
-		strlcpy(current_path,
+		strlcpy(state.current_path,
 				get_tablespace_mapping(PQgetvalue(res, rownum, 1)),
-				sizeof(current_path));
+				sizeof(state.current_path));
+
+	/* Each tablespace's tar is a separate compressed stream */
+#ifdef USE_LZ4
+	if (server_compression == SERVER_COMPRESSION_LZ4)
+	{
+		if (LZ4F_isError(LZ4F_createDecompressionContext(&lz4_dctx,
+														 LZ4F_VERSION)))
+		{
+			pg_log_error("could not create LZ4 decompression context");
+			exit(1);
+		}
+	}
+#endif
+#ifdef USE_ZSTD
+	if (server_compression == SERVER_COMPRESSION_ZSTD)
+	{
+		zstd_dstream = ZSTD_createDStream();
+		if (zstd_dstream == NULL)
+		{
+			pg_log_error("could not create zstd decompression stream");
+			exit(1);
+		}
+		ZSTD_initDStream(zstd_dstream);
+	}
+#endif
 
 	/*
 	 * Get the COPY data
@@ -1429,8 +1895,8 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 			/*
 			 * End of chunk
 			 */
-			if (file)
-				fclose(file);
+			if (state.file)
+				fclose(state.file);
 
 			break;
 		}
@@ -1441,179 +1907,26 @@ ReceiveAndUnpackTarFile(PGconn *conn, PGresult *res, int rownum)
 			exit(1);
 		}
 
-		if (file == NULL)
-		{
-#ifndef WIN32
-			int			filemode;
-#endif
-
-			/*
-			 * No current file, so this must be the header for a new file
-			 */
-			if (r != 512)
-			{
-				pg_log_error("invalid tar block header size: %d", r);
-				exit(1);
-			}
-			totaldone += 512;
-
-			current_len_left = read_tar_number(&copybuf[124], 12);
-
-#ifndef WIN32
-			/* Set permissions on the file */
-			filemode = read_tar_number(&copybuf[100], 8);
-#endif
-
-			/*
-			 * All files are padded up to 512 bytes
-			 */
-			current_padding =
-				((current_len_left + 511) & ~511) - current_len_left;
+		DecompressTarData(copybuf, r, &state);
+	}							/* loop over all data blocks */
+	progress_report(rownum, state.filename, true);
 
-			/*
-			 * First part of header is zero terminated filename
-			 */
-			snprintf(filename, sizeof(filename), "%s/%s", current_path,
-					 copybuf);
-			if (filename[strlen(filename) - 1] == '/')
-			{
-				/*
-				 * Ends in a slash means directory or symlink to directory
-				 */
-				if (copybuf[156] == '5')
-				{
-					/*
-					 * Directory
-					 */
-					filename[strlen(filename) - 1] = '\0';	/* Remove trailing slash */
-					if (mkdir(filename, pg_dir_create_mode) != 0)
-					{
-						/*
-						 * When streaming WAL, pg_wal (or pg_xlog for pre-9.6
-						 * clusters) will have been created by the wal
-						 * receiver process. Also, when the WAL directory
-						 * location was specified, pg_wal (or pg_xlog) has
-						 * already been created as a symbolic link before
-						 * starting the actual backup. So just ignore creation
-						 * failures on related directories.
-						 */
-						if (!((pg_str_endswith(filename, "/pg_wal") ||
-							   pg_str_endswith(filename, "/pg_xlog") ||
-							   pg_str_endswith(filename, "/archive_status")) &&
-							  errno == EEXIST))
-						{
-							pg_log_error("could not create directory \"%s\": %m",
-										 filename);
-							exit(1);
-						}
-					}
-#ifndef WIN32
-					if (chmod(filename, (mode_t) filemode))
-						pg_log_error("could not set permissions on directory \"%s\": %m",
-									 filename);
+#ifdef USE_LZ4
+	if (lz4_dctx != NULL)
+	{
+		LZ4F_freeDecompressionContext(lz4_dctx);
+		lz4_dctx = NULL;
+	}
 #endif
-				}
-				else if (copybuf[156] == '2')
-				{
-					/*
-					 * Symbolic link
-					 *
-					 * It's most likely a link in pg_tblspc directory, to the
-					 * location of a tablespace. Apply any tablespace mapping
-					 * given on the command line (--tablespace-mapping). (We
-					 * blindly apply the mapping without checking that the
-					 * link really is inside pg_tblspc. We don't expect there
-					 * to be other symlinks in a data directory, but if there
-					 * are, you can call it an undocumented feature that you
-					 * can map them too.)
-					 */
-					filename[strlen(filename) - 1] = '\0';	/* Remove trailing slash */
-
-					mapped_tblspc_path = get_tablespace_mapping(&copybuf[157]);
-					if (symlink(mapped_tblspc_path, filename) != 0)
-					{
-						pg_log_error("could not create symbolic link from \"%s\" to \"%s\": %m",
-									 filename, mapped_tblspc_path);
-						exit(1);
-					}
-				}
-				else
-				{
-					pg_log_error("unrecognized link indicator \"%c\"",
-								 copybuf[156]);
-					exit(1);
-				}
-				continue;		/* directory or link handled */
-			}
-
-			/*
-			 * regular file
-			 */
-			file = fopen(filename, "wb");
-			if (!file)
-			{
-				pg_log_error("could not create file \"%s\": %m", filename);
-				exit(1);
-			}
-
-#ifndef WIN32
-			if (chmod(filename, (mode_t) filemode))
-				pg_log_error("could not set permissions on file \"%s\": %m",
-							 filename);
+#ifdef USE_ZSTD
+	if (zstd_dstream != NULL)
+	{
+		ZSTD_freeDStream(zstd_dstream);
+		zstd_dstream = NULL;
+	}
 #endif
 
-			if (current_len_left == 0)
-			{
-				/*
-				 * Done with this file, next one will be a new tar header
-				 */
-				fclose(file);
-				file = NULL;
-				continue;
-			}
-		}						/* new file */
-		else
-		{
-			/*
-			 * Continuing blocks in existing file
-			 */
-			if (current_len_left == 0 && r == current_padding)
-			{
-				/*
-				 * Received the padding block for this file, ignore it and
-				 * close the file, then move on to the next tar header.
-				 */
-				fclose(file);
-				file = NULL;
-				totaldone += r;
-				continue;
-			}
-
-			if (fwrite(copybuf, r, 1, file) != 1)
-			{
-				pg_log_error("could not write to file \"%s\": %m", filename);
-				exit(1);
-			}
-			totaldone += r;
-			progress_report(rownum, filename, false);
-
-			current_len_left -= r;
-			if (current_len_left == 0 && current_padding == 0)
-			{
-				/*
-				 * Received the last block, and there is no padding to be
-				 * expected. Close the file and move on to the next tar
-				 * header.
-				 */
-				fclose(file);
-				file = NULL;
-				continue;
-			}
-		}						/* continuing data in existing file */
-	}							/* loop over all data blocks */
-	progress_report(rownum, filename, true);
-
-	if (file != NULL)
+	if (state.file != NULL)
 	{
 		pg_log_error("COPY stream ended before last file was finished");
 		exit(1);
@@ -1642,6 +1955,7 @@ BaseBackup(void)
 	char	   *basebkp;
 	char		escaped_label[MAXPGPATH];
 	char	   *maxrate_clause = NULL;
+	const char *compression_clause = "";
 	int			i;
 	char		xlogstart[64];
 	char		xlogend[64];
@@ -1703,6 +2017,18 @@ BaseBackup(void)
 	if (maxrate > 0)
 		maxrate_clause = psprintf("MAX_RATE %u", maxrate);
 
+	if (server_compression != SERVER_COMPRESSION_NONE)
+	{
+		if (serverVersion < MINIMUM_VERSION_FOR_SERVER_COMPRESSION)
+		{
+			pg_log_error("server-side compression is not supported by server version %s",
+						 PQparameterStatus(conn, "server_version"));
+			exit(1);
+		}
+		compression_clause = server_compression == SERVER_COMPRESSION_LZ4 ?
+			"COMPRESSION 'lz4'" : "COMPRESSION 'zstd'";
+	}
+
 	if (verbose)
 		pg_log_info("initiating base backup, waiting for checkpoint to complete");
 
@@ -1716,7 +2042,7 @@ BaseBackup(void)
 	}
 
 	basebkp =
-		psprintf("BASE_BACKUP LABEL '%s' %s %s %s %s %s %s %s",
+		psprintf("BASE_BACKUP LABEL '%s' %s %s %s %s %s %s %s %s",
 				 escaped_label,
 				 showprogress ? "PROGRESS" : "",
 				 includewal == FETCH_WAL ? "WAL" : "",
@@ -1724,7 +2050,8 @@ BaseBackup(void)
 				 includewal == NO_WAL ? "" : "NOWAIT",
 				 maxrate_clause ? maxrate_clause : "",
 				 format == 't' ? "TABLESPACE_MAP" : "",
-				 verify_checksums ? "" : "NOVERIFY_CHECKSUMS");
+				 verify_checksums ? "" : "NOVERIFY_CHECKSUMS",
+				 compression_clause);
 
 	if (PQsendQuery(conn, basebkp) == 0)
 	{
@@ -2043,6 +2370,7 @@ main(int argc, char **argv)
 		{"waldir", required_argument, NULL, 1},
 		{"no-slot", no_argument, NULL, 2},
 		{"no-verify-checksums", no_argument, NULL, 3},
+		{"server-compression", required_argument, NULL, 4},
 		{NULL, 0, NULL, 0}
 	};
 	int			c;
@@ -2211,6 +2539,20 @@ main(int argc, char **argv)
 			case 3:
 				verify_checksums = false;
 				break;
+			case 4:
+				if (strcmp(optarg, "none") == 0)
+					server_compression = SERVER_COMPRESSION_NONE;
+				else if (strcmp(optarg, "lz4") == 0)
+					server_compression = SERVER_COMPRESSION_LZ4;
+				else if (strcmp(optarg, "zstd") == 0)
+					server_compression = SERVER_COMPRESSION_ZSTD;
+				else
+				{
+					pg_log_error("invalid server compression method \"%s\", must be \"none\", \"lz4\", or \"zstd\"",
+								 optarg);
+					exit(1);
+				}
+				break;
 			default:
 
 				/*
@@ -2256,6 +2598,23 @@ main(int argc, char **argv)
 		exit(1);
 	}
 
+	if (server_compression != SERVER_COMPRESSION_NONE && compresslevel != 0)
+	{
+		pg_log_error("--server-compression cannot be used together with client-side compression");
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+				progname);
+		exit(1);
+	}
+
+	if (server_compression != SERVER_COMPRESSION_NONE &&
+		format == 't' && writerecoveryconf)
+	{
+		pg_log_error("cannot write recovery configuration into a server-compressed tar archive");
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"),
+				progname);
+		exit(1);
+	}
+
 	if (format == 't' && includewal == STREAM_WAL && strcmp(basedir, "-") == 0)
 	{
 		pg_log_error("cannot stream write-ahead logs in tar mode to stdout");
@@ -2333,6 +2692,25 @@ main(int argc, char **argv)
 	}
 #endif
 
+	/*
+	 * A tar format backup just stores the compressed stream as received, but
+	 * a plain format backup must decompress it to unpack the files.
+	 */
+#ifndef USE_LZ4
+	if (server_compression == SERVER_COMPRESSION_LZ4 && format == 'p')
+	{
+		pg_log_error("this build does not support LZ4 decompression");
+		exit(1);
+	}
+#endif
+#ifndef USE_ZSTD
+	if (server_compression == SERVER_COMPRESSION_ZSTD && format == 'p')
+	{
+		pg_log_error("this build does not support zstd decompression");
+		exit(1);
+	}
+#endif
+
 	/* connection in replication mode to server */
 	conn = GetConnection();
 	if (!conn)
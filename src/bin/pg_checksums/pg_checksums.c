@@ -342,7 +342,8 @@ scan_directory(const char *basedir, const char *subdir, bool sizeonly)
 				if (strstr(segmentpath, "undo"))
 					first_blkno = strtol(segmentpath, &end, 16) / BLCKSZ;
 				else
-					first_blkno = strtol(segmentpath, &end, 10) * RELSEG_SIZE;
+					first_blkno = strtol(segmentpath, &end, 10) *
+						ControlFile->relseg_size;
 				if (*end != '\0')
 				{
 					pg_log_error("invalid segment number in file name \"%s\"",
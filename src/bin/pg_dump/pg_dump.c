@@ -143,6 +143,14 @@ static int	extra_float_digits;
  */
 #define DUMP_DEFAULT_ROWS_PER_INSERT 1
 
+/*
+ * With --table-segments, large tables are split into at most that many
+ * block-range segments, but never into segments of fewer than
+ * MIN_SEGMENT_PAGES pages; small tables aren't worth splitting.
+ */
+#define MAX_TABLE_SEGMENTS	256
+#define MIN_SEGMENT_PAGES	1024
+
 /*
  * Macro for producing quoted, schema-qualified name of a dumpable object.
  */
@@ -244,6 +252,8 @@ static void addBoundaryDependencies(DumpableObject **dobjs, int numObjs,
 static void getDomainConstraints(Archive *fout, TypeInfo *tyinfo);
 static void getTableData(DumpOptions *dopt, TableInfo *tblinfo, int numTables, char relkind);
 static void makeTableDataInfo(DumpOptions *dopt, TableInfo *tbinfo);
+static void makeTableDataSegments(DumpOptions *dopt, TableInfo *tbinfo);
+static int	tableDataNSegments(DumpOptions *dopt, TableInfo *tbinfo);
 static void buildMatViewRefreshDependencies(Archive *fout);
 static void getTableDataFKConstraints(void);
 static char *format_function_arguments(FuncInfo *finfo, char *funcargs,
@@ -390,6 +400,7 @@ main(int argc, char **argv)
 		{"no-subscriptions", no_argument, &dopt.no_subscriptions, 1},
 		{"no-sync", no_argument, NULL, 7},
 		{"on-conflict-do-nothing", no_argument, &dopt.do_nothing, 1},
+		{"table-segments", required_argument, NULL, 11},
 		{"rows-per-insert", required_argument, NULL, 10},
 
 		{NULL, 0, NULL, 0}
@@ -607,6 +618,17 @@ main(int argc, char **argv)
 				dopt.dump_inserts = (int) rowsPerInsert;
 				break;
 
+			case 11:			/* table segments */
+				dopt.table_segments = atoi(optarg);
+				if (dopt.table_segments < 1 ||
+					dopt.table_segments > MAX_TABLE_SEGMENTS)
+				{
+					pg_log_error("table-segments must be in range %d..%d",
+								 1, MAX_TABLE_SEGMENTS);
+					exit_nicely(1);
+				}
+				break;
+
 			default:
 				fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
 				exit_nicely(1);
@@ -1035,6 +1057,8 @@ help(const char *progname)
 	printf(_("  --snapshot=SNAPSHOT          use given snapshot for the dump\n"));
 	printf(_("  --strict-names               require table and/or schema include patterns to\n"
 			 "                               match at least one entity each\n"));
+	printf(_("  --table-segments=NUM         split large tables into up to NUM block-range\n"
+			 "                               segments, dumped independently\n"));
 	printf(_("  --use-set-session-authorization\n"
 			 "                               use SET SESSION AUTHORIZATION commands instead of\n"
 			 "                               ALTER OWNER commands to set ownership\n"));
@@ -2257,9 +2281,11 @@ dumpTableData(Archive *fout, TableDataInfo *tdinfo)
 		 * However, relpages is declared as "integer" in pg_class, and hence
 		 * also in TableInfo, but it's really BlockNumber a/k/a unsigned int.
 		 * Cast so that we get the right interpretation of table sizes
-		 * exceeding INT_MAX pages.
+		 * exceeding INT_MAX pages.  When the table is dumped in several
+		 * block-range segments, each entry covers only its own share.
 		 */
-		te->dataLength = (BlockNumber) tbinfo->relpages;
+		te->dataLength = (BlockNumber) tbinfo->relpages /
+			tableDataNSegments(fout->dopt, tbinfo);
 	}
 
 	destroyPQExpBuffer(copyBuf);
@@ -2317,7 +2343,10 @@ getTableData(DumpOptions *dopt, TableInfo *tblinfo, int numTables, char relkind)
 	{
 		if (tblinfo[i].dobj.dump & DUMP_COMPONENT_DATA &&
 			(!relkind || tblinfo[i].relkind == relkind))
+		{
 			makeTableDataInfo(dopt, &(tblinfo[i]));
+			makeTableDataSegments(dopt, &(tblinfo[i]));
+		}
 	}
 }
 
@@ -2385,6 +2414,80 @@ makeTableDataInfo(DumpOptions *dopt, TableInfo *tbinfo)
 	tbinfo->dataObj = tdinfo;
 }
 
+/*
+ * Compute how many block-range segments this table's data is dumped in.
+ */
+static int
+tableDataNSegments(DumpOptions *dopt, TableInfo *tbinfo)
+{
+	BlockNumber relpages = (BlockNumber) tbinfo->relpages;
+	int			nsegments;
+
+	if (dopt->table_segments <= 1 ||
+		tbinfo->relkind != RELKIND_RELATION)
+		return 1;
+
+	nsegments = Min((BlockNumber) dopt->table_segments,
+					relpages / MIN_SEGMENT_PAGES);
+	return Max(nsegments, 1);
+}
+
+/*
+ * With --table-segments, split a large table's data into several block-range
+ * segments, each an independent TABLE DATA entry dumped with a ctid range
+ * condition.  A parallel dump can then work on one table's segments
+ * concurrently, so dump time isn't bounded by the largest table.  The
+ * archive TOC serves as the manifest tying the segments back together; each
+ * one restores with a plain COPY, and they can be restored in parallel too.
+ *
+ * The primary TableDataInfo made by makeTableDataInfo becomes the first
+ * segment; the last segment's range is left open at the top so that blocks
+ * added after relpages was last updated are still dumped.
+ */
+static void
+makeTableDataSegments(DumpOptions *dopt, TableInfo *tbinfo)
+{
+	TableDataInfo *tdinfo = tbinfo->dataObj;
+	BlockNumber relpages = (BlockNumber) tbinfo->relpages;
+	BlockNumber segpages;
+	int			nsegments;
+	int			k;
+
+	nsegments = tableDataNSegments(dopt, tbinfo);
+	if (nsegments <= 1)
+		return;
+
+	/* Nothing to do if the table isn't dumped, or is dumped filtered. */
+	if (tdinfo == NULL ||
+		tdinfo->dobj.objType != DO_TABLE_DATA ||
+		tdinfo->filtercond != NULL)
+		return;
+
+	segpages = relpages / nsegments;
+
+	tdinfo->filtercond = psprintf("WHERE ctid < '(%u,0)'", segpages);
+
+	for (k = 1; k < nsegments; k++)
+	{
+		TableDataInfo *seginfo;
+
+		seginfo = (TableDataInfo *) pg_malloc(sizeof(TableDataInfo));
+		*seginfo = *tdinfo;
+		AssignDumpId(&seginfo->dobj);
+		seginfo->dobj.dependencies = NULL;
+		seginfo->dobj.nDeps = 0;
+		seginfo->dobj.allocDeps = 0;
+		addObjectDependency(&seginfo->dobj, tbinfo->dobj.dumpId);
+
+		if (k == nsegments - 1)
+			seginfo->filtercond = psprintf("WHERE ctid >= '(%u,0)'",
+										   k * segpages);
+		else
+			seginfo->filtercond = psprintf("WHERE ctid >= '(%u,0)' AND ctid < '(%u,0)'",
+										   k * segpages, (k + 1) * segpages);
+	}
+}
+
 /*
  * The refresh for a materialized view must be dependent on the refresh for
  * any materialized view that this one is dependent on.
@@ -428,8 +428,8 @@ process_block_change(ForkNumber forknum, RelFileNode rnode, BlockNumber blkno)
 
 	Assert(map->array);
 
-	segno = blkno / RELSEG_SIZE;
-	blkno_inseg = blkno % RELSEG_SIZE;
+	segno = blkno / ControlFile_target.relseg_size;
+	blkno_inseg = blkno % ControlFile_target.relseg_size;
 
 	path = datasegpath(rnode, forknum, segno);
 
@@ -13,6 +13,9 @@
 #include <dirent.h>
 #include <fcntl.h>
 #include <unistd.h>
+#ifdef HAVE_SYS_SELECT_H
+#include <sys/select.h>
+#endif
 
 #include "pg_rewind.h"
 #include "datapagemap.h"
@@ -26,6 +29,16 @@
 
 PGconn *conn = NULL;
 
+/*
+ * Connections used to fetch file chunks.  The first one is the main
+ * connection, 'conn' above; with -j, additional connections fetch disjoint
+ * subsets of the chunk list concurrently.  Everything other than chunk
+ * fetching goes through the main connection only.
+ */
+static PGconn *fetch_conns[MAX_REWIND_JOBS];
+static int	n_fetch_conns = 0;
+static int	next_fetch_conn = 0;
+
 /*
  * Files are fetched max CHUNKSIZE bytes at a time.
  *
@@ -36,15 +49,17 @@ PGconn *conn = NULL;
 #define CHUNKSIZE 1000000
 
 static void receiveFileChunks(const char *sql);
+static void process_file_chunk(PGresult *res);
 static void execute_pagemap(datapagemap_t *pagemap, const char *path);
 static char *run_simple_query(const char *sql);
-static void run_simple_command(const char *sql);
+static void run_simple_command(PGconn *conn, const char *sql);
 
 void
 libpqConnect(const char *connstr)
 {
 	char	   *str;
 	PGresult   *res;
+	int			i;
 
 	conn = PQconnectdb(connstr);
 	if (PQstatus(conn) == CONNECTION_BAD)
@@ -54,16 +69,35 @@ libpqConnect(const char *connstr)
 	if (showprogress)
 		pg_log_info("connected to server");
 
-	/* disable all types of timeouts */
-	run_simple_command("SET statement_timeout = 0");
-	run_simple_command("SET lock_timeout = 0");
-	run_simple_command("SET idle_in_transaction_session_timeout = 0");
+	/*
+	 * Open any additional connections used to fetch file chunks in
+	 * parallel.
+	 */
+	fetch_conns[0] = conn;
+	n_fetch_conns = 1;
+	while (n_fetch_conns < rewind_jobs)
+	{
+		PGconn	   *fconn = PQconnectdb(connstr);
 
-	res = PQexec(conn, ALWAYS_SECURE_SEARCH_PATH_SQL);
-	if (PQresultStatus(res) != PGRES_TUPLES_OK)
-		pg_fatal("could not clear search_path: %s",
-				 PQresultErrorMessage(res));
-	PQclear(res);
+		if (PQstatus(fconn) == CONNECTION_BAD)
+			pg_fatal("could not connect to server: %s",
+					 PQerrorMessage(fconn));
+		fetch_conns[n_fetch_conns++] = fconn;
+	}
+
+	for (i = 0; i < n_fetch_conns; i++)
+	{
+		/* disable all types of timeouts */
+		run_simple_command(fetch_conns[i], "SET statement_timeout = 0");
+		run_simple_command(fetch_conns[i], "SET lock_timeout = 0");
+		run_simple_command(fetch_conns[i], "SET idle_in_transaction_session_timeout = 0");
+
+		res = PQexec(fetch_conns[i], ALWAYS_SECURE_SEARCH_PATH_SQL);
+		if (PQresultStatus(res) != PGRES_TUPLES_OK)
+			pg_fatal("could not clear search_path: %s",
+					 PQresultErrorMessage(res));
+		PQclear(res);
+	}
 
 	/*
 	 * Check that the server is not in hot standby mode. There is no
@@ -93,7 +127,8 @@ libpqConnect(const char *connstr)
 	 * replication, and replication isn't working for some reason, we don't
 	 * want to get stuck, waiting for it to start working again.
 	 */
-	run_simple_command("SET synchronous_commit = off");
+	for (i = 0; i < n_fetch_conns; i++)
+		run_simple_command(fetch_conns[i], "SET synchronous_commit = off");
 }
 
 /*
@@ -128,7 +163,7 @@ run_simple_query(const char *sql)
  * In the event of a failure, exit immediately.
  */
 static void
-run_simple_command(const char *sql)
+run_simple_command(PGconn *conn, const char *sql)
 {
 	PGresult   *res;
 
@@ -255,107 +290,181 @@ libpqProcessFileList(void)
 static void
 receiveFileChunks(const char *sql)
 {
-	PGresult   *res;
-
-	if (PQsendQueryParams(conn, sql, 0, NULL, NULL, NULL, NULL, 1) != 1)
-		pg_fatal("could not send query: %s", PQerrorMessage(conn));
-
-	pg_log_debug("getting file chunks");
-
-	if (PQsetSingleRowMode(conn) != 1)
-		pg_fatal("could not set libpq connection to single row mode");
+	bool		active[MAX_REWIND_JOBS];
+	int			nactive;
+	int			i;
 
-	while ((res = PQgetResult(conn)) != NULL)
+	for (i = 0; i < n_fetch_conns; i++)
 	{
-		char	   *filename;
-		int			filenamelen;
-		int64		chunkoff;
-		int			chunksize;
-		char	   *chunk;
+		if (PQsendQueryParams(fetch_conns[i], sql, 0, NULL, NULL, NULL, NULL, 1) != 1)
+			pg_fatal("could not send query: %s",
+					 PQerrorMessage(fetch_conns[i]));
 
-		switch (PQresultStatus(res))
-		{
-			case PGRES_SINGLE_TUPLE:
-				break;
+		if (PQsetSingleRowMode(fetch_conns[i]) != 1)
+			pg_fatal("could not set libpq connection to single row mode");
 
-			case PGRES_TUPLES_OK:
-				PQclear(res);
-				continue;		/* final zero-row result */
+		active[i] = true;
+	}
+	nactive = n_fetch_conns;
 
-			default:
-				pg_fatal("unexpected result while fetching remote files: %s",
-						 PQresultErrorMessage(res));
-		}
+	pg_log_debug("getting file chunks");
 
-		/* sanity check the result set */
-		if (PQnfields(res) != 3 || PQntuples(res) != 1)
-			pg_fatal("unexpected result set size while fetching remote files");
+	/*
+	 * Consume the result streams of all connections in parallel, writing
+	 * out each chunk as it arrives.  The chunks assigned to one connection
+	 * arrive in order, so chunks belonging to the same file never conflict
+	 * even though the streams are interleaved arbitrarily.
+	 */
+	while (nactive > 0)
+	{
+		fd_set		readfds;
+		int			maxfd = -1;
 
-		if (PQftype(res, 0) != TEXTOID ||
-			PQftype(res, 1) != INT8OID ||
-			PQftype(res, 2) != BYTEAOID)
+		FD_ZERO(&readfds);
+		for (i = 0; i < n_fetch_conns; i++)
 		{
-			pg_fatal("unexpected data types in result set while fetching remote files: %u %u %u",
-					 PQftype(res, 0), PQftype(res, 1), PQftype(res, 2));
+			if (active[i])
+			{
+				int			sock = PQsocket(fetch_conns[i]);
+
+				if (sock < 0)
+					pg_fatal("invalid socket while fetching remote files: %s",
+							 PQerrorMessage(fetch_conns[i]));
+				FD_SET(sock, &readfds);
+				maxfd = Max(maxfd, sock);
+			}
 		}
 
-		if (PQfformat(res, 0) != 1 &&
-			PQfformat(res, 1) != 1 &&
-			PQfformat(res, 2) != 1)
+		if (select(maxfd + 1, &readfds, NULL, NULL, NULL) < 0)
 		{
-			pg_fatal("unexpected result format while fetching remote files");
+			if (errno == EINTR)
+				continue;
+			pg_fatal("select() failed: %m");
 		}
 
-		if (PQgetisnull(res, 0, 0) ||
-			PQgetisnull(res, 0, 1))
+		for (i = 0; i < n_fetch_conns; i++)
 		{
-			pg_fatal("unexpected null values in result while fetching remote files");
+			PGconn	   *fconn = fetch_conns[i];
+
+			if (!active[i] || !FD_ISSET(PQsocket(fconn), &readfds))
+				continue;
+
+			if (PQconsumeInput(fconn) == 0)
+				pg_fatal("unexpected result while fetching remote files: %s",
+						 PQerrorMessage(fconn));
+
+			while (active[i] && !PQisBusy(fconn))
+			{
+				PGresult   *res = PQgetResult(fconn);
+
+				if (res == NULL)
+				{
+					/* this connection has delivered all of its chunks */
+					active[i] = false;
+					nactive--;
+				}
+				else
+					process_file_chunk(res);
+			}
 		}
+	}
+}
 
-		if (PQgetlength(res, 0, 1) != sizeof(int64))
-			pg_fatal("unexpected result length while fetching remote files");
-
-		/* Read result set to local variables */
-		memcpy(&chunkoff, PQgetvalue(res, 0, 1), sizeof(int64));
-		chunkoff = pg_ntoh64(chunkoff);
-		chunksize = PQgetlength(res, 0, 2);
-
-		filenamelen = PQgetlength(res, 0, 0);
-		filename = pg_malloc(filenamelen + 1);
-		memcpy(filename, PQgetvalue(res, 0, 0), filenamelen);
-		filename[filenamelen] = '\0';
-
-		chunk = PQgetvalue(res, 0, 2);
-
-		/*
-		 * If a file has been deleted on the source, remove it on the target
-		 * as well.  Note that multiple unlink() calls may happen on the same
-		 * file if multiple data chunks are associated with it, hence ignore
-		 * unconditionally anything missing.  If this file is not a relation
-		 * data file, then it has been already truncated when creating the
-		 * file chunk list at the previous execution of the filemap.
-		 */
-		if (PQgetisnull(res, 0, 2))
-		{
-			pg_log_debug("received null value for chunk for file \"%s\", file has been deleted",
-						 filename);
-			remove_target_file(filename, true);
-			pg_free(filename);
+/*
+ * Handle one row of the chunk result set: write the chunk to the target
+ * file, or propagate a deletion.  Takes ownership of 'res'.
+ */
+static void
+process_file_chunk(PGresult *res)
+{
+	char	   *filename;
+	int			filenamelen;
+	int64		chunkoff;
+	int			chunksize;
+	char	   *chunk;
+
+	switch (PQresultStatus(res))
+	{
+		case PGRES_SINGLE_TUPLE:
+			break;
+
+		case PGRES_TUPLES_OK:
 			PQclear(res);
-			continue;
-		}
+			return;				/* final zero-row result */
 
-		pg_log_debug("received chunk for file \"%s\", offset %lld, size %d",
-					 filename, (long long int) chunkoff, chunksize);
+		default:
+			pg_fatal("unexpected result while fetching remote files: %s",
+					 PQresultErrorMessage(res));
+	}
 
-		open_target_file(filename, false);
+	/* sanity check the result set */
+	if (PQnfields(res) != 3 || PQntuples(res) != 1)
+		pg_fatal("unexpected result set size while fetching remote files");
 
-		write_target_range(chunk, chunkoff, chunksize);
+	if (PQftype(res, 0) != TEXTOID ||
+		PQftype(res, 1) != INT8OID ||
+		PQftype(res, 2) != BYTEAOID)
+	{
+		pg_fatal("unexpected data types in result set while fetching remote files: %u %u %u",
+				 PQftype(res, 0), PQftype(res, 1), PQftype(res, 2));
+	}
 
-		pg_free(filename);
+	if (PQfformat(res, 0) != 1 &&
+		PQfformat(res, 1) != 1 &&
+		PQfformat(res, 2) != 1)
+	{
+		pg_fatal("unexpected result format while fetching remote files");
+	}
+
+	if (PQgetisnull(res, 0, 0) ||
+		PQgetisnull(res, 0, 1))
+	{
+		pg_fatal("unexpected null values in result while fetching remote files");
+	}
+
+	if (PQgetlength(res, 0, 1) != sizeof(int64))
+		pg_fatal("unexpected result length while fetching remote files");
+
+	/* Read result set to local variables */
+	memcpy(&chunkoff, PQgetvalue(res, 0, 1), sizeof(int64));
+	chunkoff = pg_ntoh64(chunkoff);
+	chunksize = PQgetlength(res, 0, 2);
+
+	filenamelen = PQgetlength(res, 0, 0);
+	filename = pg_malloc(filenamelen + 1);
+	memcpy(filename, PQgetvalue(res, 0, 0), filenamelen);
+	filename[filenamelen] = '\0';
+
+	chunk = PQgetvalue(res, 0, 2);
 
+	/*
+	 * If a file has been deleted on the source, remove it on the target
+	 * as well.  Note that multiple unlink() calls may happen on the same
+	 * file if multiple data chunks are associated with it, hence ignore
+	 * unconditionally anything missing.  If this file is not a relation
+	 * data file, then it has been already truncated when creating the
+	 * file chunk list at the previous execution of the filemap.
+	 */
+	if (PQgetisnull(res, 0, 2))
+	{
+		pg_log_debug("received null value for chunk for file \"%s\", file has been deleted",
+					 filename);
+		remove_target_file(filename, true);
+		pg_free(filename);
 		PQclear(res);
+		return;
 	}
+
+	pg_log_debug("received chunk for file \"%s\", offset %lld, size %d",
+				 filename, (long long int) chunkoff, chunksize);
+
+	open_target_file(filename, false);
+
+	write_target_range(chunk, chunkoff, chunksize);
+
+	pg_free(filename);
+
+	PQclear(res);
 }
 
 /*
@@ -403,6 +512,9 @@ libpqGetFile(const char *filename, size_t *filesize)
  * The range is sent to the server as a COPY formatted line, to be inserted
  * into the 'fetchchunks' temporary table. It is used in receiveFileChunks()
  * function to actually fetch the data.
+ *
+ * Chunks are dealt out to the fetch connections round robin, so that with
+ * -j, even a single large file is fetched over all connections at once.
  */
 static void
 fetch_file_range(const char *path, uint64 begin, uint64 end)
@@ -422,9 +534,10 @@ fetch_file_range(const char *path, uint64 begin, uint64 end)
 
 		snprintf(linebuf, sizeof(linebuf), "%s\t" UINT64_FORMAT "\t%u\n", path, begin, len);
 
-		if (PQputCopyData(conn, linebuf, strlen(linebuf)) != 1)
+		if (PQputCopyData(fetch_conns[next_fetch_conn], linebuf, strlen(linebuf)) != 1)
 			pg_fatal("could not send COPY data: %s",
-					 PQerrorMessage(conn));
+					 PQerrorMessage(fetch_conns[next_fetch_conn]));
+		next_fetch_conn = (next_fetch_conn + 1) % n_fetch_conns;
 
 		begin += len;
 	}
@@ -442,19 +555,24 @@ libpq_executeFileMap(filemap_t *map)
 	int			i;
 
 	/*
-	 * First create a temporary table, and load it with the blocks that we
-	 * need to fetch.
+	 * First create a temporary table in each fetch connection, and load it
+	 * with the blocks that we need to fetch.  Each connection fetches the
+	 * chunks listed in its own table, so the tables form a partition of the
+	 * whole chunk list.
 	 */
-	sql = "CREATE TEMPORARY TABLE fetchchunks(path text, begin int8, len int4);";
-	run_simple_command(sql);
+	for (i = 0; i < n_fetch_conns; i++)
+	{
+		sql = "CREATE TEMPORARY TABLE fetchchunks(path text, begin int8, len int4);";
+		run_simple_command(fetch_conns[i], sql);
 
-	sql = "COPY fetchchunks FROM STDIN";
-	res = PQexec(conn, sql);
+		sql = "COPY fetchchunks FROM STDIN";
+		res = PQexec(fetch_conns[i], sql);
 
-	if (PQresultStatus(res) != PGRES_COPY_IN)
-		pg_fatal("could not send file list: %s",
-				 PQresultErrorMessage(res));
-	PQclear(res);
+		if (PQresultStatus(res) != PGRES_COPY_IN)
+			pg_fatal("could not send file list: %s",
+					 PQresultErrorMessage(res));
+		PQclear(res);
+	}
 
 	for (i = 0; i < map->narray; i++)
 	{
@@ -493,16 +611,19 @@ libpq_executeFileMap(filemap_t *map)
 		}
 	}
 
-	if (PQputCopyEnd(conn, NULL) != 1)
-		pg_fatal("could not send end-of-COPY: %s",
-				 PQerrorMessage(conn));
-
-	while ((res = PQgetResult(conn)) != NULL)
+	for (i = 0; i < n_fetch_conns; i++)
 	{
-		if (PQresultStatus(res) != PGRES_COMMAND_OK)
-			pg_fatal("unexpected result while sending file list: %s",
-					 PQresultErrorMessage(res));
-		PQclear(res);
+		if (PQputCopyEnd(fetch_conns[i], NULL) != 1)
+			pg_fatal("could not send end-of-COPY: %s",
+					 PQerrorMessage(fetch_conns[i]));
+
+		while ((res = PQgetResult(fetch_conns[i])) != NULL)
+		{
+			if (PQresultStatus(res) != PGRES_COMMAND_OK)
+				pg_fatal("unexpected result while sending file list: %s",
+						 PQresultErrorMessage(res));
+			PQclear(res);
+		}
 	}
 
 	/*
@@ -44,7 +44,7 @@ static void findCommonAncestorTimeline(XLogRecPtr *recptr, int *tliIndex);
 static void ensureCleanShutdown(const char *argv0);
 static void disconnect_atexit(void);
 
-static ControlFileData ControlFile_target;
+ControlFileData ControlFile_target;
 static ControlFileData ControlFile_source;
 
 const char *progname;
@@ -54,6 +54,7 @@ int			WalSegSz;
 char	   *datadir_target = NULL;
 char	   *datadir_source = NULL;
 char	   *connstr_source = NULL;
+int			rewind_jobs = 1;
 
 static bool debug = false;
 bool		showprogress = false;
@@ -78,6 +79,8 @@ usage(const char *progname)
 	printf(_("  -D, --target-pgdata=DIRECTORY  existing data directory to modify\n"));
 	printf(_("      --source-pgdata=DIRECTORY  source data directory to synchronize with\n"));
 	printf(_("      --source-server=CONNSTR    source server to synchronize with\n"));
+	printf(_("  -j, --jobs=NUM                 use this many concurrent connections to fetch\n"
+			 "                                 (requires --source-server)\n"));
 	printf(_("  -R, --write-recovery-conf      write configuration for replication\n"
 			 "                                 (requires --source-server)\n"));
 	printf(_("  -n, --dry-run                  stop before modifying anything\n"));
@@ -98,6 +101,7 @@ main(int argc, char **argv)
 	static struct option long_options[] = {
 		{"help", no_argument, NULL, '?'},
 		{"target-pgdata", required_argument, NULL, 'D'},
+		{"jobs", required_argument, NULL, 'j'},
 		{"write-recovery-conf", no_argument, NULL, 'R'},
 		{"source-pgdata", required_argument, NULL, 1},
 		{"source-server", required_argument, NULL, 2},
@@ -144,7 +148,7 @@ main(int argc, char **argv)
 		}
 	}
 
-	while ((c = getopt_long(argc, argv, "D:nNPR", long_options, &option_index)) != -1)
+	while ((c = getopt_long(argc, argv, "D:j:nNPR", long_options, &option_index)) != -1)
 	{
 		switch (c)
 		{
@@ -164,6 +168,16 @@ main(int argc, char **argv)
 				do_sync = false;
 				break;
 
+			case 'j':
+				rewind_jobs = atoi(optarg);
+				if (rewind_jobs < 1 || rewind_jobs > MAX_REWIND_JOBS)
+				{
+					pg_log_error("number of jobs must be between 1 and %d",
+								 MAX_REWIND_JOBS);
+					exit(1);
+				}
+				break;
+
 			case 'R':
 				writerecoveryconf = true;
 				break;
@@ -212,6 +226,13 @@ main(int argc, char **argv)
 		exit(1);
 	}
 
+	if (rewind_jobs > 1 && connstr_source == NULL)
+	{
+		pg_log_error("--jobs can only be used with --source-server");
+		fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
+		exit(1);
+	}
+
 	if (writerecoveryconf && connstr_source == NULL)
 	{
 		pg_log_error("no source server information (--source--server) specified for --write-recovery-conf");
@@ -14,20 +14,28 @@
 #include "datapagemap.h"
 
 #include "access/timeline.h"
+#include "catalog/pg_control.h"
 #include "common/logging.h"
 #include "libpq-fe.h"
 #include "storage/block.h"
 #include "storage/relfilenode.h"
 
 
+/* Upper limit on the number of concurrent fetch connections (-j) */
+#define MAX_REWIND_JOBS 64
+
 /* Configuration options */
 extern char *datadir_target;
 extern char *datadir_source;
 extern char *connstr_source;
+extern int	rewind_jobs;
 extern bool showprogress;
 extern bool dry_run;
 extern int	WalSegSz;
 
+/* Target cluster's control file, for its relation segment size */
+extern ControlFileData ControlFile_target;
+
 /* Target history */
 extern TimeLineHistoryEntry *targetHistory;
 extern int	targetNentries;
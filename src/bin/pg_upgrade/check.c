@@ -808,7 +808,10 @@ check_for_prepared_transactions(ClusterInfo *cluster)
  *
  *	Make sure there are no live undo records (aborted transactions that have
  *	not been rolled back, or committed transactions whose undo data has not
- *	yet been discarded).
+ *	yet been discarded).  Undo data that is merely waiting for the background
+ *	discard worker is discarded here, so that none of it has to be carried
+ *	over to the new cluster; only transactions still awaiting rollback cause
+ *	the upgrade to fail.
  */
 static void
 check_for_undo_data(ClusterInfo *cluster)
@@ -823,16 +826,54 @@ check_for_undo_data(ClusterInfo *cluster)
 	prep_status("Checking for undo data");
 
 	res = executeQueryOrDie(conn,
-							"SELECT * "
+							"SELECT logno "
 							"FROM pg_catalog.pg_stat_undo_logs "
 							"WHERE discard != insert");
 
 	if (PQntuples(res) != 0)
 	{
-		if (cluster == &old_cluster)
-			pg_fatal("The source cluster contains live undo data\n");
-		else
-			pg_fatal("The target cluster contains live undo data\n");
+		PGresult   *requests;
+		int			i;
+
+		/*
+		 * Some undo logs still contain undiscarded data.  If any of it
+		 * belongs to a transaction whose rollback is still pending, we can't
+		 * do anything about that here.
+		 */
+		requests = executeQueryOrDie(conn,
+									 "SELECT * FROM pg_catalog.pg_xact_undo_status()");
+		if (PQntuples(requests) != 0)
+		{
+			if (cluster == &old_cluster)
+				pg_fatal("The source cluster contains live undo data\n");
+			else
+				pg_fatal("The target cluster contains live undo data\n");
+		}
+		PQclear(requests);
+
+		/*
+		 * Otherwise the remaining data belongs to transactions that have
+		 * completed, and the discard worker just hasn't caught up yet.
+		 * Advance the discard pointers ourselves rather than failing.
+		 */
+		for (i = 0; i < PQntuples(res); i++)
+			PQclear(executeQueryOrDie(conn,
+									  "SELECT pg_catalog.pg_force_discard_undo_log(%s)",
+									  PQgetvalue(res, i, 0)));
+		PQclear(res);
+
+		/* Re-check; anything left over now is a hard failure. */
+		res = executeQueryOrDie(conn,
+								"SELECT logno "
+								"FROM pg_catalog.pg_stat_undo_logs "
+								"WHERE discard != insert");
+		if (PQntuples(res) != 0)
+		{
+			if (cluster == &old_cluster)
+				pg_fatal("The source cluster contains live undo data\n");
+			else
+				pg_fatal("The target cluster contains live undo data\n");
+		}
 	}
 
 	PQclear(res);
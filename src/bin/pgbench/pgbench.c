@@ -235,6 +235,9 @@ int			nclients = 1;		/* number of clients */
 int			nthreads = 1;		/* number of threads */
 bool		is_connect;			/* establish connection for each transaction */
 bool		report_per_command; /* report per-command latencies */
+bool		report_percentiles = false; /* report latency percentiles */
+int			abort_ratio = 10;	/* tpcb-abort: percent of xacts rolled back */
+int			tx_size = 1;		/* tpcb-abort: accounts rows touched per xact */
 int			main_pid;			/* main process id used in log filename */
 
 char	   *pghost = "";
@@ -283,6 +286,18 @@ typedef struct SimpleStats
 	double		sum2;			/* sum of squared values */
 } SimpleStats;
 
+/*
+ * Parameters of the transaction latency histogram, used for percentile
+ * reporting.  Buckets cover latencies in microseconds: one group of
+ * LATENCY_HIST_SUBBUCKETS linearly-spaced buckets per power of two, in the
+ * style of an HDR histogram, which bounds the relative error of a percentile
+ * at 1 / LATENCY_HIST_SUBBUCKETS regardless of the latency's magnitude.
+ */
+#define LATENCY_HIST_SUBBUCKET_BITS 4
+#define LATENCY_HIST_SUBBUCKETS	(1 << LATENCY_HIST_SUBBUCKET_BITS)
+#define LATENCY_HIST_GROUPS		60
+#define LATENCY_HIST_NBUCKETS	(LATENCY_HIST_SUBBUCKETS * (LATENCY_HIST_GROUPS + 1))
+
 /*
  * Data structure to hold various statistics: per-thread and per-script stats
  * are maintained and merged together.
@@ -295,6 +310,7 @@ typedef struct StatsData
 								 * and --latency-limit */
 	SimpleStats latency;
 	SimpleStats lag;
+	uint64		latency_hist[LATENCY_HIST_NBUCKETS];	/* latencies in usec */
 } StatsData;
 
 /*
@@ -583,6 +599,25 @@ static const BuiltinScript builtin_script[] =
 		"<builtin: select only>",
 		"\\set aid random(1, " CppAsString2(naccounts) " * :scale)\n"
 		"SELECT abalance FROM pgbench_accounts WHERE aid = :aid;\n"
+	},
+	{
+		"tpcb-abort",
+		"<builtin: TPC-B (sort of), batched updates, random aborts>",
+		"\\set aid random(1, " CppAsString2(naccounts) " * :scale - :tx_size + 1)\n"
+		"\\set bid random(1, " CppAsString2(nbranches) " * :scale)\n"
+		"\\set tid random(1, " CppAsString2(ntellers) " * :scale)\n"
+		"\\set delta random(-5000, 5000)\n"
+		"BEGIN;\n"
+		"UPDATE pgbench_accounts SET abalance = abalance + :delta WHERE aid BETWEEN :aid AND :aid + :tx_size - 1;\n"
+		"SELECT abalance FROM pgbench_accounts WHERE aid = :aid;\n"
+		"UPDATE pgbench_tellers SET tbalance = tbalance + :delta WHERE tid = :tid;\n"
+		"UPDATE pgbench_branches SET bbalance = bbalance + :delta WHERE bid = :bid;\n"
+		"INSERT INTO pgbench_history (tid, bid, aid, delta, mtime) VALUES (:tid, :bid, :aid, :delta, CURRENT_TIMESTAMP);\n"
+		"\\if random(1, 100) <= :abort_ratio\n"
+		"ROLLBACK;\n"
+		"\\else\n"
+		"END;\n"
+		"\\endif\n"
 	}
 };
 
@@ -666,13 +701,17 @@ usage(void)
 		   "  -t, --transactions=NUM   number of transactions each client runs (default: 10)\n"
 		   "  -T, --time=NUM           duration of benchmark test in seconds\n"
 		   "  -v, --vacuum-all         vacuum all four standard tables before tests\n"
+		   "  --abort-ratio=NUM        percentage of tpcb-abort transactions to roll back\n"
+		   "                           (default: 10)\n"
 		   "  --aggregate-interval=NUM aggregate data over NUM seconds\n"
+		   "  --latency-percentiles    report latency percentiles from a histogram\n"
 		   "  --log-prefix=PREFIX      prefix for transaction time log file\n"
 		   "                           (default: \"pgbench_log\")\n"
 		   "  --progress-timestamp     use Unix epoch timestamps for progress\n"
 		   "  --random-seed=SEED       set random seed (\"time\", \"rand\", integer)\n"
 		   "  --sampling-rate=NUM      fraction of transactions to log (e.g., 0.01 for 1%%)\n"
 		   "  --show-script=NAME       show builtin script code, then exit\n"
+		   "  --tx-size=NUM            rows touched per tpcb-abort transaction (default: 1)\n"
 		   "\nCommon options:\n"
 		   "  -d, --debug              print debugging output\n"
 		   "  -h, --host=HOSTNAME      database server host or socket directory\n"
@@ -1100,6 +1139,95 @@ mergeSimpleStats(SimpleStats *acc, SimpleStats *ss)
 	acc->sum2 += ss->sum2;
 }
 
+/*
+ * Histogram bucket for a latency in microseconds.
+ */
+static int
+latencyHistBucket(double usec)
+{
+	uint64		v = (uint64) usec;
+	int			msb;
+	int			bucket;
+
+	/* the first group covers its value range exactly */
+	if (v < LATENCY_HIST_SUBBUCKETS)
+		return (int) v;
+
+	msb = 0;
+	while ((v >> msb) != 1)
+		msb++;
+
+	/* one group of linearly-spaced sub-buckets per power of two */
+	bucket = (msb - LATENCY_HIST_SUBBUCKET_BITS + 1) * LATENCY_HIST_SUBBUCKETS +
+		(int) ((v >> (msb - LATENCY_HIST_SUBBUCKET_BITS)) &
+			   (LATENCY_HIST_SUBBUCKETS - 1));
+
+	return Min(bucket, LATENCY_HIST_NBUCKETS - 1);
+}
+
+/*
+ * Lower bound of a histogram bucket, in microseconds.
+ */
+static double
+latencyHistBucketLow(int bucket)
+{
+	int			group = bucket >> LATENCY_HIST_SUBBUCKET_BITS;
+	int			sub = bucket & (LATENCY_HIST_SUBBUCKETS - 1);
+
+	if (group == 0)
+		return (double) sub;
+	return ldexp((double) (LATENCY_HIST_SUBBUCKETS + sub), group - 1);
+}
+
+/*
+ * Estimate a latency percentile (0 < pct <= 100) from the histogram, in
+ * microseconds, interpolating linearly within the bucket the percentile
+ * falls into.  Returns 0 if no latencies were recorded.
+ */
+static double
+latencyHistPercentile(const StatsData *sd, double pct)
+{
+	int64		total = 0;
+	int64		seen = 0;
+	double		target;
+	int			i;
+
+	for (i = 0; i < LATENCY_HIST_NBUCKETS; i++)
+		total += sd->latency_hist[i];
+
+	if (total == 0)
+		return 0.0;
+
+	target = pct / 100.0 * total;
+	for (i = 0; i < LATENCY_HIST_NBUCKETS; i++)
+	{
+		seen += sd->latency_hist[i];
+		if (seen >= target)
+		{
+			double		low = latencyHistBucketLow(i);
+			double		width = latencyHistBucketLow(i + 1) - low;
+
+			return low + width *
+				(1.0 - (seen - target) / (double) sd->latency_hist[i]);
+		}
+	}
+
+	/* cannot get here, the loop must have reached the target */
+	return latencyHistBucketLow(LATENCY_HIST_NBUCKETS);
+}
+
+/*
+ * Merge the histogram of one StatsData object into another.
+ */
+static void
+mergeLatencyHist(StatsData *acc, const StatsData *ss)
+{
+	int			i;
+
+	for (i = 0; i < LATENCY_HIST_NBUCKETS; i++)
+		acc->latency_hist[i] += ss->latency_hist[i];
+}
+
 /*
  * Initialize a StatsData struct to mostly zeroes, with its start time set to
  * the given value.
@@ -1112,6 +1240,7 @@ initStats(StatsData *sd, time_t start_time)
 	sd->skipped = 0;
 	initSimpleStats(&sd->latency);
 	initSimpleStats(&sd->lag);
+	memset(sd->latency_hist, 0, sizeof(sd->latency_hist));
 }
 
 /*
@@ -1130,6 +1259,7 @@ accumStats(StatsData *stats, bool skipped, double lat, double lag)
 	else
 	{
 		addToSimpleStats(&stats->latency, lat);
+		stats->latency_hist[latencyHistBucket(lat)]++;
 
 		/* and possibly the same for schedule lag */
 		if (throttle_delay)
@@ -3554,7 +3684,8 @@ processXactStats(TState *thread, CState *st, instr_time *now,
 {
 	double		latency = 0.0,
 				lag = 0.0;
-	bool		thread_details = progress || throttle_delay || latency_limit,
+	bool		thread_details = progress || throttle_delay || latency_limit ||
+				report_percentiles,
 				detailed = thread_details || use_log || per_script_stats;
 
 	if (detailed && !skipped)
@@ -5126,6 +5257,20 @@ printSimpleStats(const char *prefix, SimpleStats *ss)
 	}
 }
 
+/*
+ * Print the standard set of latency percentiles from a histogram.
+ */
+static void
+printLatencyPercentiles(const char *prefix, const StatsData *sd)
+{
+	static const double pcts[] = {50.0, 90.0, 95.0, 99.0, 99.9};
+	int			i;
+
+	for (i = 0; i < lengthof(pcts); i++)
+		printf("%s %g%% percentile = %.3f ms\n", prefix, pcts[i],
+			   0.001 * latencyHistPercentile(sd, pcts[i]));
+}
+
 /* print out results */
 static void
 printResults(StatsData *total, instr_time total_time,
@@ -5181,8 +5326,12 @@ printResults(StatsData *total, instr_time total_time,
 			   latency_limit / 1000.0, latency_late, ntx,
 			   (ntx > 0) ? 100.0 * latency_late / ntx : 0.0);
 
-	if (throttle_delay || progress || latency_limit)
+	if (throttle_delay || progress || latency_limit || report_percentiles)
+	{
 		printSimpleStats("latency", &total->latency);
+		if (report_percentiles)
+			printLatencyPercentiles("latency", total);
+	}
 	else
 	{
 		/* no measurement, show average latency computed from run time */
@@ -5232,6 +5381,8 @@ printResults(StatsData *total, instr_time total_time,
 						   100.0 * sstats->skipped / sstats->cnt);
 
 				printSimpleStats(" - latency", &sstats->latency);
+				if (report_percentiles)
+					printLatencyPercentiles(" - latency", sstats);
 			}
 
 			/* Report per-command latencies */
@@ -5240,9 +5391,9 @@ printResults(StatsData *total, instr_time total_time,
 				Command   **commands;
 
 				if (per_script_stats)
-					printf(" - statement latencies in milliseconds:\n");
+					printf(" - statement latencies in milliseconds (average, maximum):\n");
 				else
-					printf("statement latencies in milliseconds:\n");
+					printf("statement latencies in milliseconds (average, maximum):\n");
 
 				for (commands = sql_script[i].commands;
 					 *commands != NULL;
@@ -5250,9 +5401,10 @@ printResults(StatsData *total, instr_time total_time,
 				{
 					SimpleStats *cstats = &(*commands)->stats;
 
-					printf("   %11.3f  %s\n",
+					printf("   %11.3f  %11.3f  %s\n",
 						   (cstats->count > 0) ?
 						   1000.0 * cstats->sum / cstats->count : 0.0,
+						   1000.0 * cstats->max,
 						   (*commands)->first_line);
 				}
 			}
@@ -5360,6 +5512,9 @@ main(int argc, char **argv)
 		{"show-script", required_argument, NULL, 10},
 		{"partitions", required_argument, NULL, 11},
 		{"partition-method", required_argument, NULL, 12},
+		{"latency-percentiles", no_argument, NULL, 13},
+		{"abort-ratio", required_argument, NULL, 14},
+		{"tx-size", required_argument, NULL, 15},
 		{NULL, 0, NULL, 0}
 	};
 
@@ -5742,6 +5897,28 @@ main(int argc, char **argv)
 					exit(1);
 				}
 				break;
+			case 13:			/* latency-percentiles */
+				benchmarking_option_set = true;
+				report_percentiles = true;
+				break;
+			case 14:			/* abort-ratio */
+				benchmarking_option_set = true;
+				abort_ratio = atoi(optarg);
+				if (abort_ratio < 0 || abort_ratio > 100)
+				{
+					fprintf(stderr, "invalid abort ratio: \"%s\"\n", optarg);
+					exit(1);
+				}
+				break;
+			case 15:			/* tx-size */
+				benchmarking_option_set = true;
+				tx_size = atoi(optarg);
+				if (tx_size <= 0)
+				{
+					fprintf(stderr, "invalid transaction size: \"%s\"\n", optarg);
+					exit(1);
+				}
+				break;
 			default:
 				fprintf(stderr, _("Try \"%s --help\" for more information.\n"), progname);
 				exit(1);
@@ -6016,6 +6193,24 @@ main(int argc, char **argv)
 				exit(1);
 	}
 
+	/*
+	 * Define :abort_ratio and :tx_size for the tpcb-abort script, unless
+	 * overridden with an explicit -D switch.
+	 */
+	if (lookupVariable(&state[0], "abort_ratio") == NULL)
+	{
+		for (i = 0; i < nclients; i++)
+			if (!putVariableInt(&state[i], "startup", "abort_ratio", abort_ratio))
+				exit(1);
+	}
+
+	if (lookupVariable(&state[0], "tx_size") == NULL)
+	{
+		for (i = 0; i < nclients; i++)
+			if (!putVariableInt(&state[i], "startup", "tx_size", tx_size))
+				exit(1);
+	}
+
 	/* set default seed for hash functions */
 	if (lookupVariable(&state[0], "default_seed") == NULL)
 	{
@@ -6148,6 +6343,7 @@ main(int argc, char **argv)
 		/* aggregate thread level stats */
 		mergeSimpleStats(&stats.latency, &thread->stats.latency);
 		mergeSimpleStats(&stats.lag, &thread->stats.lag);
+		mergeLatencyHist(&stats, &thread->stats);
 		stats.cnt += thread->stats.cnt;
 		stats.skipped += thread->stats.skipped;
 		latency_late += thread->latency_late;
@@ -729,18 +729,39 @@ pglz_decompress(const char *source, int32 slen, char *dest,
 				if (len == 18)
 					len += *sp++;
 
+				/*
+				 * Check for corrupt data: if we fell off the end of the
+				 * source, or if we obtained off = 0, we have problems.  (We
+				 * must check this, else we risk an infinite loop below in
+				 * the face of corrupt data.)
+				 */
+				if (unlikely(sp > srcend || off == 0))
+					return -1;
+
 				/*
 				 * Now we copy the bytes specified by the tag from OUTPUT to
-				 * OUTPUT. It is dangerous and platform dependent to use
-				 * memcpy() here, because the copied areas could overlap
-				 * extremely!
+				 * OUTPUT (copy len bytes from dp - off to dp).  The copied
+				 * areas could overlap, and a plain memcpy or memmove of the
+				 * whole range would not replicate the data the way the
+				 * format requires, so copy only non-overlapping regions.
+				 *
+				 * As long as off < len, copying off bytes is certainly
+				 * non-overlapping, and doing so doubles the length of
+				 * replicated data in front of dp, so off can be doubled
+				 * after each such copy.  This way a short repeating pattern
+				 * is expanded in O(log(len)) memcpy calls rather than one
+				 * byte at a time.
 				 */
 				len = Min(len, destend - dp);
-				while (len--)
+				while (off < len)
 				{
-					*dp = dp[-off];
-					dp++;
+					memcpy(dp, dp - off, off);
+					len -= off;
+					dp += off;
+					off += off;
 				}
+				memcpy(dp, dp - off, len);
+				dp += len;
 			}
 			else
 			{
@@ -76,6 +76,19 @@ typedef bool (*aminsert_function) (Relation indexRelation,
 								   IndexUniqueCheck checkUnique,
 								   struct IndexInfo *indexInfo);
 
+/*
+ * insert a batch of tuples, with no uniqueness checking (optional).
+ * Implementations may reorder the batch to suit the index's layout; each
+ * element of values/isnull points to one tuple's column arrays.
+ */
+typedef void (*aminsertbatch_function) (Relation indexRelation,
+										Datum **values,
+										bool **isnull,
+										ItemPointer *heap_tids,
+										int ntuples,
+										Relation heapRelation,
+										struct IndexInfo *indexInfo);
+
 /* bulk delete */
 typedef IndexBulkDeleteResult *(*ambulkdelete_function) (IndexVacuumInfo *info,
 														 IndexBulkDeleteResult *stats,
@@ -210,6 +223,7 @@ typedef struct IndexAmRoutine
 	ambuild_function ambuild;
 	ambuildempty_function ambuildempty;
 	aminsert_function aminsert;
+	aminsertbatch_function aminsertbatch;	/* can be NULL */
 	ambulkdelete_function ambulkdelete;
 	amvacuumcleanup_function amvacuumcleanup;
 	amcanreturn_function amcanreturn;	/* can be NULL */
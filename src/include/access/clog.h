@@ -28,6 +28,9 @@ typedef int XidStatus;
 #define TRANSACTION_STATUS_ABORTED			0x02
 #define TRANSACTION_STATUS_SUB_COMMITTED	0x03
 
+/* GUC variable */
+extern int	clog_buffers;
+
 typedef struct xl_clog_truncate
 {
 	int			pageno;
@@ -144,6 +144,11 @@ extern bool index_insert(Relation indexRelation,
 						 Relation heapRelation,
 						 IndexUniqueCheck checkUnique,
 						 struct IndexInfo *indexInfo);
+extern void index_insert_batch(Relation indexRelation,
+							   Datum **values, bool **isnull,
+							   ItemPointer *heap_tids, int ntuples,
+							   Relation heapRelation,
+							   struct IndexInfo *indexInfo);
 
 extern IndexScanDesc index_beginscan(Relation heapRelation,
 									 Relation indexRelation,
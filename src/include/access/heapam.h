@@ -61,6 +61,7 @@ typedef struct HeapScanDescData
 
 	/* rs_numblocks is usually InvalidBlockNumber, meaning "scan whole rel" */
 	BufferAccessStrategy rs_strategy;	/* access strategy for reads */
+	BlockNumber rs_extent_until;	/* blocks below this were bulk-read */
 
 	HeapTupleData rs_ctup;		/* current tuple in scan, if any */
 
@@ -577,6 +577,7 @@ typedef struct BTScanPosData
 	int			firstItem;		/* first valid index in items[] */
 	int			lastItem;		/* last valid index in items[] */
 	int			itemIndex;		/* current index in items[] */
+	int			prefetchIndex;	/* next item to consider for heap prefetch */
 
 	BTScanPosItem items[MaxIndexTuplesPerPage]; /* MUST BE LAST */
 } BTScanPosData;
@@ -662,6 +663,13 @@ typedef struct BTScanOpaqueData
 	 */
 	int			markItemIndex;	/* itemIndex, or -1 if not valid */
 
+	/*
+	 * How many items ahead of the cursor heap-block prefetching may run,
+	 * from the heap's tablespace's effective_io_concurrency; -1 until first
+	 * computed (see _bt_prefetchheap).
+	 */
+	int			prefetchMaximum;
+
 	/* keep these last in struct for efficiency */
 	BTScanPosData currPos;		/* current position data */
 	BTScanPosData markPos;		/* marked position, if any */
@@ -698,6 +706,9 @@ extern bool btinsert(Relation rel, Datum *values, bool *isnull,
 					 ItemPointer ht_ctid, Relation heapRel,
 					 IndexUniqueCheck checkUnique,
 					 struct IndexInfo *indexInfo);
+extern void btinsertbatch(Relation rel, Datum **values, bool **isnull,
+						  ItemPointer *heap_tids, int ntuples,
+						  Relation heapRel, struct IndexInfo *indexInfo);
 extern IndexScanDesc btbeginscan(Relation rel, int nkeys, int norderbys);
 extern Size btestimateparallelscan(void);
 extern void btinitparallelscan(void *target);
@@ -127,6 +127,15 @@ typedef struct SlruCtlData
 	 */
 	bool		(*PagePrecedes) (int, int);
 
+	/*
+	 * Slot where this backend last found a page in the read-only path.
+	 * Probing it before scanning all the buffers makes repeated lookups of a
+	 * hot page O(1) instead of O(num_slots), which matters when a large
+	 * buffer pool is configured (see clog_buffers).  This is a per-process
+	 * hint, not shared state; a stale value is detected and ignored.
+	 */
+	int			last_read_slot;
+
 	/*
 	 * Dir is set during SimpleLruInit and does not change thereafter. Since
 	 * it's always the same, it doesn't need to be in shared memory.
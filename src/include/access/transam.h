@@ -182,6 +182,9 @@ typedef struct VariableCacheData
 	 */
 	TransactionId latestCompletedXid;	/* newest XID that has committed or
 										 * aborted */
+	uint64		xactCompletionCount;	/* advances whenever a transaction
+										 * completes; used to detect whether
+										 * snapshots can be reused */
 
 	/*
 	 * These fields are protected by CLogTruncationLock
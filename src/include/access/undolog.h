@@ -17,6 +17,7 @@
 #define UNDOLOG_H
 
 #include "access/undodefs.h"
+#include "access/xlogdefs.h"
 #include "catalog/database_internal.h"
 #include "lib/ilist.h"
 
@@ -39,6 +40,22 @@
 /* Size of an undo log segment file in bytes. */
 #define UndoLogSegmentSize ((size_t) BLCKSZ * UNDOSEG_SIZE)
 
+/* Name suffix of a compressed undo log segment file. */
+#define UndoLogSegmentCompressSuffix ".cz"
+
+/*
+ * Header written at the start of a compressed undo log segment file, followed
+ * by the pglz-compressed image of the whole segment.
+ */
+typedef struct UndoLogCompressedSegmentHeader
+{
+	uint32		magic;			/* UNDO_COMPRESSED_SEGMENT_MAGIC */
+	uint32		rawsize;		/* uncompressed size, always
+								 * UndoLogSegmentSize */
+} UndoLogCompressedSegmentHeader;
+
+#define UNDO_COMPRESSED_SEGMENT_MAGIC 0x43557a01
+
 /* The width of an undo log number in bits.  24 allows for 16.7m logs. */
 #define UndoLogNumberBits 24
 
@@ -152,12 +169,41 @@ typedef struct UndoLogSlot
 	TransactionId xid;
 	UndoLogOffset begin;			/* beginning of lowest segment file */
 	UndoLogOffset end;				/* one past end of highest segment */
+
+	/*
+	 * Discarding is split into two stages: UndoDiscard() just advances
+	 * meta.discard, and the undo launcher later invalidates buffers and
+	 * removes segment files.  'reclaim' records how far that second stage
+	 * has gotten, and 'discard_lsn' the WAL position that must be flushed
+	 * before files in the discarded range can be unlinked.
+	 */
+	UndoLogOffset reclaim;			/* buffers invalidated up to here */
+	XLogRecPtr	discard_lsn;		/* WAL position of latest discard record */
 } UndoLogSlot;
 
 extern UndoLogSlot *UndoLogGetSlot(UndoLogNumber logno, bool missing_ok);
 extern UndoLogSlot *UndoLogGetNextSlot(UndoLogSlot *slot);
 extern UndoRecPtr UndoLogGetOldestRecord(UndoLogNumber logno, bool *full);
 
+/*
+ * A snapshot of the undo subsystem's activity counters, maintained in shared
+ * memory and exposed through the pg_stat_undo_workers view.
+ */
+typedef struct UndoLogStatsData
+{
+	uint64		records_inserted;	/* undo records written */
+	uint64		bytes_inserted;		/* bytes of undo data written */
+	uint64		bytes_discarded;	/* bytes passed by the discard pointer */
+	uint64		segments_created;	/* segment files zero-filled */
+	uint64		spare_segments_claimed; /* preallocated spares claimed */
+	uint64		segments_recycled;	/* old segments renamed into place */
+	uint64		buffers_reclaimed;	/* discarded buffers invalidated */
+	uint64		reclaim_passes;		/* background reclaim passes */
+} UndoLogStatsData;
+
+extern void UndoLogGetStats(UndoLogStatsData *stats);
+extern void UndoLogCountInsertion(size_t bytes, int nrecords);
+
 /*
  * Each backend maintains a small hash table mapping undo log numbers to
  * UndoLogSlot objects in shared memory.
@@ -306,6 +352,8 @@ extern void CheckPointUndoLogs(UndoCheckpointContext *ctx);
 
 /* Interfaces exported for undo_file.c. */
 extern void UndoLogNewSegment(UndoLogNumber logno, Oid tablespace, int segno);
+extern bool UndoLogUncompressSegment(UndoLogNumber logno, Oid tablespace,
+									 int segno);
 extern void UndoLogDirectory(Oid tablespace, char *path);
 extern void UndoLogSegmentPath(UndoLogNumber logno, int segno, Oid tablespace,
 							   char *path);
@@ -314,7 +362,15 @@ extern void ResetUndoLogs(char persistence);
 /* Interface use by tablespace.c. */
 extern bool DropUndoLogsInTablespace(Oid tablespace);
 
+/* Interface used by the undo launcher. */
+extern void UndoLogMaintainSpareSegments(void);
+extern void UndoLogBackgroundReclaim(void);
+extern void UndoLogCompressSegments(void);
+
 /* GUC interfaces. */
+extern int	undo_prealloc_segments;
+extern int	undo_freelist_stripes;
+extern bool undo_compress_segments;
 extern void assign_undo_tablespaces(const char *newval, void *extra);
 
 extern void TempUndoDiscard(UndoLogNumber);
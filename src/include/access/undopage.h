@@ -119,6 +119,9 @@ extern int UndoPageInsertRecord(Page page, int page_offset, int data_offset,
 								UndoRecordSetType chunk_type);
 extern int UndoPageSkipRecord(int page_offset, int data_offset,
 							  size_t data_size);
+extern char *UndoPageReserveRecord(Page page, int page_offset, Size data_size,
+								   UndoRecPtr chunk_start,
+								   UndoRecordSetType chunk_type);
 extern int UndoPageOverwrite(Page page, int page_offset, int data_offset,
 							 Size data_size, char *data);
 extern int UndoPageSkipOverwrite(int page_offset, int data_offset, Size data_size);
@@ -42,15 +42,31 @@ typedef struct UndoRecordSetChunkHeader
 #define SizeOfUndoRecordSetChunkHeader \
 	(offsetof(UndoRecordSetChunkHeader, type) + sizeof(uint8))
 
+/*
+ * An iovec-style description of one undo record, for callers that insert
+ * several records with a single call to UndoInsertMulti().
+ */
+typedef struct UndoRecData
+{
+	void	   *data;
+	size_t		size;
+} UndoRecData;
+
 extern UndoRecordSet *UndoCreate(UndoRecordSetType type, char presistence,
 								 int nestingLevel, Size type_header_size,
 								 char *type_header);
 extern bool UndoPrepareToMarkClosed(UndoRecordSet *urs);
 extern void UndoMarkClosed(UndoRecordSet *urs);
 extern UndoRecPtr UndoPrepareToInsert(UndoRecordSet *urs, size_t record_size);
+extern bool UndoCanInsertInPlace(UndoRecordSet *urs, size_t record_size);
+extern char *UndoBeginInsertInPlace(UndoRecordSet *urs, size_t record_size);
+extern void UndoFinishInsertInPlace(UndoRecordSet *urs, size_t record_size);
 extern void UndoInsert(UndoRecordSet *urs,
 					   void *record_data,
 					   size_t record_size);
+extern void UndoInsertMulti(UndoRecordSet *urs,
+							const UndoRecData *records,
+							int nrecords);
 extern void UndoPageSetLSN(UndoRecordSet *urs, XLogRecPtr lsn);
 extern void UndoRelease(UndoRecordSet *urs);
 extern void UndoDestroy(UndoRecordSet *urs);
@@ -60,6 +76,9 @@ extern void UndoXLogRegisterBuffers(UndoRecordSet *urs, uint8 first_block_id);
 extern UndoRecPtr UndoReplay(XLogReaderState *xlog_record,
 							 void *record_data,
 							 size_t record_size);
+extern UndoRecPtr UndoReplayMulti(XLogReaderState *xlog_record,
+								  const UndoRecData *records,
+								  int nrecords);
 extern void CloseDanglingUndoRecordSets(void);
 
 /* transaction integration */
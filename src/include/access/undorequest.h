@@ -31,7 +31,7 @@ extern bool undo_force_foreground;
 /* Initialization functions. */
 extern Size EstimateUndoRequestManagerSize(unsigned capacity);
 extern void InitializeUndoRequestManager(UndoRequestManager *urm,
-										 LWLock *lock, unsigned capacity,
+										 unsigned capacity,
 										 unsigned soft_limit);
 
 /* Call this before inserting undo records. */
@@ -59,6 +59,11 @@ extern bool PerformUndoInBackground(UndoRequestManager *urm, UndoRequest *req,
 /* Check how long a worker would need to wait for an UndoRequest. */
 extern long UndoRequestWaitTime(UndoRequestManager *urm, TimestampTz when);
 
+/* Count databases with dispatchable UndoRequests, for pool sizing. */
+extern unsigned CountPendingUndoRequestDatabases(UndoRequestManager *urm,
+												 TimestampTz when,
+												 unsigned max_databases);
+
 /* Get work for background undo process. */
 extern UndoRequest *GetNextUndoRequest(UndoRequestManager *urm, Oid dbid,
 									   bool minimum_runtime_reached,
@@ -28,5 +28,6 @@ extern void RegisterUndoLauncher(void);
 extern void UndoLauncherMain(Datum main_arg);
 extern void UndoWorkerMain(Datum main_arg);
 extern void DisturbUndoLauncherHibernation(void);
+extern void WakeUndoLauncher(void);
 
 #endif
@@ -25,6 +25,7 @@
  * WAL records for undoxacttest
  */
 #define XLOG_UNDOXACTTEST_MOD		0x00
+#define XLOG_UNDOXACTTEST_MOD_MULTI	0x10
 
 typedef struct xl_undoxacttest_mod
 {
@@ -33,6 +34,14 @@ typedef struct xl_undoxacttest_mod
 	int64 debug_oldval;
 } xl_undoxacttest_mod;
 
+typedef struct xl_undoxacttest_mod_multi
+{
+	int64 newval;
+	int64 debug_mod;
+	int64 debug_oldval;
+	int32 nmods;
+} xl_undoxacttest_mod_multi;
+
 
 /*
  * UNDO records for undoxacttest
@@ -51,5 +60,6 @@ extern RmgrUndoHandler* undoxacttest_undo(void);
 
 /* functions to be called by SQL UDFs */
 int64 undoxacttest_log_execute_mod(Relation rel, Buffer buf, int64 *counter, int64 mod);
+int64 undoxacttest_log_execute_mod_multi(Relation rel, Buffer buf, int64 *counter, int64 mod, int nmods);
 
 #endif /* UNDOXACTTEST */
@@ -14,6 +14,7 @@
 
 #include "access/twophase.h"
 #include "access/undodefs.h"
+#include "access/undorecordset.h"
 #include "access/xlogdefs.h"
 #include "access/xlogreader.h"
 #include "datatype/timestamp.h"
@@ -22,7 +23,13 @@
 typedef struct XactUndoContext
 {
 	UndoPersistenceLevel plevel;
-	StringInfoData data;
+	struct UndoNode *node;		/* caller's record, for in-place insertion */
+	size_t		size;			/* combined serialized size of the records */
+	int			nrecords;		/* number of records in this insertion */
+	UndoRecData *rdata;			/* per-record slices of 'data', when several
+								 * records are inserted as one batch */
+	StringInfoData data;		/* staged record data; unused (data.data ==
+								 * NULL) when inserting in place */
 } XactUndoContext;
 
 typedef struct UndoNode
@@ -46,6 +53,9 @@ extern void CheckPointXactUndo(UndoCheckpointContext *ctx);
 
 extern UndoRecPtr PrepareXactUndoData(XactUndoContext *ctx, char persistence,
 									  UndoNode *undo_node);
+extern UndoRecPtr PrepareXactUndoDataMulti(XactUndoContext *ctx,
+										   char persistence,
+										   UndoNode *undo_nodes, int nnodes);
 extern void InsertXactUndoData(XactUndoContext *ctx, uint8 first_block_id);
 extern void SetXactUndoPageLSNs(XactUndoContext *ctx, XLogRecPtr lsn);
 extern void CleanupXactUndoInsertion(XactUndoContext *ctx);
@@ -53,12 +63,16 @@ extern void CleanupXactUndoInsertion(XactUndoContext *ctx);
 /* undo re-insertion during recovery */
 extern UndoRecPtr XactUndoReplay(XLogReaderState *xlog_record,
 								 UndoNode *undo_node);
+extern UndoRecPtr XactUndoReplayMulti(XLogReaderState *xlog_record,
+									  UndoNode *undo_nodes, int nnodes);
 extern void XactUndoCloseRecordSet(void *type_header, UndoRecPtr begin,
 								   UndoRecPtr end,
 								   bool isCommit, bool isPrepare);
 
 /* undo worker infrastructure */
 extern long XactUndoWaitTime(TimestampTz now);
+extern unsigned XactUndoPendingDatabases(TimestampTz now,
+										 unsigned max_databases);
 extern Oid InitializeBackgroundXactUndo(bool minimum_runtime_reached);
 extern void FinishBackgroundXactUndo(void);
 
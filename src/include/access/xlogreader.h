@@ -81,6 +81,8 @@ typedef struct
 	/* Buffer holding the rmgr-specific data associated with this block */
 	bool		has_data;
 	char	   *data;
+	char	   *data_src;		/* borrowed pointer into the record; NULL
+								 * once the data has been copied to "data" */
 	uint16		data_len;
 	uint16		data_bufsz;
 } DecodedBkpBlock;
@@ -143,6 +145,9 @@ struct XLogReaderState
 	XLogRecord *decoded_record; /* currently decoded record */
 
 	char	   *main_data;		/* record's main data portion */
+	char	   *main_data_src;	/* borrowed pointer into the record; NULL
+								 * once the data has been copied to
+								 * "main_data" */
 	uint32		main_data_len;	/* main data portion's length */
 	uint32		main_data_bufsz;	/* allocated size of the buffer */
 
@@ -243,7 +248,7 @@ extern bool DecodeXLogRecord(XLogReaderState *state, XLogRecord *record,
 #define XLogRecGetRmid(decoder) ((decoder)->decoded_record->xl_rmid)
 #define XLogRecGetXid(decoder) ((decoder)->decoded_record->xl_xid)
 #define XLogRecGetOrigin(decoder) ((decoder)->record_origin)
-#define XLogRecGetData(decoder) ((decoder)->main_data)
+#define XLogRecGetData(decoder) (XLogRecGetMainData(decoder))
 #define XLogRecGetDataLen(decoder) ((decoder)->main_data_len)
 #define XLogRecHasAnyBlockRefs(decoder) ((decoder)->max_block_id >= 0)
 #define XLogRecHasBlockRef(decoder, block_id) \
@@ -259,6 +264,7 @@ extern FullTransactionId RedoGetFullXID(TransactionId xid);
 #endif
 
 extern bool RestoreBlockImage(XLogReaderState *record, uint8 block_id, char *page);
+extern char *XLogRecGetMainData(XLogReaderState *record);
 extern char *XLogRecGetBlockData(XLogReaderState *record, uint8 block_id, Size *len);
 extern bool XLogRecGetBlockTag(XLogReaderState *record, uint8 block_id,
 							   RelFileNode *rnode, ForkNumber *forknum,
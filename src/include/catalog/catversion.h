@@ -53,6 +53,6 @@
  */
 
 /*							yyyymmddN */
-#define CATALOG_VERSION_NO	201909251
+#define CATALOG_VERSION_NO	201909265
 
 #endif
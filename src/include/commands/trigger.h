@@ -148,6 +148,13 @@ typedef struct TransitionCaptureState
 #define SESSION_REPLICATION_ROLE_LOCAL		2
 extern PGDLLIMPORT int SessionReplicationRole;
 
+/*
+ * Memory limit (in kilobytes) on a single query's AFTER trigger event queue,
+ * beyond which event chunks are spilled to a temporary file.  -1 disables
+ * spilling.
+ */
+extern PGDLLIMPORT int after_trigger_spill_threshold;
+
 /*
  * States at which a trigger can be fired. These are the
  * possible values for pg_trigger.tgenabled.
@@ -225,10 +225,12 @@ typedef enum ExprEvalOp
 	EEOP_AGG_DESERIALIZE,
 	EEOP_AGG_STRICT_INPUT_CHECK_ARGS,
 	EEOP_AGG_STRICT_INPUT_CHECK_NULLS,
-	EEOP_AGG_INIT_TRANS,
-	EEOP_AGG_STRICT_TRANS_CHECK,
+	EEOP_AGG_PLAIN_TRANS_INIT_STRICT_BYVAL,
+	EEOP_AGG_PLAIN_TRANS_STRICT_BYVAL,
 	EEOP_AGG_PLAIN_TRANS_BYVAL,
-	EEOP_AGG_PLAIN_TRANS,
+	EEOP_AGG_PLAIN_TRANS_INIT_STRICT_BYREF,
+	EEOP_AGG_PLAIN_TRANS_STRICT_BYREF,
+	EEOP_AGG_PLAIN_TRANS_BYREF,
 	EEOP_AGG_ORDERED_TRANS_DATUM,
 	EEOP_AGG_ORDERED_TRANS_TUPLE,
 
@@ -597,7 +599,6 @@ typedef struct ExprEvalStep
 		/* for EEOP_AGG_*DESERIALIZE */
 		struct
 		{
-			AggState   *aggstate;
 			FunctionCallInfo fcinfo_data;
 			int			jumpnull;
 		}			agg_deserialize;
@@ -622,32 +623,9 @@ typedef struct ExprEvalStep
 			int			jumpnull;
 		}			agg_strict_input_check;
 
-		/* for EEOP_AGG_INIT_TRANS */
-		struct
-		{
-			AggState   *aggstate;
-			AggStatePerTrans pertrans;
-			ExprContext *aggcontext;
-			int			setno;
-			int			transno;
-			int			setoff;
-			int			jumpnull;
-		}			agg_init_trans;
-
-		/* for EEOP_AGG_STRICT_TRANS_CHECK */
-		struct
-		{
-			AggState   *aggstate;
-			int			setno;
-			int			transno;
-			int			setoff;
-			int			jumpnull;
-		}			agg_strict_trans_check;
-
 		/* for EEOP_AGG_{PLAIN,ORDERED}_TRANS* */
 		struct
 		{
-			AggState   *aggstate;
 			AggStatePerTrans pertrans;
 			ExprContext *aggcontext;
 			int			setno;
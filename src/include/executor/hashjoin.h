@@ -14,6 +14,7 @@
 #ifndef HASHJOIN_H
 #define HASHJOIN_H
 
+#include "lib/bloomfilter.h"
 #include "nodes/execnodes.h"
 #include "port/atomics.h"
 #include "storage/barrier.h"
@@ -319,6 +320,28 @@ typedef struct HashJoinTableData
 	double		partialTuples;	/* # tuples obtained from inner plan by me */
 	double		skewTuples;		/* # tuples inserted into skew tuples */
 
+	/*
+	 * Bloom filter over the hash values of all inner tuples (in all
+	 * batches), used to reject non-matching outer tuples without probing a
+	 * bucket.  NULL if disabled, e.g. for parallel hash tables, or if the
+	 * filter turned out to be too dense to be useful.
+	 */
+	bloom_filter *bloomFilter;
+
+	/*
+	 * Minimum and maximum value of the first join key across all inner
+	 * tuples, used to reject out-of-range outer tuples even earlier than
+	 * the Bloom filter, and exactly.  Only maintained for private hash
+	 * tables when the join has a single key whose equality operator is the
+	 * default for a pass-by-value type with a btree comparison function
+	 * (so the Datums can be retained without copying).
+	 */
+	bool		useKeyRange;	/* collect and apply the min/max filter? */
+	bool		haveKeyRange;	/* has any non-null key been seen yet? */
+	Datum		keyRangeMin;
+	Datum		keyRangeMax;
+	FmgrInfo	keyRangeCmp;	/* btree comparison function for the key */
+
 	/*
 	 * These arrays are allocated for the life of the hash join, but only if
 	 * nbatch > 1.  A file is opened only when we first write a tuple into it
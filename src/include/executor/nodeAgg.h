@@ -17,6 +17,29 @@
 #include "nodes/execnodes.h"
 
 
+/*
+ * Inline "kernels" for a handful of built-in transition functions that
+ * dominate typical aggregation workloads.  When the transition function is
+ * recognized at ExecInitAgg() time, the expression interpreter applies the
+ * operation directly to the transition value instead of going through the
+ * function-call machinery for every input row.  The kernels replicate the
+ * built-ins' semantics exactly, including overflow checks.
+ */
+typedef enum AggTransKernel
+{
+	AGG_TRANSKERNEL_NONE,
+	AGG_TRANSKERNEL_INT8INC,	/* int8inc, int8inc_any: count() */
+	AGG_TRANSKERNEL_INT8PL,		/* int8pl: count/sum(int8) combine */
+	AGG_TRANSKERNEL_INT4_SUM,	/* int4_sum: sum(int4) */
+	AGG_TRANSKERNEL_FLOAT8PL,	/* float8pl: sum(float8) */
+	AGG_TRANSKERNEL_INT4_MIN,	/* int4smaller: min(int4) */
+	AGG_TRANSKERNEL_INT4_MAX,	/* int4larger: max(int4) */
+	AGG_TRANSKERNEL_INT8_MIN,	/* int8smaller: min(int8) */
+	AGG_TRANSKERNEL_INT8_MAX,	/* int8larger: max(int8) */
+	AGG_TRANSKERNEL_FLOAT8_MIN, /* float8smaller: min(float8) */
+	AGG_TRANSKERNEL_FLOAT8_MAX	/* float8larger: max(float8) */
+} AggTransKernel;
+
 /*
  * AggStatePerTransData - per aggregate state value information
  *
@@ -127,6 +150,12 @@ typedef struct AggStatePerTransData
 	bool		inputtypeByVal,
 				transtypeByVal;
 
+	/*
+	 * Inline kernel for the transition function, or AGG_TRANSKERNEL_NONE if
+	 * it wasn't recognized as one of the supported built-ins.
+	 */
+	AggTransKernel transKernel;
+
 	/*
 	 * Slots for holding the evaluated input arguments.  These are set up
 	 * during ExecInitAgg() and then used for each input row requiring either
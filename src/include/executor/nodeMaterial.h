@@ -14,6 +14,7 @@
 #ifndef NODEMATERIAL_H
 #define NODEMATERIAL_H
 
+#include "access/parallel.h"
 #include "nodes/execnodes.h"
 
 extern MaterialState *ExecInitMaterial(Material *node, EState *estate, int eflags);
@@ -22,4 +23,11 @@ extern void ExecMaterialMarkPos(MaterialState *node);
 extern void ExecMaterialRestrPos(MaterialState *node);
 extern void ExecReScanMaterial(MaterialState *node);
 
+/* parallel scan support */
+extern void ExecMaterialEstimate(MaterialState *node, ParallelContext *pcxt);
+extern void ExecMaterialInitializeDSM(MaterialState *node, ParallelContext *pcxt);
+extern void ExecMaterialReInitializeDSM(MaterialState *node, ParallelContext *pcxt);
+extern void ExecMaterialInitializeWorker(MaterialState *node,
+										 ParallelWorkerContext *pwcxt);
+
 #endif							/* NODEMATERIAL_H */
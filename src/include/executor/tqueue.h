@@ -28,5 +28,8 @@ extern TupleQueueReader *CreateTupleQueueReader(shm_mq_handle *handle);
 extern void DestroyTupleQueueReader(TupleQueueReader *reader);
 extern HeapTuple TupleQueueReaderNext(TupleQueueReader *reader,
 									  bool nowait, bool *done);
+extern HeapTuple TupleQueueReaderNextReuse(TupleQueueReader *reader,
+										   bool nowait, bool *done,
+										   void **buf, Size *buflen);
 
 #endif							/* TQUEUE_H */
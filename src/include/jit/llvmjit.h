@@ -117,6 +117,9 @@ extern void llvm_inline(LLVMModuleRef mod);
  */
 extern bool llvm_compile_expr(struct ExprState *state);
 struct TupleTableSlotOps;
+extern void *llvm_get_deform_function(struct LLVMJitContext *context,
+						 TupleDesc desc,
+						 const struct TupleTableSlotOps *ops, int natts);
 extern LLVMValueRef slot_compile_deform(struct LLVMJitContext *context, TupleDesc desc,
 										const struct TupleTableSlotOps *ops, int natts);
 
@@ -251,6 +251,8 @@ extern int	VacuumCostPageMiss;
 extern int	VacuumCostPageDirty;
 extern int	VacuumCostLimit;
 extern double VacuumCostDelay;
+extern int	VacuumIOReadLimit;
+extern int	VacuumIOWriteLimit;
 
 extern int	VacuumPageHit;
 extern int	VacuumPageMiss;
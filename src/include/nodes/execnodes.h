@@ -1050,6 +1050,25 @@ typedef struct PlanState
 			((PlanState *)(node))->instrument->nfiltered2 += (delta); \
 	} while(0)
 
+/*
+ * AsyncRequest
+ *
+ * State for an asynchronous tuple request issued by a requestor node (such
+ * as an Append) against an async-capable requestee node (currently only a
+ * ForeignScan whose FDW provides the ForeignAsync* callbacks).  See
+ * src/backend/executor/execAsync.c.
+ */
+typedef struct AsyncRequest
+{
+	struct PlanState *requestor;	/* Node that wants a tuple */
+	struct PlanState *requestee;	/* Node from which a tuple is wanted */
+	int			request_index;	/* Scratch space for requestor */
+	bool		callback_pending;	/* Callback is needed */
+	bool		request_complete;	/* Request complete, result valid */
+	TupleTableSlot *result;		/* Result (NULL or an empty slot if no more
+								 * tuples) */
+} AsyncRequest;
+
 /*
  * EPQState is state for executing an EvalPlanQual recheck on a candidate
  * tuples e.g. in ModifyTable or LockRows.
@@ -1191,6 +1210,13 @@ typedef struct ModifyTableState
 
 	/* Per plan map for tuple conversion from child to root */
 	TupleConversionMap **mt_per_subplan_tupconv_maps;
+
+	/* these fields are used for batching qualifying INSERTs: */
+	bool		mt_use_multi_insert;	/* buffer tuples for multi-insert? */
+	TupleTableSlot **mt_multi_slots;	/* buffered tuples, allocated lazily */
+	int			mt_multi_nused; /* number of buffered tuples */
+	uint64		mt_multi_bytes; /* size of buffered tuples, in bytes */
+	struct BulkInsertStateData *mt_bistate; /* bulk insert state */
 } ModifyTableState;
 
 /* ----------------
@@ -1203,6 +1229,8 @@ typedef struct ModifyTableState
  *							eliminated from the scan, or NULL if not possible.
  *		valid_subplans		for runtime pruning, valid appendplans indexes to
  *							scan.
+ *		asyncplans			asynchronous plans indexes.
+ *		nasyncplans			# of asynchronous plans.
  * ----------------
  */
 
@@ -1218,12 +1246,25 @@ struct AppendState
 	PlanState **appendplans;	/* array of PlanStates for my inputs */
 	int			as_nplans;
 	int			as_whichplan;
+	bool		as_begun;		/* false means need to initialize */
+	Bitmapset  *as_asyncplans;	/* asynchronous plans indexes */
+	int			as_nasyncplans; /* # of asynchronous plans */
+	AsyncRequest **as_asyncrequests;	/* array of AsyncRequests */
+	TupleTableSlot **as_asyncresults;	/* unreturned results of async plans */
+	int			as_nasyncresults;	/* # of valid entries in as_asyncresults */
+	bool		as_syncdone;	/* true if all synchronous plans done in
+								 * asynchronous mode, else false */
+	int			as_nasyncremain;	/* # of remaining asynchronous plans */
+	Bitmapset  *as_needrequest; /* asynchronous plans needing a new request */
+	struct WaitEventSet *as_eventset;	/* WaitEventSet used to configure file
+										 * descriptor wait events */
 	int			as_first_partial_plan;	/* Index of 'appendplans' containing
 										 * the first partial plan */
 	ParallelAppendState *as_pstate; /* parallel coordination info */
 	Size		pstate_len;		/* size of parallel coordination info */
 	struct PartitionPruneState *as_prune_state;
 	Bitmapset  *as_valid_subplans;
+	Bitmapset  *as_valid_asyncplans;	/* valid asynchronous plans indexes */
 	bool		(*choose_next_subplan) (AppendState *);
 };
 
@@ -1841,6 +1882,10 @@ typedef struct JoinState
  *		NeedNewOuter	   true if need new outer tuple on next call
  *		MatchedOuter	   true if found a join match for current outer tuple
  *		NullInnerTupleSlot prepared null tuple for left outer joins
+ *
+ *		The nl_Cache* fields implement replay of the inner plan's result
+ *		when consecutive outer tuples supply identical parameter values;
+ *		see nodeNestloop.c for details.
  * ----------------
  */
 typedef struct NestLoopState
@@ -1849,6 +1894,19 @@ typedef struct NestLoopState
 	bool		nl_NeedNewOuter;
 	bool		nl_MatchedOuter;
 	TupleTableSlot *nl_NullInnerTupleSlot;
+	bool		nl_CacheUsable; /* is inner result safe to cache at all? */
+	bool		nl_CacheComplete;	/* cache holds the previous parameters'
+									 * complete inner result */
+	bool		nl_CacheFilling;	/* currently appending inner tuples */
+	bool		nl_CacheReplay; /* currently reading back cached tuples */
+	int			nl_NumParams;	/* length of the per-parameter arrays */
+	Datum	   *nl_LastParamValues; /* parameters the cache was filled with */
+	bool	   *nl_LastParamNulls;
+	int16	   *nl_ParamTypLens;	/* typlen of each parameter's type */
+	bool	   *nl_ParamTypByVals;	/* typbyval of each parameter's type */
+	MemoryContext nl_ParamCxt;	/* holds nl_LastParamValues' datums */
+	Tuplestorestate *nl_CacheStore; /* stored inner tuples */
+	TupleTableSlot *nl_CacheSlot;	/* for reading back from nl_CacheStore */
 } NestLoopState;
 
 /* ----------------
@@ -1971,6 +2029,11 @@ typedef struct MaterialState
 	int			eflags;			/* capability flags to pass to tuplestore */
 	bool		eof_underlying; /* reached end of underlying plan? */
 	Tuplestorestate *tuplestorestate;
+
+	/* these fields are used for a parallel-aware Material */
+	struct ParallelMaterialState *parallel_state;	/* shared state in DSM */
+	struct SharedTuplestoreAccessor *sts;	/* accessor for shared store */
+	bool		sts_ready;		/* true once shared store is built */
 } MaterialState;
 
 /* ----------------
@@ -2001,6 +2064,39 @@ typedef struct SortState
 	SharedSortInfo *shared_info;	/* one entry per worker */
 } SortState;
 
+/*
+ * PresortedKeyData - for detecting prefix-key group boundaries in an
+ * incremental sort
+ */
+typedef struct PresortedKeyData
+{
+	FmgrInfo	flinfo;			/* comparison function info */
+	FunctionCallInfo fcinfo;	/* comparison function call info */
+	OffsetNumber attno;			/* attribute number in tuple */
+} PresortedKeyData;
+
+/* ----------------
+ *	 IncrementalSortState information
+ * ----------------
+ */
+typedef struct IncrementalSortState
+{
+	ScanState	ss;				/* its first field is NodeTag */
+	bool		bounded;		/* is the result set bounded? */
+	int64		bound;			/* if bounded, how many tuples are needed */
+	bool		outerNodeDone;	/* finished fetching tuples from outer node */
+	bool		sort_Done;		/* sort of current group completed yet? */
+	int64		bound_Done;		/* tuples already returned across groups */
+	int64		group_count;	/* number of groups sorted so far */
+	void	   *tuplesortstate; /* private state of tuplesort.c */
+	/* the keys by which the input is already sorted */
+	PresortedKeyData *presorted_keys;
+	/* slot holding the first tuple of the group being collected */
+	TupleTableSlot *group_pivot;
+	/* slot for the first tuple of the next group, fetched too early */
+	TupleTableSlot *transfer_tuple;
+} IncrementalSortState;
+
 /* ---------------------
  *	GroupState information
  * ---------------------
@@ -2071,10 +2167,25 @@ typedef struct AggState
 	HeapTuple	grp_firstTuple; /* copy of first tuple of current group */
 	/* these fields are used in AGG_HASHED and AGG_MIXED modes: */
 	bool		table_filled;	/* hash table filled yet? */
+	bool		hash_release_on_exhaust;	/* free hash tables once output
+											 * is exhausted? */
+	bool		hash_released;	/* hash tables have been freed */
 	int			num_hashes;
 	AggStatePerHash perhash;	/* array of per-hashtable data */
 	AggStatePerGroup *hash_pergroup;	/* grouping set indexed array of
 										 * per-group pointers */
+	/* these fields are used for spilling the hash table to disk: */
+	bool		hash_spill_ok;	/* may the hash table spill to disk? */
+	bool		hash_spill_mode;	/* we hit a limit during the current batch
+									 * and must not create new groups */
+	bool		hash_ever_spilled;	/* ever spilled during this execution? */
+	long		hash_ngroups_limit; /* allowed number of groups per batch */
+	long		hash_ngroups_current;	/* groups created in current batch */
+	int			hash_batch_bits;	/* hash bits consumed by current batch */
+	struct HashAggSpill *hash_spill;	/* current-batch spill state, if any */
+	List	   *hash_batches;	/* pending spilled batches (HashAggBatch) */
+	TupleTableSlot *hash_spill_slot;	/* slot for reading back spilled
+										 * tuples */
 
 	/* support for evaluation of agg input expressions: */
 #define FIELDNO_AGGSTATE_ALL_PERGROUPS 34
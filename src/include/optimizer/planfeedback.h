@@ -0,0 +1,25 @@
+/*-------------------------------------------------------------------------
+ *
+ * planfeedback.h
+ *	  prototypes for planfeedback.c.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/optimizer/planfeedback.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef PLANFEEDBACK_H
+#define PLANFEEDBACK_H
+
+#include "executor/execdesc.h"
+#include "nodes/pathnodes.h"
+
+/* GUC parameter */
+extern PGDLLIMPORT bool plan_cache_feedback;
+
+extern double plan_feedback_correction(PlannerInfo *root, RelOptInfo *rel);
+extern void plan_feedback_record(QueryDesc *queryDesc);
+
+#endif							/* PLANFEEDBACK_H */
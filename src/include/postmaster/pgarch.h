@@ -26,6 +26,62 @@
 #define MAX_XFN_CHARS	40
 #define VALID_XFN_CHARS "0123456789ABCDEF.history.backup.partial"
 
+/* ----------
+ * Archive module API
+ *
+ * Instead of a shell archive_command, a loadable module can be named with
+ * archive_library.  The library's _PG_archive_module_init() function is
+ * called once, at archiver startup, to fill in a set of callbacks; the
+ * archiver then calls back into the library for each WAL file (or batch of
+ * files) to be archived, with no fork/exec per segment.
+ * ----------
+ */
+
+/*
+ * Returns true if the module is ready to archive; if it returns false, the
+ * archiver emits a warning and tries again later.
+ */
+typedef bool (*ArchiveCheckConfiguredCB) (void);
+
+/*
+ * Archives one WAL file.  'file' is the base name and 'path' its path
+ * relative to the data directory.  Returns true on success; on failure the
+ * file is retried later.
+ */
+typedef bool (*ArchiveFileCB) (const char *file, const char *path);
+
+/*
+ * Archives a batch of WAL files, oldest first.  The module must archive a
+ * prefix of the array (files must be durably archived in order) and return
+ * the number of files successfully archived; any remainder is retried
+ * later.  This callback is optional; when it is not set, archive_file_cb is
+ * called for each file individually.
+ */
+typedef int (*ArchiveBatchCB) (int nfiles, const char *const *files,
+							   const char *const *paths);
+
+/*
+ * Called once just before the archiver process exits.
+ */
+typedef void (*ArchiveShutdownCB) (void);
+
+typedef struct ArchiveModuleCallbacks
+{
+	ArchiveCheckConfiguredCB check_configured_cb;
+	ArchiveFileCB archive_file_cb;
+	ArchiveBatchCB archive_batch_cb;
+	ArchiveShutdownCB shutdown_cb;
+} ArchiveModuleCallbacks;
+
+/*
+ * Type of the shared library symbol _PG_archive_module_init that is looked
+ * up when archive_library is loaded.
+ */
+typedef void (*ArchiveModuleInit) (ArchiveModuleCallbacks *cb);
+
+/* GUC */
+extern char *XLogArchiveLibrary;
+
 /* ----------
  * Functions called from postmaster
  * ----------
@@ -53,6 +53,12 @@ typedef struct LogicalDecodingContext
 	OutputPluginCallbacks callbacks;
 	OutputPluginOptions options;
 
+	/*
+	 * Does the output plugin support streaming of in-progress transactions,
+	 * i.e. did it register the full set of stream callbacks?
+	 */
+	bool		streaming;
+
 	/*
 	 * User specified options
 	 */
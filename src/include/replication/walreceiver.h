@@ -25,6 +25,7 @@
 /* user-settable parameters */
 extern int	wal_receiver_status_interval;
 extern int	wal_receiver_timeout;
+extern int	wal_receiver_write_size;
 extern bool hot_standby_feedback;
 
 /*
@@ -172,22 +172,36 @@ typedef struct buftag
  * atomic operations (i.e. only pg_atomic_read_u32() and
  * pg_atomic_unlocked_write_u32()).
  *
- * Be careful to avoid increasing the size of the struct when adding or
- * reordering members.  Keeping it below 64 bytes (the most common CPU
- * cache line size) is fairly important for performance.
+ * The descriptor is laid out as two cache lines on 64-bit builds: the
+ * frequently written fields (the state word that pin/unpin hammers with CAS
+ * loops, the content lock, and the freelist link) occupy the first line,
+ * while the read-mostly identity fields (tag and pin-count-waiter PID) are
+ * padded onto a line of their own.  That way the scans that read tags
+ * without pinning, such as DropRelFileNodeBuffers() and the checkpointer's
+ * buffer sweep, are not invalidated by every pin and unpin.  Be careful to
+ * avoid pushing either group past its cache line when adding or reordering
+ * members.
  */
+#define BUFFERDESC_HOT_PAD_TO_SIZE \
+	(64 - sizeof(pg_atomic_uint32) - 2 * sizeof(int) - sizeof(LWLock))
+
 typedef struct BufferDesc
 {
-	BufferTag	tag;			/* ID of page contained in buffer */
-	int			buf_id;			/* buffer's index number (from 0) */
-
 	/* state of the tag, containing flags, refcount and usagecount */
 	pg_atomic_uint32 state;
 
-	int			wait_backend_pid;	/* backend PID of pin-count waiter */
+	int			buf_id;			/* buffer's index number (from 0) */
 	int			freeNext;		/* link in freelist chain */
 
 	LWLock		content_lock;	/* to lock access to buffer contents */
+
+#if SIZEOF_VOID_P == 8 && !defined(LOCK_DEBUG)
+	/* start the read-mostly identity fields on their own cache line */
+	char		hot_padding[BUFFERDESC_HOT_PAD_TO_SIZE];
+#endif
+
+	BufferTag	tag;			/* ID of page contained in buffer */
+	int			wait_backend_pid;	/* backend PID of pin-count waiter */
 } BufferDesc;
 
 /*
@@ -205,12 +219,15 @@ typedef struct BufferDesc
  * Note that local buffer descriptors aren't forced to be aligned - as there's
  * no concurrent access to those it's unlikely to be beneficial.
  *
- * We use 64bit as the cache line size here, because that's the most common
- * size. Making it bigger would be a waste of memory. Even if running on a
- * platform with either 32 or 128 byte line sizes, it's good to align to
- * boundaries and avoid false sharing.
+ * We use 64 bytes as the cache line size here, because that's the most
+ * common size. Making it bigger would be a waste of memory. Even if running
+ * on a platform with either 32 or 128 byte line sizes, it's good to align
+ * to boundaries and avoid false sharing.
+ *
+ * The descriptor itself spans two lines on 64-bit builds (see the comments
+ * above BufferDesc), so the stride is two cache lines there.
  */
-#define BUFFERDESC_PAD_TO_SIZE	(SIZEOF_VOID_P == 8 ? 64 : 1)
+#define BUFFERDESC_PAD_TO_SIZE	(SIZEOF_VOID_P == 8 ? 128 : 1)
 
 typedef union BufferDescPadded
 {
@@ -313,7 +330,9 @@ extern void StrategyFreeBuffer(BufferDesc *buf);
 extern bool StrategyRejectBuffer(BufferAccessStrategy strategy,
 								 BufferDesc *buf);
 
-extern int	StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc);
+extern int	StrategySyncStart(uint32 *complete_passes, uint32 *num_buf_alloc,
+							  uint32 *num_backend_writes);
+extern void StrategyReportBackendWrite(void);
 extern void StrategyNotifyBgWriter(int bgwprocno);
 
 extern Size StrategyShmemSize(void);
@@ -47,6 +47,27 @@ typedef enum
 								 * replay; otherwise same as RBM_NORMAL */
 } ReadBufferMode;
 
+/*
+ * State for a read that has been split into StartReadBuffer() and
+ * WaitReadBuffer(), so that several reads can be in flight at once.
+ * Callers should treat the contents as opaque.
+ */
+typedef struct ReadBufferOp
+{
+	Relation	rel;
+	ForkNumber	forkNum;
+	BlockNumber blockNum;
+	BufferAccessStrategy strategy;
+	Buffer		pinned_buffer;	/* already pinned, or InvalidBuffer */
+} ReadBufferOp;
+
+/*
+ * Maximum number of blocks that ReadBufferExtent() fetches in one call.
+ * 32 blocks is 256kB with the default BLCKSZ, enough for the kernel and
+ * the storage to coalesce effectively without hogging the buffer pool.
+ */
+#define READ_EXTENT_SIZE	32
+
 /* forward declared, to avoid having to expose buf_internals.h here */
 struct WritebackContext;
 
@@ -64,6 +85,9 @@ extern int	checkpoint_flush_after;
 extern int	backend_flush_after;
 extern int	bgwriter_flush_after;
 
+/* in freelist.c */
+extern int	bulk_read_ring_size;
+
 /* in buf_init.c */
 extern PGDLLIMPORT char *BufferBlocks;
 
@@ -163,6 +187,8 @@ extern PGDLLIMPORT int32 *LocalRefCount;
  * prototypes for functions in bufmgr.c
  */
 extern bool ComputeIoConcurrency(int io_concurrency, double *target);
+extern void PrefetchBufferWithoutRelcache(RelFileNode rnode,
+							  ForkNumber forkNum, BlockNumber blockNum);
 extern void PrefetchBuffer(Relation reln, ForkNumber forkNum,
 						   BlockNumber blockNum);
 extern Buffer ReadBuffer(Relation reln, BlockNumber blockNum);
@@ -173,8 +199,18 @@ extern Buffer ReadBufferWithoutRelcache(RelFileNode rnode,
 										ForkNumber forkNum, BlockNumber blockNum,
 										ReadBufferMode mode, BufferAccessStrategy strategy,
 										char relpersistence);
+extern void StartReadBuffer(Relation reln, ForkNumber forkNum,
+							BlockNumber blockNum,
+							BufferAccessStrategy strategy,
+							ReadBufferOp *op);
+extern Buffer WaitReadBuffer(ReadBufferOp *op);
+extern void ReadBufferExtent(Relation reln, ForkNumber forkNum,
+							 BlockNumber blockNum, int nblocks,
+							 BufferAccessStrategy strategy);
 extern void DiscardBuffer(RelFileNode rnode, ForkNumber forkNum,
 						  BlockNumber blockNum);
+extern void FlushBufferIfPresent(RelFileNode rnode, ForkNumber forkNum,
+								 BlockNumber blockNum);
 extern void ReleaseBuffer(Buffer buffer);
 extern void UnlockReleaseBuffer(Buffer buffer);
 extern void MarkBufferDirty(Buffer buffer);
@@ -0,0 +1,38 @@
+/*-------------------------------------------------------------------------
+ *
+ * iostats.h
+ *	  Shared-memory I/O statistics with latency histograms.
+ *
+ * Portions Copyright (c) 1996-2019, PostgreSQL Global Development Group
+ * Portions Copyright (c) 1994, Regents of the University of California
+ *
+ * src/include/storage/iostats.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef IOSTATS_H
+#define IOSTATS_H
+
+#include "common/relpath.h"
+#include "portability/instr_time.h"
+
+/* I/O operation classes tracked */
+#define IOSTAT_OP_READ		0
+#define IOSTAT_OP_WRITE		1
+#define IOSTAT_OP_EXTEND	2
+#define IOSTAT_NUM_OPS		3
+
+/* object classes: one per relation fork, plus undo log storage */
+#define IOSTAT_OBJ_UNDO		(MAX_FORKNUM + 1)
+#define IOSTAT_NUM_OBJECTS	(MAX_FORKNUM + 2)
+
+/* number of log2(microseconds) latency histogram buckets */
+#define IOSTAT_NUM_BUCKETS	16
+
+extern Size IOStatsShmemSize(void);
+extern void IOStatsShmemInit(void);
+
+extern void iostat_io_begin(instr_time *start);
+extern void iostat_io_end(int object, int op, instr_time start);
+
+#endif							/* IOSTATS_H */
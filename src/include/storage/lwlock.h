@@ -116,8 +116,16 @@ extern PGDLLIMPORT int NamedLWLockTrancheRequests;
 #define LOG2_NUM_LOCK_PARTITIONS  4
 #define NUM_LOCK_PARTITIONS  (1 << LOG2_NUM_LOCK_PARTITIONS)
 
-/* Number of partitions the shared predicate lock tables are divided into */
-#define LOG2_NUM_PREDICATELOCK_PARTITIONS  4
+/*
+ * Number of partitions the shared predicate lock tables are divided into.
+ *
+ * This is deliberately larger than NUM_LOCK_PARTITIONS: SERIALIZABLE
+ * workloads take an SIREAD lock on nearly every object they read, so the
+ * predicate lock hash sees much more traffic per transaction than the
+ * regular lock hash, and on many-core machines sixteen partitions become a
+ * bottleneck before anything else in the lock manager does.
+ */
+#define LOG2_NUM_PREDICATELOCK_PARTITIONS  6
 #define NUM_PREDICATELOCK_PARTITIONS  (1 << LOG2_NUM_PREDICATELOCK_PARTITIONS)
 
 /* Offsets for various chunks of preallocated lwlocks. */
@@ -222,6 +230,8 @@ typedef enum BuiltinTrancheIds
 	LWTRANCHE_SXACT,
 	LWTRANCHE_UNDOLOG,
 	LWTRANCHE_UNDOFILE,
+	LWTRANCHE_UNDO_REQUEST,
+	LWTRANCHE_UNDO_FREELIST,
 	LWTRANCHE_FIRST_USER_DEFINED,
 }			BuiltinTrancheIds;
 
@@ -63,12 +63,22 @@ struct XidCache
 	(PROC_IN_VACUUM | PROC_IN_ANALYZE | PROC_VACUUM_FOR_WRAPAROUND)
 
 /*
- * We allow a small number of "weak" relation locks (AccessShareLock,
+ * We allow a limited number of "weak" relation locks (AccessShareLock,
  * RowShareLock, RowExclusiveLock) to be recorded in the PGPROC structure
- * rather than the main lock table.  This eases contention on the lock
- * manager LWLocks.  See storage/lmgr/README for additional details.
+ * (really, in separate shared-memory arrays referenced from it) rather than
+ * the main lock table.  This eases contention on the lock manager LWLocks.
+ * See storage/lmgr/README for additional details.
+ *
+ * The arrays are organized as groups of FP_LOCK_SLOTS_PER_GROUP slots, with
+ * each relation mapped (by hashing its OID) to one particular group.  The
+ * number of groups is determined at server start from
+ * max_locks_per_transaction; see InitializeFastPathLocks().
  */
-#define		FP_LOCK_SLOTS_PER_BACKEND 16
+extern PGDLLIMPORT int FastPathLockGroupsPerBackend;
+
+#define		FP_LOCK_GROUPS_PER_BACKEND_MAX	1024
+#define		FP_LOCK_SLOTS_PER_GROUP		16	/* don't change */
+#define		FP_LOCK_SLOTS_PER_BACKEND	(FP_LOCK_SLOTS_PER_GROUP * FastPathLockGroupsPerBackend)
 
 /*
  * An invalid pgprocno.  Must be larger than the maximum number of PGPROC
@@ -108,6 +118,9 @@ struct PGPROC
 								 * else InvalidLocalTransactionId */
 	int			pid;			/* Backend's process ID; 0 if prepared xact */
 	int			pgprocno;
+	int			pgxactoff;		/* offset into the dense ProcGlobal arrays
+								 * while in the procarray; only valid between
+								 * ProcArrayAdd() and ProcArrayRemove() */
 
 	/* These fields are zero while a backend is still starting up: */
 	BackendId	backendId;		/* This backend's backend ID (if assigned) */
@@ -186,12 +199,19 @@ struct PGPROC
 	XLogRecPtr	clogGroupMemberLsn; /* WAL location of commit record for clog
 									 * group member */
 
+	/* Support for group WAL space reservation. */
+	bool		walReserveMember;	/* true, if member of WAL reserve group */
+	pg_atomic_uint32 walReserveNext;	/* next WAL reserve group member */
+	int			walReserveSize; /* bytes of WAL space wanted */
+	uint64		walReserveStartBytePos; /* assigned start usable byte pos */
+	uint64		walReservePrevBytePos;	/* assigned xl_prev usable byte pos */
+
 	/* Per-backend LWLock.  Protects fields below (but not group fields). */
 	LWLock		backendLock;
 
 	/* Lock manager data, recording fast-path locks taken by this backend. */
-	uint64		fpLockBits;		/* lock modes held for each fast-path slot */
-	Oid			fpRelId[FP_LOCK_SLOTS_PER_BACKEND]; /* slots for rel oids */
+	uint64	   *fpLockBits;		/* lock modes held for each fast-path slot */
+	Oid		   *fpRelId;		/* slots for rel oids */
 	bool		fpVXIDLock;		/* are we holding a fast-path VXID lock? */
 	LocalTransactionId fpLocalTransactionId;	/* lxid for fast-path VXID
 												 * lock */
@@ -238,8 +258,37 @@ typedef struct PGXACT
 	uint8		nxids;
 } PGXACT;
 
+/*
+ * Per-backend status of the subtransaction-XID cache, packed for the dense
+ * mirror array in PROC_HDR.
+ */
+typedef struct XidCacheStatus
+{
+	/* number of cached subxids, never more than PGPROC_MAX_CACHED_SUBXIDS */
+	uint8		count;
+	/* has PGPROC->subxids overflowed */
+	bool		overflowed;
+} XidCacheStatus;
+
 /*
  * There is one ProcGlobal struct for the whole database cluster.
+ *
+ * The dense arrays below (xids, subxidStates, vacuumFlags) mirror the
+ * corresponding PGXACT fields for exactly the backends that are currently
+ * in the procarray, stored contiguously in procarray order and indexed by
+ * PGPROC->pgxactoff.  GetSnapshotData() reads only these arrays, so the
+ * snapshot loop touches far fewer cache lines than a walk over the
+ * (sparse) PGXACT array would on systems with many backend slots.  The
+ * PGXACT fields remain authoritative for all other readers; every writer
+ * must update both copies.
+ *
+ * Adding or removing a procarray entry relocates dense array elements, so
+ * ProcArrayAdd() and ProcArrayRemove() hold both ProcArrayLock and
+ * XidGenLock in exclusive mode (in that order) while doing so.  That means
+ * a backend may update its own entries while holding either just
+ * XidGenLock (as GetNewTransactionId() does) or just ProcArrayLock in any
+ * mode; entries of other backends may only be written while holding
+ * ProcArrayLock exclusively.
  */
 typedef struct PROC_HDR
 {
@@ -247,6 +296,12 @@ typedef struct PROC_HDR
 	PGPROC	   *allProcs;
 	/* Array of PGXACT structures (not including dummies for prepared txns) */
 	PGXACT	   *allPgXact;
+	/* Dense mirror of PGXACT.xid for procarray members */
+	TransactionId *xids;
+	/* Dense mirror of PGXACT.nxids/overflowed for procarray members */
+	XidCacheStatus *subxidStates;
+	/* Dense mirror of PGXACT.vacuumFlags for procarray members */
+	uint8	   *vacuumFlags;
 	/* Length of allProcs array */
 	uint32		allProcCount;
 	/* Head of list of free PGPROC structures */
@@ -46,6 +46,7 @@ extern void undofile_immedsync(SMgrRelation reln, ForkNumber forknum);
 
 /* Callbacks used by sync.c. */
 extern int undofile_syncfiletag(const FileTag *tag, char *path);
+extern int undofile_presyncfiletag(const FileTag *tag, char *path);
 extern bool undofile_filetagmatches(const FileTag *tag, const FileTag *candidate);
 
 /* Management of checkpointer requests. */
@@ -75,6 +75,8 @@ extern void generate_operator_clause(fmStringInfo buf,
 extern int	bpchartruelen(char *s, int len);
 
 /* popular functions from varlena.c */
+extern bool trust_strxfrm;
+
 extern text *cstring_to_text(const char *s);
 extern text *cstring_to_text_with_len(const char *s, int len);
 extern char *text_to_cstring(const text *t);
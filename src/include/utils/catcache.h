@@ -118,6 +118,7 @@ typedef struct catctup
 	int			refcount;		/* number of active references */
 	bool		dead;			/* dead but not yet removed? */
 	bool		negative;		/* negative cache entry? */
+	bool		recently_used;	/* accessed since last eviction sweep? */
 	HeapTupleData tuple;		/* tuple management header */
 
 	/*
@@ -189,6 +190,9 @@ typedef struct catcacheheader
 /* this extern duplicates utils/memutils.h... */
 extern PGDLLIMPORT MemoryContext CacheMemoryContext;
 
+/* GUC: limit on total number of catcache entries, or -1 for no limit */
+extern int	syscache_max_entries;
+
 extern void CreateCacheMemoryContext(void);
 
 extern CatCache *InitCatCache(int id, Oid reloid, Oid indexoid,
@@ -405,6 +405,7 @@ extern int	Log_error_verbosity;
 extern char *Log_line_prefix;
 extern int	Log_destination;
 extern char *Log_destination_string;
+extern bool Log_async;
 extern bool syslog_sequence_numbers;
 extern bool syslog_split_messages;
 
@@ -26,6 +26,14 @@ extern Datum hash_any_extended(const unsigned char *k,
 extern Datum hash_uint32(uint32 k);
 extern Datum hash_uint32_extended(uint32 k, uint64 seed);
 
+/*
+ * Faster alternatives for hash values that never reach disk or the wire.
+ * These may change from release to release; anything needing a stable hash
+ * must use hash_any() and friends above.
+ */
+extern uint32 hash_bytes_fast(const unsigned char *k, Size keylen);
+extern uint32 hash_uint32_fast(uint32 k);
+
 /*
  * Combine two 32-bit hash values, resulting in another hash value, with
  * decent bit mixing.
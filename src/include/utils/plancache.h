@@ -19,6 +19,7 @@
 #include "lib/ilist.h"
 #include "nodes/params.h"
 #include "utils/queryenvironment.h"
+#include "utils/resowner.h"
 
 /* Forward declaration, to avoid including parsenodes.h here */
 struct RawStmt;
@@ -128,6 +129,13 @@ typedef struct CachedPlanSource
 	double		generic_cost;	/* cost of generic plan, or -1 if not known */
 	double		total_custom_cost;	/* total cost of custom plans so far */
 	int			num_custom_plans;	/* number of plans included in total */
+	/* Run-time feedback reported via CachedPlanReportExecTime (msec): */
+	double		total_generic_exec_time;	/* total observed time of generic
+											 * plan executions */
+	int			num_generic_execs;	/* number of executions in total */
+	double		total_custom_exec_time; /* total observed time of custom plan
+										 * executions */
+	int			num_custom_execs;	/* number of executions in total */
 } CachedPlanSource;
 
 /*
@@ -218,6 +226,15 @@ extern CachedPlan *GetCachedPlan(CachedPlanSource *plansource,
 								 bool useResOwner,
 								 QueryEnvironment *queryEnv);
 extern void ReleaseCachedPlan(CachedPlan *plan, bool useResOwner);
+extern bool CachedPlanAllowsSimpleValidityCheck(CachedPlanSource *plansource,
+												CachedPlan *plan,
+												ResourceOwner owner);
+extern bool CachedPlanIsSimplyValid(CachedPlanSource *plansource,
+									CachedPlan *plan,
+									ResourceOwner owner);
+extern void CachedPlanReportExecTime(CachedPlanSource *plansource,
+									 CachedPlan *plan,
+									 double exec_time);
 
 extern CachedExpression *GetCachedExpression(Node *expr);
 extern void FreeCachedExpression(CachedExpression *cexpr);
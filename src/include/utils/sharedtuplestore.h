@@ -58,4 +58,9 @@ extern void sts_puttuple(SharedTuplestoreAccessor *accessor,
 extern MinimalTuple sts_parallel_scan_next(SharedTuplestoreAccessor *accessor,
 										   void *meta_data);
 
+extern void sts_begin_private_scan(SharedTuplestoreAccessor *accessor);
+
+extern MinimalTuple sts_private_scan_next(SharedTuplestoreAccessor *accessor,
+										  void *meta_data);
+
 #endif							/* SHAREDTUPLESTORE_H */
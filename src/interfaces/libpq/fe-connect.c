@@ -3812,6 +3812,7 @@ makeEmptyPGconn(void)
 	conn->status = CONNECTION_BAD;
 	conn->asyncStatus = PGASYNC_IDLE;
 	conn->xactStatus = PQTRANS_IDLE;
+	conn->pipelineStatus = PQ_PIPELINE_OFF;
 	conn->options_valid = false;
 	conn->nonblocking = false;
 	conn->setenv_state = SETENV_STATE_IDLE;
@@ -3993,6 +3994,22 @@ freePGconn(PGconn *conn)
 	/* Note that conn->Pfdebug is not ours to close or free */
 	if (conn->last_query)
 		free(conn->last_query);
+	while (conn->cmd_queue_head != NULL)
+	{
+		PGcmdQueueEntry *cur = conn->cmd_queue_head;
+
+		conn->cmd_queue_head = cur->next;
+		if (cur->query)
+			free(cur->query);
+		free(cur);
+	}
+	while (conn->cmd_queue_recycle != NULL)
+	{
+		PGcmdQueueEntry *cur = conn->cmd_queue_recycle;
+
+		conn->cmd_queue_recycle = cur->next;
+		free(cur);
+	}
 	if (conn->write_err_msg)
 		free(conn->write_err_msg);
 	if (conn->inBuffer)
@@ -4082,6 +4099,10 @@ closePGconn(PGconn *conn)
 	conn->status = CONNECTION_BAD;	/* Well, not really _bad_ - just absent */
 	conn->asyncStatus = PGASYNC_IDLE;
 	conn->xactStatus = PQTRANS_IDLE;
+	conn->pipelineStatus = PQ_PIPELINE_OFF;
+	/* Drop any commands still queued for a pipeline */
+	while (conn->cmd_queue_head != NULL)
+		pqCommandQueueAdvance(conn);
 	pqClearAsyncResult(conn);	/* deallocate result */
 	resetPQExpBuffer(&conn->errorMessage);
 	release_conn_addrinfo(conn);
@@ -40,7 +40,9 @@ char	   *const pgresStatus[] = {
 	"PGRES_NONFATAL_ERROR",
 	"PGRES_FATAL_ERROR",
 	"PGRES_COPY_BOTH",
-	"PGRES_SINGLE_TUPLE"
+	"PGRES_SINGLE_TUPLE",
+	"PGRES_PIPELINE_SYNC",
+	"PGRES_PIPELINE_ABORTED"
 };
 
 /*
@@ -55,6 +57,11 @@ static PGEvent *dupEvents(PGEvent *events, int count, size_t *memSize);
 static bool pqAddTuple(PGresult *res, PGresAttValue *tup,
 					   const char **errmsgp);
 static bool PQsendQueryStart(PGconn *conn);
+static int	pqSendQueryFinish(PGconn *conn, PGQueryClass queryclass,
+							  const char *query);
+static PGcmdQueueEntry *pqAllocCmdQueueEntry(PGconn *conn);
+static void pqAppendCmdQueueEntry(PGconn *conn, PGcmdQueueEntry *entry);
+static void pqRecycleCmdQueueEntry(PGconn *conn, PGcmdQueueEntry *entry);
 static int	PQsendQueryGuts(PGconn *conn,
 							const char *command,
 							const char *stmtName,
@@ -1210,8 +1217,8 @@ pqRowProcessor(PGconn *conn, const char **errmsgp)
 		/* Stash old result for re-use later */
 		conn->next_result = conn->result;
 		conn->result = res;
-		/* And mark the result ready to return */
-		conn->asyncStatus = PGASYNC_READY;
+		/* And mark the result ready to return, with more to follow */
+		conn->asyncStatus = PGASYNC_READY_MORE;
 	}
 
 	return 1;
@@ -1237,6 +1244,14 @@ PQsendQuery(PGconn *conn, const char *query)
 	if (!PQsendQueryStart(conn))
 		return 0;
 
+	/* Simple-Query protocol doesn't fit the pipeline model */
+	if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+	{
+		printfPQExpBuffer(&conn->errorMessage,
+						  libpq_gettext("PQsendQuery not allowed in pipeline mode\n"));
+		return 0;
+	}
+
 	/* check the argument */
 	if (!query)
 	{
@@ -1389,29 +1404,18 @@ PQsendPrepare(PGconn *conn,
 	if (pqPutMsgEnd(conn) < 0)
 		goto sendFailed;
 
-	/* construct the Sync message */
-	if (pqPutMsgStart('S', false, conn) < 0 ||
-		pqPutMsgEnd(conn) < 0)
-		goto sendFailed;
-
-	/* remember we are doing just a Parse */
-	conn->queryclass = PGQUERY_PREPARE;
-
-	/* and remember the query text too, if possible */
-	/* if insufficient memory, last_query just winds up NULL */
-	if (conn->last_query)
-		free(conn->last_query);
-	conn->last_query = strdup(query);
+	/* construct the Sync message, unless a pipeline is collecting commands */
+	if (conn->pipelineStatus == PQ_PIPELINE_OFF)
+	{
+		if (pqPutMsgStart('S', false, conn) < 0 ||
+			pqPutMsgEnd(conn) < 0)
+			goto sendFailed;
+	}
 
-	/*
-	 * Give the data a push.  In nonblock mode, don't complain if we're unable
-	 * to send it all; PQgetResult() will do any additional flushing needed.
-	 */
-	if (pqFlush(conn) < 0)
+	/* remember we are doing just a Parse, then launch or enqueue it */
+	if (!pqSendQueryFinish(conn, PGQUERY_PREPARE, query))
 		goto sendFailed;
 
-	/* OK, it's launched! */
-	conn->asyncStatus = PGASYNC_BUSY;
 	return 1;
 
 sendFailed:
@@ -1480,14 +1484,38 @@ PQsendQueryStart(PGconn *conn)
 						  libpq_gettext("no connection to the server\n"));
 		return false;
 	}
-	/* Can't send while already busy, either. */
-	if (conn->asyncStatus != PGASYNC_IDLE)
+	/* Can't send while already busy, either, unless enqueuing for later */
+	if (conn->asyncStatus != PGASYNC_IDLE &&
+		conn->pipelineStatus == PQ_PIPELINE_OFF)
 	{
 		printfPQExpBuffer(&conn->errorMessage,
 						  libpq_gettext("another command is already in progress\n"));
 		return false;
 	}
 
+	if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+	{
+		/*
+		 * When enqueuing a command into a pipeline we don't change much of
+		 * the connection state, since it's still in use by the command
+		 * currently being processed; the rest is updated when
+		 * pqPipelineProcessQueue() advances to the queued command.  We do
+		 * need to reject this during COPY, though.
+		 */
+		switch (conn->asyncStatus)
+		{
+			case PGASYNC_COPY_IN:
+			case PGASYNC_COPY_OUT:
+			case PGASYNC_COPY_BOTH:
+				printfPQExpBuffer(&conn->errorMessage,
+								  libpq_gettext("cannot queue commands during COPY\n"));
+				return false;
+			default:
+				break;
+		}
+		return true;
+	}
+
 	/* initialize async result-accumulation state */
 	pqClearAsyncResult(conn);
 
@@ -1638,20 +1666,66 @@ PQsendQueryGuts(PGconn *conn,
 		pqPutMsgEnd(conn) < 0)
 		goto sendFailed;
 
-	/* construct the Sync message */
-	if (pqPutMsgStart('S', false, conn) < 0 ||
-		pqPutMsgEnd(conn) < 0)
+	/* construct the Sync message, unless a pipeline is collecting commands */
+	if (conn->pipelineStatus == PQ_PIPELINE_OFF)
+	{
+		if (pqPutMsgStart('S', false, conn) < 0 ||
+			pqPutMsgEnd(conn) < 0)
+			goto sendFailed;
+	}
+
+	/* remember we are using extended query protocol, and launch or enqueue */
+	if (!pqSendQueryFinish(conn, PGQUERY_EXTENDED, command))
 		goto sendFailed;
 
-	/* remember we are using extended query protocol */
-	conn->queryclass = PGQUERY_EXTENDED;
+	return 1;
+
+sendFailed:
+	/* error message should be set up already */
+	return 0;
+}
+
+/*
+ * pqSendQueryFinish
+ *		Common tail code for launching a command in any protocol flavor.
+ *
+ * Outside pipeline mode, this retains the historical behavior: record the
+ * query class and text in the connection, flush, and mark the connection
+ * busy.  In pipeline mode, the command is instead appended to the pending
+ * command queue and no flush is forced; data accumulates in the output
+ * buffer (pqPutMsgEnd flushes automatically whenever it grows large) until
+ * PQpipelineSync() or PQflush() pushes it out.
+ */
+static int
+pqSendQueryFinish(PGconn *conn, PGQueryClass queryclass, const char *query)
+{
+	if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+	{
+		PGcmdQueueEntry *entry;
+
+		entry = pqAllocCmdQueueEntry(conn);
+		if (entry == NULL)
+			return 0;
+		entry->queryclass = queryclass;
+		/* if insufficient memory, query just winds up NULL */
+		if (query)
+			entry->query = strdup(query);
+		pqAppendCmdQueueEntry(conn, entry);
+
+		/* If the connection is idle, this command becomes current at once */
+		if (conn->asyncStatus == PGASYNC_IDLE)
+			pqPipelineProcessQueue(conn);
+		return 1;
+	}
+
+	conn->queryclass = queryclass;
 
 	/* and remember the query text too, if possible */
 	/* if insufficient memory, last_query just winds up NULL */
 	if (conn->last_query)
 		free(conn->last_query);
-	if (command)
-		conn->last_query = strdup(command);
+	if (query)
+		conn->last_query = strdup(query);
 	else
 		conn->last_query = NULL;
 
@@ -1660,15 +1734,11 @@ PQsendQueryGuts(PGconn *conn,
 	 * to send it all; PQgetResult() will do any additional flushing needed.
 	 */
 	if (pqFlush(conn) < 0)
-		goto sendFailed;
+		return 0;
 
 	/* OK, it's launched! */
 	conn->asyncStatus = PGASYNC_BUSY;
 	return 1;
-
-sendFailed:
-	/* error message should be set up already */
-	return 0;
 }
 
 /*
@@ -1696,6 +1766,310 @@ PQsetSingleRowMode(PGconn *conn)
 	return 1;
 }
 
+/*
+ * pqAllocCmdQueueEntry
+ *		Get a command queue entry for caller to fill, from the freelist if
+ *		possible.
+ */
+static PGcmdQueueEntry *
+pqAllocCmdQueueEntry(PGconn *conn)
+{
+	PGcmdQueueEntry *entry;
+
+	if (conn->cmd_queue_recycle == NULL)
+	{
+		entry = (PGcmdQueueEntry *) malloc(sizeof(PGcmdQueueEntry));
+		if (entry == NULL)
+		{
+			printfPQExpBuffer(&conn->errorMessage,
+							  libpq_gettext("out of memory\n"));
+			return NULL;
+		}
+	}
+	else
+	{
+		entry = conn->cmd_queue_recycle;
+		conn->cmd_queue_recycle = entry->next;
+	}
+	entry->next = NULL;
+	entry->query = NULL;
+
+	return entry;
+}
+
+/*
+ * pqAppendCmdQueueEntry
+ *		Append a caller-filled entry to the end of the command queue.
+ */
+static void
+pqAppendCmdQueueEntry(PGconn *conn, PGcmdQueueEntry *entry)
+{
+	if (conn->cmd_queue_head == NULL)
+		conn->cmd_queue_head = entry;
+	else
+		conn->cmd_queue_tail->next = entry;
+	conn->cmd_queue_tail = entry;
+}
+
+/*
+ * pqRecycleCmdQueueEntry
+ *		Push a no-longer-needed entry onto the freelist for later reuse.
+ */
+static void
+pqRecycleCmdQueueEntry(PGconn *conn, PGcmdQueueEntry *entry)
+{
+	if (entry == NULL)
+		return;
+	if (entry->query)
+	{
+		free(entry->query);
+		entry->query = NULL;
+	}
+	entry->next = conn->cmd_queue_recycle;
+	conn->cmd_queue_recycle = entry;
+}
+
+/*
+ * pqCommandQueueAdvance
+ *		Remove the head of the command queue; all of its results have been
+ *		returned to the application.
+ */
+void
+pqCommandQueueAdvance(PGconn *conn)
+{
+	PGcmdQueueEntry *prevquery;
+
+	if (conn->cmd_queue_head == NULL)
+		return;
+
+	prevquery = conn->cmd_queue_head;
+	conn->cmd_queue_head = prevquery->next;
+	if (conn->cmd_queue_head == NULL)
+		conn->cmd_queue_tail = NULL;
+	pqRecycleCmdQueueEntry(conn, prevquery);
+}
+
+/*
+ * pqPipelineProcessQueue
+ *		If the connection is idle and a queued command is pending, make it
+ *		the current command and resume parsing its results.
+ *
+ * In an aborted pipeline, the backend discards everything up to the next
+ * Sync without responding, so commands queued after the failed one never
+ * drew any server reply; we manufacture a PGRES_PIPELINE_ABORTED result for
+ * each of them here instead.
+ */
+void
+pqPipelineProcessQueue(PGconn *conn)
+{
+	PGcmdQueueEntry *next_query;
+
+	if (conn->pipelineStatus == PQ_PIPELINE_OFF ||
+		conn->asyncStatus != PGASYNC_IDLE ||
+		conn->cmd_queue_head == NULL)
+		return;
+
+	next_query = conn->cmd_queue_head;
+
+	/* initialize async result-accumulation state */
+	pqClearAsyncResult(conn);
+
+	/* reset single-row processing mode */
+	conn->singleRowMode = false;
+
+	/* the queue head is now the current command */
+	conn->queryclass = next_query->queryclass;
+	if (conn->last_query)
+		free(conn->last_query);
+	if (next_query->query)
+		conn->last_query = strdup(next_query->query);
+	else
+		conn->last_query = NULL;
+
+	if (conn->pipelineStatus == PQ_PIPELINE_ABORTED &&
+		conn->queryclass != PGQUERY_SYNC)
+	{
+		/*
+		 * This command didn't run; report that, and let PQgetResult advance
+		 * the queue when the application collects the result.
+		 */
+		conn->result = PQmakeEmptyPGresult(conn, PGRES_PIPELINE_ABORTED);
+		if (!conn->result)
+		{
+			printfPQExpBuffer(&conn->errorMessage,
+							  libpq_gettext("out of memory\n"));
+			pqSaveErrorResult(conn);
+		}
+		conn->asyncStatus = PGASYNC_READY;
+	}
+	else
+	{
+		/* allow parsing of the command's results to proceed */
+		conn->asyncStatus = PGASYNC_BUSY;
+	}
+}
+
+/*
+ * PQenterPipelineMode
+ *		Start pipeline mode.
+ *
+ * No attempt is made to send anything to the server; this only changes
+ * libpq's behavior: subsequent PQsendQueryParams/PQsendPrepare/
+ * PQsendQueryPrepared/PQsendDescribe* calls are queued without a trailing
+ * Sync, allowing many commands to be in flight on the connection at once.
+ */
+int
+PQenterPipelineMode(PGconn *conn)
+{
+	if (!conn)
+		return 0;
+
+	if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+		return 1;
+
+	if (conn->asyncStatus != PGASYNC_IDLE)
+	{
+		printfPQExpBuffer(&conn->errorMessage,
+						  libpq_gettext("cannot enter pipeline mode, connection not idle\n"));
+		return 0;
+	}
+
+	conn->pipelineStatus = PQ_PIPELINE_ON;
+	return 1;
+}
+
+/*
+ * PQexitPipelineMode
+ *		End pipeline mode.
+ *
+ * This fails if there are pending commands or uncollected results; the
+ * application must drain the pipeline first, normally by sending
+ * PQpipelineSync and reading results up to the PGRES_PIPELINE_SYNC one.
+ */
+int
+PQexitPipelineMode(PGconn *conn)
+{
+	if (!conn)
+		return 0;
+
+	if (conn->pipelineStatus == PQ_PIPELINE_OFF)
+		return 1;
+
+	switch (conn->asyncStatus)
+	{
+		case PGASYNC_READY:
+		case PGASYNC_READY_MORE:
+			/* there are some uncollected results */
+			printfPQExpBuffer(&conn->errorMessage,
+							  libpq_gettext("cannot exit pipeline mode with uncollected results\n"));
+			return 0;
+
+		case PGASYNC_BUSY:
+			printfPQExpBuffer(&conn->errorMessage,
+							  libpq_gettext("cannot exit pipeline mode while busy\n"));
+			return 0;
+
+		default:
+			break;
+	}
+
+	/* still commands queued for which no results have been collected */
+	if (conn->cmd_queue_head != NULL)
+	{
+		printfPQExpBuffer(&conn->errorMessage,
+						  libpq_gettext("cannot exit pipeline mode with uncollected results\n"));
+		return 0;
+	}
+
+	conn->pipelineStatus = PQ_PIPELINE_OFF;
+
+	/* Flush any pending data in the output buffer */
+	if (pqFlush(conn) < 0)
+		return 0;				/* error message is setup already */
+	return 1;
+}
+
+/*
+ * PQpipelineSync
+ *		Send a Sync message, marking the end of one pipeline unit, and
+ *		flush all queued output to the server.
+ *
+ * The server executes everything up to the Sync as one implicit
+ * transaction and then replies ReadyForQuery, which is handed to the
+ * application as a PGRES_PIPELINE_SYNC result (clearing the aborted state
+ * if an earlier command in the pipeline failed).
+ */
+int
+PQpipelineSync(PGconn *conn)
+{
+	PGcmdQueueEntry *entry;
+
+	if (!conn)
+		return 0;
+
+	if (conn->pipelineStatus == PQ_PIPELINE_OFF)
+	{
+		printfPQExpBuffer(&conn->errorMessage,
+						  libpq_gettext("cannot send pipeline when not in pipeline mode\n"));
+		return 0;
+	}
+
+	switch (conn->asyncStatus)
+	{
+		case PGASYNC_COPY_IN:
+		case PGASYNC_COPY_OUT:
+		case PGASYNC_COPY_BOTH:
+			printfPQExpBuffer(&conn->errorMessage,
+							  libpq_gettext("cannot queue commands during COPY\n"));
+			return 0;
+
+		default:
+			break;
+	}
+
+	entry = pqAllocCmdQueueEntry(conn);
+	if (entry == NULL)
+		return 0;
+	entry->queryclass = PGQUERY_SYNC;
+
+	/* construct the Sync message */
+	if (pqPutMsgStart('S', false, conn) < 0 ||
+		pqPutMsgEnd(conn) < 0)
+	{
+		pqRecycleCmdQueueEntry(conn, entry);
+		return 0;
+	}
+	pqAppendCmdQueueEntry(conn, entry);
+
+	/*
+	 * Give the data a push; the application wants results now, so there is
+	 * no point in deferring the flush any longer.  In nonblock mode, don't
+	 * complain if we're unable to send it all; PQgetResult() will do any
+	 * additional flushing needed.
+	 */
+	if (pqFlush(conn) < 0)
+		return 0;
+
+	/* If the connection is idle, let parsing of the responses begin */
+	if (conn->asyncStatus == PGASYNC_IDLE)
+		pqPipelineProcessQueue(conn);
+
+	return 1;
+}
+
+/*
+ * PQpipelineStatus
+ *		Return the pipeline mode status of the given connection.
+ */
+PGpipelineStatus
+PQpipelineStatus(const PGconn *conn)
+{
+	if (!conn)
+		return PQ_PIPELINE_OFF;
+
+	return conn->pipelineStatus;
+}
+
 /*
  * Consume any available input from the backend
  * 0 return: some kind of trouble
@@ -1844,8 +2218,35 @@ PQgetResult(PGconn *conn)
 	{
 		case PGASYNC_IDLE:
 			res = NULL;			/* query is complete */
+			if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+			{
+				/*
+				 * We're about to return the NULL that terminates the round of
+				 * results from the current query; prepare to send the results
+				 * of the next query, if any, when we're called next.
+				 */
+				pqPipelineProcessQueue(conn);
+			}
 			break;
 		case PGASYNC_READY:
+			res = pqPrepareAsyncResult(conn);
+			if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+			{
+				/*
+				 * That was the last result of the current command in the
+				 * pipeline: retire its queue entry and go idle until the
+				 * application has collected the result and asks for more.
+				 */
+				pqCommandQueueAdvance(conn);
+				conn->asyncStatus = PGASYNC_IDLE;
+			}
+			else
+			{
+				/* Set the state back to BUSY, allowing parsing to proceed. */
+				conn->asyncStatus = PGASYNC_BUSY;
+			}
+			break;
+		case PGASYNC_READY_MORE:
 			res = pqPrepareAsyncResult(conn);
 			/* Set the state back to BUSY, allowing parsing to proceed. */
 			conn->asyncStatus = PGASYNC_BUSY;
@@ -2026,6 +2427,13 @@ PQexecStart(PGconn *conn)
 	if (!conn)
 		return false;
 
+	if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+	{
+		printfPQExpBuffer(&conn->errorMessage,
+						  libpq_gettext("synchronous command execution functions are not allowed in pipeline mode\n"));
+		return false;
+	}
+
 	/*
 	 * Silently discard any prior query result that application didn't eat.
 	 * This is probably poor design, but it's here for backward compatibility.
@@ -2242,30 +2650,18 @@ PQsendDescribe(PGconn *conn, char desc_type, const char *desc_target)
 		pqPutMsgEnd(conn) < 0)
 		goto sendFailed;
 
-	/* construct the Sync message */
-	if (pqPutMsgStart('S', false, conn) < 0 ||
-		pqPutMsgEnd(conn) < 0)
-		goto sendFailed;
-
-	/* remember we are doing a Describe */
-	conn->queryclass = PGQUERY_DESCRIBE;
-
-	/* reset last_query string (not relevant now) */
-	if (conn->last_query)
+	/* construct the Sync message, unless a pipeline is collecting commands */
+	if (conn->pipelineStatus == PQ_PIPELINE_OFF)
 	{
-		free(conn->last_query);
-		conn->last_query = NULL;
+		if (pqPutMsgStart('S', false, conn) < 0 ||
+			pqPutMsgEnd(conn) < 0)
+			goto sendFailed;
 	}
 
-	/*
-	 * Give the data a push.  In nonblock mode, don't complain if we're unable
-	 * to send it all; PQgetResult() will do any additional flushing needed.
-	 */
-	if (pqFlush(conn) < 0)
+	/* remember we are doing a Describe, then launch or enqueue it */
+	if (!pqSendQueryFinish(conn, PGQUERY_DESCRIBE, NULL))
 		goto sendFailed;
 
-	/* OK, it's launched! */
-	conn->asyncStatus = PGASYNC_BUSY;
 	return 1;
 
 sendFailed:
@@ -2666,6 +3062,13 @@ PQfn(PGconn *conn,
 	/* clear the error string */
 	resetPQExpBuffer(&conn->errorMessage);
 
+	if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+	{
+		printfPQExpBuffer(&conn->errorMessage,
+						  libpq_gettext("PQfn not allowed in pipeline mode\n"));
+		return NULL;
+	}
+
 	if (conn->sock == PGINVALID_SOCKET || conn->asyncStatus != PGASYNC_IDLE ||
 		conn->result != NULL)
 	{
@@ -160,6 +160,15 @@ pqParseInput3(PGconn *conn)
 			if (conn->asyncStatus != PGASYNC_IDLE)
 				return;
 
+			/*
+			 * We're notionally not-IDLE in pipeline mode when results of a
+			 * queued command are still waiting to be processed; hold off
+			 * until pqPipelineProcessQueue() makes that command current.
+			 */
+			if (conn->pipelineStatus != PQ_PIPELINE_OFF &&
+				conn->cmd_queue_head != NULL)
+				return;
+
 			/*
 			 * Unexpected message in IDLE state; need to recover somehow.
 			 * ERROR messages are handled using the notice processor;
@@ -217,12 +226,49 @@ pqParseInput3(PGconn *conn)
 				case 'E':		/* error return */
 					if (pqGetErrorNotice3(conn, true))
 						return;
+					/* A command failing aborts the rest of its pipeline */
+					if (conn->pipelineStatus == PQ_PIPELINE_ON)
+						conn->pipelineStatus = PQ_PIPELINE_ABORTED;
 					conn->asyncStatus = PGASYNC_READY;
 					break;
 				case 'Z':		/* backend is ready for new query */
 					if (getReadyForQuery(conn))
 						return;
-					conn->asyncStatus = PGASYNC_IDLE;
+					if (conn->pipelineStatus != PQ_PIPELINE_OFF)
+					{
+						if (conn->queryclass == PGQUERY_SYNC)
+						{
+							/*
+							 * This is the sync point the pipeline was
+							 * waiting for, so any error recovery is over;
+							 * report it as a PGRES_PIPELINE_SYNC result.
+							 */
+							if (conn->result == NULL)
+							{
+								conn->result = PQmakeEmptyPGresult(conn,
+																   PGRES_PIPELINE_SYNC);
+								if (!conn->result)
+								{
+									printfPQExpBuffer(&conn->errorMessage,
+													  libpq_gettext("out of memory"));
+									pqSaveErrorResult(conn);
+								}
+							}
+							conn->pipelineStatus = PQ_PIPELINE_ON;
+							conn->asyncStatus = PGASYNC_READY;
+						}
+						else
+						{
+							/*
+							 * This should not happen; stay busy waiting for
+							 * the sync point we have queued.
+							 */
+							pqInternalNotice(&conn->noticeHooks,
+											 "unexpected ReadyForQuery while not at a pipeline synchronization point");
+						}
+					}
+					else
+						conn->asyncStatus = PGASYNC_IDLE;
 					break;
 				case 'I':		/* empty query */
 					if (conn->result == NULL)
@@ -95,6 +95,16 @@ typedef struct SimpleEcontextStackEntry
 static EState *shared_simple_eval_estate = NULL;
 static SimpleEcontextStackEntry *simple_econtext_stack = NULL;
 
+/*
+ * In addition to the shared simple-eval EState, we have a shared resource
+ * owner that holds refcounts on the CachedPlans for any simple expressions
+ * we have validated in the current transaction.  This allows us to avoid
+ * continually grabbing and releasing a plan refcount when a simple expression
+ * is used over and over.  (DO blocks use their own resowner, in exactly the
+ * same way described above for shared_simple_eval_estate.)
+ */
+static ResourceOwner shared_simple_eval_resowner = NULL;
+
 /*
  * Memory management within a plpgsql function generally works with three
  * contexts:
@@ -242,6 +252,7 @@ static HTAB *shared_cast_hash = NULL;
 static void coerce_function_result_tuple(PLpgSQL_execstate *estate,
 										 TupleDesc tupdesc);
 static void plpgsql_exec_error_callback(void *arg);
+static void build_datum_template(PLpgSQL_function *func);
 static void copy_plpgsql_datums(PLpgSQL_execstate *estate,
 								PLpgSQL_function *func);
 static void plpgsql_fulfill_promise(PLpgSQL_execstate *estate,
@@ -314,7 +325,8 @@ static int	exec_stmt_set(PLpgSQL_execstate *estate,
 static void plpgsql_estate_setup(PLpgSQL_execstate *estate,
 								 PLpgSQL_function *func,
 								 ReturnSetInfo *rsi,
-								 EState *simple_eval_estate);
+								 EState *simple_eval_estate,
+								 ResourceOwner simple_eval_resowner);
 static void exec_eval_cleanup(PLpgSQL_execstate *estate);
 
 static void exec_prepare_plan(PLpgSQL_execstate *estate,
@@ -440,16 +452,18 @@ static char *format_preparedparamsdata(PLpgSQL_execstate *estate,
  *
  * This is also used to execute inline code blocks (DO blocks).  The only
  * difference that this code is aware of is that for a DO block, we want
- * to use a private simple_eval_estate, which is created and passed in by
- * the caller.  For regular functions, pass NULL, which implies using
- * shared_simple_eval_estate.  (When using a private simple_eval_estate,
+ * to use private simple_eval_estate and simple_eval_resowner, which are
+ * created and passed in by the caller.  For regular functions, pass NULL,
+ * which implies using shared_simple_eval_estate and
+ * shared_simple_eval_resowner.  (When using a private simple_eval_estate,
  * we must also use a private cast hashtable, but that's taken care of
  * within plpgsql_estate_setup.)
  * ----------
  */
 Datum
 plpgsql_exec_function(PLpgSQL_function *func, FunctionCallInfo fcinfo,
-					  EState *simple_eval_estate, bool atomic)
+					  EState *simple_eval_estate,
+					  ResourceOwner simple_eval_resowner, bool atomic)
 {
 	PLpgSQL_execstate estate;
 	ErrorContextCallback plerrcontext;
@@ -460,7 +474,7 @@ plpgsql_exec_function(PLpgSQL_function *func, FunctionCallInfo fcinfo,
 	 * Setup the execution state
 	 */
 	plpgsql_estate_setup(&estate, func, (ReturnSetInfo *) fcinfo->resultinfo,
-						 simple_eval_estate);
+						 simple_eval_estate, simple_eval_resowner);
 	estate.atomic = atomic;
 
 	/*
@@ -897,7 +911,7 @@ plpgsql_exec_trigger(PLpgSQL_function *func,
 	/*
 	 * Setup the execution state
 	 */
-	plpgsql_estate_setup(&estate, func, NULL, NULL);
+	plpgsql_estate_setup(&estate, func, NULL, NULL, NULL);
 	estate.trigdata = trigdata;
 
 	/*
@@ -1135,7 +1149,7 @@ plpgsql_exec_event_trigger(PLpgSQL_function *func, EventTriggerData *trigdata)
 	/*
 	 * Setup the execution state
 	 */
-	plpgsql_estate_setup(&estate, func, NULL, NULL);
+	plpgsql_estate_setup(&estate, func, NULL, NULL, NULL);
 	estate.evtrigdata = trigdata;
 
 	/*
@@ -1264,41 +1278,94 @@ copy_plpgsql_datums(PLpgSQL_execstate *estate,
 	PLpgSQL_datum **indatums;
 	PLpgSQL_datum **outdatums;
 	char	   *workspace;
-	char	   *ws_next;
 	int			i;
 
-	/* Allocate local datum-pointer array */
-	estate->datums = (PLpgSQL_datum **)
-		palloc(sizeof(PLpgSQL_datum *) * ndatums);
+	/*
+	 * On first execution, precompute a contiguous template image of the
+	 * locally-instantiated datums, along with each datum's offset in it, so
+	 * that later calls can build their frame with a single memcpy instead of
+	 * datum-by-datum copying.
+	 */
+	if (func->copiable_template == NULL)
+		build_datum_template(func);
 
 	/*
-	 * To reduce palloc overhead, we make a single palloc request for all the
-	 * space needed for locally-instantiated datums.
+	 * Acquire the frame: the datum-pointer array plus the workspace holding
+	 * locally-instantiated datums.  If we are the only active execution of
+	 * this function, reuse the frame cached in the function's context,
+	 * creating it if this is the first call; recursive executions fall back
+	 * to transient allocations in the current (SPI procedure) context.  Any
+	 * stale frame contents, including those left behind by a call that
+	 * failed partway through, are entirely overwritten below.
 	 */
-	workspace = palloc(func->copiable_size);
-	ws_next = workspace;
+	if (func->use_count == 1)
+	{
+		if (func->frame_datums == NULL)
+		{
+			MemoryContext oldcxt = MemoryContextSwitchTo(func->fn_cxt);
+
+			func->frame_datums = (PLpgSQL_datum **)
+				palloc(sizeof(PLpgSQL_datum *) * ndatums);
+			func->frame_workspace = (char *) palloc(func->copiable_size);
+			MemoryContextSwitchTo(oldcxt);
+		}
+		estate->datums = func->frame_datums;
+		workspace = func->frame_workspace;
+	}
+	else
+	{
+		estate->datums = (PLpgSQL_datum **)
+			palloc(sizeof(PLpgSQL_datum *) * ndatums);
+		workspace = palloc(func->copiable_size);
+	}
 
-	/* Fill datum-pointer array, copying datums into workspace as needed */
+	/* Instantiate the locally-copiable datums in one go */
+	memcpy(workspace, func->copiable_template, func->copiable_size);
+
+	/* Fill datum-pointer array using the precomputed offsets */
 	indatums = func->datums;
 	outdatums = estate->datums;
 	for (i = 0; i < ndatums; i++)
 	{
-		PLpgSQL_datum *indatum = indatums[i];
-		PLpgSQL_datum *outdatum;
+		int			offset = func->datum_offsets[i];
+
+		if (offset >= 0)
+			outdatums[i] = (PLpgSQL_datum *) (workspace + offset);
+		else
+			outdatums[i] = indatums[i];
+	}
+}
+
+/*
+ * Build the template image and datum offsets used by copy_plpgsql_datums.
+ * These live in the function's context, alongside the reusable frame.
+ */
+static void
+build_datum_template(PLpgSQL_function *func)
+{
+	MemoryContext oldcxt = MemoryContextSwitchTo(func->fn_cxt);
+	char	   *image = palloc0(func->copiable_size);
+	int		   *offsets = (int *) palloc(sizeof(int) * func->ndatums);
+	char	   *ws_next = image;
+	int			i;
+
+	for (i = 0; i < func->ndatums; i++)
+	{
+		PLpgSQL_datum *indatum = func->datums[i];
 
 		/* This must agree with plpgsql_finish_datums on what is copiable */
 		switch (indatum->dtype)
 		{
 			case PLPGSQL_DTYPE_VAR:
 			case PLPGSQL_DTYPE_PROMISE:
-				outdatum = (PLpgSQL_datum *) ws_next;
-				memcpy(outdatum, indatum, sizeof(PLpgSQL_var));
+				offsets[i] = (int) (ws_next - image);
+				memcpy(ws_next, indatum, sizeof(PLpgSQL_var));
 				ws_next += MAXALIGN(sizeof(PLpgSQL_var));
 				break;
 
 			case PLPGSQL_DTYPE_REC:
-				outdatum = (PLpgSQL_datum *) ws_next;
-				memcpy(outdatum, indatum, sizeof(PLpgSQL_rec));
+				offsets[i] = (int) (ws_next - image);
+				memcpy(ws_next, indatum, sizeof(PLpgSQL_rec));
 				ws_next += MAXALIGN(sizeof(PLpgSQL_rec));
 				break;
 
@@ -1311,19 +1378,21 @@ copy_plpgsql_datums(PLpgSQL_execstate *estate,
 				 * copy them (well, RECFIELD and ARRAYELEM contain cached
 				 * data, but we'd just as soon centralize the caching anyway).
 				 */
-				outdatum = indatum;
+				offsets[i] = -1;
 				break;
 
 			default:
 				elog(ERROR, "unrecognized dtype: %d", indatum->dtype);
-				outdatum = NULL;	/* keep compiler quiet */
 				break;
 		}
-
-		outdatums[i] = outdatum;
 	}
 
-	Assert(ws_next == workspace + func->copiable_size);
+	Assert(ws_next == image + func->copiable_size);
+
+	func->datum_offsets = offsets;
+	func->copiable_template = image;
+
+	MemoryContextSwitchTo(oldcxt);
 }
 
 /*
@@ -2321,6 +2390,7 @@ exec_stmt_call(PLpgSQL_execstate *estate, PLpgSQL_stmt_call *stmt)
 		 * some internal state.
 		 */
 		estate->simple_eval_estate = NULL;
+		estate->simple_eval_resowner = NULL;
 		plpgsql_create_econtext(estate);
 	}
 
@@ -3876,7 +3946,8 @@ static void
 plpgsql_estate_setup(PLpgSQL_execstate *estate,
 					 PLpgSQL_function *func,
 					 ReturnSetInfo *rsi,
-					 EState *simple_eval_estate)
+					 EState *simple_eval_estate,
+					 ResourceOwner simple_eval_resowner)
 {
 	HASHCTL		ctl;
 
@@ -3968,6 +4039,13 @@ plpgsql_estate_setup(PLpgSQL_execstate *estate,
 		estate->cast_hash_context = shared_cast_context;
 	}
 
+	/*
+	 * Likewise, a DO block receives its own resource owner for simple
+	 * expressions' plan refcounts; functions use the shared one, which is
+	 * created on demand in plpgsql_create_econtext.
+	 */
+	estate->simple_eval_resowner = simple_eval_resowner;
+
 	/*
 	 * We start with no stmt_mcontext; one will be created only if needed.
 	 * That context will be a direct child of the function's main execution
@@ -4828,6 +4906,7 @@ exec_stmt_commit(PLpgSQL_execstate *estate, PLpgSQL_stmt_commit *stmt)
 	}
 
 	estate->simple_eval_estate = NULL;
+	estate->simple_eval_resowner = NULL;
 	plpgsql_create_econtext(estate);
 
 	return PLPGSQL_RC_OK;
@@ -4850,6 +4929,7 @@ exec_stmt_rollback(PLpgSQL_execstate *estate, PLpgSQL_stmt_rollback *stmt)
 	}
 
 	estate->simple_eval_estate = NULL;
+	estate->simple_eval_resowner = NULL;
 	plpgsql_create_econtext(estate);
 
 	return PLPGSQL_RC_OK;
@@ -6063,7 +6143,9 @@ loop_exit:
  * expression.  That cannot cause a simple expression to become non-simple (or
  * vice versa), but we do have to handle replacing the expression tree.
  * Fortunately it's normally inexpensive to call SPI_plan_get_cached_plan for
- * a simple expression.
+ * a simple expression; and when the plan has been validated once in the
+ * current transaction and is eligible for CachedPlanIsSimplyValid, we can
+ * skip even that.
  *
  * Note: if pass-by-reference, the result is in the eval_mcontext.
  * It will be freed when exec_eval_cleanup is done.
@@ -6097,27 +6179,60 @@ exec_eval_simple_expr(PLpgSQL_execstate *estate,
 
 	/*
 	 * Revalidate cached plan, so that we will notice if it became stale. (We
-	 * need to hold a refcount while using the plan, anyway.)  If replanning
-	 * is needed, do that work in the eval_mcontext.
+	 * also need to hold a refcount while using the plan.)  Note that even if
+	 * replanning occurs, the length of the rewritten query list cannot
+	 * change from what exec_simple_check_plan saw; it's a property of the
+	 * raw parsetree generated from the query text.
+	 *
+	 * If we have a valid refcount on the plan from a previous validation in
+	 * the current transaction, and the plan is still simply valid, we can
+	 * skip the plancache entirely; this is the down-to-the-metal path for
+	 * tight evaluation loops.
 	 */
-	oldcontext = MemoryContextSwitchTo(get_eval_mcontext(estate));
-	cplan = SPI_plan_get_cached_plan(expr->plan);
-	MemoryContextSwitchTo(oldcontext);
+	if (expr->expr_simple_plan_lxid == curlxid &&
+		CachedPlanIsSimplyValid(expr->expr_simple_plansource,
+								expr->expr_simple_plan, NULL))
+	{
+		/* Our refcount on the plan is held by simple_eval_resowner */
+		cplan = NULL;
+	}
+	else
+	{
+		/* Do it the hard way; if replanning is needed, use the eval_mcontext */
+		oldcontext = MemoryContextSwitchTo(get_eval_mcontext(estate));
+		cplan = SPI_plan_get_cached_plan(expr->plan);
+		MemoryContextSwitchTo(oldcontext);
 
-	/*
-	 * We can't get a failure here, because the number of CachedPlanSources in
-	 * the SPI plan can't change from what exec_simple_check_plan saw; it's a
-	 * property of the raw parsetree generated from the query text.
-	 */
-	Assert(cplan != NULL);
+		/* As above, we can't get a failure here */
+		Assert(cplan != NULL);
 
-	/* If it got replanned, update our copy of the simple expression */
-	if (cplan->generation != expr->expr_simple_generation)
-	{
-		exec_save_simple_expr(expr, cplan);
-		/* better recheck r/w safety, as it could change due to inlining */
-		if (expr->rwparam >= 0)
-			exec_check_rw_parameter(expr, expr->rwparam);
+		/* If it got replanned, update our copy of the simple expression */
+		if (cplan->generation != expr->expr_simple_generation)
+		{
+			exec_save_simple_expr(expr, cplan);
+			/* better recheck r/w safety, as it could change due to inlining */
+			if (expr->rwparam >= 0)
+				exec_check_rw_parameter(expr, expr->rwparam);
+		}
+
+		/*
+		 * Test whether the plan is eligible for the fast revalidation path;
+		 * if so, take out a refcount on it with our simple_eval_resowner and
+		 * remember it, so that future evaluations within this transaction
+		 * can use the check above instead of SPI_plan_get_cached_plan.
+		 */
+		if (CachedPlanAllowsSimpleValidityCheck(expr->expr_simple_plansource,
+												cplan,
+												estate->simple_eval_resowner))
+		{
+			expr->expr_simple_plan = cplan;
+			expr->expr_simple_plan_lxid = curlxid;
+		}
+		else
+		{
+			expr->expr_simple_plan = NULL;
+			expr->expr_simple_plan_lxid = InvalidLocalTransactionId;
+		}
 	}
 
 	/*
@@ -6154,10 +6269,12 @@ exec_eval_simple_expr(PLpgSQL_execstate *estate,
 	 * We have to do some of the things SPI_execute_plan would do, in
 	 * particular advance the snapshot if we are in a non-read-only function.
 	 * Without this, stable functions within the expression would fail to see
-	 * updates made so far by our own function.
+	 * updates made so far by our own function.  However, if the expression
+	 * contains neither volatile nor stable functions, that concern cannot
+	 * apply, and we can save the considerable overhead of a new snapshot.
 	 */
 	oldcontext = MemoryContextSwitchTo(get_eval_mcontext(estate));
-	if (!estate->readonly_func)
+	if (!estate->readonly_func && expr->expr_simple_mutable)
 	{
 		CommandCounterIncrement();
 		PushActiveSnapshot(GetTransactionSnapshot());
@@ -6182,15 +6299,18 @@ exec_eval_simple_expr(PLpgSQL_execstate *estate,
 
 	estate->paramLI->parserSetupArg = save_setup_arg;
 
-	if (!estate->readonly_func)
+	if (!estate->readonly_func && expr->expr_simple_mutable)
 		PopActiveSnapshot();
 
 	MemoryContextSwitchTo(oldcontext);
 
 	/*
-	 * Now we can release our refcount on the cached plan.
+	 * Now we can release the refcount we took in SPI_plan_get_cached_plan,
+	 * if any.  (The refcount for the fast path is held by
+	 * simple_eval_resowner instead, and is released at transaction end.)
 	 */
-	ReleaseCachedPlan(cplan, true);
+	if (cplan != NULL)
+		ReleaseCachedPlan(cplan, true);
 
 	/*
 	 * That's it.
@@ -7973,6 +8093,9 @@ exec_simple_check_plan(PLpgSQL_execstate *estate, PLpgSQL_expr *expr)
 	/* Share the remaining work with replan code path */
 	exec_save_simple_expr(expr, cplan);
 
+	/* Remember the plan's source, for the fast revalidation path */
+	expr->expr_simple_plansource = plansource;
+
 	/* Release our plan refcount */
 	ReleaseCachedPlan(cplan, true);
 }
@@ -8050,9 +8173,13 @@ exec_save_simple_expr(PLpgSQL_expr *expr, CachedPlan *cplan)
 	expr->expr_simple_state = NULL;
 	expr->expr_simple_in_use = false;
 	expr->expr_simple_lxid = InvalidLocalTransactionId;
+	expr->expr_simple_plan = NULL;
+	expr->expr_simple_plan_lxid = InvalidLocalTransactionId;
 	/* Also stash away the expression result type */
 	expr->expr_simple_type = exprType((Node *) tle_expr);
 	expr->expr_simple_typmod = exprTypmod((Node *) tle_expr);
+	/* We also want to remember if it is immutable or not */
+	expr->expr_simple_mutable = contain_mutable_functions((Node *) tle_expr);
 }
 
 /*
@@ -8208,6 +8335,21 @@ plpgsql_create_econtext(PLpgSQL_execstate *estate)
 		estate->simple_eval_estate = shared_simple_eval_estate;
 	}
 
+	/*
+	 * Likewise for the simple-expression resource owner.  (A DO block's
+	 * private resowner is made by plpgsql_inline_handler and already set.)
+	 * We make the shared owner standalone, not a child of the transaction's
+	 * owner, because its refcounts must be released explicitly by
+	 * plpgsql_xact_cb, whether we commit or abort.
+	 */
+	if (estate->simple_eval_resowner == NULL)
+	{
+		if (shared_simple_eval_resowner == NULL)
+			shared_simple_eval_resowner =
+				ResourceOwnerCreate(NULL, "PL/pgSQL simple expressions");
+		estate->simple_eval_resowner = shared_simple_eval_resowner;
+	}
+
 	/*
 	 * Create a child econtext for the current function.
 	 */
@@ -8272,11 +8414,23 @@ plpgsql_xact_cb(XactEvent event, void *arg)
 		if (shared_simple_eval_estate)
 			FreeExecutorState(shared_simple_eval_estate);
 		shared_simple_eval_estate = NULL;
+		if (shared_simple_eval_resowner)
+		{
+			ResourceOwnerReleaseAllPlanCacheRefs(shared_simple_eval_resowner);
+			ResourceOwnerDelete(shared_simple_eval_resowner);
+		}
+		shared_simple_eval_resowner = NULL;
 	}
 	else if (event == XACT_EVENT_ABORT)
 	{
 		simple_econtext_stack = NULL;
 		shared_simple_eval_estate = NULL;
+		if (shared_simple_eval_resowner)
+		{
+			ResourceOwnerReleaseAllPlanCacheRefs(shared_simple_eval_resowner);
+			ResourceOwnerDelete(shared_simple_eval_resowner);
+		}
+		shared_simple_eval_resowner = NULL;
 	}
 }
 
@@ -234,6 +234,18 @@ typedef struct PLpgSQL_expr
 	int			expr_simple_generation; /* plancache generation we checked */
 	Oid			expr_simple_type;	/* result type Oid, if simple */
 	int32		expr_simple_typmod; /* result typmod, if simple */
+	bool		expr_simple_mutable;	/* true if simple expr is mutable */
+
+	/*
+	 * If the expression was ever determined to be simple, we remember its
+	 * CachedPlanSource and CachedPlan here.  If expr_simple_plan_lxid matches
+	 * current LXID, then we hold a refcount on expr_simple_plan in the
+	 * simple_eval_resowner, so the plan can be revalidated cheaply with
+	 * CachedPlanIsSimplyValid, without consulting the plancache proper.
+	 */
+	CachedPlanSource *expr_simple_plansource;	/* extracted from "plan" */
+	CachedPlan *expr_simple_plan;	/* validated plan, if any */
+	LocalTransactionId expr_simple_plan_lxid;
 
 	/*
 	 * if expr is simple AND prepared in current transaction,
@@ -1020,6 +1032,15 @@ typedef struct PLpgSQL_function
 	PLpgSQL_datum **datums;
 	Size		copiable_size;	/* space for locally instantiated datums */
 
+	/*
+	 * Cached material for fast construction of execution frames, all living
+	 * in fn_cxt; see copy_plpgsql_datums.  Built on first execution.
+	 */
+	char	   *copiable_template;	/* preassembled image of copiable datums */
+	int		   *datum_offsets;	/* offsets into workspace, -1 if shared */
+	PLpgSQL_datum **frame_datums;	/* reusable frame: datum-pointer array */
+	char	   *frame_workspace;	/* reusable frame: datum workspace */
+
 	/* function body parsetree */
 	PLpgSQL_stmt_block *action;
 
@@ -1083,6 +1104,9 @@ typedef struct PLpgSQL_execstate
 	/* EState to use for "simple" expression evaluation */
 	EState	   *simple_eval_estate;
 
+	/* ResourceOwner to use for "simple" expressions' plancache refcounts */
+	ResourceOwner simple_eval_resowner;
+
 	/* lookup table to use for executing type casts */
 	HTAB	   *cast_hash;
 	MemoryContext cast_hash_context;
@@ -1266,6 +1290,7 @@ extern void _PG_init(void);
 extern Datum plpgsql_exec_function(PLpgSQL_function *func,
 								   FunctionCallInfo fcinfo,
 								   EState *simple_eval_estate,
+								   ResourceOwner simple_eval_resowner,
 								   bool atomic);
 extern HeapTuple plpgsql_exec_trigger(PLpgSQL_function *func,
 									  TriggerData *trigdata);
@@ -18,6 +18,71 @@
 
 #include <arm_acle.h>
 
+/*
+ * As on x86, the CRC32C instructions pipeline well but have multi-cycle
+ * latency, so a single chain through the CRC register underuses the unit.
+ * Large inputs are split into three lanes processed by independent chains
+ * in one interleaved loop; the lane CRCs are then combined by advancing
+ * them over the data that followed, using the GF(2) 32x32 matrix of the
+ * "append CRC32C_LANE_SIZE zero bytes" operator, computed on first use.
+ */
+#define CRC32C_LANE_SIZE 1024
+
+static uint32 crc32c_lane_shift[32];
+static bool crc32c_lane_shift_valid = false;
+
+/*
+ * Multiply the GF(2) 32x32 matrix mat by the bit vector vec.  mat[n] is the
+ * image of the basis vector (1 << n).
+ */
+static uint32
+crc32c_matrix_times(const uint32 *mat, uint32 vec)
+{
+	uint32		sum = 0;
+
+	while (vec)
+	{
+		if (vec & 1)
+			sum ^= *mat;
+		vec >>= 1;
+		mat++;
+	}
+	return sum;
+}
+
+/*
+ * Build crc32c_lane_shift by squaring the one-zero-bit operator
+ * log2(8 * CRC32C_LANE_SIZE) times.
+ */
+static void
+crc32c_lane_shift_init(void)
+{
+	uint32		mat1[32];
+	uint32		mat2[32];
+	uint32	   *cur = mat1;
+	uint32	   *next = mat2;
+	uint32	   *swap;
+	int			i;
+	int			n;
+
+	/* operator for appending one zero bit */
+	cur[0] = 0x82F63B78;		/* reflected CRC-32C polynomial */
+	for (n = 1; n < 32; n++)
+		cur[n] = 1U << (n - 1);
+
+	for (i = 8 * CRC32C_LANE_SIZE; i > 1; i >>= 1)
+	{
+		for (n = 0; n < 32; n++)
+			next[n] = crc32c_matrix_times(cur, cur[n]);
+		swap = cur;
+		cur = next;
+		next = swap;
+	}
+
+	memcpy(crc32c_lane_shift, cur, sizeof(crc32c_lane_shift));
+	crc32c_lane_shift_valid = true;
+}
+
 pg_crc32c
 pg_comp_crc32c_armv8(pg_crc32c crc, const void *data, size_t len)
 {
@@ -48,6 +113,36 @@ pg_comp_crc32c_armv8(pg_crc32c crc, const void *data, size_t len)
 		p += 4;
 	}
 
+	/* For large inputs, run three interleaved CRC chains; see above. */
+	if (p + 3 * CRC32C_LANE_SIZE <= pend)
+	{
+		if (!crc32c_lane_shift_valid)
+			crc32c_lane_shift_init();
+
+		do
+		{
+			const unsigned char *p1 = p + CRC32C_LANE_SIZE;
+			const unsigned char *p2 = p + 2 * CRC32C_LANE_SIZE;
+			uint32		crc0 = crc;
+			uint32		crc1 = 0;
+			uint32		crc2 = 0;
+			int			i;
+
+			for (i = 0; i < CRC32C_LANE_SIZE; i += 8)
+			{
+				crc0 = __crc32cd(crc0, *(uint64 *) (p + i));
+				crc1 = __crc32cd(crc1, *(uint64 *) (p1 + i));
+				crc2 = __crc32cd(crc2, *(uint64 *) (p2 + i));
+			}
+
+			/* advance each lane's CRC over the lanes that follow it */
+			crc0 = crc32c_matrix_times(crc32c_lane_shift, crc0) ^ crc1;
+			crc = crc32c_matrix_times(crc32c_lane_shift, crc0) ^ crc2;
+
+			p += 3 * CRC32C_LANE_SIZE;
+		} while (p + 3 * CRC32C_LANE_SIZE <= pend);
+	}
+
 	/* Process eight bytes at a time, as far as we can. */
 	while (p + 8 <= pend)
 	{
@@ -18,6 +18,83 @@
 
 #include <nmmintrin.h>
 
+#ifdef __x86_64__
+
+/*
+ * The latency of the CRC32 instruction is about three cycles while its
+ * throughput is one per cycle, so a single dependency chain through the CRC
+ * register leaves most of the unit idle.  For large inputs we therefore
+ * split the data into three equal-sized lanes, run three independent CRC
+ * chains over them in one interleaved loop, and combine the lane results
+ * afterwards.
+ *
+ * Combining requires advancing a lane's CRC over the lanes that follow it,
+ * i.e. applying the linear operator that a run of CRC32C_LANE_SIZE zero
+ * bytes has on the CRC register.  We represent that operator as a GF(2)
+ * 32x32 bit matrix, computed once on first use.
+ */
+#define CRC32C_LANE_SIZE 1024
+
+static uint32 crc32c_lane_shift[32];
+static bool crc32c_lane_shift_valid = false;
+
+/*
+ * Multiply the GF(2) 32x32 matrix mat by the bit vector vec.  mat[n] is the
+ * image of the basis vector (1 << n).
+ */
+static uint32
+crc32c_matrix_times(const uint32 *mat, uint32 vec)
+{
+	uint32		sum = 0;
+
+	while (vec)
+	{
+		if (vec & 1)
+			sum ^= *mat;
+		vec >>= 1;
+		mat++;
+	}
+	return sum;
+}
+
+/*
+ * Compute the operator that advances a (reflected) CRC-32C register by
+ * CRC32C_LANE_SIZE zero bytes.  Appending a single zero bit maps the
+ * register linearly, so the operator for 8 * CRC32C_LANE_SIZE zero bits is
+ * obtained by repeatedly squaring the one-bit operator.
+ */
+static void
+crc32c_lane_shift_init(void)
+{
+	uint32		mat1[32];
+	uint32		mat2[32];
+	uint32	   *cur = mat1;
+	uint32	   *next = mat2;
+	uint32	   *swap;
+	int			i;
+	int			n;
+
+	/* operator for appending one zero bit */
+	cur[0] = 0x82F63B78;		/* reflected CRC-32C polynomial */
+	for (n = 1; n < 32; n++)
+		cur[n] = 1U << (n - 1);
+
+	/* square log2(8 * CRC32C_LANE_SIZE) times */
+	for (i = 8 * CRC32C_LANE_SIZE; i > 1; i >>= 1)
+	{
+		for (n = 0; n < 32; n++)
+			next[n] = crc32c_matrix_times(cur, cur[n]);
+		swap = cur;
+		cur = next;
+		next = swap;
+	}
+
+	memcpy(crc32c_lane_shift, cur, sizeof(crc32c_lane_shift));
+	crc32c_lane_shift_valid = true;
+}
+
+#endif							/* __x86_64__ */
+
 pg_crc32c
 pg_comp_crc32c_sse42(pg_crc32c crc, const void *data, size_t len)
 {
@@ -32,6 +109,41 @@ pg_comp_crc32c_sse42(pg_crc32c crc, const void *data, size_t len)
 	 * the begin address.
 	 */
 #ifdef __x86_64__
+
+	/*
+	 * For large inputs, run three interleaved CRC chains; see above.  This
+	 * roughly triples throughput for multi-kilobyte buffers such as
+	 * assembled WAL records.
+	 */
+	if (p + 3 * CRC32C_LANE_SIZE <= pend)
+	{
+		if (!crc32c_lane_shift_valid)
+			crc32c_lane_shift_init();
+
+		do
+		{
+			const unsigned char *p1 = p + CRC32C_LANE_SIZE;
+			const unsigned char *p2 = p + 2 * CRC32C_LANE_SIZE;
+			uint64		crc0 = crc;
+			uint64		crc1 = 0;
+			uint64		crc2 = 0;
+			int			i;
+
+			for (i = 0; i < CRC32C_LANE_SIZE; i += 8)
+			{
+				crc0 = _mm_crc32_u64(crc0, *((const uint64 *) (p + i)));
+				crc1 = _mm_crc32_u64(crc1, *((const uint64 *) (p1 + i)));
+				crc2 = _mm_crc32_u64(crc2, *((const uint64 *) (p2 + i)));
+			}
+
+			/* advance each lane's CRC over the lanes that follow it */
+			crc0 = crc32c_matrix_times(crc32c_lane_shift, (uint32) crc0) ^ crc1;
+			crc = crc32c_matrix_times(crc32c_lane_shift, (uint32) crc0) ^ (uint32) crc2;
+
+			p += 3 * CRC32C_LANE_SIZE;
+		} while (p + 3 * CRC32C_LANE_SIZE <= pend);
+	}
+
 	while (p + 8 <= pend)
 	{
 		crc = (uint32) _mm_crc32_u64(crc, *((const uint64 *) p));
@@ -73,19 +73,15 @@ urm_simple_test(PG_FUNCTION_ARGS)
 					  &darray, NULL, &nentries);
 
 	/*
-	 * Initialize UndoRequestManager. We have to supply an LWLock; rather than
-	 * creating a new one somewhere, just use our own backendLock. These locks
-	 * aren't that heavily trafficked and we won't have any reason to take it
-	 * for any other purpose while the UndoRequstManager holds it, so this
-	 * should be safe enough.
+	 * Initialize UndoRequestManager. The manager creates its own per-shard
+	 * locks, which work fine in backend-private memory too.
 	 *
 	 * We make the soft limit equal to the full capacity here for testing
 	 * purposes, which means that we should always succeed in dispatching to
 	 * the background.
 	 */
 	urm = palloc(EstimateUndoRequestManagerSize(capacity));
-	InitializeUndoRequestManager(urm, &MyProc->backendLock,
-								 capacity, capacity);
+	InitializeUndoRequestManager(urm, capacity, capacity);
 
 	/* Insert entries as provided by caller. */
 	for (i = 0; i < nentries; ++i)
@@ -460,3 +460,29 @@ VACUUM ANALYZE brin_test;
 EXPLAIN (COSTS OFF) SELECT * FROM brin_test WHERE a = 1;
 -- Ensure brin index is not used when values are not correlated
 EXPLAIN (COSTS OFF) SELECT * FROM brin_test WHERE b = 1;
+
+-- Test the bloom operator classes, on data with no physical correlation
+CREATE TABLE brin_bloom_test (i int4, b int8, t text, u uuid) WITH (fillfactor = 10);
+INSERT INTO brin_bloom_test
+  SELECT v, v, v::text, md5(v::text)::uuid
+    FROM (SELECT (x * 17) % 1000 AS v FROM generate_series(1, 2000) x) ss;
+CREATE INDEX brin_bloom_test_idx ON brin_bloom_test
+  USING brin (i int4_bloom_ops, b int8_bloom_ops,
+              t text_bloom_ops, u uuid_bloom_ops)
+  WITH (pages_per_range = 1);
+VACUUM ANALYZE brin_bloom_test;
+
+SET enable_seqscan = off;
+EXPLAIN (COSTS OFF) SELECT count(*) FROM brin_bloom_test WHERE i = 177;
+SELECT count(*) FROM brin_bloom_test WHERE i = 177;
+SELECT count(*) FROM brin_bloom_test WHERE b = 177;
+SELECT count(*) FROM brin_bloom_test WHERE t = '177';
+SELECT count(*) FROM brin_bloom_test WHERE u = md5('177')::uuid;
+SELECT count(*) FROM brin_bloom_test WHERE i = 1177;  -- absent value
+RESET enable_seqscan;
+
+-- The seqscan baseline must agree
+SET enable_bitmapscan = off;
+SELECT count(*) FROM brin_bloom_test WHERE i = 177;
+SELECT count(*) FROM brin_bloom_test WHERE t = '177';
+RESET enable_bitmapscan;
@@ -148,3 +148,35 @@ reset enable_bitmapscan;
 reset enable_indexonlyscan;
 
 drop table gist_tbl;
+
+--
+-- Test sorted build.  The point opclass provides a sortsupport procedure,
+-- so creating an index over pre-existing data sorts the input and inserts
+-- it in sort order instead of building with buffering.
+--
+create table gist_sorted_tbl (id int4, p point);
+insert into gist_sorted_tbl
+select g, point(g % 100, g / 100) from generate_series(1, 10000) g;
+create index gist_sorted_idx on gist_sorted_tbl using gist (p);
+vacuum analyze gist_sorted_tbl;
+
+set enable_seqscan = off;
+set enable_bitmapscan = off;
+
+-- queries through the sorted-built index ...
+explain (costs off)
+select id from gist_sorted_tbl where p <@ box(point(2, 2), point(4, 4)) order by id;
+select id from gist_sorted_tbl where p <@ box(point(2, 2), point(4, 4)) order by id;
+
+-- including ordered (nearest-neighbor) scans
+select id from gist_sorted_tbl order by p <-> point(0, 0), id limit 3;
+
+-- ... must agree with a plain seqscan
+reset enable_seqscan;
+set enable_indexscan = off;
+select id from gist_sorted_tbl where p <@ box(point(2, 2), point(4, 4)) order by id;
+select id from gist_sorted_tbl order by p <-> point(0, 0), id limit 3;
+
+reset enable_bitmapscan;
+reset enable_indexscan;
+drop table gist_sorted_tbl;
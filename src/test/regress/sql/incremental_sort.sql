@@ -0,0 +1,34 @@
+--
+-- Test incremental sorting of partially ordered input
+--
+create table incsort_test (a int, b int, c int);
+insert into incsort_test
+  select i / 100, i % 100, i from generate_series(1, 10000) i;
+create index incsort_test_a_idx on incsort_test (a);
+analyze incsort_test;
+
+-- A LIMIT query ordered on more than an index's columns should use an
+-- incremental sort over the index scan: only the leading prefix groups
+-- need to be read and sorted before tuples can be returned.
+explain (costs off)
+  select * from incsort_test order by a, b limit 5;
+
+select * from incsort_test order by a, b limit 5;
+
+-- The output must stay correctly ordered across a prefix group boundary
+select * from incsort_test order by a, b limit 4 offset 98;
+
+-- Cross several group boundaries, so that the sort is reset and refilled
+-- repeatedly; aggregate to keep the output small
+explain (costs off)
+  select sum(c) from (select c from incsort_test order by a, b limit 250) s;
+
+select sum(c) from (select c from incsort_test order by a, b limit 250) s;
+
+-- With incremental sort disabled, we fall back to an ordinary full sort
+set enable_incrementalsort = off;
+explain (costs off)
+  select * from incsort_test order by a, b limit 5;
+reset enable_incrementalsort;
+
+drop table incsort_test;
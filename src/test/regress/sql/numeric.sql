@@ -1043,3 +1043,13 @@ select scale(-13.000000000000000);
 -- cases that need carry propagation
 SELECT SUM(9999::numeric) FROM generate_series(1, 100000);
 SELECT SUM((-9999)::numeric) FROM generate_series(1, 100000);
+
+--
+-- Tests for the int128 fixed-point fast paths
+--
+
+-- values near the fast-path width limit; the first operand's intermediate
+-- representation is wider than its value, which must not overflow
+select 500000000000000000000000000000000000.5 + 0.5;
+select 500000000000000000000000000000000000.5 - 0.5;
+select 500000000000000000000000000000000000.5 = 500000000000000000000000000000000000.5;
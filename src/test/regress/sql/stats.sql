@@ -176,4 +176,28 @@ FROM prevstats AS pr;
 
 DROP TABLE trunc_stats_test, trunc_stats_test1, trunc_stats_test2, trunc_stats_test3, trunc_stats_test4;
 DROP TABLE prevstats;
+
+-- Test pg_stat_io.  Its counters live in shared memory and are updated
+-- directly by the issuing process, so there is no collector delay to wait
+-- out; but they are cluster-wide and only ever grow, so we can only test
+-- invariants, not exact values.
+SELECT count(*) > 0 AS has_rows FROM pg_stat_io;
+
+-- only combinations that saw I/O are reported, and always fully formed
+SELECT count(*) = 0 AS ok FROM pg_stat_io
+ WHERE count <= 0 OR total_time < 0 OR array_length(latency_histogram, 1) <> 16;
+
+-- an INSERT must extend the new table, advancing this backend's counter
+CREATE TABLE previostats AS
+  SELECT coalesce(max(count), 0) AS extends FROM pg_stat_io
+   WHERE backend_type = 'client backend' AND object = 'main' AND op = 'extend';
+CREATE TABLE iostats_test (a int);
+INSERT INTO iostats_test SELECT generate_series(1, 1000);
+
+SELECT st.count >= pr.extends + 1 AS extend_advanced
+  FROM pg_stat_io AS st, previostats AS pr
+ WHERE st.backend_type = 'client backend' AND st.object = 'main'
+   AND st.op = 'extend';
+
+DROP TABLE iostats_test, previostats;
 -- End of Stats Test
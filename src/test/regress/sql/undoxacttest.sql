@@ -175,3 +175,24 @@ SELECT undoxacttest_fetch_and_inc('undoxacttest_perm'::regclass, 36);
 ROLLBACK;
 
 DROP TABLE undoxacttest_perm;
+
+-- batched modifications: one WAL record covers several undo records
+DROP TABLE IF EXISTS undoxacttest_batch;
+CREATE TABLE undoxacttest_batch(data bytea not null);
+ALTER TABLE undoxacttest_batch ALTER COLUMN data SET STORAGE plain;
+SELECT undoxacttest_init_rel('undoxacttest_batch'::regclass);
+
+-- implicit xact: batched undo generating statement, statement succeeds
+SELECT undoxacttest_fetch_and_inc_batch('undoxacttest_batch'::regclass, 1, 4);
+SELECT undoxacttest_read('undoxacttest_batch'::regclass);
+
+-- explicit xact: batched undo generating statement, followed by ROLLBACK
+BEGIN;
+SELECT undoxacttest_fetch_and_inc_batch('undoxacttest_batch'::regclass, 2, 8);
+ROLLBACK;
+SELECT undoxacttest_read('undoxacttest_batch'::regclass);
+
+-- batch count must be sane
+SELECT undoxacttest_fetch_and_inc_batch('undoxacttest_batch'::regclass, 1, 0);
+
+DROP TABLE undoxacttest_batch;